@@ -0,0 +1,74 @@
+//    Copyright (C) 2024 Jakub Melka
+//
+//    This file is part of PDF4QT.
+//
+//    PDF4QT is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    with the written consent of the copyright owner, any later version.
+//
+//    PDF4QT is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public License
+//    along with PDF4QT.  If not, see <https://www.gnu.org/licenses/>.
+
+#include <QtTest>
+
+#include "pdfccittfaxdecoder.h"
+
+/// Benchmark of the CCITT fax decoder. Decodes A4 fax page (1728 x 2200 pixels)
+/// encoded by one dimensional byte aligned encoding. Correctness of the decoder
+/// is verified by the unit tests.
+class CCITTFaxDecoderBenchmark : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void benchmark_decode();
+};
+
+void CCITTFaxDecoderBenchmark::benchmark_decode()
+{
+    // One dimensional byte aligned encoding of a fax line (1728 pixels),
+    // line is repeated to get the height of the A4 fax page.
+    const std::vector<uint8_t> line =
+    {
+        0x29, 0x03, 0xC3, 0x28, 0xA4, 0x1B, 0x36, 0x4D, 0xC0, 0x1E, 0x19, 0x45, 0x33, 0x83, 0x64, 0xE7,
+        0x03, 0xC3, 0x28, 0x70, 0x30, 0x53, 0x0E, 0x07, 0x86, 0x53, 0xA1, 0xDD, 0xA2, 0x90, 0x5C, 0xA5,
+        0xEC, 0x9B, 0x98, 0x36, 0x0F, 0x94, 0x8A, 0xAC, 0x0F, 0x0C, 0xA7, 0x16, 0xA7, 0xB2, 0x62, 0x8F,
+        0xB8, 0x18, 0x71, 0x55, 0xE3, 0xAB, 0x63, 0x83, 0x62, 0xB0, 0x30, 0xAF, 0xB1, 0x6A, 0xE6, 0x0B,
+        0x8E, 0x06, 0x1E, 0xBC, 0x74, 0x52, 0x0D, 0x90, 0x0C, 0xE0
+    };
+
+    constexpr int rows = 2200;
+
+    QByteArray stream;
+    for (int i = 0; i < rows; ++i)
+    {
+        stream.append(reinterpret_cast<const char*>(line.data()), static_cast<int>(line.size()));
+    }
+
+    pdf::PDFCCITTFaxDecoderParameters parameters;
+    parameters.K = 0;
+    parameters.columns = 1728;
+    parameters.rows = rows;
+    parameters.hasEncodedByteAlign = true;
+    parameters.hasEndOfBlock = false;
+    parameters.decode = { 0.0, 1.0 };
+
+    pdf::PDFImageData imageData;
+    QBENCHMARK
+    {
+        pdf::PDFCCITTFaxDecoder decoder(&stream, parameters);
+        imageData = decoder.decode();
+    }
+
+    QCOMPARE(imageData.getHeight(), uint(rows));
+}
+
+QTEST_APPLESS_MAIN(CCITTFaxDecoderBenchmark)
+
+#include "tst_ccittfaxdecoderbenchmark.moc"
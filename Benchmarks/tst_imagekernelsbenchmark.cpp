@@ -0,0 +1,301 @@
+//    Copyright (C) 2024 Jakub Melka
+//
+//    This file is part of PDF4QT.
+//
+//    PDF4QT is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    with the written consent of the copyright owner, any later version.
+//
+//    PDF4QT is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public License
+//    along with PDF4QT.  If not, see <https://www.gnu.org/licenses/>.
+
+#include <QtTest>
+
+#include "pdfsimdkernels.h"
+#include "pdfutils.h"
+
+#include <random>
+
+/// Benchmarks of image decoding kernels. Each kernel is measured for all instruction
+/// sets supported by the processor and compared against the reference implementation
+/// (the original per-byte / per-sample code). Results of all implementations are
+/// verified against the reference implementation before measurement.
+class ImageKernelsBenchmark : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void benchmark_png_predictor_data();
+    void benchmark_png_predictor();
+    void benchmark_unpack_samples_data();
+    void benchmark_unpack_samples();
+
+private:
+    static constexpr int IMPLEMENTATION_REFERENCE = -1;
+
+    static void addImplementations(const char* name, int parameter, int pixelBytes);
+
+    static QByteArray createRandomData(int size);
+    static QByteArray decodePNGReference(const QByteArray& data, int stride, int pixelBytes);
+    static QByteArray decodePNG(const QByteArray& data, int stride, int pixelBytes, pdf::PDFSimdKernels::InstructionSet instructionSet);
+};
+
+void ImageKernelsBenchmark::addImplementations(const char* name, int parameter, int pixelBytes)
+{
+    using InstructionSet = pdf::PDFSimdKernels::InstructionSet;
+
+    QTest::newRow(QString("%1 - reference").arg(name).toLatin1().constData()) << parameter << pixelBytes << IMPLEMENTATION_REFERENCE;
+
+    const std::pair<InstructionSet, const char*> instructionSets[] = { { InstructionSet::Scalar, "scalar" }, { InstructionSet::SSE2, "SSE2" }, { InstructionSet::AVX2, "AVX2" } };
+    for (const auto& instructionSet : instructionSets)
+    {
+        if (pdf::PDFSimdKernels::isInstructionSetSupported(instructionSet.first))
+        {
+            QTest::newRow(QString("%1 - %2").arg(name, instructionSet.second).toLatin1().constData()) << parameter << pixelBytes << int(instructionSet.first);
+        }
+    }
+}
+
+QByteArray ImageKernelsBenchmark::createRandomData(int size)
+{
+    std::mt19937 generator(size);
+    std::uniform_int_distribution<int> distribution(0, 255);
+
+    QByteArray data(size, 0);
+    for (char& value : data)
+    {
+        value = static_cast<char>(distribution(generator));
+    }
+
+    return data;
+}
+
+QByteArray ImageKernelsBenchmark::decodePNGReference(const QByteArray& data, int stride, int pixelBytes)
+{
+    QByteArray outputData;
+    outputData.reserve(data.size());
+
+    auto it = data.cbegin();
+    auto itEnd = data.cend();
+
+    auto readByte = [&it, &itEnd]() -> uint8_t
+    {
+        if (it != itEnd)
+        {
+            return static_cast<uint8_t>(*it++);
+        }
+
+        return 0;
+    };
+
+    const int totalBytes = stride + pixelBytes;
+    std::vector<uint8_t> line(totalBytes, 0);
+    std::vector<uint8_t> lineOld(totalBytes, 0);
+
+    while (it != itEnd)
+    {
+        const int predictor = readByte();
+
+        for (int i = 0; i < stride; ++i)
+        {
+            uint8_t currentByte = readByte();
+
+            int lineIndex = i + pixelBytes;
+            switch (predictor)
+            {
+                case pdf::PDFSimdKernels::PNG_Sub:
+                    line[lineIndex] = line[i] + currentByte;
+                    break;
+
+                case pdf::PDFSimdKernels::PNG_Up:
+                    line[lineIndex] = lineOld[lineIndex] + currentByte;
+                    break;
+
+                case pdf::PDFSimdKernels::PNG_Average:
+                    line[lineIndex] = (lineOld[lineIndex] + line[i]) / 2 + currentByte;
+                    break;
+
+                case pdf::PDFSimdKernels::PNG_Paeth:
+                {
+                    const int a = line[i];
+                    const int b = lineOld[lineIndex];
+                    const int c = lineOld[i];
+                    const int p = a + b - c;
+                    const int pa = std::abs(p - a);
+                    const int pb = std::abs(p - b);
+                    const int pc = std::abs(p - c);
+                    if (pa <= pb && pa <= pc)
+                    {
+                        line[lineIndex] = a + currentByte;
+                    }
+                    else if (pb <= pc)
+                    {
+                        line[lineIndex] = b + currentByte;
+                    }
+                    else
+                    {
+                        line[lineIndex] = c + currentByte;
+                    }
+                    break;
+                }
+
+                default:
+                    line[lineIndex] = currentByte;
+                    break;
+            }
+
+            outputData.push_back(static_cast<char>(line[lineIndex]));
+        }
+
+        std::swap(line, lineOld);
+    }
+
+    return outputData;
+}
+
+QByteArray ImageKernelsBenchmark::decodePNG(const QByteArray& data, int stride, int pixelBytes, pdf::PDFSimdKernels::InstructionSet instructionSet)
+{
+    QByteArray outputData;
+    outputData.reserve(data.size());
+
+    std::vector<uint8_t> line(stride + pixelBytes, 0);
+    std::vector<uint8_t> lineOld(stride + pixelBytes, 0);
+
+    const uint8_t* input = pdf::convertByteArrayToUcharPtr(data);
+    const int rowCount = data.size() / (stride + 1);
+    for (int i = 0; i < rowCount; ++i, input += stride + 1)
+    {
+        pdf::PDFSimdKernels::decodePNGRow(input[0], input + 1, line.data() + pixelBytes, lineOld.data() + pixelBytes, stride, pixelBytes, instructionSet);
+        outputData.append(reinterpret_cast<const char*>(line.data() + pixelBytes), stride);
+        std::swap(line, lineOld);
+    }
+
+    return outputData;
+}
+
+void ImageKernelsBenchmark::benchmark_png_predictor_data()
+{
+    QTest::addColumn<int>("filter");
+    QTest::addColumn<int>("pixelBytes");
+    QTest::addColumn<int>("implementation");
+
+    const std::pair<int, const char*> filters[] = { { pdf::PDFSimdKernels::PNG_Sub, "Sub" },
+                                                    { pdf::PDFSimdKernels::PNG_Up, "Up" },
+                                                    { pdf::PDFSimdKernels::PNG_Average, "Average" },
+                                                    { pdf::PDFSimdKernels::PNG_Paeth, "Paeth" } };
+
+    for (const auto& filter : filters)
+    {
+        for (int pixelBytes : { 1, 3, 4 })
+        {
+            addImplementations(QString("%1, %2 bytes per pixel").arg(filter.second).arg(pixelBytes).toLatin1().constData(), filter.first, pixelBytes);
+        }
+    }
+}
+
+void ImageKernelsBenchmark::benchmark_png_predictor()
+{
+    QFETCH(int, filter);
+    QFETCH(int, pixelBytes);
+    QFETCH(int, implementation);
+
+    // 2400 x 3200 pixels scanned page
+    const int stride = 2400 * pixelBytes;
+    const int rowCount = 3200;
+
+    QByteArray data = createRandomData((stride + 1) * rowCount);
+    for (int i = 0; i < rowCount; ++i)
+    {
+        data[i * (stride + 1)] = static_cast<char>(filter);
+    }
+
+    const QByteArray reference = decodePNGReference(data, stride, pixelBytes);
+
+    if (implementation == IMPLEMENTATION_REFERENCE)
+    {
+        QBENCHMARK
+        {
+            decodePNGReference(data, stride, pixelBytes);
+        }
+    }
+    else
+    {
+        const pdf::PDFSimdKernels::InstructionSet instructionSet = static_cast<pdf::PDFSimdKernels::InstructionSet>(implementation);
+        QCOMPARE(decodePNG(data, stride, pixelBytes, instructionSet), reference);
+
+        QBENCHMARK
+        {
+            decodePNG(data, stride, pixelBytes, instructionSet);
+        }
+    }
+}
+
+void ImageKernelsBenchmark::benchmark_unpack_samples_data()
+{
+    QTest::addColumn<int>("bitsPerComponent");
+    QTest::addColumn<int>("pixelBytes");
+    QTest::addColumn<int>("implementation");
+
+    for (int bitsPerComponent : { 1, 2, 4, 8, 16 })
+    {
+        addImplementations(QString("%1 bits per component").arg(bitsPerComponent).toLatin1().constData(), bitsPerComponent, 0);
+    }
+}
+
+void ImageKernelsBenchmark::benchmark_unpack_samples()
+{
+    QFETCH(int, bitsPerComponent);
+    QFETCH(int, implementation);
+
+    const int sampleCount = 2400 * 3 * 32;
+    const QByteArray data = createRandomData((sampleCount * bitsPerComponent + 7) / 8);
+
+    auto unpackReference = [&data, bitsPerComponent](std::vector<float>& samples)
+    {
+        pdf::PDFBitReader reader(&data, bitsPerComponent);
+        const double coefficient = 1.0 / reader.max();
+        for (float& sample : samples)
+        {
+            pdf::PDFReal value = reader.read();
+            sample = value * coefficient;
+        }
+    };
+
+    std::vector<float> reference(sampleCount, 0.0f);
+    unpackReference(reference);
+
+    std::vector<float> samples(sampleCount, 0.0f);
+    if (implementation == IMPLEMENTATION_REFERENCE)
+    {
+        QBENCHMARK
+        {
+            unpackReference(samples);
+        }
+    }
+    else
+    {
+        const pdf::PDFSimdKernels::InstructionSet instructionSet = static_cast<pdf::PDFSimdKernels::InstructionSet>(implementation);
+        const uint8_t* input = pdf::convertByteArrayToUcharPtr(data);
+
+        pdf::PDFSimdKernels::unpackNormalizedSamples(input, samples.data(), samples.size(), bitsPerComponent, instructionSet);
+        for (int i = 0; i < sampleCount; ++i)
+        {
+            QVERIFY(qAbs(samples[i] - reference[i]) < 1.0e-6f);
+        }
+
+        QBENCHMARK
+        {
+            pdf::PDFSimdKernels::unpackNormalizedSamples(input, samples.data(), samples.size(), bitsPerComponent, instructionSet);
+        }
+    }
+}
+
+QTEST_APPLESS_MAIN(ImageKernelsBenchmark)
+
+#include "tst_imagekernelsbenchmark.moc"
@@ -0,0 +1,189 @@
+//    Copyright (C) 2024 Jakub Melka
+//
+//    This file is part of PDF4QT.
+//
+//    PDF4QT is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    with the written consent of the copyright owner, any later version.
+//
+//    PDF4QT is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public License
+//    along with PDF4QT.  If not, see <https://www.gnu.org/licenses/>.
+
+#include <QtTest>
+
+#include "pdftransparencyrenderer.h"
+#include "pdfblendfunction.h"
+
+#include <random>
+
+/// Benchmarks of blending of float bitmaps used by the transparency renderer
+/// (output preview, ink coverage). Each test blends a page sized transparency
+/// group with soft mask into the backdrop. Blend modes without overprint are
+/// blended by row kernels, blending with overprint is processed pixel by pixel.
+/// Overprint mode 0 without active color mask selects the same colors, so both
+/// paths are measured and their results are verified against each other.
+class TransparencyBenchmark : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void benchmark_blend_data();
+    void benchmark_blend();
+    void benchmark_blend_converted_spots_data();
+    void benchmark_blend_converted_spots();
+    void benchmark_extract_luminosity_data();
+    void benchmark_extract_luminosity();
+
+private:
+    static constexpr size_t WIDTH = 1240;
+    static constexpr size_t HEIGHT = 1754;
+
+    static void addPixelFormats();
+    static pdf::PDFPixelFormat getPixelFormat(int format);
+    static pdf::PDFFloatBitmap createRandomBitmap(pdf::PDFPixelFormat format, int seed);
+};
+
+void TransparencyBenchmark::addPixelFormats()
+{
+    QTest::addColumn<int>("format");
+
+    QTest::newRow("RGB") << 0;
+    QTest::newRow("CMYK") << 1;
+    QTest::newRow("CMYK + 4 spots") << 2;
+}
+
+pdf::PDFPixelFormat TransparencyBenchmark::getPixelFormat(int format)
+{
+    switch (format)
+    {
+        case 0:
+            return pdf::PDFPixelFormat::createFormatDefaultRGB(0);
+
+        case 1:
+            return pdf::PDFPixelFormat::createFormatDefaultCMYK(0);
+
+        default:
+            return pdf::PDFPixelFormat::createFormatDefaultCMYK(4);
+    }
+}
+
+pdf::PDFFloatBitmap TransparencyBenchmark::createRandomBitmap(pdf::PDFPixelFormat format, int seed)
+{
+    std::mt19937 generator(seed);
+    std::uniform_real_distribution<pdf::PDFColorComponent> distribution(0.0f, 1.0f);
+
+    pdf::PDFFloatBitmap bitmap(WIDTH, HEIGHT, format);
+    for (pdf::PDFColorComponent& value : bitmap.getPixels())
+    {
+        value = distribution(generator);
+    }
+
+    return bitmap;
+}
+
+void TransparencyBenchmark::benchmark_blend_data()
+{
+    QTest::addColumn<int>("format");
+    QTest::addColumn<int>("mode");
+    QTest::addColumn<bool>("overprint");
+
+    const std::pair<int, const char*> formats[] = { { 0, "RGB" }, { 1, "CMYK" }, { 2, "CMYK + 4 spots" } };
+    const pdf::BlendMode modes[] = { pdf::BlendMode::Normal, pdf::BlendMode::Multiply, pdf::BlendMode::Screen,
+                                     pdf::BlendMode::Overlay, pdf::BlendMode::ColorDodge, pdf::BlendMode::SoftLight,
+                                     pdf::BlendMode::Difference, pdf::BlendMode::Luminosity };
+
+    for (const auto& format : formats)
+    {
+        for (const pdf::BlendMode mode : modes)
+        {
+            const QString name = QString("%1, %2").arg(format.second, pdf::PDFBlendModeInfo::getBlendModeName(mode));
+            QTest::newRow(QString("%1 - row kernel").arg(name).toLatin1().constData()) << format.first << int(mode) << false;
+            QTest::newRow(QString("%1 - per pixel").arg(name).toLatin1().constData()) << format.first << int(mode) << true;
+        }
+    }
+}
+
+void TransparencyBenchmark::benchmark_blend()
+{
+    QFETCH(int, format);
+    QFETCH(int, mode);
+    QFETCH(bool, overprint);
+
+    const pdf::PDFPixelFormat pixelFormat = getPixelFormat(format);
+    const pdf::BlendMode blendMode = static_cast<pdf::BlendMode>(mode);
+    const pdf::PDFFloatBitmap source = createRandomBitmap(pixelFormat, 1);
+    const pdf::PDFFloatBitmap backdrop = createRandomBitmap(pixelFormat, 2);
+    const pdf::PDFFloatBitmap softMask = createRandomBitmap(pdf::PDFPixelFormat::createOpacityMask(), 3);
+    const QRect blendRegion(0, 0, int(WIDTH), int(HEIGHT));
+
+    auto blend = [&](pdf::PDFFloatBitmap& target, pdf::PDFFloatBitmap::OverprintMode overprintMode)
+    {
+        pdf::PDFFloatBitmap::blend(source, target, backdrop, backdrop, softMask, false, 0.75f, blendMode, false, overprintMode, blendRegion);
+    };
+
+    pdf::PDFFloatBitmap rowKernelTarget = backdrop;
+    pdf::PDFFloatBitmap perPixelTarget = backdrop;
+    blend(rowKernelTarget, pdf::PDFFloatBitmap::OverprintMode::NoOveprint);
+    blend(perPixelTarget, pdf::PDFFloatBitmap::OverprintMode::Overprint_Mode_0);
+
+    auto itRowKernel = rowKernelTarget.begin();
+    for (auto itPerPixel = perPixelTarget.begin(); itPerPixel != perPixelTarget.end(); ++itPerPixel, ++itRowKernel)
+    {
+        QVERIFY(qAbs(*itPerPixel - *itRowKernel) < 1.0e-4f);
+    }
+
+    const pdf::PDFFloatBitmap::OverprintMode overprintMode = overprint ? pdf::PDFFloatBitmap::OverprintMode::Overprint_Mode_0
+                                                                       : pdf::PDFFloatBitmap::OverprintMode::NoOveprint;
+    pdf::PDFFloatBitmap target = backdrop;
+    QBENCHMARK
+    {
+        blend(target, overprintMode);
+    }
+}
+
+void TransparencyBenchmark::benchmark_blend_converted_spots_data()
+{
+    addPixelFormats();
+}
+
+void TransparencyBenchmark::benchmark_blend_converted_spots()
+{
+    QFETCH(int, format);
+
+    const pdf::PDFPixelFormat pixelFormat = getPixelFormat(format);
+    const pdf::PDFFloatBitmap convertedSpotColors = createRandomBitmap(pdf::PDFPixelFormat::removeSpotColors(pixelFormat), 4);
+    pdf::PDFFloatBitmap bitmap = createRandomBitmap(pixelFormat, 5);
+
+    QBENCHMARK
+    {
+        bitmap.blendConvertedSpots(convertedSpotColors);
+    }
+}
+
+void TransparencyBenchmark::benchmark_extract_luminosity_data()
+{
+    addPixelFormats();
+}
+
+void TransparencyBenchmark::benchmark_extract_luminosity()
+{
+    QFETCH(int, format);
+
+    const pdf::PDFFloatBitmap bitmap = createRandomBitmap(getPixelFormat(format), 6);
+
+    QBENCHMARK
+    {
+        pdf::PDFFloatBitmap softMask = bitmap.extractLuminosityChannel();
+        Q_UNUSED(softMask);
+    }
+}
+
+QTEST_APPLESS_MAIN(TransparencyBenchmark)
+
+#include "tst_transparencybenchmark.moc"
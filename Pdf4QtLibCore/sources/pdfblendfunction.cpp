@@ -254,126 +254,164 @@ PDFColorComponent PDFBlendFunction::blend(BlendMode mode, PDFColorComponent Cb,
     switch (mode)
     {
         case BlendMode::Normal:
+            return blend<BlendMode::Normal>(Cb, Cs);
+
         case BlendMode::Compatible:
-            return Cs;
+            return blend<BlendMode::Compatible>(Cb, Cs);
 
         case BlendMode::Multiply:
-            return Cb * Cs;
+            return blend<BlendMode::Multiply>(Cb, Cs);
 
         case BlendMode::Screen:
-            return Cb + Cs - Cb * Cs;
+            return blend<BlendMode::Screen>(Cb, Cs);
 
         case BlendMode::Overlay:
-            return blend(BlendMode::HardLight, Cs, Cb);
+            return blend<BlendMode::Overlay>(Cb, Cs);
 
         case BlendMode::Darken:
-            return qMin(Cb, Cs);
+            return blend<BlendMode::Darken>(Cb, Cs);
 
         case BlendMode::Lighten:
-            return qMax(Cb, Cs);
+            return blend<BlendMode::Lighten>(Cb, Cs);
 
         case BlendMode::ColorDodge:
-        {
-            if (qFuzzyIsNull(Cb))
-            {
-                return 0.0f;
-            }
-
-            const PDFColorComponent CsInverted = 1.0f - Cs;
-            if (Cb >= CsInverted)
-            {
-                return 1.0f;
-            }
-
-            return Cb / CsInverted;
-        }
+            return blend<BlendMode::ColorDodge>(Cb, Cs);
 
         case BlendMode::ColorBurn:
-        {
-            const PDFColorComponent CbInverted = 1.0f - Cb;
-            if (qFuzzyIsNull(CbInverted))
-            {
-                return 1.0f;
-            }
-
-            if (CbInverted >= Cs)
-            {
-                return 0.0f;
-            }
-
-            return 1.0f - CbInverted / Cs;
-        }
+            return blend<BlendMode::ColorBurn>(Cb, Cs);
 
         case BlendMode::HardLight:
-        {
-            if (Cs <= 0.5f)
-            {
-                return blend(BlendMode::Multiply, Cb, 2.0f * Cs);
-            }
-            else
-            {
-                return blend(BlendMode::Screen, Cb, 2.0f * Cs - 1.0f);
-            }
-        }
+            return blend<BlendMode::HardLight>(Cb, Cs);
 
         case BlendMode::SoftLight:
-        {
-            if (Cs <= 0.5f)
-            {
-                return Cb - (1.0f - 2.0f * Cs) * Cb * (1.0f - Cb);
-            }
-            else
-            {
-                PDFColorComponent D = 0.0f;
-                if (Cb <= 0.25)
-                {
-                    D = ((16.0f * Cb - 12.0f) * Cb + 4.0f) * Cb;
-                }
-                else
-                {
-                    D = std::sqrt(Cb);
-                }
-                return Cb + (2.0f * Cs - 1.0f) * (D - Cb);
-            }
-        }
+            return blend<BlendMode::SoftLight>(Cb, Cs);
 
         case BlendMode::Difference:
-            return qAbs(Cb - Cs);
+            return blend<BlendMode::Difference>(Cb, Cs);
 
         case BlendMode::Exclusion:
-            return Cb + Cs - 2.0f * Cb * Cs;
+            return blend<BlendMode::Exclusion>(Cb, Cs);
 
         case BlendMode::Overprint_SelectBackdrop:
-            return Cb;
+            return blend<BlendMode::Overprint_SelectBackdrop>(Cb, Cs);
 
         case BlendMode::Overprint_SelectNonZeroSourceOrBackdrop:
-        {
-            if (qFuzzyIsNull(Cs))
-            {
-                return Cb;
-            }
-
-            return Cs;
-        }
+            return blend<BlendMode::Overprint_SelectNonZeroSourceOrBackdrop>(Cb, Cs);
 
         case BlendMode::Overprint_SelectNonOneSourceOrBackdrop:
+            return blend<BlendMode::Overprint_SelectNonOneSourceOrBackdrop>(Cb, Cs);
+
+        default:
         {
-            if (qFuzzyIsNull(1.0f - Cs))
-            {
-                return Cb;
-            }
+            Q_ASSERT(false);
+            break;
+        }
+    }
+
+    return Cs;
+}
 
-            return Cs;
+template<BlendMode mode, bool subtractive>
+void PDFBlendFunction::blendRowImpl(const PDFColorComponent* Cb, const PDFColorComponent* Cs, PDFColorComponent* B, size_t count)
+{
+    for (size_t i = 0; i < count; ++i)
+    {
+        if constexpr (subtractive)
+        {
+            B[i] = 1.0f - blend<mode>(1.0f - Cb[i], 1.0f - Cs[i]);
+        }
+        else
+        {
+            B[i] = blend<mode>(Cb[i], Cs[i]);
         }
+    }
+}
+
+void PDFBlendFunction::blendRow(BlendMode mode,
+                                bool subtractive,
+                                const PDFColorComponent* Cb,
+                                const PDFColorComponent* Cs,
+                                PDFColorComponent* B,
+                                size_t count)
+{
+    using BlendRowFunction = void(*)(const PDFColorComponent*, const PDFColorComponent*, PDFColorComponent*, size_t);
+    BlendRowFunction function = nullptr;
+
+    switch (mode)
+    {
+        case BlendMode::Normal:
+            function = subtractive ? &blendRowImpl<BlendMode::Normal, true> : &blendRowImpl<BlendMode::Normal, false>;
+            break;
+
+        case BlendMode::Compatible:
+            function = subtractive ? &blendRowImpl<BlendMode::Compatible, true> : &blendRowImpl<BlendMode::Compatible, false>;
+            break;
+
+        case BlendMode::Multiply:
+            function = subtractive ? &blendRowImpl<BlendMode::Multiply, true> : &blendRowImpl<BlendMode::Multiply, false>;
+            break;
+
+        case BlendMode::Screen:
+            function = subtractive ? &blendRowImpl<BlendMode::Screen, true> : &blendRowImpl<BlendMode::Screen, false>;
+            break;
+
+        case BlendMode::Overlay:
+            function = subtractive ? &blendRowImpl<BlendMode::Overlay, true> : &blendRowImpl<BlendMode::Overlay, false>;
+            break;
+
+        case BlendMode::Darken:
+            function = subtractive ? &blendRowImpl<BlendMode::Darken, true> : &blendRowImpl<BlendMode::Darken, false>;
+            break;
+
+        case BlendMode::Lighten:
+            function = subtractive ? &blendRowImpl<BlendMode::Lighten, true> : &blendRowImpl<BlendMode::Lighten, false>;
+            break;
+
+        case BlendMode::ColorDodge:
+            function = subtractive ? &blendRowImpl<BlendMode::ColorDodge, true> : &blendRowImpl<BlendMode::ColorDodge, false>;
+            break;
+
+        case BlendMode::ColorBurn:
+            function = subtractive ? &blendRowImpl<BlendMode::ColorBurn, true> : &blendRowImpl<BlendMode::ColorBurn, false>;
+            break;
+
+        case BlendMode::HardLight:
+            function = subtractive ? &blendRowImpl<BlendMode::HardLight, true> : &blendRowImpl<BlendMode::HardLight, false>;
+            break;
+
+        case BlendMode::SoftLight:
+            function = subtractive ? &blendRowImpl<BlendMode::SoftLight, true> : &blendRowImpl<BlendMode::SoftLight, false>;
+            break;
+
+        case BlendMode::Difference:
+            function = subtractive ? &blendRowImpl<BlendMode::Difference, true> : &blendRowImpl<BlendMode::Difference, false>;
+            break;
+
+        case BlendMode::Exclusion:
+            function = subtractive ? &blendRowImpl<BlendMode::Exclusion, true> : &blendRowImpl<BlendMode::Exclusion, false>;
+            break;
+
+        case BlendMode::Overprint_SelectBackdrop:
+            function = subtractive ? &blendRowImpl<BlendMode::Overprint_SelectBackdrop, true> : &blendRowImpl<BlendMode::Overprint_SelectBackdrop, false>;
+            break;
+
+        case BlendMode::Overprint_SelectNonZeroSourceOrBackdrop:
+            function = subtractive ? &blendRowImpl<BlendMode::Overprint_SelectNonZeroSourceOrBackdrop, true> : &blendRowImpl<BlendMode::Overprint_SelectNonZeroSourceOrBackdrop, false>;
+            break;
+
+        case BlendMode::Overprint_SelectNonOneSourceOrBackdrop:
+            function = subtractive ? &blendRowImpl<BlendMode::Overprint_SelectNonOneSourceOrBackdrop, true> : &blendRowImpl<BlendMode::Overprint_SelectNonOneSourceOrBackdrop, false>;
+            break;
 
         default:
         {
             Q_ASSERT(false);
-            break;
+            std::copy(Cs, Cs + count, B);
+            return;
         }
     }
 
-    return Cs;
+    function(Cb, Cs, B, count);
 }
 
 PDFRGB PDFBlendFunction::blend_Hue(PDFRGB Cb, PDFRGB Cs)
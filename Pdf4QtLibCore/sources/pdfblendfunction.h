@@ -22,6 +22,8 @@
 
 #include <QPainter>
 
+#include <cmath>
+
 namespace pdf
 {
 
@@ -111,6 +113,31 @@ public:
     /// \param Cs Source color
     static PDFColorComponent blend(BlendMode mode, PDFColorComponent Cb, PDFColorComponent Cs);
 
+    /// Blend function specialized for given separable blend mode. Blend mode
+    /// is resolved at compile time, so the function can be inlined into loops
+    /// processing whole rows of color components.
+    /// \param Cb Backdrop color
+    /// \param Cs Source color
+    template<BlendMode mode>
+    static inline PDFColorComponent blend(PDFColorComponent Cb, PDFColorComponent Cs);
+
+    /// Blends \p count color components using separable blend mode. Kernel
+    /// for the blend mode is selected once for the whole run of the components.
+    /// If \p subtractive is true, colors are inverted before and after the blending
+    /// (blending of subtractive colors, such as CMYK).
+    /// \param mode Separable blend mode
+    /// \param subtractive Are colors subtractive?
+    /// \param Cb Backdrop colors
+    /// \param Cs Source colors
+    /// \param B Blended colors
+    /// \param count Number of color components
+    static void blendRow(BlendMode mode,
+                         bool subtractive,
+                         const PDFColorComponent* Cb,
+                         const PDFColorComponent* Cs,
+                         PDFColorComponent* B,
+                         size_t count);
+
     /// Blend non-separable hue function
     /// \param Cb Backdrop color
     /// \param Cs Source color
@@ -208,6 +235,9 @@ public:
     static constexpr PDFColorComponent blend_Union(PDFColorComponent b, PDFColorComponent s) { return b + s - b * s; }
 
 private:
+    template<BlendMode mode, bool subtractive>
+    static void blendRowImpl(const PDFColorComponent* Cb, const PDFColorComponent* Cs, PDFColorComponent* B, size_t count);
+
     static PDFRGB nonseparable_gray2rgb(PDFGray gray);
     static PDFGray nonseparable_rgb2gray(PDFRGB rgb);
     static PDFRGB nonseparable_cmyk2rgb(PDFCMYK cmyk);
@@ -219,6 +249,90 @@ private:
     static PDFRGB nonseparable_ClipColor(PDFRGB C);
 };
 
+template<BlendMode mode>
+inline PDFColorComponent PDFBlendFunction::blend(PDFColorComponent Cb, PDFColorComponent Cs)
+{
+    // Conditions are written as selects, so the loops using this
+    // function can be vectorized by the compiler.
+    if constexpr (mode == BlendMode::Normal || mode == BlendMode::Compatible)
+    {
+        return Cs;
+    }
+    else if constexpr (mode == BlendMode::Multiply)
+    {
+        return Cb * Cs;
+    }
+    else if constexpr (mode == BlendMode::Screen)
+    {
+        return Cb + Cs - Cb * Cs;
+    }
+    else if constexpr (mode == BlendMode::Overlay)
+    {
+        return blend<BlendMode::HardLight>(Cs, Cb);
+    }
+    else if constexpr (mode == BlendMode::Darken)
+    {
+        return qMin(Cb, Cs);
+    }
+    else if constexpr (mode == BlendMode::Lighten)
+    {
+        return qMax(Cb, Cs);
+    }
+    else if constexpr (mode == BlendMode::ColorDodge)
+    {
+        const PDFColorComponent CsInverted = 1.0f - Cs;
+        const PDFColorComponent value = (Cb >= CsInverted) ? 1.0f : Cb / CsInverted;
+        return qFuzzyIsNull(Cb) ? 0.0f : value;
+    }
+    else if constexpr (mode == BlendMode::ColorBurn)
+    {
+        const PDFColorComponent CbInverted = 1.0f - Cb;
+        const PDFColorComponent value = (CbInverted >= Cs) ? 0.0f : 1.0f - CbInverted / Cs;
+        return qFuzzyIsNull(CbInverted) ? 1.0f : value;
+    }
+    else if constexpr (mode == BlendMode::HardLight)
+    {
+        const PDFColorComponent multiply = blend<BlendMode::Multiply>(Cb, 2.0f * Cs);
+        const PDFColorComponent screen = blend<BlendMode::Screen>(Cb, 2.0f * Cs - 1.0f);
+        return (Cs <= 0.5f) ? multiply : screen;
+    }
+    else if constexpr (mode == BlendMode::SoftLight)
+    {
+        if (Cs <= 0.5f)
+        {
+            return Cb - (1.0f - 2.0f * Cs) * Cb * (1.0f - Cb);
+        }
+
+        const PDFColorComponent D = (Cb <= 0.25f) ? ((16.0f * Cb - 12.0f) * Cb + 4.0f) * Cb : std::sqrt(Cb);
+        return Cb + (2.0f * Cs - 1.0f) * (D - Cb);
+    }
+    else if constexpr (mode == BlendMode::Difference)
+    {
+        return qAbs(Cb - Cs);
+    }
+    else if constexpr (mode == BlendMode::Exclusion)
+    {
+        return Cb + Cs - 2.0f * Cb * Cs;
+    }
+    else if constexpr (mode == BlendMode::Overprint_SelectBackdrop)
+    {
+        return Cb;
+    }
+    else if constexpr (mode == BlendMode::Overprint_SelectNonZeroSourceOrBackdrop)
+    {
+        return qFuzzyIsNull(Cs) ? Cb : Cs;
+    }
+    else if constexpr (mode == BlendMode::Overprint_SelectNonOneSourceOrBackdrop)
+    {
+        return qFuzzyIsNull(1.0f - Cs) ? Cb : Cs;
+    }
+    else
+    {
+        static_assert(mode == BlendMode::Normal, "Blend mode is not separable.");
+        return Cs;
+    }
+}
+
 }   // namespace pdf
 
 #endif // PDFBLENDFUNCTION_H
@@ -20,6 +20,8 @@
 #include "pdfexception.h"
 #include "pdfdbgheap.h"
 
+#include <cstring>
+
 namespace pdf
 {
 
@@ -58,7 +60,7 @@ struct PDFCCITTCode
     uint8_t bits;
 };
 
-static constexpr uint8_t MAX_CODE_BIT_LENGTH = 12;
+static constexpr uint8_t MAX_CODE_BIT_LENGTH = 13;
 
 static constexpr PDFCCITTCode CCITT_WHITE_CODES[] = {
 
@@ -284,6 +286,53 @@ static constexpr PDFCCITTCode CCITT_BLACK_CODES[] = {
     { 2560,    0b000000011111,     000000011111_bitlength }
 };
 
+/// Entry of the lookup table of run length codes. Table is indexed by the next
+/// MAX_CODE_BIT_LENGTH bits of the stream, so all indices starting with
+/// the code word point to the entry of the code word.
+struct PDFCCITTCodeTableEntry
+{
+    uint16_t length = 0;
+    uint8_t bits = 0;   ///< Length of the code word, zero for invalid code word
+};
+
+/// Entry of the lookup table of 2D modes, indexed by the next MAX_2D_MODE_BIT_LENGTH bits
+struct PDFCCITT2DModeTableEntry
+{
+    CCITT_2D_Code_Mode mode = Invalid;
+    uint8_t bits = 0;   ///< Length of the code word, zero for invalid code word
+};
+
+template<size_t Size>
+static std::vector<PDFCCITTCodeTableEntry> createCodeTable(const PDFCCITTCode (&codes)[Size])
+{
+    std::vector<PDFCCITTCodeTableEntry> table(size_t(1) << MAX_CODE_BIT_LENGTH);
+
+    for (const PDFCCITTCode& code : codes)
+    {
+        const uint8_t freeBits = MAX_CODE_BIT_LENGTH - code.bits;
+        const size_t first = size_t(code.code) << freeBits;
+        const size_t last = first + (size_t(1) << freeBits);
+        std::fill(std::next(table.begin(), first), std::next(table.begin(), last), PDFCCITTCodeTableEntry{ code.length, code.bits });
+    }
+
+    return table;
+}
+
+static std::vector<PDFCCITT2DModeTableEntry> create2DModeTable()
+{
+    std::vector<PDFCCITT2DModeTableEntry> table(size_t(1) << MAX_2D_MODE_BIT_LENGTH);
+
+    for (const PDFCCITT2DModeInfo& info : CCITT_2D_CODE_MODES)
+    {
+        const uint8_t freeBits = MAX_2D_MODE_BIT_LENGTH - info.bits;
+        const size_t first = size_t(info.code) << freeBits;
+        const size_t last = first + (size_t(1) << freeBits);
+        std::fill(std::next(table.begin(), first), std::next(table.begin(), last), PDFCCITT2DModeTableEntry{ info.mode, info.bits });
+    }
+
+    return table;
+}
+
 PDFCCITTFaxDecoder::PDFCCITTFaxDecoder(const QByteArray* stream, const PDFCCITTFaxDecoderParameters& parameters) :
     m_reader(stream, 1),
     m_parameters(parameters)
@@ -293,7 +342,13 @@ PDFCCITTFaxDecoder::PDFCCITTFaxDecoder(const QByteArray* stream, const PDFCCITTF
 
 PDFImageData PDFCCITTFaxDecoder::decode()
 {
-    PDFBitWriter writer(1);
+    const int stride = (m_parameters.columns + 7) / 8;
+    QByteArray imageData;
+    if (!m_parameters.hasEndOfBlock && m_parameters.rows > 0)
+    {
+        imageData.reserve(stride * m_parameters.rows);
+    }
+
     std::vector<int> codingLine;
     std::vector<int> referenceLine;
 
@@ -454,19 +509,8 @@ PDFImageData PDFCCITTFaxDecoder::decode()
         }
 
         // Write the line to the output buffer
-        isCurrentPixelBlack = false;
-        int index = 0;
-        for (int i = 0; i < m_parameters.columns; ++i)
-        {
-            if (i == codingLine[index])
-            {
-                isCurrentPixelBlack = !isCurrentPixelBlack;
-                ++index;
-            }
-
-            writer.write(isCurrentPixelBlack ? 0 : 1);
-        }
-        writer.finishLine();
+        imageData.resize(imageData.size() + stride);
+        writeLine(codingLine, reinterpret_cast<uint8_t*>(imageData.data()) + imageData.size() - stride);
 
         ++row;
 
@@ -556,7 +600,7 @@ PDFImageData PDFCCITTFaxDecoder::decode()
         decode = { m_parameters.decode[0], m_parameters.decode[1] };
     }
 
-    return PDFImageData(1, 1, m_parameters.columns, row, (m_parameters.columns + 7) / 8, m_parameters.maskingType, writer.takeByteArray(), { }, qMove(decode), { });
+    return PDFImageData(1, 1, m_parameters.columns, row, stride, m_parameters.maskingType, qMove(imageData), { }, qMove(decode), { });
 }
 
 void PDFCCITTFaxDecoder::skipFill()
@@ -612,6 +656,58 @@ void PDFCCITTFaxDecoder::addPixels(std::vector<int>& line, int& a0_index, int a1
     }
 }
 
+void PDFCCITTFaxDecoder::writeLine(const std::vector<int>& line, uint8_t* output) const
+{
+    const int columns = m_parameters.columns;
+    const int stride = (columns + 7) / 8;
+
+    // Start with white line, padding bits of the last byte are zero
+    std::memset(output, 0xFF, stride);
+    if (columns % 8)
+    {
+        output[stride - 1] = static_cast<uint8_t>(0xFF << (8 - columns % 8));
+    }
+
+    // Clears pixels in range [start, end)
+    auto fillBlack = [output](int start, int end)
+    {
+        const int startByte = start / 8;
+        const int endByte = end / 8;
+        const uint8_t startMask = static_cast<uint8_t>(0xFF >> (start % 8));
+        const uint8_t endMask = static_cast<uint8_t>(~(0xFF >> (end % 8)));
+
+        if (startByte == endByte)
+        {
+            output[startByte] &= ~(startMask & endMask);
+        }
+        else
+        {
+            output[startByte] &= ~startMask;
+            std::memset(output + startByte + 1, 0, endByte - startByte - 1);
+
+            if (end % 8)
+            {
+                output[endByte] &= ~endMask;
+            }
+        }
+    };
+
+    // Changing elements at even indices end white runs, at odd indices end black runs
+    int position = 0;
+    for (size_t i = 0; i + 1 < line.size() && position < columns; i += 2)
+    {
+        const int start = qMax(position, line[i]);
+        const int end = qMin(line[i + 1], columns);
+
+        if (start < end)
+        {
+            fillBlack(start, end);
+        }
+
+        position = qMax(start, end);
+    }
+}
+
 uint32_t PDFCCITTFaxDecoder::getRunLength(bool white)
 {
     uint32_t value = 0;
@@ -640,57 +736,41 @@ uint32_t PDFCCITTFaxDecoder::getRunLength(bool white)
 
 uint32_t PDFCCITTFaxDecoder::getWhiteCode()
 {
-    return getCode(CCITT_WHITE_CODES, std::size(CCITT_WHITE_CODES));
+    static const std::vector<PDFCCITTCodeTableEntry> table = createCodeTable(CCITT_WHITE_CODES);
+    return getCode(table.data());
 }
 
 uint32_t PDFCCITTFaxDecoder::getBlackCode()
 {
-    return getCode(CCITT_BLACK_CODES, std::size(CCITT_BLACK_CODES));
+    static const std::vector<PDFCCITTCodeTableEntry> table = createCodeTable(CCITT_BLACK_CODES);
+    return getCode(table.data());
 }
 
-uint32_t PDFCCITTFaxDecoder::getCode(const PDFCCITTCode* codes, size_t codeCount)
+uint32_t PDFCCITTFaxDecoder::getCode(const PDFCCITTCodeTableEntry* table)
 {
-    uint32_t code = 0;
-    uint8_t bits = 0;
+    const PDFCCITTCodeTableEntry& entry = table[m_reader.look(MAX_CODE_BIT_LENGTH)];
 
-    while (bits <= MAX_CODE_BIT_LENGTH)
+    if (entry.bits == 0)
     {
-        code = (code << 1) + m_reader.read(1);
-        ++bits;
-
-        for (size_t i = 0; i < codeCount; ++i)
-        {
-            const PDFCCITTCode& currentCode = codes[i];
-            if (currentCode.bits == bits && currentCode.code == code)
-            {
-                return currentCode.length;
-            }
-        }
+        throw PDFException(PDFTranslationContext::tr("Invalid CCITT run length code word."));
     }
 
-    throw PDFException(PDFTranslationContext::tr("Invalid CCITT run length code word."));
+    m_reader.read(entry.bits);
+    return entry.length;
 }
 
 CCITT_2D_Code_Mode PDFCCITTFaxDecoder::get2DMode()
 {
-    uint32_t code = 0;
-    uint8_t bits = 0;
+    static const std::vector<PDFCCITT2DModeTableEntry> table = create2DModeTable();
+    const PDFCCITT2DModeTableEntry& entry = table[m_reader.look(MAX_2D_MODE_BIT_LENGTH)];
 
-    while (bits <= MAX_2D_MODE_BIT_LENGTH)
+    if (entry.bits == 0)
     {
-        code = (code << 1) + m_reader.read(1);
-        ++bits;
-
-        for (const PDFCCITT2DModeInfo& info : CCITT_2D_CODE_MODES)
-        {
-            if (info.bits == bits && info.code == code)
-            {
-                return info.mode;
-            }
-        }
+        throw PDFException(PDFTranslationContext::tr("Invalid CCITT 2D mode."));
     }
 
-    throw PDFException(PDFTranslationContext::tr("Invalid CCITT 2D mode."));
+    m_reader.read(entry.bits);
+    return entry.mode;
 }
 
 }   // namespace pdf
@@ -24,7 +24,8 @@
 namespace pdf
 {
 
-struct PDFCCITTCode;
+struct PDFCCITTCodeTableEntry;
+struct PDFCCITT2DModeTableEntry;
 
 struct PDFCCITTFaxDecoderParameters
 {
@@ -86,7 +87,7 @@ enum CCITT_2D_Code_Mode
     Invalid
 };
 
-class PDFCCITTFaxDecoder
+class PDF4QTLIBCORESHARED_EXPORT PDFCCITTFaxDecoder
 {
 public:
     explicit PDFCCITTFaxDecoder(const QByteArray* stream, const PDFCCITTFaxDecoderParameters& parameters);
@@ -114,6 +115,12 @@ private:
     /// \param isA1LeftOfA0Allowed Allow a1 to be left of a0 (not a0_index, but line[a0_index], which is a0)
     void addPixels(std::vector<int>& line, int& a0_index, int a1, bool isCurrentPixelBlack, bool isA1LeftOfA0Allowed);
 
+    /// Writes decoded line to the output row. Runs of pixels between changing
+    /// elements are filled at once, white pixels are 1, black pixels are 0.
+    /// \param line Line with changing element indices
+    /// \param output Output row (must have stride bytes)
+    void writeLine(const std::vector<int>& line, uint8_t* output) const;
+
     /// Get 2D mode from the stream
     CCITT_2D_Code_Mode get2DMode();
 
@@ -122,7 +129,8 @@ private:
     uint32_t getWhiteCode();
     uint32_t getBlackCode();
 
-    uint32_t getCode(const PDFCCITTCode* codes, size_t codeCount);
+    /// Reads code using the lookup table indexed by the next bits of the stream
+    uint32_t getCode(const PDFCCITTCodeTableEntry* table);
 
     PDFBitReader m_reader;
     PDFCCITTFaxDecoderParameters m_parameters;
@@ -60,11 +60,154 @@
 #endif
 #endif
 
+#include <array>
+#include <atomic>
+#include <cstring>
+#include <algorithm>
 #include <unordered_map>
 
 namespace pdf
 {
 
+/// Memo of single colors converted by the color management system. Content streams
+/// often set the same few colors over and over again, so each thread remembers recently
+/// converted colors. Memo is a small direct mapped table, the key consists of color
+/// management system instance id, source color space, rendering intent and color components.
+/// Memo is used as follows: lookup is performed in the constructor, if color is not found,
+/// then it is converted by the color management system and stored.
+class PDFCMSColorMemo
+{
+public:
+    static constexpr size_t MAX_COMPONENTS = 8;
+
+    /// Creates memo for color in Device Gray, Device RGB, Device CMYK or ICC color space
+    explicit PDFCMSColorMemo(quint64 cmsId,
+                             PDFCMS::ColorSpaceType colorSpaceType,
+                             RenderingIntent intent,
+                             const PDFColor& color,
+                             const QByteArray& iccID = QByteArray());
+
+    /// Creates memo for color in XYZ color space with given white point
+    explicit PDFCMSColorMemo(quint64 cmsId,
+                             RenderingIntent intent,
+                             const PDFColor3& whitePoint,
+                             const PDFColor3& color);
+
+    /// Returns true, if color was found in the memo
+    bool isFound() const { return m_found; }
+
+    /// Returns color found in the memo
+    QColor getColor() const { return m_entry->color; }
+
+    /// Stores valid color into the memo and returns it
+    QColor store(QColor color);
+
+private:
+    static constexpr size_t ENTRY_COUNT = 256;
+
+    struct Entry
+    {
+        quint64 cmsId = 0;
+        PDFCMS::ColorSpaceType colorSpaceType = PDFCMS::Invalid;
+        RenderingIntent intent = RenderingIntent::Unknown;
+        size_t componentCount = 0;
+        std::array<PDFColorComponent, MAX_COMPONENTS> components = { };
+        QByteArray iccID;
+        QColor color;
+
+        bool isSameKey(const Entry& other) const;
+    };
+
+    /// Finds entry for the key in the memo of the current thread
+    void lookup();
+
+    Entry m_key;
+    Entry* m_entry = nullptr;
+    bool m_found = false;
+};
+
+PDFCMSColorMemo::PDFCMSColorMemo(quint64 cmsId,
+                                 PDFCMS::ColorSpaceType colorSpaceType,
+                                 RenderingIntent intent,
+                                 const PDFColor& color,
+                                 const QByteArray& iccID)
+{
+    if (color.size() > MAX_COMPONENTS)
+    {
+        // Color is too big to be remembered
+        return;
+    }
+
+    m_key.cmsId = cmsId;
+    m_key.colorSpaceType = colorSpaceType;
+    m_key.intent = intent;
+    m_key.componentCount = color.size();
+    for (size_t i = 0; i < color.size(); ++i)
+    {
+        m_key.components[i] = color[i];
+    }
+    m_key.iccID = iccID;
+    lookup();
+}
+
+PDFCMSColorMemo::PDFCMSColorMemo(quint64 cmsId,
+                                 RenderingIntent intent,
+                                 const PDFColor3& whitePoint,
+                                 const PDFColor3& color)
+{
+    m_key.cmsId = cmsId;
+    m_key.colorSpaceType = PDFCMS::XYZ;
+    m_key.intent = intent;
+    m_key.componentCount = whitePoint.size() + color.size();
+    std::copy(whitePoint.cbegin(), whitePoint.cend(), m_key.components.begin());
+    std::copy(color.cbegin(), color.cend(), std::next(m_key.components.begin(), whitePoint.size()));
+    lookup();
+}
+
+void PDFCMSColorMemo::lookup()
+{
+    // FNV-1a hash of the key
+    uint32_t hash = 2166136261u;
+    auto addToHash = [&hash](uint32_t value)
+    {
+        hash = (hash ^ value) * 16777619u;
+    };
+
+    addToHash(uint32_t(m_key.cmsId));
+    addToHash(uint32_t(m_key.colorSpaceType) | (uint32_t(m_key.intent) << 8));
+    for (size_t i = 0; i < m_key.componentCount; ++i)
+    {
+        uint32_t bits = 0;
+        std::memcpy(&bits, &m_key.components[i], sizeof(bits));
+        addToHash(bits);
+    }
+
+    thread_local std::array<Entry, ENTRY_COUNT> entries;
+    m_entry = &entries[(hash ^ (hash >> 16)) % ENTRY_COUNT];
+    m_found = m_entry->isSameKey(m_key);
+}
+
+QColor PDFCMSColorMemo::store(QColor color)
+{
+    if (m_entry && color.isValid())
+    {
+        *m_entry = m_key;
+        m_entry->color = color;
+    }
+
+    return color;
+}
+
+bool PDFCMSColorMemo::Entry::isSameKey(const Entry& other) const
+{
+    return cmsId == other.cmsId &&
+           colorSpaceType == other.colorSpaceType &&
+           intent == other.intent &&
+           componentCount == other.componentCount &&
+           std::equal(components.cbegin(), std::next(components.cbegin(), componentCount), other.components.cbegin()) &&
+           iccID == other.iccID;
+}
+
 class PDFLittleCMS : public PDFCMS
 {
 public:
@@ -86,6 +229,7 @@ public:
     virtual bool fillRGBBufferFromXYZ(const PDFColor3& whitePoint, const std::vector<float>& colors, RenderingIntent intent, unsigned char* outputBuffer, PDFRenderErrorReporter* reporter) const override;
     virtual bool fillRGBBufferFromICC(const std::vector<float>& colors, RenderingIntent renderingIntent, unsigned char* outputBuffer, const QByteArray& iccID, const QByteArray& iccData, PDFRenderErrorReporter* reporter) const override;
     virtual bool transformColorSpace(const ColorSpaceTransformParams& params) const override;
+    virtual bool getColors(ColorSpaceType colorSpaceType, const std::vector<float>& colors, size_t componentCount, RenderingIntent intent, const QByteArray& iccID, const QByteArray& iccData, QRgb* outputColors, PDFRenderErrorReporter* reporter) const override;
     virtual PDFColorConvertor getColorConvertor() const override;
 
 private:
@@ -523,7 +667,14 @@ QColor PDFLittleCMS::getPaperColor() const
 
 QColor PDFLittleCMS::getColorFromDeviceGray(const PDFColor& color, RenderingIntent intent, PDFRenderErrorReporter* reporter) const
 {
-    cmsHTRANSFORM transform = getTransform(Gray, getEffectiveRenderingIntent(intent), false);
+    const RenderingIntent effectiveIntent = getEffectiveRenderingIntent(intent);
+    PDFCMSColorMemo memo(getInstanceId(), DeviceGray, effectiveIntent, color);
+    if (memo.isFound())
+    {
+        return memo.getColor();
+    }
+
+    cmsHTRANSFORM transform = getTransform(Gray, effectiveIntent, false);
 
     if (!transform)
     {
@@ -538,7 +689,7 @@ QColor PDFLittleCMS::getColorFromDeviceGray(const PDFColor& color, RenderingInte
         const float grayColor = color[0];
         std::array<float, 3> rgbOutputColor = { };
         cmsDoTransform(transform, &grayColor, rgbOutputColor.data(), 1);
-        return getColorFromOutputColor(rgbOutputColor);
+        return memo.store(getColorFromOutputColor(rgbOutputColor));
     }
     else
     {
@@ -550,7 +701,14 @@ QColor PDFLittleCMS::getColorFromDeviceGray(const PDFColor& color, RenderingInte
 
 QColor PDFLittleCMS::getColorFromDeviceRGB(const PDFColor& color, RenderingIntent intent, PDFRenderErrorReporter* reporter) const
 {
-    cmsHTRANSFORM transform = getTransform(RGB, getEffectiveRenderingIntent(intent), false);
+    const RenderingIntent effectiveIntent = getEffectiveRenderingIntent(intent);
+    PDFCMSColorMemo memo(getInstanceId(), DeviceRGB, effectiveIntent, color);
+    if (memo.isFound())
+    {
+        return memo.getColor();
+    }
+
+    cmsHTRANSFORM transform = getTransform(RGB, effectiveIntent, false);
 
     if (!transform)
     {
@@ -565,7 +723,7 @@ QColor PDFLittleCMS::getColorFromDeviceRGB(const PDFColor& color, RenderingInten
         std::array<float, 3> rgbInputColor = { color[0], color[1], color[2] };
         std::array<float, 3> rgbOutputColor = { };
         cmsDoTransform(transform, rgbInputColor.data(), rgbOutputColor.data(), 1);
-        return getColorFromOutputColor(rgbOutputColor);
+        return memo.store(getColorFromOutputColor(rgbOutputColor));
     }
     else
     {
@@ -577,7 +735,14 @@ QColor PDFLittleCMS::getColorFromDeviceRGB(const PDFColor& color, RenderingInten
 
 QColor PDFLittleCMS::getColorFromDeviceCMYK(const PDFColor& color, RenderingIntent intent, PDFRenderErrorReporter* reporter) const
 {
-    cmsHTRANSFORM transform = getTransform(CMYK, getEffectiveRenderingIntent(intent), false);
+    const RenderingIntent effectiveIntent = getEffectiveRenderingIntent(intent);
+    PDFCMSColorMemo memo(getInstanceId(), DeviceCMYK, effectiveIntent, color);
+    if (memo.isFound())
+    {
+        return memo.getColor();
+    }
+
+    cmsHTRANSFORM transform = getTransform(CMYK, effectiveIntent, false);
 
     if (!transform)
     {
@@ -592,7 +757,7 @@ QColor PDFLittleCMS::getColorFromDeviceCMYK(const PDFColor& color, RenderingInte
         std::array<float, 4> cmykInputColor = { color[0] * 100.0f, color[1] * 100.0f, color[2] * 100.0f, color[3] * 100.0f };
         std::array<float, 3> rgbOutputColor = { };
         cmsDoTransform(transform, cmykInputColor.data(), rgbOutputColor.data(), 1);
-        return getColorFromOutputColor(rgbOutputColor);
+        return memo.store(getColorFromOutputColor(rgbOutputColor));
     }
     else
     {
@@ -604,7 +769,14 @@ QColor PDFLittleCMS::getColorFromDeviceCMYK(const PDFColor& color, RenderingInte
 
 QColor PDFLittleCMS::getColorFromXYZ(const PDFColor3& whitePoint, const PDFColor3& color, RenderingIntent intent, PDFRenderErrorReporter* reporter) const
 {
-    cmsHTRANSFORM transform = getTransform(XYZ, getEffectiveRenderingIntent(intent), false);
+    const RenderingIntent effectiveIntent = getEffectiveRenderingIntent(intent);
+    PDFCMSColorMemo memo(getInstanceId(), effectiveIntent, whitePoint, color);
+    if (memo.isFound())
+    {
+        return memo.getColor();
+    }
+
+    cmsHTRANSFORM transform = getTransform(XYZ, effectiveIntent, false);
 
     if (!transform)
     {
@@ -620,7 +792,7 @@ QColor PDFLittleCMS::getColorFromXYZ(const PDFColor3& whitePoint, const PDFColor
         const PDFColor3 xyzInputColor = adaptationMatrix * color;
         std::array<float, 3> rgbOutputColor = { };
         cmsDoTransform(transform, xyzInputColor.data(), rgbOutputColor.data(), 1);
-        return getColorFromOutputColor(rgbOutputColor);
+        return memo.store(getColorFromOutputColor(rgbOutputColor));
     }
     else
     {
@@ -689,6 +861,12 @@ cmsHTRANSFORM PDFLittleCMS::getTransformFromICCProfile(const QByteArray& iccData
 
 QColor PDFLittleCMS::getColorFromICC(const PDFColor& color, RenderingIntent renderingIntent, const QByteArray& iccID, const QByteArray& iccData, PDFRenderErrorReporter* reporter) const
 {
+    PDFCMSColorMemo memo(getInstanceId(), ICC, getEffectiveRenderingIntent(renderingIntent), color, iccID);
+    if (memo.isFound())
+    {
+        return memo.getColor();
+    }
+
     cmsHTRANSFORM transform = getTransformFromICCProfile(iccData, iccID, renderingIntent, false);
 
     if (!transform)
@@ -711,7 +889,7 @@ QColor PDFLittleCMS::getColorFromICC(const PDFColor& color, RenderingIntent rend
 
         std::array<float, 3> rgbOutputColor = { };
         cmsDoTransform(transform, inputBuffer.data(), rgbOutputColor.data(), 1);
-        return getColorFromOutputColor(rgbOutputColor);
+        return memo.store(getColorFromOutputColor(rgbOutputColor));
     }
     else
     {
@@ -721,6 +899,86 @@ QColor PDFLittleCMS::getColorFromICC(const PDFColor& color, RenderingIntent rend
     return QColor();
 }
 
+bool PDFLittleCMS::getColors(ColorSpaceType colorSpaceType,
+                             const std::vector<float>& colors,
+                             size_t componentCount,
+                             RenderingIntent intent,
+                             const QByteArray& iccID,
+                             const QByteArray& iccData,
+                             QRgb* outputColors,
+                             PDFRenderErrorReporter* reporter) const
+{
+    Q_UNUSED(reporter);
+
+    if (componentCount == 0 || colors.size() % componentCount != 0)
+    {
+        return false;
+    }
+
+    // Errors are not reported here, caller converts colors one by one
+    // in case of failure, and errors are reported then.
+    cmsHTRANSFORM transform = cmsHTRANSFORM();
+    switch (colorSpaceType)
+    {
+        case DeviceGray:
+            transform = getTransform(Gray, getEffectiveRenderingIntent(intent), false);
+            break;
+
+        case DeviceRGB:
+            transform = getTransform(RGB, getEffectiveRenderingIntent(intent), false);
+            break;
+
+        case DeviceCMYK:
+            transform = getTransform(CMYK, getEffectiveRenderingIntent(intent), false);
+            break;
+
+        case ICC:
+            transform = getTransformFromICCProfile(iccData, iccID, intent, false);
+            break;
+
+        default:
+            return false;
+    }
+
+    if (!transform)
+    {
+        return false;
+    }
+
+    const cmsUInt32Number format = cmsGetTransformInputFormat(transform);
+    if (!T_FLOAT(format) || T_BYTES(format) != sizeof(float) || T_CHANNELS(format) != componentCount || T_EXTRA(format) != 0)
+    {
+        return false;
+    }
+
+    Q_ASSERT(cmsGetTransformOutputFormat(transform) == TYPE_RGB_FLT);
+
+    const float* inputColors = colors.data();
+    std::vector<float> cmykColors;
+
+    if (T_COLORSPACE(format) == PT_CMYK)
+    {
+        cmykColors = colors;
+        for (float& value : cmykColors)
+        {
+            value *= 100.0f;
+        }
+        inputColors = cmykColors.data();
+    }
+
+    const size_t colorCount = colors.size() / componentCount;
+    std::vector<float> rgbOutputColors(colorCount * 3, 0.0f);
+    cmsDoTransform(transform, inputColors, rgbOutputColors.data(), static_cast<cmsUInt32Number>(colorCount));
+
+    for (size_t i = 0; i < colorCount; ++i)
+    {
+        const float* rgbOutputColor = rgbOutputColors.data() + 3 * i;
+        outputColors[i] = getColorFromOutputColor({ rgbOutputColor[0], rgbOutputColor[1], rgbOutputColor[2] }).rgb();
+    }
+
+    return true;
+}
+
 void PDFLittleCMS::init()
 {
     // Jakub Melka: initialize all color profiles
@@ -1865,6 +2123,70 @@ PDFColorProfileIdentifier PDFColorProfileIdentifier::createOutputIntent(PDFColor
     return result;
 }
 
+PDFCMS::PDFCMS()
+{
+    static std::atomic<quint64> s_instanceCounter = 0;
+    m_instanceId = ++s_instanceCounter;
+}
+
+bool PDFCMS::getColors(ColorSpaceType colorSpaceType,
+                       const std::vector<float>& colors,
+                       size_t componentCount,
+                       RenderingIntent intent,
+                       const QByteArray& iccID,
+                       const QByteArray& iccData,
+                       QRgb* outputColors,
+                       PDFRenderErrorReporter* reporter) const
+{
+    if (componentCount == 0 || colors.size() % componentCount != 0)
+    {
+        return false;
+    }
+
+    PDFColor color;
+    color.resize(componentCount);
+
+    for (size_t i = 0; i < colors.size(); i += componentCount)
+    {
+        for (size_t j = 0; j < componentCount; ++j)
+        {
+            color[j] = colors[i + j];
+        }
+
+        QColor transformedColor;
+        switch (colorSpaceType)
+        {
+            case DeviceGray:
+                transformedColor = getColorFromDeviceGray(color, intent, reporter);
+                break;
+
+            case DeviceRGB:
+                transformedColor = getColorFromDeviceRGB(color, intent, reporter);
+                break;
+
+            case DeviceCMYK:
+                transformedColor = getColorFromDeviceCMYK(color, intent, reporter);
+                break;
+
+            case ICC:
+                transformedColor = getColorFromICC(color, intent, iccID, iccData, reporter);
+                break;
+
+            default:
+                break;
+        }
+
+        if (!transformedColor.isValid())
+        {
+            return false;
+        }
+
+        *outputColors++ = transformedColor.rgb();
+    }
+
+    return true;
+}
+
 PDFColor3 PDFCMS::getDefaultXYZWhitepoint()
 {
     const cmsCIEXYZ* whitePoint = cmsD50_XYZ();
@@ -98,9 +98,14 @@ struct PDFCMSSettings
 class PDFCMS
 {
 public:
-    explicit inline PDFCMS() = default;
+    explicit PDFCMS();
     virtual ~PDFCMS() = default;
 
+    /// Returns identifier of this color management system instance. Identifiers
+    /// are never reused, so identifier can be used as a key in caches of colors
+    /// (or images) converted by this color management system.
+    quint64 getInstanceId() const { return m_instanceId; }
+
     /// This function should decide, if color management system is compatible with these
     /// settings (so, it transforms colors according to this setting). If this
     /// function returns false, then this color management system should be replaced
@@ -258,8 +263,33 @@ public:
     /// it just transforms two float buffers from input color space to output color space.
     virtual bool transformColorSpace(const ColorSpaceTransformParams& params) const = 0;
 
+    /// Converts batch of colors in Device Gray, Device RGB, Device CMYK or ICC color space
+    /// to the target device color space. Colors are stored in \p colors one after another,
+    /// each color has \p componentCount components. Color management system can transform
+    /// all colors at once instead of transforming them one by one. If error occurs, then
+    /// false is returned, and caller should convert colors one by one.
+    /// \param colorSpaceType Source color space type (XYZ is not supported)
+    /// \param colors Input colors
+    /// \param componentCount Number of components of a single color
+    /// \param intent Rendering intent
+    /// \param iccID Unique ICC profile identifier (ICC color space only)
+    /// \param iccData Color profile data (ICC color space only)
+    /// \param outputColors Output colors, must be big enough to contain all colors
+    /// \param reporter Render error reporter (used, when color transform fails)
+    virtual bool getColors(ColorSpaceType colorSpaceType,
+                           const std::vector<float>& colors,
+                           size_t componentCount,
+                           RenderingIntent intent,
+                           const QByteArray& iccID,
+                           const QByteArray& iccData,
+                           QRgb* outputColors,
+                           PDFRenderErrorReporter* reporter) const;
+
     /// Get D50 white point for XYZ color space
     static PDFColor3 getDefaultXYZWhitepoint();
+
+private:
+    quint64 m_instanceId;
 };
 
 using PDFCMSPointer = QSharedPointer<PDFCMS>;
@@ -23,6 +23,7 @@
 #include "pdfpattern.h"
 #include "pdfcms.h"
 #include "pdfexecutionpolicy.h"
+#include "pdfsimdkernels.h"
 
 #include <QCryptographicHash>
 
@@ -55,6 +56,54 @@ PDFColorComponentMatrix_3x3 getInverseMatrix(const PDFColorComponentMatrix_3x3&
     return inversedMatrix;
 }
 
+/// Transforms colors using batched color conversion of color management system.
+/// Color components are clipped using \p clip function. If batched conversion
+/// fails, then empty vector is returned.
+/// \param colors Input colors
+/// \param componentCount Color component count of the color space
+/// \param colorSpaceType Color space type
+/// \param iccID Unique ICC profile identifier (ICC color space only)
+/// \param iccData Color profile data (ICC color space only)
+/// \param cms Color management system
+/// \param intent Rendering intent
+/// \param reporter Render error reporter
+/// \param clip Clipping function of the color component
+template<typename ClipFunction>
+static std::vector<QRgb> getRGBColorsFromCMS(const std::vector<PDFColor>& colors,
+                                             size_t componentCount,
+                                             PDFCMS::ColorSpaceType colorSpaceType,
+                                             const QByteArray& iccID,
+                                             const QByteArray& iccData,
+                                             const PDFCMS* cms,
+                                             RenderingIntent intent,
+                                             PDFRenderErrorReporter* reporter,
+                                             ClipFunction clip)
+{
+    std::vector<float> components;
+    components.reserve(colors.size() * componentCount);
+
+    for (const PDFColor& color : colors)
+    {
+        if (color.size() != componentCount)
+        {
+            return std::vector<QRgb>();
+        }
+
+        for (size_t i = 0; i < componentCount; ++i)
+        {
+            components.push_back(clip(color[i], i));
+        }
+    }
+
+    std::vector<QRgb> result(colors.size(), QRgb());
+    if (!cms->getColors(colorSpaceType, components, componentCount, intent, iccID, iccData, result.data(), reporter))
+    {
+        result.clear();
+    }
+
+    return result;
+}
+
 PDFColor PDFDeviceGrayColorSpace::getDefaultColorOriginal() const
 {
     return PDFColor(0.0f);
@@ -94,6 +143,18 @@ void PDFDeviceGrayColorSpace::fillRGBBuffer(const std::vector<float>& colors, un
     }
 }
 
+std::vector<QRgb> PDFDeviceGrayColorSpace::getRGBColors(const std::vector<PDFColor>& colors, const PDFCMS* cms, RenderingIntent intent, PDFRenderErrorReporter* reporter) const
+{
+    auto clip = [](PDFColorComponent component, size_t) { return component; };
+    std::vector<QRgb> result = getRGBColorsFromCMS(colors, getColorComponentCount(), PDFCMS::DeviceGray, QByteArray(), QByteArray(), cms, intent, reporter, clip);
+    if (result.size() == colors.size())
+    {
+        return result;
+    }
+
+    return PDFAbstractColorSpace::getRGBColors(colors, cms, intent, reporter);
+}
+
 PDFColor PDFDeviceRGBColorSpace::getDefaultColorOriginal() const
 {
     return PDFColor(0.0f, 0.0f, 0.0f);
@@ -133,6 +194,18 @@ void PDFDeviceRGBColorSpace::fillRGBBuffer(const std::vector<float>& colors, uns
     }
 }
 
+std::vector<QRgb> PDFDeviceRGBColorSpace::getRGBColors(const std::vector<PDFColor>& colors, const PDFCMS* cms, RenderingIntent intent, PDFRenderErrorReporter* reporter) const
+{
+    auto clip = [](PDFColorComponent component, size_t) { return clip01(component); };
+    std::vector<QRgb> result = getRGBColorsFromCMS(colors, getColorComponentCount(), PDFCMS::DeviceRGB, QByteArray(), QByteArray(), cms, intent, reporter, clip);
+    if (result.size() == colors.size())
+    {
+        return result;
+    }
+
+    return PDFAbstractColorSpace::getRGBColors(colors, cms, intent, reporter);
+}
+
 PDFColor PDFDeviceCMYKColorSpace::getDefaultColorOriginal() const
 {
     return PDFColor(0.0f, 0.0f, 0.0f, 1.0f);
@@ -173,6 +246,18 @@ void PDFDeviceCMYKColorSpace::fillRGBBuffer(const std::vector<float>& colors, un
     }
 }
 
+std::vector<QRgb> PDFDeviceCMYKColorSpace::getRGBColors(const std::vector<PDFColor>& colors, const PDFCMS* cms, RenderingIntent intent, PDFRenderErrorReporter* reporter) const
+{
+    auto clip = [](PDFColorComponent component, size_t) { return clip01(component); };
+    std::vector<QRgb> result = getRGBColorsFromCMS(colors, getColorComponentCount(), PDFCMS::DeviceCMYK, QByteArray(), QByteArray(), cms, intent, reporter, clip);
+    if (result.size() == colors.size())
+    {
+        return result;
+    }
+
+    return PDFAbstractColorSpace::getRGBColors(colors, cms, intent, reporter);
+}
+
 bool PDFAbstractColorSpace::equals(const PDFAbstractColorSpace* other) const
 {
     return getColorSpace() == other->getColorSpace();
@@ -254,7 +339,28 @@ QImage PDFAbstractColorSpace::getImage(const PDFImageData& imageData,
                         std::vector<float> inputColors(imageWidth * componentCount, 0.0f);
                         auto itInputColor = inputColors.begin();
 
-                        if (!decode.empty())
+                        const unsigned int bitsPerComponent = imageData.getBitsPerComponent();
+                        const qint64 lineOffset = qint64(i) * imageData.getStride();
+                        const qint64 lineBytes = (qint64(inputColors.size()) * bitsPerComponent + 7) / 8;
+
+                        if (PDFSimdKernels::isUnpackSupported(bitsPerComponent) && lineOffset + lineBytes <= imageData.getData().size())
+                        {
+                            // Fast path - unpack whole line at once
+                            const uint8_t* lineData = convertByteArrayToUcharPtr(imageData.getData()) + lineOffset;
+                            PDFSimdKernels::unpackNormalizedSamples(lineData, inputColors.data(), inputColors.size(), bitsPerComponent);
+
+                            if (!decode.empty())
+                            {
+                                for (size_t j = 0; j < inputColors.size(); j += componentCount)
+                                {
+                                    for (unsigned int k = 0; k < componentCount; ++k)
+                                    {
+                                        inputColors[j + k] = decode[2 * k] + inputColors[j + k] * (decode[2 * k + 1] - decode[2 * k]);
+                                    }
+                                }
+                            }
+                        }
+                        else if (!decode.empty())
                         {
                             // Interpolate value
                             for (unsigned int j = 0; j < imageData.getWidth(); ++j)
@@ -517,6 +623,22 @@ void PDFAbstractColorSpace::fillRGBBuffer(const std::vector<float>& colors,
     }
 }
 
+std::vector<QRgb> PDFAbstractColorSpace::getRGBColors(const std::vector<PDFColor>& colors,
+                                                      const PDFCMS* cms,
+                                                      RenderingIntent intent,
+                                                      PDFRenderErrorReporter* reporter) const
+{
+    std::vector<QRgb> result;
+    result.reserve(colors.size());
+
+    for (const PDFColor& color : colors)
+    {
+        result.push_back(getColor(color, cms, intent, reporter, true).rgb());
+    }
+
+    return result;
+}
+
 QColor PDFAbstractColorSpace::getCheckedColor(const PDFColor& color, const PDFCMS* cms, RenderingIntent intent, PDFRenderErrorReporter* reporter) const
 {
     if (getColorComponentCount() != color.size())
@@ -1685,6 +1807,24 @@ void PDFICCBasedColorSpace::fillRGBBuffer(const std::vector<float>& colors, unsi
     }
 }
 
+std::vector<QRgb> PDFICCBasedColorSpace::getRGBColors(const std::vector<PDFColor>& colors, const PDFCMS* cms, RenderingIntent intent, PDFRenderErrorReporter* reporter) const
+{
+    auto clip = [this](PDFColorComponent component, size_t componentIndex)
+    {
+        const size_t imin = 2 * componentIndex + 0;
+        const size_t imax = 2 * componentIndex + 1;
+        return qBound(m_range[imin], component, m_range[imax]);
+    };
+
+    std::vector<QRgb> result = getRGBColorsFromCMS(colors, getColorComponentCount(), PDFCMS::ICC, m_iccProfileDataChecksum, m_iccProfileData, cms, intent, reporter, clip);
+    if (result.size() == colors.size())
+    {
+        return result;
+    }
+
+    return PDFAbstractColorSpace::getRGBColors(colors, cms, intent, reporter);
+}
+
 bool PDFICCBasedColorSpace::equals(const PDFAbstractColorSpace* other) const
 {
     if (!PDFAbstractColorSpace::equals(other))
@@ -2591,7 +2731,7 @@ PDFColorSpacePointer PDFDeviceNColorSpace::createDeviceNColorSpace(const PDFDict
                     const PDFReal defaultSolidity = loader.readNumberFromDictionary(solidityDictionary, "Default", 0.0);
                     for (ColorantInfo& colorantInfo : colorants)
                     {
-                        colorantInfo.solidity = loader.readNumberFromDictionary(solidityDictionary, colorantInfo.name, defaultSolidity);
+                        colorantInfo.solidity = loader.readNumberFromDictionary(solidityDictionary, PDFNameAtom(colorantInfo.name), defaultSolidity);
                     }
                 }
 
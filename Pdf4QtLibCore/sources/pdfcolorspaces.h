@@ -388,6 +388,18 @@ public:
                                const PDFCMS* cms,
                                PDFRenderErrorReporter* reporter) const;
 
+    /// Transforms batch of colors. Result is the same as if \p getColor is called
+    /// for each color (with range [0, 1]), but color spaces, which are handled by color
+    /// management system, transform all colors at once.
+    /// \param colors Input colors
+    /// \param cms Color management system
+    /// \param intent Rendering intent
+    /// \param reporter Render error reporter
+    virtual std::vector<QRgb> getRGBColors(const std::vector<PDFColor>& colors,
+                                           const PDFCMS* cms,
+                                           RenderingIntent intent,
+                                           PDFRenderErrorReporter* reporter) const;
+
     /// If this class is pattern space, returns this, otherwise returns nullptr.
     virtual const PDFPatternColorSpace* asPatternColorSpace() const { return nullptr; }
 
@@ -566,6 +578,7 @@ public:
     virtual QColor getColor(const PDFColor& color, const PDFCMS* cms, RenderingIntent intent, PDFRenderErrorReporter* reporter, bool isRange01) const override;
     virtual size_t getColorComponentCount() const override;
     virtual void fillRGBBuffer(const std::vector<float>& colors,unsigned char* outputBuffer, RenderingIntent intent, const PDFCMS* cms, PDFRenderErrorReporter* reporter) const override;
+    virtual std::vector<QRgb> getRGBColors(const std::vector<PDFColor>& colors, const PDFCMS* cms, RenderingIntent intent, PDFRenderErrorReporter* reporter) const override;
 };
 
 class PDFDeviceRGBColorSpace : public PDFAbstractColorSpace
@@ -579,6 +592,7 @@ public:
     virtual QColor getColor(const PDFColor& color, const PDFCMS* cms, RenderingIntent intent, PDFRenderErrorReporter* reporter, bool isRange01) const override;
     virtual size_t getColorComponentCount() const override;
     virtual void fillRGBBuffer(const std::vector<float>& colors,unsigned char* outputBuffer, RenderingIntent intent, const PDFCMS* cms, PDFRenderErrorReporter* reporter) const override;
+    virtual std::vector<QRgb> getRGBColors(const std::vector<PDFColor>& colors, const PDFCMS* cms, RenderingIntent intent, PDFRenderErrorReporter* reporter) const override;
 };
 
 class PDFDeviceCMYKColorSpace : public PDFAbstractColorSpace
@@ -592,6 +606,7 @@ public:
     virtual QColor getColor(const PDFColor& color, const PDFCMS* cms, RenderingIntent intent, PDFRenderErrorReporter* reporter, bool isRange01) const override;
     virtual size_t getColorComponentCount() const override;
     virtual void fillRGBBuffer(const std::vector<float>& colors,unsigned char* outputBuffer, RenderingIntent intent, const PDFCMS* cms, PDFRenderErrorReporter* reporter) const override;
+    virtual std::vector<QRgb> getRGBColors(const std::vector<PDFColor>& colors, const PDFCMS* cms, RenderingIntent intent, PDFRenderErrorReporter* reporter) const override;
 };
 
 class PDFXYZColorSpace : public PDFAbstractColorSpace
@@ -714,6 +729,7 @@ public:
     virtual QColor getColor(const PDFColor& color, const PDFCMS* cms, RenderingIntent intent, PDFRenderErrorReporter* reporter, bool isRange01) const override;
     virtual size_t getColorComponentCount() const override;
     virtual void fillRGBBuffer(const std::vector<float>& colors, unsigned char* outputBuffer, RenderingIntent intent, const PDFCMS* cms, PDFRenderErrorReporter* reporter) const override;
+    virtual std::vector<QRgb> getRGBColors(const std::vector<PDFColor>& colors, const PDFCMS* cms, RenderingIntent intent, PDFRenderErrorReporter* reporter) const override;
     virtual bool equals(const PDFAbstractColorSpace* other) const override;
 
     PDFObjectReference getMetadata() const { return m_metadata; }
@@ -74,6 +74,9 @@ static constexpr const int PDF_MAX_COLOR_COMPONENTS = 32;
 // Cache limits
 static constexpr size_t DEFAULT_FONT_CACHE_LIMIT = 32;
 static constexpr size_t DEFAULT_REALIZED_FONT_CACHE_LIMIT = 128;
+static constexpr size_t DEFAULT_IMAGE_CACHE_LIMIT = 128 * 1024 * 1024; // [bytes]
+static constexpr size_t DEFAULT_BYTECODE_CACHE_LIMIT = 64 * 1024 * 1024; // [bytes]
+static constexpr size_t DEFAULT_GLYPH_CACHE_LIMIT = 32 * 1024 * 1024; // [bytes]
 
 }   // namespace pdf
 
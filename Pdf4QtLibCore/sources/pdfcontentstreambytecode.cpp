@@ -0,0 +1,421 @@
+//    Copyright (C) 2024 Jakub Melka
+//
+//    This file is part of PDF4QT.
+//
+//    PDF4QT is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    with the written consent of the copyright owner, any later version.
+//
+//    PDF4QT is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public License
+//    along with PDF4QT.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "pdfcontentstreambytecode.h"
+#include "pdfdocument.h"
+#include "pdfexception.h"
+#include "pdfstreamfilters.h"
+
+#include <QHash>
+
+#include "pdfdbgheap.h"
+
+namespace pdf
+{
+
+void PDFContentStreamParser::parse(const QByteArray& content)
+{
+    PDFLexicalAnalyzer parser(content.constBegin(), content.constEnd());
+
+    while (!parser.isAtEnd() && !isParsingCancelled())
+    {
+        bool tokenFetched = false;
+        PDFInteger oldParserPosition = parser.pos();
+
+        try
+        {
+            PDFLexicalAnalyzer::Token token = parser.fetch();
+            tokenFetched = true;
+
+            Operand operand;
+            operand.type = token.type;
+
+            switch (token.type)
+            {
+                case TokenType::Command:
+                {
+                    QByteArray command = token.data.toByteArray();
+
+                    if (command == "BI")
+                    {
+                        onInlineImage(readInlineImage(parser, content));
+                    }
+                    else
+                    {
+                        onOperator(PDFPageContentProcessor::getOperator(command), command);
+                    }
+                    break;
+                }
+
+                case TokenType::EndOfFile:
+                {
+                    // Do nothing, just break, we are at the end
+                    break;
+                }
+
+                case TokenType::Boolean:
+                {
+                    operand.boolean = token.data.toBool();
+                    onOperand(operand);
+                    break;
+                }
+
+                case TokenType::Integer:
+                {
+                    operand.integer = token.data.value<PDFInteger>();
+                    onOperand(operand);
+                    break;
+                }
+
+                case TokenType::Real:
+                {
+                    operand.real = token.data.value<PDFReal>();
+                    onOperand(operand);
+                    break;
+                }
+
+                case TokenType::String:
+                case TokenType::Name:
+                {
+                    QByteArray string = token.data.toByteArray();
+                    operand.string = &string;
+                    onOperand(operand);
+                    break;
+                }
+
+                default:
+                {
+                    // Tokens without data (array/dictionary delimiters, null object)
+                    onOperand(operand);
+                    break;
+                }
+            }
+        }
+        catch (const PDFException& exception)
+        {
+            // If we get exception when parsing, and parser position is not advanced,
+            // then we must advance it manually, otherwise we get infinite loop.
+            if (!tokenFetched && oldParserPosition == parser.pos() && !parser.isAtEnd())
+            {
+                parser.seek(parser.pos() + 1);
+            }
+
+            onError(exception.getMessage());
+        }
+    }
+}
+
+/// Parser, which stores parsed content stream into the bytecode
+class PDFContentStreamBytecode::Translator : public PDFContentStreamParser
+{
+public:
+    explicit Translator(const PDFDocument* document, PDFContentStreamBytecode* bytecode) :
+        PDFContentStreamParser(document),
+        m_bytecode(bytecode),
+        m_firstOperandIndex(0)
+    {
+
+    }
+
+    /// Finishes the translation, operands at the end of the content stream
+    /// remain on the operand stack, operator can be in the next content stream of the page.
+    void finish()
+    {
+        if (m_firstOperandIndex < m_bytecode->m_operands.size())
+        {
+            addInstruction(InstructionType::Operands, Operator::Invalid, 0);
+        }
+    }
+
+protected:
+    virtual void onOperand(const Operand& operand) override
+    {
+        Operand storedOperand = operand;
+        if (operand.string)
+        {
+            storedOperand.string = &m_bytecode->m_strings[addString(*operand.string)];
+        }
+        m_bytecode->m_operands.push_back(storedOperand);
+    }
+
+    virtual void onOperator(Operator op, const QByteArray& command) override
+    {
+        addInstruction(InstructionType::Operator, op, addString(command));
+    }
+
+    virtual void onInlineImage(PDFStream&& inlineImage) override
+    {
+        m_bytecode->m_inlineImages.push_back(std::move(inlineImage));
+        addInstruction(InstructionType::InlineImage, Operator::Invalid, static_cast<uint32_t>(m_bytecode->m_inlineImages.size() - 1));
+    }
+
+    virtual void onError(const QString& message) override
+    {
+        m_bytecode->m_errors.push_back(message);
+        addInstruction(InstructionType::Error, Operator::Invalid, static_cast<uint32_t>(m_bytecode->m_errors.size() - 1));
+    }
+
+private:
+    uint32_t addString(const QByteArray& string)
+    {
+        auto it = m_stringIndices.constFind(string);
+        if (it == m_stringIndices.cend())
+        {
+            it = m_stringIndices.insert(string, static_cast<uint32_t>(m_bytecode->m_strings.size()));
+            m_bytecode->m_strings.push_back(string);
+        }
+        return it.value();
+    }
+
+    void addInstruction(InstructionType type, Operator op, uint32_t dataIndex)
+    {
+        if (type == InstructionType::InlineImage || type == InstructionType::Error)
+        {
+            // Operands are discarded by these instructions
+            m_bytecode->m_operands.resize(m_firstOperandIndex);
+        }
+
+        Instruction instruction;
+        instruction.type = type;
+        instruction.op = op;
+        instruction.operandIndex = static_cast<uint32_t>(m_firstOperandIndex);
+        instruction.operandCount = static_cast<uint32_t>(m_bytecode->m_operands.size() - m_firstOperandIndex);
+        instruction.dataIndex = dataIndex;
+        m_bytecode->m_instructions.push_back(instruction);
+
+        m_firstOperandIndex = m_bytecode->m_operands.size();
+    }
+
+    PDFContentStreamBytecode* m_bytecode;
+    QHash<QByteArray, uint32_t> m_stringIndices;
+
+    /// Operands of the current instruction are at the end
+    /// of the operand array, starting with this index.
+    size_t m_firstOperandIndex;
+};
+
+PDFContentStreamBytecode::PDFContentStreamBytecode(const PDFDocument* document, const QByteArray& content)
+{
+    Translator translator(document, this);
+    translator.parse(content);
+    translator.finish();
+
+    m_instructions.shrink_to_fit();
+    m_operands.shrink_to_fit();
+}
+
+qint64 PDFContentStreamBytecode::getMemoryConsumptionEstimate() const
+{
+    qint64 memoryConsumption = sizeof(*this);
+    memoryConsumption += m_instructions.capacity() * sizeof(Instruction);
+    memoryConsumption += m_operands.capacity() * sizeof(Operand);
+    memoryConsumption += m_strings.size() * sizeof(QByteArray);
+    memoryConsumption += m_inlineImages.capacity() * sizeof(PDFStream);
+    memoryConsumption += m_errors.capacity() * sizeof(QString);
+
+    for (const QByteArray& string : m_strings)
+    {
+        memoryConsumption += string.size();
+    }
+
+    for (const PDFStream& stream : m_inlineImages)
+    {
+        memoryConsumption += stream.getContent()->size();
+    }
+
+    return memoryConsumption;
+}
+
+PDFStream PDFContentStreamParser::readInlineImage(PDFLexicalAnalyzer& parser, const QByteArray& content) const
+{
+    // Strategy: We will try to find position of BI/ID/EI in the stream. If we can determine
+    // length of the stream explicitly, then we use explicit length. We also create a PDFObject
+    // from the inline image dictionary/image content stream and then process it like XObject.
+    PDFInteger operatorBIPosition = parser.pos();
+    PDFInteger operatorIDPosition = parser.findSubstring("ID", operatorBIPosition);
+    PDFInteger operatorEIPosition = parser.findSubstring("EI", operatorIDPosition);
+
+    // According the PDF 1.7 specification, single white space characters is after ID, then the byte
+    // immediately after it is interpreted as first byte of image data.
+    PDFInteger startDataPosition = operatorIDPosition + 3;
+
+    if (operatorIDPosition == -1 || operatorEIPosition == -1)
+    {
+        throw PDFException(PDFTranslationContext::tr("Invalid inline image dictionary, ID operator is missing."));
+    }
+
+    Q_ASSERT(operatorBIPosition < content.size());
+    Q_ASSERT(operatorIDPosition < content.size());
+    Q_ASSERT(operatorBIPosition <= operatorIDPosition);
+
+    PDFLexicalAnalyzer inlineImageLexicalAnalyzer(content.constBegin() + operatorBIPosition, content.constBegin() + operatorIDPosition);
+    PDFParser inlineImageParser([&inlineImageLexicalAnalyzer]{ return inlineImageLexicalAnalyzer.fetch(); });
+
+    constexpr std::pair<const char*, const char*> replacements[] =
+    {
+        { "BPC", "BitsPerComponent" },
+        { "CS", "ColorSpace" },
+        { "D", "Decode" },
+        { "DP", "DecodeParms" },
+        { "F", "Filter" },
+        { "H", "Height" },
+        { "IM", "ImageMask" },
+        { "I", "Interpolate" },
+        { "W", "Width" },
+        { "L", "Length" },
+        { "G", "DeviceGray" },
+        { "RGB", "DeviceRGB" },
+        { "CMYK", "DeviceCMYK" }
+    };
+
+    PDFDictionary dictionary;
+
+    while (inlineImageParser.lookahead().type != PDFLexicalAnalyzer::TokenType::EndOfFile)
+    {
+        PDFObject nameObject = inlineImageParser.getObject();
+        PDFObject valueObject = inlineImageParser.getObject();
+
+        if (!nameObject.isName())
+        {
+            throw PDFException(PDFTranslationContext::tr("Expected name in the inline image dictionary stream."));
+        }
+
+        // Replace the name, if neccessary
+        QByteArray name = nameObject.getString();
+        for (auto [string, replacement] : replacements)
+        {
+            if (name == string)
+            {
+                name = replacement;
+                break;
+            }
+        }
+
+        dictionary.addEntry(PDFInplaceOrMemoryString(qMove(name)), qMove(valueObject));
+    }
+
+    PDFDocumentDataLoaderDecorator loader(m_document);
+    PDFInteger dataLength = 0;
+
+    if (dictionary.hasKey("Length"))
+    {
+        dataLength = loader.readIntegerFromDictionary(&dictionary, "Length", 0);
+    }
+    else if (dictionary.hasKey("Filter"))
+    {
+        dataLength = -1;
+
+        // We will try to use stream filter hint
+        QByteArray filterName = loader.readNameFromDictionary(&dictionary, "Filter");
+        if (!filterName.isEmpty())
+        {
+            dataLength = PDFStreamFilterStorage::getStreamDataLength(content, filterName, startDataPosition);
+        }
+
+        if (dataLength == -1)
+        {
+            // We will use EI operator position to determine stream length
+            dataLength = operatorEIPosition - startDataPosition;
+        }
+    }
+    else
+    {
+        // We will calculate stream size from the with/height and bit per component
+        const PDFInteger width = loader.readIntegerFromDictionary(&dictionary, "Width", 0);
+        const PDFInteger height = loader.readIntegerFromDictionary(&dictionary, "Height", 0);
+        const PDFInteger bpc = loader.readIntegerFromDictionary(&dictionary, "BitsPerComponent", 8);
+
+        if (width <= 0 || height <= 0 || bpc <= 0)
+        {
+            throw PDFException(PDFTranslationContext::tr("Expected name in the inline image dictionary stream."));
+        }
+
+        const PDFInteger stride = (width * bpc + 7) / 8;
+        dataLength = stride * height;
+    }
+
+    // We will once more find the "EI" operator, due to recomputed dataLength.
+    operatorEIPosition = parser.findSubstring("EI", startDataPosition + dataLength);
+    if (operatorEIPosition == -1)
+    {
+        throw PDFException(PDFTranslationContext::tr("Invalid inline image stream."));
+    }
+
+    // We must seek after EI operator. Image is painted, when instruction is executed.
+    parser.seek(operatorEIPosition + 2);
+
+    QByteArray buffer = content.mid(startDataPosition, dataLength);
+    return PDFStream(std::move(dictionary), std::move(buffer));
+}
+
+PDFContentStreamBytecodeCache::PDFContentStreamBytecodeCache(qint64 cacheLimit) :
+    m_document(nullptr)
+{
+    m_cache.setMaxCost(cacheLimit);
+}
+
+void PDFContentStreamBytecodeCache::setDocument(const PDFModifiedDocument& document)
+{
+    QMutexLocker lock(&m_mutex);
+    if (m_document != document)
+    {
+        m_document = document;
+
+        if (document.hasReset() || document.hasPageContentsChanged())
+        {
+            m_cache.clear();
+        }
+    }
+}
+
+PDFContentStreamBytecodePointer PDFContentStreamBytecodeCache::getBytecode(const PDFDocument* document, const PDFObject& streamObject) const
+{
+    Q_ASSERT(streamObject.isStream());
+    const PDFStream* stream = streamObject.getStream();
+
+    {
+        QMutexLocker lock(&m_mutex);
+        if (const CacheItem* item = m_cache.object(stream))
+        {
+            return item->bytecode;
+        }
+    }
+
+    // Translate the content stream without locked mutex, so other
+    // threads are not blocked. Stream can be translated twice
+    // in the worst case, which is harmless.
+    QByteArray content = document->getDecodedStream(stream);
+    PDFContentStreamBytecodePointer bytecode(new PDFContentStreamBytecode(document, content));
+
+    QMutexLocker lock(&m_mutex);
+    m_cache.insert(stream, new CacheItem{ streamObject, bytecode }, bytecode->getMemoryConsumptionEstimate());
+    return bytecode;
+}
+
+void PDFContentStreamBytecodeCache::setCacheLimit(qint64 cacheLimit)
+{
+    QMutexLocker lock(&m_mutex);
+    m_cache.setMaxCost(cacheLimit);
+}
+
+void PDFContentStreamBytecodeCache::clear()
+{
+    QMutexLocker lock(&m_mutex);
+    m_cache.clear();
+}
+
+}   // namespace pdf
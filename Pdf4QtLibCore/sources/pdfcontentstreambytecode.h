@@ -0,0 +1,197 @@
+//    Copyright (C) 2024 Jakub Melka
+//
+//    This file is part of PDF4QT.
+//
+//    PDF4QT is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    with the written consent of the copyright owner, any later version.
+//
+//    PDF4QT is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public License
+//    along with PDF4QT.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef PDFCONTENTSTREAMBYTECODE_H
+#define PDFCONTENTSTREAMBYTECODE_H
+
+#include "pdfpagecontentprocessor.h"
+
+#include <QCache>
+#include <QMutex>
+#include <QSharedPointer>
+
+#include <deque>
+
+namespace pdf
+{
+class PDFDocument;
+class PDFModifiedDocument;
+
+/// Parser of the content stream. Content stream is parsed by lexical analyzer and parsed
+/// operands, operators, inline images and errors are passed to the handler functions
+/// in the order, in which they appear in the content stream. Page content processor
+/// uses the parser to interpret the content stream directly, and to translate
+/// the content stream into the bytecode.
+class PDF4QTLIBCORESHARED_EXPORT PDFContentStreamParser
+{
+public:
+    explicit PDFContentStreamParser(const PDFDocument* document) : m_document(document) { }
+    virtual ~PDFContentStreamParser() = default;
+
+    using Operator = PDFPageContentProcessor::Operator;
+    using Operand = PDFPageContentProcessor::Operand;
+    using TokenType = PDFLexicalAnalyzer::TokenType;
+
+    /// Parses the content stream. Parsing errors are passed to the error handler,
+    /// parsing then continues with the next token.
+    /// \param content Decoded content stream
+    void parse(const QByteArray& content);
+
+protected:
+    /// Handles operand. For names and strings, operand refers to the string,
+    /// which exists only during the call of this function.
+    /// \param operand Operand
+    virtual void onOperand(const Operand& operand) = 0;
+
+    /// Handles operator
+    /// \param op Operator
+    /// \param command Command (operator name in the content stream)
+    virtual void onOperator(Operator op, const QByteArray& command) = 0;
+
+    /// Handles inline image (BI ... ID ... EI)
+    /// \param inlineImage Inline image stream
+    virtual void onInlineImage(PDFStream&& inlineImage) = 0;
+
+    /// Handles parsing error. Exceptions of type PDFException thrown
+    /// by the other handlers are also passed to this handler.
+    /// \param message Error message
+    virtual void onError(const QString& message) = 0;
+
+    /// Returns true, if parsing should be stopped
+    virtual bool isParsingCancelled() const { return false; }
+
+private:
+    /// Reads inline image (BI ... ID ... EI) from the content stream. Parser must be
+    /// positioned after the BI operator. After reading, parser is positioned
+    /// after the EI operator. If inline image can't be read, exception is thrown.
+    PDFStream readInlineImage(PDFLexicalAnalyzer& parser, const QByteArray& content) const;
+
+    const PDFDocument* m_document;
+};
+
+/// Content stream translated to the compact bytecode. Content stream is parsed
+/// by lexical analyzer only once, then bytecode can be executed by page content
+/// processor many times (for example, when page is compiled again after zoom
+/// or color settings change). Each instruction has an operator and a range of operands.
+/// Operands are passed to the operators directly. Numeric operands are stored directly,
+/// names and strings refer to the string table of the bytecode.
+class PDF4QTLIBCORESHARED_EXPORT PDFContentStreamBytecode
+{
+public:
+    /// Translates content stream into the bytecode. No exception is thrown. Errors,
+    /// which occur during translation, are stored as instructions, so they are reported
+    /// at the same position in the content stream, when the bytecode is executed.
+    /// \param document Document
+    /// \param content Decoded content stream
+    explicit PDFContentStreamBytecode(const PDFDocument* document, const QByteArray& content);
+
+    // Operands refer to the string table, so bytecode can't be copied or moved
+    inline PDFContentStreamBytecode(const PDFContentStreamBytecode&) = delete;
+    inline PDFContentStreamBytecode(PDFContentStreamBytecode&&) = delete;
+    inline PDFContentStreamBytecode& operator=(const PDFContentStreamBytecode&) = delete;
+    inline PDFContentStreamBytecode& operator=(PDFContentStreamBytecode&&) = delete;
+
+    using Operator = PDFPageContentProcessor::Operator;
+    using Operand = PDFPageContentProcessor::Operand;
+
+    enum class InstructionType : uint8_t
+    {
+        Operator,       ///< Push operands and invoke operator
+        Operands,       ///< Push operands only (operands at the end of content stream)
+        InlineImage,    ///< Paint inline image
+        Error           ///< Report error, which occured during translation
+    };
+
+    struct Instruction
+    {
+        InstructionType type = InstructionType::Operator;
+        Operator op = Operator::Invalid;
+        uint32_t operandIndex = 0;  ///< Index of the first operand
+        uint32_t operandCount = 0;  ///< Number of operands
+        uint32_t dataIndex = 0;     ///< Index of operator name, inline image, or error message
+    };
+
+    const std::vector<Instruction>& getInstructions() const { return m_instructions; }
+
+    /// Returns operands of the instruction
+    /// \param instruction Instruction
+    const Operand* getOperands(const Instruction& instruction) const { return m_operands.data() + instruction.operandIndex; }
+
+    const QByteArray& getString(uint32_t index) const { return m_strings[index]; }
+    const PDFStream* getInlineImage(uint32_t index) const { return &m_inlineImages[index]; }
+    const QString& getError(uint32_t index) const { return m_errors[index]; }
+
+    /// Returns memory consumption estimate in bytes
+    qint64 getMemoryConsumptionEstimate() const;
+
+private:
+    class Translator;
+
+    std::vector<Instruction> m_instructions;
+    std::vector<Operand> m_operands;
+    std::deque<QByteArray> m_strings; ///< Deque, so operands can refer to the strings
+    std::vector<PDFStream> m_inlineImages;
+    std::vector<QString> m_errors;
+};
+
+using PDFContentStreamBytecodePointer = QSharedPointer<const PDFContentStreamBytecode>;
+
+/// Cache of translated content streams. Content streams are identified by the stream
+/// object, cache holds the stream object, so it can't be destroyed, while it is in the cache.
+/// Least recently used bytecodes are removed from the cache, when cache limit is exceeded.
+/// Cache is thread safe, so it can be shared between multiple compiling / rendering threads.
+class PDF4QTLIBCORESHARED_EXPORT PDFContentStreamBytecodeCache
+{
+public:
+    /// Constructs bytecode cache
+    /// \param cacheLimit Cache limit [bytes]
+    explicit PDFContentStreamBytecodeCache(qint64 cacheLimit);
+
+    /// Sets the document to the cache. Whole cache is cleared,
+    /// if it is needed.
+    /// \param document Document to be setted
+    void setDocument(const PDFModifiedDocument& document);
+
+    /// Returns bytecode of the content stream. If bytecode is not found in the cache,
+    /// then content stream is translated and bytecode is inserted into the cache. If content
+    /// stream can't be decoded, then exception is thrown.
+    /// \param document Document
+    /// \param streamObject Content stream object
+    PDFContentStreamBytecodePointer getBytecode(const PDFDocument* document, const PDFObject& streamObject) const;
+
+    /// Sets cache limit in bytes
+    /// \param cacheLimit Cache limit [bytes]
+    void setCacheLimit(qint64 cacheLimit);
+
+    /// Clears the cache
+    void clear();
+
+private:
+    struct CacheItem
+    {
+        PDFObject streamObject;
+        PDFContentStreamBytecodePointer bytecode;
+    };
+
+    mutable QMutex m_mutex;
+    const PDFDocument* m_document;
+    mutable QCache<const PDFStream*, CacheItem> m_cache;
+};
+
+}   // namespace pdf
+
+#endif // PDFCONTENTSTREAMBYTECODE_H
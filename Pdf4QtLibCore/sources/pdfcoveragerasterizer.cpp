@@ -0,0 +1,347 @@
+//    Copyright (C) 2024 Jakub Melka
+//
+//    This file is part of PDF4QT.
+//
+//    PDF4QT is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    with the written consent of the copyright owner, any later version.
+//
+//    PDF4QT is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public License
+//    along with PDF4QT.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "pdfcoveragerasterizer.h"
+#include "pdfdbgheap.h"
+
+#include <array>
+#include <cmath>
+#include <algorithm>
+
+namespace pdf
+{
+
+/// Coverage values smaller than this value are considered as zero
+/// (numerical noise of the accumulation), values close to 1.0 are
+/// considered as full coverage.
+static constexpr PDFReal COVERAGE_EPSILON = 1.0e-5;
+
+PDFCoverageRasterizer::PDFCoverageRasterizer(QRect clipRect) :
+    m_clipRect(clipRect)
+{
+
+}
+
+void PDFCoverageRasterizer::addPath(const QPainterPath& path)
+{
+    for (const QPolygonF& polygon : path.toSubpathPolygons())
+    {
+        addPolygon(polygon);
+    }
+}
+
+void PDFCoverageRasterizer::addPolygon(const QPolygonF& polygon)
+{
+    if (polygon.size() < 2)
+    {
+        return;
+    }
+
+    for (int i = 1; i < polygon.size(); ++i)
+    {
+        addLine(polygon[i - 1], polygon[i]);
+    }
+
+    if (polygon.front() != polygon.back())
+    {
+        addLine(polygon.back(), polygon.front());
+    }
+}
+
+void PDFCoverageRasterizer::addLine(QPointF p1, QPointF p2)
+{
+    if (!m_clipRect.isValid())
+    {
+        return;
+    }
+
+    const PDFReal x1 = p1.x();
+    const PDFReal y1 = p1.y();
+    const PDFReal x2 = p2.x();
+    const PDFReal y2 = p2.y();
+
+    if (y1 == y2 || !std::isfinite(x1) || !std::isfinite(y1) || !std::isfinite(x2) || !std::isfinite(y2))
+    {
+        // Horizontal lines do not contribute to the coverage
+        return;
+    }
+
+    const PDFReal left = m_clipRect.left();
+    const PDFReal right = m_clipRect.right() + 1.0;
+    const PDFReal top = m_clipRect.top();
+    const PDFReal bottom = m_clipRect.bottom() + 1.0;
+    const PDFReal dx = x2 - x1;
+    const PDFReal dy = y2 - y1;
+
+    // Parts of the line above and below the clip rectangle do not affect
+    // coverage of any pixel in the clip rectangle, so they are removed.
+    PDFReal tTop = (top - y1) / dy;
+    PDFReal tBottom = (bottom - y1) / dy;
+    if (tTop > tBottom)
+    {
+        std::swap(tTop, tBottom);
+    }
+
+    const PDFReal tStart = qMax(tTop, 0.0);
+    const PDFReal tEnd = qMin(tBottom, 1.0);
+    if (tStart >= tEnd)
+    {
+        return;
+    }
+
+    // Parts of the line left (right) of the clip rectangle are projected onto its
+    // left (right) boundary. Projected line has the same winding contribution
+    // to the pixels right of it, so the coverage of the pixels is preserved.
+    std::array<PDFReal, 4> splitPoints = { tStart, tEnd, tEnd, tEnd };
+    size_t splitPointCount = 2;
+    if (dx != 0.0)
+    {
+        for (const PDFReal boundary : { left, right })
+        {
+            const PDFReal t = (boundary - x1) / dx;
+            if (t > tStart && t < tEnd)
+            {
+                splitPoints[splitPointCount++] = t;
+            }
+        }
+    }
+    std::sort(splitPoints.begin(), std::next(splitPoints.begin(), splitPointCount));
+
+    auto getPoint = [&](PDFReal t)
+    {
+        return QPointF(qBound(left, x1 + t * dx, right), qBound(top, y1 + t * dy, bottom));
+    };
+
+    QPointF lastPoint = getPoint(splitPoints[0]);
+    for (size_t i = 1; i < splitPointCount; ++i)
+    {
+        const QPointF point = getPoint(splitPoints[i]);
+        addClippedLine(lastPoint.x(), lastPoint.y(), point.x(), point.y());
+        lastPoint = point;
+    }
+}
+
+void PDFCoverageRasterizer::addClippedLine(PDFReal x1, PDFReal y1, PDFReal x2, PDFReal y2)
+{
+    if (y1 == y2)
+    {
+        return;
+    }
+
+    PDFReal direction = 1.0;
+    if (y1 > y2)
+    {
+        std::swap(x1, x2);
+        std::swap(y1, y2);
+        direction = -1.0;
+    }
+
+    // Split the line into the rows of pixels. Crossings of the rows are clamped
+    // to the x-range of the line, so rounding can't move them out of the clip rectangle.
+    const PDFReal dxdy = (x2 - x1) / (y2 - y1);
+    const PDFReal xMin = qMin(x1, x2);
+    const PDFReal xMax = qMax(x1, x2);
+    int row = static_cast<int>(std::floor(y1));
+    PDFReal xa = x1;
+    PDFReal ya = y1;
+
+    while (true)
+    {
+        const PDFReal yb = row + 1.0;
+        if (y2 <= yb)
+        {
+            addRowLine(row, xa, ya, x2, y2, direction);
+            break;
+        }
+
+        const PDFReal xb = qBound(xMin, x1 + (yb - y1) * dxdy, xMax);
+        addRowLine(row, xa, ya, xb, yb, direction);
+        xa = xb;
+        ya = yb;
+        ++row;
+    }
+}
+
+void PDFCoverageRasterizer::addRowLine(int row, PDFReal x1, PDFReal y1, PDFReal x2, PDFReal y2, PDFReal direction)
+{
+    if (y1 >= y2)
+    {
+        return;
+    }
+
+    if (x1 == x2)
+    {
+        const int cellX = static_cast<int>(std::floor(x1));
+        addCell(cellX, row, x1 - cellX, x1 - cellX, (y2 - y1) * direction);
+        return;
+    }
+
+    // Split the line into the cells of the row
+    const PDFReal dydx = (y2 - y1) / (x2 - x1);
+    PDFReal xa = x1;
+    PDFReal ya = y1;
+
+    if (x1 < x2)
+    {
+        int cellX = static_cast<int>(std::floor(x1));
+        while (true)
+        {
+            const PDFReal xb = cellX + 1.0;
+            if (x2 <= xb)
+            {
+                addCell(cellX, row, xa - cellX, x2 - cellX, (y2 - ya) * direction);
+                break;
+            }
+
+            const PDFReal yb = y1 + (xb - x1) * dydx;
+            addCell(cellX, row, xa - cellX, 1.0, (yb - ya) * direction);
+            xa = xb;
+            ya = yb;
+            ++cellX;
+        }
+    }
+    else
+    {
+        int cellX = static_cast<int>(std::ceil(x1)) - 1;
+        while (true)
+        {
+            const PDFReal xb = cellX;
+            if (x2 >= xb)
+            {
+                addCell(cellX, row, xa - cellX, x2 - cellX, (y2 - ya) * direction);
+                break;
+            }
+
+            const PDFReal yb = y1 + (xb - x1) * dydx;
+            addCell(cellX, row, xa - cellX, 0.0, (yb - ya) * direction);
+            xa = xb;
+            ya = yb;
+            --cellX;
+        }
+    }
+}
+
+void PDFCoverageRasterizer::addCell(int x, int y, PDFReal fx1, PDFReal fx2, PDFReal dy)
+{
+    if (x < m_clipRect.left())
+    {
+        // Numerical error can move the cell just left of the clip rectangle. Line
+        // left of the clip rectangle is equivalent to the line on its left boundary.
+        x = m_clipRect.left();
+        fx1 = 0.0;
+        fx2 = 0.0;
+    }
+
+    if (x > m_clipRect.right() || y > m_clipRect.bottom() || dy == 0.0)
+    {
+        // Cell lies on the right boundary of the clip rectangle, it doesn't
+        // affect coverage of the pixels in the clip rectangle.
+        return;
+    }
+
+    // Cover is signed height of the line in the cell, area is the part of the cover,
+    // which lies right of the line in the cell (it belongs to the following pixels).
+    m_cells.push_back(Cell{ y, x, dy, dy * (fx1 + fx2) * 0.5 });
+}
+
+std::vector<PDFCoverageRasterizer::Span> PDFCoverageRasterizer::createSpans(Qt::FillRule fillRule) const
+{
+    std::vector<Span> spans;
+
+    std::vector<Cell> cells = m_cells;
+    std::sort(cells.begin(), cells.end());
+
+    auto getCoverage = [fillRule](PDFReal winding)
+    {
+        PDFReal coverage = qAbs(winding);
+        if (fillRule == Qt::OddEvenFill)
+        {
+            coverage = std::fmod(coverage, 2.0);
+            if (coverage > 1.0)
+            {
+                coverage = 2.0 - coverage;
+            }
+        }
+
+        return qMin(coverage, 1.0);
+    };
+
+    auto addSpan = [&spans](int x, int y, int length, PDFReal coverage)
+    {
+        if (coverage < COVERAGE_EPSILON)
+        {
+            return;
+        }
+
+        const PDFColorComponent spanCoverage = (coverage > 1.0 - COVERAGE_EPSILON) ? 1.0f : PDFColorComponent(coverage);
+
+        if (!spans.empty())
+        {
+            Span& lastSpan = spans.back();
+            if (lastSpan.y == y && lastSpan.x + lastSpan.length == x && lastSpan.coverage == spanCoverage)
+            {
+                lastSpan.length += length;
+                return;
+            }
+        }
+
+        spans.push_back(Span{ x, y, length, spanCoverage });
+    };
+
+    auto it = cells.cbegin();
+    auto itEnd = cells.cend();
+    while (it != itEnd)
+    {
+        const int y = it->y;
+        int nextX = it->x;
+        PDFReal cover = 0.0;
+
+        while (it != itEnd && it->y == y)
+        {
+            const int x = it->x;
+
+            PDFReal cellCover = 0.0;
+            PDFReal cellArea = 0.0;
+            for (; it != itEnd && it->y == y && it->x == x; ++it)
+            {
+                cellCover += it->cover;
+                cellArea += it->area;
+            }
+
+            // Pixels between cells have coverage given by the accumulated cover
+            if (nextX < x)
+            {
+                addSpan(nextX, y, x - nextX, getCoverage(cover));
+            }
+
+            addSpan(x, y, 1, getCoverage(cover + cellCover - cellArea));
+            cover += cellCover;
+            nextX = x + 1;
+        }
+
+        // Edges right of the clip rectangle were projected onto its right
+        // boundary, so the cover can be nonzero up to the end of the row.
+        if (nextX <= m_clipRect.right())
+        {
+            addSpan(nextX, y, m_clipRect.right() + 1 - nextX, getCoverage(cover));
+        }
+    }
+
+    return spans;
+}
+
+}   // namespace pdf
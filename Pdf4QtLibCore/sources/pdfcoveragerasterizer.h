@@ -0,0 +1,103 @@
+//    Copyright (C) 2024 Jakub Melka
+//
+//    This file is part of PDF4QT.
+//
+//    PDF4QT is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    with the written consent of the copyright owner, any later version.
+//
+//    PDF4QT is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public License
+//    along with PDF4QT.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef PDFCOVERAGERASTERIZER_H
+#define PDFCOVERAGERASTERIZER_H
+
+#include "pdfglobal.h"
+
+#include <QRect>
+#include <QPainterPath>
+
+#include <vector>
+
+namespace pdf
+{
+
+/// Rasterizer computing exact area coverage of the pixels by the path.
+/// Path is flattened into line segments, each segment accumulates signed
+/// cover and area into the cells (pixels) it crosses. Only cells crossed by
+/// some segment are stored, pixels between cells have constant coverage, so the
+/// result is a list of spans and the cost is proportional to the number of edges
+/// and spans, not to the number of pixels.
+class PDF4QTLIBCORESHARED_EXPORT PDFCoverageRasterizer
+{
+public:
+    /// Creates rasterizer, which rasterizes paths into the clip rectangle.
+    /// Pixel (x, y) represents area [x, x + 1) x [y, y + 1).
+    /// \param clipRect Clip rectangle in pixels
+    explicit PDFCoverageRasterizer(QRect clipRect);
+
+    /// Horizontal run of pixels with the same coverage
+    struct Span
+    {
+        int x = 0;
+        int y = 0;
+        int length = 0;
+        PDFColorComponent coverage = 0.0f;
+    };
+
+    /// Adds path to the rasterizer. Curves are flattened, open subpaths
+    /// are implicitly closed.
+    /// \param path Path
+    void addPath(const QPainterPath& path);
+
+    /// Adds polygon to the rasterizer. Polygon is implicitly closed.
+    /// \param polygon Polygon
+    void addPolygon(const QPolygonF& polygon);
+
+    /// Adds oriented line segment to the rasterizer
+    /// \param p1 Start point
+    /// \param p2 End point
+    void addLine(QPointF p1, QPointF p2);
+
+    /// Creates spans with nonzero coverage. Spans are ordered by rows
+    /// and by horizontal coordinate in each row and do not overlap.
+    /// \param fillRule Fill rule
+    std::vector<Span> createSpans(Qt::FillRule fillRule) const;
+
+    /// Removes all added edges
+    void clear() { m_cells.clear(); }
+
+private:
+    struct Cell
+    {
+        int y = 0;
+        int x = 0;
+        PDFReal cover = 0.0;
+        PDFReal area = 0.0;
+
+        bool operator<(const Cell& other) const { return std::pair(y, x) < std::pair(other.y, other.x); }
+    };
+
+    /// Adds line segment, which is clipped to the clip rectangle
+    void addClippedLine(PDFReal x1, PDFReal y1, PDFReal x2, PDFReal y2);
+
+    /// Adds line segment lying in one row of pixels. Segment must be oriented
+    /// downwards (y1 <= y2), \p direction is winding direction.
+    void addRowLine(int row, PDFReal x1, PDFReal y1, PDFReal x2, PDFReal y2, PDFReal direction);
+
+    /// Adds cover and area to the cell
+    void addCell(int x, int y, PDFReal fx1, PDFReal fx2, PDFReal dy);
+
+    QRect m_clipRect;
+    std::vector<Cell> m_cells;
+};
+
+}   // namespace pdf
+
+#endif // PDFCOVERAGERASTERIZER_H
@@ -33,6 +33,11 @@ QByteArray PDFObjectStorage::getDecodedStream(const PDFStream* stream) const
     return PDFStreamFilterStorage::getDecodedStream(stream, std::bind(QOverload<const PDFObject&>::of(&PDFObjectStorage::getObject), this, std::placeholders::_1), getSecurityHandler());
 }
 
+PDFStreamFilterSourcePointer PDFObjectStorage::createDecodedStreamSource(const PDFStream* stream) const
+{
+    return PDFStreamFilterStorage::createDecodedStreamSource(stream, std::bind(QOverload<const PDFObject&>::of(&PDFObjectStorage::getObject), this, std::placeholders::_1), getSecurityHandler());
+}
+
 PDFDocument::~PDFDocument()
 {
 
@@ -69,6 +74,11 @@ QByteArray PDFDocument::getDecodedStream(const PDFStream* stream) const
     return m_pdfObjectStorage.getDecodedStream(stream);
 }
 
+PDFStreamFilterSourcePointer PDFDocument::createDecodedStreamSource(const PDFStream* stream) const
+{
+    return m_pdfObjectStorage.createDecodedStreamSource(stream);
+}
+
 const PDFDictionary* PDFDocument::getTrailerDictionary() const
 {
     const PDFObject& trailerDictionary = m_pdfObjectStorage.getTrailerDictionary();
@@ -125,8 +135,42 @@ void PDFDocument::initInfo()
 bool PDFObjectStorage::operator==(const PDFObjectStorage& other) const
 {
     // We compare just content. Security handler just defines encryption behavior.
-    return m_objects == other.m_objects &&
-           m_trailerDictionary == other.m_trailerDictionary;
+    if (!m_objectLoader && !other.m_objectLoader)
+    {
+        return m_objects == other.m_objects &&
+               m_trailerDictionary == other.m_trailerDictionary;
+    }
+
+    if (m_objects.size() != other.m_objects.size() ||
+        m_trailerDictionary != other.m_trailerDictionary)
+    {
+        return false;
+    }
+
+    for (size_t i = 0; i < m_objects.size(); ++i)
+    {
+        const Entry& entry = m_objects[i];
+        const Entry& otherEntry = other.m_objects[i];
+
+        if (entry.generation != otherEntry.generation)
+        {
+            return false;
+        }
+
+        // Objects, which are not loaded by the same loader, are equal
+        if (!entry.isLoaded() && !otherEntry.isLoaded() && m_objectLoader == other.m_objectLoader)
+        {
+            continue;
+        }
+
+        PDFObjectReference reference(PDFInteger(i), entry.generation);
+        if (getObject(reference) != other.getObject(reference))
+        {
+            return false;
+        }
+    }
+
+    return true;
 }
 
 const PDFObject& PDFObjectStorage::getObject(PDFObjectReference reference) const
@@ -135,7 +179,13 @@ const PDFObject& PDFObjectStorage::getObject(PDFObjectReference reference) const
         reference.objectNumber < static_cast<PDFInteger>(m_objects.size()) &&
         m_objects[reference.objectNumber].generation == reference.generation)
     {
-        return m_objects[reference.objectNumber].object;
+        const Entry& entry = m_objects[reference.objectNumber];
+        if (!entry.isLoaded())
+        {
+            loadObject(reference);
+        }
+
+        return entry.object;
     }
     else
     {
@@ -161,6 +211,123 @@ void PDFObjectStorage::updateTrailerDictionary(PDFObject trailerDictionary)
     m_trailerDictionary = PDFObjectManipulator::merge(m_trailerDictionary, trailerDictionary, PDFObjectManipulator::RemoveNullObjects);
 }
 
+void PDFObjectStorage::loadAllObjects() const
+{
+    if (!m_objectLoader)
+    {
+        return;
+    }
+
+    for (size_t i = 0; i < m_objects.size(); ++i)
+    {
+        const Entry& entry = m_objects[i];
+        if (!entry.isLoaded())
+        {
+            loadObject(PDFObjectReference(PDFInteger(i), entry.generation));
+        }
+    }
+}
+
+PDFInteger PDFObjectStorage::getObjectGeneration(PDFInteger objectNumber) const
+{
+    if (objectNumber >= 0 && objectNumber < static_cast<PDFInteger>(m_objects.size()))
+    {
+        return m_objects[objectNumber].generation;
+    }
+
+    return -1;
+}
+
+bool PDFObjectStorage::isSameObject(const PDFObjectStorage& other, PDFInteger objectNumber) const
+{
+    const PDFInteger generation = getObjectGeneration(objectNumber);
+    if (generation != other.getObjectGeneration(objectNumber))
+    {
+        return false;
+    }
+
+    if (generation == -1)
+    {
+        // Object doesn't exist in both storages
+        return true;
+    }
+
+    const Entry& entry = m_objects[objectNumber];
+    const Entry& otherEntry = other.m_objects[objectNumber];
+    const bool isLoaded = entry.isLoaded();
+    const bool isOtherLoaded = otherEntry.isLoaded();
+    if (isLoaded && isOtherLoaded)
+    {
+        // Unchanged objects share their content, so they are usually
+        // identical and deep comparison is performed only for changed ones.
+        return entry.object == otherEntry.object;
+    }
+
+    if (!isLoaded && !isOtherLoaded && m_objectLoader && m_objectLoader == other.m_objectLoader)
+    {
+        // Both objects will be loaded from the same data
+        return true;
+    }
+
+    PDFObjectReference reference(objectNumber, generation);
+    return getObject(reference) == other.getObject(reference);
+}
+
+QStringList PDFObjectStorage::takeObjectLoadingErrors() const
+{
+    if (!m_objectLoader)
+    {
+        return QStringList();
+    }
+
+    QMutexLocker lock(m_objectLoader->getMutex());
+    return m_objectLoader->takeErrors();
+}
+
+void PDFObjectStorage::loadObject(PDFObjectReference reference) const
+{
+    Q_ASSERT(m_objectLoader);
+
+    QMutexLocker lock(m_objectLoader->getMutex());
+    Entry& entry = m_objects[reference.objectNumber];
+
+    // Object can be loaded by another thread, while we were waiting for the mutex.
+    // If object is requested during its own loading (cyclic reference), then
+    // null object is returned now, but entry remains not loaded, so the object
+    // will be stored, when its loading finishes.
+    if (!entry.isLoaded() && !m_objectLoader->isLoading(reference))
+    {
+        entry.object = m_objectLoader->load(reference, this);
+        entry.loaded.store(true, std::memory_order_release);
+    }
+}
+
+PDFObject PDFObjectStorageLoader::load(PDFObjectReference reference, const PDFObjectStorage* storage)
+{
+    PDFObject object;
+    m_loadingObjects.insert(reference);
+
+    try
+    {
+        object = loadObject(reference, storage);
+    }
+    catch (const PDFException& exception)
+    {
+        m_errors << PDFTranslationContext::tr("Object %1 %2 R can't be loaded: %3").arg(reference.objectNumber).arg(reference.generation).arg(exception.getMessage());
+        object = PDFObject();
+    }
+
+    m_loadingObjects.erase(reference);
+    return object;
+}
+
+QStringList PDFObjectStorageLoader::takeErrors()
+{
+    QStringList errors;
+    std::swap(errors, m_errors);
+    return errors;
+}
+
 PDFDocumentDataLoaderDecorator::PDFDocumentDataLoaderDecorator(const PDFDocument* document)
     : m_storage(&document->getStorage())
 {
@@ -276,7 +443,7 @@ QRectF PDFDocumentDataLoaderDecorator::readRectangle(const PDFObject& object, co
     return defaultValue;
 }
 
-QTransform PDFDocumentDataLoaderDecorator::readMatrixFromDictionary(const PDFDictionary* dictionary, const char* key, QTransform defaultValue) const
+QTransform PDFDocumentDataLoaderDecorator::readMatrixFromDictionary(const PDFDictionary* dictionary, PDFNameAtom key, QTransform defaultValue) const
 {
     if (dictionary->hasKey(key))
     {
@@ -293,7 +460,7 @@ QTransform PDFDocumentDataLoaderDecorator::readMatrixFromDictionary(const PDFDic
 }
 
 std::vector<PDFReal> PDFDocumentDataLoaderDecorator::readNumberArrayFromDictionary(const PDFDictionary* dictionary,
-                                                                                   const char* key,
+                                                                                   PDFNameAtom key,
                                                                                    std::vector<PDFReal> defaultValue) const
 {
     if (dictionary->hasKey(key))
@@ -304,7 +471,7 @@ std::vector<PDFReal> PDFDocumentDataLoaderDecorator::readNumberArrayFromDictiona
     return defaultValue;
 }
 
-std::vector<PDFInteger> PDFDocumentDataLoaderDecorator::readIntegerArrayFromDictionary(const PDFDictionary* dictionary, const char* key) const
+std::vector<PDFInteger> PDFDocumentDataLoaderDecorator::readIntegerArrayFromDictionary(const PDFDictionary* dictionary, PDFNameAtom key) const
 {
     if (dictionary->hasKey(key))
     {
@@ -314,17 +481,7 @@ std::vector<PDFInteger> PDFDocumentDataLoaderDecorator::readIntegerArrayFromDict
     return std::vector<PDFInteger>();
 }
 
-PDFReal PDFDocumentDataLoaderDecorator::readNumberFromDictionary(const PDFDictionary* dictionary, const char* key, PDFReal defaultValue) const
-{
-    if (dictionary->hasKey(key))
-    {
-        return readNumber(dictionary->get(key), defaultValue);
-    }
-
-    return defaultValue;
-}
-
-PDFReal PDFDocumentDataLoaderDecorator::readNumberFromDictionary(const PDFDictionary* dictionary, const QByteArray& key, PDFReal defaultValue) const
+PDFReal PDFDocumentDataLoaderDecorator::readNumberFromDictionary(const PDFDictionary* dictionary, PDFNameAtom key, PDFReal defaultValue) const
 {
     if (dictionary->hasKey(key))
     {
@@ -334,7 +491,7 @@ PDFReal PDFDocumentDataLoaderDecorator::readNumberFromDictionary(const PDFDictio
     return defaultValue;
 }
 
-PDFInteger PDFDocumentDataLoaderDecorator::readIntegerFromDictionary(const PDFDictionary* dictionary, const char* key, PDFInteger defaultValue) const
+PDFInteger PDFDocumentDataLoaderDecorator::readIntegerFromDictionary(const PDFDictionary* dictionary, PDFNameAtom key, PDFInteger defaultValue) const
 {
     if (dictionary->hasKey(key))
     {
@@ -344,7 +501,7 @@ PDFInteger PDFDocumentDataLoaderDecorator::readIntegerFromDictionary(const PDFDi
     return defaultValue;
 }
 
-QString PDFDocumentDataLoaderDecorator::readTextStringFromDictionary(const PDFDictionary* dictionary, const char* key, const QString& defaultValue) const
+QString PDFDocumentDataLoaderDecorator::readTextStringFromDictionary(const PDFDictionary* dictionary, PDFNameAtom key, const QString& defaultValue) const
 {
     if (dictionary->hasKey(key))
     {
@@ -354,7 +511,7 @@ QString PDFDocumentDataLoaderDecorator::readTextStringFromDictionary(const PDFDi
     return defaultValue;
 }
 
-std::vector<PDFObjectReference> PDFDocumentDataLoaderDecorator::readReferenceArrayFromDictionary(const PDFDictionary* dictionary, const char* key) const
+std::vector<PDFObjectReference> PDFDocumentDataLoaderDecorator::readReferenceArrayFromDictionary(const PDFDictionary* dictionary, PDFNameAtom key) const
 {
     if (dictionary->hasKey(key))
     {
@@ -431,7 +588,7 @@ PDFObjectReference PDFDocumentDataLoaderDecorator::readReference(const PDFObject
     return PDFObjectReference();
 }
 
-PDFObjectReference PDFDocumentDataLoaderDecorator::readReferenceFromDictionary(const PDFDictionary* dictionary, const char* key) const
+PDFObjectReference PDFDocumentDataLoaderDecorator::readReferenceFromDictionary(const PDFDictionary* dictionary, PDFNameAtom key) const
 {
     const PDFObject& object = dictionary->get(key);
 
@@ -505,7 +662,7 @@ std::vector<QByteArray> PDFDocumentDataLoaderDecorator::readNameArray(const PDFO
     return std::vector<QByteArray>();
 }
 
-std::vector<QByteArray> PDFDocumentDataLoaderDecorator::readNameArrayFromDictionary(const PDFDictionary* dictionary, const char* key) const
+std::vector<QByteArray> PDFDocumentDataLoaderDecorator::readNameArrayFromDictionary(const PDFDictionary* dictionary, PDFNameAtom key) const
 {
     if (dictionary->hasKey(key))
     {
@@ -515,7 +672,7 @@ std::vector<QByteArray> PDFDocumentDataLoaderDecorator::readNameArrayFromDiction
     return std::vector<QByteArray>();
 }
 
-bool PDFDocumentDataLoaderDecorator::readBooleanFromDictionary(const PDFDictionary* dictionary, const char* key, bool defaultValue) const
+bool PDFDocumentDataLoaderDecorator::readBooleanFromDictionary(const PDFDictionary* dictionary, PDFNameAtom key, bool defaultValue) const
 {
     if (dictionary->hasKey(key))
     {
@@ -525,7 +682,7 @@ bool PDFDocumentDataLoaderDecorator::readBooleanFromDictionary(const PDFDictiona
     return defaultValue;
 }
 
-QByteArray PDFDocumentDataLoaderDecorator::readNameFromDictionary(const PDFDictionary* dictionary, const char* key) const
+QByteArray PDFDocumentDataLoaderDecorator::readNameFromDictionary(const PDFDictionary* dictionary, PDFNameAtom key) const
 {
     if (dictionary->hasKey(key))
     {
@@ -535,7 +692,7 @@ QByteArray PDFDocumentDataLoaderDecorator::readNameFromDictionary(const PDFDicti
     return QByteArray();
 }
 
-QByteArray PDFDocumentDataLoaderDecorator::readStringFromDictionary(const PDFDictionary* dictionary, const char* key) const
+QByteArray PDFDocumentDataLoaderDecorator::readStringFromDictionary(const PDFDictionary* dictionary, PDFNameAtom key) const
 {
     if (dictionary->hasKey(key))
     {
@@ -545,7 +702,7 @@ QByteArray PDFDocumentDataLoaderDecorator::readStringFromDictionary(const PDFDic
     return QByteArray();
 }
 
-std::vector<QByteArray> PDFDocumentDataLoaderDecorator::readStringArrayFromDictionary(const PDFDictionary* dictionary, const char* key) const
+std::vector<QByteArray> PDFDocumentDataLoaderDecorator::readStringArrayFromDictionary(const PDFDictionary* dictionary, PDFNameAtom key) const
 {
     if (dictionary->hasKey(key))
     {
@@ -575,7 +732,7 @@ QStringList PDFDocumentDataLoaderDecorator::readTextStringList(const PDFObject&
     return result;
 }
 
-QColor PDFDocumentDataLoaderDecorator::readRGBColorFromDictionary(const PDFDictionary* dictionary, const char* key, QColor defaultColor)
+QColor PDFDocumentDataLoaderDecorator::readRGBColorFromDictionary(const PDFDictionary* dictionary, PDFNameAtom key, QColor defaultColor)
 {
     std::vector<PDFReal> colors = readNumberArrayFromDictionary(dictionary, key);
 
@@ -590,7 +747,7 @@ QColor PDFDocumentDataLoaderDecorator::readRGBColorFromDictionary(const PDFDicti
     return defaultColor;
 }
 
-std::optional<QByteArray> PDFDocumentDataLoaderDecorator::readOptionalStringFromDictionary(const PDFDictionary* dictionary, const char* key) const
+std::optional<QByteArray> PDFDocumentDataLoaderDecorator::readOptionalStringFromDictionary(const PDFDictionary* dictionary, PDFNameAtom key) const
 {
     if (dictionary->hasKey(key))
     {
@@ -599,7 +756,7 @@ std::optional<QByteArray> PDFDocumentDataLoaderDecorator::readOptionalStringFrom
     return std::nullopt;
 }
 
-std::optional<PDFInteger> PDFDocumentDataLoaderDecorator::readOptionalIntegerFromDictionary(const PDFDictionary* dictionary, const char* key) const
+std::optional<PDFInteger> PDFDocumentDataLoaderDecorator::readOptionalIntegerFromDictionary(const PDFDictionary* dictionary, PDFNameAtom key) const
 {
     if (dictionary->hasKey(key))
     {
@@ -22,20 +22,76 @@
 #include "pdfobject.h"
 #include "pdfcatalog.h"
 #include "pdfsecurityhandler.h"
+#include "pdfstreamfilters.h"
 
 #include <QColor>
 #include <QTransform>
 #include <QDateTime>
+#include <QRecursiveMutex>
 
+#include <set>
+#include <atomic>
 #include <optional>
 
 namespace pdf
 {
 class PDFDocument;
 class PDFDocumentBuilder;
+class PDFObjectStorage;
+
+/// Loader of objects, which are loaded on demand (on first access) into the object
+/// storage. Storage serializes loading of objects by the loader's mutex (which is recursive,
+/// because loading of one object can require loading of another object, for example,
+/// stream length). Loader is shared between all copies of the object storage.
+class PDF4QTLIBCORESHARED_EXPORT PDFObjectStorageLoader
+{
+public:
+    explicit inline PDFObjectStorageLoader() = default;
+    virtual ~PDFObjectStorageLoader() = default;
+
+    /// Loads object with given reference. Must be called with locked loader's
+    /// mutex. Function doesn't throw exceptions, if object can't be loaded,
+    /// then error is recorded and null object is returned.
+    /// \param reference Reference of object to be loaded
+    /// \param storage Storage, for which object is being loaded
+    PDFObject load(PDFObjectReference reference, const PDFObjectStorage* storage);
+
+    /// Returns true, if object with given reference is being loaded, i.e. it
+    /// is requested again during its own loading (cyclic reference).
+    /// Must be called with locked loader's mutex.
+    /// \param reference Reference of object
+    bool isLoading(PDFObjectReference reference) const { return m_loadingObjects.count(reference); }
+
+    /// Returns errors of objects, which failed to load since the last call
+    /// of this function, and clears them.
+    QStringList takeErrors();
+
+    /// Returns mutex used for serialization of object loading
+    QRecursiveMutex* getMutex() { return &m_mutex; }
+
+protected:
+    /// Loads object with given reference. This function is called with locked
+    /// loader's mutex. If object can't be loaded, then exception is thrown.
+    /// \param reference Reference of object to be loaded
+    /// \param storage Storage, for which object is being loaded
+    virtual PDFObject loadObject(PDFObjectReference reference, const PDFObjectStorage* storage) = 0;
+
+private:
+    QRecursiveMutex m_mutex;
+
+    /// Objects, which are currently being loaded (to detect cyclic references)
+    std::set<PDFObjectReference> m_loadingObjects;
+
+    /// Errors of objects, which failed to load
+    QStringList m_errors;
+};
+
+using PDFObjectStorageLoaderPointer = std::shared_ptr<PDFObjectStorageLoader>;
 
 /// Storage for objects. This class is not thread safe for writing (calling non-const functions). Caller must ensure
 /// locking, if this object is used from multiple threads. Calling const functions should be thread safe.
+/// Storage can have an object loader. In that case, some objects are not loaded, until
+/// they are accessed for the first time (loading is thread safe).
 class PDF4QTLIBCORESHARED_EXPORT PDFObjectStorage
 {
 public:
@@ -55,11 +111,26 @@ public:
         constexpr inline explicit Entry() = default;
         inline explicit Entry(PDFInteger generation, PDFObject object) : generation(generation), object(std::move(object)) { }
 
-        inline bool operator==(const Entry& other) const { return generation == other.generation && object == other.object; }
+        inline Entry(const Entry& other) : generation(other.generation), loaded(other.isLoaded()) { if (loaded) { object = other.object; } }
+        inline Entry(Entry&& other) noexcept : generation(other.generation), loaded(other.isLoaded()) { if (loaded) { object = std::move(other.object); } }
+
+        inline Entry& operator=(const Entry& other);
+        inline Entry& operator=(Entry&& other) noexcept;
+
+        inline bool operator==(const Entry& other) const { return generation == other.generation && isLoaded() == other.isLoaded() && object == other.object; }
         inline bool operator!=(const Entry& other) const { return !(*this == other); }
 
+        /// Returns true, if object of this entry is loaded. Entry, which is
+        /// not loaded, is loaded on demand by the storage's object loader.
+        inline bool isLoaded() const { return loaded.load(std::memory_order_acquire); }
+
+        /// Creates entry, whose object will be loaded on first access
+        /// \param generation Generation number of the object
+        static inline Entry createNotLoaded(PDFInteger generation) { Entry entry(generation, PDFObject()); entry.loaded = false; return entry; }
+
         PDFInteger generation = 0;
         PDFObject object;
+        std::atomic_bool loaded = true;
     };
 
     using PDFObjects = std::vector<Entry>;
@@ -72,6 +143,15 @@ public:
 
     }
 
+    explicit PDFObjectStorage(PDFObjects&& objects, PDFObject&& trailerDictionary, PDFSecurityHandlerPointer&& securityHandler, PDFObjectStorageLoaderPointer objectLoader) :
+        m_objects(std::move(objects)),
+        m_trailerDictionary(std::move(trailerDictionary)),
+        m_securityHandler(std::move(securityHandler)),
+        m_objectLoader(std::move(objectLoader))
+    {
+
+    }
+
     /// Returns object from the object storage. If invalid reference is passed,
     /// then null object is returned (no exception is thrown).
     const PDFObject& getObject(PDFObjectReference reference) const;
@@ -90,11 +170,13 @@ public:
     /// is returned (no exception is thrown).
     const PDFObject& getObjectByReference(PDFObjectReference reference) const;
 
-    /// Returns array of objects stored in this storage
-    const PDFObjects& getObjects() const { return m_objects; }
+    /// Returns array of objects stored in this storage. If storage
+    /// has object loader, then all objects are loaded first.
+    const PDFObjects& getObjects() const { loadAllObjects(); return m_objects; }
 
-    /// Returns array of objects stored in this storage
-    PDFObjects& getObjects() { return m_objects; }
+    /// Returns array of objects stored in this storage. If storage
+    /// has object loader, then all objects are loaded first.
+    PDFObjects& getObjects() { loadAllObjects(); return m_objects; }
 
     /// Sets array of objects
     void setObjects(PDFObjects&& objects) { m_objects = qMove(objects); }
@@ -130,21 +212,66 @@ public:
     /// \param stream Stream to be decoded
     QByteArray getDecodedStream(const PDFStream* stream) const;
 
+    /// Creates source of decoded stream data, data are decoded in chunks, as they
+    /// are read. Storage must exist, while source is being used. If stream filters
+    /// are invalid, then nullptr is returned.
+    /// \param stream Stream to be decoded
+    PDFStreamFilterSourcePointer createDecodedStreamSource(const PDFStream* stream) const;
+
     /// Set trailer dictionary
     /// \param object Object defining trailer dictionary
     void setTrailerDictionary(const PDFObject& object) { m_trailerDictionary = object; }
 
+    /// Returns true, if some objects are loaded on demand
+    bool hasObjectLoader() const { return m_objectLoader != nullptr; }
+
+    /// Loads all objects, which are not yet loaded. If storage
+    /// doesn't have object loader, nothing happens.
+    void loadAllObjects() const;
+
+    /// Returns errors of objects, which failed to load on demand since
+    /// the last call of this function, and clears them. If storage
+    /// doesn't have object loader, empty list is returned.
+    QStringList takeObjectLoadingErrors() const;
+
+    /// Returns number of object entries in the storage (objects are not loaded)
+    size_t getObjectCount() const { return m_objects.size(); }
+
+    /// Returns generation number of object with given object number. Object
+    /// is not loaded. If object number is invalid, -1 is returned.
+    /// \param objectNumber Object number
+    PDFInteger getObjectGeneration(PDFInteger objectNumber) const;
+
+    /// Returns true, if object with given object number is the same in this
+    /// storage and in the \p other storage. Generation numbers are compared first.
+    /// Objects, which are not loaded in both storages and are loaded by the same
+    /// object loader, are the same without loading them. Loaded objects sharing
+    /// the same content are the same without deep comparison. Otherwise objects
+    /// are loaded and compared.
+    /// \param other Other storage
+    /// \param objectNumber Object number
+    bool isSameObject(const PDFObjectStorage& other, PDFInteger objectNumber) const;
+
 private:
-    PDFObjects m_objects;
+    /// Loads object using the object loader. Object entry
+    /// must exist and must not be loaded.
+    /// \param reference Reference to object
+    void loadObject(PDFObjectReference reference) const;
+
+    /// Objects are mutable, because not loaded objects are
+    /// loaded on demand in const functions (thread safe).
+    mutable PDFObjects m_objects;
     PDFObject m_trailerDictionary;
     PDFSecurityHandlerPointer m_securityHandler;
+    PDFObjectStorageLoaderPointer m_objectLoader;
 };
 
 /// Loads data from the object contained in the PDF document, such as integers,
 /// bools, ... This object has two sets of functions - first one with default values,
 /// then if object with valid data is not found, default value is used, and second one,
 /// without default value, if valid data are not found, then exception is thrown.
-/// This class uses Decorator design pattern.
+/// This class uses Decorator design pattern. Dictionary keys are passed as name
+/// atoms, so hashes of string literal keys are computed at compile time.
 class PDF4QTLIBCORESHARED_EXPORT PDFDocumentDataLoaderDecorator
 {
 public:
@@ -246,7 +373,7 @@ public:
     /// \param first First iterator
     /// \param second Second iterator
     template<typename T>
-    void readNumberArrayFromDictionary(const PDFDictionary* dictionary, const char* key, T first, T last)
+    void readNumberArrayFromDictionary(const PDFDictionary* dictionary, PDFNameAtom key, T first, T last)
     {
         if (dictionary->hasKey(key))
         {
@@ -256,43 +383,37 @@ public:
 
     /// Tries to read matrix from the dictionary. If matrix entry is not present, default value is returned.
     /// If it is present and invalid, exception is thrown.
-    QTransform readMatrixFromDictionary(const PDFDictionary* dictionary, const char* key, QTransform defaultValue) const;
+    QTransform readMatrixFromDictionary(const PDFDictionary* dictionary, PDFNameAtom key, QTransform defaultValue) const;
 
     /// Tries to read array of real values from dictionary. If entry dictionary doesn't exist,
     /// or error occurs, default value is returned.
-    std::vector<PDFReal> readNumberArrayFromDictionary(const PDFDictionary* dictionary, const char* key, std::vector<PDFReal> defaultValue = std::vector<PDFReal>()) const;
+    std::vector<PDFReal> readNumberArrayFromDictionary(const PDFDictionary* dictionary, PDFNameAtom key, std::vector<PDFReal> defaultValue = std::vector<PDFReal>()) const;
 
     /// Tries to read array of integer values from dictionary. If entry dictionary doesn't exist,
     /// or error occurs, empty array is returned.
-    std::vector<PDFInteger> readIntegerArrayFromDictionary(const PDFDictionary* dictionary, const char* key) const;
-
-    /// Reads number from dictionary. If dictionary entry doesn't exist, or error occurs, default value is returned.
-    /// \param dictionary Dictionary containing desired data
-    /// \param key Entry key
-    /// \param defaultValue Default value
-    PDFReal readNumberFromDictionary(const PDFDictionary* dictionary, const char* key, PDFReal defaultValue) const;
+    std::vector<PDFInteger> readIntegerArrayFromDictionary(const PDFDictionary* dictionary, PDFNameAtom key) const;
 
     /// Reads number from dictionary. If dictionary entry doesn't exist, or error occurs, default value is returned.
     /// \param dictionary Dictionary containing desired data
     /// \param key Entry key
     /// \param defaultValue Default value
-    PDFReal readNumberFromDictionary(const PDFDictionary* dictionary, const QByteArray& key, PDFReal defaultValue) const;
+    PDFReal readNumberFromDictionary(const PDFDictionary* dictionary, PDFNameAtom key, PDFReal defaultValue) const;
 
     /// Reads integer from dictionary. If dictionary entry doesn't exist, or error occurs, default value is returned.
     /// \param dictionary Dictionary containing desired data
     /// \param key Entry key
     /// \param defaultValue Default value
-    PDFInteger readIntegerFromDictionary(const PDFDictionary* dictionary, const char* key, PDFInteger defaultValue) const;
+    PDFInteger readIntegerFromDictionary(const PDFDictionary* dictionary, PDFNameAtom key, PDFInteger defaultValue) const;
 
     /// Reads a text string from the dictionary, if it is possible.
     /// \param dictionary Dictionary containing desired data
     /// \param key Entry key
     /// \param defaultValue Default value
-    QString readTextStringFromDictionary(const PDFDictionary* dictionary, const char* key, const QString& defaultValue) const;
+    QString readTextStringFromDictionary(const PDFDictionary* dictionary, PDFNameAtom key, const QString& defaultValue) const;
 
     /// Tries to read array of references from dictionary. If entry dictionary doesn't exist,
     /// or error occurs, empty array is returned.
-    std::vector<PDFObjectReference> readReferenceArrayFromDictionary(const PDFDictionary* dictionary, const char* key) const;
+    std::vector<PDFObjectReference> readReferenceArrayFromDictionary(const PDFDictionary* dictionary, PDFNameAtom key) const;
 
     /// Reads number array from dictionary. Reads all values. If some value is not
     /// real number (or integer number), default value is returned. Default value is also returned,
@@ -313,7 +434,7 @@ public:
     /// Reads reference from dictionary. If error occurs, then invalid reference is returned.
     /// \param dictionary Dictionary containing desired data
     /// \param key Entry key
-    PDFObjectReference readReferenceFromDictionary(const PDFDictionary* dictionary, const char* key) const;
+    PDFObjectReference readReferenceFromDictionary(const PDFDictionary* dictionary, PDFNameAtom key) const;
 
     /// Reads reference array. Reads all values. If error occurs,
     /// then empty array is returned.
@@ -334,35 +455,35 @@ public:
     /// then empty array is returned.
     /// \param dictionary Dictionary containing desired data
     /// \param key Entry key
-    std::vector<QByteArray> readNameArrayFromDictionary(const PDFDictionary* dictionary, const char* key) const;
+    std::vector<QByteArray> readNameArrayFromDictionary(const PDFDictionary* dictionary, PDFNameAtom key) const;
 
     /// Reads boolean from dictionary. If dictionary entry doesn't exist, or error occurs, default value is returned.
     /// \param dictionary Dictionary containing desired data
     /// \param key Entry key
     /// \param defaultValue Default value
-    bool readBooleanFromDictionary(const PDFDictionary* dictionary, const char* key, bool defaultValue) const;
+    bool readBooleanFromDictionary(const PDFDictionary* dictionary, PDFNameAtom key, bool defaultValue) const;
 
     /// Reads a name from dictionary. If dictionary entry doesn't exist, or error occurs, empty byte array is returned.
     /// \param dictionary Dictionary containing desired data
     /// \param key Entry key
-    QByteArray readNameFromDictionary(const PDFDictionary* dictionary, const char* key) const;
+    QByteArray readNameFromDictionary(const PDFDictionary* dictionary, PDFNameAtom key) const;
 
     /// Reads a string from dictionary. If dictionary entry doesn't exist, or error occurs, empty byte array is returned.
     /// \param dictionary Dictionary containing desired data
     /// \param key Entry key
-    QByteArray readStringFromDictionary(const PDFDictionary* dictionary, const char* key) const;
+    QByteArray readStringFromDictionary(const PDFDictionary* dictionary, PDFNameAtom key) const;
 
     /// Reads string array from dictionary. Reads all values. If error occurs,
     /// then empty array is returned.
     /// \param dictionary Dictionary containing desired data
     /// \param key Entry key
-    std::vector<QByteArray> readStringArrayFromDictionary(const PDFDictionary* dictionary, const char* key) const;
+    std::vector<QByteArray> readStringArrayFromDictionary(const PDFDictionary* dictionary, PDFNameAtom key) const;
 
     /// Reads string list. If error occurs, empty list is returned.
     QStringList readTextStringList(const PDFObject& object);
 
     /// Reads RGB color from dictionary
-    QColor readRGBColorFromDictionary(const PDFDictionary* dictionary, const char* key, QColor defaultColor);
+    QColor readRGBColorFromDictionary(const PDFDictionary* dictionary, PDFNameAtom key, QColor defaultColor);
 
     /// Reads list of object, using parse function defined in object
     template<typename Object>
@@ -389,12 +510,12 @@ public:
     /// then empty optional is returned.
     /// \param dictionary Dictionary containing desired data
     /// \param key Entry key
-    std::optional<QByteArray> readOptionalStringFromDictionary(const PDFDictionary* dictionary, const char* key) const;
+    std::optional<QByteArray> readOptionalStringFromDictionary(const PDFDictionary* dictionary, PDFNameAtom key) const;
 
     /// Reads optionalinteger from dictionary. If dictionary entry doesn't exist, or error occurs, empty optional is returned.
     /// \param dictionary Dictionary containing desired data
     /// \param key Entry key
-    std::optional<PDFInteger> readOptionalIntegerFromDictionary(const PDFDictionary* dictionary, const char* key) const;
+    std::optional<PDFInteger> readOptionalIntegerFromDictionary(const PDFDictionary* dictionary, PDFNameAtom key) const;
 
 private:
     const PDFObjectStorage* m_storage;
@@ -443,6 +564,13 @@ public:
     /// \param stream Stream to be decoded
     QByteArray getDecodedStream(const PDFStream* stream) const;
 
+    /// Creates source of decoded stream data, data are decoded in chunks, as they
+    /// are read, so large streams can be processed without decoding them whole
+    /// into the memory. Document must exist, while source is being used.
+    /// If stream filters are invalid, then nullptr is returned.
+    /// \param stream Stream to be decoded
+    PDFStreamFilterSourcePointer createDecodedStreamSource(const PDFStream* stream) const;
+
     /// Returns the trailer dictionary
     const PDFDictionary* getTrailerDictionary() const;
 
@@ -464,7 +592,8 @@ public:
      * @brief Retrieves the hash of the source data.
      *
      * This function returns the hash derived from the source data
-     * from which the document was originally read.
+     * from which the document was originally read. Hash is empty
+     * for documents loaded lazily from the memory-mapped file.
      *
      * @return Hash value of the source data.
      */
@@ -584,6 +713,32 @@ private:
 
 // Implementation
 
+inline
+PDFObjectStorage::Entry& PDFObjectStorage::Entry::operator=(const Entry& other)
+{
+    if (this != &other)
+    {
+        generation = other.generation;
+        const bool isOtherLoaded = other.isLoaded();
+        object = isOtherLoaded ? other.object : PDFObject();
+        loaded.store(isOtherLoaded, std::memory_order_release);
+    }
+    return *this;
+}
+
+inline
+PDFObjectStorage::Entry& PDFObjectStorage::Entry::operator=(Entry&& other) noexcept
+{
+    if (this != &other)
+    {
+        generation = other.generation;
+        const bool isOtherLoaded = other.isLoaded();
+        object = isOtherLoaded ? std::move(other.object) : PDFObject();
+        loaded.store(isOtherLoaded, std::memory_order_release);
+    }
+    return *this;
+}
+
 inline
 const PDFObject& PDFDocument::getObject(const PDFObject& object) const
 {
@@ -33,10 +33,180 @@
 #include <cctype>
 #include <algorithm>
 #include <execution>
+#include <deque>
 
 namespace pdf
 {
 
+/// Object loader for lazy loading mode of the document reader. It parses
+/// objects from the memory mapped file on first access. Objects from object
+/// streams are parsed from decoded object streams, a few recently decoded
+/// object streams are cached.
+class PDFLazyObjectLoader : public PDFObjectStorageLoader
+{
+public:
+    explicit PDFLazyObjectLoader(std::shared_ptr<QFile> mappedFile, QByteArray source, PDFXRefTable xrefTable) :
+        m_mappedFile(std::move(mappedFile)),
+        m_source(std::move(source)),
+        m_xrefTable(std::move(xrefTable))
+    {
+
+    }
+
+    /// Sets security handler used to decrypt loaded objects
+    void setSecurityHandler(PDFSecurityHandlerPointer securityHandler) { m_securityHandler = std::move(securityHandler); }
+
+protected:
+    virtual PDFObject loadObject(PDFObjectReference reference, const PDFObjectStorage* storage) override;
+
+private:
+    static constexpr size_t MAX_CACHED_OBJECT_STREAMS = 16;
+
+    struct ObjectStream
+    {
+        QByteArray data;
+        std::vector<std::pair<PDFInteger, PDFInteger>> objectNumberAndOffset;
+    };
+
+    PDFObject loadObjectFromObjectStream(const PDFXRefTable::Entry& entry, const PDFObjectStorage* storage);
+    const ObjectStream& getObjectStream(PDFObjectReference objectStreamReference, const PDFObjectStorage* storage);
+
+    /// Memory mapped file, source data references mapped memory
+    std::shared_ptr<QFile> m_mappedFile;
+    QByteArray m_source;
+    PDFXRefTable m_xrefTable;
+    PDFSecurityHandlerPointer m_securityHandler;
+
+    /// Recently decoded object streams
+    std::map<PDFObjectReference, ObjectStream> m_objectStreams;
+    std::deque<PDFObjectReference> m_objectStreamsOrder;
+};
+
+PDFObject PDFLazyObjectLoader::loadObject(PDFObjectReference reference, const PDFObjectStorage* storage)
+{
+    const PDFXRefTable::Entry& entry = m_xrefTable.getEntry(reference);
+    switch (entry.type)
+    {
+        case PDFXRefTable::EntryType::Occupied:
+        {
+            auto objectFetcher = [storage](PDFParsingContext*, PDFObjectReference objectReference) { return storage->getObject(objectReference); };
+            PDFParsingContext context(objectFetcher);
+
+            // Encrypted streams are decrypted into a new buffer, so we can
+            // reference mapped data only for unencrypted documents.
+            const bool isEncrypted = m_securityHandler && m_securityHandler->getMode() != EncryptionMode::None;
+            PDFObject object = PDFDocumentReader::parseObject(m_source, &context, entry.offset, reference, !isEncrypted);
+
+            if (isEncrypted)
+            {
+                object = m_securityHandler->decryptObject(object, reference);
+            }
+
+            return object;
+        }
+
+        case PDFXRefTable::EntryType::InObjectStream:
+            return loadObjectFromObjectStream(entry, storage);
+
+        default:
+            break;
+    }
+
+    return PDFObject();
+}
+
+PDFObject PDFLazyObjectLoader::loadObjectFromObjectStream(const PDFXRefTable::Entry& entry, const PDFObjectStorage* storage)
+{
+    const ObjectStream& objectStream = getObjectStream(entry.objectStream, storage);
+
+    // Try to use index from the reference table, if it is not valid, then search for the object
+    PDFInteger offset = -1;
+    const PDFInteger index = entry.indexInObjectStream;
+    if (index >= 0 && index < PDFInteger(objectStream.objectNumberAndOffset.size()) && objectStream.objectNumberAndOffset[index].first == entry.reference.objectNumber)
+    {
+        offset = objectStream.objectNumberAndOffset[index].second;
+    }
+    else
+    {
+        auto it = std::find_if(objectStream.objectNumberAndOffset.cbegin(), objectStream.objectNumberAndOffset.cend(), [&entry](const auto& item) { return item.first == entry.reference.objectNumber; });
+        if (it != objectStream.objectNumberAndOffset.cend())
+        {
+            offset = it->second;
+        }
+    }
+
+    if (offset < 0)
+    {
+        throw PDFException(PDFTranslationContext::tr("Object %1 not found in object stream %2.").arg(entry.reference.objectNumber).arg(entry.objectStream.objectNumber));
+    }
+
+    auto objectFetcher = [storage](PDFParsingContext*, PDFObjectReference objectReference) { return storage->getObject(objectReference); };
+    PDFParsingContext context(objectFetcher);
+    PDFParsingContext::PDFParsingContextGuard guard(&context, entry.objectStream);
+    PDFParser parser(objectStream.data, &context, PDFParser::AllowStreams);
+    parser.seek(offset);
+    return parser.getObject();
+}
+
+const PDFLazyObjectLoader::ObjectStream& PDFLazyObjectLoader::getObjectStream(PDFObjectReference objectStreamReference, const PDFObjectStorage* storage)
+{
+    auto it = m_objectStreams.find(objectStreamReference);
+    if (it != m_objectStreams.cend())
+    {
+        return it->second;
+    }
+
+    const PDFObject& object = storage->getObject(objectStreamReference);
+    if (!object.isStream())
+    {
+        throw PDFException(PDFTranslationContext::tr("Object stream %1 is invalid.").arg(objectStreamReference.objectNumber));
+    }
+
+    const PDFStream* stream = object.getStream();
+    const PDFDictionary* dictionary = stream->getDictionary();
+
+    const PDFObject& objectStreamType = dictionary->get("Type");
+    const PDFObject& nObject = dictionary->get("N");
+    const PDFObject& firstObject = dictionary->get("First");
+    if (!objectStreamType.isName() || objectStreamType.getString() != "ObjStm" || !nObject.isInt() || !firstObject.isInt())
+    {
+        throw PDFException(PDFTranslationContext::tr("Object stream %1 is invalid.").arg(objectStreamReference.objectNumber));
+    }
+
+    const PDFInteger n = nObject.getInteger();
+    const PDFInteger first = firstObject.getInteger();
+
+    auto objectFetcher = [storage](const PDFObject& object) -> const PDFObject& { return storage->getObject(object); };
+
+    ObjectStream objectStream;
+    objectStream.data = PDFStreamFilterStorage::getDecodedStream(stream, objectFetcher, m_securityHandler.data());
+
+    PDFParsingContext context([](PDFParsingContext*, PDFObjectReference) { return PDFObject(); });
+    PDFParser parser(objectStream.data, &context, PDFParser::None);
+    objectStream.objectNumberAndOffset.reserve(n);
+    for (PDFInteger i = 0; i < n; ++i)
+    {
+        PDFObject currentObjectNumber = parser.getObject();
+        PDFObject currentOffset = parser.getObject();
+
+        if (!currentObjectNumber.isInt() || !currentOffset.isInt())
+        {
+            throw PDFException(PDFTranslationContext::tr("Object stream %1 is invalid.").arg(objectStreamReference.objectNumber));
+        }
+
+        objectStream.objectNumberAndOffset.emplace_back(currentObjectNumber.getInteger(), currentOffset.getInteger() + first);
+    }
+
+    if (m_objectStreamsOrder.size() >= MAX_CACHED_OBJECT_STREAMS)
+    {
+        m_objectStreams.erase(m_objectStreamsOrder.front());
+        m_objectStreamsOrder.pop_front();
+    }
+
+    m_objectStreamsOrder.push_back(objectStreamReference);
+    return m_objectStreams.emplace(objectStreamReference, std::move(objectStream)).first->second;
+}
+
 PDFDocumentReader::PDFDocumentReader(PDFProgress* progress, const std::function<QString(bool*)>& getPasswordCallback, bool permissive, bool authorizeOwnerOnly) :
     m_result(Result::OK),
     m_getPasswordCallback(getPasswordCallback),
@@ -55,6 +225,27 @@ PDFDocument PDFDocumentReader::readFromFile(const QString& fileName)
 
     if (file.exists())
     {
+        if (m_loadingMode == LoadingMode::Lazy)
+        {
+            std::shared_ptr<QFile> mappedFile = std::make_shared<QFile>(fileName);
+            if (mappedFile->open(QFile::ReadOnly) && mappedFile->size() > 0)
+            {
+                const qint64 size = mappedFile->size();
+                const uchar* data = mappedFile->map(0, size);
+
+                // Mapped memory remains valid after the file is closed
+                mappedFile->close();
+
+                if (data)
+                {
+                    QByteArray buffer = QByteArray::fromRawData(reinterpret_cast<const char*>(data), size);
+                    return readLazyFromMappedFile(std::move(mappedFile), buffer);
+                }
+            }
+
+            // File can't be memory mapped, read it into the memory
+        }
+
         if (file.open(QFile::ReadOnly))
         {
             PDFDocument document = readFromDevice(&file);
@@ -167,7 +358,7 @@ void PDFDocumentReader::checkHeader(const QByteArray& buffer)
 
 PDFInteger PDFDocumentReader::findXrefTableOffset(const QByteArray& buffer)
 {
-    const int startXRefPosition = findFromEnd(PDF_START_OF_XREF_MARK, buffer, PDF_FOOTER_SCAN_LIMIT);
+    const PDFInteger startXRefPosition = findFromEnd(PDF_START_OF_XREF_MARK, buffer, PDF_FOOTER_SCAN_LIMIT);
     if (startXRefPosition == FIND_NOT_FOUND_RESULT)
     {
         throw PDFException(tr("Start of object reference table not found."));
@@ -186,10 +377,25 @@ PDFInteger PDFDocumentReader::findXrefTableOffset(const QByteArray& buffer)
 }
 
 PDFObject PDFDocumentReader::getObject(PDFParsingContext* context, PDFInteger offset, PDFObjectReference reference) const
+{
+    return parseObject(m_source, context, offset, reference, false);
+}
+
+PDFObject PDFDocumentReader::parseObject(const QByteArray& source,
+                                         PDFParsingContext* context,
+                                         PDFInteger offset,
+                                         PDFObjectReference reference,
+                                         bool referenceStreamData)
 {
     PDFParsingContext::PDFParsingContextGuard guard(context, reference);
 
-    PDFParser parser(m_source, context, PDFParser::AllowStreams);
+    PDFParser::Features features = PDFParser::AllowStreams;
+    if (referenceStreamData)
+    {
+        features.setFlag(PDFParser::ReferenceStreamData);
+    }
+
+    PDFParser parser(source, context, features);
     parser.seek(offset);
 
     PDFObject objectNumber = parser.getObject();
@@ -601,11 +807,112 @@ PDFDocument PDFDocumentReader::readFromBuffer(const QByteArray& buffer)
     return PDFDocument();
 }
 
+PDFDocument PDFDocumentReader::readLazyFromMappedFile(std::shared_ptr<QFile> mappedFile, const QByteArray& buffer)
+{
+    bool shouldTryPermissiveReading = true;
+
+    try
+    {
+        m_source = buffer;
+        m_mappedFile = mappedFile;
+
+        // FOOTER CHECKING
+        //  1) Check, if EOF marking is present
+        //  2) Find start of cross reference table
+        checkFooter(buffer);
+        const PDFInteger firstXrefTableOffset = findXrefTableOffset(buffer);
+
+        // HEADER CHECKING
+        //  1) Check if header is present
+        //  2) Scan header version
+        checkHeader(buffer);
+
+        // Now, we are ready to scan xref table
+        PDFXRefTable xrefTable;
+        xrefTable.readXRefTable(nullptr, buffer, firstXrefTableOffset);
+
+        if (xrefTable.getSize() == 0)
+        {
+            throw PDFException(tr("Empty xref table."));
+        }
+
+        // Objects are not parsed now, they will be parsed on first access
+        PDFObjectStorage::PDFObjects objects;
+        objects.resize(xrefTable.getSize());
+
+        for (const PDFXRefTable::Entry& entry : xrefTable.getOccupiedEntries())
+        {
+            objects[entry.reference.objectNumber] = PDFObjectStorage::Entry::createNotLoaded(entry.reference.generation);
+        }
+
+        for (const PDFXRefTable::Entry& entry : xrefTable.getObjectStreamEntries())
+        {
+            objects[entry.reference.objectNumber] = PDFObjectStorage::Entry::createNotLoaded(entry.reference.generation);
+        }
+
+        // Encrypt dictionary must be loaded now, because we need it for the security
+        // handler. It is never decrypted, so we load it directly.
+        const PDFObject& trailerDictionaryObject = xrefTable.getTrailerDictionary();
+        const PDFDictionary* trailerDictionary = trailerDictionaryObject.isStream() ? trailerDictionaryObject.getStream()->getDictionary() : trailerDictionaryObject.getDictionary();
+        if (trailerDictionary)
+        {
+            const PDFObject& encryptObject = trailerDictionary->get("Encrypt");
+            if (encryptObject.isReference())
+            {
+                const PDFObjectReference encryptObjectReference = encryptObject.getReference();
+                if (xrefTable.getEntry(encryptObjectReference).type == PDFXRefTable::EntryType::Occupied)
+                {
+                    auto objectFetcher = [this, &xrefTable](PDFParsingContext* context, PDFObjectReference reference) { return getObjectFromXrefTable(&xrefTable, context, reference); };
+                    PDFParsingContext context(objectFetcher);
+                    objects[encryptObjectReference.objectNumber] = PDFObjectStorage::Entry(encryptObjectReference.generation, getObjectFromXrefTable(&xrefTable, &context, encryptObjectReference));
+                }
+            }
+        }
+
+        std::shared_ptr<PDFLazyObjectLoader> objectLoader = std::make_shared<PDFLazyObjectLoader>(mappedFile, buffer, xrefTable);
+
+        // Objects are decrypted by the loader, when they are loaded, so we pass
+        // empty list of occupied entries (no object is decrypted here).
+        if (processSecurityHandler(trailerDictionaryObject, { }, objects) == Result::Cancelled)
+        {
+            return PDFDocument();
+        }
+
+        shouldTryPermissiveReading = !m_securityHandler || m_securityHandler->getMode() == EncryptionMode::None;
+        objectLoader->setSecurityHandler(m_securityHandler);
+
+        // Hash is not computed, it would read whole mapped file into the memory,
+        // which is what lazy loading avoids. Source data hash remains empty.
+        PDFObjectStorage storage(std::move(objects), PDFObject(trailerDictionaryObject), qMove(m_securityHandler), std::move(objectLoader));
+        return PDFDocument(std::move(storage), m_version, QByteArray());
+    }
+    catch (const PDFException &parserException)
+    {
+        m_result = Result::Failed;
+        m_errorMessage = parserException.getMessage();
+        m_warnings << m_errorMessage;
+    }
+
+    if (m_result == Result::Failed && m_permissive && shouldTryPermissiveReading)
+    {
+        return readDamagedDocumentFromBuffer(buffer);
+    }
+
+    return PDFDocument();
+}
+
 QByteArray PDFDocumentReader::hash(const QByteArray& sourceData)
 {
     return QCryptographicHash::hash(sourceData, QCryptographicHash::Sha256);
 }
 
+QByteArray PDFDocumentReader::hash(QIODevice* device)
+{
+    QCryptographicHash hash(QCryptographicHash::Sha256);
+    hash.addData(device);
+    return hash.result();
+}
+
 std::vector<std::pair<int, int>> PDFDocumentReader::findObjectByteOffsets(const QByteArray& buffer) const
 {
     std::vector<std::pair<int, int>> offsets;
@@ -791,10 +1098,11 @@ void PDFDocumentReader::reset()
     m_errorMessage = QString();
     m_version = PDFVersion();
     m_source = QByteArray();
+    m_mappedFile.reset();
     m_securityHandler = nullptr;
 }
 
-int PDFDocumentReader::findFromEnd(const char* what, const QByteArray& byteArray, int limit)
+PDFInteger PDFDocumentReader::findFromEnd(const char* what, const QByteArray& byteArray, int limit)
 {
     if (byteArray.isEmpty())
     {
@@ -802,8 +1110,8 @@ int PDFDocumentReader::findFromEnd(const char* what, const QByteArray& byteArray
         return FIND_NOT_FOUND_RESULT;
     }
 
-    const int size = byteArray.size();
-    const int adjustedLimit = qMin(byteArray.size(), limit);
+    const qsizetype size = byteArray.size();
+    const qsizetype adjustedLimit = qMin(byteArray.size(), qsizetype(limit));
     const int whatLength = static_cast<int>(std::strlen(what));
 
     if (adjustedLimit < whatLength)
@@ -27,10 +27,13 @@
 #include <QMutex>
 #include <QIODevice>
 
+class QFile;
+
 namespace pdf
 {
 class PDFXRefTable;
 class PDFParsingContext;
+class PDFLazyObjectLoader;
 
 /// This class is a reader of PDF document from various devices (file, io device,
 /// byte buffer). This class doesn't throw exceptions, to check errors, use
@@ -54,9 +57,16 @@ public:
         Cancelled   ///< User cancelled document reading
     };
 
+    enum class LoadingMode
+    {
+        Eager,      ///< Whole file is read into memory and all objects are parsed during reading
+        Lazy        ///< File is memory mapped and objects are parsed on first access
+    };
+
     /// Reads a PDF document from the specified file. If file doesn't exist,
     /// cannot be opened or contain invalid pdf, empty PDF file is returned.
-    /// No exception is thrown.
+    /// No exception is thrown. If lazy loading mode is set and file can
+    /// be memory mapped, then document is loaded lazily.
     PDFDocument readFromFile(const QString& fileName);
 
     /// Reads a PDF document from the specified device. If device is not opened
@@ -81,10 +91,29 @@ public:
     /// Returns warning messages
     const QStringList& getWarnings() const { return m_warnings; }
 
+    /// Returns loading mode used when reading document from file
+    LoadingMode getLoadingMode() const { return m_loadingMode; }
+
+    /// Sets loading mode used when reading document from file. In lazy mode,
+    /// the file is memory mapped, objects are parsed on first access and stream
+    /// data of unencrypted streams reference the mapped memory. Document (and all
+    /// its copies) keeps the mapping alive, so file must not be modified in place,
+    /// while the document exists.
+    /// \param loadingMode Loading mode
+    void setLoadingMode(LoadingMode loadingMode) { m_loadingMode = loadingMode; }
+
     static QByteArray hash(const QByteArray& sourceData);
 
+    /// Computes hash of the data read from the device (from its current position
+    /// to the end), the data are read in blocks. Hash is the same as the hash of the
+    /// source data of the document read from the device.
+    /// \param device Device opened for reading
+    static QByteArray hash(QIODevice* device);
+
 private:
-    static constexpr const int FIND_NOT_FOUND_RESULT = -1;
+    friend class PDFLazyObjectLoader;
+
+    static constexpr const PDFInteger FIND_NOT_FOUND_RESULT = -1;
 
     /// Resets the internal state and prepares it for new reading cycle
     void reset();
@@ -96,7 +125,7 @@ private:
     /// \param byteArray Byte array to be scanned from the end
     /// \param limit Scan up to this value bytes from the end
     /// \returns Position of string, or FIND_NOT_FOUND_RESULT
-    int findFromEnd(const char* what, const QByteArray& byteArray, int limit);
+    PDFInteger findFromEnd(const char* what, const QByteArray& byteArray, int limit);
 
     void checkFooter(const QByteArray& buffer);
     void checkHeader(const QByteArray& buffer);
@@ -112,6 +141,19 @@ private:
     /// \param reference Reference to parsed object
     PDFObject getObject(PDFParsingContext* context, PDFInteger offset, PDFObjectReference reference) const;
 
+    /// This function fetches object from the buffer from the specified offset.
+    /// Can throw exception, returns object content.
+    /// \param source Source data
+    /// \param context Context
+    /// \param offset Offset
+    /// \param reference Reference to parsed object
+    /// \param referenceStreamData Stream data are not copied, they reference source data
+    static PDFObject parseObject(const QByteArray& source,
+                                 PDFParsingContext* context,
+                                 PDFInteger offset,
+                                 PDFObjectReference reference,
+                                 bool referenceStreamData);
+
     /// Tries to restore objects from object list. This function can be used in multiple pass, because
     /// for example streams, can have length defined in referred object. If such is the case, then
     /// second pass is needed. Returns true, if all object were correctly read.
@@ -129,6 +171,12 @@ private:
     /// PDF is read, then empty PDF document is returned. No exception is thrown.
     PDFDocument readDamagedDocumentFromBuffer(const QByteArray& buffer);
 
+    /// Reads a PDF document lazily from the memory mapped file. Objects are not
+    /// parsed, they are parsed on first access. No exception is thrown.
+    /// \param mappedFile Memory mapped file
+    /// \param buffer Buffer referencing mapped memory
+    PDFDocument readLazyFromMappedFile(std::shared_ptr<QFile> mappedFile, const QByteArray& buffer);
+
     /// This function is used, when damaged pdf document is being restored. It returns
     /// array of hints, where objects should appear. It constists of pair of start offset,
     /// and end offset. Start offset is always a valid index to the buffer, end offset
@@ -162,6 +210,12 @@ private:
     /// Raw document data (byte array containing source data for created document)
     QByteArray m_source;
 
+    /// Memory mapped file (in lazy loading mode, source data references the mapped memory)
+    std::shared_ptr<QFile> m_mappedFile;
+
+    /// Loading mode used when reading document from file
+    LoadingMode m_loadingMode = LoadingMode::Eager;
+
     /// Security handler
     PDFSecurityHandlerPointer m_securityHandler;
 
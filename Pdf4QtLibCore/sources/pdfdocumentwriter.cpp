@@ -19,8 +19,11 @@
 #include "pdfconstants.h"
 #include "pdfvisitor.h"
 #include "pdfparser.h"
+#include "pdfstreamfilters.h"
+#include "pdfexception.h"
 
 #include <QFile>
+#include <QFileInfo>
 #include <QBuffer>
 #include <QSaveFile>
 
@@ -157,11 +160,16 @@ void PDFWriteObjectVisitor::visitDictionary(const PDFDictionary* dictionary)
 
 void PDFWriteObjectVisitor::visitStream(const PDFStream* stream)
 {
-    visitDictionary(stream->getDictionary());
+    // Length of the decrypted stream content is known only after decryption,
+    // so we always write the length of the content.
+    const QByteArray* content = stream->getContent();
+    PDFDictionary dictionary = *stream->getDictionary();
+    dictionary.setEntry(PDFInplaceOrMemoryString("Length"), PDFObject::createInteger(content->size()));
+    visitDictionary(&dictionary);
 
     m_device->write("stream");
     m_device->write("\x0D\x0A");
-    m_device->write(*stream->getContent());
+    m_device->write(*content);
     m_device->write("\x0D\x0A");
     m_device->write("endstream");
     m_device->write("\x0D\x0A");
@@ -174,6 +182,129 @@ void PDFWriteObjectVisitor::visitReference(const PDFObjectReference reference)
     m_device->write("R ");
 }
 
+/// Size of the write buffer, data are written to the target
+/// device in blocks of (at least) this size.
+static constexpr qint64 WRITE_BUFFER_SIZE = 4 * 1024 * 1024;
+
+/// Output device, which buffers written data and writes them to the target
+/// device in large blocks. Serialization of objects produces many small writes,
+/// so target device (usually file) gets only few large write requests.
+class PDFBufferedWriteIODevice : public QIODevice
+{
+public:
+    explicit PDFBufferedWriteIODevice(QIODevice* device, qint64 bufferSize) :
+        QIODevice(nullptr),
+        m_device(device),
+        m_bufferSize(bufferSize),
+        m_position(device->pos())
+    {
+        m_buffer.reserve(bufferSize);
+    }
+
+    virtual bool isSequential() const override { return true; }
+    virtual bool open(OpenMode mode) override;
+    virtual void close() override;
+    virtual qint64 pos() const override { return m_position; }
+    virtual qint64 size() const override { return m_position; }
+
+    /// Writes buffered data to the target device. Returns false,
+    /// if target device failed to write data.
+    bool flushBuffer();
+
+protected:
+    virtual qint64 readData(char* data, qint64 maxlen) override;
+    virtual qint64 writeData(const char* data, qint64 len) override;
+
+private:
+    bool writeToDevice(const char* data, qint64 len);
+
+    QIODevice* m_device;
+    QByteArray m_buffer;
+    qint64 m_bufferSize;
+    qint64 m_position;
+    bool m_failed = false;
+};
+
+bool PDFBufferedWriteIODevice::open(OpenMode mode)
+{
+    if (openMode() == NotOpen)
+    {
+        setOpenMode(mode);
+        return true;
+    }
+
+    return false;
+}
+
+void PDFBufferedWriteIODevice::close()
+{
+    flushBuffer();
+    setOpenMode(NotOpen);
+}
+
+bool PDFBufferedWriteIODevice::flushBuffer()
+{
+    if (!m_buffer.isEmpty())
+    {
+        writeToDevice(m_buffer.constData(), m_buffer.size());
+        m_buffer.clear();
+    }
+
+    return !m_failed;
+}
+
+qint64 PDFBufferedWriteIODevice::readData(char* data, qint64 maxlen)
+{
+    Q_UNUSED(data);
+    Q_UNUSED(maxlen);
+
+    return -1;
+}
+
+qint64 PDFBufferedWriteIODevice::writeData(const char* data, qint64 len)
+{
+    if (m_failed)
+    {
+        return -1;
+    }
+
+    if (m_buffer.size() + len > m_bufferSize)
+    {
+        flushBuffer();
+    }
+
+    if (len >= m_bufferSize)
+    {
+        // Large block (for example, stream content) is written directly
+        writeToDevice(data, len);
+    }
+    else
+    {
+        m_buffer.append(data, len);
+    }
+
+    m_position += len;
+    return m_failed ? -1 : len;
+}
+
+bool PDFBufferedWriteIODevice::writeToDevice(const char* data, qint64 len)
+{
+    while (!m_failed && len > 0)
+    {
+        const qint64 written = m_device->write(data, len);
+        if (written <= 0)
+        {
+            m_failed = true;
+            break;
+        }
+
+        data += written;
+        len -= written;
+    }
+
+    return !m_failed;
+}
+
 PDFOperationResult PDFDocumentWriter::write(const QString& fileName, const PDFDocument* document, bool safeWrite)
 {
     Q_ASSERT(document);
@@ -234,24 +365,344 @@ PDFOperationResult PDFDocumentWriter::write(const QString& fileName, const PDFDo
     }
 }
 
-PDFOperationResult PDFDocumentWriter::write(QIODevice* device, const PDFDocument* document)
+PDFOperationResult PDFDocumentWriter::write(QIODevice* targetDevice, const PDFDocument* document)
 {
-    if (!device->isWritable())
+    if (!targetDevice->isWritable())
     {
         return tr("Device is not writable.");
     }
 
     const PDFObjectStorage& storage = document->getStorage();
-    const PDFObjectStorage::PDFObjects& objects = storage.getObjects();
-    const size_t objectCount = objects.size();
-    const bool isEncrypted = storage.getSecurityHandler()->getMode() != EncryptionMode::None;
     if (!storage.getSecurityHandler()->isEncryptionAllowed())
     {
         return tr("Writing of encrypted documents is not supported.");
     }
 
-    // Write header
+    // All data are written through the buffer, so target device gets large blocks of data
+    PDFBufferedWriteIODevice bufferedDevice(targetDevice, WRITE_BUFFER_SIZE);
+    bufferedDevice.open(QIODevice::WriteOnly);
+    QIODevice* device = &bufferedDevice;
+
+    try
+    {
+        writeDocument(device, document);
+    }
+    catch (const PDFException& exception)
+    {
+        return exception.getMessage();
+    }
+
+    if (!bufferedDevice.flushBuffer())
+    {
+        return tr("Writing to the device failed. %1").arg(targetDevice->errorString());
+    }
+
+    return true;
+}
+
+PDFOperationResult PDFDocumentWriter::writeIncremental(const QString& fileName,
+                                                       const PDFDocument* document,
+                                                       const PDFDocument* originalDocument,
+                                                       const QString& originalFileName)
+{
+    Q_ASSERT(document);
+    Q_ASSERT(originalDocument);
+
+    QFile originalFile(originalFileName);
+    if (!originalFile.open(QFile::ReadOnly))
+    {
+        return tr("Original file '%1' can't be opened for reading. %2").arg(originalFileName, originalFile.errorString());
+    }
+
+    // Update is never appended to the existing file in place. Original data and update
+    // are written to the temporary file, which then replaces the target file, so target
+    // file is not changed, if writing fails or crashes. No direct write fallback is used,
+    // because target file can be the original file, which is being read (and can be
+    // memory mapped by the lazy loader).
+    QSaveFile file(fileName);
+    if (!file.open(QFile::WriteOnly))
+    {
+        return tr("File '%1' can't be opened for writing. %2").arg(fileName, file.errorString());
+    }
+
+    // Original data are copied unchanged, update is appended then
+    while (!originalFile.atEnd())
+    {
+        const QByteArray data = originalFile.read(WRITE_BUFFER_SIZE);
+        if (data.isEmpty() || file.write(data) != data.size())
+        {
+            file.cancelWriting();
+            return tr("File '%1' can't be copied to '%2'.").arg(originalFileName, fileName);
+        }
+    }
+
+    PDFOperationResult result = writeIncremental(&originalFile, &file, document, originalDocument);
+    if (!result)
+    {
+        file.cancelWriting();
+        return result;
+    }
+
+    if (!file.commit())
+    {
+        return tr("File '%1' can't be opened for writing. %2").arg(fileName, file.errorString());
+    }
+
+    return true;
+}
+
+PDFOperationResult PDFDocumentWriter::writeIncremental(QIODevice* device, const PDFDocument* document, const PDFDocument* originalDocument)
+{
+    if (!device->isWritable())
+    {
+        return tr("Incremental update requires readable and writable random access device.");
+    }
+
+    return writeIncremental(device, device, document, originalDocument);
+}
+
+PDFOperationResult PDFDocumentWriter::writeIncremental(QIODevice* originalDevice,
+                                                       QIODevice* device,
+                                                       const PDFDocument* document,
+                                                       const PDFDocument* originalDocument)
+{
+    if (!originalDevice->isReadable() || originalDevice->isSequential())
+    {
+        return tr("Incremental update requires readable and writable random access device.");
+    }
+
+    const PDFObjectStorage& storage = document->getStorage();
+    const PDFObjectStorage& originalStorage = originalDocument->getStorage();
+    if (!storage.getSecurityHandler()->isEncryptionAllowed())
+    {
+        return tr("Writing of encrypted documents is not supported.");
+    }
+
+    // Objects, which are not changed, remain encrypted by the original security handler,
+    // so incremental update can't be used, if encryption has been changed.
+    const EncryptionMode encryptionMode = storage.getSecurityHandler()->getMode();
+    const EncryptionMode originalEncryptionMode = originalStorage.getSecurityHandler()->getMode();
+    if (encryptionMode != originalEncryptionMode ||
+        (encryptionMode != EncryptionMode::None && storage.getSecurityHandler() != originalStorage.getSecurityHandler()) ||
+        document->getTrailerDictionary()->get("Encrypt") != originalDocument->getTrailerDictionary()->get("Encrypt"))
+    {
+        return tr("Encryption of the document has been changed, incremental update is not possible.");
+    }
+
+    // Find last cross-reference section of the original data
+    const qint64 originalSize = originalDevice->size();
+    const qint64 tailSize = qMin<qint64>(originalSize, PDF_FOOTER_SCAN_LIMIT);
+    if (!originalDevice->seek(originalSize - tailSize))
+    {
+        return tr("Reading of the original document failed. %1").arg(originalDevice->errorString());
+    }
+
+    const QByteArray tail = originalDevice->read(tailSize);
+    const qsizetype startXRefPosition = tail.lastIndexOf(PDF_START_OF_XREF_MARK);
+    if (startXRefPosition == -1)
+    {
+        return tr("Start of object reference table not found.");
+    }
+
+    const char* startXRefData = tail.constData() + startXRefPosition + std::strlen(PDF_START_OF_XREF_MARK);
+    PDFLexicalAnalyzer analyzer(startXRefData, tail.constData() + tail.size());
+    const PDFLexicalAnalyzer::Token token = analyzer.fetch();
+    const PDFInteger originalXRefOffset = token.data.toLongLong();
+    if (token.type != PDFLexicalAnalyzer::TokenType::Integer || originalXRefOffset < 0 || originalXRefOffset >= originalSize)
+    {
+        return tr("Start of object reference table not found.");
+    }
+
+    if (!originalDevice->seek(originalXRefOffset))
+    {
+        return tr("Reading of the original document failed. %1").arg(originalDevice->errorString());
+    }
+    const bool isOriginalXRefStream = !originalDevice->read(32).trimmed().startsWith(PDF_XREF_HEADER);
+
+    // If update is written to the device with original data, it is appended
+    // at the end. Otherwise device already contains copy of the original data.
+    if (device == originalDevice && !device->seek(originalSize))
+    {
+        return tr("Writing to the device failed. %1").arg(device->errorString());
+    }
+
+    PDFBufferedWriteIODevice bufferedDevice(device, WRITE_BUFFER_SIZE);
+    bufferedDevice.open(QIODevice::WriteOnly);
+
+    try
+    {
+        writeIncrementalUpdate(&bufferedDevice, document, originalDocument, originalXRefOffset, isOriginalXRefStream);
+    }
+    catch (const PDFException& exception)
+    {
+        return exception.getMessage();
+    }
+
+    if (!bufferedDevice.flushBuffer())
+    {
+        return tr("Writing to the device failed. %1").arg(device->errorString());
+    }
+
+    return true;
+}
+
+void PDFDocumentWriter::writeIncrementalUpdate(QIODevice* device,
+                                               const PDFDocument* document,
+                                               const PDFDocument* originalDocument,
+                                               PDFInteger originalXRefOffset,
+                                               bool isOriginalXRefStream) const
+{
+    const PDFObjectStorage& storage = document->getStorage();
+    const PDFObjectStorage& originalStorage = originalDocument->getStorage();
+    const PDFSecurityHandler* securityHandler = storage.getSecurityHandler();
+    const bool isEncrypted = securityHandler->getMode() != EncryptionMode::None;
+
+    PDFObjectReference encryptObjectReference;
+    PDFObject encryptObject = document->getTrailerDictionary()->get("Encrypt");
+    if (encryptObject.isReference())
+    {
+        encryptObjectReference = encryptObject.getReference();
+    }
+
+    const PDFInteger objectCount = PDFInteger(storage.getObjectCount());
+    const PDFInteger originalObjectCount = PDFInteger(originalStorage.getObjectCount());
+    const PDFInteger maxObjectCount = qMax(objectCount, originalObjectCount);
+
+    // Original data need not to be terminated by end of line
+    writeCRLF(device);
+
+    // Write new and changed objects, deleted objects will have free entries.
+    // Objects, which are the same in both documents, are not loaded, if possible.
+    std::vector<PDFInteger> objectNumbers;
+    std::vector<std::array<PDFInteger, 3>> xrefEntries;
+    for (PDFInteger i = 1; i < maxObjectCount; ++i)
+    {
+        if (storage.isSameObject(originalStorage, i))
+        {
+            continue;
+        }
+
+        PDFObjectReference reference(i, storage.getObjectGeneration(i));
+        const PDFObject& object = storage.getObject(reference);
+
+        if (object.isNull())
+        {
+            const PDFInteger originalGeneration = originalStorage.getObjectGeneration(i);
+            if (originalGeneration == -1 || originalStorage.getObject(PDFObjectReference(i, originalGeneration)).isNull())
+            {
+                // Object is free in both documents
+                continue;
+            }
+
+            // Deleted object, next generation number is used
+            objectNumbers.push_back(i);
+            xrefEntries.push_back({ 0, 0, qMin<PDFInteger>(qMax(reference.generation, originalGeneration) + 1, 65535) });
+            continue;
+        }
+
+        objectNumbers.push_back(i);
+        xrefEntries.push_back({ 1, device->pos(), reference.generation });
+
+        PDFObject objectToWrite = object;
+        if (isEncrypted && reference != encryptObjectReference)
+        {
+            objectToWrite = securityHandler->encryptObject(objectToWrite, reference);
+        }
+
+        PDFWriteObjectVisitor visitor(device);
+        writeObjectHeader(device, reference);
+        objectToWrite.accept(&visitor);
+        writeObjectFooter(device);
+    }
+
+    PDFInteger size = maxObjectCount;
+    const PDFObject& originalSizeObject = originalDocument->getTrailerDictionary()->get("Size");
+    if (originalSizeObject.isInt())
+    {
+        size = qMax(size, originalSizeObject.getInteger());
+    }
+
+    const PDFInteger xrefOffset = device->pos();
+    if (isOriginalXRefStream)
+    {
+        // Cross-reference stream is the last object
+        PDFObjectReference xrefReference(size++, 0);
+        objectNumbers.push_back(xrefReference.objectNumber);
+        xrefEntries.push_back({ 1, xrefOffset, 0 });
+    }
+
+    // Consecutive object numbers form subsections
+    std::vector<PDFInteger> index;
+    for (size_t i = 0; i < objectNumbers.size(); ++i)
+    {
+        if (index.empty() || index[index.size() - 2] + index.back() != objectNumbers[i])
+        {
+            index.push_back(objectNumbers[i]);
+            index.push_back(0);
+        }
+        ++index.back();
+    }
+
+    PDFDictionary trailerDictionary = createTrailerDictionary(document, size, originalXRefOffset);
+
+    if (isOriginalXRefStream)
+    {
+        writeXRefStream(device, PDFObjectReference(size - 1, 0), xrefEntries, index, qMove(trailerDictionary));
+    }
+    else
+    {
+        device->write(PDF_XREF_HEADER);
+        writeCRLF(device);
+
+        size_t entryIndex = 0;
+        for (size_t i = 0; i < index.size(); i += 2)
+        {
+            device->write(QString("%1 %2").arg(index[i]).arg(index[i + 1]).toLatin1());
+            writeCRLF(device);
+
+            for (PDFInteger j = 0; j < index[i + 1]; ++j)
+            {
+                const std::array<PDFInteger, 3>& entry = xrefEntries[entryIndex++];
+                writeXRefTableEntry(device, entry[1], entry[2], entry[0] == 1);
+            }
+        }
+
+        if (index.empty())
+        {
+            // Cross-reference section must have at least one subsection
+            device->write("0 0");
+            writeCRLF(device);
+        }
+
+        PDFObject trailerDictionaryObject = PDFObject::createDictionary(std::make_shared<PDFDictionary>(qMove(trailerDictionary)));
+        device->write("trailer");
+        writeCRLF(device);
+        PDFWriteObjectVisitor trailerVisitor(device);
+        trailerDictionaryObject.accept(&trailerVisitor);
+        writeCRLF(device);
+    }
+
+    device->write("startxref");
+    writeCRLF(device);
+    device->write(QString::number(xrefOffset).toLatin1());
+    writeCRLF(device);
+    device->write("%%EOF");
+    writeCRLF(device);
+}
+
+void PDFDocumentWriter::writeDocument(QIODevice* device, const PDFDocument* document) const
+{
+    const PDFObjectStorage& storage = document->getStorage();
+    const PDFObjectStorage::PDFObjects& objects = storage.getObjects();
+    const size_t objectCount = objects.size();
+    const bool isEncrypted = storage.getSecurityHandler()->getMode() != EncryptionMode::None;
+
+    // Write header. Object streams require PDF 1.5.
     PDFVersion version = document->getInfo()->version;
+    if (m_objectStreamsEnabled && (version.major < 1 || (version.major == 1 && version.minor < 5)))
+    {
+        version = PDFVersion(1, 5);
+    }
     device->write(QString("%PDF-%1.%2").arg(version.major).arg(version.minor).toLatin1());
     writeCRLF(device);
     device->write("% PDF producer: ");
@@ -267,8 +718,10 @@ PDFOperationResult PDFDocumentWriter::write(QIODevice* device, const PDFDocument
         encryptObjectReference = encryptObject.getReference();
     }
 
-    // Write objects
+    // Write objects. If object streams are enabled, objects, which can
+    // be stored in the object stream, are written later.
     std::vector<PDFInteger> offsets(objectCount, -1);
+    std::vector<PDFInteger> compressedObjects;
     for (size_t i = 0; i < objectCount; ++i)
     {
         const PDFObjectStorage::Entry& entry = objects[i];
@@ -277,6 +730,16 @@ PDFOperationResult PDFDocumentWriter::write(QIODevice* device, const PDFDocument
             continue;
         }
 
+        if (m_objectStreamsEnabled &&
+            i > 0 &&
+            entry.generation == 0 &&
+            !entry.object.isStream() &&
+            PDFInteger(i) != encryptObjectReference.objectNumber)
+        {
+            compressedObjects.push_back(PDFInteger(i));
+            continue;
+        }
+
         // Jakub Melka: we must mark actual position of object
         offsets[i] = device->pos();
 
@@ -304,6 +767,41 @@ PDFOperationResult PDFDocumentWriter::write(QIODevice* device, const PDFDocument
         }
     }
 
+    if (m_objectStreamsEnabled)
+    {
+        std::vector<std::array<PDFInteger, 3>> xrefEntries;
+        xrefEntries.reserve(objectCount + compressedObjects.size() / m_objectsPerStream + 2);
+
+        for (size_t i = 0; i < objectCount; ++i)
+        {
+            if (offsets[i] != -1)
+            {
+                xrefEntries.push_back({ 1, offsets[i], objects[i].generation });
+            }
+            else
+            {
+                xrefEntries.push_back({ 0, 0, (i == 0) ? 65535 : objects[i].generation });
+            }
+        }
+
+        writeObjectStreams(device, document, compressedObjects, PDFInteger(objectCount), xrefEntries);
+
+        // Cross-reference stream is the last object
+        PDFObjectReference xrefReference(PDFInteger(xrefEntries.size()), 0);
+        PDFInteger xrefOffset = device->pos();
+        xrefEntries.push_back({ 1, xrefOffset, 0 });
+        writeXRefStream(device, xrefReference, xrefEntries, { }, createTrailerDictionary(document, PDFInteger(xrefEntries.size()), -1));
+
+        device->write("startxref");
+        writeCRLF(device);
+        device->write(QString::number(xrefOffset).toLatin1());
+        writeCRLF(device);
+
+        // Write footer
+        device->write("%%EOF");
+        return;
+    }
+
     // Write cross-reference table
     PDFInteger xrefOffset = device->pos();
     device->write("xref");
@@ -327,15 +825,7 @@ PDFOperationResult PDFDocumentWriter::write(QIODevice* device, const PDFDocument
             offset = 0;
         }
 
-        QString offsetString = QString::number(offset).rightJustified(10, QChar('0'), true);
-        QString generationString = QString::number(generation).rightJustified(5, QChar('0'), true);
-
-        device->write(offsetString.toLatin1());
-        device->write(" ");
-        device->write(generationString.toLatin1());
-        device->write(" ");
-        device->write(entry.object.isNull() ? "f" : "n");
-        writeCRLF(device);
+        writeXRefTableEntry(device, offset, generation, !entry.object.isNull());
     }
 
     // Jakub Melka: Adjust trailer dictionary, to be really dictionary, not a stream
@@ -365,8 +855,183 @@ PDFOperationResult PDFDocumentWriter::write(QIODevice* device, const PDFDocument
 
     // Write footer
     device->write("%%EOF");
+}
 
-    return true;
+void PDFDocumentWriter::writeObjectStreams(QIODevice* device,
+                                           const PDFDocument* document,
+                                           const std::vector<PDFInteger>& compressedObjects,
+                                           PDFInteger objectNumber,
+                                           std::vector<std::array<PDFInteger, 3>>& xrefEntries) const
+{
+    const PDFObjectStorage& storage = document->getStorage();
+    const PDFObjectStorage::PDFObjects& objects = storage.getObjects();
+    const PDFSecurityHandler* securityHandler = storage.getSecurityHandler();
+    const bool isEncrypted = securityHandler->getMode() != EncryptionMode::None;
+    const size_t objectsPerStream = m_objectsPerStream;
+
+    for (size_t first = 0; first < compressedObjects.size(); first += objectsPerStream)
+    {
+        const size_t last = qMin(first + objectsPerStream, compressedObjects.size());
+        const PDFObjectReference streamReference(objectNumber++, 0);
+        Q_ASSERT(PDFInteger(xrefEntries.size()) == streamReference.objectNumber);
+
+        // Object stream starts with pairs of object number and offset of the object
+        // relative to the first object. Objects in object stream are not encrypted,
+        // the whole object stream is encrypted instead.
+        QByteArray header;
+        QByteArray data;
+        for (size_t i = first; i < last; ++i)
+        {
+            const PDFInteger compressedObjectNumber = compressedObjects[i];
+
+            header.append(QByteArray::number(compressedObjectNumber));
+            header.append(' ');
+            header.append(QByteArray::number(data.size()));
+            header.append(' ');
+            data.append(getSerializedObject(objects[compressedObjectNumber].object));
+
+            xrefEntries[compressedObjectNumber] = { 2, streamReference.objectNumber, PDFInteger(i - first) };
+        }
+
+        QByteArray content = PDFFlateDecodeFilter::compress(header + data);
+
+        PDFDictionary dictionary;
+        dictionary.addEntry(PDFInplaceOrMemoryString("Type"), PDFObject::createName("ObjStm"));
+        dictionary.addEntry(PDFInplaceOrMemoryString("N"), PDFObject::createInteger(PDFInteger(last - first)));
+        dictionary.addEntry(PDFInplaceOrMemoryString("First"), PDFObject::createInteger(header.size()));
+        dictionary.addEntry(PDFInplaceOrMemoryString("Filter"), PDFObject::createName("FlateDecode"));
+        dictionary.addEntry(PDFInplaceOrMemoryString("Length"), PDFObject::createInteger(content.size()));
+
+        PDFObject streamObject = PDFObject::createStream(std::make_shared<PDFStream>(qMove(dictionary), qMove(content)));
+        if (isEncrypted)
+        {
+            streamObject = securityHandler->encryptObject(streamObject, streamReference);
+        }
+
+        xrefEntries.push_back({ 1, device->pos(), 0 });
+
+        PDFWriteObjectVisitor visitor(device);
+        writeObjectHeader(device, streamReference);
+        streamObject.accept(&visitor);
+        writeObjectFooter(device);
+    }
+}
+
+void PDFDocumentWriter::writeXRefStream(QIODevice* device,
+                                        PDFObjectReference reference,
+                                        const std::vector<std::array<PDFInteger, 3>>& xrefEntries,
+                                        const std::vector<PDFInteger>& index,
+                                        PDFDictionary trailerDictionary)
+{
+    Q_ASSERT(index.size() % 2 == 0);
+
+    // Determine widths of the fields, first field (entry type) has always one byte
+    PDFInteger maxField2 = 0;
+    PDFInteger maxField3 = 0;
+    for (const std::array<PDFInteger, 3>& entry : xrefEntries)
+    {
+        maxField2 = qMax(maxField2, entry[1]);
+        maxField3 = qMax(maxField3, entry[2]);
+    }
+
+    auto getByteCount = [](PDFInteger value)
+    {
+        int byteCount = 1;
+        while (value > 0xFF)
+        {
+            value >>= 8;
+            ++byteCount;
+        }
+        return byteCount;
+    };
+
+    const int field2ByteCount = getByteCount(maxField2);
+    const int field3ByteCount = getByteCount(maxField3);
+
+    QByteArray data;
+    data.reserve(xrefEntries.size() * (1 + field2ByteCount + field3ByteCount));
+
+    auto writeField = [&data](PDFInteger value, int byteCount)
+    {
+        for (int i = byteCount - 1; i >= 0; --i)
+        {
+            data.append(static_cast<char>((value >> (8 * i)) & 0xFF));
+        }
+    };
+
+    for (const std::array<PDFInteger, 3>& entry : xrefEntries)
+    {
+        writeField(entry[0], 1);
+        writeField(entry[1], field2ByteCount);
+        writeField(entry[2], field3ByteCount);
+    }
+
+    QByteArray content = PDFFlateDecodeFilter::compress(data);
+
+    std::vector<PDFObject> widths = { PDFObject::createInteger(1), PDFObject::createInteger(field2ByteCount), PDFObject::createInteger(field3ByteCount) };
+
+    // Cross-reference stream serves also as a trailer dictionary
+    PDFDictionary dictionary = qMove(trailerDictionary);
+    dictionary.addEntry(PDFInplaceOrMemoryString("Type"), PDFObject::createName("XRef"));
+    dictionary.addEntry(PDFInplaceOrMemoryString("W"), PDFObject::createArray(std::make_shared<PDFArray>(qMove(widths))));
+
+    if (!index.empty())
+    {
+        std::vector<PDFObject> indexObjects;
+        indexObjects.reserve(index.size());
+        for (PDFInteger value : index)
+        {
+            indexObjects.push_back(PDFObject::createInteger(value));
+        }
+        dictionary.addEntry(PDFInplaceOrMemoryString("Index"), PDFObject::createArray(std::make_shared<PDFArray>(qMove(indexObjects))));
+    }
+
+    dictionary.addEntry(PDFInplaceOrMemoryString("Filter"), PDFObject::createName("FlateDecode"));
+    dictionary.addEntry(PDFInplaceOrMemoryString("Length"), PDFObject::createInteger(content.size()));
+
+    // Cross-reference stream is never encrypted
+    PDFObject streamObject = PDFObject::createStream(std::make_shared<PDFStream>(qMove(dictionary), qMove(content)));
+
+    PDFWriteObjectVisitor visitor(device);
+    writeObjectHeader(device, reference);
+    streamObject.accept(&visitor);
+    writeObjectFooter(device);
+}
+
+PDFDictionary PDFDocumentWriter::createTrailerDictionary(const PDFDocument* document, PDFInteger size, PDFInteger previousXRefOffset)
+{
+    PDFDictionary dictionary;
+    dictionary.addEntry(PDFInplaceOrMemoryString("Size"), PDFObject::createInteger(size));
+
+    const PDFDictionary* trailerDictionary = document->getTrailerDictionary();
+    for (const char* entry : { "Root", "Encrypt", "Info", "ID" })
+    {
+        PDFObject object = trailerDictionary->get(entry);
+        if (!object.isNull())
+        {
+            dictionary.addEntry(PDFInplaceOrMemoryString(entry), qMove(object));
+        }
+    }
+
+    if (previousXRefOffset >= 0)
+    {
+        dictionary.addEntry(PDFInplaceOrMemoryString(PDF_XREF_TRAILER_PREVIOUS), PDFObject::createInteger(previousXRefOffset));
+    }
+
+    return dictionary;
+}
+
+void PDFDocumentWriter::writeXRefTableEntry(QIODevice* device, PDFInteger offset, PDFInteger generation, bool isOccupied)
+{
+    QString offsetString = QString::number(offset).rightJustified(10, QChar('0'), true);
+    QString generationString = QString::number(generation).rightJustified(5, QChar('0'), true);
+
+    device->write(offsetString.toLatin1());
+    device->write(" ");
+    device->write(generationString.toLatin1());
+    device->write(" ");
+    device->write(isOccupied ? "n" : "f");
+    writeCRLF(device);
 }
 
 void PDFDocumentWriter::writeCRLF(QIODevice* device)
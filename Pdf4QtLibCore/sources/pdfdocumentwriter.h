@@ -24,6 +24,8 @@
 
 #include <QIODevice>
 
+#include <array>
+
 namespace pdf
 {
 
@@ -56,6 +58,33 @@ public:
     /// \param document Document
     PDFOperationResult write(QIODevice* device, const PDFDocument* document);
 
+    /// Writes document as an incremental update of the original document. Only objects,
+    /// which differ from the original document, are appended after the original data,
+    /// together with new cross-reference section (table or stream, the same kind as
+    /// the last section of the original document) and trailer pointing to the original
+    /// cross-reference section by /Prev entry. Original data are not modified, so
+    /// existing signatures remain valid. Original file is copied to the temporary file,
+    /// update is appended and then temporary file replaces the target file (which
+    /// can be the original file), so file is never modified in place. If incremental
+    /// update is not possible (for example, encryption has been changed), error is
+    /// returned and file is not modified.
+    /// \param fileName File name
+    /// \param document Document
+    /// \param originalDocument Document, as it is stored in the original file
+    /// \param originalFileName File name of the original document
+    PDFOperationResult writeIncremental(const QString& fileName,
+                                        const PDFDocument* document,
+                                        const PDFDocument* originalDocument,
+                                        const QString& originalFileName);
+
+    /// Writes document as an incremental update of the original document. Device
+    /// must be readable, writable, random access and it must contain data
+    /// of the original document. Update is appended at the end of the device.
+    /// \param device Device with original document data
+    /// \param document Document
+    /// \param originalDocument Document, as it is stored in the device
+    PDFOperationResult writeIncremental(QIODevice* device, const PDFDocument* document, const PDFDocument* originalDocument);
+
     /// Calculates document file size, as if it is written to the disk.
     /// No file is accessed by this function; document is written
     /// to fake stream, which counts operations. If error occurs, and
@@ -72,13 +101,109 @@ public:
     /// \param object Object to be written
     static QByteArray getSerializedObject(const PDFObject& object);
 
+    /// Returns true, if object streams are written
+    bool isObjectStreamsEnabled() const { return m_objectStreamsEnabled; }
+
+    /// Enables or disables writing of object streams. If enabled, then objects,
+    /// which are not streams, are packed into object streams compressed
+    /// by flate filter, and cross-reference stream is written instead
+    /// of cross-reference table and trailer. Such document requires PDF 1.5.
+    /// \param objectStreamsEnabled Write object streams
+    void setObjectStreamsEnabled(bool objectStreamsEnabled) { m_objectStreamsEnabled = objectStreamsEnabled; }
+
+    /// Returns maximal number of objects in one object stream
+    int getObjectsPerStream() const { return m_objectsPerStream; }
+
+    /// Sets maximal number of objects in one object stream
+    /// \param objectsPerStream Maximal number of objects in one object stream
+    void setObjectsPerStream(int objectsPerStream) { m_objectsPerStream = qBound(1, objectsPerStream, MAX_OBJECTS_PER_STREAM); }
+
+    static constexpr int DEFAULT_OBJECTS_PER_STREAM = 100;
+    static constexpr int MAX_OBJECTS_PER_STREAM = 65535;
+
 private:
     static void writeCRLF(QIODevice* device);
     static void writeObjectHeader(QIODevice* device, PDFObjectReference reference);
     static void writeObjectFooter(QIODevice* device);
 
+    /// Writes document to the output device. Exception is thrown, if error occurs.
+    /// \param device Output device
+    /// \param document Document
+    void writeDocument(QIODevice* device, const PDFDocument* document) const;
+
+    /// Writes object streams containing given objects. Objects are appended to the document,
+    /// their object numbers start at \p objectNumber. Cross-reference entries of compressed
+    /// objects and object streams are filled.
+    /// \param device Output device
+    /// \param document Document
+    /// \param compressedObjects Object numbers of objects to be compressed
+    /// \param objectNumber Object number of the first object stream
+    /// \param xrefEntries Cross-reference entries
+    void writeObjectStreams(QIODevice* device,
+                            const PDFDocument* document,
+                            const std::vector<PDFInteger>& compressedObjects,
+                            PDFInteger objectNumber,
+                            std::vector<std::array<PDFInteger, 3>>& xrefEntries) const;
+
+    /// Writes document as an incremental update. Exception is thrown, if error occurs.
+    /// \param device Output device, positioned at the end of original data
+    /// \param document Document
+    /// \param originalDocument Original document
+    /// \param originalXRefOffset Offset of the last cross-reference section of original data
+    /// \param isOriginalXRefStream Is last cross-reference section of original data a stream?
+    /// Writes document as an incremental update of the original document. Original
+    /// data are read from \p originalDevice, which must be readable and random access,
+    /// update is written to \p device. If devices are different, then \p device must
+    /// already contain copy of the original data and it must be positioned at its end.
+    /// \param originalDevice Device with original document data
+    /// \param device Output device
+    /// \param document Document
+    /// \param originalDocument Document, as it is stored in the original device
+    PDFOperationResult writeIncremental(QIODevice* originalDevice,
+                                        QIODevice* device,
+                                        const PDFDocument* document,
+                                        const PDFDocument* originalDocument);
+
+    void writeIncrementalUpdate(QIODevice* device,
+                                const PDFDocument* document,
+                                const PDFDocument* originalDocument,
+                                PDFInteger originalXRefOffset,
+                                bool isOriginalXRefStream) const;
+
+    /// Creates trailer dictionary with entries from document's trailer dictionary
+    /// \param document Document
+    /// \param size Number of cross-reference entries (/Size entry)
+    /// \param previousXRefOffset Offset of previous cross-reference section (/Prev entry), or -1
+    static PDFDictionary createTrailerDictionary(const PDFDocument* document, PDFInteger size, PDFInteger previousXRefOffset);
+
+    /// Writes one entry of cross-reference table
+    /// \param device Output device
+    /// \param offset Offset of the object (or next free object number)
+    /// \param generation Generation number
+    /// \param isOccupied Is entry occupied (not free)?
+    static void writeXRefTableEntry(QIODevice* device, PDFInteger offset, PDFInteger generation, bool isOccupied);
+
+    /// Writes cross-reference stream with trailer entries
+    /// \param device Output device
+    /// \param reference Reference of cross-reference stream
+    /// \param xrefEntries Cross-reference entries
+    /// \param index Pairs of first object number and entry count of subsections, if empty, then
+    ///        entries form one subsection starting at zero object number
+    /// \param trailerDictionary Trailer dictionary
+    static void writeXRefStream(QIODevice* device,
+                                PDFObjectReference reference,
+                                const std::vector<std::array<PDFInteger, 3>>& xrefEntries,
+                                const std::vector<PDFInteger>& index,
+                                PDFDictionary trailerDictionary);
+
     /// Progress indicator
     PDFProgress* m_progress;
+
+    /// Write object streams and cross-reference stream
+    bool m_objectStreamsEnabled = false;
+
+    /// Maximal number of objects in one object stream
+    int m_objectsPerStream = DEFAULT_OBJECTS_PER_STREAM;
 };
 
 }   // namespace pdf
@@ -17,14 +17,122 @@
 
 #include "pdfexecutionpolicy.h"
 
+#include <QMutex>
 #include <QThread>
+#include <QWaitCondition>
 #include <QCoreApplication>
 
 #include "pdfdbgheap.h"
 
+#include <atomic>
+#include <memory>
+#include <exception>
+#include <algorithm>
+
 namespace pdf
 {
 
+/// Parallel job processed by the work-stealing scheduler. Range of items [0, count)
+/// is distributed into slots, each participating thread owns one slot (if there
+/// is a free slot). Participant takes chunks of items from the front of its own slot,
+/// and when its slot is empty, it steals back half of the largest slot. Participants
+/// without a slot take chunks directly from the back of the largest slot.
+/// Job started from an item of another job remembers that job as its parent.
+/// Parent job always outlives its nested jobs, because the item starting
+/// the nested job waits until the nested job is finished.
+class PDFExecutionPolicyJob
+{
+public:
+    explicit PDFExecutionPolicyJob(const std::function<void(size_t, size_t)>* function, size_t count, size_t maxChunkSize, const PDFExecutionPolicyJob* parent, int slotCount) :
+        m_function(function),
+        m_count(count),
+        m_maxChunkSize(maxChunkSize),
+        m_parent(parent),
+        m_depth(parent ? parent->getDepth() + 1 : 0),
+        m_slotCount(slotCount),
+        m_slots(std::make_unique<Slot[]>(slotCount)),
+        m_nextSlot(1),
+        m_remaining(count),
+        m_completed(0)
+    {
+        // Whole range is initially in the slot of the calling thread
+        m_slots[0].end = count;
+    }
+
+    /// Returns slot index for a new participant, or -1, if there is no free slot
+    int acquireSlot();
+
+    /// Processes items of the job, until there are no items to be taken
+    /// \param slotIndex Slot index of the participant (can be -1)
+    void participate(int slotIndex);
+
+    /// Returns true, if some items are not yet taken by any participant
+    bool hasWork() const { return m_remaining.load(std::memory_order_acquire) > 0; }
+
+    /// Returns true, if all items were processed
+    bool isFinished() const { return m_completed.load(std::memory_order_acquire) == m_count; }
+
+    int getDepth() const { return m_depth; }
+
+    /// Returns true, if this job was started (directly or indirectly)
+    /// from items of job \p job, or if it is the job \p job itself.
+    /// \param job Job
+    bool isDescendantOf(const PDFExecutionPolicyJob* job) const;
+
+    /// Rethrows the exception, if some item has thrown it
+    void rethrowException();
+
+private:
+    struct Slot
+    {
+        QMutex mutex;
+        size_t begin = 0;
+        size_t end = 0;
+    };
+
+    bool takeChunk(int slotIndex, size_t& begin, size_t& end);
+    void process(size_t begin, size_t end);
+    size_t getChunkSize(size_t size) const;
+
+    const std::function<void(size_t, size_t)>* m_function;
+    size_t m_count;
+    size_t m_maxChunkSize;
+    const PDFExecutionPolicyJob* m_parent;
+    int m_depth;
+    int m_slotCount;
+    std::unique_ptr<Slot[]> m_slots;
+    std::atomic<int> m_nextSlot;
+
+    /// Number of items not yet taken by any participant
+    std::atomic<size_t> m_remaining;
+
+    /// Number of processed items
+    std::atomic<size_t> m_completed;
+
+    QMutex m_exceptionMutex;
+    std::exception_ptr m_exception;
+};
+
+using PDFExecutionPolicyJobPointer = std::shared_ptr<PDFExecutionPolicyJob>;
+
+/// Helper thread of the work-stealing scheduler. It participates on its job, and
+/// then on jobs nested in its job, until no such work is available. Jobs
+/// of unrelated callers are never processed by the helper.
+class PDFExecutionPolicyHelper : public QRunnable
+{
+public:
+    explicit inline PDFExecutionPolicyHelper(PDFExecutionPolicyJobPointer job) :
+        m_job(std::move(job))
+    {
+        setAutoDelete(true);
+    }
+
+    virtual void run() override;
+
+private:
+    PDFExecutionPolicyJobPointer m_job;
+};
+
 struct PDFExecutionPolicyHolder
 {
     PDFExecutionPolicyHolder()
@@ -37,11 +145,275 @@ struct PDFExecutionPolicyHolder
         primary.waitForDone();
     }
 
+    /// Registers a new job, so other threads can participate on it
+    void registerJob(PDFExecutionPolicyJobPointer job);
+
+    /// Unregisters finished job
+    void unregisterJob(const PDFExecutionPolicyJob* job);
+
+    /// Wakes up threads waiting for a finished job
+    void notifyJobFinished();
+
+    /// Finds registered job with remaining work, which is nested
+    /// in job \p ancestor (or is \p ancestor itself). Deepest job is preferred.
+    /// \param ancestor Ancestor job
+    PDFExecutionPolicyJobPointer findJob(const PDFExecutionPolicyJob* ancestor);
+
+    /// Waits until job is finished, helping meanwhile only with jobs nested
+    /// in this job. Jobs of unrelated callers are never processed, so calling
+    /// thread doesn't execute work it didn't start.
+    /// \param job Job
+    void waitForJob(PDFExecutionPolicyJob* job);
+
     PDFExecutionPolicy policy;
     QThreadPool primary;
     QThreadPool auxiliary;
+
+    QMutex jobsMutex;
+    QWaitCondition jobsCondition;
+    std::vector<PDFExecutionPolicyJobPointer> jobs;
 } s_execution_policy;
 
+/// Job, whose items are processed by current thread (nullptr, if none)
+static thread_local const PDFExecutionPolicyJob* s_currentJob = nullptr;
+
+int PDFExecutionPolicyJob::acquireSlot()
+{
+    const int slotIndex = m_nextSlot.fetch_add(1, std::memory_order_relaxed);
+    return slotIndex < m_slotCount ? slotIndex : -1;
+}
+
+void PDFExecutionPolicyJob::participate(int slotIndex)
+{
+    const PDFExecutionPolicyJob* oldJob = s_currentJob;
+    s_currentJob = this;
+
+    size_t begin = 0;
+    size_t end = 0;
+    while (takeChunk(slotIndex, begin, end))
+    {
+        process(begin, end);
+    }
+
+    s_currentJob = oldJob;
+}
+
+bool PDFExecutionPolicyJob::isDescendantOf(const PDFExecutionPolicyJob* job) const
+{
+    for (const PDFExecutionPolicyJob* current = this; current; current = current->m_parent)
+    {
+        if (current == job)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void PDFExecutionPolicyJob::rethrowException()
+{
+    if (m_exception)
+    {
+        std::rethrow_exception(m_exception);
+    }
+}
+
+size_t PDFExecutionPolicyJob::getChunkSize(size_t size) const
+{
+    // Guided chunking - chunks are smaller, as less items remain,
+    // so load is balanced at the end of the job.
+    return qBound(size_t(1), size / (2 * size_t(m_slotCount)), m_maxChunkSize);
+}
+
+bool PDFExecutionPolicyJob::takeChunk(int slotIndex, size_t& begin, size_t& end)
+{
+    while (true)
+    {
+        if (slotIndex >= 0)
+        {
+            Slot& slot = m_slots[slotIndex];
+            QMutexLocker lock(&slot.mutex);
+
+            if (slot.begin < slot.end)
+            {
+                const size_t chunkSize = getChunkSize(slot.end - slot.begin);
+                begin = slot.begin;
+                end = begin + chunkSize;
+                slot.begin = end;
+                m_remaining.fetch_sub(chunkSize, std::memory_order_acq_rel);
+                return true;
+            }
+        }
+
+        if (!hasWork())
+        {
+            return false;
+        }
+
+        // Find victim with the largest range. Sizes are read without
+        // locking, we check them again under the lock.
+        int victimIndex = -1;
+        size_t victimSize = 0;
+        for (int i = 0; i < m_slotCount; ++i)
+        {
+            Slot& slot = m_slots[i];
+            QMutexLocker lock(&slot.mutex);
+            const size_t size = slot.end - slot.begin;
+            if (size > victimSize)
+            {
+                victimSize = size;
+                victimIndex = i;
+            }
+        }
+
+        if (victimIndex == -1)
+        {
+            // Stolen range is being moved to another slot, try again
+            QThread::yieldCurrentThread();
+            continue;
+        }
+
+        size_t stolenBegin = 0;
+        size_t stolenEnd = 0;
+
+        {
+            Slot& victim = m_slots[victimIndex];
+            QMutexLocker lock(&victim.mutex);
+
+            const size_t size = victim.end - victim.begin;
+            if (size == 0)
+            {
+                continue;
+            }
+
+            if (slotIndex < 0 || slotIndex == victimIndex || size == 1)
+            {
+                // Take chunk directly from the back of the victim's range
+                const size_t chunkSize = getChunkSize(size);
+                end = victim.end;
+                begin = end - chunkSize;
+                victim.end = begin;
+                m_remaining.fetch_sub(chunkSize, std::memory_order_acq_rel);
+                return true;
+            }
+
+            // Steal back half of the victim's range
+            stolenEnd = victim.end;
+            stolenBegin = victim.begin + size / 2;
+            victim.end = stolenBegin;
+        }
+
+        Slot& slot = m_slots[slotIndex];
+        QMutexLocker lock(&slot.mutex);
+        Q_ASSERT(slot.begin == slot.end);
+        slot.begin = stolenBegin;
+        slot.end = stolenEnd;
+    }
+
+    return false;
+}
+
+void PDFExecutionPolicyJob::process(size_t begin, size_t end)
+{
+    try
+    {
+        (*m_function)(begin, end);
+    }
+    catch (...)
+    {
+        QMutexLocker lock(&m_exceptionMutex);
+        if (!m_exception)
+        {
+            m_exception = std::current_exception();
+        }
+    }
+
+    const size_t count = end - begin;
+    if (m_completed.fetch_add(count, std::memory_order_acq_rel) + count == m_count)
+    {
+        s_execution_policy.notifyJobFinished();
+    }
+}
+
+void PDFExecutionPolicyHelper::run()
+{
+    m_job->participate(m_job->acquireSlot());
+
+    // Help with jobs nested in our job, until there is no work
+    while (PDFExecutionPolicyJobPointer job = s_execution_policy.findJob(m_job.get()))
+    {
+        job->participate(job->acquireSlot());
+    }
+
+    m_job.reset();
+}
+
+void PDFExecutionPolicyHolder::registerJob(PDFExecutionPolicyJobPointer job)
+{
+    QMutexLocker lock(&jobsMutex);
+    jobs.push_back(std::move(job));
+    jobsCondition.wakeAll();
+}
+
+void PDFExecutionPolicyHolder::unregisterJob(const PDFExecutionPolicyJob* job)
+{
+    QMutexLocker lock(&jobsMutex);
+    auto it = std::find_if(jobs.begin(), jobs.end(), [job](const PDFExecutionPolicyJobPointer& item) { return item.get() == job; });
+    if (it != jobs.end())
+    {
+        jobs.erase(it);
+    }
+}
+
+void PDFExecutionPolicyHolder::notifyJobFinished()
+{
+    QMutexLocker lock(&jobsMutex);
+    jobsCondition.wakeAll();
+}
+
+PDFExecutionPolicyJobPointer PDFExecutionPolicyHolder::findJob(const PDFExecutionPolicyJob* ancestor)
+{
+    QMutexLocker lock(&jobsMutex);
+
+    PDFExecutionPolicyJobPointer result;
+    for (const PDFExecutionPolicyJobPointer& job : jobs)
+    {
+        if (job->hasWork() && (!result || job->getDepth() > result->getDepth()) && job->isDescendantOf(ancestor))
+        {
+            result = job;
+        }
+    }
+
+    return result;
+}
+
+void PDFExecutionPolicyHolder::waitForJob(PDFExecutionPolicyJob* job)
+{
+    auto hasNestedWork = [this, job]()
+    {
+        return std::any_of(jobs.cbegin(), jobs.cend(), [job](const PDFExecutionPolicyJobPointer& item) { return item->hasWork() && item->isDescendantOf(job); });
+    };
+
+    while (!job->isFinished())
+    {
+        // Items of our job are being processed by other threads. These items can
+        // start nested jobs, so we help with them (only jobs nested in our job),
+        // instead of blocking. Depth is increasing, so recursion is bounded.
+        if (PDFExecutionPolicyJobPointer nestedJob = findJob(job))
+        {
+            nestedJob->participate(nestedJob->acquireSlot());
+            continue;
+        }
+
+        QMutexLocker lock(&jobsMutex);
+        while (!job->isFinished() && !hasNestedWork())
+        {
+            jobsCondition.wait(&jobsMutex);
+        }
+    }
+}
+
 void PDFExecutionPolicy::setStrategy(Strategy strategy)
 {
     s_execution_policy.policy.m_strategy.store(strategy, std::memory_order_relaxed);
@@ -117,6 +489,53 @@ void PDFExecutionPolicy::endProcessingContentStream()
     --s_execution_policy.policy.m_contentStreamsCount;
 }
 
+void PDFExecutionPolicy::executeParallel(Scope scope, size_t count, const std::function<void(size_t, size_t)>& function)
+{
+    if (count == 0)
+    {
+        return;
+    }
+
+    if (count == 1)
+    {
+        function(0, 1);
+        return;
+    }
+
+    QThreadPool* pool = getThreadPool(scope);
+    const int helperCount = static_cast<int>(qMin(static_cast<size_t>(qMax(pool->maxThreadCount(), 1)), count - 1));
+
+    // For page scope, we do not divide the tasks into chunks, i.e. each chunk
+    // will have size 1. But if we are in a content scope, then we are processing
+    // smaller tasks, so chunk size is adapted to the count of remaining items.
+    const size_t maxChunkSize = (scope == Scope::Page) ? 1 : count;
+
+    // Few extra slots are reserved for threads helping from ancestor jobs
+    const int slotCount = helperCount + 1 + 4;
+    PDFExecutionPolicyJobPointer job = std::make_shared<PDFExecutionPolicyJob>(&function, count, maxChunkSize, s_currentJob, slotCount);
+    s_execution_policy.registerJob(job);
+
+    // Start helpers only on free threads. If thread pool is busy, then threads
+    // working on ancestor jobs will help with this job, when they run out of work.
+    for (int i = 0; i < helperCount; ++i)
+    {
+        PDFExecutionPolicyHelper* helper = new PDFExecutionPolicyHelper(job);
+        if (!pool->tryStart(helper))
+        {
+            delete helper;
+            break;
+        }
+    }
+
+    // Calling thread participates on the job and then helps
+    // with nested jobs, until all items are processed.
+    job->participate(0);
+    s_execution_policy.waitForJob(job.get());
+    s_execution_policy.unregisterJob(job.get());
+
+    job->rethrowException();
+}
+
 void PDFExecutionPolicy::finalize()
 {
     s_execution_policy.auxiliary.waitForDone();
@@ -20,11 +20,14 @@
 
 #include "pdfglobal.h"
 
-#include <QSemaphore>
 #include <QThreadPool>
 
 #include <atomic>
+#include <vector>
+#include <iterator>
 #include <execution>
+#include <functional>
+#include <type_traits>
 
 namespace pdf
 {
@@ -59,77 +62,60 @@ public:
     /// \param scope Scope for which we want to determine execution policy
     static bool isParallelizing(Scope scope);
 
-    template<typename ForwardIt, typename UnaryFunction>
-    class Runnable : public QRunnable
-    {
-    public:
-        explicit inline Runnable(ForwardIt it, ForwardIt itEnd, UnaryFunction* function, QSemaphore* semaphore) :
-            m_forwardIt(qMove(it)),
-            m_forwardItEnd(qMove(itEnd)),
-            m_function(function),
-            m_semaphore(semaphore),
-            m_packSize(static_cast<int>(std::distance(m_forwardIt, m_forwardItEnd)))
-        {
-            setAutoDelete(true);
-        }
-
-        virtual void run() override
-        {
-            QSemaphoreReleaser semaphoreReleaser(m_semaphore, m_packSize);
-            for (auto it = m_forwardIt; it != m_forwardItEnd; ++it)
-            {
-                (*m_function)(*it);
-            }
-        }
-
-    private:
-        ForwardIt m_forwardIt;
-        ForwardIt m_forwardItEnd;
-        UnaryFunction* m_function;
-        QSemaphore* m_semaphore;
-        int m_packSize;
-    };
-
+    /// Executes function \p f for each item in the range [first, last). If scope is
+    /// parallelized, then items are processed by a work-stealing scheduler: calling thread
+    /// processes items itself, while helper threads from the thread pool steal halves
+    /// of the remaining ranges. When calling thread runs out of work, it helps
+    /// with nested work (started from the items being processed), instead of blocking
+    /// the thread. So nested calls of this function are safe and do not block
+    /// pool threads. Exception thrown by \p f is rethrown in the calling thread,
+    /// after all items are processed.
+    /// \param scope Scope
+    /// \param first First item
+    /// \param last Last item (end iterator)
+    /// \param f Function to be executed for each item
     template<typename ForwardIt, typename UnaryFunction>
     static void execute(Scope scope, ForwardIt first, ForwardIt last, UnaryFunction f)
     {
         if (isParallelizing(scope))
         {
-            QSemaphore semaphore(0);
-            int count = static_cast<int>(std::distance(first, last));
-            int remainder = count;
-
-            int bucketSize = 1;
+            using IteratorCategory = typename std::iterator_traits<ForwardIt>::iterator_category;
 
-            // For page scope, we do not divide the tasks into buckets, i.e.
-            // each bucket will have size 1. But if we are in a content scope,
-            // then we are processing smaller task, so we divide the work
-            // into buckets of appropriate size.
-            if (scope != Scope::Page)
+            if constexpr (std::is_base_of_v<std::random_access_iterator_tag, IteratorCategory>)
             {
-                const int buckets = 8 * QThread::idealThreadCount();
-                bucketSize = qMax(1, count / buckets);
+                const size_t count = static_cast<size_t>(std::distance(first, last));
+                auto processRange = [first, &f](size_t begin, size_t end)
+                {
+                    auto it = std::next(first, begin);
+                    auto itEnd = std::next(first, end);
+                    for (; it != itEnd; ++it)
+                    {
+                        f(*it);
+                    }
+                };
+
+                executeParallel(scope, count, processRange);
             }
-
-            QThreadPool* pool = getThreadPool(scope);
-
-            // Divide tasks into buckets with given bucket size
-            auto it = first;
-            while (remainder > 0)
+            else
             {
-                const int currentSize = qMin(remainder, bucketSize);
-
-                auto itStart = it;
-                auto itEnd = std::next(it, currentSize);
-                pool->start(new Runnable(itStart, itEnd, &f, &semaphore));
-
-                remainder -= currentSize;
-                std::advance(it, currentSize);
+                // We must be able to split the range, so we store
+                // the iterators, if they are not random access.
+                std::vector<ForwardIt> iterators;
+                for (auto it = first; it != last; ++it)
+                {
+                    iterators.push_back(it);
+                }
+
+                auto processRange = [&iterators, &f](size_t begin, size_t end)
+                {
+                    for (size_t i = begin; i < end; ++i)
+                    {
+                        f(*iterators[i]);
+                    }
+                };
+
+                executeParallel(scope, iterators.size(), processRange);
             }
-
-            Q_ASSERT(it == last);
-
-            semaphore.acquire(count);
         }
         else
         {
@@ -173,6 +159,13 @@ public:
 private:
     friend struct PDFExecutionPolicyHolder;
 
+    /// Processes range of indices [0, count) by the work-stealing scheduler. Function
+    /// \p function is called with subranges [begin, end) from multiple threads.
+    /// \param scope Scope
+    /// \param count Count of items
+    /// \param function Function processing subrange of items
+    static void executeParallel(Scope scope, size_t count, const std::function<void(size_t, size_t)>& function);
+
     /// Returns thread pool based on scope
     static QThreadPool* getThreadPool(Scope scope);
 
@@ -48,6 +48,11 @@
 #pragma comment(lib, "User32")
 #endif
 
+#include <map>
+#include <tuple>
+#include <atomic>
+#include <memory>
+
 namespace pdf
 {
 
@@ -118,7 +123,9 @@ public:
     /// Returns instance of storage
     static const PDFSystemFontInfoStorage* getInstance();
 
-    /// Loads font from descriptor
+    /// Loads font from descriptor. Result of the font substitution is cached
+    /// for the whole process, so font matching is performed only once for the
+    /// same font traits, and font data are shared by all documents.
     /// \param descriptor Descriptor describing the font
     QByteArray loadFont(const CIDSystemInfo* cidSystemInfo,
                         const FontDescriptor* descriptor,
@@ -128,6 +135,34 @@ public:
 private:
     explicit PDFSystemFontInfoStorage();
 
+    /// Traits of the font, which are used in the font substitution
+    using SubstitutionKey = std::tuple<QByteArray, QByteArray, QByteArray, QByteArray, int, PDFReal, PDFInteger, PDFReal, StandardFontType>;
+
+    struct SubstitutionResult
+    {
+        QByteArray fontData;
+        std::vector<std::pair<RenderErrorType, QString>> warnings;
+    };
+
+    /// Loaded font file. Font file is memory mapped, if possible,
+    /// and font data are a view of the mapped memory.
+    struct FontFile
+    {
+        std::unique_ptr<QFile> file;
+        QByteArray fontData;
+    };
+
+    /// Performs font substitution
+    /// \param descriptor Descriptor describing the font
+    QByteArray loadFontSubstitution(const CIDSystemInfo* cidSystemInfo,
+                                    const FontDescriptor* descriptor,
+                                    StandardFontType standardFontType,
+                                    PDFRenderErrorReporter* reporter) const;
+
+    /// Returns data of the font file. Each font file is loaded only once.
+    /// \param fileName Font file name
+    QByteArray getFontFileData(const QString& fileName) const;
+
     /// Loads font from descriptor
     /// \param descriptor Descriptor describing the font
     QByteArray loadFontImpl(const FontDescriptor* descriptor,
@@ -166,6 +201,12 @@ private:
 
     std::vector<FontInfo> m_fontInfos;
 #endif
+
+    /// Mutex guarding the caches. It is not held during font matching and
+    /// loading of the font files, only while caches are accessed.
+    mutable QMutex m_mutex;
+    mutable std::map<SubstitutionKey, SubstitutionResult> m_substitutions;
+    mutable std::map<QString, FontFile> m_fontFiles;
 };
 
 const PDFSystemFontInfoStorage* PDFSystemFontInfoStorage::getInstance()
@@ -178,6 +219,73 @@ QByteArray PDFSystemFontInfoStorage::loadFont(const CIDSystemInfo* cidSystemInfo
                                               const FontDescriptor* descriptor,
                                               StandardFontType standardFontType,
                                               PDFRenderErrorReporter* reporter) const
+{
+    /// Reporter recording warnings of the font substitution,
+    /// so they can be reported again, when cached result is used.
+    class PDFRecordingRenderErrorReporter : public PDFRenderErrorReporter
+    {
+    public:
+        explicit PDFRecordingRenderErrorReporter(std::vector<std::pair<RenderErrorType, QString>>& errors) :
+            m_errors(errors)
+        {
+
+        }
+
+        virtual void reportRenderError(RenderErrorType type, QString message) override
+        {
+            m_errors.emplace_back(type, qMove(message));
+        }
+
+        virtual void reportRenderErrorOnce(RenderErrorType type, QString message) override
+        {
+            reportRenderError(type, qMove(message));
+        }
+
+    private:
+        std::vector<std::pair<RenderErrorType, QString>>& m_errors;
+    };
+
+    SubstitutionKey key(cidSystemInfo->registry, cidSystemInfo->ordering, descriptor->fontName, descriptor->fontFamily,
+                        static_cast<int>(descriptor->fontStretch), descriptor->fontWeight, descriptor->flags,
+                        descriptor->italicAngle, standardFontType);
+
+    SubstitutionResult result;
+    bool isCached = false;
+
+    {
+        QMutexLocker lock(&m_mutex);
+        auto it = m_substitutions.find(key);
+        if (it != m_substitutions.end())
+        {
+            result = it->second;
+            isCached = true;
+        }
+    }
+
+    if (!isCached)
+    {
+        // Font substitution (font matching and reading of the font file) is
+        // performed without the lock, so fonts can be realized in parallel. If
+        // another thread has stored the result meanwhile, its result is used.
+        PDFRecordingRenderErrorReporter recordingReporter(result.warnings);
+        result.fontData = loadFontSubstitution(cidSystemInfo, descriptor, standardFontType, &recordingReporter);
+
+        QMutexLocker lock(&m_mutex);
+        result = m_substitutions.emplace(qMove(key), qMove(result)).first->second;
+    }
+
+    for (const auto& warning : result.warnings)
+    {
+        reporter->reportRenderError(warning.first, warning.second);
+    }
+
+    return result.fontData;
+}
+
+QByteArray PDFSystemFontInfoStorage::loadFontSubstitution(const CIDSystemInfo* cidSystemInfo,
+                                                          const FontDescriptor* descriptor,
+                                                          StandardFontType standardFontType,
+                                                          PDFRenderErrorReporter* reporter) const
 {
     QString fontName;
 
@@ -452,10 +560,7 @@ QByteArray PDFSystemFontInfoStorage::loadFontImpl(const FontDescriptor* descript
         FcChar8* s = nullptr;
         if (FcPatternGetString(match, FC_FILE, 0, &s) == FcResultMatch)
         {
-            QFile f(QString::fromUtf8(reinterpret_cast<char*>(s)));
-            f.open(QIODevice::ReadOnly);
-            result = f.readAll();
-            f.close();
+            result = getFontFileData(QString::fromUtf8(reinterpret_cast<char*>(s)));
         }
     }
 
@@ -469,6 +574,42 @@ QByteArray PDFSystemFontInfoStorage::loadFontImpl(const FontDescriptor* descript
 #endif
 }
 
+QByteArray PDFSystemFontInfoStorage::getFontFileData(const QString& fileName) const
+{
+    {
+        QMutexLocker lock(&m_mutex);
+        auto it = m_fontFiles.find(fileName);
+        if (it != m_fontFiles.end())
+        {
+            return it->second.fontData;
+        }
+    }
+
+    // Font file is loaded without the lock. If another thread has loaded
+    // the same file meanwhile, its data are used and our file is released.
+    FontFile fontFile;
+    fontFile.file = std::make_unique<QFile>(fileName);
+
+    if (fontFile.file->open(QIODevice::ReadOnly))
+    {
+        // Font files are never modified by us, so we can map them
+        // into the memory and let the system share the pages.
+        const qint64 size = fontFile.file->size();
+        if (uchar* data = size > 0 ? fontFile.file->map(0, size) : nullptr)
+        {
+            fontFile.fontData = QByteArray::fromRawData(reinterpret_cast<const char*>(data), size);
+        }
+        else
+        {
+            fontFile.fontData = fontFile.file->readAll();
+            fontFile.file->close();
+        }
+    }
+
+    QMutexLocker lock(&m_mutex);
+    return m_fontFiles.emplace(fileName, qMove(fontFile)).first->second.fontData;
+}
+
 PDFSystemFontInfoStorage::PDFSystemFontInfoStorage()
 {
 #ifdef Q_OS_WIN
@@ -749,7 +890,7 @@ void PDFRealizedFontImpl::fillTextSequence(const QByteArray& byteArray, TextSequ
                 if (glyphIndex)
                 {
                     const Glyph& glyph = getGlyph(glyphIndex);
-                    textSequence.items.emplace_back(&glyph.glyph, (*encoding)[static_cast<uint8_t>(byteArray[i])], glyph.advance);
+                    textSequence.items.emplace_back(&glyph.glyph, (*encoding)[static_cast<uint8_t>(byteArray[i])], glyph.advance, glyphIndex);
                 }
                 else
                 {
@@ -784,7 +925,7 @@ void PDFRealizedFontImpl::fillTextSequence(const QByteArray& byteArray, TextSequ
                 {
                     QChar character = toUnicode->getToUnicode(cid);
                     const Glyph& glyph = getGlyph(glyphIndex);
-                    textSequence.items.emplace_back(&glyph.glyph, character, glyph.advance);
+                    textSequence.items.emplace_back(&glyph.glyph, character, glyph.advance, glyphIndex);
                 }
                 else
                 {
@@ -1107,6 +1248,13 @@ void PDFRealizedFontImpl::checkFreeTypeError(FT_Error error)
     }
 }
 
+PDFRealizedFont::PDFRealizedFont(IRealizedFontImpl* impl) :
+    m_impl(impl)
+{
+    static std::atomic<quint64> s_instanceCounter = 0;
+    m_instanceId = ++s_instanceCounter;
+}
+
 PDFRealizedFont::~PDFRealizedFont()
 {
     delete m_impl;
@@ -70,7 +70,7 @@ public:
 struct TextSequenceItem
 {
     inline explicit TextSequenceItem() = default;
-    inline explicit TextSequenceItem(const QPainterPath* glyph, QChar character, PDFReal advance) : glyph(glyph), character(character), advance(advance) { }
+    inline explicit TextSequenceItem(const QPainterPath* glyph, QChar character, PDFReal advance, GID glyphIndex = 0) : glyph(glyph), character(character), advance(advance), glyphIndex(glyphIndex) { }
     inline explicit TextSequenceItem(PDFReal advance) : character(), advance(advance) { }
     inline explicit TextSequenceItem(const QByteArray* characterContentStream, QChar character, PDFReal advance) : characterContentStream(characterContentStream), character(character), advance(advance) { }
 
@@ -83,6 +83,7 @@ struct TextSequenceItem
     const QByteArray* characterContentStream = nullptr;
     QChar character;
     PDFReal advance = 0;
+    GID glyphIndex = 0; ///< Index of the glyph in the realized font (zero, if unknown)
 };
 
 struct TextSequence
@@ -279,15 +280,21 @@ public:
     /// Returns character info
     CharacterInfos getCharacterInfos() const;
 
+    /// Returns identifier of this realized font. Identifiers are never reused,
+    /// so identifier together with glyph index can be used as a key in caches
+    /// of rasterized glyphs.
+    quint64 getInstanceId() const { return m_instanceId; }
+
     /// Creates new realized font from the standard font. If font can't be created,
     /// then exception is thrown.
     static PDFRealizedFontPointer createRealizedFont(PDFFontPointer font, PDFReal pixelSize, PDFRenderErrorReporter* reporter);
 
 private:
     /// Constructs new realized font
-    explicit PDFRealizedFont(IRealizedFontImpl* impl) : m_impl(impl) { }
+    explicit PDFRealizedFont(IRealizedFontImpl* impl);
 
     IRealizedFontImpl* m_impl;
+    quint64 m_instanceId;
 };
 
 /// Base  class representing font in the PDF file
@@ -27,7 +27,9 @@
 
 #include "pdfdbgheap.h"
 
+#include <array>
 #include <stack>
+#include <cstring>
 #include <iterator>
 #include <type_traits>
 
@@ -49,6 +51,191 @@ PDFFunctionPtr PDFFunction::createFunction(const PDFDocument* document, const PD
     return createFunctionImpl(document, object, &context);
 }
 
+PDFFunctionPtr PDFFunction::createSampledApproximation(const PDFFunctionPtr& function, PDFReal tolerance)
+{
+    static constexpr uint32_t MAX_INPUT_COUNT = 4;
+    static constexpr size_t MAX_NODE_COUNT = 16384;
+    static constexpr size_t MAX_VALIDATION_POINT_COUNT = 262144;
+
+    // Only PostScript functions are expensive enough to be approximated. Other
+    // function types are cheap, and stitching functions can contain narrow
+    // features, which would be lost in the approximation.
+    if (!function || function->m_m == 0 || function->m_m > MAX_INPUT_COUNT || function->m_n == 0 ||
+        function->m_domain.size() != 2 * function->m_m || !dynamic_cast<const PDFPostScriptFunction*>(function.get()))
+    {
+        return function;
+    }
+
+    const uint32_t m = function->m_m;
+    const uint32_t n = function->m_n;
+    const std::vector<PDFReal>& domain = function->m_domain;
+
+    for (uint32_t i = 0; i < m; ++i)
+    {
+        if (!std::isfinite(domain[2 * i]) || !std::isfinite(domain[2 * i + 1]) || domain[2 * i] >= domain[2 * i + 1])
+        {
+            return function;
+        }
+    }
+
+    std::vector<PDFReal> x(m, 0.0);
+    std::vector<PDFReal> y(n, 0.0);
+    std::vector<PDFReal> yApproximation(n, 0.0);
+
+    // Calls the callback for each point of the grid with pointCount points in each dimension,
+    // point with index i has coordinate (i + offset) / intervals, mapped to the domain.
+    auto forEachGridPoint = [&](size_t pointCount, PDFReal offset, size_t intervals, const auto& callback)
+    {
+        size_t totalPointCount = 1;
+        for (uint32_t i = 0; i < m; ++i)
+        {
+            totalPointCount *= pointCount;
+        }
+
+        for (size_t point = 0; point < totalPointCount; ++point)
+        {
+            size_t remainder = point;
+            for (uint32_t i = 0; i < m; ++i)
+            {
+                const size_t index = remainder % pointCount;
+                remainder /= pointCount;
+                x[i] = mix((index + offset) / intervals, domain[2 * i], domain[2 * i + 1]);
+            }
+
+            if (!callback())
+            {
+                return false;
+            }
+        }
+
+        return true;
+    };
+
+    for (size_t intervals = 4; ; intervals *= 2)
+    {
+        const size_t nodeCount = intervals + 1;
+        size_t totalNodeCount = 1;
+        for (uint32_t i = 0; i < m; ++i)
+        {
+            totalNodeCount *= nodeCount;
+        }
+
+        if (totalNodeCount > MAX_NODE_COUNT)
+        {
+            break;
+        }
+
+        // Approximation is validated on the grid, which is denser than the grid of samples,
+        // so features of the function between the samples are detected.
+        size_t validationIntervals = 0;
+        for (const size_t factor : { 8, 4, 2 })
+        {
+            size_t totalValidationPointCount = 1;
+            for (uint32_t i = 0; i < m; ++i)
+            {
+                totalValidationPointCount *= intervals * factor;
+            }
+
+            if (totalValidationPointCount <= MAX_VALIDATION_POINT_COUNT)
+            {
+                validationIntervals = intervals * factor;
+                break;
+            }
+        }
+
+        if (validationIntervals == 0)
+        {
+            break;
+        }
+
+        // Samples are ordered so the first input variable varies fastest,
+        // which is the order used by the sampled function.
+        std::vector<PDFReal> samples;
+        samples.reserve(totalNodeCount * n);
+        auto evaluateNode = [&]()
+        {
+            if (!function->apply(x.data(), x.data() + m, y.data(), y.data() + n))
+            {
+                return false;
+            }
+
+            samples.insert(samples.end(), y.cbegin(), y.cend());
+            return true;
+        };
+
+        if (!forEachGridPoint(nodeCount, 0.0, intervals, evaluateNode))
+        {
+            break;
+        }
+
+        std::vector<PDFReal> sampledRange(2 * n, 0.0);
+        for (uint32_t i = 0; i < n; ++i)
+        {
+            sampledRange[2 * i] = std::numeric_limits<PDFReal>::infinity();
+            sampledRange[2 * i + 1] = -std::numeric_limits<PDFReal>::infinity();
+        }
+
+        for (size_t i = 0; i < samples.size(); ++i)
+        {
+            const size_t outputIndex = i % n;
+            sampledRange[2 * outputIndex] = qMin(sampledRange[2 * outputIndex], samples[i]);
+            sampledRange[2 * outputIndex + 1] = qMax(sampledRange[2 * outputIndex + 1], samples[i]);
+        }
+
+        std::vector<PDFReal> tolerances(n, 0.0);
+        for (uint32_t i = 0; i < n; ++i)
+        {
+            tolerances[i] = tolerance * qMax(sampledRange[2 * i + 1] - sampledRange[2 * i], 1.0);
+        }
+
+        std::vector<PDFReal> encoder;
+        for (uint32_t i = 0; i < m; ++i)
+        {
+            encoder.insert(encoder.end(), { 0.0, PDFReal(intervals) });
+        }
+
+        std::vector<PDFReal> decoder;
+        for (uint32_t i = 0; i < n; ++i)
+        {
+            decoder.insert(decoder.end(), { 0.0, 1.0 });
+        }
+
+        std::vector<PDFReal> range = (function->m_range.size() == 2 * n) ? function->m_range : std::move(sampledRange);
+        std::shared_ptr<PDFSampledFunction> approximation = std::make_shared<PDFSampledFunction>(m, n, std::vector<PDFReal>(domain), std::move(range),
+                                                                                                 std::vector<uint32_t>(m, static_cast<uint32_t>(nodeCount)),
+                                                                                                 std::move(samples), std::move(encoder), std::move(decoder), 1.0, 1);
+
+        // Compare the function with the approximation in the centers of the cells
+        // of the validation grid. Features narrower than cell of the validation grid
+        // can still be missed, validation grid is as dense as the limit allows.
+        auto checkValidationPoint = [&]()
+        {
+            if (!function->apply(x.data(), x.data() + m, y.data(), y.data() + n) ||
+                !approximation->apply(x.data(), x.data() + m, yApproximation.data(), yApproximation.data() + n))
+            {
+                return false;
+            }
+
+            for (uint32_t i = 0; i < n; ++i)
+            {
+                if (qAbs(y[i] - yApproximation[i]) > tolerances[i])
+                {
+                    return false;
+                }
+            }
+
+            return true;
+        };
+
+        if (forEachGridPoint(validationIntervals, 0.5, validationIntervals, checkValidationPoint))
+        {
+            return approximation;
+        }
+    }
+
+    return function;
+}
+
 PDFFunctionPtr PDFFunction::createFunctionImpl(const PDFDocument* document, const PDFObject& object, PDFParsingContext* context)
 {
     PDFParsingContext::PDFParsingContextObjectGuard guard(context, &object);
@@ -1580,149 +1767,1110 @@ void PDFPostScriptFunctionStack::checkUnderflow(size_t n) const
     }
 }
 
-PDFPostScriptFunction::Code PDFPostScriptFunction::getCode(const QByteArray& byteArray)
+/// Compiles the postscript program into the register form. Operand stack is simulated
+/// at compile time, each stack item is either constant, or register with known type.
+/// Stack operators only rearrange the simulated stack, operators with constant operands
+/// are evaluated at compile time (using the interpreter, so semantics is the same),
+/// if/ifelse with constant condition are resolved at compile time, other conditional
+/// blocks are compiled into the forward jumps. Value, which is integer in one branch
+/// and real in the other branch, is stored as real (operators accepting both integers
+/// and reals give the same values for them). Programs, where stack depth or types
+/// depend on the input values (or which will fail at runtime for any input), are
+/// not compiled and interpreter is used instead.
+class PDFPostScriptFunctionCompiler
 {
-    static constexpr const std::pair<Code, const  char*> codes[] =
+public:
+    using Code = PDFPostScriptFunction::Code;
+    using OperandType = PDFPostScriptFunction::OperandType;
+    using OperandObject = PDFPostScriptFunction::OperandObject;
+    using InstructionPointer = PDFPostScriptFunction::InstructionPointer;
+    using CompiledCode = PDFPostScriptFunction::CompiledCode;
+    using CompiledRegister = PDFPostScriptFunction::CompiledRegister;
+    using CompiledInstruction = PDFPostScriptFunction::CompiledInstruction;
+    using CompiledProgram = PDFPostScriptFunction::CompiledProgram;
+
+    explicit inline PDFPostScriptFunctionCompiler(const PDFPostScriptFunction::Program& program) :
+        m_program(program)
     {
-        // B.1 Arithmetic operators
-        std::pair<Code, const  char*>{ Code::Add, "add" },
-        std::pair<Code, const  char*>{ Code::Sub, "sub" },
-        std::pair<Code, const  char*>{ Code::Mul, "mul" },
-        std::pair<Code, const  char*>{ Code::Div, "div" },
-        std::pair<Code, const  char*>{ Code::Idiv, "idiv" },
-        std::pair<Code, const  char*>{ Code::Mod, "mod" },
-        std::pair<Code, const  char*>{ Code::Neg, "neg" },
-        std::pair<Code, const  char*>{ Code::Abs, "abs" },
-        std::pair<Code, const  char*>{ Code::Ceiling, "ceiling" },
-        std::pair<Code, const  char*>{ Code::Floor, "floor" },
-        std::pair<Code, const  char*>{ Code::Round, "round" },
-        std::pair<Code, const  char*>{ Code::Truncate, "truncate" },
-        std::pair<Code, const  char*>{ Code::Sqrt, "sqrt" },
-        std::pair<Code, const  char*>{ Code::Sin, "sin" },
-        std::pair<Code, const  char*>{ Code::Cos, "cos" },
-        std::pair<Code, const  char*>{ Code::Atan, "atan" },
-        std::pair<Code, const  char*>{ Code::Exp, "exp" },
-        std::pair<Code, const  char*>{ Code::Ln, "ln" },
-        std::pair<Code, const  char*>{ Code::Log, "log" },
-        std::pair<Code, const  char*>{ Code::Cvi, "cvi" },
-        std::pair<Code, const  char*>{ Code::Cvr, "cvr" },
 
-        // B.2 Relational, Boolean and Bitwise operators
-        std::pair<Code, const  char*>{ Code::Eq, "eq" },
-        std::pair<Code, const  char*>{ Code::Ne, "ne" },
-        std::pair<Code, const  char*>{ Code::Gt, "gt" },
-        std::pair<Code, const  char*>{ Code::Ge, "ge" },
-        std::pair<Code, const  char*>{ Code::Lt, "lt" },
-        std::pair<Code, const  char*>{ Code::Le, "le" },
-        std::pair<Code, const  char*>{ Code::And, "and" },
-        std::pair<Code, const  char*>{ Code::Or, "or" },
-        std::pair<Code, const  char*>{ Code::Xor, "xor" },
-        std::pair<Code, const  char*>{ Code::Not, "not" },
-        std::pair<Code, const  char*>{ Code::Bitshift, "bitshift" },
-        std::pair<Code, const  char*>{ Code::True, "true" },
-        std::pair<Code, const  char*>{ Code::False, "false" },
+    }
 
-        // B.3 Conditional operators
-        std::pair<Code, const  char*>{ Code::If, "if" },
-        std::pair<Code, const  char*>{ Code::IfElse, "ifelse" },
+    /// Compiles the program with m inputs and n outputs. If program can't be
+    /// compiled, invalid compiled program is returned.
+    /// \param m Number of input variables
+    /// \param n Number of output variables
+    CompiledProgram compile(uint32_t m, uint32_t n);
 
-        // B.4 Stack operators
-        std::pair<Code, const  char*>{ Code::Pop, "pop" },
-        std::pair<Code, const  char*>{ Code::Exch, "exch" },
-        std::pair<Code, const  char*>{ Code::Dup, "dup" },
-        std::pair<Code, const  char*>{ Code::Copy, "copy" },
-        std::pair<Code, const  char*>{ Code::Index, "index" },
-        std::pair<Code, const  char*>{ Code::Roll, "roll" }
+private:
+    static constexpr const size_t MAX_STACK_SIZE = 100;
+    static constexpr const int MAX_BLOCK_DEPTH = 32;
+
+    struct Value
+    {
+        OperandType type = OperandType::Real;
+        bool isConstant = false;
+        bool mayBeInteger = false;  ///< Real value, which is integer in some branches
+        uint16_t reg = 0;
+        OperandObject constant;
+
+        bool isNumber() const { return type == OperandType::Real || type == OperandType::Integer; }
+        bool operator==(const Value& other) const;
+
+        static Value createConstant(const OperandObject& constant) { Value value; value.type = constant.type; value.isConstant = true; value.constant = constant; return value; }
+        static Value createRegister(OperandType type, uint16_t reg) { Value value; value.type = type; value.reg = reg; return value; }
     };
 
-    for (const std::pair<Code, const  char*>& codeItem : codes)
+    using Stack = std::vector<Value>;
+
+    /// Compiles the block starting at instruction pointer ip. Block
+    /// ends with return instruction (or with end of the program).
+    void compileBlock(InstructionPointer ip, Stack& stack, int depth);
+
+    /// Compiles single operator (other than stack and conditional operator)
+    void compileOperator(Code code, Stack& stack);
+
+    /// Compiles if/ifelse with condition evaluated at runtime. Blocks
+    /// must leave the stack of the same depth and with same types.
+    void compileConditional(uint16_t conditionRegister, InstructionPointer trueIp, InstructionPointer falseIp, Stack& stack, int depth);
+
+    /// Tries to evaluate the operator at compile time, if all operands are constant.
+    /// Returns true, if operator was evaluated.
+    bool tryEvaluateConstantOperator(Code code, size_t operandCount, Stack& stack) const;
+
+    /// Returns register containing the value. Constants are placed
+    /// in the constant area of the register file.
+    uint16_t getRegister(const Value& value);
+
+    /// Returns register containing the value converted to real number
+    uint16_t getRealRegister(const Value& value);
+
+    /// Creates instruction, which moves value to the target register of given type
+    CompiledInstruction createMove(uint16_t target, const Value& value, OperandType type);
+
+    uint16_t allocateRegister();
+    void emit(CompiledCode code, uint16_t target, uint16_t operand1 = 0, uint16_t operand2 = 0);
+
+    static Value pop(Stack& stack);
+    static void push(Stack& stack, Value value);
+    static void checkUnderflow(const Stack& stack, size_t n);
+    static PDFInteger popConstantInteger(Stack& stack);
+    [[noreturn]] static void fail();
+
+    const PDFPostScriptFunction::Program& m_program;
+    std::vector<CompiledInstruction> m_instructions;
+    std::vector<CompiledRegister> m_constants;
+    std::vector<OperandType> m_constantTypes;
+    size_t m_registerCount = 0;
+};
+
+bool PDFPostScriptFunctionCompiler::Value::operator==(const Value& other) const
+{
+    if (type != other.type || isConstant != other.isConstant)
     {
-        if (byteArray == codeItem.second)
-        {
-            return codeItem.first;
-        }
+        return false;
     }
 
-    throw PDFException(PDFTranslationContext::tr("Invalid operator (PostScript function) '%1'.").arg(QString::fromLatin1(byteArray)));
-}
+    if (!isConstant)
+    {
+        return reg == other.reg && mayBeInteger == other.mayBeInteger;
+    }
 
-PDFPostScriptFunction::PDFPostScriptFunction(uint32_t m, uint32_t n, std::vector<PDFReal>&& domain, std::vector<PDFReal>&& range, PDFPostScriptFunction::Program&& program) :
-    PDFFunction(m, n, std::move(domain), std::move(range)),
-    m_program(std::move(program))
-{
-    Q_ASSERT(!m_program.empty());
+    switch (type)
+    {
+        case OperandType::Real:
+            return std::memcmp(&constant.realNumber, &other.constant.realNumber, sizeof(PDFReal)) == 0;
+        case OperandType::Integer:
+            return constant.integerNumber == other.constant.integerNumber;
+        case OperandType::Boolean:
+            return constant.boolean == other.constant.boolean;
+        case OperandType::InstructionPointer:
+            return constant.instructionPointer == other.constant.instructionPointer;
+    }
+
+    return false;
 }
 
-PDFPostScriptFunction::~PDFPostScriptFunction()
+PDFPostScriptFunction::CompiledProgram PDFPostScriptFunctionCompiler::compile(uint32_t m, uint32_t n)
 {
+    CompiledProgram compiledProgram;
+
+    try
+    {
+        Stack stack;
+        for (uint32_t i = 0; i < m; ++i)
+        {
+            push(stack, Value::createRegister(OperandType::Real, allocateRegister()));
+        }
+
+        compileBlock(0, stack, 0);
+
+        // Interpreter reports error, if stack doesn't contain exactly n numbers
+        if (stack.size() != n)
+        {
+            fail();
+        }
+
+        for (const Value& value : stack)
+        {
+            compiledProgram.outputs.push_back(getRealRegister(value));
+        }
+    }
+    catch (const PDFPostScriptFunction::PDFPostScriptFunctionException&)
+    {
+        return CompiledProgram();
+    }
+
+    // Constant k is stored in the register MAX_COMPILED_REGISTER_COUNT - 1 - k, we reverse
+    // the constants, so they can be copied to the end of the register file.
+    std::reverse(m_constants.begin(), m_constants.end());
 
+    compiledProgram.isValid = true;
+    compiledProgram.instructions = std::move(m_instructions);
+    compiledProgram.constants = std::move(m_constants);
+    return compiledProgram;
 }
 
-PDFPostScriptFunction::Program PDFPostScriptFunction::parseProgram(const QByteArray& byteArray)
+void PDFPostScriptFunctionCompiler::compileBlock(InstructionPointer ip, Stack& stack, int depth)
 {
-    // Lexical analyzer can't handle when '{' or '}' is near next token (for example '{0' etc.)
-    QByteArray adjustedArray = byteArray;
-    adjustedArray.replace('{', " { ").replace('}', " } ");
-
-    Program result;
-    PDFLexicalAnalyzer parser(adjustedArray.constBegin(), adjustedArray.constEnd());
-    parser.setTokenizingPostScriptFunction();
+    if (depth > MAX_BLOCK_DEPTH)
+    {
+        fail();
+    }
 
-    std::stack<InstructionPointer> blockCallStack;
-    while (true)
+    while (ip != PDFPostScriptFunction::INVALID_INSTRUCTION_POINTER)
     {
-        PDFLexicalAnalyzer::Token token = parser.fetch();
-        if (token.type == PDFLexicalAnalyzer::TokenType::EndOfFile)
+        if (ip >= m_program.size())
         {
-            // We are at end, stop the parsing
-            break;
+            fail();
         }
 
-        switch (token.type)
+        const PDFPostScriptFunction::CodeObject& instruction = m_program[ip];
+        switch (instruction.code)
         {
-            case PDFLexicalAnalyzer::TokenType::Boolean:
+            case Code::Return:
             {
-                result.emplace_back(OperandObject::createBoolean(token.data.toBool()), result.size() + 1);
+                if (depth == 0)
+                {
+                    fail();
+                }
+                return;
+            }
+
+            case Code::Push:
+            {
+                push(stack, Value::createConstant(instruction.operand));
                 break;
             }
 
-            case PDFLexicalAnalyzer::TokenType::Integer:
+            case Code::Call:
             {
-                result.emplace_back(OperandObject::createInteger(token.data.toLongLong()), result.size() + 1);
+                push(stack, Value::createConstant(OperandObject::createInstructionPointer(instruction.operand.instructionPointer)));
                 break;
             }
 
-            case PDFLexicalAnalyzer::TokenType::Real:
+            case Code::True:
+            case Code::False:
             {
-                result.emplace_back(OperandObject::createReal(token.data.toDouble()), result.size() + 1);
+                push(stack, Value::createConstant(OperandObject::createBoolean(instruction.code == Code::True)));
                 break;
             }
 
-            case PDFLexicalAnalyzer::TokenType::Command:
+            case Code::Execute:
             {
-                QByteArray command = token.data.toByteArray();
-                if (command == "{")
+                const Value block = pop(stack);
+                if (block.type != OperandType::InstructionPointer)
                 {
-                    // Opening bracket - means start of block
-                    blockCallStack.push(result.size());
-                    result.emplace_back(Code::Call, INVALID_INSTRUCTION_POINTER);
-                    result.back().operand = OperandObject::createInstructionPointer(result.size());
+                    fail();
                 }
-                else if (command == "}")
+
+                compileBlock(block.constant.instructionPointer, stack, depth + 1);
+                break;
+            }
+
+            case Code::If:
+            case Code::IfElse:
+            {
+                InstructionPointer falseIp = PDFPostScriptFunction::INVALID_INSTRUCTION_POINTER;
+                if (instruction.code == Code::IfElse)
                 {
-                    // Closing bracket - means end of block
-                    if (blockCallStack.empty())
+                    const Value falseBlock = pop(stack);
+                    if (falseBlock.type != OperandType::InstructionPointer)
                     {
-                        throw PDFException(PDFTranslationContext::tr("Invalid program - bad enclosing brackets (PostScript function)."));
+                        fail();
                     }
+                    falseIp = falseBlock.constant.instructionPointer;
+                }
 
-                    result[blockCallStack.top()].next = result.size() + 1;
-                    blockCallStack.pop();
-                    result.emplace_back(Code::Return, INVALID_INSTRUCTION_POINTER);
+                const Value trueBlock = pop(stack);
+                const Value condition = pop(stack);
+                if (trueBlock.type != OperandType::InstructionPointer || condition.type != OperandType::Boolean)
+                {
+                    fail();
+                }
+
+                if (condition.isConstant)
+                {
+                    // Branch is resolved at compile time
+                    const InstructionPointer blockIp = condition.constant.boolean ? trueBlock.constant.instructionPointer : falseIp;
+                    if (blockIp != PDFPostScriptFunction::INVALID_INSTRUCTION_POINTER)
+                    {
+                        compileBlock(blockIp, stack, depth + 1);
+                    }
                 }
                 else
                 {
-                    result.emplace_back(getCode(command), result.size() + 1);
+                    compileConditional(condition.reg, trueBlock.constant.instructionPointer, falseIp, stack, depth);
+                }
+                break;
+            }
+
+            case Code::Pop:
+            {
+                pop(stack);
+                break;
+            }
+
+            case Code::Exch:
+            {
+                checkUnderflow(stack, 2);
+                std::swap(stack[stack.size() - 2], stack[stack.size() - 1]);
+                break;
+            }
+
+            case Code::Dup:
+            {
+                checkUnderflow(stack, 1);
+                push(stack, stack.back());
+                break;
+            }
+
+            case Code::Copy:
+            {
+                const PDFInteger count = popConstantInteger(stack);
+                if (count < 0)
+                {
+                    fail();
+                }
+
+                checkUnderflow(stack, static_cast<size_t>(count));
+                const size_t startIndex = stack.size() - count;
+                for (size_t i = 0; i < static_cast<size_t>(count); ++i)
+                {
+                    push(stack, stack[startIndex + i]);
+                }
+                break;
+            }
+
+            case Code::Index:
+            {
+                const PDFInteger index = popConstantInteger(stack);
+                if (index < 0)
+                {
+                    fail();
+                }
+
+                checkUnderflow(stack, static_cast<size_t>(index) + 1);
+                push(stack, stack[stack.size() - 1 - index]);
+                break;
+            }
+
+            case Code::Roll:
+            {
+                PDFInteger j = popConstantInteger(stack);
+                const PDFInteger count = popConstantInteger(stack);
+                if (count < 0)
+                {
+                    fail();
+                }
+
+                if (count > 0)
+                {
+                    j = j % count;
+                }
+
+                if (count > 0 && j != 0)
+                {
+                    checkUnderflow(stack, static_cast<size_t>(count));
+
+                    auto itBegin = std::prev(stack.end(), count);
+                    if (j > 0)
+                    {
+                        std::rotate(itBegin, stack.end() - j, stack.end());
+                    }
+                    else
+                    {
+                        std::rotate(itBegin, itBegin - j, stack.end());
+                    }
+                }
+                break;
+            }
+
+            default:
+            {
+                compileOperator(instruction.code, stack);
+                break;
+            }
+        }
+
+        ip = instruction.next;
+    }
+
+    if (depth > 0)
+    {
+        // Block must end with return instruction
+        fail();
+    }
+}
+
+void PDFPostScriptFunctionCompiler::compileConditional(uint16_t conditionRegister,
+                                                       InstructionPointer trueIp,
+                                                       InstructionPointer falseIp,
+                                                       Stack& stack,
+                                                       int depth)
+{
+    // Both branches are compiled separately. Jumps are relative,
+    // so the code of the branches can be moved.
+    auto compileBranch = [&](InstructionPointer ip, Stack& branchStack)
+    {
+        const size_t codeStart = m_instructions.size();
+        if (ip != PDFPostScriptFunction::INVALID_INSTRUCTION_POINTER)
+        {
+            compileBlock(ip, branchStack, depth + 1);
+        }
+
+        std::vector<CompiledInstruction> code(std::next(m_instructions.cbegin(), codeStart), m_instructions.cend());
+        m_instructions.resize(codeStart);
+        return code;
+    };
+
+    Stack trueStack = stack;
+    Stack falseStack = stack;
+    std::vector<CompiledInstruction> trueCode = compileBranch(trueIp, trueStack);
+    std::vector<CompiledInstruction> falseCode = compileBranch(falseIp, falseStack);
+
+    if (trueStack.size() != falseStack.size())
+    {
+        fail();
+    }
+
+    // Values, which differ between the branches, are moved into the new registers
+    // at the end of each branch.
+    for (size_t i = 0; i < trueStack.size(); ++i)
+    {
+        const Value& trueValue = trueStack[i];
+        const Value& falseValue = falseStack[i];
+
+        if (trueValue == falseValue)
+        {
+            continue;
+        }
+
+        OperandType type = trueValue.type;
+        bool mayBeInteger = trueValue.mayBeInteger || falseValue.mayBeInteger;
+        if (trueValue.type != falseValue.type)
+        {
+            if (!trueValue.isNumber() || !falseValue.isNumber())
+            {
+                fail();
+            }
+
+            type = OperandType::Real;
+            mayBeInteger = true;
+        }
+        else if (type == OperandType::InstructionPointer)
+        {
+            fail();
+        }
+
+        const uint16_t reg = allocateRegister();
+        trueCode.push_back(createMove(reg, trueValue, type));
+        falseCode.push_back(createMove(reg, falseValue, type));
+        trueStack[i] = Value::createRegister(type, reg);
+        trueStack[i].mayBeInteger = mayBeInteger;
+    }
+    stack = std::move(trueStack);
+
+    if (trueCode.empty() && falseCode.empty())
+    {
+        return;
+    }
+
+    const size_t trueBranchSize = trueCode.size() + (falseCode.empty() ? 0 : 1);
+    emit(CompiledCode::JumpIfFalse, static_cast<uint16_t>(trueBranchSize + 1), conditionRegister);
+    m_instructions.insert(m_instructions.end(), trueCode.cbegin(), trueCode.cend());
+
+    if (!falseCode.empty())
+    {
+        emit(CompiledCode::Jump, static_cast<uint16_t>(falseCode.size() + 1));
+        m_instructions.insert(m_instructions.end(), falseCode.cbegin(), falseCode.cend());
+    }
+
+    if (m_instructions.size() > PDFPostScriptFunction::MAX_COMPILED_INSTRUCTION_COUNT)
+    {
+        fail();
+    }
+}
+
+void PDFPostScriptFunctionCompiler::compileOperator(Code code, Stack& stack)
+{
+    size_t operandCount = 2;
+    switch (code)
+    {
+        case Code::Neg:
+        case Code::Abs:
+        case Code::Ceiling:
+        case Code::Floor:
+        case Code::Round:
+        case Code::Truncate:
+        case Code::Sqrt:
+        case Code::Sin:
+        case Code::Cos:
+        case Code::Ln:
+        case Code::Log:
+        case Code::Cvi:
+        case Code::Cvr:
+        case Code::Not:
+            operandCount = 1;
+            break;
+
+        default:
+            break;
+    }
+
+    checkUnderflow(stack, operandCount);
+    if (tryEvaluateConstantOperator(code, operandCount, stack))
+    {
+        return;
+    }
+
+    const Value b = pop(stack);
+    const Value a = (operandCount == 2) ? pop(stack) : Value();
+
+    const bool isInteger = (operandCount == 2) ? (a.type == OperandType::Integer && b.type == OperandType::Integer) : b.type == OperandType::Integer;
+    const bool isBoolean = (operandCount == 2) ? (a.type == OperandType::Boolean && b.type == OperandType::Boolean) : b.type == OperandType::Boolean;
+    const bool isNumber = (operandCount == 2) ? (a.isNumber() && b.isNumber()) : b.isNumber();
+
+    // Real result of the operator is integer, if operands are integers in some branches
+    auto isIntegerValued = [](const Value& value) { return value.type == OperandType::Integer || value.mayBeInteger; };
+    const bool mayBeInteger = (operandCount == 2) ? (isIntegerValued(a) && isIntegerValued(b)) : isIntegerValued(b);
+
+    // Emits operation on real numbers, integer operands are converted
+    auto emitReal = [&](CompiledCode compiledCode, OperandType resultType)
+    {
+        if (!isNumber)
+        {
+            fail();
+        }
+
+        const uint16_t operand1 = getRealRegister(operandCount == 2 ? a : b);
+        const uint16_t operand2 = (operandCount == 2) ? getRealRegister(b) : operand1;
+        const uint16_t target = allocateRegister();
+        emit(compiledCode, target, operand1, operand2);
+        push(stack, Value::createRegister(resultType, target));
+    };
+
+    // Emits operation on integers (or booleans, if allowed)
+    auto emitInteger = [&](CompiledCode compiledCode, OperandType resultType)
+    {
+        const uint16_t operand1 = getRegister(operandCount == 2 ? a : b);
+        const uint16_t operand2 = (operandCount == 2) ? getRegister(b) : operand1;
+        const uint16_t target = allocateRegister();
+        emit(compiledCode, target, operand1, operand2);
+        push(stack, Value::createRegister(resultType, target));
+    };
+
+    // Emits arithmetic operation, result is integer, if both operands are integers
+    auto emitArithmetic = [&](CompiledCode integerCode, CompiledCode realCode)
+    {
+        if (isInteger)
+        {
+            emitInteger(integerCode, OperandType::Integer);
+        }
+        else
+        {
+            emitReal(realCode, OperandType::Real);
+            stack.back().mayBeInteger = mayBeInteger;
+        }
+    };
+
+    // Emits rounding operation, integers are left unchanged
+    auto emitRounding = [&](CompiledCode compiledCode)
+    {
+        if (isInteger)
+        {
+            push(stack, b);
+        }
+        else if (b.type == OperandType::Real)
+        {
+            emitReal(compiledCode, OperandType::Real);
+            stack.back().mayBeInteger = mayBeInteger;
+        }
+        else
+        {
+            fail();
+        }
+    };
+
+    // Emits relation operator
+    auto emitRelation = [&](CompiledCode integerCode, CompiledCode realCode)
+    {
+        if (isInteger)
+        {
+            emitInteger(integerCode, OperandType::Boolean);
+        }
+        else
+        {
+            emitReal(realCode, OperandType::Boolean);
+        }
+    };
+
+    // Emits bitwise / logical operator
+    auto emitBitwise = [&](CompiledCode compiledCode)
+    {
+        if (!isInteger && !isBoolean)
+        {
+            fail();
+        }
+
+        emitInteger(compiledCode, a.type);
+    };
+
+    switch (code)
+    {
+        case Code::Add:
+            emitArithmetic(CompiledCode::AddInteger, CompiledCode::AddReal);
+            break;
+
+        case Code::Sub:
+            emitArithmetic(CompiledCode::SubInteger, CompiledCode::SubReal);
+            break;
+
+        case Code::Mul:
+            emitArithmetic(CompiledCode::MulInteger, CompiledCode::MulReal);
+            break;
+
+        case Code::Div:
+            emitReal(CompiledCode::Div, OperandType::Real);
+            break;
+
+        case Code::Idiv:
+        case Code::Mod:
+        case Code::Bitshift:
+        {
+            if (!isInteger)
+            {
+                fail();
+            }
+
+            const CompiledCode compiledCode = (code == Code::Idiv) ? CompiledCode::Idiv : ((code == Code::Mod) ? CompiledCode::Mod : CompiledCode::Bitshift);
+            emitInteger(compiledCode, OperandType::Integer);
+            break;
+        }
+
+        case Code::Neg:
+        case Code::Abs:
+        {
+            if (isInteger)
+            {
+                emitInteger(code == Code::Neg ? CompiledCode::NegInteger : CompiledCode::AbsInteger, OperandType::Integer);
+            }
+            else if (b.type == OperandType::Real)
+            {
+                emitReal(code == Code::Neg ? CompiledCode::NegReal : CompiledCode::AbsReal, OperandType::Real);
+                stack.back().mayBeInteger = mayBeInteger;
+            }
+            else
+            {
+                fail();
+            }
+            break;
+        }
+
+        case Code::Ceiling:
+            emitRounding(CompiledCode::Ceiling);
+            break;
+
+        case Code::Floor:
+            emitRounding(CompiledCode::Floor);
+            break;
+
+        case Code::Round:
+            emitRounding(CompiledCode::Round);
+            break;
+
+        case Code::Truncate:
+            emitRounding(CompiledCode::Truncate);
+            break;
+
+        case Code::Sqrt:
+            emitReal(CompiledCode::Sqrt, OperandType::Real);
+            break;
+
+        case Code::Sin:
+            emitReal(CompiledCode::Sin, OperandType::Real);
+            break;
+
+        case Code::Cos:
+            emitReal(CompiledCode::Cos, OperandType::Real);
+            break;
+
+        case Code::Atan:
+            emitReal(CompiledCode::Atan, OperandType::Real);
+            break;
+
+        case Code::Exp:
+            emitReal(CompiledCode::Exp, OperandType::Real);
+            break;
+
+        case Code::Ln:
+            emitReal(CompiledCode::Ln, OperandType::Real);
+            break;
+
+        case Code::Log:
+            emitReal(CompiledCode::Log, OperandType::Real);
+            break;
+
+        case Code::Cvi:
+        {
+            if (isInteger)
+            {
+                push(stack, b);
+            }
+            else if (b.type == OperandType::Real)
+            {
+                emitInteger(CompiledCode::Cvi, OperandType::Integer);
+            }
+            else
+            {
+                fail();
+            }
+            break;
+        }
+
+        case Code::Cvr:
+        {
+            if (b.type == OperandType::Real)
+            {
+                Value value = b;
+                value.mayBeInteger = false;
+                push(stack, value);
+            }
+            else if (isInteger)
+            {
+                emitInteger(CompiledCode::Cvr, OperandType::Real);
+            }
+            else
+            {
+                fail();
+            }
+            break;
+        }
+
+        case Code::Eq:
+        case Code::Ne:
+        {
+            if (isInteger || isBoolean)
+            {
+                emitInteger(code == Code::Eq ? CompiledCode::EqInteger : CompiledCode::NeInteger, OperandType::Boolean);
+            }
+            else
+            {
+                emitReal(code == Code::Eq ? CompiledCode::EqReal : CompiledCode::NeReal, OperandType::Boolean);
+            }
+            break;
+        }
+
+        case Code::Gt:
+            emitRelation(CompiledCode::GtInteger, CompiledCode::GtReal);
+            break;
+
+        case Code::Ge:
+            emitRelation(CompiledCode::GeInteger, CompiledCode::GeReal);
+            break;
+
+        case Code::Lt:
+            emitRelation(CompiledCode::LtInteger, CompiledCode::LtReal);
+            break;
+
+        case Code::Le:
+            emitRelation(CompiledCode::LeInteger, CompiledCode::LeReal);
+            break;
+
+        case Code::And:
+            emitBitwise(CompiledCode::And);
+            break;
+
+        case Code::Or:
+            emitBitwise(CompiledCode::Or);
+            break;
+
+        case Code::Xor:
+            emitBitwise(CompiledCode::Xor);
+            break;
+
+        case Code::Not:
+        {
+            if (isInteger)
+            {
+                emitInteger(CompiledCode::NotInteger, OperandType::Integer);
+            }
+            else if (isBoolean)
+            {
+                emitInteger(CompiledCode::NotBoolean, OperandType::Boolean);
+            }
+            else
+            {
+                fail();
+            }
+            break;
+        }
+
+        default:
+            fail();
+    }
+}
+
+bool PDFPostScriptFunctionCompiler::tryEvaluateConstantOperator(Code code, size_t operandCount, Stack& stack) const
+{
+    PDFPostScriptFunctionStack constantStack;
+    for (auto it = std::prev(stack.cend(), operandCount); it != stack.cend(); ++it)
+    {
+        if (!it->isConstant)
+        {
+            return false;
+        }
+
+        constantStack.push(it->constant);
+    }
+
+    try
+    {
+        PDFPostScriptFunction::Program program = { PDFPostScriptFunction::CodeObject(code, PDFPostScriptFunction::INVALID_INSTRUCTION_POINTER) };
+        PDFPostScriptFunctionExecutor executor(program, constantStack);
+        executor.execute();
+
+        OperandObject result;
+        if (constantStack.size() != 1)
+        {
+            return false;
+        }
+        else if (constantStack.isReal())
+        {
+            result = OperandObject::createReal(constantStack.popReal());
+        }
+        else if (constantStack.isInteger())
+        {
+            result = OperandObject::createInteger(constantStack.popInteger());
+        }
+        else
+        {
+            result = OperandObject::createBoolean(constantStack.popBoolean());
+        }
+
+        stack.resize(stack.size() - operandCount);
+        stack.push_back(Value::createConstant(result));
+        return true;
+    }
+    catch (const PDFPostScriptFunction::PDFPostScriptFunctionException&)
+    {
+        // Operator fails for constant operands, but it can be in the branch,
+        // which is never executed, so we let it fail at runtime.
+        return false;
+    }
+}
+
+uint16_t PDFPostScriptFunctionCompiler::getRegister(const Value& value)
+{
+    if (!value.isConstant)
+    {
+        return value.reg;
+    }
+
+    CompiledRegister constant;
+    switch (value.type)
+    {
+        case OperandType::Real:
+            constant.real = value.constant.realNumber;
+            break;
+
+        case OperandType::Integer:
+            constant.integer = value.constant.integerNumber;
+            break;
+
+        case OperandType::Boolean:
+            constant.integer = value.constant.boolean ? 1 : 0;
+            break;
+
+        case OperandType::InstructionPointer:
+            fail();
+    }
+
+    for (size_t i = 0; i < m_constants.size(); ++i)
+    {
+        if (m_constantTypes[i] == value.type && m_constants[i].integer == constant.integer)
+        {
+            return static_cast<uint16_t>(PDFPostScriptFunction::MAX_COMPILED_REGISTER_COUNT - 1 - i);
+        }
+    }
+
+    m_constants.push_back(constant);
+    m_constantTypes.push_back(value.type);
+
+    if (m_registerCount + m_constants.size() > PDFPostScriptFunction::MAX_COMPILED_REGISTER_COUNT)
+    {
+        fail();
+    }
+
+    return static_cast<uint16_t>(PDFPostScriptFunction::MAX_COMPILED_REGISTER_COUNT - m_constants.size());
+}
+
+uint16_t PDFPostScriptFunctionCompiler::getRealRegister(const Value& value)
+{
+    switch (value.type)
+    {
+        case OperandType::Real:
+            return getRegister(value);
+
+        case OperandType::Integer:
+        {
+            if (value.isConstant)
+            {
+                return getRegister(Value::createConstant(OperandObject::createReal(value.constant.integerNumber)));
+            }
+
+            const uint16_t target = allocateRegister();
+            emit(CompiledCode::Cvr, target, value.reg);
+            return target;
+        }
+
+        default:
+            fail();
+    }
+}
+
+PDFPostScriptFunction::CompiledInstruction PDFPostScriptFunctionCompiler::createMove(uint16_t target, const Value& value, OperandType type)
+{
+    if (type == OperandType::Real && value.type == OperandType::Integer)
+    {
+        if (value.isConstant)
+        {
+            return CompiledInstruction{ CompiledCode::Move, target, getRealRegister(value), 0 };
+        }
+
+        return CompiledInstruction{ CompiledCode::Cvr, target, value.reg, 0 };
+    }
+
+    return CompiledInstruction{ CompiledCode::Move, target, getRegister(value), 0 };
+}
+
+uint16_t PDFPostScriptFunctionCompiler::allocateRegister()
+{
+    if (m_registerCount + m_constants.size() >= PDFPostScriptFunction::MAX_COMPILED_REGISTER_COUNT)
+    {
+        fail();
+    }
+
+    return static_cast<uint16_t>(m_registerCount++);
+}
+
+void PDFPostScriptFunctionCompiler::emit(CompiledCode code, uint16_t target, uint16_t operand1, uint16_t operand2)
+{
+    if (m_instructions.size() >= PDFPostScriptFunction::MAX_COMPILED_INSTRUCTION_COUNT)
+    {
+        fail();
+    }
+
+    m_instructions.push_back(CompiledInstruction{ code, target, operand1, operand2 });
+}
+
+PDFPostScriptFunctionCompiler::Value PDFPostScriptFunctionCompiler::pop(Stack& stack)
+{
+    checkUnderflow(stack, 1);
+    Value value = stack.back();
+    stack.pop_back();
+    return value;
+}
+
+void PDFPostScriptFunctionCompiler::push(Stack& stack, Value value)
+{
+    stack.push_back(value);
+
+    if (stack.size() > MAX_STACK_SIZE)
+    {
+        fail();
+    }
+}
+
+void PDFPostScriptFunctionCompiler::checkUnderflow(const Stack& stack, size_t n)
+{
+    if (stack.size() < n)
+    {
+        fail();
+    }
+}
+
+PDFInteger PDFPostScriptFunctionCompiler::popConstantInteger(Stack& stack)
+{
+    const Value value = pop(stack);
+    if (!value.isConstant || value.type != OperandType::Integer)
+    {
+        // Stack depth would depend on the input values
+        fail();
+    }
+
+    return value.constant.integerNumber;
+}
+
+void PDFPostScriptFunctionCompiler::fail()
+{
+    throw PDFPostScriptFunction::PDFPostScriptFunctionException(PDFTranslationContext::tr("Program can't be compiled (PostScript engine)."));
+}
+
+PDFPostScriptFunction::Code PDFPostScriptFunction::getCode(const QByteArray& byteArray)
+{
+    static constexpr const std::pair<Code, const  char*> codes[] =
+    {
+        // B.1 Arithmetic operators
+        std::pair<Code, const  char*>{ Code::Add, "add" },
+        std::pair<Code, const  char*>{ Code::Sub, "sub" },
+        std::pair<Code, const  char*>{ Code::Mul, "mul" },
+        std::pair<Code, const  char*>{ Code::Div, "div" },
+        std::pair<Code, const  char*>{ Code::Idiv, "idiv" },
+        std::pair<Code, const  char*>{ Code::Mod, "mod" },
+        std::pair<Code, const  char*>{ Code::Neg, "neg" },
+        std::pair<Code, const  char*>{ Code::Abs, "abs" },
+        std::pair<Code, const  char*>{ Code::Ceiling, "ceiling" },
+        std::pair<Code, const  char*>{ Code::Floor, "floor" },
+        std::pair<Code, const  char*>{ Code::Round, "round" },
+        std::pair<Code, const  char*>{ Code::Truncate, "truncate" },
+        std::pair<Code, const  char*>{ Code::Sqrt, "sqrt" },
+        std::pair<Code, const  char*>{ Code::Sin, "sin" },
+        std::pair<Code, const  char*>{ Code::Cos, "cos" },
+        std::pair<Code, const  char*>{ Code::Atan, "atan" },
+        std::pair<Code, const  char*>{ Code::Exp, "exp" },
+        std::pair<Code, const  char*>{ Code::Ln, "ln" },
+        std::pair<Code, const  char*>{ Code::Log, "log" },
+        std::pair<Code, const  char*>{ Code::Cvi, "cvi" },
+        std::pair<Code, const  char*>{ Code::Cvr, "cvr" },
+
+        // B.2 Relational, Boolean and Bitwise operators
+        std::pair<Code, const  char*>{ Code::Eq, "eq" },
+        std::pair<Code, const  char*>{ Code::Ne, "ne" },
+        std::pair<Code, const  char*>{ Code::Gt, "gt" },
+        std::pair<Code, const  char*>{ Code::Ge, "ge" },
+        std::pair<Code, const  char*>{ Code::Lt, "lt" },
+        std::pair<Code, const  char*>{ Code::Le, "le" },
+        std::pair<Code, const  char*>{ Code::And, "and" },
+        std::pair<Code, const  char*>{ Code::Or, "or" },
+        std::pair<Code, const  char*>{ Code::Xor, "xor" },
+        std::pair<Code, const  char*>{ Code::Not, "not" },
+        std::pair<Code, const  char*>{ Code::Bitshift, "bitshift" },
+        std::pair<Code, const  char*>{ Code::True, "true" },
+        std::pair<Code, const  char*>{ Code::False, "false" },
+
+        // B.3 Conditional operators
+        std::pair<Code, const  char*>{ Code::If, "if" },
+        std::pair<Code, const  char*>{ Code::IfElse, "ifelse" },
+
+        // B.4 Stack operators
+        std::pair<Code, const  char*>{ Code::Pop, "pop" },
+        std::pair<Code, const  char*>{ Code::Exch, "exch" },
+        std::pair<Code, const  char*>{ Code::Dup, "dup" },
+        std::pair<Code, const  char*>{ Code::Copy, "copy" },
+        std::pair<Code, const  char*>{ Code::Index, "index" },
+        std::pair<Code, const  char*>{ Code::Roll, "roll" }
+    };
+
+    for (const std::pair<Code, const  char*>& codeItem : codes)
+    {
+        if (byteArray == codeItem.second)
+        {
+            return codeItem.first;
+        }
+    }
+
+    throw PDFException(PDFTranslationContext::tr("Invalid operator (PostScript function) '%1'.").arg(QString::fromLatin1(byteArray)));
+}
+
+PDFPostScriptFunction::PDFPostScriptFunction(uint32_t m, uint32_t n, std::vector<PDFReal>&& domain, std::vector<PDFReal>&& range, PDFPostScriptFunction::Program&& program) :
+    PDFFunction(m, n, std::move(domain), std::move(range)),
+    m_program(std::move(program))
+{
+    Q_ASSERT(!m_program.empty());
+
+    m_compiledProgram = PDFPostScriptFunctionCompiler(m_program).compile(m_m, m_n);
+}
+
+PDFPostScriptFunction::~PDFPostScriptFunction()
+{
+
+}
+
+PDFPostScriptFunction::Program PDFPostScriptFunction::parseProgram(const QByteArray& byteArray)
+{
+    // Lexical analyzer can't handle when '{' or '}' is near next token (for example '{0' etc.)
+    QByteArray adjustedArray = byteArray;
+    adjustedArray.replace('{', " { ").replace('}', " } ");
+
+    Program result;
+    PDFLexicalAnalyzer parser(adjustedArray.constBegin(), adjustedArray.constEnd());
+    parser.setTokenizingPostScriptFunction();
+
+    std::stack<InstructionPointer> blockCallStack;
+    while (true)
+    {
+        PDFLexicalAnalyzer::Token token = parser.fetch();
+        if (token.type == PDFLexicalAnalyzer::TokenType::EndOfFile)
+        {
+            // We are at end, stop the parsing
+            break;
+        }
+
+        switch (token.type)
+        {
+            case PDFLexicalAnalyzer::TokenType::Boolean:
+            {
+                result.emplace_back(OperandObject::createBoolean(token.data.toBool()), result.size() + 1);
+                break;
+            }
+
+            case PDFLexicalAnalyzer::TokenType::Integer:
+            {
+                result.emplace_back(OperandObject::createInteger(token.data.toLongLong()), result.size() + 1);
+                break;
+            }
+
+            case PDFLexicalAnalyzer::TokenType::Real:
+            {
+                result.emplace_back(OperandObject::createReal(token.data.toDouble()), result.size() + 1);
+                break;
+            }
+
+            case PDFLexicalAnalyzer::TokenType::Command:
+            {
+                QByteArray command = token.data.toByteArray();
+                if (command == "{")
+                {
+                    // Opening bracket - means start of block
+                    blockCallStack.push(result.size());
+                    result.emplace_back(Code::Call, INVALID_INSTRUCTION_POINTER);
+                    result.back().operand = OperandObject::createInstructionPointer(result.size());
+                }
+                else if (command == "}")
+                {
+                    // Closing bracket - means end of block
+                    if (blockCallStack.empty())
+                    {
+                        throw PDFException(PDFTranslationContext::tr("Invalid program - bad enclosing brackets (PostScript function)."));
+                    }
+
+                    result[blockCallStack.top()].next = result.size() + 1;
+                    blockCallStack.pop();
+                    result.emplace_back(Code::Return, INVALID_INSTRUCTION_POINTER);
+                }
+                else
+                {
+                    result.emplace_back(getCode(command), result.size() + 1);
                 }
 
                 break;
@@ -1838,6 +2986,12 @@ PDFFunction::FunctionResult PDFPostScriptFunction::apply(const_iterator x_1, con
         return PDFTranslationContext::tr("Invalid number of output variables for function. Expected %1, provided %2.").arg(m_n).arg(n);
     }
 
+    // If compiled program fails, interpreter is used to get the error message
+    if (m_compiledProgram.isValid && applyCompiled(x_1, y_1))
+    {
+        return true;
+    }
+
     try
     {
         PDFPostScriptFunctionStack stack;
@@ -1876,4 +3030,273 @@ PDFFunction::FunctionResult PDFPostScriptFunction::apply(const_iterator x_1, con
     return true;
 }
 
+bool PDFPostScriptFunction::applyCompiled(const_iterator x_1, iterator y_1) const
+{
+    using PDFIntegerUnsigned = std::make_unsigned<PDFInteger>::type;
+
+    std::array<CompiledRegister, MAX_COMPILED_REGISTER_COUNT> registers;
+
+    for (uint32_t i = 0; i < m_m; ++i)
+    {
+        registers[i].real = clampInput(i, *std::next(x_1, i));
+    }
+
+    const std::vector<CompiledRegister>& constants = m_compiledProgram.constants;
+    std::copy(constants.cbegin(), constants.cend(), std::prev(registers.end(), constants.size()));
+
+    const CompiledInstruction* instructions = m_compiledProgram.instructions.data();
+    const size_t instructionCount = m_compiledProgram.instructions.size();
+
+    size_t ip = 0;
+    while (ip < instructionCount)
+    {
+        const CompiledInstruction& instruction = instructions[ip++];
+        const CompiledRegister& a = registers[instruction.operand1];
+        const CompiledRegister& b = registers[instruction.operand2];
+
+        switch (instruction.code)
+        {
+            case CompiledCode::Move:
+                registers[instruction.target] = a;
+                break;
+
+            case CompiledCode::AddInteger:
+                registers[instruction.target].integer = a.integer + b.integer;
+                break;
+
+            case CompiledCode::AddReal:
+                registers[instruction.target].real = a.real + b.real;
+                break;
+
+            case CompiledCode::SubInteger:
+                registers[instruction.target].integer = a.integer - b.integer;
+                break;
+
+            case CompiledCode::SubReal:
+                registers[instruction.target].real = a.real - b.real;
+                break;
+
+            case CompiledCode::MulInteger:
+                registers[instruction.target].integer = a.integer * b.integer;
+                break;
+
+            case CompiledCode::MulReal:
+                registers[instruction.target].real = a.real * b.real;
+                break;
+
+            case CompiledCode::Div:
+            {
+                if (qFuzzyIsNull(b.real))
+                {
+                    return false;
+                }
+
+                registers[instruction.target].real = a.real / b.real;
+                break;
+            }
+
+            case CompiledCode::Idiv:
+            case CompiledCode::Mod:
+            {
+                if (b.integer == 0)
+                {
+                    return false;
+                }
+
+                registers[instruction.target].integer = (instruction.code == CompiledCode::Idiv) ? a.integer / b.integer : a.integer % b.integer;
+                break;
+            }
+
+            case CompiledCode::NegInteger:
+                registers[instruction.target].integer = -a.integer;
+                break;
+
+            case CompiledCode::NegReal:
+                registers[instruction.target].real = -a.real;
+                break;
+
+            case CompiledCode::AbsInteger:
+                registers[instruction.target].integer = qAbs(a.integer);
+                break;
+
+            case CompiledCode::AbsReal:
+                registers[instruction.target].real = qAbs(a.real);
+                break;
+
+            case CompiledCode::Ceiling:
+                registers[instruction.target].real = std::ceil(a.real);
+                break;
+
+            case CompiledCode::Floor:
+                registers[instruction.target].real = std::floor(a.real);
+                break;
+
+            case CompiledCode::Round:
+                registers[instruction.target].real = qRound(a.real);
+                break;
+
+            case CompiledCode::Truncate:
+                registers[instruction.target].real = std::trunc(a.real);
+                break;
+
+            case CompiledCode::Sqrt:
+            {
+                if (a.real < 0.0)
+                {
+                    return false;
+                }
+
+                registers[instruction.target].real = std::sqrt(a.real);
+                break;
+            }
+
+            case CompiledCode::Sin:
+                registers[instruction.target].real = qSin(qDegreesToRadians(a.real));
+                break;
+
+            case CompiledCode::Cos:
+                registers[instruction.target].real = qCos(qDegreesToRadians(a.real));
+                break;
+
+            case CompiledCode::Atan:
+            {
+                const PDFReal angles = qRadiansToDegrees(qAtan2(a.real, b.real));
+                registers[instruction.target].real = angles < 0.0 ? (angles + 360.0) : angles;
+                break;
+            }
+
+            case CompiledCode::Exp:
+                registers[instruction.target].real = qPow(a.real, b.real);
+                break;
+
+            case CompiledCode::Ln:
+            case CompiledCode::Log:
+            {
+                if (a.real < 0.0 || qFuzzyIsNull(a.real))
+                {
+                    return false;
+                }
+
+                registers[instruction.target].real = (instruction.code == CompiledCode::Ln) ? qLn(a.real) : std::log10(a.real);
+                break;
+            }
+
+            case CompiledCode::Cvi:
+                registers[instruction.target].integer = static_cast<PDFInteger>(a.real);
+                break;
+
+            case CompiledCode::Cvr:
+                registers[instruction.target].real = a.integer;
+                break;
+
+            case CompiledCode::EqInteger:
+                registers[instruction.target].integer = (a.integer == b.integer) ? 1 : 0;
+                break;
+
+            case CompiledCode::EqReal:
+                registers[instruction.target].integer = (a.real == b.real) ? 1 : 0;
+                break;
+
+            case CompiledCode::NeInteger:
+                registers[instruction.target].integer = (a.integer != b.integer) ? 1 : 0;
+                break;
+
+            case CompiledCode::NeReal:
+                registers[instruction.target].integer = (a.real != b.real) ? 1 : 0;
+                break;
+
+            case CompiledCode::GtInteger:
+                registers[instruction.target].integer = (a.integer > b.integer) ? 1 : 0;
+                break;
+
+            case CompiledCode::GtReal:
+                registers[instruction.target].integer = (a.real > b.real) ? 1 : 0;
+                break;
+
+            case CompiledCode::GeInteger:
+                registers[instruction.target].integer = (a.integer >= b.integer) ? 1 : 0;
+                break;
+
+            case CompiledCode::GeReal:
+                registers[instruction.target].integer = (a.real >= b.real) ? 1 : 0;
+                break;
+
+            case CompiledCode::LtInteger:
+                registers[instruction.target].integer = (a.integer < b.integer) ? 1 : 0;
+                break;
+
+            case CompiledCode::LtReal:
+                registers[instruction.target].integer = (a.real < b.real) ? 1 : 0;
+                break;
+
+            case CompiledCode::LeInteger:
+                registers[instruction.target].integer = (a.integer <= b.integer) ? 1 : 0;
+                break;
+
+            case CompiledCode::LeReal:
+                registers[instruction.target].integer = (a.real <= b.real) ? 1 : 0;
+                break;
+
+            case CompiledCode::And:
+                registers[instruction.target].integer = a.integer & b.integer;
+                break;
+
+            case CompiledCode::Or:
+                registers[instruction.target].integer = a.integer | b.integer;
+                break;
+
+            case CompiledCode::Xor:
+                registers[instruction.target].integer = a.integer ^ b.integer;
+                break;
+
+            case CompiledCode::NotInteger:
+                registers[instruction.target].integer = ~a.integer;
+                break;
+
+            case CompiledCode::NotBoolean:
+                registers[instruction.target].integer = a.integer ? 0 : 1;
+                break;
+
+            case CompiledCode::Bitshift:
+            {
+                const PDFInteger shift = b.integer;
+                const PDFIntegerUnsigned value = static_cast<PDFIntegerUnsigned>(a.integer);
+                PDFIntegerUnsigned shiftedValue = value;
+
+                if (shift > 0)
+                {
+                    shiftedValue = value << shift;
+                }
+                else if (shift < 0)
+                {
+                    shiftedValue = value >> -shift;
+                }
+
+                registers[instruction.target].integer = shiftedValue;
+                break;
+            }
+
+            case CompiledCode::Jump:
+                ip += instruction.target - 1;
+                break;
+
+            case CompiledCode::JumpIfFalse:
+            {
+                if (!a.integer)
+                {
+                    ip += instruction.target - 1;
+                }
+                break;
+            }
+        }
+    }
+
+    for (uint32_t i = 0; i < m_n; ++i)
+    {
+        *std::next(y_1, i) = clampOutput(i, registers[m_compiledProgram.outputs[i]].real);
+    }
+
+    return true;
+}
+
 }   // namespace pdf
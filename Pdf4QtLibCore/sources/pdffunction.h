@@ -91,6 +91,20 @@ public:
     /// \param object Object defining the function
     static PDFFunctionPtr createFunction(const PDFDocument* document, const PDFObject& object);
 
+    /// Creates sampled approximation of the PostScript function (function is baked into
+    /// the table of samples, which is interpolated multilinearly). Other function types
+    /// are returned unchanged. Function must have 1 to 4 input variables. Function is sampled
+    /// on the regular grid over its domain, which is refined, until the error of the interpolation
+    /// is below the tolerance on the validation grid, which is 2-8 times denser than the grid
+    /// of samples. If the accuracy can't be reached with a reasonable table size, or the
+    /// function can't be evaluated at some point, original function is returned. Passing
+    /// the validation doesn't prove the accuracy - features narrower than the cell
+    /// of the validation grid can be missed by all samples and then they are lost.
+    /// \param function Function to be approximated
+    /// \param tolerance Allowed error, relative to the span of the output values (but
+    ///        absolute for the values spanning less than 1.0, i.e. color components)
+    static PDFFunctionPtr createSampledApproximation(const PDFFunctionPtr& function, PDFReal tolerance = 0.001);
+
 protected:
     static constexpr const size_t DEFAULT_OPERAND_COUNT = 32;
 
@@ -466,11 +480,103 @@ public:
     /// \param y_n Iterator to the end of the output values (one item after last value)
     virtual FunctionResult apply(const_iterator x_1, const_iterator x_m, iterator y_1, iterator y_n) const override;
 
+    /// Returns true, if program was compiled into the register form. Programs,
+    /// which can't be compiled, are interpreted.
+    bool isCompiled() const { return m_compiledProgram.isValid; }
+
 private:
+    static constexpr const size_t MAX_COMPILED_REGISTER_COUNT = 256;
+    static constexpr const size_t MAX_COMPILED_INSTRUCTION_COUNT = 4096;
+
+    /// Register of the compiled program. Type of each register is known
+    /// at compile time, booleans are stored as integers 0 and 1.
+    union CompiledRegister
+    {
+        PDFReal real;
+        PDFInteger integer;
+    };
+
+    enum class CompiledCode : uint8_t
+    {
+        Move,
+        AddInteger,
+        AddReal,
+        SubInteger,
+        SubReal,
+        MulInteger,
+        MulReal,
+        Div,
+        Idiv,
+        Mod,
+        NegInteger,
+        NegReal,
+        AbsInteger,
+        AbsReal,
+        Ceiling,
+        Floor,
+        Round,
+        Truncate,
+        Sqrt,
+        Sin,
+        Cos,
+        Atan,
+        Exp,
+        Ln,
+        Log,
+        Cvi,
+        Cvr,
+        EqInteger,
+        EqReal,
+        NeInteger,
+        NeReal,
+        GtInteger,
+        GtReal,
+        GeInteger,
+        GeReal,
+        LtInteger,
+        LtReal,
+        LeInteger,
+        LeReal,
+        And,
+        Or,
+        Xor,
+        NotInteger,
+        NotBoolean,
+        Bitshift,
+        Jump,           ///< Jumps forward by target instructions
+        JumpIfFalse     ///< Jumps forward by target instructions, if boolean operand1 is false
+    };
+
+    struct CompiledInstruction
+    {
+        CompiledCode code = CompiledCode::Move;
+        uint16_t target = 0;    ///< Target register (or jump offset)
+        uint16_t operand1 = 0;  ///< First operand register
+        uint16_t operand2 = 0;  ///< Second operand register
+    };
+
+    /// Program compiled into the register form. Operand stack is resolved at compile
+    /// time, so stack operators and constant expressions do not generate any code.
+    /// Input values are in registers [0, m), constants are stored at the end
+    /// of the register file.
+    struct CompiledProgram
+    {
+        bool isValid = false;
+        std::vector<CompiledInstruction> instructions;
+        std::vector<CompiledRegister> constants;
+        std::vector<uint16_t> outputs;  ///< Output registers (of type real)
+    };
+
+    /// Evaluates compiled program. Returns false, if runtime error occurs,
+    /// in that case, the interpreter should be used to get the error message.
+    bool applyCompiled(const_iterator x_1, iterator y_1) const;
+
     Program m_program;
+    CompiledProgram m_compiledProgram;
 
     friend class PDFPostScriptFunctionStack;
     friend class PDFPostScriptFunctionExecutor;
+    friend class PDFPostScriptFunctionCompiler;
 };
 
 }   // namespace pdf
@@ -0,0 +1,169 @@
+//    Copyright (C) 2024 Jakub Melka
+//
+//    This file is part of PDF4QT.
+//
+//    PDF4QT is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    with the written consent of the copyright owner, any later version.
+//
+//    PDF4QT is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public License
+//    along with PDF4QT.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "pdfglyphcache.h"
+#include "pdfcoveragerasterizer.h"
+#include "pdfconstants.h"
+#include "pdfdbgheap.h"
+
+#include <cmath>
+#include <limits>
+#include <algorithm>
+
+namespace pdf
+{
+
+/// Number of subpixel positions of the glyph origin in each direction
+static constexpr int GLYPH_SUBPIXEL_POSITIONS = 4;
+
+/// Glyph scale is quantized to multiples of 1 / GLYPH_SCALE_QUANTIZATION,
+/// so glyphs of the same font size differing only by numerical noise
+/// of the matrices share the cache entry.
+static constexpr PDFReal GLYPH_SCALE_QUANTIZATION = 1024.0;
+
+/// Maximal width/height of the cached glyph in pixels. Larger glyphs
+/// are rare and are drawn as paths.
+static constexpr int GLYPH_MAX_SIZE = 256;
+
+/// Maximal skew of the glyph to device space matrix, for which
+/// the matrix is still treated as axis-aligned.
+static constexpr PDFReal GLYPH_MAX_SKEW = 1.0e-6;
+
+PDFGlyphCache::PDFGlyphCache(qint64 cacheLimit)
+{
+    m_cache.setMaxCost(cacheLimit);
+}
+
+PDFGlyphCache* PDFGlyphCache::getInstance()
+{
+    static PDFGlyphCache instance(DEFAULT_GLYPH_CACHE_LIMIT);
+    return &instance;
+}
+
+QImage PDFGlyphCache::getGlyph(quint64 fontId,
+                               GID glyphIndex,
+                               const QTransform& glyphMatrix,
+                               const QPainterPath& path,
+                               const QTransform& pathToDeviceMatrix,
+                               QColor color,
+                               QPoint& position) const
+{
+    const QTransform glyphToDeviceMatrix = glyphMatrix * pathToDeviceMatrix;
+    if (!glyphToDeviceMatrix.isAffine() ||
+        qAbs(glyphToDeviceMatrix.m12()) > GLYPH_MAX_SKEW ||
+        qAbs(glyphToDeviceMatrix.m21()) > GLYPH_MAX_SKEW)
+    {
+        return QImage();
+    }
+
+    const PDFReal scaleX = std::round(glyphToDeviceMatrix.m11() * GLYPH_SCALE_QUANTIZATION);
+    const PDFReal scaleY = std::round(glyphToDeviceMatrix.m22() * GLYPH_SCALE_QUANTIZATION);
+    const PDFReal originX = std::round(glyphToDeviceMatrix.dx() * GLYPH_SUBPIXEL_POSITIONS);
+    const PDFReal originY = std::round(glyphToDeviceMatrix.dy() * GLYPH_SUBPIXEL_POSITIONS);
+    if (qAbs(scaleX) > std::numeric_limits<qint32>::max() || qAbs(scaleY) > std::numeric_limits<qint32>::max() ||
+        qAbs(originX) > std::numeric_limits<qint32>::max() || qAbs(originY) > std::numeric_limits<qint32>::max())
+    {
+        return QImage();
+    }
+
+    // Split the origin into whole pixels and subpixel offset
+    const int quantizedOriginX = static_cast<int>(originX);
+    const int quantizedOriginY = static_cast<int>(originY);
+    const int pixelOriginX = static_cast<int>(std::floor(PDFReal(quantizedOriginX) / GLYPH_SUBPIXEL_POSITIONS));
+    const int pixelOriginY = static_cast<int>(std::floor(PDFReal(quantizedOriginY) / GLYPH_SUBPIXEL_POSITIONS));
+
+    PDFGlyphCacheKey key;
+    key.fontId = fontId;
+    key.glyphIndex = glyphIndex;
+    key.scaleX = static_cast<qint32>(scaleX);
+    key.scaleY = static_cast<qint32>(scaleY);
+    key.subpixelX = static_cast<quint8>(quantizedOriginX - pixelOriginX * GLYPH_SUBPIXEL_POSITIONS);
+    key.subpixelY = static_cast<quint8>(quantizedOriginY - pixelOriginY * GLYPH_SUBPIXEL_POSITIONS);
+    key.color = color.rgba();
+
+    {
+        QMutexLocker lock(&m_mutex);
+        if (const Glyph* glyph = m_cache.object(key))
+        {
+            position = QPoint(pixelOriginX, pixelOriginY) + glyph->offset;
+            return glyph->image;
+        }
+    }
+
+    // Map the path to the device space, so the glyph origin lies at the quantized subpixel
+    // position of the pixel (0, 0). Glyphs with the same key then have the same image.
+    QTransform localMatrix = pathToDeviceMatrix;
+    localMatrix *= QTransform::fromTranslate(PDFReal(quantizedOriginX) / GLYPH_SUBPIXEL_POSITIONS - glyphToDeviceMatrix.dx() - pixelOriginX,
+                                             PDFReal(quantizedOriginY) / GLYPH_SUBPIXEL_POSITIONS - glyphToDeviceMatrix.dy() - pixelOriginY);
+    Glyph glyph = createGlyph(localMatrix.map(path), color);
+
+    QMutexLocker lock(&m_mutex);
+    position = QPoint(pixelOriginX, pixelOriginY) + glyph.offset;
+    QImage image = glyph.image;
+    m_cache.insert(key, new Glyph(qMove(glyph)), qMax<qint64>(image.sizeInBytes(), sizeof(Glyph)));
+    return image;
+}
+
+PDFGlyphCache::Glyph PDFGlyphCache::createGlyph(const QPainterPath& devicePath, QColor color)
+{
+    Glyph glyph;
+
+    const QRect boundingRect = devicePath.boundingRect().toAlignedRect();
+    if (boundingRect.isEmpty() || boundingRect.width() > GLYPH_MAX_SIZE || boundingRect.height() > GLYPH_MAX_SIZE)
+    {
+        return glyph;
+    }
+
+    PDFCoverageRasterizer rasterizer(QRect(QPoint(0, 0), boundingRect.size()));
+    rasterizer.addPath(devicePath.translated(-boundingRect.topLeft()));
+
+    glyph.offset = boundingRect.topLeft();
+    glyph.image = QImage(boundingRect.size(), QImage::Format_ARGB32_Premultiplied);
+    glyph.image.fill(Qt::transparent);
+
+    const QRgb premultipliedColor = qPremultiply(color.rgba());
+    const int red = qRed(premultipliedColor);
+    const int green = qGreen(premultipliedColor);
+    const int blue = qBlue(premultipliedColor);
+    const int alpha = qAlpha(premultipliedColor);
+
+    for (const PDFCoverageRasterizer::Span& span : rasterizer.createSpans(devicePath.fillRule()))
+    {
+        const int coverage = qRound(span.coverage * 255.0f);
+        auto scale = [coverage](int value) { return (value * coverage + 127) / 255; };
+        const QRgb pixel = qRgba(scale(red), scale(green), scale(blue), scale(alpha));
+
+        QRgb* scanline = reinterpret_cast<QRgb*>(glyph.image.scanLine(span.y)) + span.x;
+        std::fill(scanline, scanline + span.length, pixel);
+    }
+
+    return glyph;
+}
+
+void PDFGlyphCache::setCacheLimit(qint64 cacheLimit)
+{
+    QMutexLocker lock(&m_mutex);
+    m_cache.setMaxCost(cacheLimit);
+}
+
+void PDFGlyphCache::clear()
+{
+    QMutexLocker lock(&m_mutex);
+    m_cache.clear();
+}
+
+}   // namespace pdf
@@ -0,0 +1,110 @@
+//    Copyright (C) 2024 Jakub Melka
+//
+//    This file is part of PDF4QT.
+//
+//    PDF4QT is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    with the written consent of the copyright owner, any later version.
+//
+//    PDF4QT is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public License
+//    along with PDF4QT.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef PDFGLYPHCACHE_H
+#define PDFGLYPHCACHE_H
+
+#include "pdffont.h"
+
+#include <QCache>
+#include <QMutex>
+#include <QImage>
+#include <QColor>
+#include <QTransform>
+#include <QPainterPath>
+
+namespace pdf
+{
+
+struct PDFGlyphCacheKey
+{
+    bool operator==(const PDFGlyphCacheKey&) const = default;
+
+    quint64 fontId = 0;     ///< Instance identifier of the realized font
+    GID glyphIndex = 0;     ///< Index of the glyph in the realized font
+    qint32 scaleX = 0;      ///< Horizontal scale of the glyph to the device space (quantized)
+    qint32 scaleY = 0;      ///< Vertical scale of the glyph to the device space (quantized)
+    quint8 subpixelX = 0;   ///< Horizontal subpixel offset of the glyph origin
+    quint8 subpixelY = 0;   ///< Vertical subpixel offset of the glyph origin
+    QRgb color = 0;         ///< Fill color of the glyph
+};
+
+inline size_t qHash(const PDFGlyphCacheKey& key, size_t seed = 0)
+{
+    return qHashMulti(seed, key.fontId, key.glyphIndex, key.scaleX, key.scaleY, key.subpixelX, key.subpixelY, key.color);
+}
+
+/// Cache of antialiased glyphs. Glyph is rasterized into coverage spans,
+/// and colored by the fill color, so drawing glyph from the cache is a simple
+/// image blit. Glyphs are identified by the font, glyph index, scale of the glyph
+/// to the device space and subpixel offset of the glyph origin, so only glyphs
+/// mapped to the device space by axis-aligned transformation can be cached.
+/// Realized fonts have process-wide unique identifiers, so one instance
+/// of the cache is shared by all documents. Cache is thread safe.
+class PDF4QTLIBCORESHARED_EXPORT PDFGlyphCache
+{
+public:
+    /// Constructs glyph cache
+    /// \param cacheLimit Cache limit [bytes]
+    explicit PDFGlyphCache(qint64 cacheLimit);
+
+    /// Returns global instance of the glyph cache
+    static PDFGlyphCache* getInstance();
+
+    /// Returns rasterized glyph, or null image, if glyph can't be cached (transformation
+    /// is not axis-aligned, or glyph is too large). If glyph is not found in the cache,
+    /// it is rasterized from the path. Image is premultiplied and it should be drawn
+    /// without any transformation in the device space at \p position.
+    /// \param fontId Instance identifier of the realized font
+    /// \param glyphIndex Index of the glyph
+    /// \param glyphMatrix Matrix mapping glyph to the path coordinates
+    /// \param path Glyph path
+    /// \param pathToDeviceMatrix Matrix mapping path to the device space
+    /// \param color Fill color
+    /// \param[out] position Position of the image in the device space
+    QImage getGlyph(quint64 fontId,
+                    GID glyphIndex,
+                    const QTransform& glyphMatrix,
+                    const QPainterPath& path,
+                    const QTransform& pathToDeviceMatrix,
+                    QColor color,
+                    QPoint& position) const;
+
+    /// Sets cache limit in bytes
+    /// \param cacheLimit Cache limit [bytes]
+    void setCacheLimit(qint64 cacheLimit);
+
+    /// Clears the cache
+    void clear();
+
+private:
+    struct Glyph
+    {
+        QImage image;   ///< Colored glyph image (null, if glyph is too large)
+        QPoint offset;  ///< Offset of the image from the glyph origin rounded down to whole pixels
+    };
+
+    /// Rasterizes path into colored premultiplied image
+    static Glyph createGlyph(const QPainterPath& devicePath, QColor color);
+
+    mutable QMutex m_mutex;
+    mutable QCache<PDFGlyphCacheKey, Glyph> m_cache;
+};
+
+}   // namespace pdf
+
+#endif // PDFGLYPHCACHE_H
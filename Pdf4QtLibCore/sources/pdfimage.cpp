@@ -54,7 +54,8 @@ PDFImage PDFImage::createImage(const PDFDocument* document,
                                PDFColorSpacePointer colorSpace,
                                bool isSoftMask,
                                RenderingIntent renderingIntent,
-                               PDFRenderErrorReporter* errorReporter)
+                               PDFRenderErrorReporter* errorReporter,
+                               QSize targetSize)
 {
     PDFImage image;
     image.m_colorSpace = colorSpace;
@@ -130,7 +131,7 @@ PDFImage PDFImage::createImage(const PDFDocument* document,
         }
         else if (object.isStream())
         {
-            PDFImage softMaskImage = createImage(document, object.getStream(), PDFColorSpacePointer(new PDFDeviceGrayColorSpace()), false, renderingIntent, errorReporter);
+            PDFImage softMaskImage = createImage(document, object.getStream(), PDFColorSpacePointer(new PDFDeviceGrayColorSpace()), false, renderingIntent, errorReporter, targetSize);
 
             if (softMaskImage.m_imageData.getMaskingType() != PDFImageData::MaskingType::ImageMask ||
                 softMaskImage.m_imageData.getColorChannels() != 1 ||
@@ -161,7 +162,7 @@ PDFImage PDFImage::createImage(const PDFDocument* document,
 
         if (softMaskObject.isStream())
         {
-            PDFImage softMaskImage = createImage(document, softMaskObject.getStream(), PDFColorSpacePointer(new PDFDeviceGrayColorSpace()), true, renderingIntent, errorReporter);
+            PDFImage softMaskImage = createImage(document, softMaskObject.getStream(), PDFColorSpacePointer(new PDFDeviceGrayColorSpace()), true, renderingIntent, errorReporter, targetSize);
             maskingType = PDFImageData::MaskingType::SoftMask;
             image.m_softMask = qMove(softMaskImage.m_imageData);
         }
@@ -176,26 +177,31 @@ PDFImage PDFImage::createImage(const PDFDocument* document,
         maskingType = PDFImageData::MaskingType::ImageMask;
     }
 
+    static constexpr PDFNameAtom filterAtom(PDF_STREAM_DICT_FILTER);
+    static constexpr PDFNameAtom fileFilterAtom(PDF_STREAM_DICT_FILE_FILTER);
+    static constexpr PDFNameAtom decodeParmsAtom(PDF_STREAM_DICT_DECODE_PARMS);
+    static constexpr PDFNameAtom fileDecodeParmsAtom(PDF_STREAM_DICT_FDECODE_PARMS);
+
     // Retrieve filters
     PDFObject filters;
-    if (dictionary->hasKey(PDF_STREAM_DICT_FILTER))
+    if (dictionary->hasKey(filterAtom))
     {
-        filters = document->getObject(dictionary->get(PDF_STREAM_DICT_FILTER));
+        filters = document->getObject(dictionary->get(filterAtom));
     }
-    else if (dictionary->hasKey(PDF_STREAM_DICT_FILE_FILTER))
+    else if (dictionary->hasKey(fileFilterAtom))
     {
-        filters = document->getObject(dictionary->get(PDF_STREAM_DICT_FILE_FILTER));
+        filters = document->getObject(dictionary->get(fileFilterAtom));
     }
 
     // Retrieve filter parameters
     PDFObject filterParameters;
-    if (dictionary->hasKey(PDF_STREAM_DICT_DECODE_PARMS))
+    if (dictionary->hasKey(decodeParmsAtom))
     {
-        filterParameters = document->getObject(dictionary->get(PDF_STREAM_DICT_DECODE_PARMS));
+        filterParameters = document->getObject(dictionary->get(decodeParmsAtom));
     }
-    else if (dictionary->hasKey(PDF_STREAM_DICT_FDECODE_PARMS))
+    else if (dictionary->hasKey(fileDecodeParmsAtom))
     {
-        filterParameters = document->getObject(dictionary->get(PDF_STREAM_DICT_FDECODE_PARMS));
+        filterParameters = document->getObject(dictionary->get(fileDecodeParmsAtom));
     }
 
     QByteArray imageFilterName;
@@ -339,6 +345,28 @@ PDFImage PDFImage::createImage(const PDFDocument* document,
                 }
             }
 
+            // Decode reduced image, if it is drawn small. Libjpeg can scale the image
+            // down by factor 1/2, 1/4 or 1/8 directly in the inverse DCT, which is
+            // much faster than decoding the full image and scaling it afterwards.
+            if (targetSize.isValid())
+            {
+                auto getScaledDimension = [](JDIMENSION dimension, unsigned int denominator) -> JDIMENSION
+                {
+                    return (dimension + denominator - 1) / denominator;
+                };
+
+                unsigned int scaleDenominator = 1;
+                while (scaleDenominator < 8 &&
+                       getScaledDimension(codec.image_width, scaleDenominator * 2) >= JDIMENSION(targetSize.width()) &&
+                       getScaledDimension(codec.image_height, scaleDenominator * 2) >= JDIMENSION(targetSize.height()))
+                {
+                    scaleDenominator *= 2;
+                }
+
+                codec.scale_num = 1;
+                codec.scale_denom = scaleDenominator;
+            }
+
             jpeg_start_decompress(&codec);
 
             const JDIMENSION rowStride = codec.output_width * codec.output_components;
@@ -430,6 +458,45 @@ PDFImage PDFImage::createImage(const PDFDocument* document,
 
                 if (opj_read_header(opjStream, codec, &jpegImage))
                 {
+                    // Discard highest resolution levels of the wavelet decomposition, if image
+                    // is drawn small. Each discarded level halves the image dimensions.
+                    if (targetSize.isValid())
+                    {
+                        OPJ_UINT32 resolutionCount = 1;
+                        if (opj_codestream_info_v2_t* codestreamInfo = opj_get_cstr_info(codec))
+                        {
+                            if (codestreamInfo->m_default_tile_info.tccp_info && codestreamInfo->nbcomps > 0)
+                            {
+                                resolutionCount = std::numeric_limits<OPJ_UINT32>::max();
+                                for (OPJ_UINT32 i = 0; i < codestreamInfo->nbcomps; ++i)
+                                {
+                                    resolutionCount = qMin(resolutionCount, codestreamInfo->m_default_tile_info.tccp_info[i].numresolutions);
+                                }
+                            }
+                            opj_destroy_cstr_info(&codestreamInfo);
+                        }
+
+                        const OPJ_UINT32 imageWidth = jpegImage->x1 - jpegImage->x0;
+                        const OPJ_UINT32 imageHeight = jpegImage->y1 - jpegImage->y0;
+                        auto getReducedDimension = [](OPJ_UINT32 dimension, OPJ_UINT32 reduction) -> OPJ_UINT32
+                        {
+                            return (dimension + (1u << reduction) - 1) >> reduction;
+                        };
+
+                        OPJ_UINT32 reduction = 0;
+                        while (reduction + 1 < resolutionCount &&
+                               getReducedDimension(imageWidth, reduction + 1) >= OPJ_UINT32(targetSize.width()) &&
+                               getReducedDimension(imageHeight, reduction + 1) >= OPJ_UINT32(targetSize.height()))
+                        {
+                            ++reduction;
+                        }
+
+                        if (reduction > 0)
+                        {
+                            opj_set_decoded_resolution_factor(codec, reduction);
+                        }
+                    }
+
                     if (opj_set_decode_area(codec, jpegImage, decompressParameters.DA_x0, decompressParameters.DA_y0, decompressParameters.DA_x1, decompressParameters.DA_y1))
                     {
                         if (opj_decode(codec, opjStream, jpegImage))
@@ -672,13 +739,11 @@ PDFImage PDFImage::createImage(const PDFDocument* document,
         parameters.damagedRowsBeforeError = loader.readIntegerFromDictionary(filterParamsDictionary, "DamagedRowsBeforeError", 0);
         parameters.decode = !decode.empty() ? qMove(decode) : std::vector<PDFReal>({ 0.0, 1.0 });
 
-        QByteArray imageDataBuffer = document->getDecodedStream(stream);
-        PDFCCITTFaxDecoder decoder(&imageDataBuffer, parameters);
+        PDFCCITTFaxDecoder decoder(&content, parameters);
         image.m_imageData = decoder.decode();
     }
     else if (imageFilterName == "JBIG2Decode")
     {
-        QByteArray data = document->getDecodedStream(stream);
         QByteArray globalData;
         if (filterParamsDictionary)
         {
@@ -689,7 +754,7 @@ PDFImage PDFImage::createImage(const PDFDocument* document,
             }
         }
 
-        PDFJBIG2Decoder decoder(qMove(data), qMove(globalData), errorReporter);
+        PDFJBIG2Decoder decoder(qMove(content), qMove(globalData), errorReporter);
         image.m_imageData = decoder.decode(maskingType);
         image.m_imageData.setDecode(!decode.empty() ? qMove(decode) : std::vector<PDFReal>({ 0.0, 1.0 }));
     }
@@ -714,8 +779,7 @@ PDFImage PDFImage::createImage(const PDFDocument* document,
         // Calculate stride
         const unsigned int stride = (components * bitsPerComponent * width + 7) / 8;
 
-        QByteArray imageDataBuffer = document->getDecodedStream(stream);
-        image.m_imageData = PDFImageData(components, bitsPerComponent, width, height, stride, maskingType, qMove(imageDataBuffer), qMove(mask), qMove(decode), qMove(matte));
+        image.m_imageData = PDFImageData(components, bitsPerComponent, width, height, stride, maskingType, qMove(content), qMove(mask), qMove(decode), qMove(matte));
     }
     else if (imageMask)
     {
@@ -739,13 +803,40 @@ PDFImage PDFImage::createImage(const PDFDocument* document,
         // Calculate stride
         const unsigned int stride = (width + 7) / 8;
 
-        QByteArray imageDataBuffer = document->getDecodedStream(stream);
-        image.m_imageData = PDFImageData(1, bitsPerComponent, width, height, stride, maskingType, qMove(imageDataBuffer), qMove(mask), qMove(decode), qMove(matte));
+        image.m_imageData = PDFImageData(1, bitsPerComponent, width, height, stride, maskingType, qMove(content), qMove(mask), qMove(decode), qMove(matte));
     }
 
     return image;
 }
 
+int PDFImage::getReductionLevel(QSize imageSize, QSize targetSize)
+{
+    if (!imageSize.isValid() || !targetSize.isValid())
+    {
+        return 0;
+    }
+
+    int reductionLevel = 0;
+    while (reductionLevel < 30)
+    {
+        const QSize reducedSize = getReducedSize(imageSize, reductionLevel + 1);
+        if (reducedSize.width() < targetSize.width() || reducedSize.height() < targetSize.height())
+        {
+            break;
+        }
+
+        ++reductionLevel;
+    }
+
+    return reductionLevel;
+}
+
+QSize PDFImage::getReducedSize(QSize imageSize, int reductionLevel)
+{
+    const qint64 divisor = qint64(1) << reductionLevel;
+    return QSize(int((imageSize.width() + divisor - 1) / divisor), int((imageSize.height() + divisor - 1) / divisor));
+}
+
 QImage PDFImage::getImage(const PDFCMS* cms,
                           PDFRenderErrorReporter* reporter,
                           const PDFOperationControl* operationControl) const
@@ -870,4 +961,55 @@ PDFAlternateImage PDFAlternateImage::parse(const PDFObjectStorage* storage, PDFO
     return result;
 }
 
+PDFImageCache::PDFImageCache(qint64 cacheLimit) :
+    m_document(nullptr)
+{
+    m_cache.setMaxCost(cacheLimit);
+}
+
+void PDFImageCache::setDocument(const PDFModifiedDocument& document)
+{
+    QMutexLocker lock(&m_mutex);
+    if (m_document != document)
+    {
+        m_document = document;
+
+        // Images are identified by object references, so if page contents
+        // were changed, object references can point to different images.
+        if (document.hasReset() || document.hasPageContentsChanged())
+        {
+            m_cache.clear();
+        }
+    }
+}
+
+QImage PDFImageCache::getImage(const PDFImageCacheKey& key) const
+{
+    QMutexLocker lock(&m_mutex);
+    if (const QImage* image = m_cache.object(key))
+    {
+        return *image;
+    }
+
+    return QImage();
+}
+
+void PDFImageCache::insertImage(const PDFImageCacheKey& key, const QImage& image) const
+{
+    QMutexLocker lock(&m_mutex);
+    m_cache.insert(key, new QImage(image), image.sizeInBytes());
+}
+
+void PDFImageCache::setCacheLimit(qint64 cacheLimit)
+{
+    QMutexLocker lock(&m_mutex);
+    m_cache.setMaxCost(cacheLimit);
+}
+
+void PDFImageCache::clear()
+{
+    QMutexLocker lock(&m_mutex);
+    m_cache.clear();
+}
+
 }   // namespace pdf
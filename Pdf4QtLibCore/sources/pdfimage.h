@@ -23,6 +23,9 @@
 #include "pdfoperationcontrol.h"
 
 #include <QByteArray>
+#include <QCache>
+#include <QImage>
+#include <QMutex>
 
 class QByteArray;
 
@@ -31,6 +34,7 @@ namespace pdf
 class PDFStream;
 class PDFDocument;
 class PDFObjectStorage;
+class PDFModifiedDocument;
 class PDFRenderErrorReporter;
 
 /// Alternate image object. Defines alternate image, which
@@ -67,12 +71,30 @@ public:
     /// \param isSoftMask Is it a soft mask image?
     /// \param renderingIntent Default rendering intent of the image
     /// \param errorReporter Error reporter for reporting errors (or warnings)
+    /// \param targetSize Size of the image on the output device in pixels. If it is valid,
+    ///        JPEG and JPEG 2000 images are decoded at the lowest resolution which isn't
+    ///        smaller than this size. If it is invalid, images are decoded at full resolution.
     static PDFImage createImage(const PDFDocument* document,
                                 const PDFStream* stream,
                                 PDFColorSpacePointer colorSpace,
                                 bool isSoftMask,
                                 RenderingIntent renderingIntent,
-                                PDFRenderErrorReporter* errorReporter);
+                                PDFRenderErrorReporter* errorReporter,
+                                QSize targetSize = QSize());
+
+    /// Returns reduction level of the image drawn with the target size. Image is needed
+    /// only at 1 / 2^level of its full resolution, where level is the greatest number,
+    /// for which image reduced by 2^level isn't smaller than the target size. Image decoded
+    /// at size returned by getReducedSize can be used for all target sizes with the same level.
+    /// \param imageSize Size of the image at full resolution
+    /// \param targetSize Size of the image on the output device in pixels
+    static int getReductionLevel(QSize imageSize, QSize targetSize);
+
+    /// Returns size of the image reduced by the reduction level (each dimension
+    /// is divided by 2^level and rounded up).
+    /// \param imageSize Size of the image at full resolution
+    /// \param reductionLevel Reduction level
+    static QSize getReducedSize(QSize imageSize, int reductionLevel);
 
     /// Returns image transformed from image data and color space
     QImage getImage(const PDFCMS* cms,
@@ -130,6 +152,69 @@ private:
     PDFObject m_pointData;
 };
 
+/// Key of the decoded image in the image cache
+struct PDFImageCacheKey
+{
+    bool operator==(const PDFImageCacheKey&) const = default;
+
+    PDFObjectReference reference;   ///< Reference to the image XObject
+    quint64 cmsInstanceId = 0;      ///< Identifier of the color management system instance
+    RenderingIntent renderingIntent = RenderingIntent::Auto;
+    int reductionLevel = 0;         ///< Reduction level of the decoded image (see PDFImage::getReductionLevel)
+
+    /// Default color spaces (DefaultGray, DefaultRGB, DefaultCMYK) of the resources,
+    /// which replace device color spaces of the image (invalid reference, if not present)
+    PDFObjectReference defaultColorSpaces[3];
+};
+
+inline size_t qHash(const PDFImageCacheKey& key, size_t seed = 0)
+{
+    return qHashMulti(seed, key.reference.objectNumber, key.reference.generation, key.cmsInstanceId,
+                      static_cast<int>(key.renderingIntent), key.reductionLevel,
+                      key.defaultColorSpaces[0].objectNumber, key.defaultColorSpaces[1].objectNumber, key.defaultColorSpaces[2].objectNumber);
+}
+
+/// Image cache, which caches decoded images (i.e. images converted to the output
+/// color space by the color management system). Images are identified by reference
+/// of the image XObject, so image drawn on many pages is decoded only once. Least recently
+/// used images are removed from the cache, when cache limit is exceeded. Cache
+/// is thread safe, so it can be shared between multiple compiling / rendering threads.
+class PDF4QTLIBCORESHARED_EXPORT PDFImageCache
+{
+public:
+    /// Constructs image cache
+    /// \param cacheLimit Cache limit [bytes]
+    explicit PDFImageCache(qint64 cacheLimit);
+
+    /// Sets the document to the cache. Whole cache is cleared,
+    /// if it is needed.
+    /// \param document Document to be setted
+    void setDocument(const PDFModifiedDocument& document);
+
+    /// Retrieves image from the cache. If image is not found,
+    /// then null image is returned.
+    /// \param key Key of the image
+    QImage getImage(const PDFImageCacheKey& key) const;
+
+    /// Inserts image into the cache. If image is larger, than
+    /// cache limit, then it is not inserted.
+    /// \param key Key of the image
+    /// \param image Decoded image
+    void insertImage(const PDFImageCacheKey& key, const QImage& image) const;
+
+    /// Sets cache limit in bytes
+    /// \param cacheLimit Cache limit [bytes]
+    void setCacheLimit(qint64 cacheLimit);
+
+    /// Clears the cache
+    void clear();
+
+private:
+    mutable QMutex m_mutex;
+    const PDFDocument* m_document;
+    mutable QCache<PDFImageCacheKey, QImage> m_cache;
+};
+
 }   // namespace pdf
 
 #endif // PDFIMAGE_H
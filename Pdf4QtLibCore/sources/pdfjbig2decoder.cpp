@@ -1119,21 +1119,28 @@ PDFImageData PDFJBIG2Decoder::decode(PDFImageData::MaskingType maskingType)
 
     if (m_pageBitmap.isValid())
     {
-        PDFBitWriter writer(1);
-
         const int columns = m_pageBitmap.getWidth();
         const int rows = m_pageBitmap.getHeight();
+        const int bytesPerRow = (columns + 7) / 8;
+
+        // Packed rows are converted directly to the bytes of the image, black pixel
+        // is 1 in the bitmap, but 0 in the image. Padding bits of the last byte are zero.
+        const uint8_t lastByteMask = (columns % 8) ? static_cast<uint8_t>(0xFF << (8 - columns % 8)) : 0xFF;
+        QByteArray imageData(bytesPerRow * rows, Qt::Uninitialized);
+        uint8_t* output = reinterpret_cast<uint8_t*>(imageData.data());
 
         for (int row = 0; row < rows; ++row)
         {
-            for (int column = 0; column < columns; ++column)
+            const uint64_t* rowData = m_pageBitmap.getRow(row);
+            for (int i = 0; i < bytesPerRow; ++i)
             {
-                writer.write(!m_pageBitmap.getPixel(column, row));
+                output[i] = static_cast<uint8_t>(~(rowData[i / 8] >> (56 - 8 * (i % 8))));
             }
-            writer.finishLine();
+            output[bytesPerRow - 1] &= lastByteMask;
+            output += bytesPerRow;
         }
 
-        return PDFImageData(1, 1, static_cast<uint32_t>(columns), static_cast<uint32_t>(rows), static_cast<uint32_t>((columns + 7) / 8), maskingType, writer.takeByteArray(), { }, { }, { });
+        return PDFImageData(1, 1, static_cast<uint32_t>(columns), static_cast<uint32_t>(rows), static_cast<uint32_t>(bytesPerRow), maskingType, qMove(imageData), { }, { }, { });
     }
 
     return PDFImageData();
@@ -2381,7 +2388,8 @@ void PDFJBIG2Decoder::processHalftoneRegion(const PDFJBIG2SegmentHeader& header)
     parameters.arithmeticDecoderState = &genericState;
     parameters.data = qMove(mmrData);
 
-    PDFJBIG2Bitmap GI(HGW, HGH, 0x00);
+    // Grayscale image has multiple bits per pixel, so it can't be stored in the bitmap
+    std::vector<uint32_t> GI(HGW * HGH, 0);
     for (int J = HBPP - 1; J >= 0; --J)
     {
         PDFJBIG2Bitmap PLANE = readBitmap(parameters);
@@ -2418,9 +2426,9 @@ void PDFJBIG2Decoder::processHalftoneRegion(const PDFJBIG2SegmentHeader& header)
             for (int y = 0; y < static_cast<int>(HGH); ++y)
             {
                 // Old bit is in the first position of grayscale image
-                const uint8_t oldPixel = GI.getPixel(x, y);
-                const uint8_t bit = (oldPixel ^ PLANE.getPixel(x, y)) & 0x01;
-                GI.setPixel(x, y, (oldPixel << 1) | bit);
+                uint32_t& pixel = GI[y * HGW + x];
+                const uint32_t bit = (pixel ^ PLANE.getPixel(x, y)) & 0x01;
+                pixel = (pixel << 1) | bit;
             }
         }
     }
@@ -2435,7 +2443,7 @@ void PDFJBIG2Decoder::processHalftoneRegion(const PDFJBIG2SegmentHeader& header)
             const int y = (static_cast<int>(HGY) + MG * static_cast<int>(HRX) - NG * static_cast<int>(HRY)) / 256;
 
             /* 6.6.5.1 1) a) ii) */
-            const uint8_t index = GI.getPixel(NG, MG);
+            const uint32_t index = GI[MG * HGW + NG];
             if (Q_UNLIKELY(index >= HNUMPATS))
             {
                 throw PDFException(PDFTranslationContext::tr("JBIG2 halftoning pattern index %1 out of bounds [0, %2]").arg(index).arg(HNUMPATS));
@@ -2983,6 +2991,39 @@ PDFJBIG2Bitmap PDFJBIG2Decoder::readBitmap(PDFJBIG2BitmapDecodingParameters& par
         Q_ASSERT(parameters.arithmeticDecoder);
         PDFJBIG2ArithmeticDecoder& decoder = *parameters.arithmeticDecoder;
 
+        struct ContextWindow
+        {
+            int offsetY = 0;    ///< Row of the window relative to the decoded pixel
+            int right = 0;      ///< Offset of the rightmost pixel of the window relative to the decoded pixel
+            int size = 0;       ///< Number of pixels of the window
+            uint32_t bits = 0;  ///< Pixels of the window
+        };
+
+        // Windows of the current row, previous row and second previous row, see figures below
+        std::array<ContextWindow, 3> windows;
+        switch (parameters.GBTEMPLATE)
+        {
+            case 0:
+                windows = { ContextWindow{ 0, -1, 4 }, ContextWindow{ -1, 2, 5 }, ContextWindow{ -2, 1, 3 } };
+                break;
+
+            case 1:
+                windows = { ContextWindow{ 0, -1, 3 }, ContextWindow{ -1, 2, 5 }, ContextWindow{ -2, 2, 4 } };
+                break;
+
+            case 2:
+                windows = { ContextWindow{ 0, -1, 2 }, ContextWindow{ -1, 1, 4 }, ContextWindow{ -2, 1, 3 } };
+                break;
+
+            case 3:
+                windows = { ContextWindow{ 0, -1, 4 }, ContextWindow{ -1, 1, 5 }, ContextWindow{ -2, 0, 0 } };
+                break;
+
+            default:
+                Q_ASSERT(false);
+                break;
+        }
+
         PDFJBIG2Bitmap bitmap(parameters.GBW, parameters.GBH, 0x00);
         for (int y = 0; y < parameters.GBH; ++y)
         {
@@ -3000,147 +3041,121 @@ PDFJBIG2Bitmap PDFJBIG2Decoder::readBitmap(PDFJBIG2BitmapDecodingParameters& par
                 }
             }
 
+            // Template pixels in rows y - 2, y - 1 and y are kept in sliding windows,
+            // the lowest bit of the window is its rightmost pixel. Windows are shifted
+            // by one pixel after each decoded pixel, so only the adaptive template
+            // pixels are read from the bitmap for each pixel.
+            for (ContextWindow& window : windows)
+            {
+                window.bits = 0;
+                for (int i = 0; i < window.size; ++i)
+                {
+                    window.bits |= uint32_t(bitmap.getPixelSafe(window.right - i, y + window.offsetY)) << i;
+                }
+            }
+
+            auto getATPixel = [&](int x, int index) -> uint32_t
+            {
+                return bitmap.getPixelSafe(x + parameters.GBAT[index].x, y + parameters.GBAT[index].y);
+            };
+
             for (int x = 0; x < parameters.GBW; ++x)
             {
                 // Check, if we have to skip pixel. Pixel should be set to 0, but it is done
                 // in the initialization of the bitmap.
-                if (parameters.SKIP && parameters.SKIP->getPixelSafe(x, y))
+                if (!parameters.SKIP || !parameters.SKIP->getPixelSafe(x, y))
                 {
-                    continue;
-                }
+                    uint32_t pixelContext = 0;
 
-                uint16_t pixelContext = 0;
-                uint16_t pixelContextShift = 0;
-                auto createContextBit = [&](int offsetX, int offsetY)
-                {
-                    uint16_t bit = bitmap.getPixelSafe(offsetX, offsetY) ? 1 : 0;
-                    bit = bit << pixelContextShift;
-                    pixelContext |= bit;
-                    ++pixelContextShift;
-                };
-
-                // Create pixel context based on used template
-                switch (parameters.GBTEMPLATE)
-                {
-                    case 0:
+                    // Create pixel context based on used template
+                    switch (parameters.GBTEMPLATE)
                     {
-                        //  Figure 8. Reused context for coding the SLTP value
-                        //
-                        //          ┌───┬───┬───┬───┬───┐
-                        //          │A15│ 14│ 13│ 12│A11│
-                        //      ┌───┼───┼───┼───┼───┼───┼───┐
-                        //      │A10│ 9 │ 8 │ 7 │ 6 │ 5 │A4 │
-                        //  ┌───┼───┼───┼───┼───┼───┴───┴───┘
-                        //  │ 3 │ 2 │ 1 │ 0 │ X │
-                        //  └───┴───┴───┴───┴───┘
-
-                        // 16-bit context
-                        createContextBit(x - 1, y);
-                        createContextBit(x - 2, y);
-                        createContextBit(x - 3, y);
-                        createContextBit(x - 4, y);
-                        createContextBit(x + parameters.GBAT[0].x, y + parameters.GBAT[0].y);
-                        createContextBit(x + 2, y - 1);
-                        createContextBit(x + 1, y - 1);
-                        createContextBit(x + 0, y - 1);
-                        createContextBit(x - 1, y - 1);
-                        createContextBit(x - 2, y - 1);
-                        createContextBit(x + parameters.GBAT[1].x, y + parameters.GBAT[1].y);
-                        createContextBit(x + parameters.GBAT[2].x, y + parameters.GBAT[2].y);
-                        createContextBit(x + 1, y - 2);
-                        createContextBit(x + 0, y - 2);
-                        createContextBit(x - 1, y - 2);
-                        createContextBit(x + parameters.GBAT[3].x, y + parameters.GBAT[3].y);
-                        break;
-                    }
+                        case 0:
+                        {
+                            //  Figure 8. Reused context for coding the SLTP value
+                            //
+                            //          ┌───┬───┬───┬───┬───┐
+                            //          │A15│ 14│ 13│ 12│A11│
+                            //      ┌───┼───┼───┼───┼───┼───┼───┐
+                            //      │A10│ 9 │ 8 │ 7 │ 6 │ 5 │A4 │
+                            //  ┌───┼───┼───┼───┼───┼───┴───┴───┘
+                            //  │ 3 │ 2 │ 1 │ 0 │ X │
+                            //  └───┴───┴───┴───┴───┘
+
+                            // 16-bit context
+                            pixelContext = windows[0].bits | (getATPixel(x, 0) << 4) | (windows[1].bits << 5) | (getATPixel(x, 1) << 10) |
+                                           (getATPixel(x, 2) << 11) | (windows[2].bits << 12) | (getATPixel(x, 3) << 15);
+                            break;
+                        }
 
-                    case 1:
-                    {
-                        //  Figure 9. Reused context for coding the SLTP value
-                        //
-                        //          ┌───┬───┬───┬───┐
-                        //          │ 12│ 11│ 10│ 9 │
-                        //      ┌───┼───┼───┼───┼───┼───┐
-                        //      │ 8 │ 7 │ 6 │ 5 │ 4 │A3 │
-                        //  ┌───┼───┼───┼───┼───┴───┴───┘
-                        //  │ 2 │ 1 │ 0 │ x │
-                        //  └───┴───┴───┴───┘
-
-                        // 13-bit context
-                        createContextBit(x - 1, y);
-                        createContextBit(x - 2, y);
-                        createContextBit(x - 3, y);
-                        createContextBit(x + parameters.GBAT[0].x, y + parameters.GBAT[0].y);
-                        createContextBit(x + 2, y - 1);
-                        createContextBit(x + 1, y - 1);
-                        createContextBit(x + 0, y - 1);
-                        createContextBit(x - 1, y - 1);
-                        createContextBit(x - 2, y - 1);
-                        createContextBit(x + 2, y - 2);
-                        createContextBit(x + 1, y - 2);
-                        createContextBit(x + 0, y - 2);
-                        createContextBit(x - 1, y - 2);
-                        break;
-                    }
+                        case 1:
+                        {
+                            //  Figure 9. Reused context for coding the SLTP value
+                            //
+                            //          ┌───┬───┬───┬───┐
+                            //          │ 12│ 11│ 10│ 9 │
+                            //      ┌───┼───┼───┼───┼───┼───┐
+                            //      │ 8 │ 7 │ 6 │ 5 │ 4 │A3 │
+                            //  ┌───┼───┼───┼───┼───┴───┴───┘
+                            //  │ 2 │ 1 │ 0 │ x │
+                            //  └───┴───┴───┴───┘
+
+                            // 13-bit context
+                            pixelContext = windows[0].bits | (getATPixel(x, 0) << 3) | (windows[1].bits << 4) | (windows[2].bits << 9);
+                            break;
+                        }
 
-                    case 2:
-                    {
-                        //  Figure 10. Reused context for coding the SLTP value
-                        //
-                        //          ┌───┬───┬───┐
-                        //          │ 9 │ 8 │ 7 │
-                        //      ┌───┼───┼───┼───┼───┐
-                        //      │ 6 │ 5 │ 4 │ 3 │A2 │
-                        //      ├───┼───┼───┼───┴───┘
-                        //      │ 1 │ 0 │ x │
-                        //      └───┴───┴───┘
-
-                        // 10-bit context
-                        createContextBit(x - 1, y);
-                        createContextBit(x - 2, y);
-                        createContextBit(x + parameters.GBAT[0].x, y + parameters.GBAT[0].y);
-                        createContextBit(x + 1, y - 1);
-                        createContextBit(x + 0, y - 1);
-                        createContextBit(x - 1, y - 1);
-                        createContextBit(x - 2, y - 1);
-                        createContextBit(x + 1, y - 2);
-                        createContextBit(x + 0, y - 2);
-                        createContextBit(x - 1, y - 2);
-                        break;
-                    }
+                        case 2:
+                        {
+                            //  Figure 10. Reused context for coding the SLTP value
+                            //
+                            //          ┌───┬───┬───┐
+                            //          │ 9 │ 8 │ 7 │
+                            //      ┌───┼───┼───┼───┼───┐
+                            //      │ 6 │ 5 │ 4 │ 3 │A2 │
+                            //      ├───┼───┼───┼───┴───┘
+                            //      │ 1 │ 0 │ x │
+                            //      └───┴───┴───┘
+
+                            // 10-bit context
+                            pixelContext = windows[0].bits | (getATPixel(x, 0) << 2) | (windows[1].bits << 3) | (windows[2].bits << 7);
+                            break;
+                        }
 
-                    case 3:
-                    {
-                        //  Figure 11. Reused context for coding the SLTP value
-                        //
-                        //          ┌───┬───┬───┬───┬───┬───┐
-                        //          │ 9 │ 8 │ 7 │ 6 │ 5 │A4 │
-                        //      ┌───┼───┼───┼───┼───┼───┴───┘
-                        //      │ 3 │ 2 │ 1 │ 0 │ x │
-                        //      └───┴───┴───┴───┴───┘
-
-                        // 10-bit context
-                        createContextBit(x - 1, y);
-                        createContextBit(x - 2, y);
-                        createContextBit(x - 3, y);
-                        createContextBit(x - 4, y);
-                        createContextBit(x + parameters.GBAT[0].x, y + parameters.GBAT[0].y);
-                        createContextBit(x + 1, y - 1);
-                        createContextBit(x + 0, y - 1);
-                        createContextBit(x - 1, y - 1);
-                        createContextBit(x - 2, y - 1);
-                        createContextBit(x - 3, y - 1);
-                        break;
+                        case 3:
+                        {
+                            //  Figure 11. Reused context for coding the SLTP value
+                            //
+                            //          ┌───┬───┬───┬───┬───┬───┐
+                            //          │ 9 │ 8 │ 7 │ 6 │ 5 │A4 │
+                            //      ┌───┼───┼───┼───┼───┼───┴───┘
+                            //      │ 3 │ 2 │ 1 │ 0 │ x │
+                            //      └───┴───┴───┴───┴───┘
+
+                            // 10-bit context
+                            pixelContext = windows[0].bits | (getATPixel(x, 0) << 4) | (windows[1].bits << 5);
+                            break;
+                        }
+
+                        default:
+                        {
+                            Q_ASSERT(false);
+                            break;
+                        }
                     }
 
-                    default:
+                    bitmap.setPixel(x, y, (decoder.readBit(pixelContext, parameters.arithmeticDecoderState)) ? 0xFF : 0x00);
+                }
+
+                // Shift the windows to the next pixel (current pixel is already decoded)
+                for (ContextWindow& window : windows)
+                {
+                    if (window.size > 0)
                     {
-                        Q_ASSERT(false);
-                        break;
+                        const uint32_t mask = (uint32_t(1) << window.size) - 1;
+                        window.bits = ((window.bits << 1) | bitmap.getPixelSafe(x + 1 + window.right, y + window.offsetY)) & mask;
                     }
                 }
-
-                bitmap.setPixel(x, y, (decoder.readBit(pixelContext, parameters.arithmeticDecoderState)) ? 0xFF : 0x00);
             }
         }
 
@@ -3636,23 +3651,26 @@ int32_t PDFJBIG2Decoder::checkInteger(std::optional<int32_t> value)
 
 PDFJBIG2Bitmap::PDFJBIG2Bitmap() :
     m_width(0),
-    m_height(0)
+    m_height(0),
+    m_stride(0)
 {
 
 }
 
 PDFJBIG2Bitmap::PDFJBIG2Bitmap(int width, int height) :
     m_width(width),
-    m_height(height)
+    m_height(height),
+    m_stride((width + 63) / 64)
 {
-    m_data.resize(width * height, 0);
+    m_data.resize(m_stride * height, 0);
 }
 
 PDFJBIG2Bitmap::PDFJBIG2Bitmap(int width, int height, uint8_t fill) :
     m_width(width),
-    m_height(height)
+    m_height(height),
+    m_stride((width + 63) / 64)
 {
-    m_data.resize(width * height, fill);
+    m_data.resize(m_stride * height, fill ? ~uint64_t(0) : uint64_t(0));
 }
 
 PDFJBIG2Bitmap::~PDFJBIG2Bitmap()
@@ -3666,9 +3684,10 @@ PDFJBIG2Bitmap PDFJBIG2Bitmap::getSubbitmap(int offsetX, int offsetY, int width,
 
     for (int y = 0; y < height; ++y)
     {
-        for (int x = 0; x < width; ++x)
+        uint64_t* row = result.m_data.data() + y * result.m_stride;
+        for (int i = 0; i < result.m_stride; ++i)
         {
-            result.setPixel(x, y, getPixelSafe(x + offsetX, y + offsetY));
+            row[i] = getBits(offsetX + i * 64, offsetY + y);
         }
     }
 
@@ -3686,7 +3705,7 @@ void PDFJBIG2Bitmap::paint(const PDFJBIG2Bitmap& bitmap, int offsetX, int offset
     if (expandY && offsetY + bitmap.getHeight() > m_height)
     {
         m_height = offsetY + bitmap.getHeight();
-        m_data.resize(getPixelCount(), expandPixel);
+        m_data.resize(m_stride * m_height, expandPixel ? ~uint64_t(0) : uint64_t(0));
     }
 
     // Check out pathological cases
@@ -3695,49 +3714,73 @@ void PDFJBIG2Bitmap::paint(const PDFJBIG2Bitmap& bitmap, int offsetX, int offset
         return;
     }
 
-    const int targetStartX = offsetX;
+    const int targetStartX = qMax(offsetX, 0);
     const int targetEndX = qMin(offsetX + bitmap.getWidth(), m_width);
-    const int targetStartY = offsetY;
+    const int targetStartY = qMax(offsetY, 0);
     const int targetEndY = qMin(offsetY + bitmap.getHeight(), m_height);
 
-    for (int targetY = targetStartY; targetY < targetEndY; ++targetY)
+    if (targetStartX >= targetEndX)
     {
-        for (int targetX = targetStartX; targetX < targetEndX; ++targetX)
+        return;
+    }
+
+    const int firstWord = targetStartX >> 6;
+    const int lastWord = (targetEndX - 1) >> 6;
+
+    // Source bits are aligned to the words of the target row, mask
+    // selects the pixels of the target word covered by the source bitmap.
+    auto paintWords = [&](auto combine)
+    {
+        for (int targetY = targetStartY; targetY < targetEndY; ++targetY)
         {
-            const int sourceX = targetX - targetStartX;
-            const int sourceY = targetY - targetStartY;
+            uint64_t* row = m_data.data() + targetY * m_stride;
+            const int sourceY = targetY - offsetY;
 
-            if (targetX < 0 || targetX >= m_width || targetY < 0 || targetY >= m_height)
+            for (int word = firstWord; word <= lastWord; ++word)
             {
-                continue;
+                const int wordStartX = word * 64;
+                uint64_t mask = ~uint64_t(0);
+
+                if (wordStartX < targetStartX)
+                {
+                    mask &= ~uint64_t(0) >> (targetStartX - wordStartX);
+                }
+
+                if (wordStartX + 64 > targetEndX)
+                {
+                    mask &= ~(~uint64_t(0) >> (targetEndX - wordStartX));
+                }
+
+                const uint64_t source = bitmap.getBits(wordStartX - offsetX, sourceY);
+                row[word] = combine(row[word], source, mask);
             }
+        }
+    };
 
-            switch (operation)
-            {
-                case PDFJBIG2BitOperation::Or:
-                    setPixel(targetX, targetY, getPixel(targetX, targetY) | bitmap.getPixel(sourceX, sourceY));
-                    break;
+    switch (operation)
+    {
+        case PDFJBIG2BitOperation::Or:
+            paintWords([](uint64_t target, uint64_t source, uint64_t mask) { return target | (source & mask); });
+            break;
 
-                case PDFJBIG2BitOperation::And:
-                    setPixel(targetX, targetY, getPixel(targetX, targetY) & bitmap.getPixel(sourceX, sourceY));
-                    break;
+        case PDFJBIG2BitOperation::And:
+            paintWords([](uint64_t target, uint64_t source, uint64_t mask) { return target & (source | ~mask); });
+            break;
 
-                case PDFJBIG2BitOperation::Xor:
-                    setPixel(targetX, targetY, getPixel(targetX, targetY) ^ bitmap.getPixel(sourceX, sourceY));
-                    break;
+        case PDFJBIG2BitOperation::Xor:
+            paintWords([](uint64_t target, uint64_t source, uint64_t mask) { return target ^ (source & mask); });
+            break;
 
-                case PDFJBIG2BitOperation::NotXor:
-                    setPixel(targetX, targetY, getPixel(targetX, targetY) ^ (~bitmap.getPixel(sourceX, sourceY)));
-                    break;
+        case PDFJBIG2BitOperation::NotXor:
+            paintWords([](uint64_t target, uint64_t source, uint64_t mask) { return target ^ (~source & mask); });
+            break;
 
-                case PDFJBIG2BitOperation::Replace:
-                    setPixel(targetX, targetY, bitmap.getPixel(sourceX, sourceY));
-                    break;
+        case PDFJBIG2BitOperation::Replace:
+            paintWords([](uint64_t target, uint64_t source, uint64_t mask) { return (target & ~mask) | (source & mask); });
+            break;
 
-                default:
-                    throw PDFException(PDFTranslationContext::tr("JBIG2 - invalid bitmap paint operation."));
-            }
-        }
+        default:
+            throw PDFException(PDFTranslationContext::tr("JBIG2 - invalid bitmap paint operation."));
     }
 }
 
@@ -3748,9 +3791,9 @@ void PDFJBIG2Bitmap::copyRow(int target, int source)
         throw PDFException(PDFTranslationContext::tr("JBIG2 - invalid bitmap copy row operation."));
     }
 
-    auto itSource = std::next(m_data.cbegin(), source * m_width);
-    auto itSourceEnd = std::next(itSource, m_width);
-    auto itTarget = std::next(m_data.begin(), target * m_width);
+    auto itSource = std::next(m_data.cbegin(), source * m_stride);
+    auto itSourceEnd = std::next(itSource, m_stride);
+    auto itTarget = std::next(m_data.begin(), target * m_stride);
     std::copy(itSource, itSourceEnd, itTarget);
 }
 
@@ -323,6 +323,9 @@ private:
     std::vector<PDFJBIG2HuffmanTableEntry> m_entries;
 };
 
+/// Bitmap used by the JBIG2 decoder. Pixels are packed, one bit per pixel,
+/// each row starts at the beginning of a 64-bit word. Leftmost pixel of the word
+/// is stored in the most significant bit. Value 1 is black (foreground) pixel.
 class PDF4QTLIBCORESHARED_EXPORT PDFJBIG2Bitmap : public PDFJBIG2Segment
 {
 public:
@@ -337,8 +340,23 @@ public:
     inline int getWidth() const { return m_width; }
     inline int getHeight() const { return m_height; }
     inline int getPixelCount() const { return m_width * m_height; }
-    inline uint8_t getPixel(int x, int y) const { return m_data[y * m_width + x]; }
-    inline void setPixel(int x, int y, uint8_t value) { m_data[y * m_width + x] = value; }
+
+    /// Returns number of 64-bit words of one row
+    inline int getStride() const { return m_stride; }
+
+    /// Returns packed data of the row, row must exist
+    inline const uint64_t* getRow(int y) const { return m_data.data() + y * m_stride; }
+
+    /// Returns pixel value (0 or 1)
+    inline uint8_t getPixel(int x, int y) const { return (m_data[y * m_stride + (x >> 6)] >> (63 - (x & 63))) & 1; }
+
+    /// Sets pixel value, any nonzero value sets the pixel to 1
+    inline void setPixel(int x, int y, uint8_t value)
+    {
+        uint64_t& word = m_data[y * m_stride + (x >> 6)];
+        const uint64_t mask = uint64_t(1) << (63 - (x & 63));
+        word = value ? (word | mask) : (word & ~mask);
+    }
 
     inline uint8_t getPixelSafe(int x, int y) const
     {
@@ -350,7 +368,45 @@ public:
         return getPixel(x, y);
     }
 
-    inline void fill(uint8_t value) { std::fill(m_data.begin(), m_data.end(), value); }
+    /// Returns 64 pixels of the row \p y starting at the pixel \p x, pixel \p x
+    /// is stored in the most significant bit. Pixels outside of the bitmap are zero.
+    /// \param x Horizontal position of the first pixel (can be outside the bitmap)
+    /// \param y Row (can be outside the bitmap)
+    inline uint64_t getBits(int x, int y) const
+    {
+        if (y < 0 || y >= m_height || x >= m_width || x <= -64)
+        {
+            return 0;
+        }
+
+        const uint64_t* row = getRow(y);
+        uint64_t bits = 0;
+        if (x >= 0)
+        {
+            const int index = x >> 6;
+            const int shift = x & 63;
+            bits = row[index] << shift;
+            if (shift > 0 && index + 1 < m_stride)
+            {
+                bits |= row[index + 1] >> (64 - shift);
+            }
+        }
+        else
+        {
+            bits = row[0] >> (-x);
+        }
+
+        // Clear padding bits after the end of the row
+        const int validPixels = m_width - x;
+        if (validPixels < 64)
+        {
+            bits &= ~(~uint64_t(0) >> validPixels);
+        }
+
+        return bits;
+    }
+
+    inline void fill(uint8_t value) { std::fill(m_data.begin(), m_data.end(), value ? ~uint64_t(0) : uint64_t(0)); }
     inline void fillZero() { fill(0); }
     inline void fillOne() { fill(0xFF); }
 
@@ -366,6 +422,7 @@ public:
 
     /// Paints another bitmap onto this bitmap. If bitmap is invalid, nothing is done.
     /// If \p expandY is true, height of target bitmap is expanded to fit source draw area.
+    /// Operation is performed on whole 64-bit words of the rows.
     /// \param bitmap Bitmap to be painted on this
     /// \param offsetX Horizontal offset of paint area
     /// \param offsetY Vertical offset of paint area
@@ -383,7 +440,8 @@ public:
 private:
     int m_width;
     int m_height;
-    std::vector<uint8_t> m_data;
+    int m_stride;
+    std::vector<uint64_t> m_data;
 };
 
 struct PDFJBIG2ReferencedSegments
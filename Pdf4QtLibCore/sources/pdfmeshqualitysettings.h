@@ -68,6 +68,11 @@ struct PDFMeshQualitySettings
 
     /// Highter value of the surface curvature meshing resolution mapping. \sa patchResolutionMappingRatioLow
     PDFReal patchResolutionMappingRatioHigh = 0.9;
+
+    /// Replace PostScript shading functions by sampled approximations, which are
+    /// much faster to evaluate. Approximation is validated only on a finite grid,
+    /// so features of the function narrower than the grid cell can be lost.
+    bool approximateFunctions = false;
 };
 
 }   // namespace pdf
@@ -17,6 +17,9 @@
 
 #include "pdfobject.h"
 #include "pdfvisitor.h"
+
+#include <atomic>
+
 #include "pdfdbgheap.h"
 
 namespace pdf
@@ -102,8 +105,12 @@ bool PDFObject::operator==(const PDFObject& other) const
         // values are "equal" (NaN == NaN returns false)
         if (std::holds_alternative<PDFObjectContentPointer>(m_data))
         {
-            Q_ASSERT(std::get<PDFObjectContentPointer>(m_data));
-            return std::get<PDFObjectContentPointer>(m_data)->equals(std::get<PDFObjectContentPointer>(other.m_data).get());
+            const PDFObjectContentPointer& content = std::get<PDFObjectContentPointer>(m_data);
+            const PDFObjectContentPointer& otherContent = std::get<PDFObjectContentPointer>(other.m_data);
+            Q_ASSERT(content);
+
+            // Objects sharing the same content are equal, deep comparison is not needed
+            return content == otherContent || content->equals(otherContent.get());
         }
 
         return m_data == other.m_data;
@@ -243,6 +250,20 @@ void PDFArray::optimize()
     m_objects.shrink_to_fit();
 }
 
+static constexpr uint32_t HASH_INDEX_EMPTY_SLOT = std::numeric_limits<uint32_t>::max();
+
+/// Returns starting slot of the key hash in the hash index of size (mask + 1)
+static inline size_t getHashIndexSlot(uint32_t hash, size_t mask)
+{
+    return hash & mask;
+}
+
+PDFDictionary::PDFDictionary(std::vector<DictionaryEntry>&& dictionary) :
+    m_dictionary(qMove(dictionary))
+{
+    rebuildKeyHashes();
+}
+
 bool PDFDictionary::equals(const PDFObjectContent* other) const
 {
     Q_ASSERT(dynamic_cast<const PDFDictionary*>(other));
@@ -250,12 +271,12 @@ bool PDFDictionary::equals(const PDFObjectContent* other) const
     return m_dictionary == otherStream->m_dictionary;
 }
 
-const PDFObject& PDFDictionary::get(const QByteArray& key) const
+const PDFObject& PDFDictionary::get(PDFNameAtom key) const
 {
-    auto it = find(key);
-    if (it != m_dictionary.cend())
+    const size_t index = findIndex(key);
+    if (index != m_dictionary.size())
     {
-        return it->second;
+        return m_dictionary[index].second;
     }
     else
     {
@@ -264,49 +285,37 @@ const PDFObject& PDFDictionary::get(const QByteArray& key) const
     }
 }
 
-const PDFObject& PDFDictionary::get(const char* key) const
+void PDFDictionary::addEntry(PDFInplaceOrMemoryString&& key, PDFObject&& value)
 {
-    auto it = find(key);
-    if (it != m_dictionary.cend())
-    {
-        return it->second;
-    }
-    else
-    {
-        static PDFObject dummy;
-        return dummy;
-    }
+    m_keyHashes.push_back(PDFNameAtom::computeHash(key.getView()));
+    m_dictionary.emplace_back(std::move(key), std::move(value));
+    insertIntoHashIndex(m_dictionary.size() - 1);
 }
 
-const PDFObject& PDFDictionary::get(const PDFInplaceOrMemoryString& key) const
+void PDFDictionary::addEntry(const PDFInplaceOrMemoryString& key, PDFObject&& value)
 {
-    auto it = find(key);
-    if (it != m_dictionary.cend())
-    {
-        return it->second;
-    }
-    else
-    {
-        static PDFObject dummy;
-        return dummy;
-    }
+    m_keyHashes.push_back(PDFNameAtom::computeHash(key.getView()));
+    m_dictionary.emplace_back(key, std::move(value));
+    insertIntoHashIndex(m_dictionary.size() - 1);
 }
 
 void PDFDictionary::removeEntry(const char* key)
 {
-    auto it = find(key);
-    if (it != m_dictionary.end())
+    const size_t index = findIndex(PDFNameAtom(key));
+    if (index != m_dictionary.size())
     {
-        m_dictionary.erase(it);
+        m_keyHashes.erase(std::next(m_keyHashes.begin(), index));
+        m_dictionary.erase(std::next(m_dictionary.begin(), index));
+        rebuildHashIndex();
     }
 }
 
 void PDFDictionary::setEntry(const PDFInplaceOrMemoryString& key, PDFObject&& value)
 {
-    auto it = find(key);
-    if (it != m_dictionary.end())
+    const size_t index = findIndex(PDFNameAtom(key));
+    if (index != m_dictionary.size())
     {
-        it->second = qMove(value);
+        m_dictionary[index].second = qMove(value);
     }
     else
     {
@@ -318,48 +327,125 @@ void PDFDictionary::removeNullObjects()
 {
     m_dictionary.erase(std::remove_if(m_dictionary.begin(), m_dictionary.end(), [](const DictionaryEntry& entry) { return entry.second.isNull(); }), m_dictionary.end());
     m_dictionary.shrink_to_fit();
+    rebuildKeyHashes();
 }
 
 void PDFDictionary::optimize()
 {
     m_dictionary.shrink_to_fit();
+    m_keyHashes.shrink_to_fit();
 }
 
-std::vector<PDFDictionary::DictionaryEntry>::const_iterator PDFDictionary::find(const QByteArray& key) const
+size_t PDFDictionary::findIndex(PDFNameAtom key) const
 {
-    return std::find_if(m_dictionary.cbegin(), m_dictionary.cend(), [&key](const DictionaryEntry& entry) { return entry.first == key; });
-}
+    const uint32_t hash = key.getHash();
 
-std::vector<PDFDictionary::DictionaryEntry>::iterator PDFDictionary::find(const QByteArray& key)
-{
-    return std::find_if(m_dictionary.begin(), m_dictionary.end(), [&key](const DictionaryEntry& entry) { return entry.first == key; });
-}
+    if (m_hashIndex.empty())
+    {
+        for (size_t i = 0; i < m_dictionary.size(); ++i)
+        {
+            if (m_keyHashes[i] == hash && m_dictionary[i].first.getView() == key.getView())
+            {
+                return i;
+            }
+        }
 
-std::vector<PDFDictionary::DictionaryEntry>::const_iterator PDFDictionary::find(const char* key) const
-{
-    return std::find_if(m_dictionary.cbegin(), m_dictionary.cend(), [key](const DictionaryEntry& entry) { return entry.first == key; });
+        return m_dictionary.size();
+    }
+
+    const size_t mask = m_hashIndex.size() - 1;
+    for (size_t slot = getHashIndexSlot(hash, mask);; slot = (slot + 1) & mask)
+    {
+        const uint32_t index = m_hashIndex[slot];
+
+        if (index == HASH_INDEX_EMPTY_SLOT)
+        {
+            return m_dictionary.size();
+        }
+
+        if (m_keyHashes[index] == hash && m_dictionary[index].first.getView() == key.getView())
+        {
+            return index;
+        }
+    }
 }
 
-std::vector<PDFDictionary::DictionaryEntry>::const_iterator PDFDictionary::find(const PDFInplaceOrMemoryString& key) const
+void PDFDictionary::insertIntoHashIndex(size_t index)
 {
-    return std::find_if(m_dictionary.cbegin(), m_dictionary.cend(), [&key](const DictionaryEntry& entry) { return entry.first == key; });
+    if (m_dictionary.size() < HASH_INDEX_THRESHOLD)
+    {
+        return;
+    }
+
+    // Keep load factor of the hash index at most 1/2
+    if (m_hashIndex.size() < 2 * m_dictionary.size())
+    {
+        rebuildHashIndex();
+        return;
+    }
+
+    const uint32_t hash = m_keyHashes[index];
+    const QByteArrayView key = m_dictionary[index].first.getView();
+    const size_t mask = m_hashIndex.size() - 1;
+    for (size_t slot = getHashIndexSlot(hash, mask);; slot = (slot + 1) & mask)
+    {
+        uint32_t& slotIndex = m_hashIndex[slot];
+
+        if (slotIndex == HASH_INDEX_EMPTY_SLOT)
+        {
+            slotIndex = static_cast<uint32_t>(index);
+            break;
+        }
+
+        if (m_keyHashes[slotIndex] == hash && m_dictionary[slotIndex].first.getView() == key)
+        {
+            // Duplicate key, the first entry has precedence (as in linear search)
+            break;
+        }
+    }
 }
 
-std::vector<PDFDictionary::DictionaryEntry>::iterator PDFDictionary::find(const PDFInplaceOrMemoryString& key)
+void PDFDictionary::rebuildKeyHashes()
 {
-    return std::find_if(m_dictionary.begin(), m_dictionary.end(), [&key](const DictionaryEntry& entry) { return entry.first == key; });
+    m_keyHashes.clear();
+    m_keyHashes.reserve(m_dictionary.size());
+
+    for (const DictionaryEntry& entry : m_dictionary)
+    {
+        m_keyHashes.push_back(PDFNameAtom::computeHash(entry.first.getView()));
+    }
+
+    rebuildHashIndex();
 }
 
-std::vector<PDFDictionary::DictionaryEntry>::iterator PDFDictionary::find(const char* key)
+void PDFDictionary::rebuildHashIndex()
 {
-    return std::find_if(m_dictionary.begin(), m_dictionary.end(), [key](const DictionaryEntry& entry) { return entry.first == key; });
+    m_hashIndex.clear();
+
+    if (m_dictionary.size() < HASH_INDEX_THRESHOLD)
+    {
+        m_hashIndex.shrink_to_fit();
+        return;
+    }
+
+    size_t capacity = HASH_INDEX_THRESHOLD;
+    while (capacity < 4 * m_dictionary.size())
+    {
+        capacity *= 2;
+    }
+
+    m_hashIndex.resize(capacity, HASH_INDEX_EMPTY_SLOT);
+    for (size_t i = 0; i < m_dictionary.size(); ++i)
+    {
+        insertIntoHashIndex(i);
+    }
 }
 
 bool PDFStream::equals(const PDFObjectContent* other) const
 {
     Q_ASSERT(dynamic_cast<const PDFStream*>(other));
     const PDFStream* otherStream = static_cast<const PDFStream*>(other);
-    return m_dictionary.equals(&otherStream->m_dictionary) && m_content == otherStream->m_content;
+    return m_dictionary.equals(&otherStream->m_dictionary) && *getContent() == *otherStream->getContent();
 }
 
 PDFObject PDFObjectManipulator::merge(PDFObject left, PDFObject right, MergeFlags flags)
@@ -557,6 +643,22 @@ bool PDFInplaceOrMemoryString::equals(const char* value, size_t length) const
     return length == 0;
 }
 
+QByteArrayView PDFInplaceOrMemoryString::getView() const
+{
+    if (std::holds_alternative<PDFInplaceString>(m_value))
+    {
+        const PDFInplaceString& string = std::get<PDFInplaceString>(m_value);
+        return QByteArrayView(string.string.data(), string.size);
+    }
+
+    if (std::holds_alternative<QByteArray>(m_value))
+    {
+        return QByteArrayView(std::get<QByteArray>(m_value));
+    }
+
+    return QByteArrayView();
+}
+
 bool PDFInplaceOrMemoryString::isInplace() const
 {
     return std::holds_alternative<PDFInplaceString>(m_value);
@@ -27,8 +27,10 @@
 #include <vector>
 #include <variant>
 #include <array>
+#include <functional>
 #include <initializer_list>
 #include <cstring>
+#include <type_traits>
 
 namespace pdf
 {
@@ -154,10 +156,61 @@ public:
     /// Returns string. If string is inplace, byte array is constructed.
     QByteArray getString() const;
 
+    /// Returns view of the string data. No memory is allocated,
+    /// view is valid as long as this string exists.
+    QByteArrayView getView() const;
+
 private:
     std::variant<typename std::monostate, PDFInplaceString, QByteArray> m_value;
 };
 
+/// Name atom is a name with precomputed hash. Dictionaries store hashes of their
+/// keys, so lookup of the atom compares hashes and compares names only if hashes
+/// are equal. Atom doesn't own the name, it references name data (usually string
+/// literal), which must outlive the atom. Atom of string literal can be computed
+/// at compile time, so lookups using literal keys do not hash the key at runtime.
+/// Atom constructed from byte array references data of that byte array, so it is
+/// valid only as long as the byte array is alive and unmodified. Construction
+/// from temporary byte array is not allowed.
+class PDF4QTLIBCORESHARED_EXPORT PDFNameAtom
+{
+public:
+    constexpr PDFNameAtom() = default;
+    constexpr PDFNameAtom(const char* name) : m_name(name), m_hash(computeHash(m_name)) { }
+    explicit inline PDFNameAtom(const QByteArray& name) : m_name(name), m_hash(computeHash(m_name)) { }
+    explicit PDFNameAtom(QByteArray&&) = delete;
+    explicit constexpr PDFNameAtom(QByteArrayView name) : m_name(name), m_hash(computeHash(m_name)) { }
+    explicit inline PDFNameAtom(const PDFInplaceOrMemoryString& name) : PDFNameAtom(name.getView()) { }
+
+    /// Returns view of the name
+    constexpr QByteArrayView getView() const { return m_name; }
+
+    /// Returns name of the atom
+    QByteArray getName() const { return m_name.toByteArray(); }
+
+    /// Returns hash of the name
+    constexpr uint32_t getHash() const { return m_hash; }
+
+    /// Computes hash of the name (FNV-1a hash)
+    /// \param name Name
+    static constexpr uint32_t computeHash(QByteArrayView name)
+    {
+        uint32_t hash = 2166136261u;
+        for (qsizetype i = 0; i < name.size(); ++i)
+        {
+            hash = (hash ^ static_cast<uint8_t>(name[i])) * 16777619u;
+        }
+        return hash;
+    }
+
+    inline bool operator==(const PDFNameAtom& other) const { return m_hash == other.m_hash && m_name == other.m_name; }
+    inline bool operator!=(const PDFNameAtom& other) const { return !(*this == other); }
+
+private:
+    QByteArrayView m_name;
+    uint32_t m_hash = computeHash(QByteArrayView());
+};
+
 class PDF4QTLIBCORESHARED_EXPORT PDFObject
 {
 public:
@@ -352,40 +405,52 @@ private:
 /// Represents a dictionary of objects in the PDF file. Dictionary is
 /// an array of pairs key-value, where key is name object and value is any
 /// PDF object. For this reason, we use QByteArray for key. We do not use
-/// map, because dictionaries are usually small.
+/// map, because dictionaries are usually small. Dictionary stores hashes of
+/// the keys, so lookup compares hashes first. Large dictionaries (for example,
+/// resource dictionaries with many fonts) have also hash index of the keys,
+/// so lookup doesn't scan the whole dictionary.
 class PDF4QTLIBCORESHARED_EXPORT PDFDictionary : public PDFObjectContent
 {
 public:
     using DictionaryEntry = std::pair<PDFInplaceOrMemoryString, PDFObject>;
 
+    /// Minimal number of entries of the dictionary, for which hash index is created
+    static constexpr size_t HASH_INDEX_THRESHOLD = 16;
+
     inline PDFDictionary() = default;
-    inline PDFDictionary(std::vector<DictionaryEntry>&& dictionary) : m_dictionary(qMove(dictionary)) { }
+    PDFDictionary(std::vector<DictionaryEntry>&& dictionary);
     virtual ~PDFDictionary() override = default;
 
     virtual bool equals(const PDFObjectContent* other) const override;
 
     /// Returns object for the key. If key is not found in the dictionary,
-    /// then valid reference to the null object is returned.
+    /// then valid reference to the null object is returned. This overload
+    /// accepts only byte arrays, string literals are converted to the atom
+    /// by constexpr constructor of the atom, see get(PDFNameAtom).
     /// \param key Key
-    const PDFObject& get(const QByteArray& key) const;
+    template<typename T, typename std::enable_if<std::is_same<T, QByteArray>::value, int>::type = 0>
+    const PDFObject& get(const T& key) const { return get(PDFNameAtom(key)); }
 
     /// Returns object for the key. If key is not found in the dictionary,
     /// then valid reference to the null object is returned.
     /// \param key Key
-    const PDFObject& get(const char* key) const;
+    const PDFObject& get(const PDFInplaceOrMemoryString& key) const { return get(PDFNameAtom(key)); }
 
     /// Returns object for the key. If key is not found in the dictionary,
     /// then valid reference to the null object is returned.
     /// \param key Key
-    const PDFObject& get(const PDFInplaceOrMemoryString& key) const;
+    const PDFObject& get(PDFNameAtom key) const;
 
-    /// Returns true, if dictionary contains a particular key
+    /// Returns true, if dictionary contains a particular key. This overload
+    /// accepts only byte arrays, string literals are converted to the atom
+    /// by constexpr constructor of the atom, see hasKey(PDFNameAtom).
     /// \param key Key to be found in the dictionary
-    bool hasKey(const QByteArray& key) const { return find(key) != m_dictionary.cend(); }
+    template<typename T, typename std::enable_if<std::is_same<T, QByteArray>::value, int>::type = 0>
+    bool hasKey(const T& key) const { return hasKey(PDFNameAtom(key)); }
 
     /// Returns true, if dictionary contains a particular key
     /// \param key Key to be found in the dictionary
-    bool hasKey(const char* key) const { return find(key) != m_dictionary.cend(); }
+    bool hasKey(PDFNameAtom key) const { return findIndex(key) != m_dictionary.size(); }
 
     /// Removes entry with given key. If entry with this key is not found,
     /// nothing happens.
@@ -395,12 +460,12 @@ public:
     /// Adds a new entry to the dictionary.
     /// \param key Key
     /// \param value Value
-    void addEntry(PDFInplaceOrMemoryString&& key, PDFObject&& value) { m_dictionary.emplace_back(std::move(key), std::move(value)); }
+    void addEntry(PDFInplaceOrMemoryString&& key, PDFObject&& value);
 
     /// Adds a new entry to the dictionary.
     /// \param key Key
     /// \param value Value
-    void addEntry(const PDFInplaceOrMemoryString& key, PDFObject&& value) { m_dictionary.emplace_back(key, std::move(value)); }
+    void addEntry(const PDFInplaceOrMemoryString& key, PDFObject&& value);
 
     /// Sets entry value. If entry with given key doesn't exist,
     /// then it is created.
@@ -429,37 +494,30 @@ public:
     virtual void optimize() override;
 
 private:
-    /// Finds an item in the dictionary array, if the item is not in the dictionary,
-    /// then end iterator is returned.
+    /// Returns index of the entry with given key. If key is not
+    /// found, then count of items in the dictionary is returned.
     /// \param key Key to be found
-    std::vector<DictionaryEntry>::const_iterator find(const QByteArray& key) const;
+    size_t findIndex(PDFNameAtom key) const;
 
-    /// Finds an item in the dictionary array, if the item is not in the dictionary,
-    /// then end iterator is returned.
-    /// \param key Key to be found
-    std::vector<DictionaryEntry>::iterator find(const QByteArray& key);
+    /// Inserts the entry into the hash index. If hash index doesn't exist
+    /// and dictionary is large enough, or hash index is full, it is rebuilt.
+    /// \param index Index of the entry
+    void insertIntoHashIndex(size_t index);
 
-    /// Finds an item in the dictionary array, if the item is not in the dictionary,
-    /// then end iterator is returned.
-    /// \param key Key to be found
-    std::vector<DictionaryEntry>::const_iterator find(const char* key) const;
+    /// Rebuilds hashes of the keys and hash index
+    void rebuildKeyHashes();
 
-    /// Finds an item in the dictionary array, if the item is not in the dictionary,
-    /// then end iterator is returned.
-    /// \param key Key to be found
-    std::vector<DictionaryEntry>::iterator find(const char* key);
+    /// Rebuilds hash index (creates it for large dictionaries,
+    /// removes it for small dictionaries)
+    void rebuildHashIndex();
 
-    /// Finds an item in the dictionary array, if the item is not in the dictionary,
-    /// then end iterator is returned.
-    /// \param key Key to be found
-    std::vector<DictionaryEntry>::const_iterator find(const PDFInplaceOrMemoryString& key) const;
+    std::vector<DictionaryEntry> m_dictionary;
 
-    /// Finds an item in the dictionary array, if the item is not in the dictionary,
-    /// then end iterator is returned.
-    /// \param key Key to be found
-    std::vector<DictionaryEntry>::iterator find(const PDFInplaceOrMemoryString& key);
+    /// Hashes of the keys, one for each dictionary entry
+    std::vector<uint32_t> m_keyHashes;
 
-    std::vector<DictionaryEntry> m_dictionary;
+    /// Open addressing hash table of entry indices (empty for small dictionaries)
+    std::vector<uint32_t> m_hashIndex;
 };
 
 /// Represents a stream object in the PDF file. Stream consists of dictionary
@@ -467,6 +525,9 @@ private:
 class PDF4QTLIBCORESHARED_EXPORT PDFStream : public PDFObjectContent
 {
 public:
+    /// Function, which decrypts the stream content
+    using Decryptor = std::function<QByteArray(const QByteArray&)>;
+
     inline explicit PDFStream() = default;
     inline explicit PDFStream(PDFDictionary&& dictionary, QByteArray&& content) :
         m_dictionary(std::move(dictionary)),
@@ -475,6 +536,15 @@ public:
 
     }
 
+    /// Constructs stream with encrypted content. Content is decrypted
+    /// by \p decryptor, when it is accessed for the first time, so
+    /// streams, which are never used, are never decrypted. Copies
+    /// of the stream share the decrypted content. Decryption is thread safe.
+    /// \param dictionary Stream dictionary
+    /// \param encryptedContent Encrypted content of the stream
+    /// \param decryptor Decryptor of the content
+    explicit PDFStream(PDFDictionary&& dictionary, QByteArray&& encryptedContent, Decryptor decryptor);
+
     virtual ~PDFStream() override = default;
 
     virtual bool equals(const PDFObjectContent* other) const override;
@@ -483,14 +553,22 @@ public:
     const PDFDictionary* getDictionary() const { return &m_dictionary; }
 
     /// Optimizes the stream for memory consumption
-    virtual void optimize() override { m_dictionary.optimize(); m_content.shrink_to_fit(); }
+    virtual void optimize() override;
 
-    /// Returns content of the stream
-    const QByteArray* getContent() const { return &m_content; }
+    /// Returns content of the stream. Encrypted content is decrypted first.
+    const QByteArray* getContent() const { return m_encryptedContent ? getDecryptedContent() : &m_content; }
 
 private:
+    struct EncryptedContent;
+
+    /// Returns decrypted content, decrypts it, if it was not decrypted yet
+    const QByteArray* getDecryptedContent() const;
+
     PDFDictionary m_dictionary;
     QByteArray m_content;
+
+    /// Encrypted content (only for streams decrypted on demand)
+    std::shared_ptr<EncryptedContent> m_encryptedContent;
 };
 
 class PDF4QTLIBCORESHARED_EXPORT PDFObjectManipulator
@@ -16,6 +16,7 @@
 //    along with PDF4QT.  If not, see <https://www.gnu.org/licenses/>.
 
 #include "pdfpagecontentprocessor.h"
+#include "pdfcontentstreambytecode.h"
 #include "pdfdocument.h"
 #include "pdfexception.h"
 #include "pdfimage.h"
@@ -323,7 +324,7 @@ QList<PDFRenderError> PDFPageContentProcessor::processContents()
             const PDFObject& streamObject = m_document->getObject(array->getItem(i));
             if (streamObject.isStream())
             {
-                processContentStream(streamObject.getStream());
+                processContentStream(streamObject);
             }
             else
             {
@@ -333,7 +334,7 @@ QList<PDFRenderError> PDFPageContentProcessor::processContents()
     }
     else if (contents.isStream())
     {
-        processContentStream(contents.getStream());
+        processContentStream(contents);
     }
     else
     {
@@ -528,201 +529,214 @@ PDFPageContentProcessor::PDFTransparencyGroup PDFPageContentProcessor::parseTran
     return group;
 }
 
-void PDFPageContentProcessor::processContent(const QByteArray& content)
+/// Interpreter of the content stream. Operators are processed immediately after
+/// they are parsed, without translation of the content stream into the bytecode.
+class PDFPageContentProcessor::ContentStreamInterpreter : public PDFContentStreamParser
 {
-    PDFLexicalAnalyzer parser(content.constBegin(), content.constEnd());
-
-    while (!parser.isAtEnd() && !isProcessingCancelled())
+public:
+    explicit ContentStreamInterpreter(PDFPageContentProcessor* processor) :
+        PDFContentStreamParser(processor->m_document),
+        m_processor(processor)
     {
-        bool tokenFetched = false;
-        PDFInteger oldParserPosition = parser.pos();
 
-        try
-        {
-            PDFLexicalAnalyzer::Token token = parser.fetch();
-            tokenFetched = true;
-
-            switch (token.type)
-            {
-                case PDFLexicalAnalyzer::TokenType::Command:
-                {
-                    QByteArray command = token.data.toByteArray();
-
-                    if (command == "BI")
-                    {
-                        // Strategy: We will try to find position of BI/ID/EI in the stream. If we can determine
-                        // length of the stream explicitly, then we use explicit length. We also create a PDFObject
-                        // from the inline image dictionary/image content stream and then process it like XObject.
-                        PDFInteger operatorBIPosition = parser.pos();
-                        PDFInteger operatorIDPosition = parser.findSubstring("ID", operatorBIPosition);
-                        PDFInteger operatorEIPosition = parser.findSubstring("EI", operatorIDPosition);
-
-                        // According the PDF 1.7 specification, single white space characters is after ID, then the byte
-                        // immediately after it is interpreted as first byte of image data.
-                        PDFInteger startDataPosition = operatorIDPosition + 3;
-
-                        if (operatorIDPosition == -1 || operatorEIPosition == -1)
-                        {
-                            throw PDFException(PDFTranslationContext::tr("Invalid inline image dictionary, ID operator is missing."));
-                        }
-
-                        Q_ASSERT(operatorBIPosition < content.size());
-                        Q_ASSERT(operatorIDPosition < content.size());
-                        Q_ASSERT(operatorBIPosition <= operatorIDPosition);
+    }
 
-                        PDFLexicalAnalyzer inlineImageLexicalAnalyzer(content.constBegin() + operatorBIPosition, content.constBegin() + operatorIDPosition);
-                        PDFParser inlineImageParser([&inlineImageLexicalAnalyzer]{ return inlineImageLexicalAnalyzer.fetch(); });
+protected:
+    virtual void onOperand(const Operand& operand) override
+    {
+        Operand storedOperand = operand;
+        if (operand.string)
+        {
+            m_strings.push_back(*operand.string);
+            storedOperand.string = &m_strings.back();
+        }
+        m_processor->m_operands.push_back(storedOperand);
+    }
 
-                        constexpr std::pair<const char*, const char*> replacements[] =
-                        {
-                            { "BPC", "BitsPerComponent" },
-                            { "CS", "ColorSpace" },
-                            { "D", "Decode" },
-                            { "DP", "DecodeParms" },
-                            { "F", "Filter" },
-                            { "H", "Height" },
-                            { "IM", "ImageMask" },
-                            { "I", "Interpolate" },
-                            { "W", "Width" },
-                            { "L", "Length" },
-                            { "G", "DeviceGray" },
-                            { "RGB", "DeviceRGB" },
-                            { "CMYK", "DeviceCMYK" }
-                        };
-
-                        std::shared_ptr<PDFDictionary> dictionarySharedPointer = std::make_shared<PDFDictionary>();
-                        PDFDictionary* dictionary = dictionarySharedPointer.get();
-
-                        while (inlineImageParser.lookahead().type != PDFLexicalAnalyzer::TokenType::EndOfFile)
-                        {
-                            PDFObject nameObject = inlineImageParser.getObject();
-                            PDFObject valueObject = inlineImageParser.getObject();
+    virtual void onOperator(Operator op, const QByteArray& command) override
+    {
+        m_processor->processOperator(op, command);
+        m_strings.clear();
+    }
 
-                            if (!nameObject.isName())
-                            {
-                                throw PDFException(PDFTranslationContext::tr("Expected name in the inline image dictionary stream."));
-                            }
+    virtual void onInlineImage(PDFStream&& inlineImage) override
+    {
+        m_processor->processInlineImage(&inlineImage);
+        m_strings.clear();
+    }
 
-                            // Replace the name, if neccessary
-                            QByteArray name = nameObject.getString();
-                            for (auto [string, replacement] : replacements)
-                            {
-                                if (name == string)
-                                {
-                                    name = replacement;
-                                    break;
-                                }
-                            }
+    virtual void onError(const QString& message) override
+    {
+        m_processor->m_operands.clear();
+        m_processor->m_errorList.append(PDFRenderError(RenderErrorType::Error, message));
+        m_strings.clear();
+    }
 
-                            dictionary->addEntry(PDFInplaceOrMemoryString(qMove(name)), qMove(valueObject));
-                        }
+    virtual bool isParsingCancelled() const override
+    {
+        return m_processor->isProcessingCancelled();
+    }
 
-                        PDFDocumentDataLoaderDecorator loader(m_document);
-                        PDFInteger dataLength = 0;
+private:
+    PDFPageContentProcessor* m_processor;
 
-                        if (dictionary->hasKey("Length"))
-                        {
-                            dataLength = loader.readIntegerFromDictionary(dictionary, "Length", 0);
-                        }
-                        else if (dictionary->hasKey("Filter"))
-                        {
-                            dataLength = -1;
+    /// Strings of the operands on the operand stack
+    std::deque<QByteArray> m_strings;
+};
 
-                            // We will try to use stream filter hint
-                            QByteArray filterName = loader.readNameFromDictionary(dictionary, "Filter");
-                            if (!filterName.isEmpty())
-                            {
-                                dataLength = PDFStreamFilterStorage::getStreamDataLength(content, filterName, startDataPosition);
-                            }
+PDFLexicalAnalyzer::Token PDFPageContentProcessor::Operand::toToken() const
+{
+    switch (type)
+    {
+        case PDFLexicalAnalyzer::TokenType::Boolean:
+            return PDFLexicalAnalyzer::Token(type, boolean);
 
-                            if (dataLength == -1)
-                            {
-                                // We will use EI operator position to determine stream length
-                                dataLength = operatorEIPosition - startDataPosition;
-                            }
-                        }
-                        else
-                        {
-                            // We will calculate stream size from the with/height and bit per component
-                            const PDFInteger width = loader.readIntegerFromDictionary(dictionary, "Width", 0);
-                            const PDFInteger height = loader.readIntegerFromDictionary(dictionary, "Height", 0);
-                            const PDFInteger bpc = loader.readIntegerFromDictionary(dictionary, "BitsPerComponent", 8);
+        case PDFLexicalAnalyzer::TokenType::Integer:
+            return PDFLexicalAnalyzer::Token(type, QVariant(static_cast<qint64>(integer)));
 
-                            if (width <= 0 || height <= 0 || bpc <= 0)
-                            {
-                                throw PDFException(PDFTranslationContext::tr("Expected name in the inline image dictionary stream."));
-                            }
+        case PDFLexicalAnalyzer::TokenType::Real:
+            return PDFLexicalAnalyzer::Token(type, real);
 
-                            const PDFInteger stride = (width * bpc + 7) / 8;
-                            dataLength = stride * height;
-                        }
+        case PDFLexicalAnalyzer::TokenType::String:
+        case PDFLexicalAnalyzer::TokenType::Name:
+            return PDFLexicalAnalyzer::Token(type, *string);
 
-                        // We will once more find the "EI" operator, due to recomputed dataLength.
-                        operatorEIPosition = parser.findSubstring("EI", startDataPosition + dataLength);
-                        if (operatorEIPosition == -1)
-                        {
-                            throw PDFException(PDFTranslationContext::tr("Invalid inline image stream."));
-                        }
+        default:
+            break;
+    }
 
-                        // We must seek after EI operator. Then we will paint the image. Because painting of image can throw exception,
-                        // then we will paint the image AFTER we seek the position.
-                        parser.seek(operatorEIPosition + 2);
+    return PDFLexicalAnalyzer::Token(type);
+}
 
-                        QByteArray buffer = content.mid(startDataPosition, dataLength);
-                        PDFStream imageStream(std::move(*dictionary), std::move(buffer));
-                        paintXObjectImage(&imageStream);
-                    }
-                    else
-                    {
-                        // Process the command, then clear the operand stack
-                        processCommand(command);
-                    }
+void PDFPageContentProcessor::processContent(const QByteArray& content)
+{
+    ContentStreamInterpreter interpreter(this);
+    interpreter.parse(content);
+    detachOperands();
+}
 
-                    m_operands.clear();
-                    break;
-                }
+void PDFPageContentProcessor::processBytecode(const PDFContentStreamBytecode& bytecode)
+{
+    for (const PDFContentStreamBytecode::Instruction& instruction : bytecode.getInstructions())
+    {
+        if (isProcessingCancelled())
+        {
+            break;
+        }
 
-                case PDFLexicalAnalyzer::TokenType::EndOfFile:
+        switch (instruction.type)
+        {
+            case PDFContentStreamBytecode::InstructionType::Operator:
+            case PDFContentStreamBytecode::InstructionType::Operands:
+            {
+                // Push the operands onto the operand stack
+                const PDFContentStreamBytecode::Operand* operands = bytecode.getOperands(instruction);
+                for (uint32_t i = 0; i < instruction.operandCount; ++i)
                 {
-                    // Do nothing, just break, we are at the end
-                    break;
+                    m_operands.push_back(operands[i]);
                 }
 
-                default:
+                if (instruction.type == PDFContentStreamBytecode::InstructionType::Operator)
                 {
-                    // Push the operand onto the operand stack
-                    m_operands.push_back(std::move(token));
-                    break;
+                    processOperator(instruction.op, bytecode.getString(instruction.dataIndex));
                 }
+                break;
             }
-        }
-        catch (const PDFException& exception)
-        {
-            // If we get exception when parsing, and parser position is not advanced,
-            // then we must advance it manually, otherwise we get infinite loop.
-            if (!tokenFetched && oldParserPosition == parser.pos() && !parser.isAtEnd())
+
+            case PDFContentStreamBytecode::InstructionType::InlineImage:
             {
-                parser.seek(parser.pos() + 1);
+                processInlineImage(bytecode.getInlineImage(instruction.dataIndex));
+                break;
             }
 
-            m_operands.clear();
-            m_errorList.append(PDFRenderError(RenderErrorType::Error, exception.getMessage()));
+            case PDFContentStreamBytecode::InstructionType::Error:
+            {
+                m_operands.clear();
+                m_errorList.append(PDFRenderError(RenderErrorType::Error, bytecode.getError(instruction.dataIndex)));
+                break;
+            }
         }
-        catch (const PDFRendererException &exception)
+    }
+
+    detachOperands();
+}
+
+void PDFPageContentProcessor::detachOperands()
+{
+    if (m_operands.empty())
+    {
+        return;
+    }
+
+    // Operands can also refer to the detached strings, so we must
+    // create new strings, before old strings are destroyed.
+    std::deque<QByteArray> strings;
+    for (size_t i = 0; i < m_operands.size(); ++i)
+    {
+        Operand& operand = m_operands[i];
+        if (operand.string)
         {
-            m_operands.clear();
-            m_errorList.append(exception.getError());
+            strings.push_back(*operand.string);
+            operand.string = &strings.back();
         }
     }
+
+    // Swap doesn't invalidate references to the elements of the deque
+    m_detachedOperandStrings.swap(strings);
 }
 
-void PDFPageContentProcessor::processContentStream(const PDFStream* stream)
+void PDFPageContentProcessor::processOperator(Operator op, const QByteArray& command)
 {
     try
     {
-        QByteArray content = m_document->getDecodedStream(stream);
+        // Process the command, then clear the operand stack
+        processCommand(op, command);
+        m_operands.clear();
+    }
+    catch (const PDFException& exception)
+    {
+        m_operands.clear();
+        m_errorList.append(PDFRenderError(RenderErrorType::Error, exception.getMessage()));
+    }
+    catch (const PDFRendererException &exception)
+    {
+        m_operands.clear();
+        m_errorList.append(exception.getError());
+    }
+}
 
-        processContent(content);
+void PDFPageContentProcessor::processInlineImage(const PDFStream* inlineImage)
+{
+    m_operands.clear();
+
+    try
+    {
+        paintXObjectImage(inlineImage);
+    }
+    catch (const PDFException& exception)
+    {
+        m_errorList.append(PDFRenderError(RenderErrorType::Error, exception.getMessage()));
+    }
+    catch (const PDFRendererException &exception)
+    {
+        m_errorList.append(exception.getError());
+    }
+}
+
+void PDFPageContentProcessor::processContentStream(const PDFObject& streamObject)
+{
+    try
+    {
+        if (m_bytecodeCache)
+        {
+            PDFContentStreamBytecodePointer bytecode = m_bytecodeCache->getBytecode(m_document, streamObject);
+            processBytecode(*bytecode);
+        }
+        else
+        {
+            QByteArray content = m_document->getDecodedStream(streamObject.getStream());
+            processContent(content);
+        }
     }
     catch (const PDFException& exception)
     {
@@ -737,6 +751,17 @@ void PDFPageContentProcessor::processForm(const QTransform& matrix,
                                           const PDFObject& transparencyGroup,
                                           const QByteArray& content,
                                           PDFInteger formStructuralParent)
+{
+    processForm(matrix, boundingBox, resources, transparencyGroup, content, nullptr, formStructuralParent);
+}
+
+void PDFPageContentProcessor::processForm(const QTransform& matrix,
+                                          const QRectF& boundingBox,
+                                          const PDFObject& resources,
+                                          const PDFObject& transparencyGroup,
+                                          const QByteArray& content,
+                                          const PDFContentStreamBytecode* bytecode,
+                                          PDFInteger formStructuralParent)
 {
     PDFPageContentProcessorStateGuard guard(this);
     PDFTemporaryValueChange structuralParentChangeGuard(&m_structuralParentKey, formStructuralParent);
@@ -787,7 +812,14 @@ void PDFPageContentProcessor::processForm(const QTransform& matrix,
         initDictionaries(resources);
     }
 
-    processContent(content);
+    if (bytecode)
+    {
+        processBytecode(*bytecode);
+    }
+    else
+    {
+        processContent(content);
+    }
 }
 
 void PDFPageContentProcessor::processPathPainting(const QPainterPath& path, bool stroke, bool fill, bool text, Qt::FillRule fillRule)
@@ -1074,7 +1106,17 @@ void PDFPageContentProcessor::processTillingPatternPainting(const PDFTilingPatte
     const QRectF boundingBox = tilingPattern->getBoundingBox();
     const PDFReal xStep = qAbs(tilingPattern->getXStep());
     const PDFReal yStep = qAbs(tilingPattern->getYStep());
-    const QByteArray& content = tilingPattern->getContent();
+    // Pattern cell is painted many times, so it is translated into the bytecode,
+    // which is taken from the cache, if possible.
+    PDFContentStreamBytecodePointer bytecode;
+    if (m_bytecodeCache && tilingPattern->getContentStream().isStream())
+    {
+        bytecode = m_bytecodeCache->getBytecode(m_document, tilingPattern->getContentStream());
+    }
+    else
+    {
+        bytecode.reset(new PDFContentStreamBytecode(m_document, tilingPattern->getContent()));
+    }
     QPainterPath boundingPath;
     boundingPath.addRect(boundingBox);
 
@@ -1100,7 +1142,7 @@ void PDFPageContentProcessor::processTillingPatternPainting(const PDFTilingPatte
             updateGraphicState();
 
             performClipping(boundingPath, boundingPath.fillRule());
-            processContent(content);
+            processBytecode(*bytecode);
 
             if (isProcessingCancelled())
             {
@@ -1115,20 +1157,22 @@ void PDFPageContentProcessor::processTillingPatternPainting(const PDFTilingPatte
     }
 }
 
-void PDFPageContentProcessor::processCommand(const QByteArray& command)
+PDFPageContentProcessor::Operator PDFPageContentProcessor::getOperator(const QByteArray& command)
 {
-    Operator op = Operator::Invalid;
-
     // Find the command in the command array
     for (const std::pair<const char*, PDFPageContentProcessor::Operator>& operatorDescriptor : operators)
     {
         if (command == operatorDescriptor.first)
         {
-            op = operatorDescriptor.second;
-            break;
+            return operatorDescriptor.second;
         }
     }
 
+    return Operator::Invalid;
+}
+
+void PDFPageContentProcessor::processCommand(Operator op, const QByteArray& command)
+{
     switch (op)
     {
         case Operator::SetLineWidth:
@@ -2110,16 +2154,18 @@ PDFReal PDFPageContentProcessor::readOperand<PDFReal>(size_t index) const
 {
     if (index < m_operands.size())
     {
-        const PDFLexicalAnalyzer::Token& token = m_operands[index];
+        const Operand& operand = m_operands[index];
 
-        switch (token.type)
+        switch (operand.type)
         {
             case PDFLexicalAnalyzer::TokenType::Real:
+                return operand.real;
+
             case PDFLexicalAnalyzer::TokenType::Integer:
-                return token.data.value<PDFReal>();
+                return static_cast<PDFReal>(operand.integer);
 
             default:
-                throw PDFRendererException(RenderErrorType::Error, PDFTranslationContext::tr("Can't read operand (real number) on index %1. Operand is of type '%2'.").arg(index + 1).arg(PDFLexicalAnalyzer::getStringFromOperandType(token.type)));
+                throw PDFRendererException(RenderErrorType::Error, PDFTranslationContext::tr("Can't read operand (real number) on index %1. Operand is of type '%2'.").arg(index + 1).arg(PDFLexicalAnalyzer::getStringFromOperandType(operand.type)));
         }
     }
     else
@@ -2133,15 +2179,15 @@ PDFInteger PDFPageContentProcessor::readOperand<PDFInteger>(size_t index) const
 {
     if (index < m_operands.size())
     {
-        const PDFLexicalAnalyzer::Token& token = m_operands[index];
+        const Operand& operand = m_operands[index];
 
-        switch (token.type)
+        switch (operand.type)
         {
             case PDFLexicalAnalyzer::TokenType::Integer:
-                return token.data.value<PDFInteger>();
+                return operand.integer;
 
             default:
-                throw PDFRendererException(RenderErrorType::Error, PDFTranslationContext::tr("Can't read operand (integer) on index %1. Operand is of type '%2'.").arg(index + 1).arg(PDFLexicalAnalyzer::getStringFromOperandType(token.type)));
+                throw PDFRendererException(RenderErrorType::Error, PDFTranslationContext::tr("Can't read operand (integer) on index %1. Operand is of type '%2'.").arg(index + 1).arg(PDFLexicalAnalyzer::getStringFromOperandType(operand.type)));
         }
     }
     else
@@ -2155,15 +2201,15 @@ PDFPageContentProcessor::PDFOperandName PDFPageContentProcessor::readOperand<PDF
 {
     if (index < m_operands.size())
     {
-        const PDFLexicalAnalyzer::Token& token = m_operands[index];
+        const Operand& operand = m_operands[index];
 
-        switch (token.type)
+        switch (operand.type)
         {
             case PDFLexicalAnalyzer::TokenType::Name:
-                return PDFOperandName{ token.data.toByteArray() };
+                return PDFOperandName{ *operand.string };
 
             default:
-                throw PDFRendererException(RenderErrorType::Error, PDFTranslationContext::tr("Can't read operand (name) on index %1. Operand is of type '%2'.").arg(index + 1).arg(PDFLexicalAnalyzer::getStringFromOperandType(token.type)));
+                throw PDFRendererException(RenderErrorType::Error, PDFTranslationContext::tr("Can't read operand (name) on index %1. Operand is of type '%2'.").arg(index + 1).arg(PDFLexicalAnalyzer::getStringFromOperandType(operand.type)));
         }
     }
     else
@@ -2178,15 +2224,15 @@ PDFPageContentProcessor::PDFOperandString PDFPageContentProcessor::readOperand<P
 {
     if (index < m_operands.size())
     {
-        const PDFLexicalAnalyzer::Token& token = m_operands[index];
+        const Operand& operand = m_operands[index];
 
-        switch (token.type)
+        switch (operand.type)
         {
             case PDFLexicalAnalyzer::TokenType::String:
-                return PDFOperandString{ token.data.toByteArray() };
+                return PDFOperandString{ *operand.string };
 
             default:
-                throw PDFRendererException(RenderErrorType::Error, PDFTranslationContext::tr("Can't read operand (string) on index %1. Operand is of type '%2'.").arg(index + 1).arg(PDFLexicalAnalyzer::getStringFromOperandType(token.type)));
+                throw PDFRendererException(RenderErrorType::Error, PDFTranslationContext::tr("Can't read operand (string) on index %1. Operand is of type '%2'.").arg(index + 1).arg(PDFLexicalAnalyzer::getStringFromOperandType(operand.type)));
         }
     }
     else
@@ -2461,7 +2507,7 @@ void PDFPageContentProcessor::operatorColorSetStrokingColorN()
             if (m_patternDictionary && m_patternDictionary->hasKey(name.name))
             {
                 // Create the pattern
-                PDFPatternPtr pattern = PDFPattern::createPattern(m_colorSpaceDictionary, m_document, m_patternDictionary->get(name.name), m_CMS, m_graphicState.getRenderingIntent(), this);
+                PDFPatternPtr pattern = PDFPattern::createPattern(m_colorSpaceDictionary, m_document, m_patternDictionary->get(name.name), m_CMS, m_graphicState.getRenderingIntent(), this, m_meshQualitySettings.approximateFunctions);
                 m_graphicState.setStrokeColorSpace(PDFColorSpacePointer(new PDFPatternColorSpace(qMove(pattern), qMove(uncoloredColorSpace), qMove(uncoloredPatternColor))));
                 updateGraphicState();
                 return;
@@ -2539,7 +2585,7 @@ void PDFPageContentProcessor::operatorColorSetFillingColorN()
             if (m_patternDictionary && m_patternDictionary->hasKey(name.name))
             {
                 // Create the pattern
-                PDFPatternPtr pattern = PDFPattern::createPattern(m_colorSpaceDictionary, m_document, m_patternDictionary->get(name.name), m_CMS, m_graphicState.getRenderingIntent(), this);
+                PDFPatternPtr pattern = PDFPattern::createPattern(m_colorSpaceDictionary, m_document, m_patternDictionary->get(name.name), m_CMS, m_graphicState.getRenderingIntent(), this, m_meshQualitySettings.approximateFunctions);
                 m_graphicState.setFillColorSpace(QSharedPointer<PDFAbstractColorSpace>(new PDFPatternColorSpace(qMove(pattern), qMove(uncoloredColorSpace), qMove(uncoloredPatternColor))));
                 updateGraphicState();
                 return;
@@ -2866,19 +2912,19 @@ void PDFPageContentProcessor::operatorTextShowTextIndividualSpacing()
             {
                 case PDFLexicalAnalyzer::TokenType::Integer:
                 {
-                    textSequence.items.push_back(TextSequenceItem(m_operands[i].data.value<PDFInteger>()));
+                    textSequence.items.push_back(TextSequenceItem(m_operands[i].integer));
                     break;
                 }
 
                 case PDFLexicalAnalyzer::TokenType::Real:
                 {
-                    textSequence.items.push_back(TextSequenceItem(m_operands[i].data.value<PDFReal>()));
+                    textSequence.items.push_back(TextSequenceItem(m_operands[i].real));
                     break;
                 }
 
                 case PDFLexicalAnalyzer::TokenType::String:
                 {
-                    realizedFont->fillTextSequence(m_operands[i].data.toByteArray(), textSequence, this);
+                    realizedFont->fillTextSequence(*m_operands[i].string, textSequence, this);
                     break;
                 }
 
@@ -2930,7 +2976,7 @@ void PDFPageContentProcessor::operatorShadingPaintShape(PDFPageContentProcessor:
         throw PDFRendererException(RenderErrorType::Error, PDFTranslationContext::tr("Shading '%1' not found.").arg(QString::fromLatin1(name.name)));
     }
 
-    PDFPatternPtr pattern = PDFPattern::createShadingPattern(m_colorSpaceDictionary, m_document, m_shadingDictionary->get(name.name), QTransform(), PDFObject(), m_CMS, m_graphicState.getRenderingIntent(), this, true);
+    PDFPatternPtr pattern = PDFPattern::createShadingPattern(m_colorSpaceDictionary, m_document, m_shadingDictionary->get(name.name), QTransform(), PDFObject(), m_CMS, m_graphicState.getRenderingIntent(), this, true, m_meshQualitySettings.approximateFunctions);
 
     // We will do a trick: we will set current fill color space, and then paint
     // bounding rectangle in the color pattern.
@@ -2947,7 +2993,7 @@ void PDFPageContentProcessor::operatorShadingPaintShape(PDFPageContentProcessor:
     processPathPainting(boundingRectPath, false, true, false, boundingRectPath.fillRule());
 }
 
-void PDFPageContentProcessor::paintXObjectImage(const PDFStream* stream)
+void PDFPageContentProcessor::paintXObjectImage(const PDFStream* stream, PDFObjectReference reference)
 {
     if (isContentKindSuppressed(ContentKind::Images))
     {
@@ -2955,48 +3001,122 @@ void PDFPageContentProcessor::paintXObjectImage(const PDFStream* stream)
         return;
     }
 
-    PDFColorSpacePointer colorSpace;
-
-    const PDFDictionary* streamDictionary = stream->getDictionary();
-    if (streamDictionary->hasKey("ColorSpace"))
+    // Image is drawn into unit square, so we can compute its size in device pixels
+    // from the current world matrix. Image need not to be decoded at higher resolution.
+    // Image is decoded at the size given by its reduction level, so decoded image
+    // doesn't depend on the exact size, in which it is drawn (for example, on zoom).
+    QSize targetSize;
+    int reductionLevel = 0;
+    if (m_imageResolutionScale > 0.0)
     {
-        const PDFObject& colorSpaceObject = m_document->getObject(streamDictionary->get("ColorSpace"));
-        if (colorSpaceObject.isName() || colorSpaceObject.isArray())
-        {
-            colorSpace = PDFAbstractColorSpace::createColorSpace(m_colorSpaceDictionary, m_document, colorSpaceObject);
-        }
-        else if (!colorSpaceObject.isNull())
+        const QTransform matrix = getCurrentWorldMatrix();
+        const QPointF origin = matrix.map(QPointF(0.0, 0.0));
+        const PDFReal targetWidth = QLineF(origin, matrix.map(QPointF(1.0, 0.0))).length() * m_imageResolutionScale;
+        const PDFReal targetHeight = QLineF(origin, matrix.map(QPointF(0.0, 1.0))).length() * m_imageResolutionScale;
+        constexpr PDFReal maximalTargetDimension = 65536.0;
+        const QSize drawnSize(qMax(qCeil(qMin(targetWidth, maximalTargetDimension)), 1), qMax(qCeil(qMin(targetHeight, maximalTargetDimension)), 1));
+
+        PDFDocumentDataLoaderDecorator loader(m_document);
+        const PDFDictionary* streamDictionary = stream->getDictionary();
+        const QSize imageSize(static_cast<int>(loader.readIntegerFromDictionary(streamDictionary, "Width", 0)),
+                              static_cast<int>(loader.readIntegerFromDictionary(streamDictionary, "Height", 0)));
+        if (!imageSize.isEmpty())
         {
-            throw PDFRendererException(RenderErrorType::Error, PDFTranslationContext::tr("Invalid color space of the image."));
+            reductionLevel = PDFImage::getReductionLevel(imageSize, drawnSize);
+            targetSize = PDFImage::getReducedSize(imageSize, reductionLevel);
         }
     }
 
-    PDFImage pdfImage = PDFImage::createImage(m_document, stream, qMove(colorSpace), false, m_graphicState.getRenderingIntent(), this);
+    // Image drawn on multiple pages is decoded only once, if image cache is used
+    bool isImageCacheUsed = m_imageCache && reference.isValid();
+    PDFImageCacheKey imageCacheKey;
+    QImage image;
 
-    if (!performOriginalImagePainting(pdfImage))
+    if (isImageCacheUsed)
     {
-        QImage image = pdfImage.getImage(m_CMS, this, m_operationControl);
+        imageCacheKey.reference = reference;
+        imageCacheKey.cmsInstanceId = m_CMS->getInstanceId();
+        imageCacheKey.renderingIntent = m_graphicState.getRenderingIntent();
+        imageCacheKey.reductionLevel = reductionLevel;
 
-        if (!isProcessingCancelled())
+        // Device color spaces of the image are replaced by default color spaces of the resources,
+        // so they are part of the key. Default color space, which is a direct object,
+        // can't be identified, so image is not cached in this case.
+        const char* defaultColorSpaceNames[] = { COLOR_SPACE_NAME_DEFAULT_GRAY, COLOR_SPACE_NAME_DEFAULT_RGB, COLOR_SPACE_NAME_DEFAULT_CMYK };
+        for (size_t i = 0; i < std::size(defaultColorSpaceNames); ++i)
         {
-            if (image.format() == QImage::Format_Alpha8)
+            if (m_colorSpaceDictionary && m_colorSpaceDictionary->hasKey(defaultColorSpaceNames[i]))
             {
-                QSize size = image.size();
-                QImage unmaskedImage(size, QImage::Format_ARGB32_Premultiplied);
-                unmaskedImage.fill(m_graphicState.getFillColor());
-                unmaskedImage.setAlphaChannel(image);
-                image = qMove(unmaskedImage);
+                const PDFObject& defaultColorSpaceObject = m_colorSpaceDictionary->get(defaultColorSpaceNames[i]);
+                if (defaultColorSpaceObject.isReference())
+                {
+                    imageCacheKey.defaultColorSpaces[i] = defaultColorSpaceObject.getReference();
+                }
+                else
+                {
+                    isImageCacheUsed = false;
+                }
             }
+        }
+
+        if (isImageCacheUsed)
+        {
+            image = m_imageCache->getImage(imageCacheKey);
+        }
+    }
+
+    if (image.isNull())
+    {
+        PDFColorSpacePointer colorSpace;
 
-            if (!image.isNull())
+        const PDFDictionary* streamDictionary = stream->getDictionary();
+        if (streamDictionary->hasKey("ColorSpace"))
+        {
+            const PDFObject& colorSpaceObject = m_document->getObject(streamDictionary->get("ColorSpace"));
+            if (colorSpaceObject.isName() || colorSpaceObject.isArray())
             {
-                performImagePainting(image);
+                colorSpace = PDFAbstractColorSpace::createColorSpace(m_colorSpaceDictionary, m_document, colorSpaceObject);
             }
-            else
+            else if (!colorSpaceObject.isNull())
             {
-                throw PDFRendererException(RenderErrorType::Error, PDFTranslationContext::tr("Can't decode the image."));
+                throw PDFRendererException(RenderErrorType::Error, PDFTranslationContext::tr("Invalid color space of the image."));
             }
         }
+
+        PDFImage pdfImage = PDFImage::createImage(m_document, stream, qMove(colorSpace), false, m_graphicState.getRenderingIntent(), this, targetSize);
+
+        if (performOriginalImagePainting(pdfImage))
+        {
+            return;
+        }
+
+        image = pdfImage.getImage(m_CMS, this, m_operationControl);
+
+        if (isImageCacheUsed && !image.isNull() && !isProcessingCancelled())
+        {
+            m_imageCache->insertImage(imageCacheKey, image);
+        }
+    }
+
+    if (!isProcessingCancelled())
+    {
+        if (image.format() == QImage::Format_Alpha8)
+        {
+            QSize size = image.size();
+            QImage unmaskedImage(size, QImage::Format_ARGB32_Premultiplied);
+            unmaskedImage.fill(m_graphicState.getFillColor());
+            unmaskedImage.setAlphaChannel(image);
+            image = qMove(unmaskedImage);
+        }
+
+        if (!image.isNull())
+        {
+            performImagePainting(image);
+        }
+        else
+        {
+            throw PDFRendererException(RenderErrorType::Error, PDFTranslationContext::tr("Can't decode the image."));
+        }
     }
 }
 
@@ -3006,6 +3126,11 @@ void PDFPageContentProcessor::reportWarningAboutColorOperatorsInUTP()
 }
 
 void PDFPageContentProcessor::processForm(const PDFStream* stream)
+{
+    processFormStream(stream, PDFObject());
+}
+
+void PDFPageContentProcessor::processFormStream(const PDFStream* stream, const PDFObject& streamObject)
 {
     PDFDocumentDataLoaderDecorator loader(getDocument());
     const PDFDictionary* streamDictionary = stream->getDictionary();
@@ -3016,9 +3141,6 @@ void PDFPageContentProcessor::processForm(const PDFStream* stream)
     // Read the transformation matrix, if it is present
     QTransform transformationMatrix = loader.readMatrixFromDictionary(streamDictionary, "Matrix", QTransform());
 
-    // Read the dictionary content
-    QByteArray content = m_document->getDecodedStream(stream);
-
     // Read resources
     PDFObject resources = m_document->getObject(streamDictionary->get("Resources"));
 
@@ -3028,7 +3150,17 @@ void PDFPageContentProcessor::processForm(const PDFStream* stream)
     // Form structural parent key
     const PDFInteger formStructuralParentKey = loader.readIntegerFromDictionary(streamDictionary, "StructParent", m_structuralParentKey);
 
-    processForm(transformationMatrix, boundingBox, resources, transparencyGroup, content, formStructuralParentKey);
+    // Take translated form content stream from the cache, or interpret it directly
+    if (m_bytecodeCache && streamObject.isStream())
+    {
+        PDFContentStreamBytecodePointer bytecode = m_bytecodeCache->getBytecode(m_document, streamObject);
+        processForm(transformationMatrix, boundingBox, resources, transparencyGroup, QByteArray(), bytecode.data(), formStructuralParentKey);
+    }
+    else
+    {
+        QByteArray content = m_document->getDecodedStream(stream);
+        processForm(transformationMatrix, boundingBox, resources, transparencyGroup, content, nullptr, formStructuralParentKey);
+    }
 }
 
 void PDFPageContentProcessor::operatorPaintXObject(PDFOperandName name)
@@ -3065,7 +3197,8 @@ void PDFPageContentProcessor::operatorPaintXObject(PDFOperandName name)
             QByteArray subtype = loader.readNameFromDictionary(streamDictionary, "Subtype");
             if (subtype == "Image")
             {
-                paintXObjectImage(stream);
+                const PDFObject& imageObject = m_xobjectDictionary->get(name.name);
+                paintXObjectImage(stream, imageObject.isReference() ? imageObject.getReference() : PDFObjectReference());
             }
             else if (subtype == "Form")
             {
@@ -3075,7 +3208,7 @@ void PDFPageContentProcessor::operatorPaintXObject(PDFOperandName name)
                     throw PDFRendererException(RenderErrorType::Error, PDFTranslationContext::tr("Form of type %1 not supported.").arg(formType));
                 }
 
-                processForm(stream);
+                processFormStream(stream, object);
             }
             else
             {
@@ -3222,7 +3355,9 @@ void PDFPageContentProcessor::drawText(const TextSequence& textSequence)
                         if (!glyphPath.isEmpty())
                         {
                             QPainterPath transformedGlyph = textRenderingMatrix.map(glyphPath);
+                            m_paintedTextGlyph = PDFTextGlyphInfo{ font->getInstanceId(), item.glyphIndex, textRenderingMatrix };
                             processPathPainting(transformedGlyph, stroke, fill, true, transformedGlyph.fillRule());
+                            m_paintedTextGlyph = PDFTextGlyphInfo();
 
                             if (clipped)
                             {
@@ -3374,7 +3509,7 @@ PDFObject PDFPageContentProcessor::readObjectFromOperandStack(size_t startPositi
     {
         if (startPosition < m_operands.size())
         {
-            return m_operands[startPosition++];
+            return m_operands[startPosition++].toToken();
         }
         return PDFLexicalAnalyzer::Token();
     };
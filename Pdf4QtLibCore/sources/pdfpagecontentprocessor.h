@@ -33,6 +33,7 @@
 #include <QPainterPath>
 #include <QSharedPointer>
 
+#include <deque>
 #include <stack>
 #include <tuple>
 #include <type_traits>
@@ -42,6 +43,9 @@ namespace pdf
 class PDFCMS;
 class PDFMesh;
 class PDFImage;
+class PDFImageCache;
+class PDFContentStreamBytecode;
+class PDFContentStreamBytecodeCache;
 class PDFTilingPattern;
 class PDFShadingPattern;
 class PDFOptionalContentActivity;
@@ -213,6 +217,30 @@ public:
     };
     Q_DECLARE_FLAGS(ProcedureSets, ProcedureSet)
 
+    /// Operand of the content stream operator. Numbers are stored directly, names
+    /// and strings refer to the string, which must exist, while operand is used.
+    struct Operand
+    {
+        PDFLexicalAnalyzer::TokenType type = PDFLexicalAnalyzer::TokenType::Null;
+
+        union
+        {
+            bool boolean;
+            PDFInteger integer = 0;
+            PDFReal real;
+        };
+
+        const QByteArray* string = nullptr; ///< Name or string (nullptr for other types)
+
+        /// Converts operand to the token of lexical analyzer
+        PDFLexicalAnalyzer::Token toToken() const;
+    };
+
+    /// Returns operator for the command. If command is unknown,
+    /// then Operator::Invalid is returned.
+    /// \param command Command (operator name in the content stream)
+    static Operator getOperator(const QByteArray& command);
+
     /// Process the contents of the page
     QList<PDFRenderError> processContents();
 
@@ -250,11 +278,42 @@ public:
     /// \param newOperationControl Operation control object
     void setOperationControl(const PDFOperationControl* newOperationControl);
 
+    /// Sets number of device pixels per device space unit, which is used to decide,
+    /// at which resolution are images decoded. JPEG and JPEG 2000 images can then
+    /// be decoded at reduced resolution, if they are drawn small. If scale is zero
+    /// (default), images are always decoded at full resolution.
+    /// \param imageResolutionScale Device pixels per device space unit
+    void setImageResolutionScale(PDFReal imageResolutionScale) { m_imageResolutionScale = imageResolutionScale; }
+
+    /// Returns image resolution scale (zero means full resolution)
+    PDFReal getImageResolutionScale() const { return m_imageResolutionScale; }
+
+    /// Sets image cache, which is used to share decoded images between pages
+    /// (and between threads). If image cache is not set, images are always decoded.
+    /// Do not use image cache in processors, which paint original images.
+    /// \param imageCache Image cache
+    void setImageCache(const PDFImageCache* imageCache) { m_imageCache = imageCache; }
+
+    /// Sets cache of translated content streams, so page content streams and forms
+    /// need not to be parsed again, when page is processed again. If cache is not set,
+    /// content streams are always parsed.
+    /// \param bytecodeCache Bytecode cache
+    void setBytecodeCache(const PDFContentStreamBytecodeCache* bytecodeCache) { m_bytecodeCache = bytecodeCache; }
+
     /// Returns true, if page content processing is being cancelled
     bool isProcessingCancelled() const;
 
 protected:
 
+    /// Identification of the glyph, which is being painted by the text
+    /// showing operator. Glyph path is mapped by the matrix to the user space.
+    struct PDFTextGlyphInfo
+    {
+        quint64 fontId = 0;
+        GID glyphIndex = 0;
+        QTransform matrix;
+    };
+
     struct PDFTransparencyGroup
     {
         PDFColorSpacePointer colorSpacePointer;
@@ -703,6 +762,11 @@ protected:
     /// Returns font cache
     const PDFFontCache* getFontCache() const { return m_fontCache; }
 
+    /// Returns glyph, which is being painted by the text showing operator,
+    /// or nullptr, if no glyph is being painted or the glyph is unknown.
+    /// Painted path is the glyph path mapped by the glyph matrix.
+    const PDFTextGlyphInfo* getPaintedTextGlyph() const { return m_paintedTextGlyph.glyphIndex ? &m_paintedTextGlyph : nullptr; }
+
     /// Returns optional content activity
     const PDFOptionalContentActivity* getOptionalContentActivity() const { return m_optionalContentActivity; }
 
@@ -720,17 +784,56 @@ protected:
     void processForm(const PDFStream* stream);
 
 private:
+    /// Interpreter of the content stream, which processes parsed operators immediately
+    class ContentStreamInterpreter;
+
     /// Initializes the resources dictionaries
     void initDictionaries(const PDFObject& resourcesObject);
 
     /// Process the content stream
-    void processContentStream(const PDFStream* stream);
+    /// \param streamObject Content stream object
+    void processContentStream(const PDFObject& streamObject);
 
-    /// Process the content
+    /// Process the content (content stream is interpreted directly)
     void processContent(const QByteArray& content);
 
+    /// Executes translated content stream
+    void processBytecode(const PDFContentStreamBytecode& bytecode);
+
+    /// Copies strings of the operands, which remain on the operand stack at the end of the
+    /// content stream, so operands don't refer to the strings of the processed content stream.
+    void detachOperands();
+
+    /// Processes operator with operands on the operand stack, then clears the operand stack.
+    /// Errors are reported to the error list.
+    /// \param op Operator
+    /// \param command Command (used for error reporting)
+    void processOperator(Operator op, const QByteArray& command);
+
+    /// Paints inline image, errors are reported to the error list
+    /// \param inlineImage Inline image stream
+    void processInlineImage(const PDFStream* inlineImage);
+
     /// Processes single command
-    void processCommand(const QByteArray& command);
+    /// \param op Operator
+    /// \param command Command (used for error reporting)
+    void processCommand(Operator op, const QByteArray& command);
+
+    /// Process form using form stream. If form stream object is valid,
+    /// then translated form content stream is taken from the bytecode cache.
+    /// \param stream Form stream
+    /// \param streamObject Form stream object (can be null)
+    void processFormStream(const PDFStream* stream, const PDFObject& streamObject);
+
+    /// Processes form, see public function of the same name. If bytecode
+    /// is not nullptr, it is executed, otherwise content is interpreted directly.
+    void processForm(const QTransform& matrix,
+                     const QRectF& boundingBox,
+                     const PDFObject& resources,
+                     const PDFObject& transparencyGroup,
+                     const QByteArray& content,
+                     const PDFContentStreamBytecode* bytecode,
+                     PDFInteger formStructuralParent);
 
     /// Performs path painting
     /// \param path Path, which should be drawn (can be emtpy - in that case nothing happens)
@@ -1007,7 +1110,9 @@ private:
     PDFObject readObjectFromOperandStack(size_t startPosition) const;
 
     /// Implementation of painting of XObject image
-    void paintXObjectImage(const PDFStream* stream);
+    /// \param stream Image stream
+    /// \param reference Reference to the image stream (invalid for inline images)
+    void paintXObjectImage(const PDFStream* stream, PDFObjectReference reference = PDFObjectReference());
 
     /// Report warning about color operators in uncolored tiling pattern
     void reportWarningAboutColorOperatorsInUTP();
@@ -1039,7 +1144,11 @@ private:
     PDFColorSpacePointer m_deviceCMYKColorSpace;
 
     /// Array with current operand arguments
-    PDFFlatArray<PDFLexicalAnalyzer::Token, 33> m_operands;
+    PDFFlatArray<Operand, 33> m_operands;
+
+    /// Strings of the operands, which remained on the operand stack
+    /// at the end of the previous content stream
+    std::deque<QByteArray> m_detachedOperandStrings;
 
     /// Stack with saved graphic states
     std::stack<PDFPageContentProcessorState> m_stack;
@@ -1071,6 +1180,9 @@ private:
     /// Actually realized physical font
     PDFCachedItem<PDFRealizedFontPointer> m_realizedFont;
 
+    /// Glyph being painted by the text showing operator
+    PDFTextGlyphInfo m_paintedTextGlyph;
+
     /// Actual clipping path obtained from text. Clipping path
     /// is in device space coordinates.
     QPainterPath m_textClippingPath;
@@ -1089,6 +1201,15 @@ private:
     /// Mesh quality settings
     PDFMeshQualitySettings m_meshQualitySettings;
 
+    /// Device pixels per device space unit used for image decoding (zero means full resolution)
+    PDFReal m_imageResolutionScale = 0.0;
+
+    /// Cache of decoded images (can be nullptr)
+    const PDFImageCache* m_imageCache = nullptr;
+
+    /// Cache of translated content streams (can be nullptr)
+    const PDFContentStreamBytecodeCache* m_bytecodeCache = nullptr;
+
     /// Set with rendering errors, which were reported (and should be reported once)
     std::set<QString> m_onceReportedErrors;
 
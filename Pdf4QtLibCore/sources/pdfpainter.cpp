@@ -19,8 +19,10 @@
 #include "pdfpattern.h"
 #include "pdfcms.h"
 #include "pdfpainterutils.h"
+#include "pdfglyphcache.h"
 
 #include <QPainter>
+#include <QPaintEngine>
 #include <QCryptographicHash>
 #include <QtMath>
 
@@ -422,7 +424,17 @@ void PDFPrecompiledPageGenerator::performPathPainting(const QPainterPath& path,
 
     QPen pen = stroke ? getCurrentPen() : QPen(Qt::NoPen);
     QBrush brush = fill ? getCurrentBrush() : QBrush(Qt::NoBrush);
-    m_precompiledPage->addPath(qMove(pen), qMove(brush), path, text);
+
+    // Filled glyphs are recorded with their identity, so they can be drawn from the glyph cache
+    const PDFTextGlyphInfo* glyph = (text && fill && !stroke) ? getPaintedTextGlyph() : nullptr;
+    if (glyph)
+    {
+        m_precompiledPage->addPath(qMove(pen), qMove(brush), path, text, glyph->fontId, glyph->glyphIndex, glyph->matrix);
+    }
+    else
+    {
+        m_precompiledPage->addPath(qMove(pen), qMove(brush), path, text);
+    }
 }
 
 void PDFPrecompiledPageGenerator::performClipping(const QPainterPath& path, Qt::FillRule fillRule)
@@ -505,6 +517,14 @@ void PDFPrecompiledPageGenerator::setCompositionMode(QPainter::CompositionMode m
     m_precompiledPage->addSetCompositionMode(mode);
 }
 
+/// Returns true, if rectangles intersect. Unlike QRectF::intersects, rectangles
+/// with zero width or height (for example, bounding box of horizontal line)
+/// are also considered. Both rectangles must be normalized.
+static inline bool isRectIntersecting(const QRectF& r1, const QRectF& r2)
+{
+    return r1.left() <= r2.right() && r2.left() <= r1.right() && r1.top() <= r2.bottom() && r2.top() <= r1.bottom();
+}
+
 void PDFPrecompiledPage::draw(QPainter* painter,
                               const QRectF& cropBox,
                               const QTransform& pagePointToDevicePointMatrix,
@@ -512,8 +532,40 @@ void PDFPrecompiledPage::draw(QPainter* painter,
                               PDFReal opacity) const
 {
     Q_ASSERT(painter);
+
+    painter->save();
+    painter->setWorldTransform(QTransform());
+    QRectF deviceClipRect = getDeviceClipRect(painter);
+    painter->restore();
+
+    draw(painter, cropBox, pagePointToDevicePointMatrix, features, opacity, deviceClipRect);
+}
+
+void PDFPrecompiledPage::draw(QPainter* painter,
+                              const QRectF& cropBox,
+                              const QTransform& pagePointToDevicePointMatrix,
+                              PDFRenderer::Features features,
+                              PDFReal opacity,
+                              const QRectF& deviceClipRect) const
+{
+    Q_ASSERT(painter);
     Q_ASSERT(pagePointToDevicePointMatrix.isInvertible());
 
+    // Determine visible area in page coordinates. Bounding boxes of the instructions
+    // are in page coordinates, so we do not have to map each bounding box.
+    QRectF pageClipRect;
+    const bool isCullingEnabled = deviceClipRect.isValid() && m_cullingNodes.size() == m_instructions.size();
+    if (isCullingEnabled)
+    {
+        const PDFReal padding = m_cullingDevicePadding;
+        pageClipRect = pagePointToDevicePointMatrix.inverted().mapRect(deviceClipRect.adjusted(-padding, -padding, padding, padding));
+    }
+
+    auto isCulled = [&pageClipRect](const QRectF& boundingBox, bool isEmpty)
+    {
+        return isEmpty || !isRectIntersecting(boundingBox, pageClipRect);
+    };
+
     painter->save();
     painter->setWorldTransform(QTransform());
     painter->setOpacity(opacity);
@@ -530,9 +582,39 @@ void PDFPrecompiledPage::draw(QPainter* painter,
 
     painter->setRenderHint(QPainter::SmoothPixmapTransform, features.testFlag(PDFRenderer::SmoothImages));
 
-    // Process all instructions
-    for (const Instruction& instruction : m_instructions)
+    // Process all visible instructions
+    const size_t instructionCount = m_instructions.size();
+    size_t blockIndex = 0;
+    size_t index = 0;
+    while (index < instructionCount)
     {
+        if (isCullingEnabled)
+        {
+            // Test the whole block of drawing instructions first
+            while (blockIndex < m_cullingBlocks.size() && m_cullingBlocks[blockIndex].begin < index)
+            {
+                ++blockIndex;
+            }
+
+            if (blockIndex < m_cullingBlocks.size() && m_cullingBlocks[blockIndex].begin == index)
+            {
+                const CullingBlock& block = m_cullingBlocks[blockIndex];
+                if (isCulled(block.boundingBox, block.isEmpty))
+                {
+                    index = block.end;
+                    continue;
+                }
+            }
+
+            const CullingNode& node = m_cullingNodes[index];
+            if (node.nextIndex != 0 && isCulled(node.boundingBox, node.isEmpty))
+            {
+                index = node.nextIndex;
+                continue;
+            }
+        }
+
+        const Instruction& instruction = m_instructions[index++];
         switch (instruction.type)
         {
             case InstructionType::DrawPath:
@@ -541,6 +623,26 @@ void PDFPrecompiledPage::draw(QPainter* painter,
 
                 // Set antialiasing
                 const bool antialiasing = (data.isText && features.testFlag(PDFRenderer::TextAntialiasing)) || (!data.isText && features.testFlag(PDFRenderer::Antialiasing));
+
+                // Try to blit the glyph from the glyph cache
+                if (data.glyphDataIndex != -1 && antialiasing && features.testFlag(PDFRenderer::GlyphCache) && data.brush.style() == Qt::SolidPattern)
+                {
+                    const GlyphPaintData& glyph = m_glyphs[data.glyphDataIndex];
+                    const PDFReal devicePixelRatio = painter->device()->devicePixelRatioF();
+                    const QTransform pathToDeviceMatrix = painter->worldTransform() * QTransform::fromScale(devicePixelRatio, devicePixelRatio);
+
+                    QPoint position;
+                    QImage image = PDFGlyphCache::getInstance()->getGlyph(glyph.fontId, glyph.glyphIndex, glyph.matrix, data.path, pathToDeviceMatrix, data.brush.color(), position);
+                    if (!image.isNull())
+                    {
+                        const QTransform worldMatrix = painter->worldTransform();
+                        painter->setWorldTransform(QTransform::fromScale(1.0 / devicePixelRatio, 1.0 / devicePixelRatio));
+                        painter->drawImage(position, image);
+                        painter->setWorldTransform(worldMatrix);
+                        break;
+                    }
+                }
+
                 painter->setRenderHint(QPainter::Antialiasing, antialiasing);
                 painter->setPen(data.pen);
                 painter->setBrush(data.brush);
@@ -648,6 +750,7 @@ void PDFPrecompiledPage::redact(QPainterPath redactPath, const QTransform& matri
                 QPainterPath mappedRedactPath = currentMatrix.map(redactPath);
                 PathPaintData& path = m_paths[instruction.dataIndex];
                 path.path = path.path.subtracted(mappedRedactPath);
+                path.glyphDataIndex = -1;
                 break;
             }
 
@@ -711,12 +814,20 @@ void PDFPrecompiledPage::redact(QPainterPath redactPath, const QTransform& matri
         addRestoreGraphicState();
         addPath(Qt::NoPen, QBrush(color), matrix.map(redactPath), false);
     }
+
+    buildCullingHierarchy();
 }
 
-void PDFPrecompiledPage::addPath(QPen pen, QBrush brush, QPainterPath path, bool isText)
+void PDFPrecompiledPage::addPath(QPen pen, QBrush brush, QPainterPath path, bool isText, quint64 fontId, GID glyphIndex, const QTransform& glyphMatrix)
 {
     m_instructions.emplace_back(InstructionType::DrawPath, m_paths.size());
     m_paths.emplace_back(qMove(pen), qMove(brush), qMove(path), isText);
+
+    if (glyphIndex)
+    {
+        m_paths.back().glyphDataIndex = static_cast<int>(m_glyphs.size());
+        m_glyphs.push_back(GlyphPaintData{ fontId, glyphIndex, glyphMatrix });
+    }
 }
 
 void PDFPrecompiledPage::addClip(QPainterPath path)
@@ -760,6 +871,7 @@ void PDFPrecompiledPage::optimize()
 {
     m_instructions.shrink_to_fit();
     m_paths.shrink_to_fit();
+    m_glyphs.shrink_to_fit();
     m_clips.shrink_to_fit();
     m_images.shrink_to_fit();
     m_meshes.shrink_to_fit();
@@ -809,15 +921,20 @@ void PDFPrecompiledPage::finalize(qint64 compilingTimeNS, QList<PDFRenderError>
     m_compilingTimeNS = compilingTimeNS;
     m_errors = qMove(errors);
 
+    buildCullingHierarchy();
+
     // Determine memory consumption
     m_memoryConsumptionEstimate = sizeof(*this);
     m_memoryConsumptionEstimate += sizeof(Instruction) * m_instructions.capacity();
     m_memoryConsumptionEstimate += sizeof(PathPaintData) * m_paths.capacity();
+    m_memoryConsumptionEstimate += sizeof(GlyphPaintData) * m_glyphs.capacity();
     m_memoryConsumptionEstimate += sizeof(ClipData) * m_clips.capacity();
     m_memoryConsumptionEstimate += sizeof(ImageData) * m_images.capacity();
     m_memoryConsumptionEstimate += sizeof(MeshPaintData) * m_meshes.capacity();
     m_memoryConsumptionEstimate += sizeof(QTransform) * m_matrices.capacity();
     m_memoryConsumptionEstimate += sizeof(QPainter::CompositionMode) * m_compositionModes.capacity();
+    m_memoryConsumptionEstimate += sizeof(CullingNode) * m_cullingNodes.capacity();
+    m_memoryConsumptionEstimate += sizeof(CullingBlock) * m_cullingBlocks.capacity();
     m_memoryConsumptionEstimate += sizeof(PDFRenderError) * m_errors.size();
 
     auto calculateQPathMemoryConsumption = [](const QPainterPath& path)
@@ -842,6 +959,293 @@ void PDFPrecompiledPage::finalize(qint64 compilingTimeNS, QList<PDFRenderError>
     }
 }
 
+void PDFPrecompiledPage::buildCullingHierarchy()
+{
+    // Maximal count of drawing instructions in one culling block
+    constexpr size_t MAX_BLOCK_SIZE = 32;
+
+    // Bounding box of graphics, which are drawn before the first world matrix
+    // is set. Such graphics are in device coordinates, so they are never culled.
+    const QRectF unboundedRect(QPointF(-1e30, -1e30), QPointF(1e30, 1e30));
+
+    struct State
+    {
+        QTransform matrix;
+        bool isMatrixKnown = false;
+        QRectF clipBox;
+        bool isClipEmpty = false;
+        size_t saveIndex = 0;
+        QRectF boundingBox;     ///< Bounding box of graphics drawn in this state
+        bool isEmpty = true;
+    };
+
+    auto unite = [](QRectF& boundingBox, bool& isEmpty, const QRectF& rect)
+    {
+        if (isEmpty)
+        {
+            boundingBox = rect;
+            isEmpty = false;
+        }
+        else
+        {
+            boundingBox.setCoords(qMin(boundingBox.left(), rect.left()), qMin(boundingBox.top(), rect.top()),
+                                  qMax(boundingBox.right(), rect.right()), qMax(boundingBox.bottom(), rect.bottom()));
+        }
+    };
+
+    auto intersect = [](const QRectF& r1, const QRectF& r2, QRectF& result)
+    {
+        const PDFReal left = qMax(r1.left(), r2.left());
+        const PDFReal top = qMax(r1.top(), r2.top());
+        const PDFReal right = qMin(r1.right(), r2.right());
+        const PDFReal bottom = qMin(r1.bottom(), r2.bottom());
+
+        if (left > right || top > bottom)
+        {
+            return false;
+        }
+
+        result.setCoords(left, top, right, bottom);
+        return true;
+    };
+
+    m_cullingNodes.assign(m_instructions.size(), CullingNode());
+    m_cullingBlocks.clear();
+
+    // Antialiasing can touch one more pixel
+    m_cullingDevicePadding = 1.0;
+
+    State initialState;
+    initialState.clipBox = unboundedRect;
+
+    std::stack<State> stateStack;
+    stateStack.push(initialState);
+
+    CullingBlock block;
+    auto finishBlock = [this, &block]()
+    {
+        // Block with single instruction is useless, node
+        // of the instruction is tested anyway.
+        if (block.end - block.begin > 1)
+        {
+            m_cullingBlocks.push_back(block);
+        }
+        block = CullingBlock();
+    };
+
+    for (size_t i = 0; i < m_instructions.size(); ++i)
+    {
+        const Instruction& instruction = m_instructions[i];
+
+        bool isDrawing = false;
+        bool isEmpty = false;
+        QRectF boundingBox;
+
+        switch (instruction.type)
+        {
+            case InstructionType::DrawPath:
+            {
+                const State& state = stateStack.top();
+                const PathPaintData& data = m_paths[instruction.dataIndex];
+
+                boundingBox = data.path.controlPointRect();
+                if (data.pen.style() != Qt::NoPen)
+                {
+                    if (data.pen.isCosmetic())
+                    {
+                        // Width of cosmetic pen is in device pixels
+                        m_cullingDevicePadding = qMax(m_cullingDevicePadding, data.pen.widthF() + 1.0);
+                    }
+                    else
+                    {
+                        // Miter join can extend up to miter limit times pen width from the joint
+                        const Qt::PenJoinStyle joinStyle = data.pen.joinStyle();
+                        const bool isMiterJoin = joinStyle == Qt::MiterJoin || joinStyle == Qt::SvgMiterJoin;
+                        const PDFReal margin = data.pen.widthF() * (isMiterJoin ? qMax(data.pen.miterLimit(), 1.0) : 1.0);
+                        boundingBox.adjust(-margin, -margin, margin, margin);
+                    }
+                }
+
+                boundingBox = state.isMatrixKnown ? state.matrix.mapRect(boundingBox) : unboundedRect;
+                isEmpty = data.path.isEmpty();
+                isDrawing = true;
+                break;
+            }
+
+            case InstructionType::DrawImage:
+            {
+                const State& state = stateStack.top();
+                boundingBox = state.isMatrixKnown ? state.matrix.mapRect(QRectF(0, 0, 1, 1)) : unboundedRect;
+                isDrawing = true;
+                break;
+            }
+
+            case InstructionType::DrawMesh:
+            {
+                // Mesh is painted in page coordinates, regardless of the world matrix,
+                // triangles are painted using pen with width 1.
+                const MeshPaintData& data = m_meshes[instruction.dataIndex];
+                boundingBox = data.mesh.getBoundingRect().adjusted(-1.0, -1.0, 1.0, 1.0);
+                isEmpty = data.mesh.isEmpty();
+                isDrawing = true;
+                break;
+            }
+
+            case InstructionType::Clip:
+            {
+                State& state = stateStack.top();
+                if (state.isMatrixKnown && !state.isClipEmpty)
+                {
+                    QRectF clipBox = state.matrix.mapRect(m_clips[instruction.dataIndex].clipPath.controlPointRect());
+                    state.isClipEmpty = !intersect(state.clipBox, clipBox, state.clipBox);
+                }
+                break;
+            }
+
+            case InstructionType::SaveGraphicState:
+            {
+                State state = stateStack.top();
+                state.saveIndex = i;
+                state.boundingBox = QRectF();
+                state.isEmpty = true;
+                stateStack.push(state);
+                break;
+            }
+
+            case InstructionType::RestoreGraphicState:
+            {
+                if (stateStack.size() > 1)
+                {
+                    // Whole block between save and restore can be culled
+                    State state = stateStack.top();
+                    stateStack.pop();
+
+                    CullingNode& node = m_cullingNodes[state.saveIndex];
+                    node.boundingBox = state.boundingBox;
+                    node.nextIndex = i + 1;
+                    node.isEmpty = state.isEmpty;
+
+                    if (!state.isEmpty)
+                    {
+                        State& parentState = stateStack.top();
+                        unite(parentState.boundingBox, parentState.isEmpty, state.boundingBox);
+                    }
+                }
+                break;
+            }
+
+            case InstructionType::SetWorldMatrix:
+            {
+                State& state = stateStack.top();
+                state.matrix = m_matrices[instruction.dataIndex];
+                state.isMatrixKnown = true;
+                break;
+            }
+
+            case InstructionType::SetCompositionMode:
+                break;
+
+            default:
+            {
+                Q_ASSERT(false);
+                break;
+            }
+        }
+
+        if (!isDrawing)
+        {
+            finishBlock();
+            continue;
+        }
+
+        State& state = stateStack.top();
+        isEmpty = isEmpty || state.isClipEmpty || !intersect(boundingBox, state.clipBox, boundingBox);
+
+        CullingNode& node = m_cullingNodes[i];
+        node.boundingBox = boundingBox;
+        node.nextIndex = i + 1;
+        node.isEmpty = isEmpty;
+
+        if (!isEmpty)
+        {
+            unite(state.boundingBox, state.isEmpty, boundingBox);
+        }
+
+        if (block.end != i)
+        {
+            finishBlock();
+            block.begin = i;
+        }
+
+        block.end = i + 1;
+        if (!isEmpty)
+        {
+            unite(block.boundingBox, block.isEmpty, boundingBox);
+        }
+
+        if (block.end - block.begin == MAX_BLOCK_SIZE)
+        {
+            finishBlock();
+        }
+    }
+
+    finishBlock();
+
+    m_cullingNodes.shrink_to_fit();
+    m_cullingBlocks.shrink_to_fit();
+}
+
+QRectF PDFPrecompiledPage::getDeviceClipRect(QPainter* painter)
+{
+    QPaintDevice* device = painter->device();
+    if (!device)
+    {
+        return QRectF();
+    }
+
+    // We can determine visible area only on raster devices. Vector devices,
+    // such as printers or pictures, can be scaled afterwards.
+    switch (device->devType())
+    {
+        case QInternal::Widget:
+        case QInternal::Image:
+        case QInternal::Pixmap:
+        case QInternal::CustomRaster:
+            break;
+
+        default:
+            return QRectF();
+    }
+
+    bool isInvertible = false;
+    QTransform deviceToLogicalMatrix = painter->combinedTransform().inverted(&isInvertible);
+    if (!isInvertible)
+    {
+        return QRectF();
+    }
+
+    QRectF rect = deviceToLogicalMatrix.mapRect(QRectF(0, 0, device->width(), device->height()));
+
+    // System clip (for example, region being repainted in the widget) is
+    // in device pixels, so we can use it only for unscaled devices.
+    QPaintEngine* paintEngine = painter->paintEngine();
+    if (paintEngine && qFuzzyCompare(device->devicePixelRatio(), 1.0))
+    {
+        QRegion systemClip = paintEngine->systemClip();
+        if (!systemClip.isEmpty())
+        {
+            rect = rect.intersected(deviceToLogicalMatrix.mapRect(QRectF(systemClip.boundingRect())));
+        }
+    }
+
+    if (painter->hasClipping())
+    {
+        rect = rect.intersected(painter->clipBoundingRect());
+    }
+
+    return rect;
+}
+
 PDFPrecompiledPage::GraphicPieceInfos PDFPrecompiledPage::calculateGraphicPieceInfos(QRectF mediaBox,
                                                                                      PDFReal epsilon) const
 {
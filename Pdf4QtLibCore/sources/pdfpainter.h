@@ -196,13 +196,39 @@ public:
               PDFRenderer::Features features,
               PDFReal opacity) const;
 
+    /// Paints page onto the painter using matrix. Only instructions, whose bounding
+    /// box intersects the device clip rectangle, are replayed. Blocks of instructions
+    /// between save/restore graphic state lying outside the rectangle are skipped
+    /// entirely, including their clipping and state changes.
+    /// \param painter Painter, onto which is page drawn
+    /// \param cropBox Page's crop box
+    /// \param pagePointToDevicePointMatrix Page point to device point transformation matrix
+    /// \param features Renderer features
+    /// \param opacity Opacity of page graphics
+    /// \param deviceClipRect Visible area in device coordinates (if invalid, all instructions are replayed)
+    void draw(QPainter* painter,
+              const QRectF& cropBox,
+              const QTransform& pagePointToDevicePointMatrix,
+              PDFRenderer::Features features,
+              PDFReal opacity,
+              const QRectF& deviceClipRect) const;
+
     /// Redact path - remove all content intersecting given path,
     /// and fill redact path with given color.
     /// \param redactPath Redaction path in page coordinates
     /// \param color Redaction color (if invalid, nothing is being drawn)
     void redact(QPainterPath redactPath, const QTransform& matrix, QColor color);
 
-    void addPath(QPen pen, QBrush brush, QPainterPath path, bool isText);
+    /// Adds path painting. If glyph is specified, path is the glyph path mapped
+    /// by the glyph matrix, and it can be drawn from the glyph cache.
+    /// \param pen Pen
+    /// \param brush Brush
+    /// \param path Path
+    /// \param isText Is text being drawn?
+    /// \param fontId Instance identifier of the realized font (glyph only)
+    /// \param glyphIndex Glyph index (zero, if path is not a glyph)
+    /// \param glyphMatrix Glyph matrix (glyph only)
+    void addPath(QPen pen, QBrush brush, QPainterPath path, bool isText, quint64 fontId = 0, GID glyphIndex = 0, const QTransform& glyphMatrix = QTransform());
     void addClip(QPainterPath path);
     void addImage(QImage image);
     void addMesh(PDFMesh mesh, PDFReal alpha);
@@ -238,6 +264,20 @@ public:
     QColor getPaperColor() const { return m_paperColor; }
     void setPaperColor(QColor paperColor) { m_paperColor = paperColor; }
 
+    /// Returns number of device pixels per page point, for which images of this page
+    /// were decoded. Images can be blurry, if page is drawn at higher scale. Zero
+    /// means, that images were decoded at full resolution.
+    PDFReal getImageResolutionScale() const { return m_imageResolutionScale; }
+    void setImageResolutionScale(PDFReal imageResolutionScale) { m_imageResolutionScale = imageResolutionScale; }
+
+    /// Returns true, if images of this page were decoded at resolution lower, than
+    /// is required by \p imageResolutionScale (zero means full resolution).
+    /// \param imageResolutionScale Required number of device pixels per page point
+    bool isImageResolutionInsufficient(PDFReal imageResolutionScale) const
+    {
+        return m_imageResolutionScale > 0.0 && (imageResolutionScale <= 0.0 || m_imageResolutionScale < imageResolutionScale);
+    }
+
     PDFSnapInfo* getSnapInfo() { return &m_snapInfo; }
     const PDFSnapInfo* getSnapInfo() const { return &m_snapInfo; }
 
@@ -307,6 +347,16 @@ private:
         QBrush brush;
         QPainterPath path;
         bool isText = false;
+        int glyphDataIndex = -1;    ///< Index of the glyph data (-1, if path is not a glyph)
+    };
+
+    /// Identification of the glyph drawn by the path. Glyph path
+    /// is mapped by the glyph matrix to the path coordinates.
+    struct GlyphPaintData
+    {
+        quint64 fontId = 0;
+        GID glyphIndex = 0;
+        QTransform matrix;
     };
 
     struct ClipData
@@ -347,16 +397,51 @@ private:
         PDFReal alpha = 1.0;
     };
 
+    /// Culling information for one instruction. For drawing instruction, it is
+    /// its bounding box (already clipped by the active clip). For save graphic state
+    /// instruction, it is the bounding box of all graphics drawn until matching
+    /// restore graphic state instruction.
+    struct CullingNode
+    {
+        QRectF boundingBox;     ///< Bounding box in page coordinates
+        size_t nextIndex = 0;   ///< Index of instruction after the culled range (zero, if instruction can't be culled)
+        bool isEmpty = true;    ///< No visible graphics are drawn in the culled range
+    };
+
+    /// Run of consecutive drawing instructions, which are tested
+    /// against the visible area at once.
+    struct CullingBlock
+    {
+        size_t begin = 0;
+        size_t end = 0;
+        QRectF boundingBox;
+        bool isEmpty = true;
+    };
+
+    /// Builds bounding box hierarchy of the instructions
+    void buildCullingHierarchy();
+
+    /// Returns visible area of the painter in device coordinates. Painter must
+    /// have identity world transform. If visible area can't be determined,
+    /// invalid rectangle is returned.
+    /// \param painter Painter
+    static QRectF getDeviceClipRect(QPainter* painter);
+
     qint64 m_compilingTimeNS = 0;
     qint64 m_memoryConsumptionEstimate = 0;
+    PDFReal m_cullingDevicePadding = 0.0;
+    PDFReal m_imageResolutionScale = 0.0;
     QColor m_paperColor = QColor(Qt::white);
     std::vector<Instruction> m_instructions;
     std::vector<PathPaintData> m_paths;
+    std::vector<GlyphPaintData> m_glyphs;
     std::vector<ClipData> m_clips;
     std::vector<ImageData> m_images;
     std::vector<MeshPaintData> m_meshes;
     std::vector<QTransform> m_matrices;
     std::vector<QPainter::CompositionMode> m_compositionModes;
+    std::vector<CullingNode> m_cullingNodes;
+    std::vector<CullingBlock> m_cullingBlocks;
     QList<PDFRenderError> m_errors;
     PDFSnapInfo m_snapInfo;
     QElapsedTimer m_expirationTimer;
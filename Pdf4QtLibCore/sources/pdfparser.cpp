@@ -553,6 +553,20 @@ QByteArray PDFLexicalAnalyzer::fetchByteArray(PDFInteger length)
     return result;
 }
 
+QByteArray PDFLexicalAnalyzer::fetchRawByteArray(PDFInteger length)
+{
+    Q_ASSERT(length >= 0);
+
+    if (std::distance(m_current, m_end) < length)
+    {
+        error(tr("Can't read %1 bytes from the input stream. Input stream end reached.").arg(length));
+    }
+
+    QByteArray result = QByteArray::fromRawData(m_current, length);
+    std::advance(m_current, length);
+    return result;
+}
+
 PDFInteger PDFLexicalAnalyzer::findSubstring(const char* str, PDFInteger position) const
 {
     const PDFInteger length = std::distance(m_begin, m_end);
@@ -863,7 +877,7 @@ PDFObject PDFParser::getObject()
 
                 // Skip the stream start, then fetch data of the stream
                 m_lexicalAnalyzer.skipStreamStart();
-                QByteArray buffer = m_lexicalAnalyzer.fetchByteArray(length);
+                QByteArray buffer = m_features.testFlag(ReferenceStreamData) ? m_lexicalAnalyzer.fetchRawByteArray(length) : m_lexicalAnalyzer.fetchByteArray(length);
 
                 // According to the PDF Reference 1.7, chapter 3.2.7, stream content can also be specified
                 // in the external file. If this is the case, then we must try to load the stream data
@@ -140,6 +140,13 @@ public:
     /// \param length Length of the buffer
     QByteArray fetchByteArray(PDFInteger length);
 
+    /// Reads number of bytes from the buffer and creates a byte array, which
+    /// references the input buffer data (no data are copied). Input buffer must
+    /// outlive the returned byte array. If end of stream appears before desired
+    /// end byte, exception is thrown.
+    /// \param length Length of the buffer
+    QByteArray fetchRawByteArray(PDFInteger length);
+
     /// Returns, if whole stream was scanned
     inline bool isAtEnd() const { return m_current == m_end; }
 
@@ -289,8 +296,9 @@ class PDF4QTLIBCORESHARED_EXPORT PDFParser
 public:
     enum Feature
     {
-        None            = 0x0000,
-        AllowStreams    = 0x0001
+        None                = 0x0000,
+        AllowStreams        = 0x0001,
+        ReferenceStreamData = 0x0002,   ///< Stream data are not copied, they reference input data (input data must outlive parsed objects)
     };
 
     Q_DECLARE_FLAGS(Features, Feature)
@@ -23,6 +23,7 @@
 #include "pdfexecutionpolicy.h"
 #include "pdfconstants.h"
 #include "pdfpainterutils.h"
+#include "pdfcoveragerasterizer.h"
 
 #include <QMutex>
 #include <QPainter>
@@ -71,7 +72,8 @@ PDFPatternPtr PDFPattern::createPattern(const PDFDictionary* colorSpaceDictionar
                                         const PDFObject& object,
                                         const PDFCMS* cms,
                                         RenderingIntent intent,
-                                        PDFRenderErrorReporter* reporter)
+                                        PDFRenderErrorReporter* reporter,
+                                        bool approximateFunctions)
 {
     const PDFObject& dereferencedObject = document->getObject(object);
     const PDFDictionary* patternDictionary = nullptr;
@@ -132,6 +134,7 @@ PDFPatternPtr PDFPattern::createPattern(const PDFDictionary* colorSpaceDictionar
                 pattern->m_yStep = yStep;
                 pattern->m_resources = resources;
                 pattern->m_content = qMove(streamData);
+                pattern->m_contentStream = dereferencedObject;
 
                 return PDFPatternPtr(pattern);
             }
@@ -140,7 +143,7 @@ PDFPatternPtr PDFPattern::createPattern(const PDFDictionary* colorSpaceDictionar
             {
                 PDFObject patternGraphicState = document->getObject(patternDictionary->get("ExtGState"));
                 QTransform matrix = loader.readMatrixFromDictionary(patternDictionary, "Matrix", QTransform());
-                return createShadingPattern(colorSpaceDictionary, document, patternDictionary->get("Shading"), matrix, patternGraphicState, cms, intent, reporter, false);
+                return createShadingPattern(colorSpaceDictionary, document, patternDictionary->get("Shading"), matrix, patternGraphicState, cms, intent, reporter, false, approximateFunctions);
             }
 
             default:
@@ -159,7 +162,8 @@ PDFPatternPtr PDFPattern::createShadingPattern(const PDFDictionary* colorSpaceDi
                                                const PDFCMS* cms,
                                                RenderingIntent intent,
                                                PDFRenderErrorReporter* reporter,
-                                               bool ignoreBackgroundColor)
+                                               bool ignoreBackgroundColor,
+                                               bool approximateFunctions)
 {
     const PDFObject& dereferencedShadingObject = document->getObject(shadingObject);
     if (!dereferencedShadingObject.isDictionary() && !dereferencedShadingObject.isStream())
@@ -221,6 +225,14 @@ PDFPatternPtr PDFPattern::createShadingPattern(const PDFDictionary* colorSpaceDi
         extendStart = loader.readBoolean(array->getItem(0), false);
         extendEnd = loader.readBoolean(array->getItem(1), false);
     }
+    // Shading functions are evaluated for each sample of the shading, so expensive
+    // PostScript functions can be replaced by sampled approximations, if it is enabled.
+    auto createFunction = [&](const PDFObject& object)
+    {
+        PDFFunctionPtr function = PDFFunction::createFunction(document, object);
+        return approximateFunctions ? PDFFunction::createSampledApproximation(function) : function;
+    };
+
     std::vector<PDFFunctionPtr> functions;
     const PDFObject& functionsObject = document->getObject(shadingDictionary->get("Function"));
     if (functionsObject.isArray())
@@ -229,12 +241,12 @@ PDFPatternPtr PDFPattern::createShadingPattern(const PDFDictionary* colorSpaceDi
         functions.reserve(functionsArray->getCount());
         for (size_t i = 0, functionCount = functionsArray->getCount(); i < functionCount; ++i)
         {
-            functions.push_back(PDFFunction::createFunction(document, functionsArray->getItem(i)));
+            functions.push_back(createFunction(functionsArray->getItem(i)));
         }
     }
     else if (!functionsObject.isNull())
     {
-        functions.push_back(PDFFunction::createFunction(document, functionsObject));
+        functions.push_back(createFunction(functionsObject));
     }
 
     const ShadingType shadingType = static_cast<ShadingType>(loader.readIntegerFromDictionary(shadingDictionary, "ShadingType", static_cast<PDFInteger>(ShadingType::Invalid)));
@@ -919,6 +931,62 @@ PDFShadingSampler* PDFFunctionShading::createSampler(QTransform userSpaceToDevic
     return new PDFFunctionShadingSampler(this, userSpaceToDeviceSpaceMatrix);
 }
 
+PDFSingleDimensionShading::ColoredCoordinates PDFSingleDimensionShading::selectMeshCoordinates(const ColoredCoordinates& coloredCoordinates,
+                                                                                                 PDFReal xStart,
+                                                                                                 PDFReal xEnd,
+                                                                                                 PDFReal tolerance)
+{
+    ColoredCoordinates selectedCoordinates;
+    if (coloredCoordinates.empty())
+    {
+        return selectedCoordinates;
+    }
+
+    // Greedy algorithm - we extend the segment from the last selected coordinate
+    // as far as possible. Coordinate is omitted, if colors of all coordinates
+    // covered by the segment are close to the linearly interpolated color.
+    selectedCoordinates.push_back(coloredCoordinates.front());
+    size_t anchor = 0;
+    for (size_t next = 2; next < coloredCoordinates.size(); ++next)
+    {
+        const std::pair<PDFReal, PDFColor>& anchorItem = coloredCoordinates[anchor];
+        const std::pair<PDFReal, PDFColor>& nextItem = coloredCoordinates[next];
+        const std::pair<PDFReal, PDFColor>& lastItem = coloredCoordinates[next - 1];
+
+        bool canOmit = lastItem.first != xStart && lastItem.first != xEnd;
+        for (size_t i = anchor + 1; canOmit && i < next; ++i)
+        {
+            const std::pair<PDFReal, PDFColor>& item = coloredCoordinates[i];
+            const PDFReal ratio = (item.first - anchorItem.first) / (nextItem.first - anchorItem.first);
+            canOmit = PDFAbstractColorSpace::isColorEqual(PDFAbstractColorSpace::mixColors(anchorItem.second, nextItem.second, ratio), item.second, tolerance);
+        }
+
+        if (!canOmit)
+        {
+            selectedCoordinates.push_back(lastItem);
+            anchor = next - 1;
+        }
+    }
+
+    if (coloredCoordinates.size() > 1)
+    {
+        selectedCoordinates.push_back(coloredCoordinates.back());
+    }
+
+    return selectedCoordinates;
+}
+
+std::vector<QRgb> PDFSingleDimensionShading::getDeviceColors(const ColoredCoordinates& coloredCoordinates,
+                                                             const PDFCMS* cms,
+                                                             RenderingIntent intent,
+                                                             PDFRenderErrorReporter* reporter) const
+{
+    std::vector<PDFColor> colors;
+    colors.reserve(coloredCoordinates.size());
+    std::transform(coloredCoordinates.cbegin(), coloredCoordinates.cend(), std::back_inserter(colors), [](const auto& item) { return item.second; });
+    return m_colorSpace->getRGBColors(colors, cms, intent, reporter);
+}
+
 PDFMesh PDFAxialShading::createMesh(const PDFMeshQualitySettings& settings,
                                     const PDFCMS* cms,
                                     RenderingIntent intent,
@@ -1043,44 +1111,8 @@ PDFMesh PDFAxialShading::createMesh(const PDFMeshQualitySettings& settings,
         coloredCoordinates.emplace_back(x, color);
     }
 
-    // Filter coordinates according the meshing criteria
-    std::vector<std::pair<PDFReal, PDFColor>> filteredCoordinates;
-    filteredCoordinates.reserve(coloredCoordinates.size());
-
-    for (auto it = coloredCoordinates.cbegin(); it != coloredCoordinates.cend(); ++it)
-    {
-        // We will skip this coordinate, if both of meshing criteria have been met:
-        //  1) Color difference is small (lesser than tolerance)
-        //  2) Distance from previous and next point is less than preferred meshing resolution OR colors are equal
-
-        if (it != coloredCoordinates.cbegin() && std::next(it) != coloredCoordinates.cend())
-        {
-            auto itNext = std::next(it);
-
-            const std::pair<PDFReal, PDFColor>& prevItem = filteredCoordinates.back();
-            const std::pair<PDFReal, PDFColor>& currentItem = *it;
-            const std::pair<PDFReal, PDFColor>& nextItem = *itNext;
-
-            if (currentItem.first != p1m.x() && currentItem.first != p2m.x())
-            {
-                if (prevItem.second == currentItem.second && currentItem.second == nextItem.second)
-                {
-                    // Colors are same, skip the test
-                    continue;
-                }
-
-                if (PDFAbstractColorSpace::isColorEqual(prevItem.second, currentItem.second, settings.tolerance) &&
-                        PDFAbstractColorSpace::isColorEqual(currentItem.second, nextItem.second, settings.tolerance) &&
-                        PDFAbstractColorSpace::isColorEqual(prevItem.second, nextItem.second, settings.tolerance) &&
-                        (nextItem.first - prevItem.first < settings.preferredMeshResolution))
-                {
-                    continue;
-                }
-            }
-        }
-
-        filteredCoordinates.push_back(*it);
-    }
+    // Select mesh coordinates, colors are interpolated between them
+    const ColoredCoordinates filteredCoordinates = selectMeshCoordinates(coloredCoordinates, p1m.x(), p2m.x(), settings.tolerance);
 
     if (!filteredCoordinates.empty())
     {
@@ -1094,45 +1126,48 @@ PDFMesh PDFAxialShading::createMesh(const PDFMeshQualitySettings& settings,
         }
         mesh.reserve(vertexCount, triangleCount);
 
-        PDFColor previousColor = filteredCoordinates.front().second;
-        uint32_t topLeft = mesh.addVertex(QPointF(filteredCoordinates.front().first, yt));
-        uint32_t bottomLeft = mesh.addVertex(QPointF(filteredCoordinates.front().first, yb));
-        for (auto it = std::next(filteredCoordinates.cbegin()); it != filteredCoordinates.cend(); ++it)
+        const std::vector<QRgb> colors = getDeviceColors(filteredCoordinates, cms, intent, reporter);
+
+        QRgb previousColor = colors.front();
+        uint32_t topLeft = mesh.addVertex(QPointF(filteredCoordinates.front().first, yt), previousColor);
+        uint32_t bottomLeft = mesh.addVertex(QPointF(filteredCoordinates.front().first, yb), previousColor);
+        for (size_t i = 1; i < filteredCoordinates.size(); ++i)
         {
-            const std::pair<PDFReal, PDFColor>& item = *it;
+            const std::pair<PDFReal, PDFColor>& item = filteredCoordinates[i];
+            const QRgb color = colors[i];
 
-            uint32_t topRight = mesh.addVertex(QPointF(item.first, yt));
-            uint32_t bottomRight = mesh.addVertex(QPointF(item.first, yb));
+            uint32_t topRight = mesh.addVertex(QPointF(item.first, yt), color);
+            uint32_t bottomRight = mesh.addVertex(QPointF(item.first, yb), color);
 
-            PDFColor mixedColor = PDFAbstractColorSpace::mixColors(previousColor, item.second, 0.5);
-            QColor color = m_colorSpace->getColor(mixedColor, cms, intent, reporter, true);
-            mesh.addQuad(topLeft, topRight, bottomRight, bottomLeft, color.rgb());
+            mesh.addQuad(topLeft, topRight, bottomRight, bottomLeft, PDFMesh::mixColors(previousColor, color, 0.5));
 
             topLeft = topRight;
             bottomLeft = bottomRight;
-            previousColor = item.second;
+            previousColor = color;
         }
     }
 
     // Create background color triangles
     if (m_backgroundColor.isValid() && (!m_extendStart || !m_extendEnd))
     {
+        const QRgb backgroundColor = m_backgroundColor.rgb();
+
         if (!m_extendStart && xl + PDF_EPSILON < p1m.x())
         {
-            uint32_t topLeft = mesh.addVertex(QPointF(xl, yt));
-            uint32_t topRight = mesh.addVertex(QPointF(p1m.x(), yt));
-            uint32_t bottomLeft = mesh.addVertex(QPointF(xl, yb));
-            uint32_t bottomRight = mesh.addVertex(QPointF(p1m.x(), yb));
-            mesh.addQuad(topLeft, topRight, bottomRight, bottomLeft, m_backgroundColor.rgb());
+            uint32_t topLeft = mesh.addVertex(QPointF(xl, yt), backgroundColor);
+            uint32_t topRight = mesh.addVertex(QPointF(p1m.x(), yt), backgroundColor);
+            uint32_t bottomLeft = mesh.addVertex(QPointF(xl, yb), backgroundColor);
+            uint32_t bottomRight = mesh.addVertex(QPointF(p1m.x(), yb), backgroundColor);
+            mesh.addQuad(topLeft, topRight, bottomRight, bottomLeft, backgroundColor);
         }
 
         if (!m_extendEnd && p2m.x() + PDF_EPSILON < xr)
         {
-            uint32_t topRight = mesh.addVertex(QPointF(xr, yt));
-            uint32_t topLeft = mesh.addVertex(QPointF(p2m.x(), yt));
-            uint32_t bottomRight = mesh.addVertex(QPointF(xr, yb));
-            uint32_t bottomLeft = mesh.addVertex(QPointF(p2m.x(), yb));
-            mesh.addQuad(topLeft, topRight, bottomRight, bottomLeft, m_backgroundColor.rgb());
+            uint32_t topRight = mesh.addVertex(QPointF(xr, yt), backgroundColor);
+            uint32_t topLeft = mesh.addVertex(QPointF(p2m.x(), yt), backgroundColor);
+            uint32_t bottomRight = mesh.addVertex(QPointF(xr, yb), backgroundColor);
+            uint32_t bottomLeft = mesh.addVertex(QPointF(p2m.x(), yb), backgroundColor);
+            mesh.addQuad(topLeft, topRight, bottomRight, bottomLeft, backgroundColor);
         }
     }
 
@@ -1339,6 +1374,13 @@ void PDFMesh::paint(QPainter* painter, PDFReal alpha) const
         painter->drawPath(m_backgroundPath);
     }
 
+    if (hasVertexColors())
+    {
+        paintInterpolatedTriangles(painter, alpha);
+        painter->restore();
+        return;
+    }
+
     QColor color;
 
     // Draw all triangles
@@ -1360,6 +1402,248 @@ void PDFMesh::paint(QPainter* painter, PDFReal alpha) const
     painter->restore();
 }
 
+void PDFMesh::paintInterpolatedTriangles(QPainter* painter, PDFReal alpha) const
+{
+    Q_ASSERT(m_vertexColors.size() == m_vertices.size());
+
+    const QTransform deviceMatrix = painter->combinedTransform();
+    if (!deviceMatrix.isInvertible())
+    {
+        return;
+    }
+
+    std::vector<QPointF> deviceVertices(m_vertices.size());
+    std::transform(m_vertices.cbegin(), m_vertices.cend(), deviceVertices.begin(), [&deviceMatrix](const QPointF& vertex) { return deviceMatrix.map(vertex); });
+
+    auto [xMin, xMax] = std::minmax_element(deviceVertices.cbegin(), deviceVertices.cend(), [](const QPointF& l, const QPointF& r) { return l.x() < r.x(); });
+    auto [yMin, yMax] = std::minmax_element(deviceVertices.cbegin(), deviceVertices.cend(), [](const QPointF& l, const QPointF& r) { return l.y() < r.y(); });
+    QRectF deviceRect(QPointF(xMin->x(), yMin->y()), QPointF(xMax->x(), yMax->y()));
+
+    // We rasterize only the visible part of the mesh
+    const QPaintDevice* device = painter->device();
+    const QRect paintDeviceRect(0, 0, static_cast<int>(std::ceil(device->width() * device->devicePixelRatio())), static_cast<int>(std::ceil(device->height() * device->devicePixelRatio())));
+    if (painter->hasClipping())
+    {
+        deviceRect = deviceRect.intersected(deviceMatrix.mapRect(painter->clipBoundingRect()));
+    }
+
+    const QRect rasterizedRect = deviceRect.toAlignedRect().intersected(paintDeviceRect);
+    if (rasterizedRect.isEmpty())
+    {
+        return;
+    }
+
+    // Image is drawn in device space pixels, so we must cancel
+    // all transformations. Clipping is already set.
+    painter->setWorldTransform(deviceMatrix.inverted() * painter->worldTransform());
+
+    // Large areas are rasterized in bands to limit the memory consumption
+    constexpr int BAND_PIXEL_COUNT = 4 * 1024 * 1024;
+    const int bandHeight = qMax(BAND_PIXEL_COUNT / rasterizedRect.width(), 1);
+    for (int bandTop = rasterizedRect.top(); bandTop <= rasterizedRect.bottom(); bandTop += bandHeight)
+    {
+        QRect bandRect(rasterizedRect.left(), bandTop, rasterizedRect.width(), qMin(bandHeight, rasterizedRect.bottom() + 1 - bandTop));
+        QImage image = rasterizeInterpolatedTriangles(deviceVertices, bandRect, alpha);
+        painter->drawImage(bandRect.topLeft(), image);
+    }
+}
+
+QImage PDFMesh::rasterizeInterpolatedTriangles(const std::vector<QPointF>& deviceVertices, QRect rect, PDFReal alpha) const
+{
+    const int width = rect.width();
+    const int height = rect.height();
+
+    // Colors of the pixels are determined from the triangle, which contains
+    // the pixel center. Pixels on the edges of the mesh, whose center is
+    // not covered by any triangle, are colored by nearby triangle (color is
+    // extrapolated), the coverage determines the opacity of these pixels.
+    // Pixels with covered center are opaque, so small gaps between the triangles
+    // (for example, between the subdivided and not subdivided edge) are not visible.
+    enum : uint8_t
+    {
+        PixelEmpty,
+        PixelTouched,
+        PixelCenterCovered
+    };
+
+    std::vector<QRgb> colors(size_t(width) * size_t(height), 0);
+    std::vector<uint8_t> pixelStates(colors.size(), PixelEmpty);
+
+    // Triangles are oriented consistently, so their common edges cancel out
+    // and the coverage is the coverage of the painted area of the mesh.
+    PDFCoverageRasterizer coverageRasterizer(rect);
+
+    for (const Triangle& triangle : m_triangles)
+    {
+        std::array<QPointF, 3> points = { deviceVertices[triangle.v1], deviceVertices[triangle.v2], deviceVertices[triangle.v3] };
+        std::array<QRgb, 3> vertexColors = { m_vertexColors[triangle.v1], m_vertexColors[triangle.v2], m_vertexColors[triangle.v3] };
+
+        const QPointF d1 = points[1] - points[0];
+        const QPointF d2 = points[2] - points[0];
+        PDFReal doubleArea = d1.x() * d2.y() - d2.x() * d1.y();
+        if (!std::isfinite(doubleArea) || qFuzzyIsNull(doubleArea))
+        {
+            // Degenerated triangle, nothing to paint
+            continue;
+        }
+
+        if (doubleArea < 0.0)
+        {
+            std::swap(points[1], points[2]);
+            std::swap(vertexColors[1], vertexColors[2]);
+            doubleArea = -doubleArea;
+        }
+
+        coverageRasterizer.addLine(points[0], points[1]);
+        coverageRasterizer.addLine(points[1], points[2]);
+        coverageRasterizer.addLine(points[2], points[0]);
+
+        // Color is a linear function c(x, y) = c0 + dcdx * (x - x0) + dcdy * (y - y0)
+        const QPointF e1 = points[1] - points[0];
+        const QPointF e2 = points[2] - points[0];
+        const PDFReal inverseDoubleArea = 1.0 / doubleArea;
+
+        std::array<PDFReal, 3> c0 = { };
+        std::array<PDFReal, 3> dcdx = { };
+        std::array<PDFReal, 3> dcdy = { };
+        for (size_t i = 0; i < c0.size(); ++i)
+        {
+            auto getChannel = [i](QRgb color) -> PDFReal
+            {
+                switch (i)
+                {
+                    case 0:
+                        return qRed(color);
+                    case 1:
+                        return qGreen(color);
+                    default:
+                        return qBlue(color);
+                }
+            };
+
+            c0[i] = getChannel(vertexColors[0]);
+            const PDFReal dc1 = getChannel(vertexColors[1]) - c0[i];
+            const PDFReal dc2 = getChannel(vertexColors[2]) - c0[i];
+            dcdx[i] = (dc1 * e2.y() - dc2 * e1.y()) * inverseDoubleArea;
+            dcdy[i] = (dc2 * e1.x() - dc1 * e2.x()) * inverseDoubleArea;
+        }
+
+        // Returns horizontal extent of the intersection of the triangle with horizontal line
+        auto getExtent = [&points](PDFReal y, PDFReal& left, PDFReal& right)
+        {
+            for (size_t i = 0; i < points.size(); ++i)
+            {
+                const QPointF& a = points[i];
+                const QPointF& b = points[(i + 1) % points.size()];
+
+                if ((a.y() <= y && y <= b.y()) || (b.y() <= y && y <= a.y()))
+                {
+                    const PDFReal x = (a.y() == b.y()) ? a.x() : a.x() + (y - a.y()) * (b.x() - a.x()) / (b.y() - a.y());
+                    left = qMin(left, x);
+                    right = qMax(right, x);
+                    if (a.y() == b.y())
+                    {
+                        left = qMin(left, b.x());
+                        right = qMax(right, b.x());
+                    }
+                }
+            }
+        };
+
+        const PDFReal triangleTop = qMin(points[0].y(), qMin(points[1].y(), points[2].y()));
+        const PDFReal triangleBottom = qMax(points[0].y(), qMax(points[1].y(), points[2].y()));
+        const int rowStart = qMax(static_cast<int>(std::floor(triangleTop)), rect.top());
+        const int rowEnd = qMin(static_cast<int>(std::ceil(triangleBottom)), rect.bottom() + 1);
+
+        for (int row = rowStart; row < rowEnd; ++row)
+        {
+            // Pixels touched by the triangle (the part of the triangle in the row)
+            PDFReal left = std::numeric_limits<PDFReal>::infinity();
+            PDFReal right = -std::numeric_limits<PDFReal>::infinity();
+            getExtent(row, left, right);
+            getExtent(row + 1.0, left, right);
+            for (const QPointF& point : points)
+            {
+                if (row <= point.y() && point.y() <= row + 1.0)
+                {
+                    left = qMin(left, point.x());
+                    right = qMax(right, point.x());
+                }
+            }
+
+            if (left > right)
+            {
+                continue;
+            }
+
+            // Pixels, whose center is covered by the triangle
+            PDFReal centerLeft = std::numeric_limits<PDFReal>::infinity();
+            PDFReal centerRight = -std::numeric_limits<PDFReal>::infinity();
+            const PDFReal yCenter = row + 0.5;
+            getExtent(yCenter, centerLeft, centerRight);
+
+            const int columnStart = qMax(static_cast<int>(std::floor(left)), rect.left());
+            const int columnEnd = qMin(qMax(static_cast<int>(std::ceil(right)), columnStart + 1), rect.right() + 1);
+            if (columnStart >= columnEnd)
+            {
+                continue;
+            }
+
+            const PDFReal xStart = columnStart + 0.5;
+            std::array<PDFReal, 3> c = { };
+            for (size_t i = 0; i < c.size(); ++i)
+            {
+                c[i] = c0[i] + dcdx[i] * (xStart - points[0].x()) + dcdy[i] * (yCenter - points[0].y());
+            }
+
+            const size_t rowOffset = size_t(row - rect.top()) * width;
+            QRgb* rowColors = colors.data() + rowOffset;
+            uint8_t* rowPixelStates = pixelStates.data() + rowOffset;
+            for (int column = columnStart; column < columnEnd; ++column)
+            {
+                const PDFReal xCenter = column + 0.5;
+                const uint8_t state = (centerLeft <= xCenter && xCenter <= centerRight) ? PixelCenterCovered : PixelTouched;
+                const int index = column - rect.left();
+
+                if (state >= rowPixelStates[index])
+                {
+                    rowPixelStates[index] = state;
+                    rowColors[index] = qRgb(qBound(0, qRound(c[0]), 255), qBound(0, qRound(c[1]), 255), qBound(0, qRound(c[2]), 255));
+                }
+
+                for (size_t i = 0; i < c.size(); ++i)
+                {
+                    c[i] += dcdx[i];
+                }
+            }
+        }
+    }
+
+    QImage image(width, height, QImage::Format_ARGB32_Premultiplied);
+    image.fill(Qt::transparent);
+
+    for (const PDFCoverageRasterizer::Span& span : coverageRasterizer.createSpans(Qt::WindingFill))
+    {
+        const int row = span.y - rect.top();
+        const int column = span.x - rect.left();
+        const int spanOpacity = qBound(0, qRound(span.coverage * alpha * 255.0), 255);
+        const int opaqueOpacity = qBound(0, qRound(alpha * 255.0), 255);
+
+        const size_t offset = size_t(row) * width + column;
+        const QRgb* rowColors = colors.data() + offset;
+        const uint8_t* rowPixelStates = pixelStates.data() + offset;
+        QRgb* scanline = reinterpret_cast<QRgb*>(image.scanLine(row)) + column;
+        for (int i = 0; i < span.length; ++i)
+        {
+            const QRgb color = rowColors[i];
+            const int opacity = (rowPixelStates[i] == PixelCenterCovered) ? opaqueOpacity : spanOpacity;
+            scanline[i] = qRgba(qRed(color) * opacity / 255, qGreen(color) * opacity / 255, qBlue(color) * opacity / 255, opacity);
+        }
+    }
+
+    return image;
+}
+
 void PDFMesh::transform(const QTransform& matrix)
 {
     for (QPointF& vertex : m_vertices)
@@ -1373,15 +1657,26 @@ void PDFMesh::transform(const QTransform& matrix)
 
 void PDFMesh::addMesh(std::vector<QPointF>&& vertices, std::vector<PDFMesh::Triangle>&& triangles)
 {
+    addMesh(qMove(vertices), std::vector<QRgb>(), qMove(triangles));
+}
+
+void PDFMesh::addMesh(std::vector<QPointF>&& vertices, std::vector<QRgb>&& vertexColors, std::vector<PDFMesh::Triangle>&& triangles)
+{
+    Q_ASSERT(vertexColors.empty() || vertexColors.size() == vertices.size());
+
     if (isEmpty())
     {
         m_vertices = qMove(vertices);
+        m_vertexColors = qMove(vertexColors);
         m_triangles = qMove(triangles);
     }
     else
     {
+        Q_ASSERT(hasVertexColors() == !vertexColors.empty());
+
         size_t offset = m_vertices.size();
         m_vertices.insert(m_vertices.cend(), vertices.cbegin(), vertices.cend());
+        m_vertexColors.insert(m_vertexColors.cend(), vertexColors.cbegin(), vertexColors.cend());
 
         for (Triangle& triangle : triangles)
         {
@@ -1399,16 +1694,59 @@ QPointF PDFMesh::getTriangleCenter(const PDFMesh::Triangle& triangle) const
     return (m_vertices[triangle.v1] + m_vertices[triangle.v2] + m_vertices[triangle.v3]) / 3.0;
 }
 
+QRgb PDFMesh::getTriangleCenterColor(const Triangle& triangle) const
+{
+    const QRgb c1 = m_vertexColors[triangle.v1];
+    const QRgb c2 = m_vertexColors[triangle.v2];
+    const QRgb c3 = m_vertexColors[triangle.v3];
+
+    return qRgb((qRed(c1) + qRed(c2) + qRed(c3) + 1) / 3,
+                (qGreen(c1) + qGreen(c2) + qGreen(c3) + 1) / 3,
+                (qBlue(c1) + qBlue(c2) + qBlue(c3) + 1) / 3);
+}
+
+QRgb PDFMesh::mixColors(QRgb color1, QRgb color2, PDFReal ratio)
+{
+    auto mix = [ratio](int value1, int value2) { return qRound(value1 * (1.0 - ratio) + value2 * ratio); };
+    return qRgba(mix(qRed(color1), qRed(color2)), mix(qGreen(color1), qGreen(color2)), mix(qBlue(color1), qBlue(color2)), mix(qAlpha(color1), qAlpha(color2)));
+}
+
 qint64 PDFMesh::getMemoryConsumptionEstimate() const
 {
     qint64 memoryConsumption = sizeof(*this);
     memoryConsumption += sizeof(QPointF) * m_vertices.capacity();
+    memoryConsumption += sizeof(QRgb) * m_vertexColors.capacity();
     memoryConsumption += sizeof(Triangle) * m_triangles.capacity();
     memoryConsumption += sizeof(QPainterPath::Element) * m_boundingPath.capacity();
     memoryConsumption += sizeof(QPainterPath::Element) * m_backgroundPath.capacity();
     return memoryConsumption;
 }
 
+QRectF PDFMesh::getBoundingRect() const
+{
+    QRectF boundingRect;
+
+    if (!m_triangles.empty())
+    {
+        auto [xMin, xMax] = std::minmax_element(m_vertices.cbegin(), m_vertices.cend(), [](const QPointF& l, const QPointF& r) { return l.x() < r.x(); });
+        auto [yMin, yMax] = std::minmax_element(m_vertices.cbegin(), m_vertices.cend(), [](const QPointF& l, const QPointF& r) { return l.y() < r.y(); });
+        boundingRect = QRectF(QPointF(xMin->x(), yMin->y()), QPointF(xMax->x(), yMax->y()));
+    }
+
+    // Background is painted even if mesh has no triangles
+    if (!m_backgroundPath.isEmpty() && m_backgroundColor.isValid())
+    {
+        boundingRect = boundingRect.united(m_backgroundPath.controlPointRect());
+    }
+
+    if (!m_boundingPath.isEmpty())
+    {
+        boundingRect = boundingRect.intersected(m_boundingPath.controlPointRect());
+    }
+
+    return boundingRect;
+}
+
 void PDFMesh::convertColors(const PDFColorConvertor& colorConvertor)
 {
     for (Triangle& triangle : m_triangles)
@@ -1418,6 +1756,11 @@ void PDFMesh::convertColors(const PDFColorConvertor& colorConvertor)
         triangle.color = adjustedColor.rgb();
     }
 
+    for (QRgb& vertexColor : m_vertexColors)
+    {
+        vertexColor = colorConvertor.convert(QColor::fromRgb(vertexColor), false, false).rgb();
+    }
+
     m_backgroundColor = colorConvertor.convert(m_backgroundColor, true, false);
 }
 
@@ -1605,50 +1948,14 @@ PDFMesh PDFRadialShading::createMesh(const PDFMeshQualitySettings& settings,
         coloredCoordinates.emplace_back(x, color);
     }
 
-    // Filter coordinates according the meshing criteria
-    std::vector<std::pair<PDFReal, PDFColor>> filteredCoordinates;
-    filteredCoordinates.reserve(coloredCoordinates.size());
-
-    for (auto it = coloredCoordinates.cbegin(); it != coloredCoordinates.cend(); ++it)
-    {
-        // We will skip this coordinate, if both of meshing criteria have been met:
-        //  1) Color difference is small (lesser than tolerance)
-        //  2) Distance from previous and next point is less than preferred meshing resolution OR colors are equal
-
-        if (it != coloredCoordinates.cbegin() && std::next(it) != coloredCoordinates.cend())
-        {
-            auto itNext = std::next(it);
-
-            const std::pair<PDFReal, PDFColor>& prevItem = filteredCoordinates.back();
-            const std::pair<PDFReal, PDFColor>& currentItem = *it;
-            const std::pair<PDFReal, PDFColor>& nextItem = *itNext;
-
-            if (currentItem.first != p1m.x() && currentItem.first != p2m.x())
-            {
-                if (prevItem.second == currentItem.second && currentItem.second == nextItem.second)
-                {
-                    // Colors are same, skip the test
-                    continue;
-                }
-
-                if (PDFAbstractColorSpace::isColorEqual(prevItem.second, currentItem.second, settings.tolerance) &&
-                        PDFAbstractColorSpace::isColorEqual(currentItem.second, nextItem.second, settings.tolerance) &&
-                        PDFAbstractColorSpace::isColorEqual(prevItem.second, nextItem.second, settings.tolerance) &&
-                        (nextItem.first - prevItem.first < settings.preferredMeshResolution))
-                {
-                    continue;
-                }
-            }
-        }
-
-        filteredCoordinates.push_back(*it);
-    }
+    // Select mesh coordinates, colors are interpolated between them
+    const ColoredCoordinates filteredCoordinates = selectMeshCoordinates(coloredCoordinates, p1m.x(), p2m.x(), settings.tolerance);
 
     if (!filteredCoordinates.empty())
     {
         constexpr const int SLICES = 120;
 
-        size_t vertexCount = filteredCoordinates.size() * SLICES * 4;
+        size_t vertexCount = filteredCoordinates.size() * SLICES;
         size_t triangleCount = filteredCoordinates.size() * SLICES * 2;
 
         if (m_backgroundColor.isValid())
@@ -1661,53 +1968,63 @@ PDFMesh PDFRadialShading::createMesh(const PDFMeshQualitySettings& settings,
         // Create background color triangles
         if (m_backgroundColor.isValid())
         {
-            uint32_t topLeft = mesh.addVertex(meshingRectangle.topLeft());
-            uint32_t topRight = mesh.addVertex(meshingRectangle.topRight());
-            uint32_t bottomLeft = mesh.addVertex(meshingRectangle.bottomRight());
-            uint32_t bottomRight = mesh.addVertex(meshingRectangle.bottomLeft());
-            mesh.addQuad(topLeft, topRight, bottomRight, bottomLeft, m_backgroundColor.rgb());
+            const QRgb backgroundColor = m_backgroundColor.rgb();
+            uint32_t topLeft = mesh.addVertex(meshingRectangle.topLeft(), backgroundColor);
+            uint32_t topRight = mesh.addVertex(meshingRectangle.topRight(), backgroundColor);
+            uint32_t bottomLeft = mesh.addVertex(meshingRectangle.bottomRight(), backgroundColor);
+            uint32_t bottomRight = mesh.addVertex(meshingRectangle.bottomLeft(), backgroundColor);
+            mesh.addQuad(topLeft, topRight, bottomRight, bottomLeft, backgroundColor);
         }
 
-        // Create radial shading triangles
+        // Create radial shading triangles. Each circle has SLICES vertices,
+        // which are shared by the quads on both sides of the circle.
         QLineF rLine(QPointF(p1m.x(), r1), QPointF(p2m.x(), r2));
         const PDFReal rlength = rLine.length();
+        const PDFReal angleStep = 2 * M_PI / SLICES;
 
-        for (auto it = std::next(filteredCoordinates.cbegin()); it != filteredCoordinates.cend(); ++it)
+        std::array<PDFReal, SLICES> cosines = { };
+        std::array<PDFReal, SLICES> sines = { };
+        for (int i = 0; i < SLICES; ++i)
         {
-            const std::pair<PDFReal, PDFColor>& leftItem = *std::prev(it);
-            const std::pair<PDFReal, PDFColor>& rightItem = *it;
+            cosines[i] = std::cos(angleStep * i);
+            sines[i] = std::sin(angleStep * i);
+        }
 
-            const PDFReal x0 = leftItem.first;
-            const PDFReal x1 = rightItem.first;
-            const PDFColor mixedColor = PDFAbstractColorSpace::mixColors(leftItem.second, rightItem.second, 0.5);
-            const PDFReal angleStep = 2 * M_PI / SLICES;
-            const PDFReal cr0 = rLine.pointAt((x0 - p1m.x()) / rlength).y();
-            const PDFReal cr1 = rLine.pointAt((x1 - p1m.x()) / rlength).y();
+        auto addCircle = [&](const std::pair<PDFReal, PDFColor>& item, QRgb color)
+        {
+            const PDFReal x = item.first;
+            const PDFReal r = rLine.pointAt((x - p1m.x()) / rlength).y();
 
-            PDFReal angle0 = 0;
+            uint32_t firstVertex = 0;
             for (int i = 0; i < SLICES; ++i)
             {
-                const PDFReal angle1 = angle0 + angleStep;
-                const PDFReal cos0 = std::cos(angle0);
-                const PDFReal sin0 = std::sin(angle0);
-                const PDFReal cos1 = std::cos(angle1);
-                const PDFReal sin1 = std::sin(angle1);
-
-                QPointF cp1(x0 + cos0 * cr0, sin0 * cr0);
-                QPointF cp2(x1 + cos0 * cr1, sin0 * cr1);
-                QPointF cp3(x1 + cos1 * cr1, sin1 * cr1);
-                QPointF cp4(x0 + cos1 * cr0, sin1 * cr0);
+                const uint32_t vertex = mesh.addVertex(QPointF(x + cosines[i] * r, sines[i] * r), color);
+                if (i == 0)
+                {
+                    firstVertex = vertex;
+                }
+            }
+            return firstVertex;
+        };
 
-                uint32_t v1 = mesh.addVertex(cp1);
-                uint32_t v2 = mesh.addVertex(cp2);
-                uint32_t v3 = mesh.addVertex(cp3);
-                uint32_t v4 = mesh.addVertex(cp4);
+        const std::vector<QRgb> colors = getDeviceColors(filteredCoordinates, cms, intent, reporter);
 
-                QColor color = m_colorSpace->getColor(mixedColor, cms, intent, reporter, true);
-                mesh.addQuad(v1, v2, v3, v4, color.rgb());
+        QRgb previousColor = colors.front();
+        uint32_t previousCircle = addCircle(filteredCoordinates.front(), previousColor);
+        for (size_t i = 1; i < filteredCoordinates.size(); ++i)
+        {
+            const QRgb color = colors[i];
+            const QRgb mixedColor = PDFMesh::mixColors(previousColor, color, 0.5);
+            const uint32_t circle = addCircle(filteredCoordinates[i], color);
 
-                angle0 = angle1;
+            for (uint32_t i = 0; i < SLICES; ++i)
+            {
+                const uint32_t j = (i + 1) % SLICES;
+                mesh.addQuad(previousCircle + i, circle + i, circle + j, previousCircle + j, mixedColor);
             }
+
+            previousCircle = circle;
+            previousColor = color;
         }
     }
 
@@ -2166,8 +2483,10 @@ bool PDFFreeFormGouradTriangleShading::processTriangles(InitializeFunction initi
     vertices.resize(vertexCount);
     std::vector<QPointF> meshVertices;
     meshVertices.resize(vertexCount);
+    std::vector<PDFColor> meshColors;
+    meshColors.resize(vertexCount);
 
-    auto readVertex = [this, &vertices, &patternSpaceToDeviceSpaceMatrix, &meshVertices, bytesPerVertex, xScaleRatio, yScaleRatio, colorScaleRatio, convertColors](size_t index)
+    auto readVertex = [this, &vertices, &patternSpaceToDeviceSpaceMatrix, &meshVertices, &meshColors, bytesPerVertex, xScaleRatio, yScaleRatio, colorScaleRatio, convertColors](size_t index)
     {
         PDFBitReader reader(&m_data, 8);
         reader.seek(index * bytesPerVertex);
@@ -2193,12 +2512,13 @@ bool PDFFreeFormGouradTriangleShading::processTriangles(InitializeFunction initi
             data.color = getColor(data.color);
         }
 
+        meshColors[index] = data.color;
         vertices[index] = qMove(data);
     };
 
     PDFIntegerRange indices(size_t(0), vertexCount);
     PDFExecutionPolicy::execute(PDFExecutionPolicy::Scope::Content, indices.begin(), indices.end(), readVertex);
-    initializeMeshFunction(qMove(meshVertices), triangleCount);
+    initializeMeshFunction(qMove(meshVertices), qMove(meshColors), triangleCount);
 
     vertices.front().flags = 0;
 
@@ -2275,9 +2595,12 @@ PDFMesh PDFFreeFormGouradTriangleShading::createMesh(const PDFMeshQualitySetting
         addSubdividedTriangles(settings, mesh, via, vib, vic, va->color, vb->color, vc->color, cms, intent, reporter);
     };
 
-    auto initializeMeshFunction = [&mesh](std::vector<QPointF>&& vertices, size_t triangleCount)
+    auto initializeMeshFunction = [this, &mesh, cms, intent, reporter](std::vector<QPointF>&& vertices, std::vector<PDFColor>&& vertexColors, size_t triangleCount)
     {
+        // Vertex colors are converted all at once, so color management
+        // system can transform whole array instead of single colors.
         mesh.reserve(0, triangleCount);
+        mesh.setVertexColors(m_colorSpace->getRGBColors(vertexColors, cms, intent, reporter));
         mesh.setVertices(qMove(vertices));
     };
 
@@ -2310,8 +2633,9 @@ PDFShadingSampler* PDFFreeFormGouradTriangleShading::createSampler(QTransform us
         sampler->addTriangle({ via, vib, vic }, { va->color, vb->color, vc->color });
     };
 
-    auto initializeMeshFunction = [sampler](std::vector<QPointF>&& vertices, size_t triangleCount)
+    auto initializeMeshFunction = [sampler](std::vector<QPointF>&& vertices, std::vector<PDFColor>&& vertexColors, size_t triangleCount)
     {
+        Q_UNUSED(vertexColors);
         sampler->setVertexArray(qMove(vertices));
         sampler->reserveSpaceForTriangles(triangleCount);
     };
@@ -2364,8 +2688,10 @@ bool PDFLatticeFormGouradTriangleShading::processTriangles(InitializeFunction in
     vertices.resize(vertexCount);
     std::vector<QPointF> meshVertices;
     meshVertices.resize(vertexCount);
+    std::vector<PDFColor> meshColors;
+    meshColors.resize(vertexCount);
 
-    auto readVertex = [this, &vertices, &patternSpaceToDeviceSpaceMatrix, &meshVertices, bytesPerVertex, xScaleRatio, yScaleRatio, colorScaleRatio, convertColors](size_t index)
+    auto readVertex = [this, &vertices, &patternSpaceToDeviceSpaceMatrix, &meshVertices, &meshColors, bytesPerVertex, xScaleRatio, yScaleRatio, colorScaleRatio, convertColors](size_t index)
     {
         PDFBitReader reader(&m_data, 8);
         reader.seek(index * bytesPerVertex);
@@ -2390,12 +2716,13 @@ bool PDFLatticeFormGouradTriangleShading::processTriangles(InitializeFunction in
             data.color = getColor(data.color);
         }
 
+        meshColors[index] = data.color;
         vertices[index] = qMove(data);
     };
 
     PDFIntegerRange indices(size_t(0), vertexCount);
     PDFExecutionPolicy::execute(PDFExecutionPolicy::Scope::Content, indices.begin(), indices.end(), readVertex);
-    initializeMeshFunction(qMove(meshVertices), triangleCount);
+    initializeMeshFunction(qMove(meshVertices), qMove(meshColors), triangleCount);
 
     auto getVertexIndex = [columnCount](size_t row, size_t column) -> size_t
     {
@@ -2443,9 +2770,12 @@ PDFMesh PDFLatticeFormGouradTriangleShading::createMesh(const PDFMeshQualitySett
         addSubdividedTriangles(settings, mesh, via, vib, vic, va->color, vb->color, vc->color, cms, intent, reporter);
     };
 
-    auto initializeMeshFunction = [&mesh](std::vector<QPointF>&& vertices, size_t triangleCount)
+    auto initializeMeshFunction = [this, &mesh, cms, intent, reporter](std::vector<QPointF>&& vertices, std::vector<PDFColor>&& vertexColors, size_t triangleCount)
     {
+        // Vertex colors are converted all at once, so color management
+        // system can transform whole array instead of single colors.
         mesh.reserve(0, triangleCount);
+        mesh.setVertexColors(m_colorSpace->getRGBColors(vertexColors, cms, intent, reporter));
         mesh.setVertices(qMove(vertices));
     };
 
@@ -2478,8 +2808,9 @@ PDFShadingSampler* PDFLatticeFormGouradTriangleShading::createSampler(QTransform
         sampler->addTriangle({ via, vib, vic }, { va->color, vb->color, vc->color });
     };
 
-    auto initializeMeshFunction = [sampler](std::vector<QPointF>&& vertices, size_t triangleCount)
+    auto initializeMeshFunction = [sampler](std::vector<QPointF>&& vertices, std::vector<PDFColor>&& vertexColors, size_t triangleCount)
     {
+        Q_UNUSED(vertexColors);
         sampler->setVertexArray(qMove(vertices));
         sampler->reserveSpaceForTriangles(triangleCount);
     };
@@ -2533,6 +2864,8 @@ void PDFType4567Shading::addSubdividedTriangles(const PDFMeshQualitySettings& se
                                                 PDFColor c1, PDFColor c2, PDFColor c3,
                                                 const PDFCMS* cms, RenderingIntent intent, PDFRenderErrorReporter* reporter) const
 {
+    Q_ASSERT(mesh.hasVertexColors());
+
     // First, verify, if we can subdivide the triangle
     QLineF v12(mesh.getVertex(v1), mesh.getVertex(v2));
     QLineF v13(mesh.getVertex(v1), mesh.getVertex(v3));
@@ -2543,13 +2876,27 @@ void PDFType4567Shading::addSubdividedTriangles(const PDFMeshQualitySettings& se
     const qreal length23 = v23.length();
     const qreal maxLength = qMax(length12, qMax(length13, length23));
 
+    const bool canSubdivide = maxLength >= settings.minimalMeshResolution * 2.0; // If we subdivide, we will have length at least settings.minimalMeshResolution
+
+    auto getDeviceColor = [&](const PDFColor& color)
+    {
+        return m_colorSpace->getColor(color, cms, intent, reporter, true).rgb();
+    };
+
+    // Colors are interpolated linearly between the vertex colors (in device color space),
+    // so edge is subdivided only, if color space transformation is not linear enough.
+    auto isEdgeLinear = [&](uint32_t va, uint32_t vb, const PDFColor& ca, const PDFColor& cb)
+    {
+        const QRgb centerColor = getDeviceColor(PDFAbstractColorSpace::mixColors(ca, cb, 0.5));
+        return isInterpolatedColorEqual(mesh.getVertexColor(va), mesh.getVertexColor(vb), centerColor, settings.tolerance);
+    };
+
     const bool isColorEqual = PDFAbstractColorSpace::isColorEqual(c1, c2, settings.tolerance) &&
                               PDFAbstractColorSpace::isColorEqual(c1, c3, settings.tolerance) &&
                               PDFAbstractColorSpace::isColorEqual(c2, c3, settings.tolerance);
-    const bool canSubdivide = maxLength >= settings.minimalMeshResolution * 2.0; // If we subdivide, we will have length at least settings.minimalMeshResolution
-
+    const bool shouldSubdivide = canSubdivide && !isColorEqual && !(isEdgeLinear(v1, v2, c1, c2) && isEdgeLinear(v1, v3, c1, c3) && isEdgeLinear(v2, v3, c2, c3));
 
-    if (!isColorEqual && canSubdivide)
+    if (shouldSubdivide)
     {
         if (length23 == maxLength)
         {
@@ -2557,7 +2904,7 @@ void PDFType4567Shading::addSubdividedTriangles(const PDFMeshQualitySettings& se
             // vx is centerpoint of line (v2, v3). We also interpolate colors.
             QPointF x = v23.center();
             PDFColor cx = PDFAbstractColorSpace::mixColors(c2, c3, 0.5);
-            const uint32_t vx = mesh.addVertex(x);
+            const uint32_t vx = mesh.addVertex(x, getDeviceColor(cx));
 
             addSubdividedTriangles(settings, mesh, v1, v2, vx, c1, c2, cx, cms, intent, reporter);
             addSubdividedTriangles(settings, mesh, v1, v3, vx, c1, c3, cx, cms, intent, reporter);
@@ -2568,7 +2915,7 @@ void PDFType4567Shading::addSubdividedTriangles(const PDFMeshQualitySettings& se
             // vx is centerpoint of line (v1, v3). We also interpolate colors.
             QPointF x = v13.center();
             PDFColor cx = PDFAbstractColorSpace::mixColors(c1, c3, 0.5);
-            const uint32_t vx = mesh.addVertex(x);
+            const uint32_t vx = mesh.addVertex(x, getDeviceColor(cx));
 
             addSubdividedTriangles(settings, mesh, v1, v2, vx, c1, c2, cx, cms, intent, reporter);
             addSubdividedTriangles(settings, mesh, v2, v3, vx, c2, c3, cx, cms, intent, reporter);
@@ -2581,7 +2928,7 @@ void PDFType4567Shading::addSubdividedTriangles(const PDFMeshQualitySettings& se
             // vx is centerpoint of line (v1, v2). We also interpolate colors.
             QPointF x = v12.center();
             PDFColor cx = PDFAbstractColorSpace::mixColors(c1, c2, 0.5);
-            const uint32_t vx = mesh.addVertex(x);
+            const uint32_t vx = mesh.addVertex(x, getDeviceColor(cx));
 
             addSubdividedTriangles(settings, mesh, v1, v3, vx, c1, c3, cx, cms, intent, reporter);
             addSubdividedTriangles(settings, mesh, v2, v3, vx, c2, c3, cx, cms, intent, reporter);
@@ -2589,29 +2936,25 @@ void PDFType4567Shading::addSubdividedTriangles(const PDFMeshQualitySettings& se
     }
     else
     {
-        const size_t colorComponents = c1.size();
-
-        // Calculate color - interpolate 3 vertex colors
-        PDFColor color;
-        color.resize(colorComponents);
-
-        constexpr const PDFReal coefficient = 1.0 / 3.0;
-        for (size_t i = 0; i < colorComponents; ++i)
-        {
-            color[i] = (c1[i] + c2[i] + c3[i]) * coefficient;
-        }
-        Q_ASSERT(colorComponents == m_colorSpace->getColorComponentCount());
-        QColor transformedColor = m_colorSpace->getColor(color, cms, intent, reporter, true);
-
         PDFMesh::Triangle triangle;
         triangle.v1 = v1;
         triangle.v2 = v2;
         triangle.v3 = v3;
-        triangle.color = transformedColor.rgb();
+        triangle.color = mesh.getTriangleCenterColor(triangle);
         mesh.addTriangle(triangle);
     }
 }
 
+bool PDFType4567Shading::isInterpolatedColorEqual(QRgb color1, QRgb color2, QRgb centerColor, PDFReal tolerance)
+{
+    const int rgbTolerance = static_cast<int>(std::ceil(tolerance * 255.0));
+    const QRgb interpolatedColor = PDFMesh::mixColors(color1, color2, 0.5);
+
+    return qAbs(qRed(centerColor) - qRed(interpolatedColor)) <= rgbTolerance &&
+           qAbs(qGreen(centerColor) - qGreen(interpolatedColor)) <= rgbTolerance &&
+           qAbs(qBlue(centerColor) - qBlue(interpolatedColor)) <= rgbTolerance;
+}
+
 QPointF PDFTensorPatch::getValue(PDFReal u, PDFReal v) const
 {
     return getValue(u, v, 0, 0);
@@ -3323,6 +3666,11 @@ void PDFTensorProductPatchShadingBase::fillMesh(PDFMesh& mesh,
         return interpolated;
     };
 
+    auto getDeviceColor = [&](const PDFColor& color)
+    {
+        return m_colorSpace->getColor(color, cms, intent, reporter, true).rgb();
+    };
+
     Triangle workStartA;
     workStartA.uvCoordinates = { QPointF(0.0, 0.0), QPointF(1.0, 0.0), QPointF(0.0, 1.0) };
     workStartA.fillTriangleDevicePoints(patch);
@@ -3348,7 +3696,7 @@ void PDFTensorProductPatchShadingBase::fillMesh(PDFMesh& mesh,
         // Should we divide the triangle? These conditions should be verified:
         //  1) Largest edge of triangle in device space exceeds preferred size of mesh
         //  2) Curvature of the triangle is too high (and largest edge doesn't exceed minimal size of mesh)
-        //  3) Color difference is too high (and largest edge doesn't exceed minimal size of mesh)
+        //  3) Colors can't be linearly interpolated across the triangle (and largest edge doesn't exceed minimal size of mesh)
 
         // First, verify, if we can subdivide the triangle
         QLineF deviceLine01(triangle.devicePoints[0], triangle.devicePoints[1]);
@@ -3388,7 +3736,39 @@ void PDFTensorProductPatchShadingBase::fillMesh(PDFMesh& mesh,
         const bool canSubdivide = maxLength >= settings.minimalMeshResolution * 2.0; // If we subdivide, we will have length at least settings.minimalMeshResolution
         const bool shouldSubdivide = maxLength >= targetLength;
 
-        if ((!isColorEqual || shouldSubdivide) && canSubdivide)
+        // Colors are interpolated linearly across the triangle (in device color space), so
+        // we must check, that bilinear interpolation of patch colors and color space transformation
+        // are close to linear interpolation - we check colors in the centers of the edges.
+        auto isColorLinear = [&]()
+        {
+            if (isColorEqual)
+            {
+                return true;
+            }
+
+            const std::array<const PDFColor*, 3> colors = { &c0, &c1, &c2 };
+            std::array<QRgb, 3> deviceColors = { };
+            for (size_t i = 0; i < deviceColors.size(); ++i)
+            {
+                deviceColors[i] = getDeviceColor(*colors[i]);
+            }
+
+            for (size_t i = 0; i < deviceColors.size(); ++i)
+            {
+                const size_t j = (i + 1) % deviceColors.size();
+                const QPointF uvCenter = (triangle.uvCoordinates[i] + triangle.uvCoordinates[j]) * 0.5;
+                const QRgb centerColor = getDeviceColor(getColorForUV(uvCenter.x(), uvCenter.y()));
+
+                if (!isInterpolatedColorEqual(deviceColors[i], deviceColors[j], centerColor, settings.tolerance))
+                {
+                    return false;
+                }
+            }
+
+            return true;
+        };
+
+        if (canSubdivide && (shouldSubdivide || !isColorLinear()))
         {
             QPointF v0 = triangle.uvCoordinates[0];
             QPointF v1 = triangle.uvCoordinates[1];
@@ -3425,31 +3805,35 @@ void PDFTensorProductPatchShadingBase::fillMesh(PDFMesh& mesh,
     PDFExecutionPolicy::sort(PDFExecutionPolicy::Scope::Content, finishedTriangles.begin(), finishedTriangles.end(), comparator);
 
     std::vector<QPointF> vertices;
+    std::vector<QRgb> vertexColors;
     std::vector<PDFMesh::Triangle> triangles;
 
     vertices.reserve(finishedTriangles.size() * 3);
+    vertexColors.reserve(finishedTriangles.size() * 3);
     triangles.reserve(finishedTriangles.size());
 
     size_t vertexIndex = 0;
     for (const Triangle& triangle : finishedTriangles)
     {
-        vertices.push_back(triangle.devicePoints[0]);
-        vertices.push_back(triangle.devicePoints[1]);
-        vertices.push_back(triangle.devicePoints[2]);
+        for (size_t i = 0; i < triangle.devicePoints.size(); ++i)
+        {
+            const QPointF& uv = triangle.uvCoordinates[i];
+            vertices.push_back(triangle.devicePoints[i]);
+            vertexColors.push_back(getDeviceColor(getColorForUV(uv.x(), uv.y())));
+        }
 
         QPointF center = triangle.getCenter();
         PDFColor color = getColorForUV(center.x(), center.y());
-        QRgb rgbColor = m_colorSpace->getColor(color, cms, intent, reporter, true).rgb();
 
         PDFMesh::Triangle meshTriangle;
         meshTriangle.v1 = static_cast<uint32_t>(vertexIndex++);
         meshTriangle.v2 = static_cast<uint32_t>(vertexIndex++);
         meshTriangle.v3 = static_cast<uint32_t>(vertexIndex++);
-        meshTriangle.color = rgbColor;
+        meshTriangle.color = getDeviceColor(color);
         triangles.push_back(meshTriangle);
     }
 
-    mesh.addMesh(qMove(vertices), qMove(triangles));
+    mesh.addMesh(qMove(vertices), qMove(vertexColors), qMove(triangles));
 }
 
 void PDFTensorProductPatchShadingBase::fillMesh(PDFMesh& mesh,
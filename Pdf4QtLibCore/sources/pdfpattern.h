@@ -24,6 +24,7 @@
 #include "pdfmeshqualitysettings.h"
 #include "pdfcolorconvertor.h"
 
+#include <QImage>
 #include <QTransform>
 #include <QPainterPath>
 
@@ -76,6 +77,15 @@ public:
     /// \returns Index of the added vertex
     inline uint32_t addVertex(const QPointF& vertex) { const size_t index = m_vertices.size(); m_vertices.emplace_back(vertex); return static_cast<uint32_t>(index); }
 
+    /// Adds vertex with color. Returns index of added vertex. Mesh, whose vertices
+    /// have colors, is painted with colors interpolated across the triangles from
+    /// the colors of their vertices (Gouraud shading), otherwise each triangle is painted
+    /// with its own color. Either all vertices of the mesh have color, or none of them.
+    /// \param vertex Vertex to be added
+    /// \param color Color of the vertex
+    /// \returns Index of the added vertex
+    inline uint32_t addVertex(const QPointF& vertex, QRgb color) { m_vertexColors.emplace_back(color); return addVertex(vertex); }
+
     /// Adds triangle. Returns index of added triangle.
     /// \param triangle Triangle to be added
     /// \returns Index of the added vertex
@@ -111,6 +121,16 @@ public:
     /// \param vertices New vertex array
     void setVertices(std::vector<QPointF>&& vertices) { m_vertices = qMove(vertices); }
 
+    /// Sets the vertex color array to the mesh. Array must be either empty,
+    /// or it must have the same size as the vertex array.
+    /// \param vertexColors New vertex color array
+    void setVertexColors(std::vector<QRgb>&& vertexColors) { m_vertexColors = qMove(vertexColors); }
+
+    /// Sets the color of the vertex at given index
+    /// \param index Index of the vertex
+    /// \param color Color of the vertex
+    void setVertexColor(size_t index, QRgb color) { m_vertexColors[index] = color; }
+
     /// Sets the triangle array to the mesh
     /// \param triangles New triangle array
     void setTriangles(std::vector<Triangle>&& triangles) { m_triangles = qMove(triangles); }
@@ -121,10 +141,36 @@ public:
     /// \param triangles Added triangle array
     void addMesh(std::vector<QPointF>&& vertices, std::vector<Triangle>&& triangles);
 
+    /// Merges the vertices with colors/triangles (renumbers triangle indices) to this mesh.
+    /// Algorithm assumes that vertices/triangles are numbered from zero.
+    /// \param vertices Added vertex array
+    /// \param vertexColors Added vertex color array (must be empty or have the same size as vertex array)
+    /// \param triangles Added triangle array
+    void addMesh(std::vector<QPointF>&& vertices, std::vector<QRgb>&& vertexColors, std::vector<Triangle>&& triangles);
+
     /// Returns vertex at given index
     /// \param index Index of the vertex
     const QPointF& getVertex(size_t index) const { return m_vertices[index]; }
 
+    /// Returns color of the vertex at given index. Mesh must have vertex colors.
+    /// \param index Index of the vertex
+    QRgb getVertexColor(size_t index) const { return m_vertexColors[index]; }
+
+    /// Returns true, if vertices of the mesh have colors, which are
+    /// interpolated across the triangles when mesh is painted.
+    bool hasVertexColors() const { return !m_vertexColors.empty(); }
+
+    /// Returns color of the triangle center interpolated from the vertex
+    /// colors. Mesh must have vertex colors.
+    /// \param triangle Triangle
+    QRgb getTriangleCenterColor(const Triangle& triangle) const;
+
+    /// Mixes two colors, ratio 0.0 returns first color, ratio 1.0 returns second color
+    /// \param color1 First color
+    /// \param color2 Second color
+    /// \param ratio Mixing ratio
+    static QRgb mixColors(QRgb color1, QRgb color2, PDFReal ratio);
+
     /// Returns triangle center. Triangles vertice indices must be valid.
     /// \param triangle Triangle
     QPointF getTriangleCenter(const Triangle& triangle) const;
@@ -145,11 +191,28 @@ public:
     /// Returns estimate of number of bytes, which this mesh occupies in memory
     qint64 getMemoryConsumptionEstimate() const;
 
+    /// Returns bounding rectangle of the painted area of the mesh (without
+    /// the pen width). If mesh paints nothing, empty rectangle is returned.
+    QRectF getBoundingRect() const;
+
     /// Apply color conversion
     void convertColors(const PDFColorConvertor& colorConvertor);
 
 private:
+    /// Paints triangles with colors interpolated from the vertex colors. Triangles
+    /// are rasterized in device space pixels, edges of the mesh are antialiased.
+    /// \param painter Painter, onto which is mesh drawn
+    /// \param alpha Opacity factor
+    void paintInterpolatedTriangles(QPainter* painter, PDFReal alpha) const;
+
+    /// Rasterizes triangles with interpolated colors into the image
+    /// \param deviceVertices Vertices mapped to the device space
+    /// \param rect Rasterized area in device space pixels
+    /// \param alpha Opacity factor
+    QImage rasterizeInterpolatedTriangles(const std::vector<QPointF>& deviceVertices, QRect rect, PDFReal alpha) const;
+
     std::vector<QPointF> m_vertices;
+    std::vector<QRgb> m_vertexColors;
     std::vector<Triangle> m_triangles;
     QPainterPath m_boundingPath;
     QPainterPath m_backgroundPath;
@@ -182,12 +245,14 @@ public:
     /// \param cms Color management system
     /// \param intent Rendering intent
     /// \param reporter Error reporter
+    /// \param approximateFunctions Replace PostScript shading functions by sampled approximations
     static PDFPatternPtr createPattern(const PDFDictionary* colorSpaceDictionary,
                                        const PDFDocument* document,
                                        const PDFObject& object,
                                        const PDFCMS* cms,
                                        RenderingIntent intent,
-                                       PDFRenderErrorReporter* reporter);
+                                       PDFRenderErrorReporter* reporter,
+                                       bool approximateFunctions);
 
     /// Create shading pattern from the object. If error occurs, exception is thrown
     /// \param colorSpaceDictionary Color space dictionary
@@ -199,6 +264,7 @@ public:
     /// \param intent Rendering intent
     /// \param reporter Error reporter
     /// \param ignoreBackgroundColor If set, then ignores background color, even if it is present
+    /// \param approximateFunctions Replace PostScript shading functions by sampled approximations
     static PDFPatternPtr createShadingPattern(const PDFDictionary* colorSpaceDictionary,
                                               const PDFDocument* document,
                                               const PDFObject& shadingObject,
@@ -207,7 +273,8 @@ public:
                                               const PDFCMS* cms,
                                               RenderingIntent intent,
                                               PDFRenderErrorReporter* reporter,
-                                              bool ignoreBackgroundColor);
+                                              bool ignoreBackgroundColor,
+                                              bool approximateFunctions);
 
 protected:
     QRectF m_boundingBox;
@@ -255,6 +322,10 @@ public:
     const PDFObject& getResources() const { return m_resources; }
     const QByteArray& getContent() const { return m_content; }
 
+    /// Returns pattern stream object, so translated content stream
+    /// can be cached (null object, if pattern is not a stream)
+    const PDFObject& getContentStream() const { return m_contentStream; }
+
 private:
     friend class PDFPattern;
 
@@ -264,6 +335,7 @@ private:
     PDFReal m_yStep = 0.0;
     PDFObject m_resources;
     QByteArray m_content;
+    PDFObject m_contentStream;
 };
 
 /// Compute color of sample points from shading pattern. Some sampler implementation
@@ -376,6 +448,26 @@ public:
 protected:
     friend class PDFPattern;
 
+    using ColoredCoordinates = std::vector<std::pair<PDFReal, PDFColor>>;
+
+    /// Selects mesh vertex coordinates from the colored coordinates on the shading
+    /// axis (sorted by coordinate). Colors are interpolated linearly between
+    /// the vertices, so coordinate is omitted, if colors of all omitted coordinates
+    /// can be interpolated from the selected coordinates within the tolerance.
+    /// Start and end of the shading axis are always selected.
+    /// \param coloredCoordinates Colored coordinates
+    /// \param xStart Start of the shading axis
+    /// \param xEnd End of the shading axis
+    /// \param tolerance Color tolerance
+    static ColoredCoordinates selectMeshCoordinates(const ColoredCoordinates& coloredCoordinates, PDFReal xStart, PDFReal xEnd, PDFReal tolerance);
+
+    /// Converts colors of the colored coordinates to the device colors (all at once)
+    /// \param coloredCoordinates Colored coordinates
+    /// \param cms Color management system
+    /// \param intent Rendering intent
+    /// \param reporter Error reporter
+    std::vector<QRgb> getDeviceColors(const ColoredCoordinates& coloredCoordinates, const PDFCMS* cms, RenderingIntent intent, PDFRenderErrorReporter* reporter) const;
+
     std::vector<PDFFunctionPtr> m_functions;
     QPointF m_startPoint;
     QPointF m_endPoint;
@@ -473,6 +565,14 @@ protected:
                                 RenderingIntent intent,
                                 PDFRenderErrorReporter* reporter) const;
 
+    /// Returns true, if color in the center of the edge is equal (within the tolerance)
+    /// to the color linearly interpolated from the colors of the edge end points.
+    /// \param color1 Color of the first end point
+    /// \param color2 Color of the second end point
+    /// \param centerColor Color in the center of the edge
+    /// \param tolerance Color tolerance
+    static bool isInterpolatedColorEqual(QRgb color1, QRgb color2, QRgb centerColor, PDFReal tolerance);
+
     uint8_t m_bitsPerCoordinate = 0;
     uint8_t m_bitsPerComponent = 0;
     uint8_t m_bitsPerFlag = 0;
@@ -515,7 +615,7 @@ private:
 
     friend class PDFPattern;
 
-    using InitializeFunction = std::function<void(std::vector<QPointF>&&, size_t)>;
+    using InitializeFunction = std::function<void(std::vector<QPointF>&&, std::vector<PDFColor>&&, size_t)>;
     using AddTriangleFunction = std::function<void(const VertexData*, const VertexData*, const VertexData*)>;
 
     bool processTriangles(InitializeFunction initializeMeshFunction,
@@ -547,7 +647,7 @@ private:
         PDFColor color;
     };
 
-    using InitializeFunction = std::function<void(std::vector<QPointF>&&, size_t)>;
+    using InitializeFunction = std::function<void(std::vector<QPointF>&&, std::vector<PDFColor>&&, size_t)>;
     using AddTriangleFunction = std::function<void(const VertexData*, const VertexData*, const VertexData*)>;
 
     bool processTriangles(InitializeFunction initializeMeshFunction,
@@ -0,0 +1,234 @@
+//    Copyright (C) 2024 Jakub Melka
+//
+//    This file is part of PDF4QT.
+//
+//    PDF4QT is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    with the written consent of the copyright owner, any later version.
+//
+//    PDF4QT is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public License
+//    along with PDF4QT.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "pdfpngstreamwriter.h"
+
+#include <QIODevice>
+#include <QtEndian>
+
+#include <zlib.h>
+
+#include "pdfdbgheap.h"
+
+namespace pdf
+{
+
+/// Size of the compressed data in one IDAT chunk
+static constexpr int PNG_IDAT_CHUNK_SIZE = 64 * 1024;
+
+struct PDFPNGStreamWriter::Compressor
+{
+    z_stream stream = { };
+    bool isInitialized = false;
+    QByteArray buffer;
+};
+
+PDFPNGStreamWriter::PDFPNGStreamWriter(QIODevice* device) :
+    m_device(device)
+{
+
+}
+
+PDFPNGStreamWriter::~PDFPNGStreamWriter()
+{
+    if (m_compressor && m_compressor->isInitialized)
+    {
+        deflateEnd(&m_compressor->stream);
+    }
+}
+
+bool PDFPNGStreamWriter::begin(QSize size, int dotsPerMeterX, int dotsPerMeterY, int compressionLevel)
+{
+    if (m_compressor)
+    {
+        return setError(PDFTranslationContext::tr("PNG image has already been started."));
+    }
+
+    if (size.isEmpty())
+    {
+        return setError(PDFTranslationContext::tr("Invalid PNG image size."));
+    }
+
+    m_size = size;
+    m_rowsWritten = 0;
+    m_compressor = std::make_unique<Compressor>();
+    m_compressor->buffer.resize(PNG_IDAT_CHUNK_SIZE);
+
+    if (deflateInit(&m_compressor->stream, qBound(-1, compressionLevel, 9)) != Z_OK)
+    {
+        return setError(PDFTranslationContext::tr("Can't initialize PNG compression."));
+    }
+    m_compressor->isInitialized = true;
+
+    static constexpr const char PNG_SIGNATURE[] = "\x89PNG\r\n\x1A\n";
+    if (m_device->write(PNG_SIGNATURE, 8) != 8)
+    {
+        return setError(m_device->errorString());
+    }
+
+    // Header - 8 bit RGBA image, deflate compression, no interlacing
+    QByteArray header(13, 0);
+    qToBigEndian<quint32>(size.width(), header.data());
+    qToBigEndian<quint32>(size.height(), header.data() + 4);
+    header[8] = 8;
+    header[9] = 6;
+
+    if (!writeChunk("IHDR", header))
+    {
+        return false;
+    }
+
+    if (dotsPerMeterX > 0 && dotsPerMeterY > 0)
+    {
+        QByteArray physicalDimensions(9, 0);
+        qToBigEndian<quint32>(dotsPerMeterX, physicalDimensions.data());
+        qToBigEndian<quint32>(dotsPerMeterY, physicalDimensions.data() + 4);
+        physicalDimensions[8] = 1;
+
+        if (!writeChunk("pHYs", physicalDimensions))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool PDFPNGStreamWriter::writeRows(const QImage& image)
+{
+    if (!m_compressor || !m_compressor->isInitialized)
+    {
+        return setError(PDFTranslationContext::tr("PNG image has not been started."));
+    }
+
+    if (image.width() != m_size.width() || m_rowsWritten + image.height() > m_size.height())
+    {
+        return setError(PDFTranslationContext::tr("Invalid size of PNG image rows."));
+    }
+
+    // PNG stores non-premultiplied RGBA samples
+    const QImage rgbaImage = image.convertToFormat(QImage::Format_RGBA8888);
+    const size_t rowSize = size_t(rgbaImage.width()) * 4;
+
+    for (int y = 0; y < rgbaImage.height(); ++y)
+    {
+        // Filter type None
+        const uchar filterType = 0;
+        if (!compress(&filterType, 1, false) || !compress(rgbaImage.constScanLine(y), rowSize, false))
+        {
+            return false;
+        }
+    }
+
+    m_rowsWritten += rgbaImage.height();
+    return true;
+}
+
+bool PDFPNGStreamWriter::end()
+{
+    if (!m_compressor || !m_compressor->isInitialized)
+    {
+        return setError(PDFTranslationContext::tr("PNG image has not been started."));
+    }
+
+    if (m_rowsWritten != m_size.height())
+    {
+        return setError(PDFTranslationContext::tr("Not all rows of PNG image were written."));
+    }
+
+    if (!compress(nullptr, 0, true))
+    {
+        return false;
+    }
+
+    deflateEnd(&m_compressor->stream);
+    m_compressor->isInitialized = false;
+
+    return writeChunk("IEND", QByteArray());
+}
+
+bool PDFPNGStreamWriter::compress(const uchar* data, size_t size, bool finish)
+{
+    z_stream& stream = m_compressor->stream;
+    QByteArray& buffer = m_compressor->buffer;
+
+    stream.next_in = const_cast<Bytef*>(data);
+    stream.avail_in = static_cast<uInt>(size);
+
+    while (true)
+    {
+        if (stream.avail_out == 0)
+        {
+            stream.next_out = reinterpret_cast<Bytef*>(buffer.data());
+            stream.avail_out = static_cast<uInt>(buffer.size());
+        }
+
+        const int error = deflate(&stream, finish ? Z_FINISH : Z_NO_FLUSH);
+        if (error != Z_OK && error != Z_STREAM_END && error != Z_BUF_ERROR)
+        {
+            return setError(PDFTranslationContext::tr("PNG compression failed (zlib code: %1).").arg(error));
+        }
+
+        // Write full buffer, or remaining data, when stream is finished
+        const bool isStreamEnd = (error == Z_STREAM_END);
+        const int compressedSize = buffer.size() - static_cast<int>(stream.avail_out);
+        if (stream.avail_out == 0 || (isStreamEnd && compressedSize > 0))
+        {
+            if (!writeChunk("IDAT", buffer.left(compressedSize)))
+            {
+                return false;
+            }
+            stream.avail_out = 0;
+        }
+
+        if (isStreamEnd || (!finish && stream.avail_in == 0 && stream.avail_out > 0))
+        {
+            break;
+        }
+    }
+
+    return true;
+}
+
+bool PDFPNGStreamWriter::writeChunk(const char* type, const QByteArray& data)
+{
+    QByteArray chunk(8, 0);
+    qToBigEndian<quint32>(data.size(), chunk.data());
+    chunk.replace(4, 4, type, 4);
+    chunk.append(data);
+
+    // CRC is computed from chunk type and chunk data
+    const uLong crc = crc32(crc32(0, Z_NULL, 0), reinterpret_cast<const Bytef*>(chunk.constData() + 4), static_cast<uInt>(chunk.size() - 4));
+    QByteArray crcData(4, 0);
+    qToBigEndian<quint32>(static_cast<quint32>(crc), crcData.data());
+    chunk.append(crcData);
+
+    if (m_device->write(chunk) != chunk.size())
+    {
+        return setError(m_device->errorString());
+    }
+
+    return true;
+}
+
+bool PDFPNGStreamWriter::setError(QString errorString)
+{
+    m_errorString = qMove(errorString);
+    return false;
+}
+
+}   // namespace pdf
@@ -0,0 +1,91 @@
+//    Copyright (C) 2024 Jakub Melka
+//
+//    This file is part of PDF4QT.
+//
+//    PDF4QT is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    with the written consent of the copyright owner, any later version.
+//
+//    PDF4QT is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public License
+//    along with PDF4QT.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef PDFPNGSTREAMWRITER_H
+#define PDFPNGSTREAMWRITER_H
+
+#include "pdfglobal.h"
+
+#include <QSize>
+#include <QImage>
+#include <QString>
+#include <QByteArray>
+
+#include <memory>
+
+class QIODevice;
+
+namespace pdf
+{
+
+/// Writes PNG image to the device row by row, so whole image need not
+/// to be in the memory (for example, when page is rendered in bands).
+/// Image is written as 8-bit RGBA image without filtering of the rows.
+/// Usage: call \p begin, then \p writeRows until all rows are written,
+/// and then call \p end.
+class PDF4QTLIBCORESHARED_EXPORT PDFPNGStreamWriter
+{
+public:
+    /// Constructs writer. Device must be opened for writing.
+    /// \param device Target device
+    explicit PDFPNGStreamWriter(QIODevice* device);
+    ~PDFPNGStreamWriter();
+
+    /// Begins writing of the image, writes the header.
+    /// Returns false, if error occurs.
+    /// \param size Size of the image
+    /// \param dotsPerMeterX Horizontal resolution (ignored, if zero)
+    /// \param dotsPerMeterY Vertical resolution (ignored, if zero)
+    /// \param compressionLevel Compression level (0-9, -1 means default compression)
+    bool begin(QSize size, int dotsPerMeterX, int dotsPerMeterY, int compressionLevel);
+
+    /// Writes next rows of the image. Width of the \p image must
+    /// be the same as width of the written image. Returns false,
+    /// if error occurs.
+    /// \param image Image containing next rows
+    bool writeRows(const QImage& image);
+
+    /// Finishes writing of the image. Returns false, if error
+    /// occurs, or not all rows of the image were written.
+    bool end();
+
+    /// Returns error string (if some error occured)
+    const QString& getErrorString() const { return m_errorString; }
+
+private:
+    struct Compressor;
+
+    /// Compresses data into IDAT chunks. If \p finish is true, then
+    /// compressed stream is finished and all remaining data are written.
+    bool compress(const uchar* data, size_t size, bool finish);
+
+    /// Writes PNG chunk
+    bool writeChunk(const char* type, const QByteArray& data);
+
+    /// Sets error string and returns false
+    bool setError(QString errorString);
+
+    QIODevice* m_device;
+    QSize m_size;
+    int m_rowsWritten = 0;
+    QString m_errorString;
+    std::unique_ptr<Compressor> m_compressor;
+};
+
+}   // namespace pdf
+
+#endif // PDFPNGSTREAMWRITER_H
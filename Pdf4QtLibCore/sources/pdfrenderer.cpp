@@ -24,9 +24,14 @@
 #include "pdfblpainter.h"
 
 #include <QDir>
+#include <QThread>
 #include <QElapsedTimer>
+#include <QWaitCondition>
 #include <QtMath>
 
+#include <deque>
+#include <atomic>
+
 #include "pdfdbgheap.h"
 
 namespace pdf
@@ -169,6 +174,8 @@ QList<PDFRenderError> PDFRenderer::render(QPainter* painter, const QRectF& recta
 
     PDFPainter processor(painter, m_features, matrix, page, m_document, m_fontCache, m_cms, m_optionalContentActivity, m_meshQualitySettings);
     processor.setOperationControl(m_operationControl);
+    processor.setImageCache(m_imageCache);
+    processor.setBytecodeCache(m_bytecodeCache);
     return processor.processContents();
 }
 
@@ -186,6 +193,8 @@ QList<PDFRenderError> PDFRenderer::render(QPainter* painter, const QTransform& m
 
     PDFPainter processor(painter, m_features, matrix, page, m_document, m_fontCache, m_cms, m_optionalContentActivity, m_meshQualitySettings);
     processor.setOperationControl(m_operationControl);
+    processor.setImageCache(m_imageCache);
+    processor.setBytecodeCache(m_bytecodeCache);
     return processor.processContents();
 }
 
@@ -207,8 +216,19 @@ void PDFRenderer::compile(PDFPrecompiledPage* precompiledPage, size_t pageIndex)
 
     PDFPrecompiledPageGenerator generator(precompiledPage, m_features, page, m_document, m_fontCache, m_cms, m_optionalContentActivity, m_meshQualitySettings);
     generator.setOperationControl(m_operationControl);
+    generator.setImageResolutionScale(m_imageResolutionScale);
+    generator.setImageCache(m_imageCache);
+    generator.setBytecodeCache(m_bytecodeCache);
+    precompiledPage->setImageResolutionScale(m_imageResolutionScale);
     QList<PDFRenderError> errors = generator.processContents();
 
+    // Objects of lazily loaded documents are parsed during rendering,
+    // so we report objects, which failed to load.
+    for (const QString& loadingError : m_document->getStorage().takeObjectLoadingErrors())
+    {
+        errors.push_back(PDFRenderError(RenderErrorType::Error, loadingError));
+    }
+
     PDFColorConvertor colorConvertor = m_cms->getColorConvertor();
     PDFRenderer::applyFeaturesToColorConvertor(m_features, colorConvertor);
     precompiledPage->convertColors(colorConvertor);
@@ -246,7 +266,65 @@ QImage PDFRasterizer::render(PDFInteger pageIndex,
     QImage image(size, QImage::Format_ARGB32_Premultiplied);
 
     QTransform matrix = PDFRenderer::createPagePointToDevicePointMatrix(page, QRect(QPoint(0, 0), size), extraRotation);
+    draw(image, matrix, pageIndex, page, compiledPage, features, annotationManager);
+    setImageResolution(image, page, size);
+
+    return image;
+}
+
+void PDFRasterizer::renderBands(PDFInteger pageIndex,
+                                const PDFPage* page,
+                                const PDFPrecompiledPage* compiledPage,
+                                QSize size,
+                                int bandHeight,
+                                PDFRenderer::Features features,
+                                const PDFAnnotationManager* annotationManager,
+                                PageRotation extraRotation,
+                                const ProcessBandMethod& processBand)
+{
+    Q_ASSERT(processBand);
+
+    if (size.isEmpty())
+    {
+        return;
+    }
+
+    bandHeight = qBound(1, bandHeight, size.height());
+    const QTransform matrix = PDFRenderer::createPagePointToDevicePointMatrix(page, QRect(QPoint(0, 0), size), extraRotation);
 
+    // Band image is allocated only once, last band can be shorter
+    QImage bandImage(size.width(), bandHeight, QImage::Format_ARGB32_Premultiplied);
+    setImageResolution(bandImage, page, size);
+
+    for (int top = 0; top < size.height(); top += bandHeight)
+    {
+        const int height = qMin(bandHeight, size.height() - top);
+        if (height != bandImage.height())
+        {
+            bandImage = bandImage.copy(0, 0, size.width(), height);
+        }
+
+        // Page is drawn shifted, so band lies at the origin of the band image,
+        // everything outside the band is clipped.
+        QTransform bandMatrix = matrix;
+        bandMatrix *= QTransform::fromTranslate(0, -top);
+        draw(bandImage, bandMatrix, pageIndex, page, compiledPage, features, annotationManager);
+
+        if (!processBand(top, bandImage))
+        {
+            break;
+        }
+    }
+}
+
+void PDFRasterizer::draw(QImage& image,
+                         const QTransform& matrix,
+                         PDFInteger pageIndex,
+                         const PDFPage* page,
+                         const PDFPrecompiledPage* compiledPage,
+                         PDFRenderer::Features features,
+                         const PDFAnnotationManager* annotationManager)
+{
     if (m_rendererEngine == RendererEngine::Blend2D_MultiThread ||
         m_rendererEngine == RendererEngine::Blend2D_SingleThread)
     {
@@ -277,16 +355,17 @@ QImage PDFRasterizer::render(PDFInteger pageIndex,
             annotationManager->drawPage(&painter, pageIndex, compiledPage, textLayoutGetter, matrix, errors);
         }
     }
+}
 
+void PDFRasterizer::setImageResolution(QImage& image, const PDFPage* page, QSize size)
+{
     // Calculate image DPI
     QSizeF rotatedSizeInMeters = page->getRotatedMediaBoxMM().size() / 1000.0;
-    QSizeF rotatedSizeInPixels = image.size();
+    QSizeF rotatedSizeInPixels = size;
     qreal dpiX = rotatedSizeInPixels.width() / rotatedSizeInMeters.width();
     qreal dpiY = rotatedSizeInPixels.height() / rotatedSizeInMeters.height();
     image.setDotsPerMeterX(qCeil(dpiX));
     image.setDotsPerMeterY(qCeil(dpiY));
-
-    return image;
 }
 
 PDFRasterizer* PDFRasterizerPool::acquire()
@@ -311,6 +390,75 @@ void PDFRasterizerPool::release(pdf::PDFRasterizer* rasterizer)
     m_semaphore.release();
 }
 
+/// Bounded queue connecting stages of the rendering pipeline. Producer is blocked,
+/// when queue is full, so faster stage can't run ahead of the slower one (and hold
+/// compiled pages or images of all pages in memory). Consumer is blocked, when queue
+/// is empty, until some item is pushed, or queue is closed.
+template<typename T>
+class PDFRenderPipelineQueue
+{
+public:
+    explicit PDFRenderPipelineQueue(size_t capacity) :
+        m_capacity(qMax(capacity, size_t(1)))
+    {
+
+    }
+
+    /// Pushes item to the queue. If queue is full, waits,
+    /// until some item is popped from the queue.
+    /// \param item Item
+    void push(T&& item)
+    {
+        QMutexLocker lock(&m_mutex);
+        while (m_queue.size() >= m_capacity)
+        {
+            m_notFullCondition.wait(&m_mutex);
+        }
+
+        m_queue.push_back(std::move(item));
+        m_notEmptyCondition.wakeOne();
+    }
+
+    /// Pops item from the queue. If queue is empty, waits, until some
+    /// item is pushed. Returns false, if queue is closed and empty.
+    /// \param item Popped item
+    bool pop(T& item)
+    {
+        QMutexLocker lock(&m_mutex);
+        while (m_queue.empty() && !m_closed)
+        {
+            m_notEmptyCondition.wait(&m_mutex);
+        }
+
+        if (m_queue.empty())
+        {
+            return false;
+        }
+
+        item = std::move(m_queue.front());
+        m_queue.pop_front();
+        m_notFullCondition.wakeOne();
+        return true;
+    }
+
+    /// Closes the queue, no more items can be pushed. Waiting
+    /// consumers receive remaining items and then finish.
+    void close()
+    {
+        QMutexLocker lock(&m_mutex);
+        m_closed = true;
+        m_notEmptyCondition.wakeAll();
+    }
+
+private:
+    QMutex m_mutex;
+    QWaitCondition m_notEmptyCondition;
+    QWaitCondition m_notFullCondition;
+    std::deque<T> m_queue;
+    size_t m_capacity;
+    bool m_closed = false;
+};
+
 void PDFRasterizerPool::render(const std::vector<PDFInteger>& pageIndices,
                                const PDFRasterizerPool::PageImageSizeGetter& imageSizeGetter,
                                const PDFRasterizerPool::ProcessImageMethod& processImage,
@@ -336,39 +484,260 @@ void PDFRasterizerPool::render(const std::vector<PDFInteger>& pageIndices,
         info.text = PDFTranslationContext::tr("Rendering document into images.");
         progress->start(pageIndices.size(), qMove(info));
     }
-    auto processPage = [this, progress, &imageSizeGetter, &processImage](const PDFInteger pageIndex)
+
+    // Pages are rendered by the pipeline of three stages: compile, rasterize and
+    // encode (process image). Each stage has its own set of workers - pages are
+    // compiled by page scope threads of the execution policy, rasterized by one thread
+    // for each rasterizer and processed by encoder threads. Stages are connected by
+    // bounded queues, so slow encoding doesn't block rasterizers and vice versa.
+    struct CompiledPage
+    {
+        PDFInteger pageIndex = 0;
+        const PDFPage* page = nullptr;
+        QSize imageSize;
+        PDFPrecompiledPage precompiledPage;
+        PDFRenderedPageImage renderedPageImage;
+        QElapsedTimer totalPageTimer;
+        QElapsedTimer queueTimer;
+    };
+
+    std::atomic<qint64> compileStageTime = 0;
+    std::atomic<qint64> rasterizeStageTime = 0;
+    std::atomic<qint64> encodeStageTime = 0;
+
+    auto compilePage = [&, this](const PDFInteger pageIndex, CompiledPage& compiledPage) -> bool
     {
-        const PDFPage* page = m_document->getCatalog()->getPage(pageIndex);
+        compiledPage.totalPageTimer.start();
 
-        if (!page)
+        QElapsedTimer pageTimer;
+        pageTimer.start();
+
+        compiledPage.pageIndex = pageIndex;
+        if (!compile(pageIndex, imageSizeGetter, compiledPage.page, compiledPage.imageSize, compiledPage.precompiledPage))
         {
             if (progress)
             {
                 progress->step();
             }
-            Q_EMIT renderError(pageIndex, PDFRenderError(RenderErrorType::Error, PDFTranslationContext::tr("Page %1 not found.").arg(pageIndex)));
-            return;
+            return false;
         }
 
+        compiledPage.renderedPageImage.pageCompileTime = pageTimer.elapsed();
+        compileStageTime += compiledPage.renderedPageImage.pageCompileTime;
+        return true;
+    };
+
+    auto rasterizePage = [&, this](CompiledPage& compiledPage, PDFRasterizer* rasterizer)
+    {
+        QElapsedTimer pageTimer;
+        pageTimer.start();
+
+        // We can const-cast here, because we do not modify the document in annotation manager.
+        // Annotations are just rendered to the target picture.
+        PDFModifiedDocument modifiedDocument(const_cast<PDFDocument*>(m_document), const_cast<PDFOptionalContentActivity*>(m_optionalContentActivity));
+
+        // Annotation manager
+        PDFAnnotationManager annotationManager(m_fontCache, m_cmsManager, m_optionalContentActivity, m_meshQualitySettings, m_features, PDFAnnotationManager::Target::Print, nullptr);
+        annotationManager.setDocument(modifiedDocument);
+
+        // Render page to image
+        QImage image = rasterizer->render(compiledPage.pageIndex, compiledPage.page, &compiledPage.precompiledPage, compiledPage.imageSize, m_features, &annotationManager, PageRotation::None);
+
+        PDFRenderedPageImage& renderedPageImage = compiledPage.renderedPageImage;
+        renderedPageImage.pageIndex = compiledPage.pageIndex;
+        renderedPageImage.pageImage = qMove(image);
+        renderedPageImage.pageRenderTime = pageTimer.elapsed();
+        rasterizeStageTime += renderedPageImage.pageRenderTime;
+
+        // Compiled page is no longer needed
+        compiledPage.precompiledPage = PDFPrecompiledPage();
+    };
+
+    auto encodePage = [&](CompiledPage& compiledPage)
+    {
+        QElapsedTimer pageTimer;
+        pageTimer.start();
+
+        PDFRenderedPageImage& renderedPageImage = compiledPage.renderedPageImage;
+        renderedPageImage.pageTotalTime = compiledPage.totalPageTimer.elapsed();
+        processImage(renderedPageImage);
+
+        encodeStageTime += pageTimer.elapsed();
+
+        if (progress)
+        {
+            progress->step();
+        }
+    };
+
+    if (PDFExecutionPolicy::isParallelizing(PDFExecutionPolicy::Scope::Page))
+    {
+        const int rasterizerCount = static_cast<int>(m_rasterizers.size());
+        PDFRenderPipelineQueue<CompiledPage> compiledPages(rasterizerCount);
+        PDFRenderPipelineQueue<CompiledPage> renderedPages(m_encoderCount);
+
+        auto rasterizeStage = [&, this]()
+        {
+            PDFRasterizer* rasterizer = acquire();
+            CompiledPage compiledPage;
+            while (compiledPages.pop(compiledPage))
+            {
+                compiledPage.renderedPageImage.pageWaitTime = compiledPage.queueTimer.elapsed();
+                rasterizePage(compiledPage, rasterizer);
+                compiledPage.queueTimer.start();
+                renderedPages.push(qMove(compiledPage));
+            }
+            release(rasterizer);
+        };
+
+        auto encodeStage = [&]()
+        {
+            CompiledPage compiledPage;
+            while (renderedPages.pop(compiledPage))
+            {
+                compiledPage.renderedPageImage.pageEncodeWaitTime = compiledPage.queueTimer.elapsed();
+                encodePage(compiledPage);
+                compiledPage = CompiledPage();
+            }
+        };
+
+        std::vector<QThread*> rasterizeThreads;
+        std::vector<QThread*> encodeThreads;
+        for (int i = 0; i < rasterizerCount; ++i)
+        {
+            rasterizeThreads.push_back(QThread::create(rasterizeStage));
+            rasterizeThreads.back()->start();
+        }
+        for (int i = 0; i < m_encoderCount; ++i)
+        {
+            encodeThreads.push_back(QThread::create(encodeStage));
+            encodeThreads.back()->start();
+        }
+
+        auto compileStage = [&](const PDFInteger pageIndex)
+        {
+            CompiledPage compiledPage;
+            if (compilePage(pageIndex, compiledPage))
+            {
+                compiledPage.queueTimer.start();
+                compiledPages.push(qMove(compiledPage));
+            }
+        };
+
+        // Let the stages finish remaining pages
+        auto finishStages = [&]()
+        {
+            compiledPages.close();
+            for (QThread* thread : rasterizeThreads)
+            {
+                thread->wait();
+            }
+
+            renderedPages.close();
+            for (QThread* thread : encodeThreads)
+            {
+                thread->wait();
+            }
+
+            qDeleteAll(rasterizeThreads);
+            qDeleteAll(encodeThreads);
+        };
+
+        try
+        {
+            PDFExecutionPolicy::execute(PDFExecutionPolicy::Scope::Page, pageIndices.cbegin(), pageIndices.cend(), compileStage);
+        }
+        catch (...)
+        {
+            finishStages();
+            throw;
+        }
+
+        finishStages();
+    }
+    else
+    {
+        for (const PDFInteger pageIndex : pageIndices)
+        {
+            CompiledPage compiledPage;
+            if (compilePage(pageIndex, compiledPage))
+            {
+                QElapsedTimer waitTimer;
+                waitTimer.start();
+                PDFRasterizer* rasterizer = acquire();
+                compiledPage.renderedPageImage.pageWaitTime = waitTimer.elapsed();
+                rasterizePage(compiledPage, rasterizer);
+                release(rasterizer);
+                encodePage(compiledPage);
+            }
+        }
+    }
+
+    if (progress)
+    {
+        progress->finish();
+    }
+
+    Q_EMIT renderError(PDFCatalog::INVALID_PAGE_INDEX, PDFRenderError(RenderErrorType::Information, PDFTranslationContext::tr("Finished at %1...").arg(QTime::currentTime().toString(Qt::TextDate))));
+    Q_EMIT renderError(PDFCatalog::INVALID_PAGE_INDEX, PDFRenderError(RenderErrorType::Information, PDFTranslationContext::tr("%1 miliseconds elapsed to render %2 pages...").arg(timer.nsecsElapsed() / 1000000).arg(pageIndices.size())));
+    Q_EMIT renderError(PDFCatalog::INVALID_PAGE_INDEX, PDFRenderError(RenderErrorType::Information, PDFTranslationContext::tr("Stage times: compile %1 ms, rasterize %2 ms, encode %3 ms...").arg(compileStageTime.load()).arg(rasterizeStageTime.load()).arg(encodeStageTime.load())));
+}
+
+void PDFRasterizerPool::renderBands(const std::vector<PDFInteger>& pageIndices,
+                                    const PageImageSizeGetter& imageSizeGetter,
+                                    int bandHeight,
+                                    const ProcessBandMethod& processBand,
+                                    const ProcessImageMethod& processImage,
+                                    PDFProgress* progress)
+{
+    if (pageIndices.empty())
+    {
+        return;
+    }
+
+    Q_ASSERT(imageSizeGetter);
+    Q_ASSERT(processBand);
+    Q_ASSERT(processImage);
+
+    QElapsedTimer timer;
+    timer.start();
+
+    Q_EMIT renderError(PDFCatalog::INVALID_PAGE_INDEX, PDFRenderError(RenderErrorType::Information, PDFTranslationContext::tr("Start at %1...").arg(QTime::currentTime().toString(Qt::TextDate))));
+
+    if (progress)
+    {
+        ProgressStartupInfo info;
+        info.showDialog = true;
+        info.text = PDFTranslationContext::tr("Rendering document into images.");
+        progress->start(pageIndices.size(), qMove(info));
+    }
+
+    // Bands of one page are rendered and processed sequentially by one rasterizer,
+    // so only one band image per rasterizer is allocated. Pages are processed in parallel.
+    auto processPage = [&, this](const PDFInteger pageIndex)
+    {
         QElapsedTimer totalPageTimer;
         totalPageTimer.start();
 
         QElapsedTimer pageTimer;
         pageTimer.start();
 
-        // Precompile the page
+        const PDFPage* page = nullptr;
+        QSize imageSize;
         PDFPrecompiledPage precompiledPage;
-        PDFCMSPointer cms = m_cmsManager->getCurrentCMS();
-        PDFRenderer renderer(m_document, m_fontCache, cms.data(), m_optionalContentActivity, m_features, m_meshQualitySettings);
-        renderer.compile(&precompiledPage, pageIndex);
-
-        qint64 pageCompileTime = pageTimer.restart();
-
-        for (const PDFRenderError& error : precompiledPage.getErrors())
+        if (!compile(pageIndex, imageSizeGetter, page, imageSize, precompiledPage))
         {
-            Q_EMIT renderError(pageIndex, error);
+            if (progress)
+            {
+                progress->step();
+            }
+            return;
         }
 
+        PDFRenderedPageImage renderedPageImage;
+        renderedPageImage.pageIndex = pageIndex;
+        renderedPageImage.pageCompileTime = pageTimer.restart();
+
         // We can const-cast here, because we do not modify the document in annotation manager.
         // Annotations are just rendered to the target picture.
         PDFModifiedDocument modifiedDocument(const_cast<PDFDocument*>(m_document), const_cast<PDFOptionalContentActivity*>(m_optionalContentActivity));
@@ -377,21 +746,30 @@ void PDFRasterizerPool::render(const std::vector<PDFInteger>& pageIndices,
         PDFAnnotationManager annotationManager(m_fontCache, m_cmsManager, m_optionalContentActivity, m_meshQualitySettings, m_features, PDFAnnotationManager::Target::Print, nullptr);
         annotationManager.setDocument(modifiedDocument);
 
-        // Render page to image
-        pageTimer.restart();
         PDFRasterizer* rasterizer = acquire();
-        qint64 pageWaitTime = pageTimer.restart();
-        QImage image = rasterizer->render(pageIndex, page, &precompiledPage, imageSizeGetter(page), m_features, &annotationManager, PageRotation::None);
-        qint64 pageRenderTime = pageTimer.elapsed();
+        renderedPageImage.pageWaitTime = pageTimer.restart();
+
+        // Time spent in processing of the bands is not a render time
+        qint64 processBandTime = 0;
+        auto processPageBand = [&](int top, const QImage& bandImage)
+        {
+            QElapsedTimer processBandTimer;
+            processBandTimer.start();
+
+            PDFRenderedPageBand band;
+            band.pageIndex = pageIndex;
+            band.pageImageSize = imageSize;
+            band.top = top;
+            band.bandImage = bandImage;
+            const bool result = processBand(band);
+
+            processBandTime += processBandTimer.elapsed();
+            return result;
+        };
+        rasterizer->renderBands(pageIndex, page, &precompiledPage, imageSize, bandHeight, m_features, &annotationManager, PageRotation::None, processPageBand);
         release(rasterizer);
 
-        // Now, process the image
-        PDFRenderedPageImage renderedPageImage;
-        renderedPageImage.pageIndex = pageIndex;
-        renderedPageImage.pageImage = qMove(image);
-        renderedPageImage.pageCompileTime = pageCompileTime;
-        renderedPageImage.pageWaitTime = pageWaitTime;
-        renderedPageImage.pageRenderTime = pageRenderTime;
+        renderedPageImage.pageRenderTime = pageTimer.elapsed() - processBandTime;
         renderedPageImage.pageTotalTime = totalPageTimer.elapsed();
         processImage(renderedPageImage);
 
@@ -411,6 +789,45 @@ void PDFRasterizerPool::render(const std::vector<PDFInteger>& pageIndices,
     Q_EMIT renderError(PDFCatalog::INVALID_PAGE_INDEX, PDFRenderError(RenderErrorType::Information, PDFTranslationContext::tr("%1 miliseconds elapsed to render %2 pages...").arg(timer.nsecsElapsed() / 1000000).arg(pageIndices.size())));
 }
 
+bool PDFRasterizerPool::compile(PDFInteger pageIndex,
+                                const PageImageSizeGetter& imageSizeGetter,
+                                const PDFPage*& page,
+                                QSize& imageSize,
+                                PDFPrecompiledPage& precompiledPage)
+{
+    page = m_document->getCatalog()->getPage(pageIndex);
+
+    if (!page)
+    {
+        Q_EMIT renderError(pageIndex, PDFRenderError(RenderErrorType::Error, PDFTranslationContext::tr("Page %1 not found.").arg(pageIndex)));
+        return false;
+    }
+
+    // Precompile the page. Images need not to be decoded at higher resolution,
+    // than is the resolution of the target image.
+    imageSize = imageSizeGetter(page);
+    const QSizeF pageSize = page->getRotatedMediaBox().size();
+    PDFReal imageResolutionScale = 0.0;
+    if (imageSize.isValid() && !pageSize.isEmpty())
+    {
+        imageResolutionScale = qMax(imageSize.width() / pageSize.width(), imageSize.height() / pageSize.height());
+    }
+
+    PDFCMSPointer cms = m_cmsManager->getCurrentCMS();
+    PDFRenderer renderer(m_document, m_fontCache, cms.data(), m_optionalContentActivity, m_features, m_meshQualitySettings);
+    renderer.setImageResolutionScale(imageResolutionScale);
+    renderer.setImageCache(m_imageCache);
+    renderer.setBytecodeCache(m_bytecodeCache);
+    renderer.compile(&precompiledPage, pageIndex);
+
+    for (const PDFRenderError& error : precompiledPage.getErrors())
+    {
+        Q_EMIT renderError(pageIndex, error);
+    }
+
+    return true;
+}
+
 int PDFRasterizerPool::getDefaultRasterizerCount()
 {
     int hint = QThread::idealThreadCount() / 2;
@@ -422,6 +839,17 @@ int PDFRasterizerPool::getCorrectedRasterizerCount(int rasterizerCount)
     return qBound(1, rasterizerCount, 256);
 }
 
+int PDFRasterizerPool::getDefaultEncoderCount()
+{
+    int hint = QThread::idealThreadCount() / 4;
+    return getCorrectedRasterizerCount(hint);
+}
+
+void PDFRasterizerPool::setEncoderCount(int encoderCount)
+{
+    m_encoderCount = getCorrectedRasterizerCount(encoderCount);
+}
+
 PDFImageWriterSettings::PDFImageWriterSettings()
 {
     m_formats = QImageWriter::supportedImageFormats();
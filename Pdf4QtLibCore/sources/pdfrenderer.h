@@ -37,6 +37,8 @@ namespace pdf
 class PDFCMS;
 class PDFProgress;
 class PDFFontCache;
+class PDFImageCache;
+class PDFContentStreamBytecodeCache;
 class PDFCMSManager;
 class PDFPrecompiledPage;
 class PDFAnnotationManager;
@@ -67,6 +69,8 @@ public:
         ColorAdjust_HighContrast    = 0x2000,   ///< Convert colors to high constrast colors
         ColorAdjust_Bitonal         = 0x4000,   ///< Convert colors to bitonal (monochromatic)
         ColorAdjust_CustomColors    = 0x8000,   ///< Convert colors to custom color settings
+
+        GlyphCache                  = 0x10000,  ///< Draw antialiased text using cache of rasterized glyphs (axis-aligned text only)
     };
 
     Q_DECLARE_FLAGS(Features, Feature)
@@ -127,6 +131,35 @@ public:
     const PDFOperationControl* getOperationControl() const;
     void setOperationControl(const PDFOperationControl* newOperationControl);
 
+    /// Returns number of device pixels per page point, for which are images decoded
+    /// when page is being compiled. Zero means full resolution.
+    PDFReal getImageResolutionScale() const { return m_imageResolutionScale; }
+
+    /// Sets number of device pixels per page point, for which are images decoded
+    /// when page is being compiled. JPEG and JPEG 2000 images are then decoded
+    /// at reduced resolution, if they are small on the device. Compiled page remembers
+    /// this scale, so it can be recompiled, when it is drawn at higher scale.
+    /// Zero (default) means full resolution.
+    /// \param imageResolutionScale Device pixels per page point
+    void setImageResolutionScale(PDFReal imageResolutionScale) { m_imageResolutionScale = imageResolutionScale; }
+
+    /// Returns image cache (can be nullptr)
+    const PDFImageCache* getImageCache() const { return m_imageCache; }
+
+    /// Sets image cache, which is used to share decoded images between pages.
+    /// Image cache can be nullptr, in this case, images are always decoded.
+    /// \param imageCache Image cache
+    void setImageCache(const PDFImageCache* imageCache) { m_imageCache = imageCache; }
+
+    /// Returns bytecode cache (can be nullptr)
+    const PDFContentStreamBytecodeCache* getBytecodeCache() const { return m_bytecodeCache; }
+
+    /// Sets bytecode cache, which holds translated content streams, so they
+    /// are not parsed again, when page is compiled or rendered again.
+    /// Bytecode cache can be nullptr, in this case, content streams are always parsed.
+    /// \param bytecodeCache Bytecode cache
+    void setBytecodeCache(const PDFContentStreamBytecodeCache* bytecodeCache) { m_bytecodeCache = bytecodeCache; }
+
 private:
     const PDFDocument* m_document;
     const PDFFontCache* m_fontCache;
@@ -135,6 +168,9 @@ private:
     const PDFOperationControl* m_operationControl;
     Features m_features;
     PDFMeshQualitySettings m_meshQualitySettings;
+    PDFReal m_imageResolutionScale = 0.0;
+    const PDFImageCache* m_imageCache = nullptr;
+    const PDFContentStreamBytecodeCache* m_bytecodeCache = nullptr;
 };
 
 /// Renders PDF pages to bitmap images (QImage).
@@ -150,6 +186,11 @@ public:
     explicit PDFRasterizer(QObject* parent);
     virtual ~PDFRasterizer() override;
 
+    /// Processes rendered band of the page image. Band is given by top row
+    /// in the page image and band image. Returns false, if rendering
+    /// of the remaining bands should be cancelled.
+    using ProcessBandMethod = std::function<bool(int, const QImage&)>;
+
     /// Resets the renderer.
     /// \param rendererEngine Renderer engine type
     void reset(RendererEngine rendererEngine);
@@ -173,21 +214,68 @@ public:
                   const PDFAnnotationManager* annotationManager,
                   PageRotation extraRotation);
 
+    /// Renders page image of given size in horizontal bands. Only one band
+    /// image is allocated and it is handed to the \p processBand function,
+    /// after each band is rendered, so memory consumption doesn't depend
+    /// on the size of the page image. Page is rendered from the top
+    /// to the bottom, last band can be smaller than \p bandHeight.
+    /// Warning: this function is not thread safe, same as \p render.
+    /// \param pageIndex Page index
+    /// \param page Page
+    /// \param compiledPage Compiled page contents
+    /// \param size Size of the whole page image
+    /// \param bandHeight Height of the band in pixels
+    /// \param features Renderer features
+    /// \param annotationManager Annotation manager (can be nullptr)
+    /// \param extraRotation Extra page rotation
+    /// \param processBand Function, which processes rendered bands
+    void renderBands(PDFInteger pageIndex,
+                     const PDFPage* page,
+                     const PDFPrecompiledPage* compiledPage,
+                     QSize size,
+                     int bandHeight,
+                     PDFRenderer::Features features,
+                     const PDFAnnotationManager* annotationManager,
+                     PageRotation extraRotation,
+                     const ProcessBandMethod& processBand);
+
 private:
+    /// Draws page (and annotations) into the image using given page to device matrix
+    void draw(QImage& image,
+              const QTransform& matrix,
+              PDFInteger pageIndex,
+              const PDFPage* page,
+              const PDFPrecompiledPage* compiledPage,
+              PDFRenderer::Features features,
+              const PDFAnnotationManager* annotationManager);
+
+    /// Sets resolution of the image, so it corresponds to page image of given size
+    static void setImageResolution(QImage& image, const PDFPage* page, QSize size);
+
     RendererEngine m_rendererEngine;
 };
 
 /// Simple structure for storing rendered page images
 struct PDFRenderedPageImage
 {
-    qint64 pageCompileTime = 0;
-    qint64 pageWaitTime = 0;
-    qint64 pageRenderTime = 0;
-    qint64 pageTotalTime = 0;
+    qint64 pageCompileTime = 0;     ///< Time of page compilation [msec]
+    qint64 pageWaitTime = 0;        ///< Time, when compiled page waits for rasterizer [msec]
+    qint64 pageRenderTime = 0;      ///< Time of page rasterization [msec]
+    qint64 pageEncodeWaitTime = 0;  ///< Time, when rendered image waits for encoder [msec]
+    qint64 pageTotalTime = 0;       ///< Total time from start of compilation to image processing [msec]
     PDFInteger pageIndex;
     QImage pageImage;
 };
 
+/// Band of the rendered page image (used in banded rendering)
+struct PDFRenderedPageBand
+{
+    PDFInteger pageIndex = 0;
+    QSize pageImageSize;    ///< Size of the whole page image
+    int top = 0;            ///< Top row of the band in the page image
+    QImage bandImage;       ///< Band image, it has the same width as page image
+};
+
 /// Pool of page image renderers. It can use predefined number of renderers to
 /// render page images asynchronously. You can use this object in two ways -
 /// first one is as standard object pool, second one is to directly render
@@ -204,6 +292,7 @@ public:
 
     using PageImageSizeGetter = std::function<QSize(const PDFPage*)>;
     using ProcessImageMethod = std::function<void(PDFRenderedPageImage&)>;
+    using ProcessBandMethod = std::function<bool(const PDFRenderedPageBand&)>;
 
     /// Creates new rasterizer pool
     /// \param document Document
@@ -235,7 +324,11 @@ public:
 
     /// Renders pages asynchronously to images, using given page indices,
     /// function which returns rendered size and process image function,
-    /// which processes rendered images.
+    /// which processes rendered images. Pages are processed by pipeline
+    /// of compile, rasterize and encode stages, connected by bounded queues.
+    /// Pages are compiled by page scope threads, rasterized by one thread
+    /// per rasterizer and processed by encoder threads, so process image
+    /// function is called from multiple threads and must be thread safe.
     /// \param pageIndices Page indices for rendered pages
     /// \param imageSizeGetter Getter, which computes image size from page index
     /// \param processImage Method, which processes rendered page images
@@ -245,6 +338,26 @@ public:
                 const ProcessImageMethod& processImage,
                 PDFProgress* progress);
 
+    /// Renders pages asynchronously to images in horizontal bands, so memory
+    /// consumption doesn't depend on the resolution of page images. Bands
+    /// of one page are rendered by one rasterizer from the top to the bottom
+    /// and handed to \p processBand function, which can cancel the rendering
+    /// of the remaining bands by returning false. Pages are rendered in parallel,
+    /// so \p processBand must be thread safe. When all bands of the page
+    /// are processed, \p processImage is called with page timings and null image.
+    /// \param pageIndices Page indices for rendered pages
+    /// \param imageSizeGetter Getter, which computes image size from page index
+    /// \param bandHeight Height of the band in pixels
+    /// \param processBand Method, which processes rendered bands
+    /// \param processImage Method, which is called, when page is finished
+    /// \param progress Progress indicator
+    void renderBands(const std::vector<PDFInteger>& pageIndices,
+                     const PageImageSizeGetter& imageSizeGetter,
+                     int bandHeight,
+                     const ProcessBandMethod& processBand,
+                     const ProcessImageMethod& processImage,
+                     PDFProgress* progress);
+
     /// Returns default rasterizer count
     static int getDefaultRasterizerCount();
 
@@ -255,12 +368,48 @@ public:
     /// \returns Corrected number of rasterizers
     static int getCorrectedRasterizerCount(int rasterizerCount);
 
+    /// Returns default count of encoder threads, which process rendered images
+    static int getDefaultEncoderCount();
+
+    /// Returns count of encoder threads, which process rendered images
+    int getEncoderCount() const { return m_encoderCount; }
+
+    /// Sets count of encoder threads, which process rendered images
+    /// (for example, encode them and write them to the files).
+    /// \param encoderCount Encoder count
+    void setEncoderCount(int encoderCount);
+
+    /// Sets image cache, which is used to share decoded images between pages.
+    /// Image cache can be nullptr, in this case, images are always decoded.
+    /// \param imageCache Image cache
+    void setImageCache(const PDFImageCache* imageCache) { m_imageCache = imageCache; }
+
+    /// Sets bytecode cache, which holds translated content streams.
+    /// Bytecode cache can be nullptr, in this case, content streams are always parsed.
+    /// \param bytecodeCache Bytecode cache
+    void setBytecodeCache(const PDFContentStreamBytecodeCache* bytecodeCache) { m_bytecodeCache = bytecodeCache; }
+
 signals:
     void renderError(PDFInteger pageIndex, PDFRenderError error);
 
 private:
+    /// Compiles page for rendering into image of size given by \p imageSizeGetter.
+    /// Returns false, if page doesn't exist.
+    /// \param pageIndex Page index
+    /// \param imageSizeGetter Getter, which computes image size from page index
+    /// \param[out] page Page
+    /// \param[out] imageSize Size of the page image
+    /// \param[out] precompiledPage Compiled page
+    bool compile(PDFInteger pageIndex,
+                 const PageImageSizeGetter& imageSizeGetter,
+                 const PDFPage*& page,
+                 QSize& imageSize,
+                 PDFPrecompiledPage& precompiledPage);
+
     const PDFDocument* m_document;
     PDFFontCache* m_fontCache;
+    const PDFImageCache* m_imageCache = nullptr;
+    const PDFContentStreamBytecodeCache* m_bytecodeCache = nullptr;
     const PDFCMSManager* m_cmsManager;
     const PDFOptionalContentActivity* m_optionalContentActivity;
     PDFRenderer::Features m_features;
@@ -269,6 +418,7 @@ private:
     QSemaphore m_semaphore;
     QMutex m_mutex;
     std::vector<PDFRasterizer*> m_rasterizers;
+    int m_encoderCount = getDefaultEncoderCount();
 };
 
 /// Settings object for image writer
@@ -225,8 +225,23 @@ void PDFDecryptOrEncryptObjectVisitor::visitStream(const PDFStream* stream)
         switch (m_mode)
         {
             case pdf::PDFDecryptOrEncryptObjectVisitor::Mode::Decrypt:
+            {
+                // Stream content is decrypted when it is accessed for the first time. Decryptor
+                // holds the security handler, so it can outlive the document. Decrypted length
+                // is not known in advance (AES padding), writer uses length of the content.
+                QSharedPointer<const PDFSecurityHandler> securityHandler = m_securityHandler->sharedFromThis();
+                if (securityHandler)
+                {
+                    PDFObjectReference reference = m_reference;
+                    auto decryptor = [securityHandler, reference, scope](const QByteArray& data) { return securityHandler->decrypt(data, reference, scope); };
+                    m_objectStack.push_back(PDFObject::createStream(std::make_shared<PDFStream>(qMove(processedDictionary), QByteArray(*stream->getContent()), qMove(decryptor))));
+                    return;
+                }
+
                 processedData = m_securityHandler->decrypt(*stream->getContent(), m_reference, scope);
                 break;
+            }
+
             case pdf::PDFDecryptOrEncryptObjectVisitor::Mode::Encrypt:
                 processedData = m_securityHandler->encrypt(*stream->getContent(), m_reference, scope);
                 break;
@@ -814,32 +829,130 @@ QByteArrayList PDFSecurityHandler::parseRecipients(const PDFDictionary* dictiona
     return result;
 }
 
+std::vector<uint8_t> PDFStandardOrPublicSecurityHandler::ObjectEncryptionKeyCache::getKey(const QByteArray& fileEncryptionKey,
+                                                                                          PDFObjectReference reference,
+                                                                                          CryptFilterType filterType,
+                                                                                          int keyLength,
+                                                                                          const std::function<std::vector<uint8_t>(void)>& createKey)
+{
+    Entry& entry = m_entries[static_cast<size_t>(reference.objectNumber) % CACHE_SIZE];
+
+    {
+        QMutexLocker lock(&m_mutex);
+
+        // File encryption key can change, when handler is authenticated again
+        if (m_fileEncryptionKey != fileEncryptionKey)
+        {
+            m_fileEncryptionKey = fileEncryptionKey;
+            m_entries.fill(Entry());
+        }
+
+        if (!entry.key.empty() && entry.reference == reference && entry.filterType == filterType && entry.keyLength == keyLength)
+        {
+            return entry.key;
+        }
+    }
+
+    std::vector<uint8_t> key = createKey();
+
+    QMutexLocker lock(&m_mutex);
+    if (m_fileEncryptionKey == fileEncryptionKey)
+    {
+        entry.reference = reference;
+        entry.filterType = filterType;
+        entry.keyLength = keyLength;
+        entry.key = key;
+    }
+    return key;
+}
+
 std::vector<uint8_t> PDFStandardOrPublicSecurityHandler::createV2_ObjectEncryptionKey(PDFObjectReference reference, CryptFilter filter) const
 {
-    std::vector<uint8_t> inputKeyData = convertByteArrayToVector(m_authorizationData.fileEncryptionKey);
-    uint32_t objectNumber = qToLittleEndian(static_cast<uint32_t>(reference.objectNumber));
-    uint32_t generation = qToLittleEndian(static_cast<uint32_t>(reference.generation));
-    inputKeyData.insert(inputKeyData.cend(), { uint8_t(objectNumber & 0xFF), uint8_t((objectNumber >> 8) & 0xFF), uint8_t((objectNumber >> 16) & 0xFF), uint8_t(generation & 0xFF), uint8_t((generation >> 8) & 0xFF) });
-    std::vector<uint8_t> objectEncryptionKey(MD5_DIGEST_LENGTH, uint8_t(0));
-    MD5(inputKeyData.data(), inputKeyData.size(), objectEncryptionKey.data());
-
-    // Use up to (n + 5) bytes, maximally 16, from the digest as object encryption key
-    size_t objectEncryptionKeySize = qMin(filter.keyLength + 5, MD5_DIGEST_LENGTH);
-    objectEncryptionKey.resize(objectEncryptionKeySize);
-
-    return objectEncryptionKey;
+    auto createKey = [this, reference, &filter]()
+    {
+        std::vector<uint8_t> inputKeyData = convertByteArrayToVector(m_authorizationData.fileEncryptionKey);
+        uint32_t objectNumber = qToLittleEndian(static_cast<uint32_t>(reference.objectNumber));
+        uint32_t generation = qToLittleEndian(static_cast<uint32_t>(reference.generation));
+        inputKeyData.insert(inputKeyData.cend(), { uint8_t(objectNumber & 0xFF), uint8_t((objectNumber >> 8) & 0xFF), uint8_t((objectNumber >> 16) & 0xFF), uint8_t(generation & 0xFF), uint8_t((generation >> 8) & 0xFF) });
+        std::vector<uint8_t> objectEncryptionKey(MD5_DIGEST_LENGTH, uint8_t(0));
+        MD5(inputKeyData.data(), inputKeyData.size(), objectEncryptionKey.data());
+
+        // Use up to (n + 5) bytes, maximally 16, from the digest as object encryption key
+        size_t objectEncryptionKeySize = qMin(filter.keyLength + 5, MD5_DIGEST_LENGTH);
+        objectEncryptionKey.resize(objectEncryptionKeySize);
+
+        return objectEncryptionKey;
+    };
+
+    return m_objectEncryptionKeyCache.getKey(m_authorizationData.fileEncryptionKey, reference, CryptFilterType::V2, filter.keyLength, createKey);
 }
 
 std::vector<uint8_t> PDFStandardOrPublicSecurityHandler::createAESV2_ObjectEncryptionKey(PDFObjectReference reference) const
 {
-    std::vector<uint8_t> inputKeyData = convertByteArrayToVector(m_authorizationData.fileEncryptionKey);
-    uint32_t objectNumber = qToLittleEndian(static_cast<uint32_t>(reference.objectNumber));
-    uint32_t generation = qToLittleEndian(static_cast<uint32_t>(reference.generation));
-    inputKeyData.insert(inputKeyData.cend(), { uint8_t(objectNumber & 0xFF), uint8_t((objectNumber >> 8) & 0xFF), uint8_t((objectNumber >> 16) & 0xFF), uint8_t(generation & 0xFF), uint8_t((generation >> 8) & 0xFF), 0x73, 0x41, 0x6C, 0x54 });
-    std::vector<uint8_t> objectEncryptionKey(MD5_DIGEST_LENGTH, uint8_t(0));
-    MD5(inputKeyData.data(), inputKeyData.size(), objectEncryptionKey.data());
-
-    return objectEncryptionKey;
+    auto createKey = [this, reference]()
+    {
+        std::vector<uint8_t> inputKeyData = convertByteArrayToVector(m_authorizationData.fileEncryptionKey);
+        uint32_t objectNumber = qToLittleEndian(static_cast<uint32_t>(reference.objectNumber));
+        uint32_t generation = qToLittleEndian(static_cast<uint32_t>(reference.generation));
+        inputKeyData.insert(inputKeyData.cend(), { uint8_t(objectNumber & 0xFF), uint8_t((objectNumber >> 8) & 0xFF), uint8_t((objectNumber >> 16) & 0xFF), uint8_t(generation & 0xFF), uint8_t((generation >> 8) & 0xFF), 0x73, 0x41, 0x6C, 0x54 });
+        std::vector<uint8_t> objectEncryptionKey(MD5_DIGEST_LENGTH, uint8_t(0));
+        MD5(inputKeyData.data(), inputKeyData.size(), objectEncryptionKey.data());
+
+        return objectEncryptionKey;
+    };
+
+    return m_objectEncryptionKeyCache.getKey(m_authorizationData.fileEncryptionKey, reference, CryptFilterType::AESV2, 0, createKey);
+}
+
+/// Encrypts or decrypts data by AES cipher in CBC mode. EVP interface is used,
+/// so hardware accelerated implementation is selected, if it is available.
+/// Padding is not handled, size of the data must be multiple of AES_BLOCK_SIZE.
+/// If cipher fails, empty data are returned, as if data were damaged.
+/// \param key Key (16 or 32 bytes)
+/// \param keySize Size of the key in bytes
+/// \param initializationVector Initialization vector (AES_BLOCK_SIZE bytes)
+/// \param data Data to be encrypted or decrypted
+/// \param encrypt Encrypt (true) or decrypt (false) data
+static QByteArray transformAES_CBC(const uint8_t* key, size_t keySize, const QByteArray& initializationVector, const QByteArray& data, bool encrypt)
+{
+    const EVP_CIPHER* cipher = nullptr;
+    switch (keySize)
+    {
+        case 16:
+            cipher = EVP_aes_128_cbc();
+            break;
+
+        case 24:
+            cipher = EVP_aes_192_cbc();
+            break;
+
+        case 32:
+            cipher = EVP_aes_256_cbc();
+            break;
+
+        default:
+            return QByteArray();
+    }
+
+    Q_ASSERT(initializationVector.size() == AES_BLOCK_SIZE);
+    Q_ASSERT(data.size() % AES_BLOCK_SIZE == 0);
+
+    openssl_ptr<EVP_CIPHER_CTX> context(EVP_CIPHER_CTX_new(), EVP_CIPHER_CTX_free);
+    QByteArray result(data.size(), Qt::Uninitialized);
+    int updateLength = 0;
+    int finalLength = 0;
+
+    if (!context ||
+        !EVP_CipherInit_ex(context.get(), cipher, nullptr, key, convertByteArrayToUcharPtr(initializationVector), encrypt ? 1 : 0) ||
+        !EVP_CIPHER_CTX_set_padding(context.get(), 0) ||
+        !EVP_CipherUpdate(context.get(), convertByteArrayToUcharPtr(result), &updateLength, convertByteArrayToUcharPtr(data), data.size()) ||
+        !EVP_CipherFinal_ex(context.get(), convertByteArrayToUcharPtr(result) + updateLength, &finalLength))
+    {
+        return QByteArray();
+    }
+
+    result.resize(updateLength + finalLength);
+    return result;
 }
 
 QByteArray PDFStandardOrPublicSecurityHandler::decryptUsingFilter(const QByteArray& data, CryptFilter filter, PDFObjectReference reference) const
@@ -922,14 +1035,10 @@ QByteArray PDFStandardOrPublicSecurityHandler::decryptUsingFilter(const QByteArr
 
             // For AES algorithm, always use 16 bytes key (128 bit encryption mode)
 
-            AES_KEY key = { };
-            AES_set_decrypt_key(objectEncryptionKey.data(), static_cast<int>(objectEncryptionKey.size()) * 8, &key);
-
             AES_data aes_data = prepareAES_data(data);
             if (!aes_data.paddedData.isEmpty())
             {
-                decryptedData.resize(aes_data.paddedData.size());
-                AES_cbc_encrypt(convertByteArrayToUcharPtr(aes_data.paddedData), convertByteArrayToUcharPtr(decryptedData), aes_data.paddedData.length(), &key, convertByteArrayToUcharPtr(aes_data.initializationVector), AES_DECRYPT);
+                decryptedData = transformAES_CBC(objectEncryptionKey.data(), objectEncryptionKey.size(), aes_data.initializationVector, aes_data.paddedData, false);
                 decryptedData = removeAES_padding(decryptedData);
             }
 
@@ -939,14 +1048,11 @@ QByteArray PDFStandardOrPublicSecurityHandler::decryptUsingFilter(const QByteArr
         case CryptFilterType::AESV3:      // Use file encryption key for AES 256 bit algorithm
         {
             Q_ASSERT(m_authorizationData.fileEncryptionKey.size() == 32);
-            AES_KEY key = { };
-            AES_set_decrypt_key(convertByteArrayToUcharPtr(m_authorizationData.fileEncryptionKey), static_cast<int>(m_authorizationData.fileEncryptionKey.size()) * 8, &key);
 
             AES_data aes_data = prepareAES_data(data);
             if (!aes_data.paddedData.isEmpty())
             {
-                decryptedData.resize(aes_data.paddedData.size());
-                AES_cbc_encrypt(convertByteArrayToUcharPtr(aes_data.paddedData), convertByteArrayToUcharPtr(decryptedData), aes_data.paddedData.length(), &key, convertByteArrayToUcharPtr(aes_data.initializationVector), AES_DECRYPT);
+                decryptedData = transformAES_CBC(convertByteArrayToUcharPtr(m_authorizationData.fileEncryptionKey), m_authorizationData.fileEncryptionKey.size(), aes_data.initializationVector, aes_data.paddedData, false);
                 decryptedData = removeAES_padding(decryptedData);
             }
 
@@ -1031,16 +1137,11 @@ QByteArray PDFStandardOrPublicSecurityHandler::encryptUsingFilter(const QByteArr
 
             // For AES algorithm, always use 16 bytes key (128 bit encryption mode)
 
-            AES_KEY key = { };
-            AES_set_encrypt_key(objectEncryptionKey.data(), static_cast<int>(objectEncryptionKey.size()) * 8, &key);
-
             AES_data aes_data = prepareAES_data(data);
             if (!aes_data.paddedData.isEmpty())
             {
-                QByteArray initializationVectorCopy = aes_data.initializationVector;
-                encryptedData.resize(aes_data.paddedData.size());
-                AES_cbc_encrypt(convertByteArrayToUcharPtr(aes_data.paddedData), convertByteArrayToUcharPtr(encryptedData), aes_data.paddedData.length(), &key, convertByteArrayToUcharPtr(aes_data.initializationVector), AES_ENCRYPT);
-                encryptedData.prepend(initializationVectorCopy);
+                encryptedData = transformAES_CBC(objectEncryptionKey.data(), objectEncryptionKey.size(), aes_data.initializationVector, aes_data.paddedData, true);
+                encryptedData.prepend(aes_data.initializationVector);
             }
 
             break;
@@ -1049,16 +1150,12 @@ QByteArray PDFStandardOrPublicSecurityHandler::encryptUsingFilter(const QByteArr
         case CryptFilterType::AESV3:      // Use file encryption key for AES 256 bit algorithm
         {
             Q_ASSERT(m_authorizationData.fileEncryptionKey.size() == 32);
-            AES_KEY key = { };
-            AES_set_encrypt_key(convertByteArrayToUcharPtr(m_authorizationData.fileEncryptionKey), static_cast<int>(m_authorizationData.fileEncryptionKey.size()) * 8, &key);
 
             AES_data aes_data = prepareAES_data(data);
             if (!aes_data.paddedData.isEmpty())
             {
-                QByteArray initializationVectorCopy = aes_data.initializationVector;
-                encryptedData.resize(aes_data.paddedData.size());
-                AES_cbc_encrypt(convertByteArrayToUcharPtr(aes_data.paddedData), convertByteArrayToUcharPtr(encryptedData), aes_data.paddedData.length(), &key, convertByteArrayToUcharPtr(aes_data.initializationVector), AES_ENCRYPT);
-                encryptedData.prepend(initializationVectorCopy);
+                encryptedData = transformAES_CBC(convertByteArrayToUcharPtr(m_authorizationData.fileEncryptionKey), m_authorizationData.fileEncryptionKey.size(), aes_data.initializationVector, aes_data.paddedData, true);
+                encryptedData.prepend(aes_data.initializationVector);
             }
 
             break;
@@ -22,10 +22,12 @@
 #include "pdfobject.h"
 #include "pdfcertificatestore.h"
 
+#include <QMutex>
 #include <QByteArray>
 #include <QSharedPointer>
 
 #include <map>
+#include <array>
 #include <functional>
 
 class QRandomGenerator;
@@ -81,7 +83,7 @@ using PDFSecurityHandlerPointer = QSharedPointer<PDFSecurityHandler>;
 
 class PDFStandardSecurityHandler;
 
-class PDFSecurityHandler
+class PDFSecurityHandler : public QEnableSharedFromThis<PDFSecurityHandler>
 {
 public:
     explicit PDFSecurityHandler() = default;
@@ -313,8 +315,51 @@ protected:
     std::vector<uint8_t> createAESV2_ObjectEncryptionKey(PDFObjectReference reference) const;
     CryptFilter getCryptFilter(EncryptionScope encryptionScope) const;
 
+    /// Cache of object encryption keys. Object encryption key is derived from the file
+    /// encryption key and object reference by MD5 hash, and all strings and streams
+    /// of the object use the same key. Cache is direct mapped by object number.
+    /// Cache is thread safe. Copy of the cache is empty.
+    class ObjectEncryptionKeyCache
+    {
+    public:
+        explicit ObjectEncryptionKeyCache() = default;
+        ObjectEncryptionKeyCache(const ObjectEncryptionKeyCache&) { }
+        ObjectEncryptionKeyCache& operator=(const ObjectEncryptionKeyCache&) { return *this; }
+
+        /// Returns object encryption key from the cache. If key is not found,
+        /// it is created by \p createKey and stored in the cache.
+        /// \param fileEncryptionKey File encryption key, from which key is derived
+        /// \param reference Object reference
+        /// \param filterType Crypt filter type
+        /// \param keyLength Key length of the crypt filter
+        /// \param createKey Function creating the key
+        std::vector<uint8_t> getKey(const QByteArray& fileEncryptionKey,
+                                    PDFObjectReference reference,
+                                    CryptFilterType filterType,
+                                    int keyLength,
+                                    const std::function<std::vector<uint8_t>(void)>& createKey);
+
+    private:
+        static constexpr size_t CACHE_SIZE = 256;
+
+        struct Entry
+        {
+            PDFObjectReference reference;
+            CryptFilterType filterType = CryptFilterType::None;
+            int keyLength = 0;
+            std::vector<uint8_t> key;
+        };
+
+        QMutex m_mutex;
+        QByteArray m_fileEncryptionKey;
+        std::array<Entry, CACHE_SIZE> m_entries;
+    };
+
     /// Authorization data
     AuthorizationData m_authorizationData;
+
+    /// Cache of object encryption keys
+    mutable ObjectEncryptionKeyCache m_objectEncryptionKeyCache;
 };
 
 /// Specifies the security using standard security handler (see PDF specification
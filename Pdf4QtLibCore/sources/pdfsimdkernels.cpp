@@ -0,0 +1,580 @@
+//    Copyright (C) 2024 Jakub Melka
+//
+//    This file is part of PDF4QT.
+//
+//    PDF4QT is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    with the written consent of the copyright owner, any later version.
+//
+//    PDF4QT is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public License
+//    along with PDF4QT.  If not, see <https://www.gnu.org/licenses/>.
+
+#include "pdfsimdkernels.h"
+
+#include <QtGlobal>
+
+#include <array>
+#include <cstdlib>
+#include <cstring>
+
+#if defined(Q_PROCESSOR_X86)
+#define PDF4QT_SIMD_X86
+#include <immintrin.h>
+#if defined(Q_CC_MSVC)
+#include <intrin.h>
+#endif
+#endif
+
+#if defined(PDF4QT_SIMD_X86) && !defined(Q_CC_MSVC)
+#define PDF4QT_TARGET_SSE2 __attribute__((target("sse2")))
+#define PDF4QT_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define PDF4QT_TARGET_SSE2
+#define PDF4QT_TARGET_AVX2
+#endif
+
+#include "pdfdbgheap.h"
+
+namespace pdf
+{
+
+namespace
+{
+
+void decodePNGRowScalar(uint8_t filter, const uint8_t* input, uint8_t* line, const uint8_t* previousLine, size_t size, size_t pixelBytes)
+{
+    // Left pixels of the first pixel are zero bytes preceding the rows
+    const uint8_t* left = line - pixelBytes;
+    const uint8_t* upperLeft = previousLine - pixelBytes;
+
+    switch (filter)
+    {
+        case PDFSimdKernels::PNG_Sub:
+        {
+            for (size_t i = 0; i < size; ++i)
+            {
+                line[i] = input[i] + left[i];
+            }
+            break;
+        }
+
+        case PDFSimdKernels::PNG_Up:
+        {
+            for (size_t i = 0; i < size; ++i)
+            {
+                line[i] = input[i] + previousLine[i];
+            }
+            break;
+        }
+
+        case PDFSimdKernels::PNG_Average:
+        {
+            for (size_t i = 0; i < size; ++i)
+            {
+                line[i] = input[i] + ((left[i] + previousLine[i]) >> 1);
+            }
+            break;
+        }
+
+        case PDFSimdKernels::PNG_Paeth:
+        {
+            for (size_t i = 0; i < size; ++i)
+            {
+                // a = left,
+                // b = upper,
+                // c = upper left
+                const int a = left[i];
+                const int b = previousLine[i];
+                const int c = upperLeft[i];
+                const int pa = std::abs(b - c);
+                const int pb = std::abs(a - c);
+                const int pc = std::abs(a + b - c - c);
+
+                if (pa <= pb && pa <= pc)
+                {
+                    line[i] = input[i] + a;
+                }
+                else if (pb <= pc)
+                {
+                    line[i] = input[i] + b;
+                }
+                else
+                {
+                    line[i] = input[i] + c;
+                }
+            }
+            break;
+        }
+
+        case PDFSimdKernels::PNG_None:
+        default:
+        {
+            std::memcpy(line, input, size);
+            break;
+        }
+    }
+}
+
+/// Table of normalized values of all samples, which can be packed in one byte.
+/// Values are computed in double precision, as PDFBitReader based code does.
+template<int bitsPerComponent>
+struct PDFNormalizedSampleTable
+{
+    static constexpr int SAMPLES_PER_BYTE = 8 / bitsPerComponent;
+
+    PDFNormalizedSampleTable()
+    {
+        const int max = (1 << bitsPerComponent) - 1;
+        const double coefficient = 1.0 / max;
+
+        for (int byte = 0; byte < 256; ++byte)
+        {
+            for (int i = 0; i < SAMPLES_PER_BYTE; ++i)
+            {
+                const int shift = 8 - bitsPerComponent * (i + 1);
+                const int value = (byte >> shift) & max;
+                samples[byte][i] = static_cast<float>(value * coefficient);
+            }
+        }
+    }
+
+    std::array<std::array<float, SAMPLES_PER_BYTE>, 256> samples;
+};
+
+template<int bitsPerComponent>
+void unpackNormalizedSamplesTable(const uint8_t* input, float* output, size_t count)
+{
+    static const PDFNormalizedSampleTable<bitsPerComponent> table;
+    constexpr size_t SAMPLES_PER_BYTE = PDFNormalizedSampleTable<bitsPerComponent>::SAMPLES_PER_BYTE;
+
+    const size_t wholeBytes = count / SAMPLES_PER_BYTE;
+    for (size_t i = 0; i < wholeBytes; ++i)
+    {
+        std::memcpy(output, table.samples[input[i]].data(), sizeof(float) * SAMPLES_PER_BYTE);
+        output += SAMPLES_PER_BYTE;
+    }
+
+    const size_t remainingSamples = count - wholeBytes * SAMPLES_PER_BYTE;
+    if (remainingSamples > 0)
+    {
+        std::memcpy(output, table.samples[input[wholeBytes]].data(), sizeof(float) * remainingSamples);
+    }
+}
+
+void unpackNormalizedSamples16Scalar(const uint8_t* input, float* output, size_t count)
+{
+    const double coefficient = 1.0 / 65535.0;
+    for (size_t i = 0; i < count; ++i)
+    {
+        const int value = (int(input[2 * i]) << 8) | int(input[2 * i + 1]);
+        output[i] = static_cast<float>(value * coefficient);
+    }
+}
+
+#if defined(PDF4QT_SIMD_X86)
+
+PDFSimdKernels::InstructionSet detectInstructionSet()
+{
+    bool hasSSE2 = false;
+    bool hasAVX2 = false;
+
+#if defined(Q_CC_MSVC)
+    int info[4] = { };
+    __cpuid(info, 0);
+    const int maxLeaf = info[0];
+
+    __cpuid(info, 1);
+    hasSSE2 = (info[3] & (1 << 26)) != 0;
+    const bool hasOSXSAVE = (info[2] & (1 << 27)) != 0;
+    const bool hasAVX = (info[2] & (1 << 28)) != 0;
+
+    // AVX registers must be enabled by the operating system
+    if (maxLeaf >= 7 && hasOSXSAVE && hasAVX && (_xgetbv(0) & 0x6) == 0x6)
+    {
+        __cpuidex(info, 7, 0);
+        hasAVX2 = (info[1] & (1 << 5)) != 0;
+    }
+#else
+    __builtin_cpu_init();
+    hasSSE2 = __builtin_cpu_supports("sse2");
+    hasAVX2 = __builtin_cpu_supports("avx2");
+#endif
+
+    if (hasAVX2)
+    {
+        return PDFSimdKernels::InstructionSet::AVX2;
+    }
+
+    if (hasSSE2)
+    {
+        return PDFSimdKernels::InstructionSet::SSE2;
+    }
+
+    return PDFSimdKernels::InstructionSet::Scalar;
+}
+
+PDF4QT_TARGET_SSE2 inline __m128i loadPixel(const uint8_t* data, size_t pixelBytes)
+{
+    int32_t value = 0;
+    std::memcpy(&value, data, pixelBytes);
+    return _mm_cvtsi32_si128(value);
+}
+
+PDF4QT_TARGET_SSE2 inline void storePixel(uint8_t* data, __m128i pixel, size_t pixelBytes)
+{
+    const int32_t value = _mm_cvtsi128_si32(pixel);
+    std::memcpy(data, &value, pixelBytes);
+}
+
+PDF4QT_TARGET_SSE2 inline __m128i absInt16(__m128i value)
+{
+    return _mm_max_epi16(value, _mm_sub_epi16(_mm_setzero_si128(), value));
+}
+
+PDF4QT_TARGET_SSE2 inline __m128i selectInt16(__m128i mask, __m128i a, __m128i b)
+{
+    return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+}
+
+PDF4QT_TARGET_SSE2 void decodePNGRowUpSSE2(const uint8_t* input, uint8_t* line, const uint8_t* previousLine, size_t size)
+{
+    size_t i = 0;
+    for (; i + 16 <= size; i += 16)
+    {
+        const __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(input + i));
+        const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(previousLine + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(line + i), _mm_add_epi8(x, b));
+    }
+
+    for (; i < size; ++i)
+    {
+        line[i] = input[i] + previousLine[i];
+    }
+}
+
+/// Sub, Average and Paeth filters have dependency on the left pixel, so they
+/// are decoded pixel by pixel, but all bytes of the pixel are decoded at once.
+PDF4QT_TARGET_SSE2 void decodePNGRowPixelsSSE2(uint8_t filter, const uint8_t* input, uint8_t* line, const uint8_t* previousLine, size_t size, size_t pixelBytes)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i one = _mm_set1_epi8(1);
+
+    size_t i = 0;
+    __m128i a = zero;
+    switch (filter)
+    {
+        case PDFSimdKernels::PNG_Sub:
+        {
+            for (; i + pixelBytes <= size; i += pixelBytes)
+            {
+                a = _mm_add_epi8(a, loadPixel(input + i, pixelBytes));
+                storePixel(line + i, a, pixelBytes);
+            }
+            break;
+        }
+
+        case PDFSimdKernels::PNG_Average:
+        {
+            for (; i + pixelBytes <= size; i += pixelBytes)
+            {
+                // Average rounds up, so we must correct odd sums
+                const __m128i b = loadPixel(previousLine + i, pixelBytes);
+                __m128i average = _mm_avg_epu8(a, b);
+                average = _mm_sub_epi8(average, _mm_and_si128(_mm_xor_si128(a, b), one));
+                a = _mm_add_epi8(loadPixel(input + i, pixelBytes), average);
+                storePixel(line + i, a, pixelBytes);
+            }
+            break;
+        }
+
+        case PDFSimdKernels::PNG_Paeth:
+        {
+            // Values are extended to 16-bit integers, so differences fit
+            __m128i c = zero;
+            for (; i + pixelBytes <= size; i += pixelBytes)
+            {
+                const __m128i b = _mm_unpacklo_epi8(loadPixel(previousLine + i, pixelBytes), zero);
+
+                __m128i pa = _mm_sub_epi16(b, c);
+                __m128i pb = _mm_sub_epi16(a, c);
+                __m128i pc = _mm_add_epi16(pa, pb);
+
+                pa = absInt16(pa);
+                pb = absInt16(pb);
+                pc = absInt16(pc);
+
+                const __m128i smallest = _mm_min_epi16(pc, _mm_min_epi16(pa, pb));
+                const __m128i nearest = selectInt16(_mm_cmpeq_epi16(smallest, pa), a,
+                                                    selectInt16(_mm_cmpeq_epi16(smallest, pb), b, c));
+
+                const __m128i decoded = _mm_add_epi8(loadPixel(input + i, pixelBytes), _mm_packus_epi16(nearest, nearest));
+                storePixel(line + i, decoded, pixelBytes);
+
+                a = _mm_unpacklo_epi8(decoded, zero);
+                c = b;
+            }
+            break;
+        }
+
+        default:
+            Q_ASSERT(false);
+            break;
+    }
+
+    // Incomplete pixel at the end of the row
+    if (i < size)
+    {
+        decodePNGRowScalar(filter, input + i, line + i, previousLine + i, size - i, pixelBytes);
+    }
+}
+
+PDF4QT_TARGET_SSE2 void decodePNGRowSSE2(uint8_t filter, const uint8_t* input, uint8_t* line, const uint8_t* previousLine, size_t size, size_t pixelBytes)
+{
+    switch (filter)
+    {
+        case PDFSimdKernels::PNG_Up:
+            decodePNGRowUpSSE2(input, line, previousLine, size);
+            break;
+
+        case PDFSimdKernels::PNG_Sub:
+        case PDFSimdKernels::PNG_Average:
+        case PDFSimdKernels::PNG_Paeth:
+        {
+            if (pixelBytes == 3 || pixelBytes == 4)
+            {
+                decodePNGRowPixelsSSE2(filter, input, line, previousLine, size, pixelBytes);
+            }
+            else
+            {
+                decodePNGRowScalar(filter, input, line, previousLine, size, pixelBytes);
+            }
+            break;
+        }
+
+        default:
+            decodePNGRowScalar(filter, input, line, previousLine, size, pixelBytes);
+            break;
+    }
+}
+
+PDF4QT_TARGET_AVX2 void decodePNGRowUpAVX2(const uint8_t* input, uint8_t* line, const uint8_t* previousLine, size_t size)
+{
+    size_t i = 0;
+    for (; i + 32 <= size; i += 32)
+    {
+        const __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(input + i));
+        const __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(previousLine + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(line + i), _mm256_add_epi8(x, b));
+    }
+
+    decodePNGRowUpSSE2(input + i, line + i, previousLine + i, size - i);
+}
+
+PDF4QT_TARGET_SSE2 void unpackNormalizedSamples8SSE2(const uint8_t* input, float* output, size_t count)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128 coefficient = _mm_set1_ps(1.0f / 255.0f);
+
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16)
+    {
+        const __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(input + i));
+        const __m128i low = _mm_unpacklo_epi8(bytes, zero);
+        const __m128i high = _mm_unpackhi_epi8(bytes, zero);
+
+        _mm_storeu_ps(output + i, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(low, zero)), coefficient));
+        _mm_storeu_ps(output + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(low, zero)), coefficient));
+        _mm_storeu_ps(output + i + 8, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(high, zero)), coefficient));
+        _mm_storeu_ps(output + i + 12, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(high, zero)), coefficient));
+    }
+
+    unpackNormalizedSamplesTable<8>(input + i, output + i, count - i);
+}
+
+PDF4QT_TARGET_SSE2 void unpackNormalizedSamples16SSE2(const uint8_t* input, float* output, size_t count)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128 coefficient = _mm_set1_ps(1.0f / 65535.0f);
+
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        __m128i samples = _mm_loadu_si128(reinterpret_cast<const __m128i*>(input + 2 * i));
+
+        // Samples are big endian
+        samples = _mm_or_si128(_mm_slli_epi16(samples, 8), _mm_srli_epi16(samples, 8));
+
+        _mm_storeu_ps(output + i, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(samples, zero)), coefficient));
+        _mm_storeu_ps(output + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(samples, zero)), coefficient));
+    }
+
+    unpackNormalizedSamples16Scalar(input + 2 * i, output + i, count - i);
+}
+
+PDF4QT_TARGET_AVX2 void unpackNormalizedSamples8AVX2(const uint8_t* input, float* output, size_t count)
+{
+    const __m256 coefficient = _mm256_set1_ps(1.0f / 255.0f);
+
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        const __m256i samples = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(input + i)));
+        _mm256_storeu_ps(output + i, _mm256_mul_ps(_mm256_cvtepi32_ps(samples), coefficient));
+    }
+
+    unpackNormalizedSamplesTable<8>(input + i, output + i, count - i);
+}
+
+PDF4QT_TARGET_AVX2 void unpackNormalizedSamples16AVX2(const uint8_t* input, float* output, size_t count)
+{
+    const __m256 coefficient = _mm256_set1_ps(1.0f / 65535.0f);
+
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8)
+    {
+        __m128i samples = _mm_loadu_si128(reinterpret_cast<const __m128i*>(input + 2 * i));
+
+        // Samples are big endian
+        samples = _mm_or_si128(_mm_slli_epi16(samples, 8), _mm_srli_epi16(samples, 8));
+        _mm256_storeu_ps(output + i, _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_cvtepu16_epi32(samples)), coefficient));
+    }
+
+    unpackNormalizedSamples16Scalar(input + 2 * i, output + i, count - i);
+}
+
+#endif
+
+}   // namespace
+
+PDFSimdKernels::InstructionSet PDFSimdKernels::getInstructionSet()
+{
+#if defined(PDF4QT_SIMD_X86)
+    static const InstructionSet instructionSet = detectInstructionSet();
+    return instructionSet;
+#else
+    return InstructionSet::Scalar;
+#endif
+}
+
+bool PDFSimdKernels::isInstructionSetSupported(InstructionSet instructionSet)
+{
+    return instructionSet <= getInstructionSet();
+}
+
+void PDFSimdKernels::decodePNGRow(uint8_t filter,
+                                  const uint8_t* input,
+                                  uint8_t* line,
+                                  const uint8_t* previousLine,
+                                  size_t size,
+                                  size_t pixelBytes,
+                                  InstructionSet instructionSet)
+{
+    Q_ASSERT(pixelBytes > 0);
+    Q_ASSERT(isInstructionSetSupported(instructionSet));
+
+    switch (instructionSet)
+    {
+#if defined(PDF4QT_SIMD_X86)
+        case InstructionSet::AVX2:
+        {
+            if (filter == PNG_Up)
+            {
+                decodePNGRowUpAVX2(input, line, previousLine, size);
+            }
+            else
+            {
+                // Other filters are limited by dependency on the left pixel, wider registers do not help
+                decodePNGRowSSE2(filter, input, line, previousLine, size, pixelBytes);
+            }
+            break;
+        }
+
+        case InstructionSet::SSE2:
+            decodePNGRowSSE2(filter, input, line, previousLine, size, pixelBytes);
+            break;
+#endif
+
+        default:
+            decodePNGRowScalar(filter, input, line, previousLine, size, pixelBytes);
+            break;
+    }
+}
+
+void PDFSimdKernels::unpackNormalizedSamples(const uint8_t* input,
+                                             float* output,
+                                             size_t count,
+                                             int bitsPerComponent,
+                                             InstructionSet instructionSet)
+{
+    Q_ASSERT(isUnpackSupported(bitsPerComponent));
+    Q_ASSERT(isInstructionSetSupported(instructionSet));
+
+    switch (bitsPerComponent)
+    {
+        case 1:
+            unpackNormalizedSamplesTable<1>(input, output, count);
+            break;
+
+        case 2:
+            unpackNormalizedSamplesTable<2>(input, output, count);
+            break;
+
+        case 4:
+            unpackNormalizedSamplesTable<4>(input, output, count);
+            break;
+
+        case 8:
+        {
+            switch (instructionSet)
+            {
+#if defined(PDF4QT_SIMD_X86)
+                case InstructionSet::AVX2:
+                    unpackNormalizedSamples8AVX2(input, output, count);
+                    break;
+
+                case InstructionSet::SSE2:
+                    unpackNormalizedSamples8SSE2(input, output, count);
+                    break;
+#endif
+
+                default:
+                    unpackNormalizedSamplesTable<8>(input, output, count);
+                    break;
+            }
+            break;
+        }
+
+        case 16:
+        {
+            switch (instructionSet)
+            {
+#if defined(PDF4QT_SIMD_X86)
+                case InstructionSet::AVX2:
+                    unpackNormalizedSamples16AVX2(input, output, count);
+                    break;
+
+                case InstructionSet::SSE2:
+                    unpackNormalizedSamples16SSE2(input, output, count);
+                    break;
+#endif
+
+                default:
+                    unpackNormalizedSamples16Scalar(input, output, count);
+                    break;
+            }
+            break;
+        }
+
+        default:
+            Q_ASSERT(false);
+            break;
+    }
+}
+
+}   // namespace pdf
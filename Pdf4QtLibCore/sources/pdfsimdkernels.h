@@ -0,0 +1,105 @@
+//    Copyright (C) 2024 Jakub Melka
+//
+//    This file is part of PDF4QT.
+//
+//    PDF4QT is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU Lesser General Public License as published by
+//    the Free Software Foundation, either version 3 of the License, or
+//    with the written consent of the copyright owner, any later version.
+//
+//    PDF4QT is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU Lesser General Public License for more details.
+//
+//    You should have received a copy of the GNU Lesser General Public License
+//    along with PDF4QT.  If not, see <https://www.gnu.org/licenses/>.
+
+#ifndef PDFSIMDKERNELS_H
+#define PDFSIMDKERNELS_H
+
+#include "pdfglobal.h"
+
+#include <cstdint>
+#include <cstddef>
+
+namespace pdf
+{
+
+/// Kernels for hot loops of image decoding (stream predictors, unpacking
+/// of image samples). Implementation is selected at runtime according to
+/// the instruction sets supported by the processor. Scalar implementation
+/// is always available and is used on other platforms than x86.
+class PDF4QTLIBCORESHARED_EXPORT PDFSimdKernels
+{
+public:
+    enum class InstructionSet
+    {
+        Scalar,
+        SSE2,
+        AVX2
+    };
+
+    /// PNG filter types (stored in the first byte of each row)
+    enum PNGFilter : uint8_t
+    {
+        PNG_None = 0,
+        PNG_Sub = 1,
+        PNG_Up = 2,
+        PNG_Average = 3,
+        PNG_Paeth = 4
+    };
+
+    /// Returns best instruction set supported by the processor
+    static InstructionSet getInstructionSet();
+
+    /// Returns true, if instruction set is supported by the processor
+    /// \param instructionSet Instruction set
+    static bool isInstructionSetSupported(InstructionSet instructionSet);
+
+    /// Decodes one row of the data encoded by the PNG filter. Both \p line
+    /// and \p previousLine must be preceded by \p pixelBytes bytes, which
+    /// are zero for \p previousLine and for \p line (left pixel of the first pixel).
+    /// Invalid filter types are treated as PNG_None.
+    /// \param filter PNG filter type
+    /// \param input Encoded row data (without filter type byte)
+    /// \param line Decoded row
+    /// \param previousLine Previously decoded row
+    /// \param size Number of bytes in the row
+    /// \param pixelBytes Number of bytes per pixel (at least 1)
+    /// \param instructionSet Instruction set to be used
+    static void decodePNGRow(uint8_t filter,
+                             const uint8_t* input,
+                             uint8_t* line,
+                             const uint8_t* previousLine,
+                             size_t size,
+                             size_t pixelBytes,
+                             InstructionSet instructionSet = getInstructionSet());
+
+    /// Returns true, if samples with given bit depth can be unpacked
+    /// by \p unpackNormalizedSamples
+    /// \param bitsPerComponent Bits per component
+    static constexpr bool isUnpackSupported(int bitsPerComponent)
+    {
+        return bitsPerComponent == 1 || bitsPerComponent == 2 || bitsPerComponent == 4 ||
+               bitsPerComponent == 8 || bitsPerComponent == 16;
+    }
+
+    /// Unpacks samples packed in the byte buffer (most significant bits first,
+    /// 16-bit samples are big endian) into the float values in the range [0, 1].
+    /// Input must contain at least (\p count * \p bitsPerComponent + 7) / 8 bytes.
+    /// \param input Packed samples
+    /// \param output Unpacked normalized samples
+    /// \param count Number of samples
+    /// \param bitsPerComponent Bits per component (1, 2, 4, 8 or 16)
+    /// \param instructionSet Instruction set to be used
+    static void unpackNormalizedSamples(const uint8_t* input,
+                                        float* output,
+                                        size_t count,
+                                        int bitsPerComponent,
+                                        InstructionSet instructionSet = getInstructionSet());
+};
+
+}   // namespace pdf
+
+#endif // PDFSIMDKERNELS_H
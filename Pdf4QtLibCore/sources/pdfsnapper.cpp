@@ -174,7 +174,7 @@ void PDFSnapper::updateSnappedPoint(const QPointF& mousePoint)
     // Iterate trough all images, check, if some is under mouse cursor
     for (const ViewportSnapImage& snapImage : m_snapImages)
     {
-        if (snapImage.viewportPath.contains(mousePoint))
+        if (snapImage.viewportBoundingRect.contains(mousePoint) && snapImage.viewportPath.contains(mousePoint))
         {
             m_snappedImage = snapImage;
             break;
@@ -281,6 +281,7 @@ void PDFSnapper::buildSnapImages(const PDFWidgetSnapshot& snapshot)
             viewportSnapImage.imagePath = snapImage.imagePath;
             viewportSnapImage.pageIndex = item.pageIndex;
             viewportSnapImage.viewportPath = item.pageToDeviceMatrix.map(snapImage.imagePath);
+            viewportSnapImage.viewportBoundingRect = viewportSnapImage.viewportPath.controlPointRect();
             m_snapImages.emplace_back(qMove(viewportSnapImage));
         }
     }
@@ -121,6 +121,7 @@ public:
     {
         PDFInteger pageIndex;
         QPainterPath viewportPath;
+        QRectF viewportBoundingRect;    ///< Bounding rectangle of viewport path, for fast hit testing
     };
 
     /// Sets snap point pixel size
@@ -21,6 +21,7 @@
 #include "pdfparser.h"
 #include "pdfsecurityhandler.h"
 #include "pdfutils.h"
+#include "pdfsimdkernels.h"
 
 #include <zlib.h>
 
@@ -31,6 +32,287 @@
 namespace pdf
 {
 
+QByteArray PDFStreamFilterSource::readAll()
+{
+    QByteArray result;
+
+    while (true)
+    {
+        const qint64 oldSize = result.size();
+        result.resize(oldSize + CHUNK_SIZE);
+
+        const qint64 bytesRead = read(result.data() + oldSize, CHUNK_SIZE);
+        result.resize(oldSize + qMax(bytesRead, qint64(0)));
+
+        if (bytesRead <= 0)
+        {
+            break;
+        }
+    }
+
+    return result;
+}
+
+/// Source, which reads data from the byte array (for example, stream content)
+class PDFByteArrayFilterSource : public PDFStreamFilterSource
+{
+public:
+    explicit PDFByteArrayFilterSource(QByteArray data) :
+        m_data(qMove(data)),
+        m_position(0)
+    {
+
+    }
+
+    virtual qint64 read(char* data, qint64 maxSize) override
+    {
+        const qint64 bytesRead = qMin(maxSize, m_data.size() - m_position);
+        if (bytesRead > 0)
+        {
+            std::copy_n(m_data.constData() + m_position, bytesRead, data);
+            m_position += bytesRead;
+            return bytesRead;
+        }
+
+        return 0;
+    }
+
+private:
+    QByteArray m_data;
+    qint64 m_position;
+};
+
+/// Source, which decodes all data from the underlying source at once,
+/// using filter's whole-buffer function. It is used for filters, which
+/// can't decode data incrementally.
+class PDFWholeBufferFilterSource : public PDFStreamFilterSource
+{
+public:
+    explicit PDFWholeBufferFilterSource(PDFStreamFilterSourcePointer source,
+                                        const PDFStreamFilter* filter,
+                                        const PDFObjectFetcher& objectFetcher,
+                                        PDFObject parameters,
+                                        const PDFSecurityHandler* securityHandler) :
+        m_source(qMove(source)),
+        m_filter(filter),
+        m_objectFetcher(objectFetcher),
+        m_parameters(qMove(parameters)),
+        m_securityHandler(securityHandler)
+    {
+
+    }
+
+    virtual qint64 read(char* data, qint64 maxSize) override
+    {
+        if (m_source)
+        {
+            QByteArray encodedData = m_source->readAll();
+            m_source.reset();
+            m_decodedData = PDFByteArrayFilterSource(m_filter->apply(encodedData, m_objectFetcher, m_parameters, m_securityHandler));
+        }
+
+        return m_decodedData.read(data, maxSize);
+    }
+
+private:
+    PDFStreamFilterSourcePointer m_source;
+    const PDFStreamFilter* m_filter;
+    PDFObjectFetcher m_objectFetcher;
+    PDFObject m_parameters;
+    const PDFSecurityHandler* m_securityHandler;
+    PDFByteArrayFilterSource m_decodedData{ QByteArray() };
+};
+
+/// Source, which decompresses data by flate method incrementally
+class PDFFlateDecodeFilterSource : public PDFStreamFilterSource
+{
+public:
+    explicit PDFFlateDecodeFilterSource(PDFStreamFilterSourcePointer source);
+    virtual ~PDFFlateDecodeFilterSource() override;
+
+    virtual qint64 read(char* data, qint64 maxSize) override;
+
+private:
+    PDFStreamFilterSourcePointer m_source;
+    std::vector<char> m_inputBuffer;
+    z_stream m_stream;
+    bool m_isInputFinished = false;
+    bool m_isFinished = false;
+};
+
+PDFFlateDecodeFilterSource::PDFFlateDecodeFilterSource(PDFStreamFilterSourcePointer source) :
+    m_source(qMove(source)),
+    m_inputBuffer(CHUNK_SIZE, 0),
+    m_stream()
+{
+    if (inflateInit(&m_stream) != Z_OK)
+    {
+        throw PDFException(PDFTranslationContext::tr("Failed to initialize flate decompression stream."));
+    }
+}
+
+PDFFlateDecodeFilterSource::~PDFFlateDecodeFilterSource()
+{
+    inflateEnd(&m_stream);
+}
+
+qint64 PDFFlateDecodeFilterSource::read(char* data, qint64 maxSize)
+{
+    if (m_isFinished || maxSize <= 0)
+    {
+        return 0;
+    }
+
+    m_stream.next_out = reinterpret_cast<Bytef*>(data);
+    m_stream.avail_out = static_cast<uInt>(qMin<qint64>(maxSize, std::numeric_limits<uInt>::max()));
+    const qint64 outputSize = m_stream.avail_out;
+
+    while (m_stream.avail_out > 0)
+    {
+        if (m_stream.avail_in == 0 && !m_isInputFinished)
+        {
+            const qint64 bytesRead = m_source->read(m_inputBuffer.data(), qint64(m_inputBuffer.size()));
+            m_isInputFinished = bytesRead <= 0;
+            m_stream.next_in = reinterpret_cast<Bytef*>(m_inputBuffer.data());
+            m_stream.avail_in = static_cast<uInt>(qMax(bytesRead, qint64(0)));
+        }
+
+        const int error = inflate(&m_stream, Z_NO_FLUSH);
+
+        if (error == Z_OK || (error == Z_BUF_ERROR && m_stream.avail_in == 0 && !m_isInputFinished))
+        {
+            // Continue decompression, more input data may be needed
+            continue;
+        }
+
+        m_isFinished = true;
+
+        if (error == Z_STREAM_END)
+        {
+            // No error, normal behaviour
+            break;
+        }
+
+        QString errorMessage;
+        if (m_stream.msg)
+        {
+            errorMessage = QString::fromLatin1(m_stream.msg);
+        }
+
+        const bool ignoreError = error == Z_DATA_ERROR && errorMessage == "incorrect data check";
+        if (!ignoreError)
+        {
+            if (errorMessage.isEmpty())
+            {
+                errorMessage = PDFTranslationContext::tr("zlib code: %1").arg(error);
+            }
+
+            throw PDFException(PDFTranslationContext::tr("Error decompressing by flate method: %1").arg(errorMessage));
+        }
+
+        break;
+    }
+
+    return outputSize - m_stream.avail_out;
+}
+
+/// Source, which applies stream predictor to the data row by row
+class PDFStreamPredictorFilterSource : public PDFStreamFilterSource
+{
+public:
+    explicit PDFStreamPredictorFilterSource(PDFStreamFilterSourcePointer source, PDFStreamPredictor predictor);
+
+    virtual qint64 read(char* data, qint64 maxSize) override;
+
+private:
+    /// Decodes next row of the data. Returns false, if no data remain.
+    bool decodeNextRow();
+
+    PDFStreamFilterSourcePointer m_source;
+    PDFStreamPredictor m_predictor;
+    bool m_isPNG;
+    int m_pixelBytes;
+    QByteArray m_input;
+    std::vector<uint8_t> m_line;
+    std::vector<uint8_t> m_lineOld;
+    QByteArray m_output;
+    qint64 m_outputPosition = 0;
+};
+
+PDFStreamPredictorFilterSource::PDFStreamPredictorFilterSource(PDFStreamFilterSourcePointer source, PDFStreamPredictor predictor) :
+    m_source(qMove(source)),
+    m_predictor(qMove(predictor)),
+    m_isPNG(m_predictor.m_predictor >= PDFStreamPredictor::PNG_None),
+    m_pixelBytes(m_predictor.getPixelBytes())
+{
+    if (m_isPNG)
+    {
+        m_line.resize(m_predictor.m_stride + m_pixelBytes, 0);
+        m_lineOld.resize(m_predictor.m_stride + m_pixelBytes, 0);
+    }
+}
+
+qint64 PDFStreamPredictorFilterSource::read(char* data, qint64 maxSize)
+{
+    qint64 bytesRead = 0;
+    while (bytesRead < maxSize)
+    {
+        if (m_outputPosition == m_output.size() && !decodeNextRow())
+        {
+            break;
+        }
+
+        const qint64 count = qMin(maxSize - bytesRead, m_output.size() - m_outputPosition);
+        std::copy_n(m_output.constData() + m_outputPosition, count, data + bytesRead);
+        m_outputPosition += count;
+        bytesRead += count;
+    }
+
+    return bytesRead;
+}
+
+bool PDFStreamPredictorFilterSource::decodeNextRow()
+{
+    // PNG predictor has one byte with predictor type before each row
+    const qint64 rowSize = m_predictor.m_stride + (m_isPNG ? 1 : 0);
+    m_input.resize(rowSize);
+
+    qint64 inputSize = 0;
+    while (inputSize < rowSize)
+    {
+        const qint64 bytesRead = m_source->read(m_input.data() + inputSize, rowSize - inputSize);
+        if (bytesRead <= 0)
+        {
+            break;
+        }
+        inputSize += bytesRead;
+    }
+
+    if (inputSize == 0)
+    {
+        return false;
+    }
+
+    m_outputPosition = 0;
+    if (m_isPNG)
+    {
+        // According to the PDF specification, incomplete line is completed
+        // by zero data.
+        std::fill(m_input.begin() + inputSize, m_input.end(), 0);
+
+        m_predictor.decodePNGRow(convertByteArrayToUcharPtr(m_input), m_line, m_lineOld);
+        m_output = QByteArray(reinterpret_cast<const char*>(m_line.data() + m_pixelBytes), m_predictor.m_stride);
+        std::swap(m_line, m_lineOld);
+    }
+    else
+    {
+        m_input.resize(inputSize);
+        m_output = m_predictor.applyTIFFPredictor(m_input);
+    }
+
+    return true;
+}
+
 QByteArray PDFAsciiHexDecodeFilter::apply(const QByteArray& data,
                                           const PDFObjectFetcher& objectFetcher,
                                           const PDFObject& parameters,
@@ -384,6 +666,17 @@ QByteArray PDFFlateDecodeFilter::apply(const QByteArray& data,
     return predictor.apply(uncompress(data));
 }
 
+PDFStreamFilterSourcePointer PDFFlateDecodeFilter::createSource(PDFStreamFilterSourcePointer source,
+                                                               const PDFObjectFetcher& objectFetcher,
+                                                               const PDFObject& parameters,
+                                                               const PDFSecurityHandler* securityHandler) const
+{
+    Q_UNUSED(securityHandler);
+
+    PDFStreamPredictor predictor = PDFStreamPredictor::createPredictor(objectFetcher, parameters);
+    return predictor.createSource(std::make_unique<PDFFlateDecodeFilterSource>(qMove(source)));
+}
+
 QByteArray PDFFlateDecodeFilter::compress(const QByteArray& decompressedData)
 {
     QByteArray result;
@@ -484,61 +777,8 @@ PDFInteger PDFFlateDecodeFilter::getStreamDataLength(const QByteArray& data, PDF
 
 QByteArray PDFFlateDecodeFilter::uncompress(const QByteArray& data)
 {
-    QByteArray result;
-
-    z_stream stream = { };
-    stream.next_in = const_cast<Bytef*>(convertByteArrayToUcharPtr(data));
-    stream.avail_in = data.size();
-
-    std::array<Bytef, 1024> outputBuffer = { };
-
-    int error = inflateInit(&stream);
-    if (error != Z_OK)
-    {
-        throw PDFException(PDFTranslationContext::tr("Failed to initialize flate decompression stream."));
-    }
-
-    do
-    {
-        stream.next_out = outputBuffer.data();
-        stream.avail_out = static_cast<uInt>(outputBuffer.size());
-
-        error = inflate(&stream, Z_NO_FLUSH);
-
-        int bytesWritten = int(outputBuffer.size()) - stream.avail_out;
-        result.append(reinterpret_cast<const char*>(outputBuffer.data()), bytesWritten);
-    } while (error == Z_OK);
-
-    QString errorMessage;
-    if (stream.msg)
-    {
-        errorMessage = QString::fromLatin1(stream.msg);
-    }
-
-    inflateEnd(&stream);
-
-    switch (error)
-    {
-        case Z_STREAM_END:
-            break; // No error, normal behaviour
-
-        default:
-        {
-            const bool ignoreError = error == Z_DATA_ERROR && errorMessage == "incorrect data check";
-
-            if (!ignoreError)
-            {
-                if (errorMessage.isEmpty())
-                {
-                    errorMessage = PDFTranslationContext::tr("zlib code: %1").arg(error);
-                }
-
-                throw PDFException(PDFTranslationContext::tr("Error decompressing by flate method: %1").arg(errorMessage));
-            }
-        }
-    }
-
-    return result;
+    PDFFlateDecodeFilterSource source(std::make_unique<PDFByteArrayFilterSource>(data));
+    return source.readAll();
 }
 
 QByteArray PDFRunLengthDecodeFilter::apply(const QByteArray& data,
@@ -604,26 +844,31 @@ PDFStreamFilterStorage::StreamFilters PDFStreamFilterStorage::getStreamFilters(c
     StreamFilters result;
     const PDFDictionary* dictionary = stream->getDictionary();
 
+    static constexpr PDFNameAtom filterAtom(PDF_STREAM_DICT_FILTER);
+    static constexpr PDFNameAtom fileFilterAtom(PDF_STREAM_DICT_FILE_FILTER);
+    static constexpr PDFNameAtom decodeParmsAtom(PDF_STREAM_DICT_DECODE_PARMS);
+    static constexpr PDFNameAtom fileDecodeParmsAtom(PDF_STREAM_DICT_FDECODE_PARMS);
+
     // Retrieve filters
     PDFObject filters;
-    if (dictionary->hasKey(PDF_STREAM_DICT_FILTER))
+    if (dictionary->hasKey(filterAtom))
     {
-        filters = objectFetcher(dictionary->get(PDF_STREAM_DICT_FILTER));
+        filters = objectFetcher(dictionary->get(filterAtom));
     }
-    else if (dictionary->hasKey(PDF_STREAM_DICT_FILE_FILTER))
+    else if (dictionary->hasKey(fileFilterAtom))
     {
-        filters = objectFetcher(dictionary->get(PDF_STREAM_DICT_FILE_FILTER));
+        filters = objectFetcher(dictionary->get(fileFilterAtom));
     }
 
     // Retrieve filter parameters
     PDFObject filterParameters;
-    if (dictionary->hasKey(PDF_STREAM_DICT_DECODE_PARMS))
+    if (dictionary->hasKey(decodeParmsAtom))
     {
-        filterParameters = objectFetcher(dictionary->get(PDF_STREAM_DICT_DECODE_PARMS));
+        filterParameters = objectFetcher(dictionary->get(decodeParmsAtom));
     }
-    else if (dictionary->hasKey(PDF_STREAM_DICT_FDECODE_PARMS))
+    else if (dictionary->hasKey(fileDecodeParmsAtom))
     {
-        filterParameters = objectFetcher(dictionary->get(PDF_STREAM_DICT_FDECODE_PARMS));
+        filterParameters = objectFetcher(dictionary->get(fileDecodeParmsAtom));
     }
 
     if (filters.isName())
@@ -676,7 +921,6 @@ PDFStreamFilterStorage::StreamFilters PDFStreamFilterStorage::getStreamFilters(c
 QByteArray PDFStreamFilterStorage::getDecodedStream(const PDFStream* stream, const PDFObjectFetcher& objectFetcher, const PDFSecurityHandler* securityHandler)
 {
     StreamFilters streamFilters = getStreamFilters(stream, objectFetcher);
-    QByteArray result = *stream->getContent();
 
     if (!streamFilters.valid)
     {
@@ -684,6 +928,28 @@ QByteArray PDFStreamFilterStorage::getDecodedStream(const PDFStream* stream, con
         return QByteArray();
     }
 
+    if (std::all_of(streamFilters.filterObjects.cbegin(), streamFilters.filterObjects.cend(), [](const PDFStreamFilter* filter) { return !filter; }))
+    {
+        // Nothing to decode, content is returned without copying
+        return *stream->getContent();
+    }
+
+    PDFStreamFilterSourcePointer source = createDecodedStreamSource(stream, objectFetcher, securityHandler);
+    return source ? source->readAll() : QByteArray();
+}
+
+PDFStreamFilterSourcePointer PDFStreamFilterStorage::createDecodedStreamSource(const PDFStream* stream, const PDFObjectFetcher& objectFetcher, const PDFSecurityHandler* securityHandler)
+{
+    StreamFilters streamFilters = getStreamFilters(stream, objectFetcher);
+
+    if (!streamFilters.valid)
+    {
+        // Stream filters are invalid
+        return nullptr;
+    }
+
+    // Build chain of filters, data are pulled from the last filter in the chain
+    PDFStreamFilterSourcePointer source = std::make_unique<PDFByteArrayFilterSource>(*stream->getContent());
     for (size_t i = 0, count = streamFilters.filterObjects.size(); i < count; ++i)
     {
         const PDFStreamFilter* streamFilter = streamFilters.filterObjects[i];
@@ -691,11 +957,11 @@ QByteArray PDFStreamFilterStorage::getDecodedStream(const PDFStream* stream, con
 
         if (streamFilter)
         {
-            result = streamFilter->apply(result, objectFetcher, streamFilterParameters, securityHandler);
+            source = streamFilter->createSource(qMove(source), objectFetcher, streamFilterParameters, securityHandler);
         }
     }
 
-    return result;
+    return source;
 }
 
 QByteArray PDFStreamFilterStorage::getDecodedStream(const PDFStream* stream, const PDFSecurityHandler* securityHandler)
@@ -778,6 +1044,29 @@ PDFStreamPredictor PDFStreamPredictor::createPredictor(const PDFObjectFetcher& o
     return PDFStreamPredictor();
 }
 
+PDFStreamFilterSourcePointer PDFStreamPredictor::createSource(PDFStreamFilterSourcePointer source) const
+{
+    switch (m_predictor)
+    {
+        case NoPredictor:
+            return source;
+
+        case TIFF:
+            return std::make_unique<PDFStreamPredictorFilterSource>(qMove(source), *this);
+
+        default:
+        {
+            if (m_predictor >= 10)
+            {
+                return std::make_unique<PDFStreamPredictorFilterSource>(qMove(source), *this);
+            }
+            break;
+        }
+    }
+
+    throw PDFException(PDFTranslationContext::tr("Invalid predictor algorithm."));
+}
+
 QByteArray PDFStreamPredictor::apply(const QByteArray& data) const
 {
     switch (m_predictor)
@@ -806,97 +1095,38 @@ QByteArray PDFStreamPredictor::applyPNGPredictor(const QByteArray& data) const
     QByteArray outputData;
     outputData.reserve(data.size());
 
-    auto it = data.cbegin();
-    auto itEnd = data.cend();
-
-    int pixelBytes = (m_components * m_bitsPerComponent + 7) / 8;
-
-    auto readByte = [&it, &itEnd]() -> uint8_t
-    {
-        if (it != itEnd)
-        {
-            return static_cast<uint8_t>(*it++);
-        }
-
-        // According to the PDF specification, incomplete line is completed. For this
-        // reason, we behave as we have zero data in the buffer.
-        return 0;
-    };
+    const int pixelBytes = getPixelBytes();
+    const int rowSize = m_stride + 1;
 
     // Idea: to avoid using if for many cases, we use larger buffer filled with zeros
     const int totalBytes = m_stride + pixelBytes;
     std::vector<uint8_t> line(totalBytes, 0);
     std::vector<uint8_t> lineOld(totalBytes, 0);
+    std::vector<uint8_t> incompleteRow;
 
-    Predictor currentPredictor = m_predictor;
-    while (it != itEnd)
+    const uint8_t* input = convertByteArrayToUcharPtr(data);
+    const uint8_t* inputEnd = input + data.size();
+    while (input != inputEnd)
     {
-        // First, read the predictor data for current line
-        currentPredictor = static_cast<Predictor>(readByte() + 10);
-
-        for (int i = 0; i < m_stride; ++i)
+        const uint8_t* row = input;
+        if (inputEnd - input >= rowSize)
         {
-            uint8_t currentByte = readByte();
-
-            int lineIndex = i + pixelBytes;
-            switch (currentPredictor)
-            {
-                case PNG_Sub:
-                {
-                    line[lineIndex] = line[i] + currentByte;
-                    break;
-                }
-
-                case PNG_Up:
-                {
-                    line[lineIndex] = lineOld[lineIndex] + currentByte;
-                    break;
-                }
-
-                case PNG_Average:
-                {
-                    line[lineIndex] = (lineOld[lineIndex] + line[i]) / 2 + currentByte;
-                    break;
-                }
-
-                case PNG_Paeth:
-                {
-                    // a = left,
-                    // b = upper,
-                    // c = upper left
-                    const int a = line[i];
-                    const int b = lineOld[lineIndex];
-                    const int c = lineOld[i];
-                    const int p = a + b - c;
-                    const int pa = std::abs(p - a);
-                    const int pb = std::abs(p - b);
-                    const int pc = std::abs(p - c);
-                    if (pa <= pb && pa <= pc)
-                    {
-                        line[lineIndex] = a + currentByte;
-                    }
-                    else if (pb <= pc)
-                    {
-                        line[lineIndex] = b + currentByte;
-                    }
-                    else
-                    {
-                        line[lineIndex] = c + currentByte;
-                    }
-                    break;
-                }
+            input += rowSize;
+        }
+        else
+        {
+            // According to the PDF specification, incomplete line is completed. For this
+            // reason, we behave as we have zero data in the buffer.
+            incompleteRow.assign(input, inputEnd);
+            incompleteRow.resize(rowSize, 0);
+            row = incompleteRow.data();
+            input = inputEnd;
+        }
 
-                case PNG_None:
-                default:
-                {
-                    line[lineIndex] = currentByte;
-                    break;
-                }
-            }
+        decodePNGRow(row, line, lineOld);
 
-            // Fill the output buffer
-            outputData.push_back(static_cast<char>(line[lineIndex]));
-        }
+        // Fill the output buffer
+        outputData.append(reinterpret_cast<const char*>(line.data() + pixelBytes), m_stride);
 
         // Swap the buffers
         std::swap(line, lineOld);
@@ -905,9 +1135,50 @@ QByteArray PDFStreamPredictor::applyPNGPredictor(const QByteArray& data) const
     return outputData;
 }
 
+void PDFStreamPredictor::decodePNGRow(const uint8_t* input, std::vector<uint8_t>& line, const std::vector<uint8_t>& lineOld) const
+{
+    const int pixelBytes = getPixelBytes();
+
+    // First byte of the row is the PNG filter type
+    PDFSimdKernels::decodePNGRow(input[0], input + 1, line.data() + pixelBytes, lineOld.data() + pixelBytes, m_stride, pixelBytes);
+}
+
 QByteArray PDFStreamPredictor::applyTIFFPredictor(const QByteArray& data) const
 {
-    Q_UNUSED(data);
+    if ((m_bitsPerComponent == 8 || m_bitsPerComponent == 16) && m_stride > 0 && data.size() % m_stride == 0)
+    {
+        // Fast path for byte aligned components: whole rows are decoded in place
+        QByteArray outputData = data;
+        uint8_t* row = convertByteArrayToUcharPtr(outputData);
+        const qsizetype rowCount = outputData.size() / m_stride;
+
+        if (m_bitsPerComponent == 8)
+        {
+            // TIFF predictor for 8-bit components is the same as PNG Sub filter
+            std::vector<uint8_t> line(m_stride + m_components, 0);
+            for (qsizetype i = 0; i < rowCount; ++i, row += m_stride)
+            {
+                PDFSimdKernels::decodePNGRow(PDFSimdKernels::PNG_Sub, row, line.data() + m_components, line.data() + m_components, m_stride, m_components);
+                std::copy_n(line.data() + m_components, m_stride, row);
+            }
+        }
+        else
+        {
+            const int componentBytes = 2 * m_components;
+            for (qsizetype i = 0; i < rowCount; ++i, row += m_stride)
+            {
+                for (int j = componentBytes; j + 1 < m_stride; j += 2)
+                {
+                    const uint16_t left = (uint16_t(row[j - componentBytes]) << 8) | row[j - componentBytes + 1];
+                    const uint16_t value = left + ((uint16_t(row[j]) << 8) | row[j + 1]);
+                    row[j] = value >> 8;
+                    row[j + 1] = value & 0xFF;
+                }
+            }
+        }
+
+        return outputData;
+    }
 
     PDFBitWriter writer(m_bitsPerComponent);
     PDFBitReader reader(&data, m_bitsPerComponent);
@@ -966,6 +1237,14 @@ QByteArray PDFCryptFilter::apply(const QByteArray& data,
     return securityHandler->decryptByFilter(data, cryptFilterName, objectReference);
 }
 
+PDFStreamFilterSourcePointer PDFStreamFilter::createSource(PDFStreamFilterSourcePointer source,
+                                                          const PDFObjectFetcher& objectFetcher,
+                                                          const PDFObject& parameters,
+                                                          const PDFSecurityHandler* securityHandler) const
+{
+    return std::make_unique<PDFWholeBufferFilterSource>(qMove(source), this, objectFetcher, parameters, securityHandler);
+}
+
 PDFInteger PDFStreamFilter::getStreamDataLength(const QByteArray& data, PDFInteger offset) const
 {
     Q_UNUSED(data);
@@ -32,6 +32,31 @@ class PDFSecurityHandler;
 
 using PDFObjectFetcher = std::function<const PDFObject&(const PDFObject&)>;
 
+/// Source of (decoded) stream data. Data are pulled from the source in chunks,
+/// so filters can be chained (for example, flate decoding followed by predictor),
+/// without holding whole intermediate buffers of the chain in the memory.
+class PDF4QTLIBCORESHARED_EXPORT PDFStreamFilterSource
+{
+public:
+    explicit PDFStreamFilterSource() = default;
+    virtual ~PDFStreamFilterSource() = default;
+
+    /// Reads at most \p maxSize bytes into the \p data buffer. Returns number
+    /// of bytes read, zero is returned at the end of the data. If error occurs,
+    /// then exception is thrown.
+    /// \param data Target buffer
+    /// \param maxSize Size of the target buffer
+    virtual qint64 read(char* data, qint64 maxSize) = 0;
+
+    /// Reads all remaining data. If error occurs, then exception is thrown.
+    QByteArray readAll();
+
+    /// Size of the chunk, in which data are pulled from the sources
+    static constexpr qint64 CHUNK_SIZE = 64 * 1024;
+};
+
+using PDFStreamFilterSourcePointer = std::unique_ptr<PDFStreamFilterSource>;
+
 /// Storage for stream filters. Can retrieve stream filters by name. Using singleton
 /// design pattern. Use static methods to retrieve filters.
 class PDFStreamFilterStorage
@@ -54,6 +79,15 @@ public:
     /// \param securityHandler Security handler for Crypt filters
     static QByteArray getDecodedStream(const PDFStream* stream, const PDFSecurityHandler* securityHandler);
 
+    /// Creates source of decoded data from the stream. Data are decoded by chain
+    /// of filters in chunks, as they are read from the source. Source doesn't
+    /// reference the stream, but object fetcher and security handler must be valid,
+    /// while source is being used. If stream filters are invalid, nullptr is returned.
+    /// \param stream Stream containing the data
+    /// \param objectFetcher Function which retrieves objects (for example, reads objects from reference)
+    /// \param securityHandler Security handler for Crypt filters
+    static PDFStreamFilterSourcePointer createDecodedStreamSource(const PDFStream* stream, const PDFObjectFetcher& objectFetcher, const PDFSecurityHandler* securityHandler);
+
     /// Tries to find stream data length using given filter. Stream will
     /// start at given \p offset in \p data. If stream length cannot be determined,
     /// then -1 is returned.
@@ -99,7 +133,13 @@ public:
     /// \param data Data to be decoded using predictor
     QByteArray apply(const QByteArray& data) const;
 
+    /// Creates source, which applies the predictor to the data
+    /// pulled from the \p source row by row.
+    /// \param source Source of the data to be decoded using predictor
+    PDFStreamFilterSourcePointer createSource(PDFStreamFilterSourcePointer source) const;
+
 private:
+    friend class PDFStreamPredictorFilterSource;
 
     enum Predictor
     {
@@ -130,6 +170,16 @@ private:
     /// Applies TIFF predictor
     QByteArray applyTIFFPredictor(const QByteArray& data) const;
 
+    /// Decodes one row of the data encoded by PNG predictor. Row buffers
+    /// have \p pixelBytes leading zero bytes, so left pixel always exists.
+    /// \param input Encoded row (predictor type byte followed by row data)
+    /// \param line Decoded row
+    /// \param lineOld Previously decoded row
+    void decodePNGRow(const uint8_t* input, std::vector<uint8_t>& line, const std::vector<uint8_t>& lineOld) const;
+
+    /// Returns number of bytes per pixel (at least one byte), used by PNG predictor
+    int getPixelBytes() const { return (m_components * m_bitsPerComponent + 7) / 8; }
+
     Predictor m_predictor = NoPredictor;
     int m_components = 0;
     int m_bitsPerComponent = 0;
@@ -157,6 +207,19 @@ public:
         return apply(data, [](const PDFObject& object) -> const PDFObject& { return object; }, parameters, securityHandler);
     }
 
+    /// Creates source, which decodes data pulled from the \p source. Default
+    /// implementation reads all data from the \p source and decodes them
+    /// at once by \p apply function. Filters, which can decode data
+    /// incrementally, should reimplement this function.
+    /// \param source Source of encoded data
+    /// \param objectFetcher Function which retrieves objects (for example, reads objects from reference)
+    /// \param parameters Stream parameters
+    /// \param securityHandler Security handler
+    virtual PDFStreamFilterSourcePointer createSource(PDFStreamFilterSourcePointer source,
+                                                      const PDFObjectFetcher& objectFetcher,
+                                                      const PDFObject& parameters,
+                                                      const PDFSecurityHandler* securityHandler) const;
+
     /// Tries to find stream data length. Stream will start at given \p offset in \p data.
     /// If stream length cannot be determined, then -1 is returned.
     /// \param data Buffer data
@@ -211,6 +274,11 @@ public:
                              const PDFObject& parameters,
                              const PDFSecurityHandler* securityHandler) const override;
 
+    virtual PDFStreamFilterSourcePointer createSource(PDFStreamFilterSourcePointer source,
+                                                      const PDFObjectFetcher& objectFetcher,
+                                                      const PDFObject& parameters,
+                                                      const PDFSecurityHandler* securityHandler) const override;
+
     virtual PDFInteger getStreamDataLength(const QByteArray& data, PDFInteger offset) const override;
 
     /// Recompresses data. So, first, data are decompressed, and then
@@ -1129,24 +1129,29 @@ void PDFTextLayoutStorage::setTextLayout(PDFInteger pageIndex, const PDFTextLayo
 }
 
 PDFFindResults PDFTextLayoutStorage::find(const QString& text, Qt::CaseSensitivity caseSensitivity, PDFTextFlow::FlowFlags flowFlags) const
+{
+    return find(PDFTextLayoutFinder(text, caseSensitivity, flowFlags));
+}
+
+PDFFindResults PDFTextLayoutStorage::find(const QRegularExpression& expression, PDFTextFlow::FlowFlags flowFlags) const
+{
+    return find(PDFTextLayoutFinder(expression, flowFlags));
+}
+
+PDFFindResults PDFTextLayoutStorage::find(const PDFTextLayoutFinder& finder) const
 {
     PDFFindResults results;
 
     QMutex resultsMutex;
-    auto findImpl = [this, flowFlags, caseSensitivity, &results, &resultsMutex, &text](size_t pageIndex)
+    auto findImpl = [this, &finder, &results, &resultsMutex](size_t pageIndex)
     {
-        PDFTextLayout textLayout = getTextLayout(pageIndex);
-        PDFTextFlows textFlows = PDFTextFlow::createTextFlows(textLayout, flowFlags, pageIndex);
-        for (const PDFTextFlow& textFlow : textFlows)
-        {
-            PDFFindResults flowResults = textFlow.find(text, caseSensitivity);
+        PDFFindResults pageResults = finder.find(getTextLayout(pageIndex), pageIndex);
 
-            // Jakub Melka: Do not lock mutex, if we didn't find anything. In that case, just skip to next flow.
-            if (!flowResults.empty())
-            {
-                QMutexLocker lock(&resultsMutex);
-                results.insert(results.end(), flowResults.begin(), flowResults.end());
-            }
+        // Jakub Melka: Do not lock mutex, if we didn't find anything. In that case, just skip to next page.
+        if (!pageResults.empty())
+        {
+            QMutexLocker lock(&resultsMutex);
+            results.insert(results.end(), pageResults.begin(), pageResults.end());
         }
     };
 
@@ -1157,32 +1162,34 @@ PDFFindResults PDFTextLayoutStorage::find(const QString& text, Qt::CaseSensitivi
     return results;
 }
 
-PDFFindResults PDFTextLayoutStorage::find(const QRegularExpression& expression, PDFTextFlow::FlowFlags flowFlags) const
+PDFTextLayoutFinder::PDFTextLayoutFinder(QString text, Qt::CaseSensitivity caseSensitivity, PDFTextFlow::FlowFlags flowFlags) :
+    m_text(qMove(text)),
+    m_caseSensitivity(caseSensitivity),
+    m_isRegularExpression(false),
+    m_flowFlags(flowFlags)
 {
-    PDFFindResults results;
 
-    QMutex resultsMutex;
-    auto findImpl = [this, flowFlags, &results, &resultsMutex, &expression](size_t pageIndex)
-    {
-        PDFTextLayout textLayout = getTextLayout(pageIndex);
-        PDFTextFlows textFlows = PDFTextFlow::createTextFlows(textLayout, flowFlags, pageIndex);
-        for (const PDFTextFlow& textFlow : textFlows)
-        {
-            PDFFindResults flowResults = textFlow.find(expression);
+}
 
-            // Jakub Melka: Do not lock mutex, if we didn't find anything. In that case, just skip to next flow.
-            if (!flowResults.empty())
-            {
-                QMutexLocker lock(&resultsMutex);
-                results.insert(results.end(), flowResults.begin(), flowResults.end());
-            }
-        }
-    };
+PDFTextLayoutFinder::PDFTextLayoutFinder(QRegularExpression expression, PDFTextFlow::FlowFlags flowFlags) :
+    m_expression(qMove(expression)),
+    m_isRegularExpression(true),
+    m_flowFlags(flowFlags)
+{
 
-    auto range = PDFIntegerRange<size_t>(0, m_offsets.size());
-    PDFExecutionPolicy::execute(PDFExecutionPolicy::Scope::Page, range.begin(), range.end(), findImpl);
+}
+
+PDFFindResults PDFTextLayoutFinder::find(const PDFTextLayout& textLayout, PDFInteger pageIndex) const
+{
+    PDFFindResults results;
+
+    PDFTextFlows textFlows = PDFTextFlow::createTextFlows(textLayout, m_flowFlags, pageIndex);
+    for (const PDFTextFlow& textFlow : textFlows)
+    {
+        PDFFindResults flowResults = m_isRegularExpression ? textFlow.find(m_expression) : textFlow.find(m_text, m_caseSensitivity);
+        results.insert(results.end(), std::make_move_iterator(flowResults.begin()), std::make_move_iterator(flowResults.end()));
+    }
 
-    std::sort(results.begin(), results.end());
     return results;
 }
 
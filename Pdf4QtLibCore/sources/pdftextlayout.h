@@ -24,6 +24,7 @@
 #include <QColor>
 #include <QDataStream>
 #include <QPainterPath>
+#include <QRegularExpression>
 
 #include <set>
 #include <compare>
@@ -538,6 +539,35 @@ private:
     const PDFTextSelection* m_selection;
 };
 
+/// Finder of the text in the text layouts. It holds the search parameters,
+/// so text layouts can be searched page by page, as they become available.
+class PDF4QTLIBCORESHARED_EXPORT PDFTextLayoutFinder
+{
+public:
+    /// Creates finder of the simple text
+    /// \param text Text to be found
+    /// \param caseSensitivity Case sensitivity
+    /// \param flowFlags Text flow flags
+    explicit PDFTextLayoutFinder(QString text, Qt::CaseSensitivity caseSensitivity, PDFTextFlow::FlowFlags flowFlags);
+
+    /// Creates finder of the regular expression matches
+    /// \param expression Regular expression to be matched
+    /// \param flowFlags Text flow flags
+    explicit PDFTextLayoutFinder(QRegularExpression expression, PDFTextFlow::FlowFlags flowFlags);
+
+    /// Finds all occurences in the text layout of the page
+    /// \param textLayout Text layout
+    /// \param pageIndex Page index
+    PDFFindResults find(const PDFTextLayout& textLayout, PDFInteger pageIndex) const;
+
+private:
+    QString m_text;
+    Qt::CaseSensitivity m_caseSensitivity = Qt::CaseSensitive;
+    QRegularExpression m_expression;
+    bool m_isRegularExpression = false;
+    PDFTextFlow::FlowFlags m_flowFlags = PDFTextFlow::None;
+};
+
 /// Storage for text layouts. For reading and writing, this object is thread safe.
 /// For writing, mutex is used to synchronize asynchronous writes, for reading
 /// no mutex is used at all. For this reason, both reading/writing at the same time
@@ -582,6 +612,10 @@ public:
     /// \param flowFlags Text flow flags
     PDFFindResults find(const QRegularExpression& expression, PDFTextFlow::FlowFlags flowFlags) const;
 
+    /// Finds all occurences in all pages using the finder
+    /// \param finder Finder
+    PDFFindResults find(const PDFTextLayoutFinder& finder) const;
+
     /// Returns number of pages
     size_t getCount() const { return m_offsets.size(); }
 
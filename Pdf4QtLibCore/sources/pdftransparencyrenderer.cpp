@@ -275,15 +275,10 @@ PDFFloatBitmap PDFFloatBitmap::extractOpacityChannel() const
     if (m_format.hasOpacityChannel())
     {
         const uint8_t opacityChannel = m_format.getOpacityChannelIndex();
-        for (size_t x = 0; x < getWidth(); ++x)
+        const PDFColorComponent* sourcePixel = begin() + opacityChannel;
+        for (PDFColorComponent* targetPixel = result.begin(); targetPixel != result.end(); ++targetPixel, sourcePixel += m_pixelSize)
         {
-            for (size_t y = 0; y < getHeight(); ++y)
-            {
-                PDFConstColorBuffer sourceProcessColorBuffer = getPixel(x, y);
-                PDFColorBuffer targetProcessColorBuffer = result.getPixel(x, y);
-
-                targetProcessColorBuffer[0] = sourceProcessColorBuffer[opacityChannel];
-            }
+            *targetPixel = *sourcePixel;
         }
     }
     else
@@ -299,57 +294,32 @@ PDFFloatBitmap PDFFloatBitmap::extractLuminosityChannel() const
     PDFFloatBitmap result(getWidth(), getHeight(), PDFPixelFormat::createOpacityMask());
 
     const uint8_t sourceChannelIndex = m_format.getProcessColorChannelIndexStart();
+    auto extractLuminosity = [this, &result, sourceChannelIndex](auto getLuminosity)
+    {
+        const PDFColorComponent* sourcePixel = begin() + sourceChannelIndex;
+        for (PDFColorComponent* targetPixel = result.begin(); targetPixel != result.end(); ++targetPixel, sourcePixel += m_pixelSize)
+        {
+            *targetPixel = getLuminosity(sourcePixel);
+        }
+    };
+
     switch (m_format.getProcessColorChannelCount())
     {
         case 1:
         {
-            for (size_t x = 0; x < getWidth(); ++x)
-            {
-                for (size_t y = 0; y < getHeight(); ++y)
-                {
-                    PDFConstColorBuffer sourceProcessColorBuffer = getPixel(x, y);
-                    PDFColorBuffer targetProcessColorBuffer = result.getPixel(x, y);
-
-                    targetProcessColorBuffer[0] = PDFBlendFunction::getLuminosity(PDFGray(sourceProcessColorBuffer[sourceChannelIndex]));
-                }
-            }
+            extractLuminosity([](const PDFColorComponent* pixel) { return PDFBlendFunction::getLuminosity(PDFGray(pixel[0])); });
             break;
         }
 
         case 3:
         {
-            for (size_t x = 0; x < getWidth(); ++x)
-            {
-                for (size_t y = 0; y < getHeight(); ++y)
-                {
-                    PDFConstColorBuffer sourceProcessColorBuffer = getPixel(x, y);
-                    PDFColorBuffer targetProcessColorBuffer = result.getPixel(x, y);
-
-                    PDFColorComponent r = sourceProcessColorBuffer[sourceChannelIndex + 0];
-                    PDFColorComponent g = sourceProcessColorBuffer[sourceChannelIndex + 1];
-                    PDFColorComponent b = sourceProcessColorBuffer[sourceChannelIndex + 2];
-                    targetProcessColorBuffer[0] = PDFBlendFunction::getLuminosity(PDFRGB{ r, g, b });
-                }
-            }
+            extractLuminosity([](const PDFColorComponent* pixel) { return PDFBlendFunction::getLuminosity(PDFRGB{ pixel[0], pixel[1], pixel[2] }); });
             break;
         }
 
         case 4:
         {
-            for (size_t x = 0; x < getWidth(); ++x)
-            {
-                for (size_t y = 0; y < getHeight(); ++y)
-                {
-                    PDFConstColorBuffer sourceProcessColorBuffer = getPixel(x, y);
-                    PDFColorBuffer targetProcessColorBuffer = result.getPixel(x, y);
-
-                    PDFColorComponent _c = sourceProcessColorBuffer[sourceChannelIndex + 0];
-                    PDFColorComponent _m = sourceProcessColorBuffer[sourceChannelIndex + 1];
-                    PDFColorComponent _y = sourceProcessColorBuffer[sourceChannelIndex + 2];
-                    PDFColorComponent _k = sourceProcessColorBuffer[sourceChannelIndex + 3];
-                    targetProcessColorBuffer[0] = PDFBlendFunction::getLuminosity(PDFCMYK{ _c, _m, _y, _k });
-                }
-            }
+            extractLuminosity([](const PDFColorComponent* pixel) { return PDFBlendFunction::getLuminosity(PDFCMYK{ pixel[0], pixel[1], pixel[2], pixel[3] }); });
             break;
         }
 
@@ -363,15 +333,10 @@ PDFFloatBitmap PDFFloatBitmap::extractLuminosityChannel() const
     if (m_format.hasOpacityChannel())
     {
         const uint8_t opacityChannel = m_format.getOpacityChannelIndex();
-        for (size_t x = 0; x < getWidth(); ++x)
+        const PDFColorComponent* sourcePixel = begin() + opacityChannel;
+        for (PDFColorComponent* targetPixel = result.begin(); targetPixel != result.end(); ++targetPixel, sourcePixel += m_pixelSize)
         {
-            for (size_t y = 0; y < getHeight(); ++y)
-            {
-                PDFConstColorBuffer sourceProcessColorBuffer = getPixel(x, y);
-                PDFColorBuffer targetProcessColorBuffer = result.getPixel(x, y);
-
-                targetProcessColorBuffer[0] = sourceProcessColorBuffer[opacityChannel];
-            }
+            *targetPixel = *sourcePixel;
         }
     }
     else
@@ -524,6 +489,8 @@ void PDFFloatBitmap::blend(const PDFFloatBitmap& source,
     Q_ASSERT(source.getWidth() == blendSoftMask.getWidth());
     Q_ASSERT(source.getHeight() == blendSoftMask.getHeight());
     Q_ASSERT(blendSoftMask.getPixelFormat() == PDFPixelFormat::createOpacityMask());
+    Q_ASSERT(source.getPixelSize() == backdrop.getPixelSize());
+    Q_ASSERT(source.getPixelSize() == initialBackdrop.getPixelSize());
 
     Q_ASSERT(blendRegion.left() >= 0);
     Q_ASSERT(blendRegion.top() >= 0);
@@ -539,8 +506,8 @@ void PDFFloatBitmap::blend(const PDFFloatBitmap& source,
     const uint8_t processColorChannelEnd = pixelFormat.getProcessColorChannelIndexEnd();
     const uint8_t spotColorChannelStart = pixelFormat.getSpotColorChannelIndexStart();
     const uint8_t spotColorChannelEnd = pixelFormat.getSpotColorChannelIndexEnd();
-    std::vector<PDFColorComponent> B_i(source.getPixelSize(), 0.0f);
-    std::vector<BlendMode> channelBlendModes(source.getPixelSize(), mode);
+    const size_t pixelSize = source.getPixelSize();
+    std::vector<BlendMode> channelBlendModes(pixelSize, mode);
 
     // For blending spot colors, only white preserving blend modes are possible.
     // If this is not the case, revert spot color blend mode to normal blending.
@@ -629,17 +596,65 @@ void PDFFloatBitmap::blend(const PDFFloatBitmap& source,
         return channelBlendModes[channel];
     };
 
-    for (int x = blendRegion.left(); x <= blendRegion.right(); ++x)
+    if (blendRegion.isEmpty())
+    {
+        return;
+    }
+
+    // Blended colors (B_i) are calculated for a whole row of the blend region at once.
+    // Separable blend modes without overprinting do not depend on the pixel, so
+    // the row is blended in bulk by kernel specialized for the blend mode.
+    // Spot colors are blended separately only, if their blend mode or
+    // subtractivity differs from the process colors. Other cases (overprinting,
+    // non-separable blend modes) are blended pixel by pixel.
+    const size_t regionLeft = blendRegion.left();
+    const size_t regionWidth = blendRegion.width();
+    const bool isProcessColorSubtractive = pixelFormat.hasProcessColorsSubtractive();
+    const bool isSpotColorSubtractive = pixelFormat.hasSpotColorsSubtractive();
+    const bool isBulkBlend = PDFBlendModeInfo::isSeparable(mode) && overprintMode == OverprintMode::NoOveprint;
+    const bool isRowSubtractive = pixelFormat.hasProcessColors() ? isProcessColorSubtractive : isSpotColorSubtractive;
+    const BlendMode spotColorBlendMode = pixelFormat.hasSpotColors() ? channelBlendModes[spotColorChannelStart] : mode;
+    const bool isSpotColorBlendedSeparately = pixelFormat.hasSpotColors() && (spotColorBlendMode != mode || isSpotColorSubtractive != isRowSubtractive);
+    const size_t softMaskPixelSize = blendSoftMask.getPixelSize();
+
+    std::vector<PDFColorComponent> blendedRow(regionWidth * pixelSize, 0.0f);
+
+    for (int y = blendRegion.top(); y <= blendRegion.bottom(); ++y)
     {
-        for (int y = blendRegion.top(); y <= blendRegion.bottom(); ++y)
+        const PDFColorComponent* sourceRow = source.begin() + source.getPixelIndex(regionLeft, y);
+        const PDFColorComponent* backdropRow = backdrop.begin() + backdrop.getPixelIndex(regionLeft, y);
+        const PDFColorComponent* initialBackdropRow = initialBackdrop.begin() + initialBackdrop.getPixelIndex(regionLeft, y);
+        const PDFColorComponent* softMaskRow = blendSoftMask.begin() + blendSoftMask.getPixelIndex(regionLeft, y);
+        PDFColorComponent* targetRow = target.begin() + target.getPixelIndex(regionLeft, y);
+
+        if (isBulkBlend)
         {
-            PDFConstColorBuffer sourceColor = source.getPixel(x, y);
-            PDFColorBuffer targetColor = target.getPixel(x, y);
-            PDFConstColorBuffer backdropColor = backdrop.getPixel(x, y);
-            PDFConstColorBuffer initialBackdropColor = initialBackdrop.getPixel(x, y);
-            PDFConstColorBuffer alphaColorBuffer = blendSoftMask.getPixel(x, y);
+            // Blend all channels of the row in one pass (blended values of shape
+            // and opacity channels are ignored), then correct spot colors, if needed.
+            PDFBlendFunction::blendRow(mode, isRowSubtractive, backdropRow, sourceRow, blendedRow.data(), blendedRow.size());
 
-            const PDFColorComponent softMaskValue = alphaColorBuffer[0];
+            if (isSpotColorBlendedSeparately)
+            {
+                const size_t spotColorChannelCount = spotColorChannelEnd - spotColorChannelStart;
+                for (size_t offset = spotColorChannelStart; offset < blendedRow.size(); offset += pixelSize)
+                {
+                    PDFBlendFunction::blendRow(spotColorBlendMode, isSpotColorSubtractive, backdropRow + offset, sourceRow + offset, blendedRow.data() + offset, spotColorChannelCount);
+                }
+            }
+        }
+
+        for (size_t column = 0; column < regionWidth; ++column)
+        {
+            const size_t x = regionLeft + column;
+            const size_t offset = column * pixelSize;
+
+            PDFConstColorBuffer sourceColor(sourceRow + offset, pixelSize);
+            PDFColorBuffer targetColor(targetRow + offset, pixelSize);
+            PDFConstColorBuffer backdropColor(backdropRow + offset, pixelSize);
+            PDFConstColorBuffer initialBackdropColor(initialBackdropRow + offset, pixelSize);
+            PDFColorBuffer B_i(blendedRow.data() + offset, pixelSize);
+
+            const PDFColorComponent softMaskValue = softMaskRow[column * softMaskPixelSize];
             const PDFColorComponent f_j_i = sourceColor[shapeChannel];
             const PDFColorComponent f_m_i = alphaIsShape ? softMaskValue : 1.0f;
             const PDFColorComponent f_k_i = alphaIsShape ? constantAlpha : 1.0f;
@@ -684,147 +699,153 @@ void PDFFloatBitmap::blend(const PDFFloatBitmap& source,
                 target.markPixelActiveColorMask(x, y, activeColorChannels);
             }
 
-            std::fill(B_i.begin(), B_i.end(), 0.0f);
-
-            // Calculate blended pixel
-            if (PDFBlendModeInfo::isSeparable(mode))
+            if (!isBulkBlend)
             {
-                // Separable blend mode - process each color separately
-                const bool isProcessColorSubtractive = pixelFormat.hasProcessColorsSubtractive();
-                const bool isSpotColorSubtractive = pixelFormat.hasSpotColorsSubtractive();
+                std::fill(B_i.begin(), B_i.end(), 0.0f);
 
-                if (pixelFormat.hasProcessColors())
+                // Calculate blended pixel
+                if (PDFBlendModeInfo::isSeparable(mode))
                 {
-                    if (!isProcessColorSubtractive)
+                    // Separable blend mode - process each color separately
+                    if (pixelFormat.hasProcessColors())
                     {
-                        for (uint8_t i = processColorChannelStart; i < processColorChannelEnd; ++i)
+                        if (!isProcessColorSubtractive)
                         {
-                            const BlendMode pixelBlendMode = getBlendModeForPixel(x, y, i);
-                            B_i[i] = PDFBlendFunction::blend(pixelBlendMode, backdropColor[i], sourceColor[i]);
+                            for (uint8_t i = processColorChannelStart; i < processColorChannelEnd; ++i)
+                            {
+                                const BlendMode pixelBlendMode = getBlendModeForPixel(x, y, i);
+                                B_i[i] = PDFBlendFunction::blend(pixelBlendMode, backdropColor[i], sourceColor[i]);
+                            }
                         }
-                    }
-                    else
-                    {
-                        for (uint8_t i = processColorChannelStart; i < processColorChannelEnd; ++i)
+                        else
                         {
-                            const BlendMode pixelBlendMode = getBlendModeForPixel(x, y, i);
-                            B_i[i] = 1.0f - PDFBlendFunction::blend(pixelBlendMode, 1.0f - backdropColor[i], 1.0f - sourceColor[i]);
+                            for (uint8_t i = processColorChannelStart; i < processColorChannelEnd; ++i)
+                            {
+                                const BlendMode pixelBlendMode = getBlendModeForPixel(x, y, i);
+                                B_i[i] = 1.0f - PDFBlendFunction::blend(pixelBlendMode, 1.0f - backdropColor[i], 1.0f - sourceColor[i]);
+                            }
                         }
                     }
-                }
 
-                if (pixelFormat.hasSpotColors())
-                {
-
-                    if (!isSpotColorSubtractive)
+                    if (pixelFormat.hasSpotColors())
                     {
-                        for (uint8_t i = spotColorChannelStart; i < spotColorChannelEnd; ++i)
+
+                        if (!isSpotColorSubtractive)
                         {
-                            const BlendMode pixelBlendMode = getBlendModeForPixel(x, y, i);
-                            B_i[i] = PDFBlendFunction::blend(pixelBlendMode, backdropColor[i], sourceColor[i]);
+                            for (uint8_t i = spotColorChannelStart; i < spotColorChannelEnd; ++i)
+                            {
+                                const BlendMode pixelBlendMode = getBlendModeForPixel(x, y, i);
+                                B_i[i] = PDFBlendFunction::blend(pixelBlendMode, backdropColor[i], sourceColor[i]);
+                            }
                         }
-                    }
-                    else
-                    {
-                        for (uint8_t i = spotColorChannelStart; i < spotColorChannelEnd; ++i)
+                        else
                         {
-                            const BlendMode pixelBlendMode = getBlendModeForPixel(x, y, i);
-                            B_i[i] = 1.0f - PDFBlendFunction::blend(pixelBlendMode, 1.0f - backdropColor[i], 1.0f - sourceColor[i]);
+                            for (uint8_t i = spotColorChannelStart; i < spotColorChannelEnd; ++i)
+                            {
+                                const BlendMode pixelBlendMode = getBlendModeForPixel(x, y, i);
+                                B_i[i] = 1.0f - PDFBlendFunction::blend(pixelBlendMode, 1.0f - backdropColor[i], 1.0f - sourceColor[i]);
+                            }
                         }
                     }
                 }
-            }
-            else
-            {
-                // Nonseparable blend mode - process colors together
-                if (pixelFormat.hasProcessColors())
+                else
                 {
-                    switch (pixelFormat.getProcessColorChannelCount())
+                    // Nonseparable blend mode - process colors together
+                    if (pixelFormat.hasProcessColors())
                     {
-                        case 1:
+                        switch (pixelFormat.getProcessColorChannelCount())
                         {
-                            // Gray
-                            const PDFGray Cb = backdropColor[processColorChannelStart];
-                            const PDFGray Cs = sourceColor[processColorChannelStart];
-                            const PDFGray blended = PDFBlendFunction::blend_Nonseparable(mode, Cb, Cs);
-                            B_i[pixelFormat.getProcessColorChannelIndexStart()] = blended;
-                            break;
-                        }
+                            case 1:
+                            {
+                                // Gray
+                                const PDFGray Cb = backdropColor[processColorChannelStart];
+                                const PDFGray Cs = sourceColor[processColorChannelStart];
+                                const PDFGray blended = PDFBlendFunction::blend_Nonseparable(mode, Cb, Cs);
+                                B_i[pixelFormat.getProcessColorChannelIndexStart()] = blended;
+                                break;
+                            }
 
-                        case 3:
-                        {
-                            // RGB
-                            const PDFRGB Cb = { backdropColor[processColorChannelStart + 0],
-                                                backdropColor[processColorChannelStart + 1],
-                                                backdropColor[processColorChannelStart + 2] };
-                            const PDFRGB Cs = { sourceColor[processColorChannelStart + 0],
-                                                sourceColor[processColorChannelStart + 1],
-                                                sourceColor[processColorChannelStart + 2] };
-                            const PDFRGB blended = PDFBlendFunction::blend_Nonseparable(mode, Cb, Cs);
-                            B_i[processColorChannelStart + 0] = blended[0];
-                            B_i[processColorChannelStart + 1] = blended[1];
-                            B_i[processColorChannelStart + 2] = blended[2];
-                            break;
-                        }
+                            case 3:
+                            {
+                                // RGB
+                                const PDFRGB Cb = { backdropColor[processColorChannelStart + 0],
+                                                    backdropColor[processColorChannelStart + 1],
+                                                    backdropColor[processColorChannelStart + 2] };
+                                const PDFRGB Cs = { sourceColor[processColorChannelStart + 0],
+                                                    sourceColor[processColorChannelStart + 1],
+                                                    sourceColor[processColorChannelStart + 2] };
+                                const PDFRGB blended = PDFBlendFunction::blend_Nonseparable(mode, Cb, Cs);
+                                B_i[processColorChannelStart + 0] = blended[0];
+                                B_i[processColorChannelStart + 1] = blended[1];
+                                B_i[processColorChannelStart + 2] = blended[2];
+                                break;
+                            }
 
-                        case 4:
-                        {
-                            // CMYK
-                            const PDFCMYK Cb = { backdropColor[processColorChannelStart + 0],
-                                                 backdropColor[processColorChannelStart + 1],
-                                                 backdropColor[processColorChannelStart + 2],
-                                                 backdropColor[processColorChannelStart + 3] };
-                            const PDFCMYK Cs = { sourceColor[processColorChannelStart + 0],
-                                                 sourceColor[processColorChannelStart + 1],
-                                                 sourceColor[processColorChannelStart + 2],
-                                                 sourceColor[processColorChannelStart + 3] };
-                            const PDFCMYK blended = PDFBlendFunction::blend_Nonseparable(mode, Cb, Cs);
-                            B_i[processColorChannelStart + 0] = blended[0];
-                            B_i[processColorChannelStart + 1] = blended[1];
-                            B_i[processColorChannelStart + 2] = blended[2];
-                            B_i[processColorChannelStart + 3] = blended[3];
-                            break;
-                        }
+                            case 4:
+                            {
+                                // CMYK
+                                const PDFCMYK Cb = { backdropColor[processColorChannelStart + 0],
+                                                     backdropColor[processColorChannelStart + 1],
+                                                     backdropColor[processColorChannelStart + 2],
+                                                     backdropColor[processColorChannelStart + 3] };
+                                const PDFCMYK Cs = { sourceColor[processColorChannelStart + 0],
+                                                     sourceColor[processColorChannelStart + 1],
+                                                     sourceColor[processColorChannelStart + 2],
+                                                     sourceColor[processColorChannelStart + 3] };
+                                const PDFCMYK blended = PDFBlendFunction::blend_Nonseparable(mode, Cb, Cs);
+                                B_i[processColorChannelStart + 0] = blended[0];
+                                B_i[processColorChannelStart + 1] = blended[1];
+                                B_i[processColorChannelStart + 2] = blended[2];
+                                B_i[processColorChannelStart + 3] = blended[3];
+                                break;
+                            }
 
-                        default:
-                        {
-                            // This is a serious error. Blended buffer remains unchanged (zero)
-                            Q_ASSERT(false);
-                            break;
+                            default:
+                            {
+                                // This is a serious error. Blended buffer remains unchanged (zero)
+                                Q_ASSERT(false);
+                                break;
+                            }
                         }
                     }
-                }
 
-                if (pixelFormat.hasSpotColors())
-                {
-                    const bool isSpotColorSubtractive = pixelFormat.hasSpotColorsSubtractive();
-                    if (!isSpotColorSubtractive)
+                    if (pixelFormat.hasSpotColors())
                     {
-                        for (uint8_t i = spotColorChannelStart; i < spotColorChannelEnd; ++i)
+                        if (!isSpotColorSubtractive)
                         {
-                            const BlendMode pixelBlendMode = getBlendModeForPixel(x, y, i);
-                            B_i[i] = PDFBlendFunction::blend(pixelBlendMode, backdropColor[i], sourceColor[i]);
+                            for (uint8_t i = spotColorChannelStart; i < spotColorChannelEnd; ++i)
+                            {
+                                const BlendMode pixelBlendMode = getBlendModeForPixel(x, y, i);
+                                B_i[i] = PDFBlendFunction::blend(pixelBlendMode, backdropColor[i], sourceColor[i]);
+                            }
                         }
-                    }
-                    else
-                    {
-                        for (uint8_t i = spotColorChannelStart; i < spotColorChannelEnd; ++i)
+                        else
                         {
-                            const BlendMode pixelBlendMode = getBlendModeForPixel(x, y, i);
-                            B_i[i] = 1.0f - PDFBlendFunction::blend(pixelBlendMode, 1.0f - backdropColor[i], 1.0f - sourceColor[i]);
+                            for (uint8_t i = spotColorChannelStart; i < spotColorChannelEnd; ++i)
+                            {
+                                const BlendMode pixelBlendMode = getBlendModeForPixel(x, y, i);
+                                B_i[i] = 1.0f - PDFBlendFunction::blend(pixelBlendMode, 1.0f - backdropColor[i], 1.0f - sourceColor[i]);
+                            }
                         }
                     }
                 }
+
             }
 
+            // Coefficients of the compositing formula are same for all color channels
+            const PDFColorComponent backdropCoefficient = (f_s_i - alpha_s_i) * alpha_b;
+            const PDFColorComponent sourceCoefficient = alpha_s_i * (1.0f - alpha_b);
+            const PDFColorComponent blendedCoefficient = alpha_s_i * alpha_b;
+            const PDFColorComponent immediateCoefficient = (1.0f - f_s_i) * alpha_i_1;
+
             for (uint8_t i = colorChannelStart; i < colorChannelEnd; ++i)
             {
                 const PDFColorComponent C_s_i = sourceColor[i];
                 const PDFColorComponent C_b = backdropColor[i];
                 const PDFColorComponent C_i_1 = targetColor[i];
 
-                PDFColorComponent C_t = (f_s_i - alpha_s_i) * alpha_b * C_b + alpha_s_i * ((1.0f - alpha_b) * C_s_i + alpha_b * B_i[i]);
-                PDFColorComponent C_i = ((1.0f - f_s_i) * alpha_i_1 * C_i_1 + C_t) / alpha_i;
+                PDFColorComponent C_t = backdropCoefficient * C_b + sourceCoefficient * C_s_i + blendedCoefficient * B_i[i];
+                PDFColorComponent C_i = (immediateCoefficient * C_i_1 + C_t) / alpha_i;
 
                 targetColor[i] = C_i;
             }
@@ -842,20 +863,29 @@ void PDFFloatBitmap::blendConvertedSpots(const PDFFloatBitmap& convertedSpotColo
     const uint8_t processColorChannelStart = m_format.getProcessColorChannelIndexStart();
     const uint8_t processColorChannelEnd = m_format.getProcessColorChannelIndexEnd();
 
-    const PDFColorComponent* sourcePixel = convertedSpotColors.begin();
-    for (PDFColorComponent* targetPixel = begin(); targetPixel != end(); targetPixel += m_pixelSize, sourcePixel+= convertedSpotColors.getPixelSize())
+    const size_t sourcePixelSize = convertedSpotColors.getPixelSize();
+
+    // Subtractive colors are blended using union (equals to Multiply blend mode
+    // on inverted colors), additive colors using Multiply blend mode.
+    auto blendPixels = [this, processColorChannelStart, processColorChannelEnd, sourcePixelSize, &convertedSpotColors](auto blendFunction)
     {
-        for (uint8_t i = processColorChannelStart; i < processColorChannelEnd; ++i)
+        const PDFColorComponent* sourcePixel = convertedSpotColors.begin();
+        for (PDFColorComponent* targetPixel = begin(); targetPixel != end(); targetPixel += m_pixelSize, sourcePixel += sourcePixelSize)
         {
-            if (m_format.hasProcessColorsSubtractive())
+            for (uint8_t i = processColorChannelStart; i < processColorChannelEnd; ++i)
             {
-                targetPixel[i] = PDFBlendFunction::blend_Union(targetPixel[i], sourcePixel[i]);
-            }
-            else
-            {
-                targetPixel[i] = targetPixel[i] * sourcePixel[i];
+                targetPixel[i] = blendFunction(targetPixel[i], sourcePixel[i]);
             }
         }
+    };
+
+    if (m_format.hasProcessColorsSubtractive())
+    {
+        blendPixels([](PDFColorComponent Cb, PDFColorComponent Cs) { return PDFBlendFunction::blend_Union(Cb, Cs); });
+    }
+    else
+    {
+        blendPixels([](PDFColorComponent Cb, PDFColorComponent Cs) { return PDFBlendFunction::blend<BlendMode::Multiply>(Cb, Cs); });
     }
 }
 
@@ -2132,43 +2162,26 @@ void PDFTransparencyRenderer::performPathPainting(const QPainterPath& path, bool
             PDFPainterPathSampler pathSampler(worldPath, m_settings.samplesCount, 0.0f, fillRect, m_settings.flags.testFlag(PDFTransparencyRendererSettings::PrecisePathSampler));
             const PDFMappedColor& fillColor = getMappedFillColor();
 
+            // Only pixels covered by the path spans are processed
+            auto processPixel = [&, this](int x, int y)
+            {
+                performPixelSampling(shapeFilling, opacityFilling, shapeChannel, opacityChannel, colorChannelStart, colorChannelEnd, x, y, fillColor, clipSampler, pathSampler);
+            };
+            auto processRow = [&](int y)
+            {
+                pathSampler.forEachSampledPixelInRow(y, processPixel);
+            };
+
             if (isMultithreadedPathSamplingUsed(fillRect))
             {
-                if (fillRect.width() > fillRect.height())
-                {
-                    // Columns
-                    PDFIntegerRange<int> range(fillRect.left(), fillRect.right() + 1);
-                    auto processEntry = [&, this](int x)
-                    {
-                        for (int y = fillRect.top(); y <= fillRect.bottom(); ++y)
-                        {
-                            performPixelSampling(shapeFilling, opacityFilling, shapeChannel, opacityChannel, colorChannelStart, colorChannelEnd, x, y, fillColor, clipSampler, pathSampler);
-                        }
-                    };
-                    PDFExecutionPolicy::execute(PDFExecutionPolicy::Scope::Content, range.begin(), range.end(), processEntry);
-                }
-                else
-                {
-                    // Rows
-                    PDFIntegerRange<int> range(fillRect.top(), fillRect.bottom() + 1);
-                    auto processEntry = [&, this](int y)
-                    {
-                        for (int x = fillRect.left(); x <= fillRect.right(); ++x)
-                        {
-                            performPixelSampling(shapeFilling, opacityFilling, shapeChannel, opacityChannel, colorChannelStart, colorChannelEnd, x, y, fillColor, clipSampler, pathSampler);
-                        }
-                    };
-                    PDFExecutionPolicy::execute(PDFExecutionPolicy::Scope::Content, range.begin(), range.end(), processEntry);
-                }
+                PDFIntegerRange<int> range(fillRect.top(), fillRect.bottom() + 1);
+                PDFExecutionPolicy::execute(PDFExecutionPolicy::Scope::Content, range.begin(), range.end(), processRow);
             }
             else
             {
-                for (int x = fillRect.left(); x <= fillRect.right(); ++x)
+                for (int y = fillRect.top(); y <= fillRect.bottom(); ++y)
                 {
-                    for (int y = fillRect.top(); y <= fillRect.bottom(); ++y)
-                    {
-                        performPixelSampling(shapeFilling, opacityFilling, shapeChannel, opacityChannel, colorChannelStart, colorChannelEnd, x, y, fillColor, clipSampler, pathSampler);
-                    }
+                    processRow(y);
                 }
             }
 
@@ -2204,43 +2217,25 @@ void PDFTransparencyRenderer::performPathPainting(const QPainterPath& path, bool
             PDFPainterPathSampler pathSampler(worldPath, m_settings.samplesCount, 0.0f, strokeRect, m_settings.flags.testFlag(PDFTransparencyRendererSettings::PrecisePathSampler));
             const PDFMappedColor& strokeColor = getMappedStrokeColor();
 
+            auto processPixel = [&, this](int x, int y)
+            {
+                performPixelSampling(shapeStroking, opacityStroking, shapeChannel, opacityChannel, colorChannelStart, colorChannelEnd, x, y, strokeColor, clipSampler, pathSampler);
+            };
+            auto processRow = [&](int y)
+            {
+                pathSampler.forEachSampledPixelInRow(y, processPixel);
+            };
+
             if (isMultithreadedPathSamplingUsed(strokeRect))
             {
-                if (strokeRect.width() > strokeRect.height())
-                {
-                    // Columns
-                    PDFIntegerRange<int> range(strokeRect.left(), strokeRect.right() + 1);
-                    auto processEntry = [&, this](int x)
-                    {
-                        for (int y = strokeRect.top(); y <= strokeRect.bottom(); ++y)
-                        {
-                            performPixelSampling(shapeStroking, opacityStroking, shapeChannel, opacityChannel, colorChannelStart, colorChannelEnd, x, y, strokeColor, clipSampler, pathSampler);
-                        }
-                    };
-                    PDFExecutionPolicy::execute(PDFExecutionPolicy::Scope::Content, range.begin(), range.end(), processEntry);
-                }
-                else
-                {
-                    // Rows
-                    PDFIntegerRange<int> range(strokeRect.top(), strokeRect.bottom() + 1);
-                    auto processEntry = [&, this](int y)
-                    {
-                        for (int x = strokeRect.left(); x <= strokeRect.right(); ++x)
-                        {
-                            performPixelSampling(shapeStroking, opacityStroking, shapeChannel, opacityChannel, colorChannelStart, colorChannelEnd, x, y, strokeColor, clipSampler, pathSampler);
-                        }
-                    };
-                    PDFExecutionPolicy::execute(PDFExecutionPolicy::Scope::Content, range.begin(), range.end(), processEntry);
-                }
+                PDFIntegerRange<int> range(strokeRect.top(), strokeRect.bottom() + 1);
+                PDFExecutionPolicy::execute(PDFExecutionPolicy::Scope::Content, range.begin(), range.end(), processRow);
             }
             else
             {
-                for (int x = strokeRect.left(); x <= strokeRect.right(); ++x)
+                for (int y = strokeRect.top(); y <= strokeRect.bottom(); ++y)
                 {
-                    for (int y = strokeRect.top(); y <= strokeRect.bottom(); ++y)
-                    {
-                        performPixelSampling(shapeStroking, opacityStroking, shapeChannel, opacityChannel, colorChannelStart, colorChannelEnd, x, y, strokeColor, clipSampler, pathSampler);
-                    }
+                    processRow(y);
                 }
             }
 
@@ -2352,39 +2347,41 @@ bool PDFTransparencyRenderer::performPathPaintingUsingShading(const QPainterPath
     const uint32_t colorChannelStart = drawBufferPixelFormat.getColorChannelIndexStart();
     const uint32_t colorChannelEnd = drawBufferPixelFormat.getColorChannelIndexEnd();
 
-    for (int x = fillRect.left(); x <= fillRect.right(); ++x)
+    auto processPixel = [&](int x, int y)
     {
-        for (int y = fillRect.top(); y <= fillRect.bottom(); ++y)
-        {
-            const int texelCoordinateX = x - fillRect.left();
-            const int texelCoordinateY = y - fillRect.top();
-            PDFColorBuffer texel = texture.getPixel(texelCoordinateX, texelCoordinateY);
+        const int texelCoordinateX = x - fillRect.left();
+        const int texelCoordinateY = y - fillRect.top();
+        PDFColorBuffer texel = texture.getPixel(texelCoordinateX, texelCoordinateY);
 
-            const PDFColorComponent textureShape = texel[drawBufferShapeChannel];
-            const PDFColorComponent textureOpacity = texel[drawBufferOpacityChannel];
-            const PDFColorComponent clipValue = clipSampler.sample(QPoint(x, y));
-            const PDFColorComponent objectShapeValue = pathSampler.sample(QPoint(x, y));
-            const PDFColorComponent shapeValue = objectShapeValue * clipValue * constantShape * textureShape;
-            const PDFColorComponent opacityValue = shapeValue * constantOpacity * textureOpacity;
+        const PDFColorComponent textureShape = texel[drawBufferShapeChannel];
+        const PDFColorComponent textureOpacity = texel[drawBufferOpacityChannel];
+        const PDFColorComponent clipValue = clipSampler.sample(QPoint(x, y));
+        const PDFColorComponent objectShapeValue = pathSampler.sample(QPoint(x, y));
+        const PDFColorComponent shapeValue = objectShapeValue * clipValue * constantShape * textureShape;
+        const PDFColorComponent opacityValue = shapeValue * constantOpacity * textureOpacity;
 
-            if (shapeValue > 0.0f)
-            {
-                // We consider old object shape - we use Union function to
-                // set shape channel value.
-
-                PDFColorBuffer pixel = m_drawBuffer.getPixel(x, y);
-                pixel[drawBufferShapeChannel] = PDFBlendFunction::blend_Union(shapeValue, pixel[drawBufferShapeChannel]);
-                pixel[drawBufferOpacityChannel] = opacityValue;
+        if (shapeValue > 0.0f)
+        {
+            // We consider old object shape - we use Union function to
+            // set shape channel value.
 
-                // Copy color
-                for (uint8_t colorChannelIndex = colorChannelStart; colorChannelIndex < colorChannelEnd; ++colorChannelIndex)
-                {
-                    pixel[colorChannelIndex] = texel[colorChannelIndex];
-                }
+            PDFColorBuffer pixel = m_drawBuffer.getPixel(x, y);
+            pixel[drawBufferShapeChannel] = PDFBlendFunction::blend_Union(shapeValue, pixel[drawBufferShapeChannel]);
+            pixel[drawBufferOpacityChannel] = opacityValue;
 
-                m_drawBuffer.markPixelActiveColorMask(x, y, texture.getPixelActiveColorMask(texelCoordinateX, texelCoordinateY));
+            // Copy color
+            for (uint8_t colorChannelIndex = colorChannelStart; colorChannelIndex < colorChannelEnd; ++colorChannelIndex)
+            {
+                pixel[colorChannelIndex] = texel[colorChannelIndex];
             }
+
+            m_drawBuffer.markPixelActiveColorMask(x, y, texture.getPixelActiveColorMask(texelCoordinateX, texelCoordinateY));
         }
+    };
+
+    for (int y = fillRect.top(); y <= fillRect.bottom(); ++y)
+    {
+        pathSampler.forEachSampledPixelInRow(y, processPixel);
     }
 
     m_drawBuffer.modify(fillRect, fill, stroke);
@@ -2686,43 +2683,26 @@ bool PDFTransparencyRenderer::performOriginalImagePainting(const PDFImage& image
     {
         PDFPainterPathSampler clipSampler(m_painterStateStack.top().clipPath, m_settings.samplesCount, 1.0f, fillRect, m_settings.flags.testFlag(PDFTransparencyRendererSettings::PrecisePathSampler));
 
+        // Only pixels inside the clipping path are processed
+        auto processPixel = [&, this](int x, int y)
+        {
+            performFillFragmentFromTexture(shape, opacity, shapeChannel, opacityChannel, colorChannelStart, colorChannelEnd, x, y, worldToTextureMatrix, texture, clipSampler);
+        };
+        auto processRow = [&](int y)
+        {
+            clipSampler.forEachSampledPixelInRow(y, processPixel);
+        };
+
         if (isMultithreadedPathSamplingUsed(fillRect))
         {
-            if (fillRect.width() > fillRect.height())
-            {
-                // Columns
-                PDFIntegerRange<int> range(fillRect.left(), fillRect.right() + 1);
-                auto processEntry = [&, this](int x)
-                {
-                    for (int y = fillRect.top(); y <= fillRect.bottom(); ++y)
-                    {
-                        performFillFragmentFromTexture(shape, opacity, shapeChannel, opacityChannel, colorChannelStart, colorChannelEnd, x, y, worldToTextureMatrix, texture, clipSampler);
-                    }
-                };
-                PDFExecutionPolicy::execute(PDFExecutionPolicy::Scope::Content, range.begin(), range.end(), processEntry);
-            }
-            else
-            {
-                // Rows
-                PDFIntegerRange<int> range(fillRect.top(), fillRect.bottom() + 1);
-                auto processEntry = [&, this](int y)
-                {
-                    for (int x = fillRect.left(); x <= fillRect.right(); ++x)
-                    {
-                        performFillFragmentFromTexture(shape, opacity, shapeChannel, opacityChannel, colorChannelStart, colorChannelEnd, x, y, worldToTextureMatrix, texture, clipSampler);
-                    }
-                };
-                PDFExecutionPolicy::execute(PDFExecutionPolicy::Scope::Content, range.begin(), range.end(), processEntry);
-            }
+            PDFIntegerRange<int> range(fillRect.top(), fillRect.bottom() + 1);
+            PDFExecutionPolicy::execute(PDFExecutionPolicy::Scope::Content, range.begin(), range.end(), processRow);
         }
         else
         {
-            for (int x = fillRect.left(); x <= fillRect.right(); ++x)
+            for (int y = fillRect.top(); y <= fillRect.bottom(); ++y)
             {
-                for (int y = fillRect.top(); y <= fillRect.bottom(); ++y)
-                {
-                    performFillFragmentFromTexture(shape, opacity, shapeChannel, opacityChannel, colorChannelStart, colorChannelEnd, x, y, worldToTextureMatrix, texture, clipSampler);
-                }
+                processRow(y);
             }
         }
 
@@ -3518,8 +3498,7 @@ PDFPainterPathSampler::PDFPainterPathSampler(QPainterPath path, int samplesCount
 {
     if (!precise)
     {
-        m_fillPolygon = m_path.toFillPolygon();
-        prepareScanLines();
+        prepareSpans();
     }
 }
 
@@ -3530,9 +3509,9 @@ PDFColorComponent PDFPainterPathSampler::sample(QPoint point) const
         return m_defaultShape;
     }
 
-    if (!m_scanLineInfo.empty())
+    if (!m_precise)
     {
-        return sampleByScanLine(point);
+        return sampleBySpans(point);
     }
 
     const qreal coordX1 = point.x();
@@ -3551,33 +3530,14 @@ PDFColorComponent PDFPainterPathSampler::sample(QPoint point) const
     if (m_samplesCount <= 1)
     {
         // Jakub Melka: Just one sample
-        if (m_precise)
-        {
-            return m_path.contains(QPointF(centerX, centerY)) ? 1.0f : 0.0f;
-        }
-        else
-        {
-            return m_fillPolygon.contains(QPointF(centerX, centerY)) ? 1.0f : 0.0f;
-        }
+        return m_path.contains(QPointF(centerX, centerY)) ? 1.0f : 0.0f;
     }
 
     int cornerHits = 0;
-    Qt::FillRule fillRule = m_path.fillRule();
-
-    if (m_precise)
-    {
-        cornerHits += m_path.contains(topLeft) ? 1 : 0;
-        cornerHits += m_path.contains(topRight) ? 1 : 0;
-        cornerHits += m_path.contains(bottomLeft) ? 1 : 0;
-        cornerHits += m_path.contains(bottomRight) ? 1 : 0;
-    }
-    else
-    {
-        cornerHits += m_fillPolygon.containsPoint(topLeft, fillRule) ? 1 : 0;
-        cornerHits += m_fillPolygon.containsPoint(topRight, fillRule) ? 1 : 0;
-        cornerHits += m_fillPolygon.containsPoint(bottomLeft, fillRule) ? 1 : 0;
-        cornerHits += m_fillPolygon.containsPoint(bottomRight, fillRule) ? 1 : 0;
-    }
+    cornerHits += m_path.contains(topLeft) ? 1 : 0;
+    cornerHits += m_path.contains(topRight) ? 1 : 0;
+    cornerHits += m_path.contains(bottomLeft) ? 1 : 0;
+    cornerHits += m_path.contains(bottomRight) ? 1 : 0;
 
     if (cornerHits == 4)
     {
@@ -3603,19 +3563,9 @@ PDFColorComponent PDFPainterPathSampler::sample(QPoint point) const
         {
             const qreal y = offset * (iy + 1) + coordY1;
 
-            if (m_precise)
+            if (m_path.contains(QPointF(x, y)))
             {
-                if (m_path.contains(QPointF(x, y)))
-                {
-                    sampleValue += sampleGain;
-                }
-            }
-            else
-            {
-                if (m_fillPolygon.containsPoint(QPointF(x, y), fillRule))
-                {
-                    sampleValue += sampleGain;
-                }
+                sampleValue += sampleGain;
             }
         }
     }
@@ -3623,182 +3573,61 @@ PDFColorComponent PDFPainterPathSampler::sample(QPoint point) const
     return sampleValue;
 }
 
-PDFColorComponent PDFPainterPathSampler::sampleByScanLine(QPoint point) const
+PDFColorComponent PDFPainterPathSampler::sampleBySpans(QPoint point) const
 {
-    int scanLinePosition = point.y() - m_fillRect.y();
-
-    size_t scanLineCountPerPixel = getScanLineCountPerPixel();
-    size_t scanLineTopRow = scanLinePosition * scanLineCountPerPixel;
-    size_t scanLineBottomRow = scanLineTopRow + scanLineCountPerPixel - 1;
-    size_t scanLineGridRowTop = scanLineTopRow + 1;
+    const size_t row = point.y() - m_fillRect.top();
+    auto itBegin = std::next(m_spans.cbegin(), m_rowSpanIndices[row]);
+    auto itEnd = std::next(m_spans.cbegin(), m_rowSpanIndices[row + 1]);
 
-    Qt::FillRule fillRule = m_path.fillRule();
-
-    auto performSampling = [&](size_t scanLineIndex, PDFReal firstOrdinate, int sampleCount, PDFReal step, PDFReal gain)
+    // Find last span starting at or before the point
+    const int x = point.x();
+    auto it = std::upper_bound(itBegin, itEnd, x, [](int value, const PDFCoverageRasterizer::Span& span) { return value < span.x; });
+    if (it == itBegin)
     {
-        ScanLineInfo info = m_scanLineInfo[scanLineIndex];
-        auto it = std::next(m_scanLineSamples.cbegin(), info.indexStart);
-
-        PDFReal ordinate = firstOrdinate;
-        PDFColorComponent value = 0.0;
-        auto ordinateIt = it;
-        for (int i = 0; i < sampleCount; ++i)
-        {
-            while (std::next(ordinateIt)->x < ordinate)
-            {
-                ++ordinateIt;
-            }
-
-            int windingNumber = ordinateIt->windingNumber;
-
-            const bool inside = (fillRule == Qt::WindingFill) ? windingNumber != 0 : windingNumber % 2 != 0;
-            if (inside)
-            {
-                value += gain;
-            }
-
-            ordinate += step;
-        }
-
-        return value;
-    };
-
-    const qreal coordX1 = point.x();
-    const PDFReal cornerValue = performSampling(scanLineTopRow, coordX1, 2, 1.0, 1.0) + performSampling(scanLineBottomRow, coordX1, 2, 1.0, 1.0);
-
-    if (qFuzzyIsNull(4.0 - cornerValue))
-    {
-        // Whole inside
-        return 1.0;
-    }
-
-    if (qFuzzyIsNull(cornerValue))
-    {
-        // Whole outside
-        return 0.0;
-    }
-
-    const qreal offset = 1.0f / PDFColorComponent(m_samplesCount + 1);
-    PDFColorComponent sampleValue = 0.0f;
-    const PDFColorComponent sampleGain = 1.0f / PDFColorComponent(m_samplesCount * m_samplesCount);
-
-    for (int i = 0; i < m_samplesCount; ++i)
-    {
-        sampleValue += performSampling(scanLineGridRowTop++, coordX1 + offset, m_samplesCount, offset, sampleGain);
+        return 0.0f;
     }
 
-    return sampleValue;
+    --it;
+    return (x < it->x + it->length) ? it->coverage : 0.0f;
 }
 
-size_t PDFPainterPathSampler::getScanLineCountPerPixel() const
+void PDFPainterPathSampler::prepareSpans()
 {
-    return m_samplesCount + 2;
-}
+    m_rowSpanIndices.assign(m_fillRect.isValid() ? m_fillRect.height() + 1 : 1, 0);
 
-void PDFPainterPathSampler::prepareScanLines()
-{
-    if (m_fillPolygon.isEmpty())
+    if (m_path.isEmpty() || !m_fillRect.isValid())
     {
         return;
     }
 
-    for (int yOffset = m_fillRect.top(); yOffset <= m_fillRect.bottom(); ++yOffset)
-    {
-        const qreal coordY1 = yOffset;
-        const qreal coordY2 = coordY1 + 1.0;
+    PDFCoverageRasterizer rasterizer(m_fillRect);
+    rasterizer.addPath(m_path);
+    m_spans = rasterizer.createSpans(m_path.fillRule());
 
-        // Top pixel line
-        if (m_scanLineInfo.empty())
-        {
-            m_scanLineInfo.emplace_back(createScanLine(coordY1));
-        }
-        else
-        {
-            m_scanLineInfo.emplace_back(m_scanLineInfo.back());
-        }
+    if (m_samplesCount <= 1)
+    {
+        // Antialiasing is turned off, pixel is inside, if its center is inside,
+        // which corresponds to at least half of the pixel area covered.
+        auto it = std::remove_if(m_spans.begin(), m_spans.end(), [](const PDFCoverageRasterizer::Span& span) { return span.coverage < 0.5f; });
+        m_spans.erase(it, m_spans.end());
 
-        // Sample grid
-        const qreal offset = 1.0f / PDFColorComponent(m_samplesCount + 1);
-        for (int iy = 0; iy < m_samplesCount; ++iy)
+        for (PDFCoverageRasterizer::Span& span : m_spans)
         {
-            const qreal y = offset * (iy + 1) + coordY1;
-            m_scanLineInfo.emplace_back(createScanLine(y));
+            span.coverage = 1.0f;
         }
-
-        // Bottom pixel line
-        m_scanLineInfo.emplace_back(createScanLine(coordY2));
     }
-}
-
-PDFPainterPathSampler::ScanLineInfo PDFPainterPathSampler::createScanLine(qreal y)
-{
-    ScanLineInfo result;
-    result.indexStart = m_scanLineSamples.size();
-
-    // Add start item
-    m_scanLineSamples.emplace_back(-std::numeric_limits<PDFReal>::infinity(), 0);
 
-    // Traverse polygon, add sample for each polygon line, we must
-    // also implicitly close last edge (if polygon is not closed)
-    for (int i = 1; i < m_fillPolygon.size(); ++i)
+    // Spans are sorted by rows, compute index of the first span of each row
+    size_t spanIndex = 0;
+    for (int row = 0; row < m_fillRect.height(); ++row)
     {
-        createScanLineSample(m_fillPolygon[i - 1], m_fillPolygon[i], y);
-    }
-
-    if (m_fillPolygon.front() != m_fillPolygon.back())
-    {
-        createScanLineSample(m_fillPolygon.back(), m_fillPolygon.front(), y);
-    }
-
-    // Add end item
-    m_scanLineSamples.emplace_back(+std::numeric_limits<PDFReal>::infinity(), 0);
-
-    result.indexEnd = m_scanLineSamples.size();
-
-    auto it = std::next(m_scanLineSamples.begin(), result.indexStart);
-    auto itEnd = std::next(m_scanLineSamples.begin(), result.indexEnd);
-
-    // Jakub Melka: now, sort the line samples and compute properly the winding number
-    std::sort(it, itEnd);
-
-    int currentWindingNumber = 0;
-    for (; it != itEnd; ++it)
-    {
-        currentWindingNumber += it->windingNumber;
-        it->windingNumber = currentWindingNumber;
-    }
-
-    return result;
-}
-
-void PDFPainterPathSampler::createScanLineSample(const QPointF& p1, const QPointF& p2, qreal y)
-{
-    PDFReal y1 = p1.y();
-    PDFReal y2 = p2.y();
-
-    if (qFuzzyIsNull(y2 - y1))
-    {
-        // Ignore horizontal lines
-        return;
-    }
-
-    PDFReal x1 = p1.x();
-    PDFReal x2 = p2.x();
-
-    int windingNumber = 1;
-    if (y2 < y1)
-    {
-        std::swap(y1, y2);
-        std::swap(x1, x2);
-        windingNumber = -1;
-    }
-
-    // Do we have intercept?
-    if (y1 <= y && y < y2)
-    {
-        const PDFReal x = interpolate(y, y1, y2, x1, x2);
-        m_scanLineSamples.emplace_back(x, windingNumber);
+        m_rowSpanIndices[row] = spanIndex;
+        while (spanIndex < m_spans.size() && m_spans[spanIndex].y == m_fillRect.top() + row)
+        {
+            ++spanIndex;
+        }
     }
+    m_rowSpanIndices.back() = spanIndex;
 }
 
 void PDFDrawBuffer::clear()
@@ -24,6 +24,7 @@
 #include "pdfconstants.h"
 #include "pdfutils.h"
 #include "pdfprogress.h"
+#include "pdfcoveragerasterizer.h"
 
 #include <QImage>
 
@@ -452,17 +453,19 @@ private:
     size_t m_activeSpotColors = 0;
 };
 
-/// Painter path sampler. Returns shape value of pixel. This sampler
-/// uses MSAA with regular grid.
+/// Painter path sampler. Returns shape value of pixel. Precise sampler
+/// uses MSAA with regular grid, otherwise exact area coverage computed
+/// by the coverage rasterizer is used.
 class PDFPainterPathSampler
 {
 public:
     /// Creates new painter path sampler, using given painter path,
     /// sample count (in one direction) and default shape used, when painter path is empty.
-    /// Fill rectangle is used to precompute winding numbers for samples. Points outside
+    /// Fill rectangle is used to rasterize the path into spans. Points outside
     /// of fill rectangle are considered as outside and defaultShape is returned.
     /// \param path Sampled path
-    /// \param samplesCount Samples count in one direction
+    /// \param samplesCount Samples count in one direction (if it is 1, then
+    ///        antialiasing is turned off)
     /// \param defaultShape Default shape returned, if path is empty
     /// \param fillRect Fill rectangle (sample point must be in this rectangle)
     /// \param precise Use precise painter path computation
@@ -475,58 +478,55 @@ public:
     /// Return sample value for a given pixel
     PDFColorComponent sample(QPoint point) const;
 
-private:
-    struct ScanLineSample
+    /// Calls \p function(x, y) for each pixel in the row \p y of the fill
+    /// rectangle, which can have nonzero sample value. Pixels with zero sample
+    /// value are skipped, if they are known from the rasterized spans.
+    /// \param y Row
+    /// \param function Function
+    template<typename Function>
+    void forEachSampledPixelInRow(int y, Function function) const
     {
-        inline constexpr ScanLineSample() = default;
-        inline constexpr ScanLineSample(PDFReal x, int windingNumber) :
-            x(x),
-            windingNumber(windingNumber)
+        if (y < m_fillRect.top() || y > m_fillRect.bottom())
         {
-
+            return;
         }
 
-        bool operator<(const ScanLineSample& other) const { return x < other.x; }
-        bool operator<(PDFReal ordinate) const { return x < ordinate; }
-
-        PDFReal x = 0.0;
-        int windingNumber = 0;
-    };
-
-    struct ScanLineInfo
-    {
-        size_t indexStart = 0;
-        size_t indexEnd = 0;
-    };
-
-    /// Compute sample by using scan lines
-    PDFColorComponent sampleByScanLine(QPoint point) const;
-
-    /// Returns number of scan lines per pixel
-    size_t getScanLineCountPerPixel() const;
+        if (m_precise || m_path.isEmpty())
+        {
+            if (!m_path.isEmpty() || m_defaultShape > 0.0f)
+            {
+                for (int x = m_fillRect.left(); x <= m_fillRect.right(); ++x)
+                {
+                    function(x, y);
+                }
+            }
+            return;
+        }
 
-    /// Creates scan lines using fill rectangle
-    void prepareScanLines();
+        const size_t row = y - m_fillRect.top();
+        for (size_t i = m_rowSpanIndices[row]; i < m_rowSpanIndices[row + 1]; ++i)
+        {
+            const PDFCoverageRasterizer::Span& span = m_spans[i];
+            for (int x = span.x, xEnd = span.x + span.length; x < xEnd; ++x)
+            {
+                function(x, y);
+            }
+        }
+    }
 
-    /// Creates scan line for given y coordinate and
-    /// returns info about this scan line
-    /// \param y Vertical coordinate of the sample line
-    ScanLineInfo createScanLine(qreal y);
+private:
+    /// Returns sample value from rasterized spans
+    PDFColorComponent sampleBySpans(QPoint point) const;
 
-    /// Creates scan line sample (if horizontal line of y coordinate
-    /// is intersecting boundary line segment p1-p2.
-    /// \param p1 First point of the oriented boundary line segment
-    /// \param p2 Second point of the oriented boundary line segment
-    /// \param y Vertical coordinate of the sample line
-    void createScanLineSample(const QPointF& p1, const QPointF& p2, qreal y);
+    /// Rasterizes path into spans
+    void prepareSpans();
 
     PDFColorComponent m_defaultShape = 0.0;
     int m_samplesCount = 0; ///< Samples count in one direction
     QPainterPath m_path;
-    QPolygonF m_fillPolygon;
     QRect m_fillRect;
-    std::vector<ScanLineSample> m_scanLineSamples;
-    std::vector<ScanLineInfo> m_scanLineInfo;
+    std::vector<PDFCoverageRasterizer::Span> m_spans;
+    std::vector<size_t> m_rowSpanIndices; ///< Index of the first span of each row of fill rectangle
     bool m_precise;
 };
 
@@ -559,7 +559,8 @@ private:
 
 struct PDFTransparencyRendererSettings
 {
-    /// Sample count for MSAA antialiasing
+    /// Sample count for MSAA antialiasing (used by precise path sampler only,
+    /// otherwise exact area coverage is used; value 1 turns antialiasing off)
     int samplesCount = 16;
 
     /// Threshold for turning on painter path
@@ -627,7 +627,7 @@ void PDFProgramController::initialize(Features features,
 
     m_pdfWidget = new pdf::PDFWidget(m_CMSManager, m_settings->getRendererEngine(), m_mainWindow);
     m_pdfWidget->setObjectName("pdfWidget");
-    m_pdfWidget->updateCacheLimits(m_settings->getCompiledPageCacheLimit() * 1024, m_settings->getThumbnailsCacheLimit(), m_settings->getFontCacheLimit(), m_settings->getInstancedFontCacheLimit());
+    m_pdfWidget->updateCacheLimits(m_settings->getCompiledPageCacheLimit() * 1024, m_settings->getThumbnailsCacheLimit(), m_settings->getFontCacheLimit(), m_settings->getInstancedFontCacheLimit(), m_settings->getPageTileCacheLimit() * 1024, qint64(m_settings->getImageCacheLimit()) * 1024);
     m_pdfWidget->getDrawWidgetProxy()->setProgress(m_progress);
 
     connect(this, &PDFProgramController::queryPasswordRequest, this, &PDFProgramController::onQueryPasswordRequest, Qt::BlockingQueuedConnection);
@@ -1172,9 +1172,24 @@ void PDFProgramController::saveDocument(const QString& fileName)
     updateFileWatcher(true);
 
     pdf::PDFDocumentWriter writer(nullptr);
-    pdf::PDFOperationResult result = writer.write(fileName, m_pdfDocument.data(), true);
+    pdf::PDFOperationResult result = false;
+
+    if (m_savedDocument && !m_fileInfo.originalFileName.isEmpty() && QFileInfo(fileName) == QFileInfo(m_fileInfo.originalFileName))
+    {
+        // Append only changed objects to the file. If it is not possible,
+        // then whole document is written.
+        result = writer.writeIncremental(fileName, m_pdfDocument.data(), m_savedDocument.data(), m_fileInfo.originalFileName);
+    }
+
+    if (!result)
+    {
+        result = writer.write(fileName, m_pdfDocument.data(), true);
+    }
+
     if (result)
     {
+        m_savedDocument = m_pdfDocument;
+
         if (m_undoRedoManager)
         {
             m_undoRedoManager->setIsCurrentSaved(true);
@@ -1699,7 +1714,7 @@ void PDFProgramController::updateActionsAvailability()
 void PDFProgramController::onViewerSettingsChanged()
 {
     m_pdfWidget->updateRenderer(m_settings->getRendererEngine());
-    m_pdfWidget->updateCacheLimits(m_settings->getCompiledPageCacheLimit() * 1024, m_settings->getThumbnailsCacheLimit(), m_settings->getFontCacheLimit(), m_settings->getInstancedFontCacheLimit());
+    m_pdfWidget->updateCacheLimits(m_settings->getCompiledPageCacheLimit() * 1024, m_settings->getThumbnailsCacheLimit(), m_settings->getFontCacheLimit(), m_settings->getInstancedFontCacheLimit(), m_settings->getPageTileCacheLimit() * 1024, qint64(m_settings->getImageCacheLimit()) * 1024);
     m_pdfWidget->getDrawWidgetProxy()->setFeatures(m_settings->getFeatures());
     m_pdfWidget->getDrawWidgetProxy()->setPreferredMeshResolutionRatio(m_settings->getPreferredMeshResolutionRatio());
     m_pdfWidget->getDrawWidgetProxy()->setMinimalMeshResolutionRatio(m_settings->getMinimalMeshResolutionRatio());
@@ -1733,32 +1748,52 @@ void PDFProgramController::onFileChanged(const QString& fileName)
         return;
     }
 
-    QFile file(fileName);
-    if (file.open(QFile::ReadOnly))
+    if (!m_pdfDocument)
     {
-        QByteArray data = file.readAll();
-        file.close();
+        return;
+    }
 
-        QByteArray hash = pdf::PDFDocumentReader::hash(data);
-        if (m_pdfDocument && m_pdfDocument->getSourceDataHash() != hash)
+    bool isChanged = false;
+    if (m_pdfDocument->getSourceDataHash().isEmpty())
+    {
+        // Lazily loaded documents have no hash, because whole mapped file would
+        // have to be read to compute it. File size and modification time are used.
+        QFileInfo fileInfo(fileName);
+        isChanged = fileInfo.exists() && (fileInfo.size() != m_fileInfo.fileSize || fileInfo.lastModified() != m_fileInfo.lastModifiedTime);
+    }
+    else
+    {
+        QFile file(fileName);
+        if (file.open(QFile::ReadOnly))
         {
-            auto queryPassword = [this](bool* ok)
-            {
-                *ok = false;
-                return QString();
-            };
+            isChanged = pdf::PDFDocumentReader::hash(&file) != m_pdfDocument->getSourceDataHash();
+            file.close();
+        }
+    }
 
-            // Try to open a new document
-            pdf::PDFDocumentReader reader(m_progress, qMove(queryPassword), true, false);
-            pdf::PDFDocument document = reader.readFromFile(fileName);
+    if (isChanged)
+    {
+        auto queryPassword = [this](bool* ok)
+        {
+            *ok = false;
+            return QString();
+        };
 
-            if (reader.getReadingResult() == pdf::PDFDocumentReader::Result::OK)
-            {
-                pdf::PDFDocumentPointer pointer(new pdf::PDFDocument(std::move(document)));
-                pdf::PDFModifiedDocument modifiedDocument(std::move(pointer), m_optionalContentActivity, pdf::PDFModifiedDocument::ModificationFlags(pdf::PDFModifiedDocument::Reset | pdf::PDFModifiedDocument::PreserveView));
-                onDocumentModified(std::move(modifiedDocument));
-                m_undoRedoManager->setIsCurrentSaved();
-            }
+        // Try to open a new document, use the same loading mode as the original document
+        pdf::PDFDocumentReader reader(m_progress, qMove(queryPassword), true, false);
+        reader.setLoadingMode(m_loadingMode);
+        pdf::PDFDocument document = reader.readFromFile(fileName);
+
+        if (reader.getReadingResult() == pdf::PDFDocumentReader::Result::OK)
+        {
+            pdf::PDFDocumentPointer pointer(new pdf::PDFDocument(std::move(document)));
+            pdf::PDFModifiedDocument modifiedDocument(std::move(pointer), m_optionalContentActivity, pdf::PDFModifiedDocument::ModificationFlags(pdf::PDFModifiedDocument::Reset | pdf::PDFModifiedDocument::PreserveView));
+            onDocumentModified(std::move(modifiedDocument));
+            m_undoRedoManager->setIsCurrentSaved();
+            m_savedDocument = m_pdfDocument;
+
+            // File size and modification time are used to detect next change
+            updateFileInfo(fileName);
         }
     }
 }
@@ -1824,12 +1859,18 @@ void PDFProgramController::openDocument(const QString& fileName)
             return result;
         };
 
-        // Try to open a new document
+        // Try to open a new document. Large files are memory mapped and their
+        // objects are parsed on demand, so the first page is shown quickly.
         pdf::PDFDocumentReader reader(m_progress, qMove(queryPassword), true, false);
+        if (QFileInfo(fileName).size() >= LAZY_LOADING_FILE_SIZE_THRESHOLD)
+        {
+            reader.setLoadingMode(pdf::PDFDocumentReader::LoadingMode::Lazy);
+        }
         pdf::PDFDocument document = reader.readFromFile(fileName);
 
         result.errorMessage = reader.getErrorMessage();
         result.result = reader.getReadingResult();
+        result.loadingMode = reader.getLoadingMode();
         if (result.result == pdf::PDFDocumentReader::Result::OK)
         {
             // Verify signatures
@@ -1875,7 +1916,9 @@ void PDFProgramController::onDocumentReadingFinished()
             m_recentFileManager->addRecentFile(m_fileInfo.originalFileName);
 
             m_pdfDocument = qMove(result.document);
+            m_savedDocument = m_pdfDocument;
             m_signatures = qMove(result.signatures);
+            m_loadingMode = result.loadingMode;
             pdf::PDFModifiedDocument document(m_pdfDocument.data(), m_optionalContentActivity);
             setDocument(document, true);
 
@@ -2065,6 +2108,7 @@ void PDFProgramController::closeDocument()
     m_signatures.clear();
     setDocument(pdf::PDFModifiedDocument(), true);
     m_pdfDocument.reset();
+    m_savedDocument.reset();
     updateActionsAvailability();
     updateTitle();
     updateFileInfo(QString());
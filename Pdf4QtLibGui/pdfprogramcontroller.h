@@ -323,12 +323,15 @@ signals:
     void queryPasswordRequest(QString* password, bool* ok);
 
 private:
+    /// Files larger than this size are loaded lazily (memory mapped, objects parsed on demand)
+    static constexpr qint64 LAZY_LOADING_FILE_SIZE_THRESHOLD = 256 * 1024 * 1024;
 
     struct AsyncReadingResult
     {
         pdf::PDFDocumentPointer document;
         QString errorMessage;
         pdf::PDFDocumentReader::Result result = pdf::PDFDocumentReader::Result::Cancelled;
+        pdf::PDFDocumentReader::LoadingMode loadingMode = pdf::PDFDocumentReader::LoadingMode::Eager;
         std::vector<pdf::PDFSignatureVerificationResult> signatures;
     };
 
@@ -429,6 +432,7 @@ private:
     PDFRecentFileManager* m_recentFileManager;
     pdf::PDFOptionalContentActivity* m_optionalContentActivity;
     pdf::PDFDocumentPointer m_pdfDocument;
+    pdf::PDFDocumentPointer m_savedDocument; ///< Document, as it is stored in the file (for incremental save)
     PDFTextToSpeech* m_textToSpeech;
     bool m_isDocumentSetInProgress;
 
@@ -443,6 +447,7 @@ private:
     PDFActionComboBox* m_actionComboBox;
 
     PDFFileInfo m_fileInfo;
+    pdf::PDFDocumentReader::LoadingMode m_loadingMode = pdf::PDFDocumentReader::LoadingMode::Eager;
     QFileSystemWatcher m_fileWatcher;
     pdf::PDFCertificateStore m_certificateStore;
     std::vector<pdf::PDFSignatureVerificationResult> m_signatures;
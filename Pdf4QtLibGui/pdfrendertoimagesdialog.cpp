@@ -300,6 +300,8 @@ void PDFRenderToImagesDialog::on_buttonBox_clicked(QAbstractButton* button)
             m_rasterizerPool = new pdf::PDFRasterizerPool(m_document, m_proxy->getFontCache(), m_proxy->getCMSManager(),
                                                           m_optionalContentActivity, m_proxy->getFeatures(), m_proxy->getMeshQualitySettings(),
                                                           pdf::PDFRasterizerPool::getDefaultRasterizerCount(), m_proxy->getRendererEngine(), this);
+            m_rasterizerPool->setImageCache(m_proxy->getImageCache());
+            m_rasterizerPool->setBytecodeCache(m_proxy->getBytecodeCache());
             connect(m_rasterizerPool, &pdf::PDFRasterizerPool::renderError, this, &PDFRenderToImagesDialog::onRenderError);
 
             auto process = [this]()
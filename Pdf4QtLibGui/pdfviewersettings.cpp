@@ -52,6 +52,8 @@ void PDFViewerSettings::readSettings(QSettings& settings, const pdf::PDFCMSSetti
     m_settings.m_thumbnailsCacheLimit = settings.value("thumbnailsCacheLimit", defaultSettings.m_thumbnailsCacheLimit).toInt();
     m_settings.m_fontCacheLimit = settings.value("fontCacheLimit", defaultSettings.m_fontCacheLimit).toInt();
     m_settings.m_instancedFontCacheLimit = settings.value("instancedFontCacheLimit", defaultSettings.m_instancedFontCacheLimit).toInt();
+    m_settings.m_pageTileCacheLimit = settings.value("pageTileCacheLimit", defaultSettings.m_pageTileCacheLimit).toInt();
+    m_settings.m_imageCacheLimit = settings.value("imageCacheLimit", defaultSettings.m_imageCacheLimit).toInt();
     m_settings.m_allowLaunchApplications = settings.value("allowLaunchApplications", defaultSettings.m_allowLaunchApplications).toBool();
     m_settings.m_allowLaunchURI = settings.value("allowLaunchURI", defaultSettings.m_allowLaunchURI).toBool();
     m_settings.m_allowDeveloperMode = settings.value("allowDeveloperMode", defaultSettings.m_allowDeveloperMode).toBool();
@@ -125,6 +127,8 @@ void PDFViewerSettings::writeSettings(QSettings& settings)
     settings.setValue("thumbnailsCacheLimit", m_settings.m_thumbnailsCacheLimit);
     settings.setValue("fontCacheLimit", m_settings.m_fontCacheLimit);
     settings.setValue("instancedFontCacheLimit", m_settings.m_instancedFontCacheLimit);
+    settings.setValue("pageTileCacheLimit", m_settings.m_pageTileCacheLimit);
+    settings.setValue("imageCacheLimit", m_settings.m_imageCacheLimit);
     settings.setValue("allowLaunchApplications", m_settings.m_allowLaunchApplications);
     settings.setValue("allowLaunchURI", m_settings.m_allowLaunchURI);
     settings.setValue("allowDeveloperMode", m_settings.m_allowDeveloperMode);
@@ -266,6 +270,8 @@ PDFViewerSettings::Settings::Settings() :
     m_thumbnailsCacheLimit(64 * 1024),
     m_fontCacheLimit(pdf::DEFAULT_FONT_CACHE_LIMIT),
     m_instancedFontCacheLimit(pdf::DEFAULT_REALIZED_FONT_CACHE_LIMIT),
+    m_pageTileCacheLimit(128 * 1024),
+    m_imageCacheLimit(static_cast<int>(pdf::DEFAULT_IMAGE_CACHE_LIMIT / 1024)),
     m_speechRate(0.0),
     m_speechPitch(0.0),
     m_speechVolume(1.0),
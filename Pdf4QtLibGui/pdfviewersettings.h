@@ -66,6 +66,8 @@ public:
         int m_thumbnailsCacheLimit;
         int m_fontCacheLimit;
         int m_instancedFontCacheLimit;
+        int m_pageTileCacheLimit;
+        int m_imageCacheLimit;
 
         // Speech settings
         QString m_speechEngine;
@@ -126,6 +128,8 @@ public:
     int getThumbnailsCacheLimit() const { return m_settings.m_thumbnailsCacheLimit; }
     int getFontCacheLimit() const { return m_settings.m_fontCacheLimit; }
     int getInstancedFontCacheLimit() const { return m_settings.m_instancedFontCacheLimit; }
+    int getPageTileCacheLimit() const { return m_settings.m_pageTileCacheLimit; }
+    int getImageCacheLimit() const { return m_settings.m_imageCacheLimit; }
 
     const pdf::PDFCMSSettings& getColorManagementSystemSettings() const { return m_colorManagementSystemSettings; }
     void setColorManagementSystemSettings(const pdf::PDFCMSSettings& settings) { m_colorManagementSystemSettings = settings; }
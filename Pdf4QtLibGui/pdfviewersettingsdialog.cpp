@@ -297,6 +297,8 @@ void PDFViewerSettingsDialog::loadData()
     ui->thumbnailCacheSizeEdit->setValue(m_settings.m_thumbnailsCacheLimit);
     ui->cachedFontLimitEdit->setValue(m_settings.m_fontCacheLimit);
     ui->cachedInstancedFontLimitEdit->setValue(m_settings.m_instancedFontCacheLimit);
+    ui->pageTileCacheSizeEdit->setValue(m_settings.m_pageTileCacheLimit);
+    ui->imageCacheSizeEdit->setValue(m_settings.m_imageCacheLimit);
 
     // Security
     ui->allowLaunchCheckBox->setChecked(m_settings.m_allowLaunchApplications);
@@ -469,6 +471,14 @@ void PDFViewerSettingsDialog::saveData()
     {
         m_settings.m_thumbnailsCacheLimit = ui->thumbnailCacheSizeEdit->value();
     }
+    else if (sender == ui->pageTileCacheSizeEdit)
+    {
+        m_settings.m_pageTileCacheLimit = ui->pageTileCacheSizeEdit->value();
+    }
+    else if (sender == ui->imageCacheSizeEdit)
+    {
+        m_settings.m_imageCacheLimit = ui->imageCacheSizeEdit->value();
+    }
     else if (sender == ui->cachedFontLimitEdit)
     {
         m_settings.m_fontCacheLimit = ui->cachedFontLimitEdit->value();
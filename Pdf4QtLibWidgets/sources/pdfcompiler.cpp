@@ -23,6 +23,8 @@
 #include "pdfdrawspacecontroller.h"
 
 #include <QCache>
+#include <QtMath>
+#include <QPainter>
 #include <QtConcurrent/QtConcurrent>
 
 #include "pdfdbgheap.h"
@@ -73,6 +75,9 @@ void PDFAsynchronousPageCompilerWorkerThread::run()
                         PDFCMSPointer cms = proxy->getCMSManager()->getCurrentCMS();
                         PDFRenderer renderer(proxy->getDocument(), proxy->getFontCache(), cms.data(), proxy->getOptionalContentActivity(), proxy->getFeatures(), proxy->getMeshQualitySettings());
                         renderer.setOperationControl(m_compiler);
+                        renderer.setImageResolutionScale(task.imageResolutionScale);
+                        renderer.setImageCache(proxy->getImageCache());
+                        renderer.setBytecodeCache(proxy->getBytecodeCache());
                         renderer.compile(&task.precompiledPage, task.pageIndex);
                         task.finished = true;
                         return compiledPage;
@@ -117,7 +122,7 @@ void PDFAsynchronousPageCompilerWorkerThread::run()
 PDFAsynchronousPageCompiler::PDFAsynchronousPageCompiler(PDFDrawWidgetProxy* proxy) :
     BaseClass(proxy),
     m_proxy(proxy),
-    m_cache(new QCache<PDFInteger, PDFPrecompiledPage>())
+    m_cache(new QCache<PDFInteger, std::shared_ptr<PDFPrecompiledPage>>())
 {
     m_cache->setMaxCost(128 * 1024 * 1024);
 }
@@ -216,6 +221,11 @@ void PDFAsynchronousPageCompiler::setCacheLimit(int limit)
     m_cache->setMaxCost(limit);
 }
 
+void PDFAsynchronousPageCompiler::setImageResolutionScale(PDFReal imageResolutionScale)
+{
+    m_imageResolutionScale = imageResolutionScale;
+}
+
 const PDFPrecompiledPage* PDFAsynchronousPageCompiler::getCompiledPage(PDFInteger pageIndex, bool compile)
 {
     if (m_state != State::Active || !m_proxy->getDocument())
@@ -224,14 +234,18 @@ const PDFPrecompiledPage* PDFAsynchronousPageCompiler::getCompiledPage(PDFIntege
         return nullptr;
     }
 
-    PDFPrecompiledPage* page = m_cache->object(pageIndex);
+    std::shared_ptr<PDFPrecompiledPage>* cachedPage = m_cache->object(pageIndex);
+    PDFPrecompiledPage* page = cachedPage ? cachedPage->get() : nullptr;
 
-    if (!page && compile)
+    // If page images were decoded at lower resolution, than is needed, then
+    // we keep the old page in the cache (to display something) and compile
+    // the page again. New page replaces the old one, when it is compiled.
+    if (compile && (!page || page->isImageResolutionInsufficient(m_imageResolutionScale)))
     {
         QMutexLocker locker(&m_mutex);
         if (!m_tasks.count(pageIndex))
         {
-            m_tasks.insert(std::make_pair(pageIndex, CompileTask(pageIndex)));
+            m_tasks.insert(std::make_pair(pageIndex, CompileTask(pageIndex, m_imageResolutionScale)));
             m_waitCondition.wakeOne();
         }
     }
@@ -244,6 +258,17 @@ const PDFPrecompiledPage* PDFAsynchronousPageCompiler::getCompiledPage(PDFIntege
     return page;
 }
 
+std::shared_ptr<const PDFPrecompiledPage> PDFAsynchronousPageCompiler::getSharedCompiledPage(PDFInteger pageIndex) const
+{
+    if (m_state != State::Active)
+    {
+        return nullptr;
+    }
+
+    std::shared_ptr<PDFPrecompiledPage>* cachedPage = m_cache->object(pageIndex);
+    return cachedPage ? *cachedPage : nullptr;
+}
+
 void PDFAsynchronousPageCompiler::smartClearCache(const int milisecondsLimit, const std::vector<PDFInteger>& activePages)
 {
     if (m_state != State::Active)
@@ -265,8 +290,8 @@ void PDFAsynchronousPageCompiler::smartClearCache(const int milisecondsLimit, co
             continue;
         }
 
-        const PDFPrecompiledPage* page = m_cache->object(pageIndex);
-        if (page && page->hasExpired(milisecondsLimit))
+        const std::shared_ptr<PDFPrecompiledPage>* page = m_cache->object(pageIndex);
+        if (page && (*page)->hasExpired(milisecondsLimit))
         {
             m_cache->remove(pageIndex);
         }
@@ -290,9 +315,9 @@ void PDFAsynchronousPageCompiler::onPageCompiled()
                 if (m_state == State::Active)
                 {
                     // If we are in active state, try to store precompiled page
-                    PDFPrecompiledPage* page = new PDFPrecompiledPage(std::move(task.precompiledPage));
-                    page->markAccessed();
-                    qint64 memoryConsumptionEstimate = page->getMemoryConsumptionEstimate();
+                    std::shared_ptr<PDFPrecompiledPage>* page = new std::shared_ptr<PDFPrecompiledPage>(std::make_shared<PDFPrecompiledPage>(std::move(task.precompiledPage)));
+                    (*page)->markAccessed();
+                    qint64 memoryConsumptionEstimate = (*page)->getMemoryConsumptionEstimate();
                     if (m_cache->insert(it->first, page, memoryConsumptionEstimate))
                     {
                         compiledPages.push_back(it->first);
@@ -328,13 +353,261 @@ void PDFAsynchronousPageCompiler::onPageCompiled()
     }
 }
 
+PDFAsynchronousTileRenderer::PDFAsynchronousTileRenderer(PDFDrawWidgetProxy* proxy) :
+    BaseClass(proxy),
+    m_cache(new QCache<PDFPageTileKey, QImage>())
+{
+    m_cache->setMaxCost(128 * 1024 * 1024);
+    connect(&m_futureWatcher, &QFutureWatcher<TileTasks>::finished, this, &PDFAsynchronousTileRenderer::onTilesRendered);
+}
+
+PDFAsynchronousTileRenderer::~PDFAsynchronousTileRenderer()
+{
+    m_futureWatcher.waitForFinished();
+
+    delete m_cache;
+    m_cache = nullptr;
+}
+
+void PDFAsynchronousTileRenderer::setCacheLimit(int limit)
+{
+    m_cache->setMaxCost(qMax(limit, 0));
+
+    if (!isEnabled())
+    {
+        invalidate(true, { });
+    }
+}
+
+bool PDFAsynchronousTileRenderer::isEnabled() const
+{
+    return m_cache->maxCost() > 0;
+}
+
+bool PDFAsynchronousTileRenderer::canCacheTiles(int tileCount, qreal devicePixelRatio) const
+{
+    const qint64 tilePixelSize = qCeil(TILE_SIZE * devicePixelRatio);
+    const qint64 tileBytes = tilePixelSize * tilePixelSize * 4;
+
+    // We want to have space also for substitute tiles
+    return 2 * tileCount * tileBytes <= m_cache->maxCost();
+}
+
+const QImage* PDFAsynchronousTileRenderer::getTile(const PDFPageTileKey& key) const
+{
+    return m_cache->object(key);
+}
+
+std::vector<PDFPageTileKey> PDFAsynchronousTileRenderer::getSubstituteLevels(const PDFPageTileKey& key) const
+{
+    std::vector<PDFPageTileKey> levels;
+
+    for (const PDFPageTileKey& level : m_levels)
+    {
+        if (level.pageIndex == key.pageIndex &&
+            level.rotation == key.rotation &&
+            level.features == key.features &&
+            level.devicePixelRatio == key.devicePixelRatio &&
+            level.pageImageSize != key.pageImageSize)
+        {
+            levels.push_back(level);
+        }
+    }
+
+    auto getDistance = [&key](const PDFPageTileKey& level)
+    {
+        return qAbs(level.pageImageSize.width() - key.pageImageSize.width());
+    };
+    std::stable_sort(levels.begin(), levels.end(), [&getDistance](const PDFPageTileKey& l, const PDFPageTileKey& r) { return getDistance(l) < getDistance(r); });
+
+    return levels;
+}
+
+void PDFAsynchronousTileRenderer::requestTile(const PDFPageTileKey& key,
+                                              std::shared_ptr<const PDFPrecompiledPage> compiledPage,
+                                              const QRectF& cropBox,
+                                              const QTransform& pagePointToTilePointMatrix)
+{
+    if (!isEnabled() || !compiledPage || m_pendingKeys.contains(key))
+    {
+        return;
+    }
+
+    TileTask task;
+    task.key = key;
+    task.cropBox = cropBox;
+    task.matrix = pagePointToTilePointMatrix;
+    task.generation = m_generation;
+    task.compiledPage = std::move(compiledPage);
+
+    m_pendingKeys.insert(key);
+    m_requests.push_back(std::move(task));
+}
+
+void PDFAsynchronousTileRenderer::clearRequests()
+{
+    for (const TileTask& task : m_requests)
+    {
+        m_pendingKeys.remove(task.key);
+    }
+
+    m_requests.clear();
+}
+
+void PDFAsynchronousTileRenderer::startRendering()
+{
+    if (m_isRendering || m_requests.empty())
+    {
+        return;
+    }
+
+    // Take first requests, they are sorted in the order, in which they were requested
+    const size_t batchSize = qMin(m_requests.size(), MAX_BATCH_SIZE);
+    TileTasks tasks(std::make_move_iterator(m_requests.begin()), std::make_move_iterator(m_requests.begin() + batchSize));
+    m_requests.erase(m_requests.begin(), m_requests.begin() + batchSize);
+
+    auto renderTiles = [tasks = std::move(tasks)]() mutable -> TileTasks
+    {
+        auto renderTile = [](TileTask& task)
+        {
+            const int tilePixelSize = qCeil(TILE_SIZE * task.key.devicePixelRatio);
+
+            QImage image(tilePixelSize, tilePixelSize, QImage::Format_ARGB32_Premultiplied);
+            image.setDevicePixelRatio(task.key.devicePixelRatio);
+            image.fill(Qt::transparent);
+
+            {
+                QPainter painter(&image);
+
+                // Fill the part of the page image covered by this tile by the paper
+                // color, so page contents are composed over the paper (as when
+                // page is drawn directly). Tiles can overlap the page image border.
+                if (task.key.paperColor.isValid())
+                {
+                    const QRect pageImageRect(QPoint(-task.key.column * TILE_SIZE, -task.key.row * TILE_SIZE), task.key.pageImageSize);
+                    painter.fillRect(pageImageRect.intersected(QRect(0, 0, TILE_SIZE, TILE_SIZE)), task.key.paperColor);
+                }
+
+                task.compiledPage->draw(&painter, task.cropBox, task.matrix, task.key.features, 1.0);
+            }
+
+            task.image = std::move(image);
+            task.compiledPage.reset();
+        };
+
+        PDFExecutionPolicy::execute(PDFExecutionPolicy::Scope::Page, tasks.begin(), tasks.end(), renderTile);
+        return std::move(tasks);
+    };
+
+    m_isRendering = true;
+    m_future = QtConcurrent::run(std::move(renderTiles));
+    m_futureWatcher.setFuture(m_future);
+}
+
+void PDFAsynchronousTileRenderer::invalidate(bool all, const std::vector<PDFInteger>& pages)
+{
+    ++m_generation;
+
+    if (all)
+    {
+        m_allInvalidatedGeneration = m_generation;
+        m_pageInvalidatedGeneration.clear();
+        m_cache->clear();
+        m_levels.clear();
+        clearRequests();
+        return;
+    }
+
+    for (const PDFInteger pageIndex : pages)
+    {
+        m_pageInvalidatedGeneration[pageIndex] = m_generation;
+    }
+
+    auto isInvalidated = [&pages](PDFInteger pageIndex) { return std::find(pages.cbegin(), pages.cend(), pageIndex) != pages.cend(); };
+
+    const QList<PDFPageTileKey> keys = m_cache->keys();
+    for (const PDFPageTileKey& key : keys)
+    {
+        if (isInvalidated(key.pageIndex))
+        {
+            m_cache->remove(key);
+        }
+    }
+
+    auto itRequests = std::remove_if(m_requests.begin(), m_requests.end(), [&](const TileTask& task) { return isInvalidated(task.key.pageIndex); });
+    for (auto it = itRequests; it != m_requests.end(); ++it)
+    {
+        m_pendingKeys.remove(it->key);
+    }
+    m_requests.erase(itRequests, m_requests.end());
+
+    m_levels.erase(std::remove_if(m_levels.begin(), m_levels.end(), [&](const PDFPageTileKey& key) { return isInvalidated(key.pageIndex); }), m_levels.end());
+}
+
+bool PDFAsynchronousTileRenderer::isValid(const TileTask& task) const
+{
+    if (task.generation < m_allInvalidatedGeneration)
+    {
+        return false;
+    }
+
+    auto it = m_pageInvalidatedGeneration.find(task.key.pageIndex);
+    return it == m_pageInvalidatedGeneration.cend() || task.generation >= it->second;
+}
+
+void PDFAsynchronousTileRenderer::onTilesRendered()
+{
+    m_isRendering = false;
+
+    TileTasks tasks = m_future.result();
+    m_future = QFuture<TileTasks>();
+
+    bool isSomethingInserted = false;
+    for (TileTask& task : tasks)
+    {
+        m_pendingKeys.remove(task.key);
+
+        if (!isEnabled() || !isValid(task))
+        {
+            continue;
+        }
+
+        const qint64 cost = task.image.sizeInBytes();
+        if (m_cache->insert(task.key, new QImage(std::move(task.image)), cost))
+        {
+            isSomethingInserted = true;
+
+            // Remember the zoom level, so it can be used as a substitute
+            PDFPageTileKey levelKey = task.key.getLevelKey();
+            auto it = std::find(m_levels.begin(), m_levels.end(), levelKey);
+            if (it != m_levels.end())
+            {
+                m_levels.erase(it);
+            }
+            m_levels.insert(m_levels.begin(), levelKey);
+
+            if (m_levels.size() > MAX_LEVELS)
+            {
+                m_levels.pop_back();
+            }
+        }
+    }
+
+    startRendering();
+
+    if (isSomethingInserted)
+    {
+        Q_EMIT tilesRendered();
+    }
+}
+
 PDFAsynchronousTextLayoutCompiler::PDFAsynchronousTextLayoutCompiler(PDFDrawWidgetProxy* proxy) :
     BaseClass(proxy),
     m_proxy(proxy),
     m_isRunning(false),
     m_cache(std::bind(&PDFAsynchronousTextLayoutCompiler::createTextLayout, this, std::placeholders::_1))
 {
-    connect(&m_textLayoutCompileFutureWatcher, &QFutureWatcher<PDFTextLayoutStorage>::finished, this, &PDFAsynchronousTextLayoutCompiler::onTextLayoutCreated);
+    connect(&m_textLayoutCompileFutureWatcher, &QFutureWatcher<void>::finished, this, &PDFAsynchronousTextLayoutCompiler::onTextLayoutCreated);
 }
 
 void PDFAsynchronousTextLayoutCompiler::start()
@@ -370,11 +643,13 @@ void PDFAsynchronousTextLayoutCompiler::stop(bool clearCache)
         {
             // Stop the engine
             m_state = State::Stopping;
+            cancelFind();
             m_textLayoutCompileFutureWatcher.waitForFinished();
 
             if (clearCache)
             {
-                m_textLayouts = std::nullopt;
+                m_textLayouts.reset();
+                m_sharedTextLayouts.reset();
                 m_cache.clear();
             }
 
@@ -522,7 +797,7 @@ void PDFAsynchronousTextLayoutCompiler::makeTextLayout()
         return;
     }
 
-    if (m_textLayouts.has_value())
+    if (m_textLayouts)
     {
         // Value is computed already
         return;
@@ -548,31 +823,37 @@ void PDFAsynchronousTextLayoutCompiler::makeTextLayout()
 
     PDFCMSPointer cms = m_proxy->getCMSManager()->getCurrentCMS();
 
-    auto createTextLayout = [this, cms, catalog]() -> PDFTextLayoutStorage
+    // Pages nearest to the visible pages are processed first, so progressive
+    // search reports results near the current view as soon as possible.
+    const PDFInteger pageCount = catalog->getPageCount();
+    const std::vector<PDFInteger> activePages = m_proxy->getActivePages();
+    std::vector<PDFInteger> pageOrder = getPageOrder(!activePages.empty() ? activePages.front() : 0, pageCount);
+
+    m_sharedTextLayouts = std::make_shared<PDFTextLayoutStorage>(pageCount);
     {
-        PDFTextLayoutStorage result(catalog->getPageCount());
-        QMutex mutex;
-        auto generateTextLayout = [this, &result, &mutex, cms, catalog](PDFInteger pageIndex)
+        QMutexLocker lock(&m_findMutex);
+        m_compiledPages.assign(pageCount, false);
+    }
+
+    auto createTextLayout = [this, cms, catalog, storage = m_sharedTextLayouts, pageOrder = qMove(pageOrder)]()
+    {
+        auto generateTextLayout = [this, &storage, cms, catalog](PDFInteger pageIndex)
         {
-            if (!catalog->getPage(pageIndex))
+            PDFTextLayout textLayout;
+
+            if (const PDFPage* page = catalog->getPage(pageIndex))
             {
-                // Invalid page index
-                result.setTextLayout(pageIndex, PDFTextLayout(), &mutex);
-                return;
+                PDFTextLayoutGenerator generator(m_proxy->getFeatures(), page, m_proxy->getDocument(), m_proxy->getFontCache(), cms.data(), m_proxy->getOptionalContentActivity(), QTransform(), m_proxy->getMeshQualitySettings());
+                generator.processContents();
+                textLayout = generator.createTextLayout();
+                m_proxy->getProgress()->step();
             }
 
-            const PDFPage* page = catalog->getPage(pageIndex);
-            Q_ASSERT(page);
-
-            PDFTextLayoutGenerator generator(m_proxy->getFeatures(), page, m_proxy->getDocument(), m_proxy->getFontCache(), cms.data(), m_proxy->getOptionalContentActivity(), QTransform(), m_proxy->getMeshQualitySettings());
-            generator.processContents();
-            result.setTextLayout(pageIndex, generator.createTextLayout(), &mutex);
-            m_proxy->getProgress()->step();
+            storage->setTextLayout(pageIndex, textLayout, &m_sharedTextLayoutsMutex);
+            onPageTextLayoutCreated(pageIndex, textLayout);
         };
 
-        auto pageRange = PDFIntegerRange<PDFInteger>(0, catalog->getPageCount());
-        PDFExecutionPolicy::execute(PDFExecutionPolicy::Scope::Page, pageRange.begin(), pageRange.end(), generateTextLayout);
-        return result;
+        PDFExecutionPolicy::execute(PDFExecutionPolicy::Scope::Page, pageOrder.cbegin(), pageOrder.cend(), generateTextLayout);
     };
 
     Q_ASSERT(!m_textLayoutCompileFuture.isRunning());
@@ -580,13 +861,174 @@ void PDFAsynchronousTextLayoutCompiler::makeTextLayout()
     m_textLayoutCompileFutureWatcher.setFuture(m_textLayoutCompileFuture);
 }
 
+void PDFAsynchronousTextLayoutCompiler::find(PDFTextLayoutFinder finder, PDFInteger startPageIndex)
+{
+    cancelFind();
+
+    if (m_state != State::Active || !m_proxy->getDocument())
+    {
+        // Engine is not active, do not search
+        return;
+    }
+
+    // Text layouts of the pages, which are not compiled yet,
+    // are searched by the compilation, when they are created.
+    makeTextLayout();
+
+    const PDFInteger pageCount = m_proxy->getDocument()->getCatalog()->getPageCount();
+    if (pageCount == 0 || !m_sharedTextLayouts)
+    {
+        Q_EMIT findFinished();
+        return;
+    }
+
+    quint64 findId = 0;
+    {
+        QMutexLocker lock(&m_findMutex);
+        findId = m_findId;
+        m_finder = std::make_shared<const PDFTextLayoutFinder>(qMove(finder));
+        m_searchedPages.assign(pageCount, false);
+        m_searchedPageCount = 0;
+    }
+
+    // Search pages, which are already compiled
+    auto findInCompiledPages = [this, findId, storage = m_sharedTextLayouts, pageOrder = getPageOrder(startPageIndex, pageCount)]()
+    {
+        auto findInPage = [this, findId, &storage](PDFInteger pageIndex)
+        {
+            std::shared_ptr<const PDFTextLayoutFinder> finder;
+            {
+                QMutexLocker lock(&m_findMutex);
+                if (findId != m_findId || !m_compiledPages[pageIndex] || m_searchedPages[pageIndex])
+                {
+                    return;
+                }
+
+                m_searchedPages[pageIndex] = true;
+                finder = m_finder;
+            }
+
+            PDFTextLayout textLayout;
+            {
+                QMutexLocker lock(&m_sharedTextLayoutsMutex);
+                textLayout = storage->getTextLayout(pageIndex);
+            }
+
+            reportFindResults(findId, finder->find(textLayout, pageIndex));
+        };
+
+        PDFExecutionPolicy::execute(PDFExecutionPolicy::Scope::Page, pageOrder.cbegin(), pageOrder.cend(), findInPage);
+    };
+
+    m_findFuture = QtConcurrent::run(findInCompiledPages);
+}
+
+void PDFAsynchronousTextLayoutCompiler::cancelFind()
+{
+    {
+        QMutexLocker lock(&m_findMutex);
+        ++m_findId;
+        m_finder.reset();
+    }
+
+    m_findFuture.waitForFinished();
+}
+
+std::vector<PDFInteger> PDFAsynchronousTextLayoutCompiler::getPageOrder(PDFInteger startPageIndex, PDFInteger pageCount)
+{
+    std::vector<PDFInteger> pageOrder;
+    pageOrder.reserve(pageCount);
+
+    startPageIndex = qBound(PDFInteger(0), startPageIndex, qMax(pageCount - 1, PDFInteger(0)));
+    for (PDFInteger offset = 0; pageOrder.size() < size_t(pageCount); ++offset)
+    {
+        if (startPageIndex + offset < pageCount)
+        {
+            pageOrder.push_back(startPageIndex + offset);
+        }
+
+        if (offset > 0 && startPageIndex - offset >= 0)
+        {
+            pageOrder.push_back(startPageIndex - offset);
+        }
+    }
+
+    return pageOrder;
+}
+
+void PDFAsynchronousTextLayoutCompiler::onPageTextLayoutCreated(PDFInteger pageIndex, const PDFTextLayout& textLayout)
+{
+    quint64 findId = 0;
+    std::shared_ptr<const PDFTextLayoutFinder> finder;
+    {
+        QMutexLocker lock(&m_findMutex);
+        m_compiledPages[pageIndex] = true;
+
+        if (!m_finder || m_searchedPages[pageIndex])
+        {
+            return;
+        }
+
+        m_searchedPages[pageIndex] = true;
+        findId = m_findId;
+        finder = m_finder;
+    }
+
+    reportFindResults(findId, finder->find(textLayout, pageIndex));
+}
+
+void PDFAsynchronousTextLayoutCompiler::reportFindResults(quint64 findId, PDFFindResults results)
+{
+    bool isFinished = false;
+    {
+        QMutexLocker lock(&m_findMutex);
+        if (findId != m_findId)
+        {
+            // Search was cancelled
+            return;
+        }
+
+        isFinished = ++m_searchedPageCount == m_searchedPages.size();
+    }
+
+    if (results.empty() && !isFinished)
+    {
+        return;
+    }
+
+    auto report = [this, findId, results = qMove(results), isFinished]()
+    {
+        if (findId != m_findId)
+        {
+            // Search was cancelled
+            return;
+        }
+
+        if (!results.empty())
+        {
+            Q_EMIT textFound(results);
+        }
+
+        if (isFinished)
+        {
+            {
+                QMutexLocker lock(&m_findMutex);
+                m_finder.reset();
+            }
+            Q_EMIT findFinished();
+        }
+    };
+    QMetaObject::invokeMethod(this, report, Qt::QueuedConnection);
+}
+
 void PDFAsynchronousTextLayoutCompiler::onTextLayoutCreated()
 {
     m_proxy->getFontCache()->setCacheShrinkEnabled(this, true);
     m_proxy->getProgress()->finish();
     m_cache.clear();
 
-    m_textLayouts = m_textLayoutCompileFuture.result();
+    // Compiled storage is shared, it is not copied
+    m_textLayouts = m_sharedTextLayouts;
     m_isRunning = false;
     Q_EMIT textLayoutChanged();
 }
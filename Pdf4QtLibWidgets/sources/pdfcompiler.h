@@ -24,6 +24,7 @@
 #include "pdfpainter.h"
 #include "pdftextlayout.h"
 
+#include <QSet>
 #include <QFuture>
 #include <QFutureWatcher>
 #include <QWaitCondition>
@@ -89,6 +90,12 @@ public:
     /// \param limit Cache limit [bytes]
     void setCacheLimit(int limit);
 
+    /// Sets number of device pixels per page point, for which are images decoded
+    /// in newly compiled pages. Pages, which were compiled with lower image resolution,
+    /// are recompiled, when they are requested. Zero means full resolution.
+    /// \param imageResolutionScale Device pixels per page point
+    void setImageResolutionScale(PDFReal imageResolutionScale);
+
     enum class State
     {
         Inactive,
@@ -105,11 +112,18 @@ public:
     /// Tries to retrieve precompiled page from the cache. If page is not found,
     /// then nullptr is returned (no exception is thrown). If \p compile is set to true,
     /// and page is not found, and compiler is active, then new asynchronous compile
-    /// task is performed.
+    /// task is performed. If page is found, but its images have insufficient resolution,
+    /// then page is returned and asynchronous compile task is performed too.
     /// \param pageIndex Index of page
     /// \param compile Compile the page, if it is not found in the cache
     const PDFPrecompiledPage* getCompiledPage(PDFInteger pageIndex, bool compile);
 
+    /// Returns precompiled page from the cache, or nullptr, if page is not
+    /// in the cache. Page remains valid, even if it is removed from the cache,
+    /// so it can be used in other threads. Page is not compiled.
+    /// \param pageIndex Index of page
+    std::shared_ptr<const PDFPrecompiledPage> getSharedCompiledPage(PDFInteger pageIndex) const;
+
     /// Performs smart cache clear. Too old pages are removed from the cache,
     /// but only if these pages are not in active pages. Use this function to
     /// clear cache to avoid huge memory consumption.
@@ -132,9 +146,10 @@ private:
     struct CompileTask
     {
         CompileTask() = default;
-        CompileTask(PDFInteger pageIndex) : pageIndex(pageIndex) { }
+        CompileTask(PDFInteger pageIndex, PDFReal imageResolutionScale) : pageIndex(pageIndex), imageResolutionScale(imageResolutionScale) { }
 
         PDFInteger pageIndex = 0;
+        PDFReal imageResolutionScale = 0.0;
         bool finished = false;
         PDFPrecompiledPage precompiledPage;
     };
@@ -145,13 +160,155 @@ private:
     PDFAsynchronousPageCompilerWorkerThread* m_thread = nullptr;
 
     PDFDrawWidgetProxy* m_proxy;
-    QCache<PDFInteger, PDFPrecompiledPage>* m_cache;
+    QCache<PDFInteger, std::shared_ptr<PDFPrecompiledPage>>* m_cache;
+    PDFReal m_imageResolutionScale = 0.0;
 
     /// This task is protected by mutex. Every access to this
     /// variable must be done with locked mutex.
     std::map<PDFInteger, CompileTask> m_tasks;
 };
 
+/// Key of the page tile. Page image of given size is divided into square tiles
+/// of fixed size, tiles are indexed by row and column. Size of the page image
+/// determines zoom level of the tile.
+struct PDFPageTileKey
+{
+    bool operator==(const PDFPageTileKey&) const = default;
+
+    /// Returns key of the zoom level of this tile (key with zero row and column)
+    PDFPageTileKey getLevelKey() const { PDFPageTileKey key = *this; key.row = 0; key.column = 0; return key; }
+
+    PDFInteger pageIndex = -1;
+    QSize pageImageSize;
+    int row = 0;
+    int column = 0;
+    PageRotation rotation = PageRotation::None;
+    PDFRenderer::Features features;
+    qreal devicePixelRatio = 1.0;
+
+    /// Paper color, tiles are filled with it (invalid color means transparent tiles)
+    QColor paperColor;
+};
+
+inline size_t qHash(const PDFPageTileKey& key, size_t seed = 0)
+{
+    return qHashMulti(seed, key.pageIndex, key.pageImageSize.width(), key.pageImageSize.height(), key.row, key.column,
+                      static_cast<int>(key.rotation), static_cast<int>(key.features), key.devicePixelRatio, key.paperColor.rgba());
+}
+
+/// Asynchronous tile renderer renders tiles of page images from precompiled pages
+/// in worker threads and stores them in the cache. Cache size can be set. Draw widget
+/// proxy then draws cached tiles instead of replaying the precompiled page on each
+/// repaint. Tiles of other zoom levels can be used as a substitute, until
+/// the requested tiles are rendered.
+class PDFAsynchronousTileRenderer : public QObject
+{
+    Q_OBJECT
+
+private:
+    using BaseClass = QObject;
+
+public:
+    explicit PDFAsynchronousTileRenderer(PDFDrawWidgetProxy* proxy);
+    virtual ~PDFAsynchronousTileRenderer() override;
+
+    /// Tile size in logical pixels
+    static constexpr int TILE_SIZE = 256;
+
+    /// Maximal number of tiles rendered in one batch
+    static constexpr size_t MAX_BATCH_SIZE = 64;
+
+    /// Maximal number of remembered zoom levels
+    static constexpr size_t MAX_LEVELS = 32;
+
+    /// Sets cache limit in bytes. If limit is zero, then tile cache is disabled.
+    /// \param limit Cache limit [bytes]
+    void setCacheLimit(int limit);
+
+    /// Returns true, if tile cache is enabled
+    bool isEnabled() const;
+
+    /// Returns true, if given count of tiles fits into the cache. If it doesn't,
+    /// tiles would be evicted from the cache before being drawn.
+    /// \param tileCount Tile count
+    /// \param devicePixelRatio Device pixel ratio
+    bool canCacheTiles(int tileCount, qreal devicePixelRatio) const;
+
+    /// Returns tile from the cache, or nullptr, if tile is not rendered yet.
+    /// \param key Tile key
+    const QImage* getTile(const PDFPageTileKey& key) const;
+
+    /// Returns cached zoom levels of the page, which can be used as a substitute
+    /// for the zoom level of \p key. Levels are sorted, so nearest zoom level
+    /// is first.
+    /// \param key Tile key
+    std::vector<PDFPageTileKey> getSubstituteLevels(const PDFPageTileKey& key) const;
+
+    /// Requests asynchronous rendering of the tile. Rendering is started,
+    /// when \p startRendering is called.
+    /// \param key Tile key
+    /// \param compiledPage Compiled page (shared with the page compiler cache)
+    /// \param cropBox Page's crop box
+    /// \param pagePointToTilePointMatrix Page point to tile point matrix
+    void requestTile(const PDFPageTileKey& key,
+                     std::shared_ptr<const PDFPrecompiledPage> compiledPage,
+                     const QRectF& cropBox,
+                     const QTransform& pagePointToTilePointMatrix);
+
+    /// Removes all requests, which are not being rendered yet
+    void clearRequests();
+
+    /// Starts rendering of the requested tiles (if rendering is not running)
+    void startRendering();
+
+    /// Removes tiles of given pages from the cache
+    /// \param all Remove all tiles
+    /// \param pages Pages, whose tiles are removed
+    void invalidate(bool all, const std::vector<PDFInteger>& pages);
+
+signals:
+    void tilesRendered();
+
+private:
+    struct TileTask
+    {
+        PDFPageTileKey key;
+        QRectF cropBox;
+        QTransform matrix;
+        quint64 generation = 0;
+        std::shared_ptr<const PDFPrecompiledPage> compiledPage;
+        QImage image;
+    };
+
+    using TileTasks = std::vector<TileTask>;
+
+    void onTilesRendered();
+
+    /// Returns true, if tile task result is still valid
+    bool isValid(const TileTask& task) const;
+
+    QCache<PDFPageTileKey, QImage>* m_cache;
+
+    /// Tiles waiting for rendering
+    TileTasks m_requests;
+
+    /// Keys of tiles waiting for rendering or being rendered
+    QSet<PDFPageTileKey> m_pendingKeys;
+
+    /// Recently rendered zoom levels, most recent first
+    std::vector<PDFPageTileKey> m_levels;
+
+    /// Generation is increased on each invalidation. Rendered tiles
+    /// requested before the invalidation of their page are discarded.
+    quint64 m_generation = 0;
+    quint64 m_allInvalidatedGeneration = 0;
+    std::map<PDFInteger, quint64> m_pageInvalidatedGeneration;
+
+    bool m_isRendering = false;
+    QFuture<TileTasks> m_future;
+    QFutureWatcher<TileTasks> m_futureWatcher;
+};
+
 class PDF4QTLIBWIDGETSSHARED_EXPORT PDFAsynchronousTextLayoutCompiler : public QObject
 {
     Q_OBJECT
@@ -210,24 +367,75 @@ public:
     void makeTextLayout();
 
     /// Returns true, if text layout is ready
-    bool isTextLayoutReady() const { return m_textLayouts.has_value(); }
+    bool isTextLayoutReady() const { return m_textLayouts != nullptr; }
 
     /// Returns text layout storage (if it is ready), or nullptr
-    const PDFTextLayoutStorage* getTextLayoutStorage() const { return isTextLayoutReady() ? &m_textLayouts.value() : nullptr; }
+    const PDFTextLayoutStorage* getTextLayoutStorage() const { return m_textLayouts.get(); }
+
+    /// Starts progressive search. Function is asynchronous, it returns immediately.
+    /// Pages are searched in order of their distance from the page \p startPageIndex,
+    /// as soon as their text layouts are available, and results of each page are
+    /// reported by signal \p textFound. Already compiled text layouts are reused,
+    /// text layout of the document is created, if it is not created yet. Previous
+    /// search is cancelled. When all pages are searched, signal \p findFinished is emitted.
+    /// \param finder Text finder
+    /// \param startPageIndex Index of the page, from which search starts
+    void find(PDFTextLayoutFinder finder, PDFInteger startPageIndex);
+
+    /// Cancels progressive search. No results are reported after this call.
+    void cancelFind();
+
+    /// Returns true, if progressive search is running
+    bool isFindRunning() const { return m_finder != nullptr; }
 
 signals:
     void textLayoutChanged();
 
+    /// Results of the progressive search for one page
+    void textFound(PDFFindResults results);
+
+    /// Progressive search has finished, all pages were searched
+    void findFinished();
+
 private:
     void onTextLayoutCreated();
 
+    /// Returns page indices ordered by distance from the start page
+    /// \param startPageIndex Start page index
+    /// \param pageCount Page count
+    static std::vector<PDFInteger> getPageOrder(PDFInteger startPageIndex, PDFInteger pageCount);
+
+    /// Called from the worker thread, when text layout of the page is created.
+    /// Page is searched by the active finder, if it wasn't searched yet.
+    void onPageTextLayoutCreated(PDFInteger pageIndex, const PDFTextLayout& textLayout);
+
+    /// Reports results of the search of one page to the main thread
+    void reportFindResults(quint64 findId, PDFFindResults results);
+
     PDFDrawWidgetProxy* m_proxy;
     State m_state = State::Inactive;
     bool m_isRunning;
-    std::optional<PDFTextLayoutStorage> m_textLayouts;
-    QFuture<PDFTextLayoutStorage> m_textLayoutCompileFuture;
-    QFutureWatcher<PDFTextLayoutStorage> m_textLayoutCompileFutureWatcher;
+
+    /// Storage of compiled text layouts. It is set, when compilation is finished,
+    /// and it shares the storage with \p m_sharedTextLayouts (no copy is made).
+    std::shared_ptr<const PDFTextLayoutStorage> m_textLayouts;
+    QFuture<void> m_textLayoutCompileFuture;
+    QFutureWatcher<void> m_textLayoutCompileFutureWatcher;
     PDFTextLayoutCache m_cache;
+
+    /// Storage of text layouts being compiled. Text layouts of compiled pages
+    /// are read by the progressive search, writes and reads are guarded by mutex.
+    std::shared_ptr<PDFTextLayoutStorage> m_sharedTextLayouts;
+    QMutex m_sharedTextLayoutsMutex;
+
+    /// State of the progressive search, it is guarded by mutex
+    QMutex m_findMutex;
+    quint64 m_findId = 0;
+    std::shared_ptr<const PDFTextLayoutFinder> m_finder;
+    std::vector<bool> m_compiledPages;
+    std::vector<bool> m_searchedPages;
+    size_t m_searchedPageCount = 0;
+    QFuture<void> m_findFuture;
 };
 
 }   // namespace pdf
@@ -27,6 +27,7 @@
 #include "pdfpainterutils.h"
 
 #include <QTimer>
+#include <QtMath>
 #include <QPainter>
 #include <QFontMetrics>
 #include <QScreen>
@@ -45,7 +46,9 @@ PDFDrawSpaceController::PDFDrawSpaceController(QObject* parent) :
     m_verticalSpacingMM(5.0),
     m_horizontalSpacingMM(1.0),
     m_pageRotation(PageRotation::None),
-    m_fontCache(DEFAULT_FONT_CACHE_LIMIT, DEFAULT_REALIZED_FONT_CACHE_LIMIT)
+    m_fontCache(DEFAULT_FONT_CACHE_LIMIT, DEFAULT_REALIZED_FONT_CACHE_LIMIT),
+    m_imageCache(DEFAULT_IMAGE_CACHE_LIMIT),
+    m_bytecodeCache(DEFAULT_BYTECODE_CACHE_LIMIT)
 {
 
 }
@@ -61,6 +64,8 @@ void PDFDrawSpaceController::setDocument(const PDFModifiedDocument& document)
     {
         m_document = document;
         m_fontCache.setDocument(document);
+        m_imageCache.setDocument(document);
+        m_bytecodeCache.setDocument(document);
         m_optionalContentActivity = document.getOptionalContentActivity();
 
         // If document is not being reset, then recalculation is not needed,
@@ -466,6 +471,7 @@ PDFDrawWidgetProxy::PDFDrawWidgetProxy(QObject* parent) :
     m_horizontalScrollbar(nullptr),
     m_features(PDFRenderer::getDefaultFeatures()),
     m_compiler(new PDFAsynchronousPageCompiler(this)),
+    m_tileRenderer(new PDFAsynchronousTileRenderer(this)),
     m_textLayoutCompiler(new PDFAsynchronousTextLayoutCompiler(this)),
     m_rasterizer(new PDFRasterizer(this)),
     m_progress(nullptr),
@@ -478,6 +484,8 @@ PDFDrawWidgetProxy::PDFDrawWidgetProxy(QObject* parent) :
     connect(m_controller, &PDFDrawSpaceController::pageImageChanged, this, &PDFDrawWidgetProxy::pageImageChanged);
     connect(m_compiler, &PDFAsynchronousPageCompiler::renderingError, this, &PDFDrawWidgetProxy::renderingError);
     connect(m_compiler, &PDFAsynchronousPageCompiler::pageImageChanged, this, &PDFDrawWidgetProxy::pageImageChanged);
+    connect(this, &PDFDrawWidgetProxy::pageImageChanged, m_tileRenderer, &PDFAsynchronousTileRenderer::invalidate);
+    connect(m_tileRenderer, &PDFAsynchronousTileRenderer::tilesRendered, this, &PDFDrawWidgetProxy::repaintNeeded);
     connect(m_textLayoutCompiler, &PDFAsynchronousTextLayoutCompiler::textLayoutChanged, this, &PDFDrawWidgetProxy::onTextLayoutChanged);
     connect(m_cacheClearTimer, &QTimer::timeout, this, &PDFDrawWidgetProxy::performPageCacheClear);
 }
@@ -563,6 +571,12 @@ void PDFDrawWidgetProxy::update()
     m_deviceSpaceUnitToPixel = m_pixelPerMM * m_zoom;
     m_pixelToDeviceSpaceUnit = 1.0 / m_deviceSpaceUnitToPixel;
 
+    // Images of compiled pages need not to be decoded at higher resolution, than they
+    // are displayed. Scale is rounded up to the power of two, so pages are not recompiled
+    // at each zoom step.
+    const PDFReal pixelPerPagePoint = m_deviceSpaceUnitToPixel * PDF_POINT_TO_MM * widget->devicePixelRatioF();
+    m_compiler->setImageResolutionScale(qPow(2.0, qCeil(std::log2(pixelPerPagePoint))));
+
     m_layout.clear();
 
     // Switch to the first block, if we haven't selected any, otherwise fix active
@@ -756,7 +770,7 @@ QTransform PDFDrawWidgetProxy::createPagePointToDevicePointMatrix(const PDFPage*
 
 void PDFDrawWidgetProxy::draw(QPainter* painter, QRect rect)
 {
-    drawPages(painter, rect, m_features);
+    drawPagesImpl(painter, rect, m_features, true);
 
     for (IDocumentDrawInterface* drawInterface : m_drawInterfaces)
     {
@@ -777,10 +791,23 @@ QColor PDFDrawWidgetProxy::getPaperColor()
 }
 
 void PDFDrawWidgetProxy::drawPages(QPainter* painter, QRect rect, PDFRenderer::Features features)
+{
+    drawPagesImpl(painter, rect, features, false);
+}
+
+void PDFDrawWidgetProxy::drawPagesImpl(QPainter* painter, QRect rect, PDFRenderer::Features features, bool allowTileCache)
 {
     painter->fillRect(rect, Qt::lightGray);
     QTransform baseMatrix = painter->worldTransform();
 
+    // Tiles are rendered in widget pixels, so we can't use them, if painter is transformed
+    const bool useTileCache = allowTileCache && m_tileRenderer->isEnabled() && baseMatrix.isIdentity();
+    if (useTileCache)
+    {
+        // Tiles requested in previous repaints may not be visible anymore
+        m_tileRenderer->clearRequests();
+    }
+
     // Use current paper color (it can be a bit different from white)
     QColor paperColor = getPaperColor();
 
@@ -809,7 +836,15 @@ void PDFDrawWidgetProxy::drawPages(QPainter* painter, QRect rect, PDFRenderer::F
 
                 const PDFPage* page = m_controller->getDocument()->getCatalog()->getPage(item.pageIndex);
                 QTransform matrix = QTransform(createPagePointToDevicePointMatrix(page, placedRect)) * baseMatrix;
-                compiledPage->draw(painter, page->getCropBox(), matrix, features, groupInfo.transparency);
+                if (useTileCache && qFuzzyCompare(groupInfo.transparency, 1.0))
+                {
+                    drawPageTiles(painter, rect, item.pageIndex, page, compiledPage, placedRect, matrix, features, groupInfo.drawPaper ? paperColor : QColor());
+                }
+                else
+                {
+                    compiledPage->draw(painter, page->getCropBox(), matrix, features, groupInfo.transparency);
+                }
+
                 PDFTextLayoutGetter layoutGetter = m_textLayoutCompiler->getTextLayoutLazy(item.pageIndex);
 
                 // Draw text blocks/text lines, if it is enabled
@@ -919,6 +954,150 @@ void PDFDrawWidgetProxy::drawPages(QPainter* painter, QRect rect, PDFRenderer::F
             }
         }
     }
+
+    if (useTileCache)
+    {
+        m_tileRenderer->startRendering();
+    }
+}
+
+void PDFDrawWidgetProxy::drawPageTiles(QPainter* painter,
+                                       QRect rect,
+                                       PDFInteger pageIndex,
+                                       const PDFPage* page,
+                                       const PDFPrecompiledPage* compiledPage,
+                                       QRect placedRect,
+                                       const QTransform& matrix,
+                                       PDFRenderer::Features features,
+                                       QColor paperColor)
+{
+    constexpr int tileSize = PDFAsynchronousTileRenderer::TILE_SIZE;
+    constexpr int maxSubstituteTiles = 16;
+
+    // Visible part of the page in page image coordinates
+    const QRect visibleRect = placedRect.intersected(rect).translated(-placedRect.topLeft());
+    if (visibleRect.isEmpty())
+    {
+        return;
+    }
+
+    const int firstColumn = visibleRect.left() / tileSize;
+    const int lastColumn = visibleRect.right() / tileSize;
+    const int firstRow = visibleRect.top() / tileSize;
+    const int lastRow = visibleRect.bottom() / tileSize;
+
+    PDFPageTileKey levelKey;
+    levelKey.pageIndex = pageIndex;
+    levelKey.pageImageSize = placedRect.size();
+    levelKey.rotation = getPageRotation();
+    levelKey.features = features;
+    levelKey.devicePixelRatio = painter->device()->devicePixelRatio();
+    levelKey.paperColor = paperColor;
+
+    const int tileCount = (lastColumn - firstColumn + 1) * (lastRow - firstRow + 1);
+    if (!m_tileRenderer->canCacheTiles(tileCount, levelKey.devicePixelRatio))
+    {
+        // Cache is too small, tiles would be evicted before they are drawn
+        compiledPage->draw(painter, page->getCropBox(), matrix, features, 1.0);
+        return;
+    }
+
+    const std::vector<PDFPageTileKey> substituteLevels = m_tileRenderer->getSubstituteLevels(levelKey);
+    const std::shared_ptr<const PDFPrecompiledPage> sharedCompiledPage = m_compiler->getSharedCompiledPage(pageIndex);
+
+    // Draws tile using tiles of the substitute zoom level. If some
+    // of the tiles of the zoom level is missing, nothing is drawn.
+    auto drawSubstituteTile = [&](const QRect& pageTileRect, const QRect& tileRect, const PDFPageTileKey& substituteLevel)
+    {
+        const PDFReal scaleX = PDFReal(substituteLevel.pageImageSize.width()) / PDFReal(placedRect.width());
+        const PDFReal scaleY = PDFReal(substituteLevel.pageImageSize.height()) / PDFReal(placedRect.height());
+
+        // Tiles on the right/bottom border of the page can overlap the page image
+        const QRect clippedPageTileRect = pageTileRect.intersected(QRect(QPoint(0, 0), placedRect.size()));
+        const int maxColumn = (substituteLevel.pageImageSize.width() - 1) / tileSize;
+        const int maxRow = (substituteLevel.pageImageSize.height() - 1) / tileSize;
+
+        const int substituteFirstColumn = qFloor(clippedPageTileRect.left() * scaleX / tileSize);
+        const int substituteLastColumn = qMin(qFloor(((clippedPageTileRect.right() + 1) * scaleX - 1) / tileSize), maxColumn);
+        const int substituteFirstRow = qFloor(clippedPageTileRect.top() * scaleY / tileSize);
+        const int substituteLastRow = qMin(qFloor(((clippedPageTileRect.bottom() + 1) * scaleY - 1) / tileSize), maxRow);
+
+        if ((substituteLastColumn - substituteFirstColumn + 1) * (substituteLastRow - substituteFirstRow + 1) > maxSubstituteTiles)
+        {
+            return false;
+        }
+
+        std::vector<std::pair<QRectF, const QImage*>> substituteTiles;
+        for (int row = substituteFirstRow; row <= substituteLastRow; ++row)
+        {
+            for (int column = substituteFirstColumn; column <= substituteLastColumn; ++column)
+            {
+                PDFPageTileKey key = substituteLevel;
+                key.row = row;
+                key.column = column;
+
+                const QImage* image = m_tileRenderer->getTile(key);
+                if (!image)
+                {
+                    return false;
+                }
+
+                QRectF targetRect(placedRect.left() + column * tileSize / scaleX,
+                                  placedRect.top() + row * tileSize / scaleY,
+                                  tileSize / scaleX,
+                                  tileSize / scaleY);
+                substituteTiles.emplace_back(targetRect, image);
+            }
+        }
+
+        painter->save();
+        painter->setClipRect(tileRect, Qt::IntersectClip);
+        painter->setRenderHint(QPainter::SmoothPixmapTransform, true);
+        for (const auto& substituteTile : substituteTiles)
+        {
+            painter->drawImage(substituteTile.first, *substituteTile.second);
+        }
+        painter->restore();
+        return true;
+    };
+
+    QRegion directDrawRegion;
+    for (int row = firstRow; row <= lastRow; ++row)
+    {
+        for (int column = firstColumn; column <= lastColumn; ++column)
+        {
+            PDFPageTileKey key = levelKey;
+            key.row = row;
+            key.column = column;
+
+            const QRect pageTileRect(column * tileSize, row * tileSize, tileSize, tileSize);
+            const QRect tileRect = pageTileRect.translated(placedRect.topLeft());
+
+            if (const QImage* image = m_tileRenderer->getTile(key))
+            {
+                painter->drawImage(tileRect, *image);
+                continue;
+            }
+
+            // Tile is rendered in its own coordinate system, with tile's top left corner at origin
+            QTransform tileMatrix = createPagePointToDevicePointMatrix(page, placedRect.translated(-tileRect.topLeft()));
+            m_tileRenderer->requestTile(key, sharedCompiledPage, page->getCropBox(), tileMatrix);
+
+            auto isDrawn = [&](const PDFPageTileKey& substituteLevel) { return drawSubstituteTile(pageTileRect, tileRect, substituteLevel); };
+            if (std::none_of(substituteLevels.cbegin(), substituteLevels.cend(), isDrawn))
+            {
+                directDrawRegion += tileRect;
+            }
+        }
+    }
+
+    if (!directDrawRegion.isEmpty())
+    {
+        painter->save();
+        painter->setClipRegion(directDrawRegion, Qt::IntersectClip);
+        compiledPage->draw(painter, page->getCropBox(), matrix, features, 1.0);
+        painter->restore();
+    }
 }
 
 QImage PDFDrawWidgetProxy::drawThumbnailImage(PDFInteger pageIndex, int pixelSize) const
@@ -23,6 +23,8 @@
 #include "pdfdocument.h"
 #include "pdfrenderer.h"
 #include "pdffont.h"
+#include "pdfimage.h"
+#include "pdfcontentstreambytecode.h"
 #include "pdfdocumentdrawinterface.h"
 #include "pdfwidgetsnapshot.h"
 
@@ -42,6 +44,7 @@ class PDFCMSManager;
 class PDFTextLayoutGetter;
 class PDFWidgetAnnotationManager;
 class PDFAsynchronousPageCompiler;
+class PDFAsynchronousTileRenderer;
 class PDFAsynchronousTextLayoutCompiler;
 
 /// This class controls draw space - page layout. Pages are divided into blocks
@@ -115,6 +118,12 @@ public:
     /// Returns the font cache
     PDFFontCache* getFontCache() { return &m_fontCache; }
 
+    /// Returns the image cache
+    PDFImageCache* getImageCache() { return &m_imageCache; }
+
+    /// Returns the bytecode cache
+    PDFContentStreamBytecodeCache* getBytecodeCache() { return &m_bytecodeCache; }
+
     /// Returns optional content activity
     const PDFOptionalContentActivity* getOptionalContentActivity() const { return m_optionalContentActivity; }
 
@@ -174,6 +183,12 @@ private:
 
     /// Font cache
     PDFFontCache m_fontCache;
+
+    /// Image cache
+    PDFImageCache m_imageCache;
+
+    /// Bytecode cache
+    PDFContentStreamBytecodeCache m_bytecodeCache;
 };
 
 /// This is a proxy class to draw space controller using widget. We have two spaces, pixel space
@@ -328,10 +343,13 @@ public:
 
     const PDFDocument* getDocument() const { return m_controller->getDocument(); }
     PDFFontCache* getFontCache() const { return m_controller->getFontCache(); }
+    PDFImageCache* getImageCache() const { return m_controller->getImageCache(); }
+    PDFContentStreamBytecodeCache* getBytecodeCache() const { return m_controller->getBytecodeCache(); }
     const PDFOptionalContentActivity* getOptionalContentActivity() const { return m_controller->getOptionalContentActivity(); }
     PDFRenderer::Features getFeatures() const;
     const PDFMeshQualitySettings& getMeshQualitySettings() const { return m_meshQualitySettings; }
     PDFAsynchronousPageCompiler* getCompiler() const { return m_compiler; }
+    PDFAsynchronousTileRenderer* getTileRenderer() const { return m_tileRenderer; }
     const PDFCMSManager* getCMSManager() const;
     PDFProgress* getProgress() const { return m_progress; }
     void setProgress(PDFProgress* progress) { m_progress = progress; }
@@ -429,6 +447,37 @@ private:
     /// Converts rectangle from device space to the pixel space
     QRectF fromDeviceSpace(const QRectF& rect) const;
 
+    /// Draws the actually visible pages on the painter using the rectangle.
+    /// If \p allowTileCache is true, then page contents are drawn using
+    /// cached page tiles, if it is possible.
+    /// \param painter Painter to paint the PDF pages
+    /// \param rect Rectangle in which the content is painted
+    /// \param features Rendering features
+    /// \param allowTileCache Allow use of the tile cache
+    void drawPagesImpl(QPainter* painter, QRect rect, PDFRenderer::Features features, bool allowTileCache);
+
+    /// Draws page contents using cached page tiles. Missing tiles are requested
+    /// to be rendered. Meanwhile, tiles of other zoom levels are drawn instead,
+    /// or, if there are none, page contents are drawn directly.
+    /// \param painter Painter to paint the page
+    /// \param rect Rectangle in which the content is painted
+    /// \param pageIndex Page index
+    /// \param page Page
+    /// \param compiledPage Compiled page
+    /// \param placedRect Page rectangle on the painter
+    /// \param matrix Page point to device point matrix
+    /// \param features Rendering features
+    /// \param paperColor Paper color (invalid color, if paper is not drawn)
+    void drawPageTiles(QPainter* painter,
+                       QRect rect,
+                       PDFInteger pageIndex,
+                       const PDFPage* page,
+                       const PDFPrecompiledPage* compiledPage,
+                       QRect placedRect,
+                       const QTransform& matrix,
+                       PDFRenderer::Features features,
+                       QColor paperColor);
+
     void performPageCacheClear();
 
     void onTextLayoutChanged();
@@ -517,6 +566,9 @@ private:
     /// Page compiler
     PDFAsynchronousPageCompiler* m_compiler;
 
+    /// Renderer of cached page tiles
+    PDFAsynchronousTileRenderer* m_tileRenderer;
+
     /// Text layout compiler
     PDFAsynchronousTextLayoutCompiler* m_textLayoutCompiler;
 
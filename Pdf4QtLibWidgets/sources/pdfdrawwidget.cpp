@@ -98,9 +98,11 @@ void PDFWidget::updateRenderer(RendererEngine engine)
     m_proxy->updateRenderer(m_rendererEngine);
 }
 
-void PDFWidget::updateCacheLimits(int compiledPageCacheLimit, int thumbnailsCacheLimit, int fontCacheLimit, int instancedFontCacheLimit)
+void PDFWidget::updateCacheLimits(int compiledPageCacheLimit, int thumbnailsCacheLimit, int fontCacheLimit, int instancedFontCacheLimit, int pageTileCacheLimit, qint64 imageCacheLimit)
 {
     m_proxy->getCompiler()->setCacheLimit(compiledPageCacheLimit);
+    m_proxy->getTileRenderer()->setCacheLimit(pageTileCacheLimit);
+    m_proxy->getImageCache()->setCacheLimit(imageCacheLimit);
     QPixmapCache::setCacheLimit(qMax(thumbnailsCacheLimit, 16384));
     m_proxy->getFontCache()->setCacheLimits(fontCacheLimit, instancedFontCacheLimit);
 }
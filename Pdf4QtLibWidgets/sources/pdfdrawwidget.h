@@ -83,7 +83,9 @@ public:
     /// \param thumbnailsCacheLimit Thumbnail image cache limit [kB]
     /// \param fontCacheLimit Font cache limit [-]
     /// \param instancedFontCacheLimit Instanced font cache limit [-]
-    void updateCacheLimits(int compiledPageCacheLimit, int thumbnailsCacheLimit, int fontCacheLimit, int instancedFontCacheLimit);
+    /// \param pageTileCacheLimit Page tile cache limit [bytes], zero disables the tile cache
+    /// \param imageCacheLimit Decoded image cache limit [bytes], zero disables the image cache
+    void updateCacheLimits(int compiledPageCacheLimit, int thumbnailsCacheLimit, int fontCacheLimit, int instancedFontCacheLimit, int pageTileCacheLimit, qint64 imageCacheLimit);
 
     const PDFCMSManager* getCMSManager() const { return m_cmsManager; }
     PDFToolManager* getToolManager() const { return m_toolManager; }
@@ -334,7 +334,7 @@ PDFFindTextTool::PDFFindTextTool(PDFDrawWidgetProxy* proxy, QAction* prevAction,
     m_selectedResultIndex(0)
 {
     PDFAsynchronousTextLayoutCompiler* compiler = getProxy()->getTextLayoutCompiler();
-    connect(compiler, &PDFAsynchronousTextLayoutCompiler::textLayoutChanged, this, &PDFFindTextTool::performSearch);
+    connect(compiler, &PDFAsynchronousTextLayoutCompiler::textFound, this, &PDFFindTextTool::onTextFound);
     connect(m_prevAction, &QAction::triggered, this, &PDFFindTextTool::onActionPrevious);
     connect(m_nextAction, &QAction::triggered, this, &PDFFindTextTool::onActionNext);
 
@@ -358,6 +358,7 @@ void PDFFindTextTool::drawPage(QPainter* painter,
 
 void PDFFindTextTool::clearResults()
 {
+    getProxy()->getTextLayoutCompiler()->cancelFind();
     m_findResults.clear();
     m_selectedResultIndex = 0;
     m_textSelection.dirty();
@@ -497,15 +498,7 @@ void PDFFindTextTool::onSearchText()
         return;
     }
 
-    pdf::PDFAsynchronousTextLayoutCompiler* compiler = getProxy()->getTextLayoutCompiler();
-    if (compiler->isTextLayoutReady())
-    {
-        performSearch();
-    }
-    else
-    {
-        compiler->makeTextLayout();
-    }
+    performSearch();
 }
 
 void PDFFindTextTool::onActionFirst()
@@ -572,13 +565,6 @@ void PDFFindTextTool::performSearch()
         return;
     }
 
-    PDFAsynchronousTextLayoutCompiler* compiler = getProxy()->getTextLayoutCompiler();
-    if (!compiler->isTextLayoutReady())
-    {
-        // Text layout is not ready yet
-        return;
-    }
-
     // Prepare string to search
     QString expression = m_parameters.phrase;
 
@@ -591,12 +577,12 @@ void PDFFindTextTool::performSearch()
 
     pdf::PDFTextFlow::FlowFlags flowFlags = pdf::PDFTextFlow::SeparateBlocks;
 
-    const pdf::PDFTextLayoutStorage* textLayoutStorage = compiler->getTextLayoutStorage();
+    std::optional<pdf::PDFTextLayoutFinder> finder;
     if (!useRegularExpression)
     {
         // Use simple text search
         Qt::CaseSensitivity caseSensitivity = m_parameters.isCaseSensitive ? Qt::CaseSensitive : Qt::CaseInsensitive;
-        m_findResults = textLayoutStorage->find(expression, caseSensitivity, flowFlags);
+        finder.emplace(expression, caseSensitivity, flowFlags);
     }
     else
     {
@@ -607,12 +593,36 @@ void PDFFindTextTool::performSearch()
             patternOptions |= QRegularExpression::CaseInsensitiveOption;
         }
 
-        QRegularExpression regularExpression(expression, patternOptions);
-        m_findResults = textLayoutStorage->find(regularExpression, flowFlags);
+        finder.emplace(QRegularExpression(expression, patternOptions), flowFlags);
+    }
+
+    // Results are reported page by page, pages near the current view first
+    const std::vector<PDFInteger> activePages = getProxy()->getActivePages();
+    getProxy()->getTextLayoutCompiler()->find(qMove(*finder), !activePages.empty() ? activePages.front() : 0);
+}
+
+void PDFFindTextTool::onTextFound(PDFFindResults results)
+{
+    if (!isActive() || results.empty())
+    {
+        return;
     }
 
+    // Keep the selected result selected, results are sorted by page
+    std::optional<PDFFindResult> selectedResult;
+    if (m_selectedResultIndex < m_findResults.size())
+    {
+        selectedResult = m_findResults[m_selectedResultIndex];
+    }
+
+    m_findResults.insert(m_findResults.end(), std::make_move_iterator(results.begin()), std::make_move_iterator(results.end()));
     std::sort(m_findResults.begin(), m_findResults.end());
-    m_selectedResultIndex = 0;
+
+    if (selectedResult)
+    {
+        m_selectedResultIndex = std::distance(m_findResults.begin(), std::lower_bound(m_findResults.begin(), m_findResults.end(), *selectedResult));
+    }
+
     m_textSelection.dirty();
     getProxy()->repaintNeeded();
 
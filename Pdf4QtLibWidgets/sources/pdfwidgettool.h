@@ -201,6 +201,7 @@ private:
     void onActionPrevious();
     void onActionNext();
     void onDialogRejected();
+    void onTextFound(PDFFindResults results);
 
     void setCurrentResultIndex(size_t index);
     void performSearch();
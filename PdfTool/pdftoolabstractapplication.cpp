@@ -311,6 +311,8 @@ void PDFToolAbstractApplication::initializeCommandLineParser(QCommandLineParser*
         parser->addOption(QCommandLineOption("render-show-page-stat", "Show page rendering statistics."));
         parser->addOption(QCommandLineOption("render-msaa-samples", "MSAA sample count for GPU rendering.", "samples", "4"));
         parser->addOption(QCommandLineOption("render-rasterizers", "Number of rasterizer contexts.", "rasterizers", QString::number(pdf::PDFRasterizerPool::getDefaultRasterizerCount())));
+        parser->addOption(QCommandLineOption("render-encoders", "Number of threads encoding and writing page images.", "encoders", QString::number(pdf::PDFRasterizerPool::getDefaultEncoderCount())));
+        parser->addOption(QCommandLineOption("render-band-height", "Render page images in horizontal bands of given height (in pixels), so large images need not to be in memory. Only PNG format is supported. Zero turns banded rendering off.", "pixels", "0"));
     }
 
     if (optionFlags.testFlag(Optimize))
@@ -340,6 +342,12 @@ void PDFToolAbstractApplication::initializeCommandLineParser(QCommandLineParser*
         parser->addOption(QCommandLineOption("enc-owner-password", "Owner password.", "owner password"));
         parser->addOption(QCommandLineOption("enc-permissions", "Document permissions (flags represented as a number).", "permissions"));
     }
+
+    if (optionFlags.testFlag(DocumentWrite))
+    {
+        parser->addOption(QCommandLineOption("write-object-streams", "Pack objects into compressed object streams and write cross-reference stream (PDF 1.5)."));
+        parser->addOption(QCommandLineOption("write-objects-per-stream", "Maximal number of objects in one object stream.", "count", QString::number(pdf::PDFDocumentWriter::DEFAULT_OBJECTS_PER_STREAM)));
+    }
 }
 
 PDFToolOptions PDFToolAbstractApplication::getOptions(QCommandLineParser* parser) const
@@ -881,6 +889,28 @@ PDFToolOptions PDFToolAbstractApplication::getOptions(QCommandLineParser* parser
             options.renderRasterizerCount = correctedRasterizerCount;
         }
 
+        textValue = parser->value("render-encoders");
+        options.renderEncoderCount = textValue.toInt(&ok);
+        if (!ok)
+        {
+            options.renderEncoderCount = pdf::PDFRasterizerPool::getDefaultEncoderCount();
+            PDFConsole::writeError(PDFToolTranslationContext::tr("Uknown encoder count '%1'. %2 encoders are used as default.").arg(textValue).arg(options.renderEncoderCount), options.outputCodec);
+        }
+        int correctedEncoderCount = pdf::PDFRasterizerPool::getCorrectedRasterizerCount(options.renderEncoderCount);
+        if (correctedEncoderCount != options.renderEncoderCount)
+        {
+            PDFConsole::writeError(PDFToolTranslationContext::tr("Invalid encoder count: %1. Correcting to use %2 encoders.").arg(options.renderEncoderCount).arg(correctedEncoderCount), options.outputCodec);
+            options.renderEncoderCount = correctedEncoderCount;
+        }
+
+        textValue = parser->value("render-band-height");
+        options.renderBandHeight = textValue.toInt(&ok);
+        if (!ok || options.renderBandHeight < 0)
+        {
+            options.renderBandHeight = 0;
+            PDFConsole::writeError(PDFToolTranslationContext::tr("Invalid band height '%1'. Banded rendering is turned off.").arg(textValue), options.outputCodec);
+        }
+
         options.renderShowPageStatistics = parser->isSet("render-show-page-stat");
     }
 
@@ -970,6 +1000,20 @@ PDFToolOptions PDFToolAbstractApplication::getOptions(QCommandLineParser* parser
         options.encryptionPermissions = parser->value("enc-permissions").toUInt();
     }
 
+    if (optionFlags.testFlag(DocumentWrite))
+    {
+        options.writeObjectStreams = parser->isSet("write-object-streams");
+
+        QString textValue = parser->value("write-objects-per-stream");
+        bool ok = false;
+        options.writeObjectsPerStream = textValue.toInt(&ok);
+        if (!ok || options.writeObjectsPerStream < 1 || options.writeObjectsPerStream > pdf::PDFDocumentWriter::MAX_OBJECTS_PER_STREAM)
+        {
+            options.writeObjectsPerStream = pdf::PDFDocumentWriter::DEFAULT_OBJECTS_PER_STREAM;
+            PDFConsole::writeError(PDFToolTranslationContext::tr("Invalid object count per object stream '%1'. %2 objects are used as default.").arg(textValue).arg(options.writeObjectsPerStream), options.outputCodec);
+        }
+    }
+
     return options;
 }
 
@@ -1117,6 +1161,12 @@ PDFToolApplicationStorage* PDFToolApplicationStorage::getInstance()
     return &storage;
 }
 
+void PDFToolOptions::applyWriterOptions(pdf::PDFDocumentWriter& writer) const
+{
+    writer.setObjectStreamsEnabled(writeObjectStreams);
+    writer.setObjectsPerStream(writeObjectsPerStream);
+}
+
 std::vector<pdf::PDFInteger> PDFToolOptions::getPageRange(pdf::PDFInteger pageCount, QString& errorMessage, bool zeroBased) const
 {
     QStringList parts;
@@ -1165,6 +1215,7 @@ std::vector<PDFToolOptions::RenderFeatureInfo> PDFToolOptions::getRenderFeatures
     return {
         RenderFeatureInfo{ "render-antialiasing", "Antialiasing for lines, shapes, etc.", pdf::PDFRenderer::Antialiasing },
         RenderFeatureInfo{ "render-text-antialiasing", "Antialiasing for text outlines.", pdf::PDFRenderer::TextAntialiasing },
+        RenderFeatureInfo{ "render-glyph-cache", "Draw antialiased text using cache of rasterized glyphs.", pdf::PDFRenderer::GlyphCache },
         RenderFeatureInfo{ "render-smooth-img", "Smooth image transformation (slower, but better quality images).", pdf::PDFRenderer::SmoothImages },
         RenderFeatureInfo{ "render-ignore-opt-content", "Ignore optional content settings (draw everything).", pdf::PDFRenderer::IgnoreOptionalContent },
         RenderFeatureInfo{ "render-clip-to-crop-box", "Clip page graphics to crop box.", pdf::PDFRenderer::ClipToCropBox },
@@ -25,6 +25,7 @@
 #include "pdfrenderer.h"
 #include "pdfcms.h"
 #include "pdfoptimizer.h"
+#include "pdfdocumentwriter.h"
 
 #include <QtGlobal>
 #include <QString>
@@ -139,6 +140,8 @@ struct PDFToolOptions
     bool renderShowPageStatistics = false;
     int renderMSAAsamples = 4;
     int renderRasterizerCount = pdf::PDFRasterizerPool::getDefaultRasterizerCount();
+    int renderEncoderCount = pdf::PDFRasterizerPool::getDefaultEncoderCount();
+    int renderBandHeight = 0;
 
     // For option 'Separate'
     QString separatePagePattern;
@@ -166,6 +169,14 @@ struct PDFToolOptions
     QString encryptionOwnerPassword;
     uint32_t encryptionPermissions = 0;
 
+    // For option 'DocumentWrite'
+    bool writeObjectStreams = false;
+    int writeObjectsPerStream = pdf::PDFDocumentWriter::DEFAULT_OBJECTS_PER_STREAM;
+
+    /// Applies document writing options to the document writer
+    /// \param writer Document writer
+    void applyWriterOptions(pdf::PDFDocumentWriter& writer) const;
+
     /// Returns page range. If page range is invalid, then \p errorMessage is empty.
     /// \param pageCount Page count
     /// \param[out] errorMessage Error message
@@ -252,6 +263,7 @@ public:
         CertStoreInstall                = 0x00400000,       ///< Settings for certificate store install certificate tool
         Encrypt                         = 0x00800000,       ///< Encryption settings
         Diff                            = 0x01000000,       ///< Diff settings (compare documents)
+        DocumentWrite                   = 0x02000000,       ///< Settings for writing of the output document
     };
     Q_DECLARE_FLAGS(Options, Option)
 
@@ -176,14 +176,24 @@ int PDFToolAttachmentsApplication::execute(const PDFToolOptions& options)
                 outputFile = QString("%1/%2").arg(options.attachmentsOutputDirectory, outputFile);
             }
 
+            QFile file(outputFile);
+
             try
             {
-                QByteArray data = document.getDecodedStream(info.specification->getPlatformFile()->getStream());
+                // Attachment is decoded in chunks, so large attachments need not to be in the memory
+                pdf::PDFStreamFilterSourcePointer source = document.createDecodedStreamSource(info.specification->getPlatformFile()->getStream());
 
-                QFile file(outputFile);
                 if (file.open(QFile::WriteOnly | QFile::Truncate))
                 {
-                    file.write(data);
+                    std::vector<char> buffer(pdf::PDFStreamFilterSource::CHUNK_SIZE, 0);
+                    qint64 bytesRead = 0;
+                    while (source && (bytesRead = source->read(buffer.data(), qint64(buffer.size()))) > 0)
+                    {
+                        if (file.write(buffer.data(), bytesRead) != bytesRead)
+                        {
+                            throw pdf::PDFException(file.errorString());
+                        }
+                    }
                     file.close();
                 }
                 else
@@ -194,6 +204,13 @@ int PDFToolAttachmentsApplication::execute(const PDFToolOptions& options)
             }
             catch (const pdf::PDFException &e)
             {
+                if (file.isOpen())
+                {
+                    // Remove incomplete attachment
+                    file.close();
+                    file.remove();
+                }
+
                 PDFConsole::writeError(PDFToolTranslationContext::tr("Failed to save attachment to file. %1").arg(e.getMessage()), options.outputCodec);
                 return ErrorFailedWriteToFile;
             }
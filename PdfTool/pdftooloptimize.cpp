@@ -67,6 +67,7 @@ int PDFToolOptimize::execute(const PDFToolOptions& options)
     document = optimizer.takeOptimizedDocument();
 
     pdf::PDFDocumentWriter writer(nullptr);
+    options.applyWriterOptions(writer);
     pdf::PDFOperationResult result = writer.write(options.document, &document, true);
     if (!result)
     {
@@ -79,7 +80,7 @@ int PDFToolOptimize::execute(const PDFToolOptions& options)
 
 PDFToolAbstractApplication::Options PDFToolOptimize::getOptionsFlags() const
 {
-    return ConsoleFormat | OpenDocument | Optimize;
+    return ConsoleFormat | OpenDocument | Optimize | DocumentWrite;
 }
 
 }   // namespace pdftool
@@ -17,6 +17,8 @@
 
 #include "pdftoolrender.h"
 #include "pdffont.h"
+#include "pdfimage.h"
+#include "pdfcontentstreambytecode.h"
 #include "pdfconstants.h"
 
 #include <QColorSpace>
@@ -94,6 +96,77 @@ void PDFToolRender::onPageRendered(const PDFToolOptions& options, pdf::PDFRender
     m_pageInfo[renderedPageImage.pageIndex].pageWriteTime = imageWriterTimer.elapsed();
 }
 
+bool PDFToolRender::onPageBandRendered(const PDFToolOptions& options, const pdf::PDFRenderedPageBand& band)
+{
+    QElapsedTimer imageWriterTimer;
+    imageWriterTimer.start();
+
+    PageInfo& info = m_pageInfo[band.pageIndex];
+    const bool result = writePageBand(options, band, info);
+    info.pageWriteTime += imageWriterTimer.elapsed();
+
+    return result;
+}
+
+bool PDFToolRender::writePageBand(const PDFToolOptions& options, const pdf::PDFRenderedPageBand& band, PageInfo& info)
+{
+    std::shared_ptr<BandWriter> bandWriter;
+
+    if (band.top == 0)
+    {
+        if (options.imageWriterSettings.getCurrentFormat() != "png")
+        {
+            info.errors.emplace_back(pdf::PDFRenderError(pdf::RenderErrorType::Error, PDFToolTranslationContext::tr("Banded rendering supports only PNG format.")));
+            return false;
+        }
+
+        QString fileName = options.imageExportSettings.getOutputFileName(band.pageIndex, options.imageWriterSettings.getCurrentFormat());
+        bandWriter = std::make_shared<BandWriter>(fileName);
+        if (!bandWriter->file.open(QFile::WriteOnly | QFile::Truncate))
+        {
+            info.errors.emplace_back(pdf::PDFRenderError(pdf::RenderErrorType::Error, PDFToolTranslationContext::tr("Cannot write page image to file '%1', because: %2.").arg(fileName).arg(bandWriter->file.errorString())));
+            return false;
+        }
+
+        // Same mapping of quality to compression level, as in Qt PNG image writer
+        const int compressionLevel = (100 - qBound(0, options.imageWriterSettings.getQuality(), 100)) * 9 / 91;
+        if (!bandWriter->writer.begin(band.pageImageSize, band.bandImage.dotsPerMeterX(), band.bandImage.dotsPerMeterY(), compressionLevel))
+        {
+            info.errors.emplace_back(pdf::PDFRenderError(pdf::RenderErrorType::Error, PDFToolTranslationContext::tr("Cannot write page image to file '%1', because: %2.").arg(fileName).arg(bandWriter->writer.getErrorString())));
+            return false;
+        }
+
+        QMutexLocker lock(&m_bandWritersMutex);
+        m_bandWriters[band.pageIndex] = bandWriter;
+    }
+    else
+    {
+        QMutexLocker lock(&m_bandWritersMutex);
+        auto it = m_bandWriters.find(band.pageIndex);
+        if (it == m_bandWriters.cend())
+        {
+            return false;
+        }
+        bandWriter = it->second;
+    }
+
+    const bool isLastBand = band.top + band.bandImage.height() >= band.pageImageSize.height();
+    const bool isWritten = bandWriter->writer.writeRows(band.bandImage) && (!isLastBand || bandWriter->writer.end());
+
+    if (!isWritten)
+    {
+        info.errors.emplace_back(pdf::PDFRenderError(pdf::RenderErrorType::Error, PDFToolTranslationContext::tr("Cannot write page image to file '%1', because: %2.").arg(bandWriter->file.fileName()).arg(bandWriter->writer.getErrorString())));
+    }
+
+    if (!isWritten || isLastBand)
+    {
+        QMutexLocker lock(&m_bandWritersMutex);
+        m_bandWriters.erase(band.pageIndex);
+    }
+
+    return isWritten;
+}
+
 QString PDFToolBenchmark::getStandardString(PDFToolAbstractApplication::StandardString standardString) const
 {
     switch (standardString)
@@ -179,12 +252,19 @@ int PDFToolRenderBase::execute(const PDFToolOptions& options)
     pdf::PDFModifiedDocument md(&document, &optionalContentActivity);
     fontCache.setDocument(md);
     fontCache.setCacheShrinkEnabled(nullptr, false);
+    pdf::PDFImageCache imageCache(pdf::DEFAULT_IMAGE_CACHE_LIMIT);
+    imageCache.setDocument(md);
+    pdf::PDFContentStreamBytecodeCache bytecodeCache(pdf::DEFAULT_BYTECODE_CACHE_LIMIT);
+    bytecodeCache.setDocument(md);
 
     m_pageInfo.resize(document.getCatalog()->getPageCount());
     pdf::PDFRasterizerPool rasterizerPool(&document, &fontCache, &cmsManager,
                                           &optionalContentActivity, options.renderFeatures, meshQualitySettings,
                                           pdf::PDFRasterizerPool::getCorrectedRasterizerCount(options.renderRasterizerCount),
                                           options.renderUseSoftwareRendering ? pdf::RendererEngine::QPainter : pdf::RendererEngine::Blend2D_SingleThread, nullptr);
+    rasterizerPool.setEncoderCount(options.renderEncoderCount);
+    rasterizerPool.setImageCache(&imageCache);
+    rasterizerPool.setBytecodeCache(&bytecodeCache);
 
     auto onRenderError = [this](pdf::PDFInteger pageIndex, pdf::PDFRenderError error)
     {
@@ -228,7 +308,16 @@ int PDFToolRenderBase::execute(const PDFToolOptions& options)
     QElapsedTimer timer;
     timer.start();
 
-    rasterizerPool.render(pageIndices, imageSizeGetter, std::bind(&PDFToolRenderBase::onPageRendered, this, options, std::placeholders::_1), nullptr);
+    if (options.renderBandHeight > 0)
+    {
+        rasterizerPool.renderBands(pageIndices, imageSizeGetter, options.renderBandHeight,
+                                   std::bind(&PDFToolRenderBase::onPageBandRendered, this, options, std::placeholders::_1),
+                                   std::bind(&PDFToolRenderBase::onPageBandsFinished, this, options, std::placeholders::_1), nullptr);
+    }
+    else
+    {
+        rasterizerPool.render(pageIndices, imageSizeGetter, std::bind(&PDFToolRenderBase::onPageRendered, this, options, std::placeholders::_1), nullptr);
+    }
 
     m_wallTime = timer.elapsed();
 
@@ -238,6 +327,19 @@ int PDFToolRenderBase::execute(const PDFToolOptions& options)
     return ExitSuccess;
 }
 
+bool PDFToolRenderBase::onPageBandRendered(const PDFToolOptions& options, const pdf::PDFRenderedPageBand& band)
+{
+    Q_UNUSED(options);
+    Q_UNUSED(band);
+    return true;
+}
+
+void PDFToolRenderBase::onPageBandsFinished(const PDFToolOptions& options, pdf::PDFRenderedPageImage& renderedPageImage)
+{
+    Q_UNUSED(options);
+    writePageInfoStatistics(renderedPageImage);
+}
+
 void PDFToolRenderBase::writePageInfoStatistics(const pdf::PDFRenderedPageImage& renderedPageImage)
 {
     PageInfo& info = m_pageInfo[renderedPageImage.pageIndex];
@@ -245,6 +347,7 @@ void PDFToolRenderBase::writePageInfoStatistics(const pdf::PDFRenderedPageImage&
     info.pageCompileTime = renderedPageImage.pageCompileTime;
     info.pageWaitTime = renderedPageImage.pageWaitTime;
     info.pageRenderTime = renderedPageImage.pageRenderTime;
+    info.pageEncodeWaitTime = renderedPageImage.pageEncodeWaitTime;
     info.pageTotalTime = renderedPageImage.pageTotalTime;
     info.pageIndex = renderedPageImage.pageIndex;
 }
@@ -256,6 +359,7 @@ void PDFToolRenderBase::writeStatistics(PDFOutputFormatter& formatter)
     qint64 pageCompileTime = 0;
     qint64 pageWaitTime = 0;
     qint64 pageRenderTime = 0;
+    qint64 pageEncodeWaitTime = 0;
     qint64 pageTotalTime = 0;
     qint64 pageWriteTime = 0;
 
@@ -270,6 +374,7 @@ void PDFToolRenderBase::writeStatistics(PDFOutputFormatter& formatter)
         pageCompileTime += info.pageCompileTime;
         pageWaitTime += info.pageWaitTime;
         pageRenderTime += info.pageRenderTime;
+        pageEncodeWaitTime += info.pageEncodeWaitTime;
         pageTotalTime += info.pageTotalTime + info.pageWriteTime;
         pageWriteTime += info.pageWriteTime;
     }
@@ -284,6 +389,7 @@ void PDFToolRenderBase::writeStatistics(PDFOutputFormatter& formatter)
         double compileRatio = 100.0 * double(pageCompileTime) / double(pageTotalTime);
         double waitRatio = 100.0 * double(pageWaitTime) / double(pageTotalTime);
         double renderRatio = 100.0 * double(pageRenderTime) / double(pageTotalTime);
+        double encodeWaitRatio = 100.0 * double(pageEncodeWaitTime) / double(pageTotalTime);
         double writeRatio = 100.0 * double(pageWriteTime) / double(pageTotalTime);
 
         formatter.beginTable("statistics", PDFToolTranslationContext::tr("Statistics"));
@@ -307,6 +413,7 @@ void PDFToolRenderBase::writeStatistics(PDFOutputFormatter& formatter)
         writeValue("compile-time", PDFToolTranslationContext::tr("Total compile time"), locale.toString(pageCompileTime), PDFToolTranslationContext::tr("msec"));
         writeValue("render-time", PDFToolTranslationContext::tr("Total render time"), locale.toString(pageRenderTime), PDFToolTranslationContext::tr("msec"));
         writeValue("wait-time", PDFToolTranslationContext::tr("Total wait time"), locale.toString(pageWaitTime), PDFToolTranslationContext::tr("msec"));
+        writeValue("encode-wait-time", PDFToolTranslationContext::tr("Total encode wait time"), locale.toString(pageEncodeWaitTime), PDFToolTranslationContext::tr("msec"));
         writeValue("write-time", PDFToolTranslationContext::tr("Total write time"), locale.toString(pageWriteTime), PDFToolTranslationContext::tr("msec"));
         writeValue("total-time", PDFToolTranslationContext::tr("Total time"), locale.toString(pageTotalTime), PDFToolTranslationContext::tr("msec"));
         writeValue("wall-time", PDFToolTranslationContext::tr("Wall time"), locale.toString(m_wallTime), PDFToolTranslationContext::tr("msec"));
@@ -315,6 +422,7 @@ void PDFToolRenderBase::writeStatistics(PDFOutputFormatter& formatter)
         writeValue("compile-time-ratio", PDFToolTranslationContext::tr("Compile time ratio"), locale.toString(compileRatio, 'f', 2), PDFToolTranslationContext::tr("%"));
         writeValue("render-time-ratio", PDFToolTranslationContext::tr("Render time ratio"), locale.toString(renderRatio, 'f', 2), PDFToolTranslationContext::tr("%"));
         writeValue("wait-time-ratio", PDFToolTranslationContext::tr("Wait time ratio"), locale.toString(waitRatio, 'f', 2), PDFToolTranslationContext::tr("%"));
+        writeValue("encode-wait-time-ratio", PDFToolTranslationContext::tr("Encode wait time ratio"), locale.toString(encodeWaitRatio, 'f', 2), PDFToolTranslationContext::tr("%"));
         writeValue("write-time-ratio", PDFToolTranslationContext::tr("Write time ratio"), locale.toString(writeRatio, 'f', 2), PDFToolTranslationContext::tr("%"));
 
         formatter.endTable();
@@ -331,6 +439,7 @@ void PDFToolRenderBase::writePageStatistics(PDFOutputFormatter& formatter)
     formatter.writeTableHeaderColumn("compile-time", PDFToolTranslationContext::tr("Compile Time [msec]"), Qt::AlignLeft);
     formatter.writeTableHeaderColumn("render-time", PDFToolTranslationContext::tr("Render Time [msec]"), Qt::AlignLeft);
     formatter.writeTableHeaderColumn("wait-time", PDFToolTranslationContext::tr("Wait Time [msec]"), Qt::AlignLeft);
+    formatter.writeTableHeaderColumn("encode-wait-time", PDFToolTranslationContext::tr("Encode Wait Time [msec]"), Qt::AlignLeft);
     formatter.writeTableHeaderColumn("write-time", PDFToolTranslationContext::tr("Write Time [msec]"), Qt::AlignLeft);
     formatter.writeTableHeaderColumn("total-time", PDFToolTranslationContext::tr("Total Time [msec]"), Qt::AlignLeft);
     formatter.endTableHeaderRow();
@@ -349,6 +458,7 @@ void PDFToolRenderBase::writePageStatistics(PDFOutputFormatter& formatter)
         formatter.writeTableColumn("compile-time", locale.toString(info.pageCompileTime), Qt::AlignRight);
         formatter.writeTableColumn("render-time", locale.toString(info.pageRenderTime), Qt::AlignRight);
         formatter.writeTableColumn("wait-time", locale.toString(info.pageWaitTime), Qt::AlignRight);
+        formatter.writeTableColumn("encode-wait-time", locale.toString(info.pageEncodeWaitTime), Qt::AlignRight);
         formatter.writeTableColumn("write-time", locale.toString(info.pageWriteTime), Qt::AlignRight);
         formatter.writeTableColumn("total-time", locale.toString(info.pageTotalTime), Qt::AlignRight);
         formatter.endTableRow();
@@ -20,6 +20,12 @@
 
 #include "pdftoolabstractapplication.h"
 #include "pdfexception.h"
+#include "pdfpngstreamwriter.h"
+
+#include <QFile>
+#include <QMutex>
+
+#include <map>
 
 namespace pdftool
 {
@@ -33,6 +39,14 @@ protected:
     virtual void finish(const PDFToolOptions& options) = 0;
     virtual void onPageRendered(const PDFToolOptions& options, pdf::PDFRenderedPageImage& renderedPageImage) = 0;
 
+    /// Called for each band of the page image in banded rendering mode,
+    /// returns false, if rendering of the page should be cancelled.
+    virtual bool onPageBandRendered(const PDFToolOptions& options, const pdf::PDFRenderedPageBand& band);
+
+    /// Called, when all bands of the page are rendered in banded rendering mode.
+    /// Rendered page image contains page timings only (page image is null).
+    virtual void onPageBandsFinished(const PDFToolOptions& options, pdf::PDFRenderedPageImage& renderedPageImage);
+
     void writePageInfoStatistics(const pdf::PDFRenderedPageImage& renderedPageImage);
 
     void writeStatistics(PDFOutputFormatter& formatter);
@@ -46,6 +60,7 @@ protected:
         qint64 pageCompileTime = 0;
         qint64 pageWaitTime = 0;
         qint64 pageRenderTime = 0;
+        qint64 pageEncodeWaitTime = 0;
         qint64 pageTotalTime = 0;
         qint64 pageWriteTime = 0;
         std::vector<pdf::PDFRenderError> errors;
@@ -64,6 +79,22 @@ public:
 protected:
     virtual void finish(const PDFToolOptions& options) override;
     virtual void onPageRendered(const PDFToolOptions& options, pdf::PDFRenderedPageImage& renderedPageImage) override;
+    virtual bool onPageBandRendered(const PDFToolOptions& options, const pdf::PDFRenderedPageBand& band) override;
+
+private:
+    struct BandWriter
+    {
+        explicit BandWriter(const QString& fileName) : file(fileName), writer(&file) { }
+
+        QFile file;
+        pdf::PDFPNGStreamWriter writer;
+    };
+
+    /// Writes band of the page image to the file
+    bool writePageBand(const PDFToolOptions& options, const pdf::PDFRenderedPageBand& band, PageInfo& info);
+
+    QMutex m_bandWritersMutex;
+    std::map<pdf::PDFInteger, std::shared_ptr<BandWriter>> m_bandWriters;
 };
 
 class PDFToolBenchmark : public PDFToolRenderBase
@@ -206,6 +206,7 @@ int PDFToolUnite::execute(const PDFToolOptions& options)
         mergedDocument = finalBuilder.build();
 
         pdf::PDFDocumentWriter writer(nullptr);
+        options.applyWriterOptions(writer);
         pdf::PDFOperationResult result = writer.write(targetFile, &mergedDocument, false);
         if (!result)
         {
@@ -224,7 +225,7 @@ int PDFToolUnite::execute(const PDFToolOptions& options)
 
 PDFToolAbstractApplication::Options PDFToolUnite::getOptionsFlags() const
 {
-    return ConsoleFormat | Unite;
+    return ConsoleFormat | Unite | DocumentWrite;
 }
 
 }   // namespace pdftool
@@ -27,6 +27,14 @@
 #include "pdfdocument.h"
 #include "pdfexception.h"
 #include "pdfjbig2decoder.h"
+#include "pdfccittfaxdecoder.h"
+#include "pdfdocumentreader.h"
+#include "pdfdocumentwriter.h"
+#include "pdfdocumentbuilder.h"
+#include "pdfsecurityhandler.h"
+#include "pdfpagecontentprocessor.h"
+#include "pdfcontentstreambytecode.h"
+#include "pdfcms.h"
 
 #include <regex>
 
@@ -54,14 +62,28 @@ private slots:
     void test_invalid_input();
     void test_header_regexp();
     void test_flat_map();
+    void test_dictionary_lookup();
     void test_lzw_filter();
     void test_sampled_function();
     void test_exponential_function();
     void test_stitching_function();
     void test_postscript_function();
     void test_jbig2_arithmetic_decoder();
+    void test_jbig2_generic_refinement_regions();
+    void test_ccitt_fax_decoder();
+    void test_content_stream_bytecode();
+    void test_incremental_update();
+    void test_object_streams_round_trip();
 
 private:
+    /// Creates data of the PDF document from the objects (first object has number 1)
+    /// \param objects Objects
+    /// \param trailer Trailer dictionary entries (without Size)
+    static QByteArray createDocumentData(const std::vector<QByteArray>& objects, const QByteArray& trailer = "/Root 1 0 R");
+
+    /// Creates stream object with given dictionary entries and content
+    static QByteArray createStreamObject(const QByteArray& dictionary, const QByteArray& content);
+
     void scanWholeStream(const char* stream);
     void testTokens(const char* stream, const std::vector<pdf::PDFLexicalAnalyzer::Token>& tokens);
 
@@ -311,6 +333,59 @@ void LexicalAnalyzerTest::test_flat_map()
     }
 }
 
+void LexicalAnalyzerTest::test_dictionary_lookup()
+{
+    // Test both small dictionaries (linear search) and large dictionaries (hash index)
+    for (int count : { 4, 15, 16, 17, 100, 1000 })
+    {
+        pdf::PDFDictionary dictionary;
+        for (int i = 0; i < count; ++i)
+        {
+            dictionary.addEntry(pdf::PDFInplaceOrMemoryString(QByteArray("Key") + QByteArray::number(i)), pdf::PDFObject::createInteger(i));
+        }
+
+        // Duplicate key, first entry must be found
+        dictionary.addEntry(pdf::PDFInplaceOrMemoryString("Key0"), pdf::PDFObject::createInteger(-1));
+
+        for (int i = 0; i < count; ++i)
+        {
+            QByteArray key = QByteArray("Key") + QByteArray::number(i);
+            QCOMPARE(dictionary.get(key).getInteger(), i);
+            QCOMPARE(dictionary.get(key.constData()).getInteger(), i);
+            QCOMPARE(dictionary.get(pdf::PDFNameAtom(key)).getInteger(), i);
+            QCOMPARE(dictionary.get(pdf::PDFInplaceOrMemoryString(key)).getInteger(), i);
+        }
+
+        QVERIFY(!dictionary.hasKey("NonExistingKeyInDictionary"));
+        QVERIFY(!dictionary.hasKey(QByteArray("Key") + QByteArray::number(count)));
+
+        // Remove entries and check, that remaining entries are still found
+        pdf::PDFDictionary copy = dictionary;
+        for (int i = 0; i < count; i += 2)
+        {
+            copy.removeEntry((QByteArray("Key") + QByteArray::number(i)).constData());
+        }
+        copy.setEntry(pdf::PDFInplaceOrMemoryString("Key0"), pdf::PDFObject::createInteger(0));
+
+        for (int i = 1; i < count; i += 2)
+        {
+            QCOMPARE(copy.get(QByteArray("Key") + QByteArray::number(i)).getInteger(), i);
+        }
+        QCOMPARE(copy.get("Key0").getInteger(), 0);
+        QVERIFY(!copy.hasKey("Key2"));
+    }
+
+    const QByteArray typeName("Type");
+    QCOMPARE(pdf::PDFNameAtom("Type"), pdf::PDFNameAtom(typeName));
+    QCOMPARE(pdf::PDFNameAtom("Type").getName(), QByteArray("Type"));
+    QVERIFY(pdf::PDFNameAtom("Type") != pdf::PDFNameAtom("Types"));
+
+    // Atoms of string literals are computed at compile time
+    static constexpr pdf::PDFNameAtom typeAtom("Type");
+    static_assert(typeAtom.getHash() == pdf::PDFNameAtom::computeHash("Type"));
+    static_assert(typeAtom.getHash() != pdf::PDFNameAtom::computeHash("Types"));
+}
+
 void LexicalAnalyzerTest::test_lzw_filter()
 {
     // This example is from PDF 1.7 Reference
@@ -995,6 +1070,11 @@ void LexicalAnalyzerTest::test_postscript_function()
         pdf::PDFFunctionPtr function = pdf::PDFFunction::createFunction(&document, parser.getObject());
 
         QVERIFY(function);
+
+        // Stack layout of all test programs doesn't depend on input, so they are compiled
+        const pdf::PDFPostScriptFunction* postScriptFunction = dynamic_cast<const pdf::PDFPostScriptFunction*>(function.get());
+        QVERIFY(postScriptFunction && postScriptFunction->isCompiled());
+
         for (double value = -1.0; value <= 3.0; value += 0.01)
         {
             const double clampedValue = qBound(0.0, value, 1.0);
@@ -1061,6 +1141,41 @@ void LexicalAnalyzerTest::test_postscript_function()
     test01("pop 4 3 2 1   3 -1 roll 3 eq { 1 eq { 2 eq { 4 eq { 1.0 } { 0.0 } ifelse } { 0.0 } ifelse } { 0.0 } ifelse } { 0.0 } ifelse", [](double) { return 1.0; }); // we should have 4 2 1 3
     test01("2.0 2 copy div 3 1 roll exp add", [](double x) { return qBound(0.0, 0.5 * x + std::pow(x, 2.0), 1.0); });
     test01("2.0 1 index exch div exch pop", [](double x) { return x / 2.0; });
+    test01("dup 0.5 gt { pop 1 } if 2 mul 0.5 mul", [](double x) { return (x > 0.5) ? 1.0 : x; });
+    test01("dup 0.5 lt { cvi } if 3 add 0.25 mul", [](double x) { return (x < 0.5) ? 0.75 : (x + 3.0) * 0.25; });
+
+    auto testApproximation = [&](const char* program, bool isApproximated)
+    {
+        QByteArray data = makeStream(0, 1, 0, 1, program);
+
+        pdf::PDFDocument document;
+        pdf::PDFParser parser(data, nullptr, pdf::PDFParser::AllowStreams);
+        pdf::PDFFunctionPtr function = pdf::PDFFunction::createFunction(&document, parser.getObject());
+        pdf::PDFFunctionPtr approximation = pdf::PDFFunction::createSampledApproximation(function, 0.001);
+
+        QVERIFY(function);
+        QCOMPARE(approximation != function, isApproximated);
+
+        for (double value = 0.0; value <= 1.0; value += 0.001)
+        {
+            double expected = 0.0;
+            double actual = 0.0;
+            QVERIFY(function->apply(&value, &value + 1, &expected, &expected + 1));
+            QVERIFY(approximation->apply(&value, &value + 1, &actual, &actual + 1));
+            QVERIFY(std::abs(expected - actual) <= 0.001);
+        }
+    };
+
+    testApproximation("360.0 mul sin 2 div 0.5 add", true);
+    testApproximation("dup mul", true);
+    testApproximation("0.5 gt { 1.0 } { 0.0 } ifelse", false);
+
+    // Only PostScript functions are approximated
+    pdf::PDFDocument document;
+    pdf::PDFParser parser("<< /FunctionType 3 /Domain [0 1] /Bounds [0.5] /Encode [0 1 0 1] /Functions [ << /FunctionType 2 /Domain [0 1] /C0 [0] /C1 [1] /N 1 >> << /FunctionType 2 /Domain [0 1] /C0 [1] /C1 [0] /N 2 >> ] >>", nullptr, pdf::PDFParser::None);
+    pdf::PDFFunctionPtr stitchingFunction = pdf::PDFFunction::createFunction(&document, parser.getObject());
+    QVERIFY(stitchingFunction);
+    QVERIFY(pdf::PDFFunction::createSampledApproximation(stitchingFunction, 0.001) == stitchingFunction);
 }
 
 void LexicalAnalyzerTest::test_jbig2_arithmetic_decoder()
@@ -1102,6 +1217,598 @@ void LexicalAnalyzerTest::test_jbig2_arithmetic_decoder()
     QVERIFY(decompressed == decompressedByAD);
 }
 
+void LexicalAnalyzerTest::test_jbig2_generic_refinement_regions()
+{
+    // Expected page image, black pixels are marked by '#'
+    const std::vector<const char*> image =
+    {
+        "..................................############################..",
+        "..................................############################..",
+        "............########..............############################..",
+        "..........############..........................................",
+        ".........##############.........................................",
+        "........################........................................",
+        ".......###.##########.###.......#.#########.##########.###......",
+        ".......#######....#######.........########################......",
+        "......######........######........########################......",
+        "......######........######......................................",
+        "......#####..........#####......................................",
+        "......#####...#......####...........#..........#..........#.....",
+        "......#####.....######################################..........",
+        "......#####.....#....#####........####################..........",
+        "......######....#...######........####################..........",
+        "......######....#...######..............#......#................",
+        "........######..#..######....#.........##......#...#............",
+        ".......###################............#........#................",
+        "........################..#.......################..............",
+        ".........##############....#......################..............",
+        "..........############..............##############..............",
+        "...........#########..#..........#..........#..#.......#........",
+        "................#..............................#................",
+        "................#..............................#................",
+        "###....###....###....###..............####..####........####..##",
+        "##....###....####...###....#..........####..####........####..##",
+        "#...####....#####..###.....#.........#####..#####.......###...##",
+        "....###....###..#.###....###..........####..####........####..##",
+        "...###....###...####....####...######.####..####........####..##",
+        "..###....###....###....####...##.....#.........#................",
+        ".###....###....###....####...###......#........#................",
+        "###....#.#....###..#.####...##.........#.#.....#....#...........",
+        "##....###....####...####...###........####..####..####........##",
+        "#....###....###.#..####...###.........####..####..####........##",
+        "....###....###..#.####...###..........#####.####..####........##",
+        "...###....###...################################..####........##",
+        "..###....####...###.....##....##..#...####..#.##..####..#.....##",
+        ".###....###....###....###....###......####..####..####........##",
+        "###....###....###....###....###.................................",
+        "##....###....###....###....###..................................",
+        "#....###....###....###....###...####........####..####..####....",
+        "....#.#....###..#.###....##.....####..#.....####.#####..####....",
+        "...###....###....###....###....#####........####..####..####....",
+        "..###....###....###....###....######........####..####..####....",
+        ".###....###....###....###....#######........####..####..####....",
+        "###....###....###....###....###.................................",
+        "##....###....###....###....###..................................",
+        "#....###....###....###....###..................................."
+    };
+
+    // Embedded JBIG2 stream (without file header), which paints four generic regions
+    // (one for each template) to the page and then refines parts of the page using
+    // both refinement templates. Typical prediction is used in some of the regions.
+    const std::vector<uint8_t> data =
+    {
+            // Page information 64 x 48
+            0x00, 0x00, 0x00, 0x00, 0x30, 0x00, 0x01, 0x00, 0x00, 0x00, 0x13, 0x00, 0x00, 0x00, 0x40, 0x00,
+            0x00, 0x00, 0x30, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+            // Immediate generic region, template 0, adaptive pixels moved
+            0x00, 0x00, 0x00, 0x01, 0x26, 0x00, 0x01, 0x00, 0x00, 0x00, 0x47, 0x00, 0x00, 0x00, 0x20, 0x00,
+            0x00, 0x00, 0x18, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x03, 0xFF, 0xFD,
+            0xFF, 0x02, 0xFE, 0xFE, 0xFE, 0xA1, 0x13, 0x7E, 0x4F, 0x54, 0x06, 0x14, 0x7C, 0xA7, 0x52, 0x01,
+            0x43, 0xB0, 0xED, 0x39, 0xA9, 0xB9, 0xD5, 0x43, 0xAC, 0x6C, 0x7C, 0xBE, 0x56, 0xB5, 0x82, 0x4A,
+            0x69, 0xEF, 0x34, 0x0E, 0x3C, 0x22, 0x2F, 0xA7, 0xCD, 0x72, 0xD2, 0xB2, 0xD9, 0x01, 0x49, 0x8F,
+            0xFF, 0xAC,
+            // Immediate generic region, template 1, TPGDON
+            0x00, 0x00, 0x00, 0x02, 0x26, 0x00, 0x01, 0x00, 0x00, 0x00, 0x24, 0x00, 0x00, 0x00, 0x20, 0x00,
+            0x00, 0x00, 0x18, 0x00, 0x00, 0x00, 0x20, 0x00, 0x00, 0x00, 0x00, 0x00, 0x0A, 0xFC, 0x00, 0x70,
+            0x4A, 0x3E, 0x37, 0x22, 0x0C, 0x2E, 0xD2, 0x28, 0xCD, 0x3B, 0x88, 0x48, 0xAE, 0xFF, 0xAC,
+            // Immediate generic region, template 2, XOR operator
+            0x00, 0x00, 0x00, 0x03, 0x26, 0x00, 0x01, 0x00, 0x00, 0x00, 0x27, 0x00, 0x00, 0x00, 0x20, 0x00,
+            0x00, 0x00, 0x18, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x18, 0x02, 0x04, 0xFD, 0x00, 0xF5,
+            0x4E, 0x95, 0x7A, 0x36, 0xB5, 0xBE, 0xB6, 0xED, 0x15, 0x34, 0xBC, 0x1B, 0x53, 0xA7, 0x81, 0x5F,
+            0xFF, 0xAC,
+            // Immediate generic region, template 3, TPGDON
+            0x00, 0x00, 0x00, 0x04, 0x26, 0x00, 0x01, 0x00, 0x00, 0x00, 0x25, 0x00, 0x00, 0x00, 0x20, 0x00,
+            0x00, 0x00, 0x18, 0x00, 0x00, 0x00, 0x20, 0x00, 0x00, 0x00, 0x18, 0x00, 0x0E, 0xFB, 0xFF, 0x08,
+            0xB4, 0x99, 0x4C, 0xE8, 0x97, 0x39, 0x36, 0x8F, 0xE3, 0x14, 0xF2, 0x98, 0xA8, 0x1F, 0xFF, 0xAC,
+            // Immediate refinement region, template 0, adaptive pixels moved
+            0x00, 0x00, 0x00, 0x05, 0x2A, 0x00, 0x01, 0x00, 0x00, 0x00, 0x49, 0x00, 0x00, 0x00, 0x20, 0x00,
+            0x00, 0x00, 0x18, 0x00, 0x00, 0x00, 0x10, 0x00, 0x00, 0x00, 0x0C, 0x04, 0x00, 0xFE, 0xFF, 0x01,
+            0x01, 0xE8, 0x55, 0x35, 0x30, 0x84, 0x00, 0xA7, 0xD7, 0xBB, 0x95, 0x89, 0xF6, 0xD9, 0x72, 0xE1,
+            0x89, 0x4F, 0x2C, 0xFD, 0xF4, 0xDC, 0xEF, 0x16, 0x1C, 0x58, 0xCF, 0xE0, 0x39, 0xCE, 0x89, 0x21,
+            0x1D, 0x69, 0x5B, 0xFC, 0xCB, 0xF3, 0x94, 0x22, 0x4D, 0xE2, 0xF4, 0x9C, 0xAE, 0xC9, 0xE6, 0x88,
+            0x13, 0xF7, 0xFF, 0xAC,
+            // Immediate refinement region, template 1, TPGRON
+            0x00, 0x00, 0x00, 0x06, 0x2A, 0x00, 0x01, 0x00, 0x00, 0x00, 0x5F, 0x00, 0x00, 0x00, 0x38, 0x00,
+            0x00, 0x00, 0x28, 0x00, 0x00, 0x00, 0x04, 0x00, 0x00, 0x00, 0x04, 0x04, 0x03, 0xC5, 0xF5, 0xB0,
+            0x7B, 0x71, 0x4E, 0x42, 0x59, 0x93, 0x3C, 0x05, 0x9C, 0xF2, 0x00, 0x41, 0xA0, 0xDB, 0x69, 0x4D,
+            0x4C, 0xCA, 0x0B, 0x35, 0xA4, 0x1C, 0xE0, 0x32, 0xF9, 0xF0, 0xF3, 0x87, 0x61, 0x52, 0x77, 0x28,
+            0x00, 0x09, 0xBF, 0x18, 0xA6, 0x3C, 0x20, 0x07, 0xEE, 0x3B, 0x5A, 0x09, 0x1D, 0x66, 0xA0, 0x65,
+            0xF7, 0x5B, 0x0A, 0xC8, 0x06, 0x85, 0x4C, 0x40, 0xAA, 0x02, 0xE2, 0x3E, 0xE2, 0x93, 0xF2, 0x3A,
+            0xF3, 0xF5, 0xF3, 0x33, 0x8B, 0xEF, 0x2F, 0xF5, 0xFF, 0xAC
+    };
+
+    const int columns = static_cast<int>(strlen(image.front()));
+    const int rows = static_cast<int>(image.size());
+
+    // Expected image data - white pixel is 1, black pixel is 0, rows are padded by zero bits
+    pdf::PDFBitWriter writer(1);
+    for (const char* row : image)
+    {
+        for (const char* pixel = row; *pixel; ++pixel)
+        {
+            writer.write(*pixel == '#' ? 0 : 1);
+        }
+        writer.finishLine();
+    }
+    const QByteArray expectedData = writer.takeByteArray();
+
+    pdf::PDFRenderErrorReporterDummy errorReporter;
+    QByteArray stream(reinterpret_cast<const char*>(data.data()), static_cast<int>(data.size()));
+    pdf::PDFJBIG2Decoder decoder(qMove(stream), QByteArray(), &errorReporter);
+    pdf::PDFImageData imageData = decoder.decode(pdf::PDFImageData::MaskingType::None);
+
+    QVERIFY(imageData.getWidth() == uint(columns));
+    QVERIFY(imageData.getHeight() == uint(rows));
+    QVERIFY(imageData.getStride() == uint((columns + 7) / 8));
+    QVERIFY(imageData.getData() == expectedData);
+}
+
+void LexicalAnalyzerTest::test_ccitt_fax_decoder()
+{
+    // Test image, black pixels are marked by '#'
+    const std::vector<const char*> image =
+    {
+        "................................................................................",
+        "######################################################################..........",
+        "..........######################################################################",
+        "#.#.#.#.#.#.#.#.#.#.#.#.#.#.#.#.#.#.#.#.#.#.#.#.#.#.#.#.#.#.#.#.#.#.#.#.#.#.#.#.",
+        "..###....###....###....###....###....###....###....###....###....###....###.....",
+        "...###....###..###.....###...####....##......##..#####...##.###...###....#####..",
+        "....#######.........###########..............................#############.....#",
+        "....###.###.........####...####............................###############.....#",
+        "#...................................................................#..........#",
+        "################################################################################"
+    };
+
+    struct TestCase
+    {
+        const char* name;
+        pdf::PDFInteger K;
+        bool hasEndOfLine;
+        bool hasEncodedByteAlign;
+        bool hasEndOfBlock;
+        std::vector<uint8_t> data;
+    };
+
+    const std::vector<TestCase> testCases =
+    {
+        {
+            "G4 (K < 0)", -1, false, false, true,
+            {
+                0x93, 0x50, 0x3C, 0xA4, 0xE0, 0x79, 0x13, 0x54, 0x47, 0x44, 0x74, 0x47, 0x41, 0x14, 0x39, 0x43,
+                0x94, 0x39, 0x43, 0x94, 0x39, 0x43, 0x94, 0x39, 0x43, 0x94, 0x39, 0x43, 0x94, 0x39, 0x43, 0x94,
+                0x39, 0x43, 0x94, 0x39, 0x43, 0x94, 0x39, 0x43, 0x94, 0x39, 0x43, 0x94, 0x39, 0x43, 0x94, 0x39,
+                0x43, 0x94, 0x39, 0x43, 0x94, 0x39, 0x43, 0x94, 0x39, 0x43, 0x94, 0x39, 0x43, 0x94, 0x39, 0x43,
+                0x82, 0x09, 0x46, 0x31, 0x6C, 0x63, 0x16, 0xC6, 0x31, 0x6C, 0x63, 0x16, 0xC6, 0x31, 0x6C, 0x63,
+                0x11, 0xB6, 0xDA, 0x5A, 0xD3, 0x85, 0x41, 0x11, 0xE6, 0xD8, 0x3B, 0x10, 0x84, 0x10, 0x84, 0x22,
+                0x22, 0xC4, 0x4A, 0xCC, 0xC3, 0xE5, 0xC4, 0x2E, 0x4D, 0x50, 0x88, 0x89, 0x16, 0x5C, 0x46, 0x00,
+                0x20, 0x02
+            }
+        },
+        {
+            "G4, EncodedByteAlign", -1, false, true, true,
+            {
+                0x80, 0x26, 0xA0, 0x79, 0x40, 0x27, 0x03, 0xC8, 0x26, 0xA8, 0x8E, 0x88, 0xE8, 0x8E, 0x82, 0x28,
+                0x72, 0x87, 0x28, 0x72, 0x87, 0x28, 0x72, 0x87, 0x28, 0x72, 0x87, 0x28, 0x72, 0x87, 0x28, 0x72,
+                0x87, 0x28, 0x72, 0x87, 0x28, 0x72, 0x87, 0x28, 0x72, 0x87, 0x28, 0x72, 0x87, 0x28, 0x72, 0x87,
+                0x28, 0x72, 0x87, 0x28, 0x72, 0x87, 0x28, 0x72, 0x87, 0x28, 0x72, 0x87, 0x28, 0x72, 0x87, 0x28,
+                0x72, 0x87, 0x04, 0x12, 0x80, 0x18, 0xC5, 0xB1, 0x8C, 0x5B, 0x18, 0xC5, 0xB1, 0x8C, 0x5B, 0x18,
+                0xC5, 0xB1, 0x8C, 0x46, 0x6D, 0xB4, 0xB5, 0xA7, 0x0A, 0x82, 0x23, 0xCD, 0xB0, 0x70, 0x62, 0x10,
+                0x82, 0x10, 0x84, 0x44, 0x58, 0x89, 0x59, 0x98, 0x7C, 0xB8, 0x85, 0xC0, 0x26, 0xA8, 0x44, 0x44,
+                0x8B, 0x2C, 0x88, 0xC0, 0x00, 0x10, 0x01
+            }
+        },
+        {
+            "G3 1D (K = 0) with EOL", 0, true, false, true,
+            {
+                0x00, 0x1D, 0xD4, 0x00, 0x26, 0xA0, 0x79, 0x1C, 0x00, 0x4E, 0x07, 0x90, 0x00, 0x9A, 0xA1, 0xD0,
+                0xE8, 0x74, 0x3A, 0x1D, 0x0E, 0x87, 0x43, 0xA1, 0xD0, 0xE8, 0x74, 0x3A, 0x1D, 0x0E, 0x87, 0x43,
+                0xA1, 0xD0, 0xE8, 0x74, 0x3A, 0x1D, 0x0E, 0x87, 0x43, 0xA1, 0xD0, 0xE8, 0x74, 0x3A, 0x1D, 0x0E,
+                0x87, 0x43, 0xA1, 0xD0, 0xE8, 0x74, 0x3A, 0x1D, 0x0E, 0x87, 0x43, 0x80, 0x0B, 0xD7, 0x5D, 0x75,
+                0xD7, 0x5D, 0x75, 0xD7, 0x5D, 0x80, 0x03, 0x15, 0xCF, 0x65, 0x0E, 0xFE, 0xDC, 0xE3, 0x1E, 0x8A,
+                0xCD, 0xC0, 0x06, 0xC7, 0x40, 0xA0, 0x60, 0x98, 0x80, 0x06, 0xE1, 0xEA, 0x38, 0x66, 0x03, 0x18,
+                0x80, 0x04, 0xD5, 0x6E, 0x11, 0xD0, 0x00, 0x9A, 0x81, 0xE0, 0xB8, 0x00, 0x80, 0x08, 0x00, 0x80,
+                0x08, 0x00, 0x80, 0x08
+            }
+        },
+        {
+            "G3 1D (K = 0), EncodedByteAlign, no EOB", 0, false, true, false,
+            {
+                0xDD, 0x40, 0x35, 0x03, 0xC8, 0xE0, 0x38, 0x1E, 0x40, 0x35, 0x43, 0xA1, 0xD0, 0xE8, 0x74, 0x3A,
+                0x1D, 0x0E, 0x87, 0x43, 0xA1, 0xD0, 0xE8, 0x74, 0x3A, 0x1D, 0x0E, 0x87, 0x43, 0xA1, 0xD0, 0xE8,
+                0x74, 0x3A, 0x1D, 0x0E, 0x87, 0x43, 0xA1, 0xD0, 0xE8, 0x74, 0x3A, 0x1D, 0x0E, 0x87, 0x43, 0xA1,
+                0xD0, 0xE8, 0x74, 0x3A, 0x1D, 0x0E, 0x87, 0x7A, 0xEB, 0xAE, 0xBA, 0xEB, 0xAE, 0xBA, 0xEB, 0xB0,
+                0x8A, 0xE7, 0xB2, 0x87, 0x7F, 0x6E, 0x71, 0x8F, 0x45, 0x66, 0xE0, 0xB1, 0xD0, 0x28, 0x18, 0x26,
+                0x20, 0xB8, 0x7A, 0x8E, 0x19, 0x80, 0xC6, 0x20, 0x35, 0x5B, 0x84, 0x74, 0x35, 0x03, 0xC1, 0x70
+            }
+        },
+        {
+            "G3 2D (K > 0) with EOL", 4, true, false, true,
+            {
+                0x00, 0x1E, 0xEA, 0x00, 0x11, 0x35, 0x03, 0xCA, 0x00, 0x22, 0x70, 0x3C, 0x80, 0x04, 0x4D, 0x51,
+                0x1D, 0x11, 0xD1, 0x1D, 0x04, 0x50, 0xE5, 0x0E, 0x50, 0xE5, 0x0E, 0x50, 0xE5, 0x0E, 0x50, 0xE5,
+                0x0E, 0x50, 0xE5, 0x0E, 0x50, 0xE5, 0x0E, 0x50, 0xE5, 0x0E, 0x50, 0xE5, 0x0E, 0x50, 0xE5, 0x0E,
+                0x50, 0xE5, 0x0E, 0x50, 0xE5, 0x0E, 0x50, 0xE5, 0x0E, 0x50, 0xE5, 0x0E, 0x50, 0xE5, 0x0E, 0x50,
+                0xE5, 0x0E, 0x50, 0xE5, 0x0E, 0x50, 0xE5, 0x0E, 0x08, 0x25, 0x00, 0x1B, 0xD7, 0x5D, 0x75, 0xD7,
+                0x5D, 0x75, 0xD7, 0x5D, 0x80, 0x02, 0x6D, 0xB4, 0xB5, 0xA7, 0x0A, 0x82, 0x23, 0xCD, 0xB0, 0x70,
+                0x01, 0x31, 0x08, 0x41, 0x08, 0x42, 0x22, 0x2C, 0x44, 0xAC, 0x80, 0x0A, 0x61, 0xF2, 0xE2, 0x17,
+                0x00, 0x19, 0xAA, 0xDC, 0x23, 0xA0, 0x01, 0x44, 0x60, 0x03, 0x00, 0x18, 0x00, 0xC0, 0x06, 0x00,
+                0x30, 0x01, 0x80
+            }
+        },
+        {
+            "G3 2D (K > 0), no EOB", 2, false, false, false,
+            {
+                0xEE, 0xA1, 0x35, 0x03, 0xCB, 0x38, 0x1E, 0x42, 0x6A, 0x88, 0xE8, 0x8E, 0x88, 0xE8, 0x22, 0x87,
+                0x28, 0x72, 0x87, 0x28, 0x72, 0x87, 0x28, 0x72, 0x87, 0x28, 0x72, 0x87, 0x28, 0x72, 0x87, 0x28,
+                0x72, 0x87, 0x28, 0x72, 0x87, 0x28, 0x72, 0x87, 0x28, 0x72, 0x87, 0x28, 0x72, 0x87, 0x28, 0x72,
+                0x87, 0x28, 0x72, 0x87, 0x28, 0x72, 0x87, 0x28, 0x72, 0x87, 0x28, 0x72, 0x87, 0x28, 0x72, 0x87,
+                0x28, 0x70, 0x41, 0x2D, 0xEB, 0xAE, 0xBA, 0xEB, 0xAE, 0xBA, 0xEB, 0xAE, 0xC3, 0x6D, 0xA5, 0xAD,
+                0x38, 0x54, 0x11, 0x1E, 0x6D, 0x83, 0xEC, 0x74, 0x0A, 0x06, 0x09, 0x89, 0x30, 0xF9, 0x71, 0x0B,
+                0xCD, 0x56, 0xE1, 0x1D, 0x22, 0x30
+            }
+        }
+    };
+
+    const int columns = static_cast<int>(strlen(image.front()));
+    const int rows = static_cast<int>(image.size());
+
+    // Expected image data - white pixel is 1, black pixel is 0, rows are padded by zero bits
+    pdf::PDFBitWriter writer(1);
+    for (const char* row : image)
+    {
+        for (const char* pixel = row; *pixel; ++pixel)
+        {
+            writer.write(*pixel == '#' ? 0 : 1);
+        }
+        writer.finishLine();
+    }
+    const QByteArray expectedData = writer.takeByteArray();
+
+    for (const TestCase& testCase : testCases)
+    {
+        for (const bool hasBlackIsOne : { false, true })
+        {
+            pdf::PDFCCITTFaxDecoderParameters parameters;
+            parameters.K = testCase.K;
+            parameters.columns = columns;
+            parameters.rows = testCase.hasEndOfBlock ? 0 : rows;
+            parameters.hasEndOfLine = testCase.hasEndOfLine;
+            parameters.hasEncodedByteAlign = testCase.hasEncodedByteAlign;
+            parameters.hasEndOfBlock = testCase.hasEndOfBlock;
+            parameters.hasBlackIsOne = hasBlackIsOne;
+            parameters.decode = { 0.0, 1.0 };
+
+            QByteArray stream(reinterpret_cast<const char*>(testCase.data.data()), static_cast<int>(testCase.data.size()));
+            pdf::PDFCCITTFaxDecoder decoder(&stream, parameters);
+            pdf::PDFImageData imageData = decoder.decode();
+
+            const std::vector<pdf::PDFReal> expectedDecode = hasBlackIsOne ? std::vector<pdf::PDFReal>{ 1.0, 0.0 } : std::vector<pdf::PDFReal>{ 0.0, 1.0 };
+            QVERIFY2(imageData.getWidth() == uint(columns), testCase.name);
+            QVERIFY2(imageData.getHeight() == uint(rows), testCase.name);
+            QVERIFY2(imageData.getData() == expectedData, testCase.name);
+            QVERIFY2(imageData.getDecode() == expectedDecode, testCase.name);
+        }
+    }
+}
+
+/// Content processor, which records painted content
+class PDFRecordingContentProcessor : public pdf::PDFPageContentProcessor
+{
+public:
+    using pdf::PDFPageContentProcessor::PDFPageContentProcessor;
+
+    const QStringList& getRecords() const { return m_records; }
+
+protected:
+    virtual void performPathPainting(const QPainterPath& path, bool stroke, bool fill, bool text, Qt::FillRule fillRule) override
+    {
+        Q_UNUSED(text);
+
+        const QRectF rect = path.boundingRect();
+        const pdf::PDFPageContentProcessorState* state = getGraphicState();
+        m_records << QString("path %1 %2 %3 %4 stroke %5 fill %6 rule %7 colors %8 %9 width %10 dash %11")
+                         .arg(rect.left()).arg(rect.top()).arg(rect.width()).arg(rect.height())
+                         .arg(stroke).arg(fill).arg(int(fillRule))
+                         .arg(state->getStrokeColor().name(), state->getFillColor().name())
+                         .arg(state->getLineWidth()).arg(state->getLineDashPattern().getDashArray().size());
+    }
+
+    virtual void performClipping(const QPainterPath& path, Qt::FillRule fillRule) override
+    {
+        const QRectF rect = path.boundingRect();
+        m_records << QString("clip %1 %2 %3 %4 rule %5").arg(rect.left()).arg(rect.top()).arg(rect.width()).arg(rect.height()).arg(int(fillRule));
+    }
+
+    virtual void performImagePainting(const QImage& image) override
+    {
+        m_records << QString("image %1 %2").arg(image.width()).arg(image.height());
+    }
+
+    virtual void performMarkedContentBegin(const QByteArray& tag, const pdf::PDFObject& properties) override
+    {
+        const pdf::PDFInteger mcid = properties.isDictionary() ? properties.getDictionary()->get("MCID").getInteger() : -1;
+        m_records << QString("begin %1 mcid %2").arg(QString::fromLatin1(tag)).arg(mcid);
+    }
+
+    virtual void performMarkedContentEnd() override
+    {
+        m_records << QString("end");
+    }
+
+private:
+    QStringList m_records;
+};
+
+void LexicalAnalyzerTest::test_content_stream_bytecode()
+{
+    // First content stream ends with operands of the operator in the second content stream
+    QByteArray content1 = "q 1 0 0 RG 2 w [3 1] 0 d 10 10 m 100 100 l S Q\n"
+                          "/Span << /MCID 7 >> BDC 0.5 g 10 10 50 50 re f EMC\n"
+                          "/Fm1 Do\n"
+                          "/Pattern cs /P1 scn 0 0 100 100 re f\n"
+                          "BI /W 2 /H 2 /BPC 8 /CS /G ID abcd EI\n"
+                          "1 2 unknown\n"
+                          "(string) 5 Tc\n"
+                          "0 1 0 rg 40 40";
+    QByteArray content2 = " 20 20 re f\n"
+                          "[1 2.5 3] 0.5 d 0 0 m 1 1 l B*";
+
+    std::vector<QByteArray> objects =
+    {
+        "<< /Type /Catalog /Pages 2 0 R >>",
+        "<< /Type /Pages /Kids [3 0 R] /Count 1 >>",
+        "<< /Type /Page /Parent 2 0 R /MediaBox [0 0 200 200] /Contents [4 0 R 5 0 R] "
+        "/Resources << /XObject << /Fm1 6 0 R >> /Pattern << /P1 7 0 R >> >> >>",
+        createStreamObject("", content1),
+        createStreamObject("", content2),
+        createStreamObject("/Type /XObject /Subtype /Form /BBox [0 0 100 100]", "0 0 1 rg 0 0 20 20 re f"),
+        createStreamObject("/PatternType 1 /PaintType 1 /TilingType 1 /BBox [0 0 50 50] /XStep 50 /YStep 50 /Resources << >>", "1 0 0 rg 0 0 5 5 re f")
+    };
+
+    pdf::PDFDocumentReader reader(nullptr, [](bool* ok) { *ok = false; return QString(); }, true, false);
+    pdf::PDFDocument document = reader.readFromBuffer(createDocumentData(objects));
+    QCOMPARE(reader.getReadingResult(), pdf::PDFDocumentReader::Result::OK);
+    QCOMPARE(document.getCatalog()->getPageCount(), size_t(1));
+
+    const pdf::PDFPage* page = document.getCatalog()->getPage(0);
+    pdf::PDFFontCache fontCache(pdf::DEFAULT_FONT_CACHE_LIMIT, pdf::DEFAULT_REALIZED_FONT_CACHE_LIMIT);
+    pdf::PDFCMSGeneric cms;
+    pdf::PDFMeshQualitySettings meshQualitySettings;
+    pdf::PDFContentStreamBytecodeCache bytecodeCache(pdf::DEFAULT_BYTECODE_CACHE_LIMIT);
+
+    auto process = [&](bool useBytecode)
+    {
+        PDFRecordingContentProcessor processor(page, &document, &fontCache, &cms, nullptr, QTransform(), meshQualitySettings);
+        if (useBytecode)
+        {
+            processor.setBytecodeCache(&bytecodeCache);
+        }
+
+        QList<pdf::PDFRenderError> errors = processor.processContents();
+        QStringList records = processor.getRecords();
+        for (const pdf::PDFRenderError& error : errors)
+        {
+            records << QString("error %1 %2").arg(int(error.type)).arg(error.message);
+        }
+        return records;
+    };
+
+    const QStringList interpreted = process(false);
+    const QStringList executed = process(true);
+    const QStringList executedFromCache = process(true);
+
+    QCOMPARE(executed, interpreted);
+    QCOMPARE(executedFromCache, interpreted);
+
+    // Verify, that content was really processed
+    QVERIFY(interpreted.contains("begin Span mcid 7"));
+    QVERIFY(interpreted.contains("image 2 2"));
+    QVERIFY(interpreted.filter("path 40 40 20 20").size() == 1);
+    QVERIFY(interpreted.filter("path 0 0 5 5").size() > 1);
+    QVERIFY(interpreted.filter("dash 3").size() == 1);
+    QVERIFY(interpreted.filter("error").size() >= 2);
+}
+
+void LexicalAnalyzerTest::test_incremental_update()
+{
+    std::vector<QByteArray> objects =
+    {
+        "<< /Type /Catalog /Pages 2 0 R >>",
+        "<< /Type /Pages /Kids [3 0 R] /Count 1 >>",
+        "<< /Type /Page /Parent 2 0 R /MediaBox [0 0 200 200] /Contents 4 0 R >>",
+        createStreamObject("", "0 0 1 rg 0 0 20 20 re f"),
+        "<< /Title (Incremental update) >>"
+    };
+
+    const QByteArray id = QByteArray::fromHex("0123456789ABCDEF0123456789ABCDEF");
+    const QByteArray originalData = createDocumentData(objects, "/Root 1 0 R /Info 5 0 R /ID [<0123456789ABCDEF0123456789ABCDEF> <0123456789ABCDEF0123456789ABCDEF>]");
+    const pdf::PDFInteger originalXRefOffset = originalData.mid(originalData.lastIndexOf("startxref") + 9).trimmed().split('\n').front().toLongLong();
+
+    pdf::PDFDocumentReader reader(nullptr, [](bool* ok) { *ok = false; return QString(); }, true, false);
+    pdf::PDFDocument originalDocument = reader.readFromBuffer(originalData);
+    QCOMPARE(reader.getReadingResult(), pdf::PDFDocumentReader::Result::OK);
+
+    // Page is changed and a new object is added, document info is changed by the builder
+    pdf::PDFDocumentBuilder builder(&originalDocument);
+    pdf::PDFObjectFactory factory;
+    factory.beginDictionary();
+    factory.beginDictionaryItem("Rotate");
+    factory << pdf::PDFInteger(90);
+    factory.endDictionaryItem();
+    factory.endDictionary();
+    builder.mergeTo(pdf::PDFObjectReference(3, 0), factory.takeObject());
+    const pdf::PDFObjectReference newObjectReference = builder.addObject(pdf::PDFObject::createInteger(42));
+    pdf::PDFDocument document = builder.build();
+
+    pdf::PDFDocumentWriter writer(nullptr);
+
+    // Incremental update appends changed and new objects only
+    {
+        QByteArray data = originalData;
+        QBuffer buffer(&data);
+        QVERIFY(buffer.open(QBuffer::ReadWrite));
+        QVERIFY(writer.writeIncremental(&buffer, &document, &originalDocument));
+        buffer.close();
+
+        QVERIFY(data.startsWith(originalData));
+        const QByteArray update = data.mid(originalData.size());
+        QVERIFY(update.contains("\n3 0 obj"));
+        QVERIFY(update.contains("\n5 0 obj"));
+        QVERIFY(update.contains(QString("\n%1 0 obj").arg(newObjectReference.objectNumber).toLatin1()));
+        QVERIFY(!update.contains("\n1 0 obj"));
+        QVERIFY(!update.contains("\n2 0 obj"));
+        QVERIFY(!update.contains("\n4 0 obj"));
+
+        pdf::PDFDocument updatedDocument = reader.readFromBuffer(data);
+        QCOMPARE(reader.getReadingResult(), pdf::PDFDocumentReader::Result::OK);
+
+        const pdf::PDFDictionary* trailerDictionary = updatedDocument.getTrailerDictionary();
+        QVERIFY(trailerDictionary->get("Prev").isInt());
+        QCOMPARE(trailerDictionary->get("Prev").getInteger(), originalXRefOffset);
+        QVERIFY(trailerDictionary->get("ID") == originalDocument.getTrailerDictionary()->get("ID"));
+        QCOMPARE(updatedDocument.getIdPart(0), id);
+
+        const pdf::PDFObject& pageObject = updatedDocument.getObjectByReference(pdf::PDFObjectReference(3, 0));
+        QVERIFY(pageObject.isDictionary());
+        QVERIFY(pageObject.getDictionary()->get("Rotate") == pdf::PDFObject::createInteger(90));
+        QVERIFY(updatedDocument.getObjectByReference(newObjectReference) == pdf::PDFObject::createInteger(42));
+        QVERIFY(updatedDocument.getObjectByReference(pdf::PDFObjectReference(4, 0)) == originalDocument.getObjectByReference(pdf::PDFObjectReference(4, 0)));
+    }
+
+    // Incremental update of unchanged document contains no objects
+    {
+        QByteArray data = originalData;
+        QBuffer buffer(&data);
+        QVERIFY(buffer.open(QBuffer::ReadWrite));
+        QVERIFY(writer.writeIncremental(&buffer, &originalDocument, &originalDocument));
+        buffer.close();
+
+        QVERIFY(data.startsWith(originalData));
+        QVERIFY(!data.mid(originalData.size()).contains(" 0 obj"));
+
+        reader.readFromBuffer(data);
+        QCOMPARE(reader.getReadingResult(), pdf::PDFDocumentReader::Result::OK);
+    }
+
+    // Encryption has been changed, incremental update is refused, original data
+    // are kept, and document must be written as a whole.
+    {
+        pdf::PDFSecurityHandlerFactory::SecuritySettings settings;
+        settings.algorithm = pdf::PDFSecurityHandlerFactory::AES_128;
+        settings.ownerPassword = "owner";
+        settings.id = id;
+
+        pdf::PDFDocumentBuilder encryptedBuilder(&document);
+        encryptedBuilder.setSecurityHandler(pdf::PDFSecurityHandlerFactory::createSecurityHandler(settings));
+        pdf::PDFDocument encryptedDocument = encryptedBuilder.build();
+
+        QByteArray data = originalData;
+        QBuffer buffer(&data);
+        QVERIFY(buffer.open(QBuffer::ReadWrite));
+        QVERIFY(!writer.writeIncremental(&buffer, &encryptedDocument, &originalDocument));
+        buffer.close();
+        QCOMPARE(data, originalData);
+
+        QByteArray fullData;
+        QBuffer fullBuffer(&fullData);
+        QVERIFY(fullBuffer.open(QBuffer::WriteOnly));
+        QVERIFY(writer.write(&fullBuffer, &encryptedDocument));
+        fullBuffer.close();
+
+        pdf::PDFDocument writtenDocument = reader.readFromBuffer(fullData);
+        QCOMPARE(reader.getReadingResult(), pdf::PDFDocumentReader::Result::OK);
+        QVERIFY(writtenDocument.getStorage().getSecurityHandler()->getMode() != pdf::EncryptionMode::None);
+        QVERIFY(writtenDocument.getObjectByReference(newObjectReference) == pdf::PDFObject::createInteger(42));
+    }
+}
+
+void LexicalAnalyzerTest::test_object_streams_round_trip()
+{
+    std::vector<QByteArray> objects =
+    {
+        "<< /Type /Catalog /Pages 2 0 R >>",
+        "<< /Type /Pages /Kids [3 0 R] /Count 1 >>",
+        "<< /Type /Page /Parent 2 0 R /MediaBox [0 0 200 200] /Contents 4 0 R >>",
+        createStreamObject("", "0 0 1 rg 0 0 20 20 re f"),
+        "[1 2.5 (string) /Name true null << /Nested [1 2 3] >>]",
+        "(Text with \\) escaped parenthesis)",
+        "<< /Real -0.5 /Hex <48656C6C6F> /Reference 5 0 R >>",
+        "123"
+    };
+
+    pdf::PDFDocumentReader reader(nullptr, [](bool* ok) { *ok = false; return QString(); }, true, false);
+    pdf::PDFDocument originalDocument = reader.readFromBuffer(createDocumentData(objects));
+    QCOMPARE(reader.getReadingResult(), pdf::PDFDocumentReader::Result::OK);
+
+    // Seven objects, which are not streams, are packed into three object streams
+    pdf::PDFDocumentWriter writer(nullptr);
+    writer.setObjectStreamsEnabled(true);
+    writer.setObjectsPerStream(3);
+
+    QByteArray data;
+    QBuffer buffer(&data);
+    QVERIFY(buffer.open(QBuffer::WriteOnly));
+    QVERIFY(writer.write(&buffer, &originalDocument));
+    buffer.close();
+
+    QCOMPARE(data.count("/ObjStm"), qsizetype(3));
+    QVERIFY(data.contains("/XRef"));
+    QVERIFY(!data.contains("trailer"));
+    QVERIFY(data.contains("\n4 0 obj"));
+    for (const char* objectHeader : { "\n1 0 obj", "\n2 0 obj", "\n3 0 obj", "\n5 0 obj", "\n6 0 obj", "\n7 0 obj", "\n8 0 obj" })
+    {
+        QVERIFY2(!data.contains(objectHeader), objectHeader);
+    }
+
+    pdf::PDFDocument document = reader.readFromBuffer(data);
+    QCOMPARE(reader.getReadingResult(), pdf::PDFDocumentReader::Result::OK);
+    QCOMPARE(document.getCatalog()->getPageCount(), size_t(1));
+
+    for (pdf::PDFInteger i = 1; i <= pdf::PDFInteger(objects.size()); ++i)
+    {
+        const pdf::PDFObjectReference reference(i, 0);
+        const pdf::PDFObject& object = document.getObjectByReference(reference);
+        QVERIFY2(!object.isNull(), qPrintable(QString("Object %1 0 R").arg(i)));
+        QVERIFY2(object == originalDocument.getObjectByReference(reference), qPrintable(QString("Object %1 0 R").arg(i)));
+    }
+}
+
+QByteArray LexicalAnalyzerTest::createDocumentData(const std::vector<QByteArray>& objects, const QByteArray& trailer)
+{
+    QByteArray data = "%PDF-1.7\n";
+    std::vector<int> offsets;
+
+    for (size_t i = 0; i < objects.size(); ++i)
+    {
+        offsets.push_back(data.size());
+        data.append(QString("%1 0 obj\n").arg(i + 1).toLatin1());
+        data.append(objects[i]);
+        data.append("\nendobj\n");
+    }
+
+    const int xrefOffset = data.size();
+    data.append(QString("xref\n0 %1\n0000000000 65535 f\r\n").arg(objects.size() + 1).toLatin1());
+    for (int offset : offsets)
+    {
+        data.append(QString("%1 00000 n\r\n").arg(offset, 10, 10, QChar('0')).toLatin1());
+    }
+    data.append(QString("trailer\n<< /Size %1 ").arg(objects.size() + 1).toLatin1());
+    data.append(trailer);
+    data.append(QString(" >>\nstartxref\n%1\n%%EOF\n").arg(xrefOffset).toLatin1());
+    return data;
+}
+
+QByteArray LexicalAnalyzerTest::createStreamObject(const QByteArray& dictionary, const QByteArray& content)
+{
+    QByteArray data = "<< ";
+    data.append(dictionary);
+    data.append(QString(" /Length %1 >>\nstream\n").arg(content.size()).toLatin1());
+    data.append(content);
+    data.append("\nendstream");
+    return data;
+}
+
 void LexicalAnalyzerTest::scanWholeStream(const char* stream)
 {
     pdf::PDFLexicalAnalyzer analyzer(stream, stream + strlen(stream));